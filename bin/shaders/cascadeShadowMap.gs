@@ -8,9 +8,16 @@ layout (std140, binding = 0) uniform LightSpaceMatrices
     mat4 lightSpaceMatrices[6];
 };
 
+//bit per cascade, only cascades which are updated this frame get triangles
+uniform int layersMask = 0x3F;
+
 
 void main()
 {          
+    if ((layersMask & (1 << gl_InvocationID)) == 0) {
+        return;
+    }
+
     for (int i = 0; i < 3; ++i)
     {
         gl_Position = lightSpaceMatrices[gl_InvocationID] * gl_in[i].gl_Position;
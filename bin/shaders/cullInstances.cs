@@ -0,0 +1,82 @@
+#version 460 core
+layout (local_size_x = 64) in;
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 10) readonly buffer modelMatrices
+{
+    mat4 model[];
+};
+
+layout(std430, binding = 13) readonly buffer instancesData
+{
+    uint instances[];
+};
+
+layout(std430, binding = 14) readonly buffer instanceDrawsData
+{
+    uint instanceDraws[];
+};
+
+//center and extents of mesh in local space for every draw, center.w is 0 if draw has no bounds
+layout(std430, binding = 15) readonly buffer boundsData
+{
+    vec4 bounds[];
+};
+
+layout(std430, binding = 16) buffer commandsData
+{
+    DrawCommand commands[];
+};
+
+layout(std430, binding = 17) writeonly buffer visibleData
+{
+    uint visibleInstances[];
+};
+
+uniform int instancesCount;
+uniform bool frustumCulling;
+//xyz - normal, w - distance
+uniform vec4 frustumPlanes[6];
+
+bool isOnFrustum(vec3 center, vec3 extents) {
+    for (int i = 0; i < 6; i++) {
+        vec3 normal = frustumPlanes[i].xyz;
+        float r = dot(extents, abs(normal));
+        if (dot(normal, center) + frustumPlanes[i].w < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void main() {
+    uint idx = gl_GlobalInvocationID.x;
+    if (idx >= uint(instancesCount)) {
+        return;
+    }
+
+    uint drawIdx = instanceDraws[idx];
+    uint entityIdx = instances[idx];
+
+    if (frustumCulling && bounds[drawIdx * 2].w > 0.0) {
+        mat4 transform = model[entityIdx];
+        vec3 localCenter = bounds[drawIdx * 2].xyz;
+        vec3 localExtents = bounds[drawIdx * 2 + 1].xyz;
+
+        vec3 center = (transform * vec4(localCenter, 1.0)).xyz;
+        vec3 extents = abs(transform[0].xyz * localExtents.x) + abs(transform[1].xyz * localExtents.y) + abs(transform[2].xyz * localExtents.z);
+        if (!isOnFrustum(center, extents)) {
+            return;
+        }
+    }
+
+    uint slot = atomicAdd(commands[drawIdx].instanceCount, 1);
+    visibleInstances[commands[drawIdx].baseInstance + slot] = entityIdx;
+}
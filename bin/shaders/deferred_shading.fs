@@ -12,7 +12,6 @@ uniform float drawDistance = 5000.0;
 uniform float fogStart = 4500.0;
 
 const int MAX_POINT_LIGHTS_SIZE = 6;
-uniform int pointLightsSize = 0;
 uniform int cascadeCount = 0;   // number of frusta - 1
 
 uniform sampler2D gPosition;
@@ -21,6 +20,12 @@ uniform sampler2D gAlbedoSpec;
 uniform sampler2D ssao;
 uniform sampler2D gOutlines;
 
+//positions are reconstructed from depth, normal is octahedral encoded
+uniform bool compactGBuffer = false;
+uniform sampler2D gDepthTexture;
+uniform mat4 invProjection;
+uniform mat4 invView;
+
 uniform sampler2DArrayShadow PointLightShadowMapArray;
 struct PointLight {
     vec3 Position;
@@ -37,6 +42,39 @@ struct PointLight {
     int Layers;
 };
 uniform PointLight pointLight[MAX_POINT_LIGHTS_SIZE];
+//every face is a tile of shadow atlas, xy - tile offset in page uv, z - tile size in page uv, w - page
+uniform vec4 pointLightTiles[MAX_POINT_LIGHTS_SIZE * 6];
+
+//all visible point lights, fragment is shaded only with lights of its cluster
+struct ClusterLight {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float linear;
+    float quadratic;
+    int shadowIdx; //index in pointLight, -1 if light has no shadow map
+};
+
+layout(std430, binding = 20) readonly buffer clusterLightsData
+{
+    ClusterLight clusterLights[];
+};
+
+//offset and count in light indices for every cluster
+layout(std430, binding = 21) readonly buffer clustersData
+{
+    uvec2 clusters[];
+};
+
+layout(std430, binding = 22) readonly buffer lightIndicesData
+{
+    uint lightIndices[];
+};
+
+const uvec3 CLUSTERS_SIZE = uvec3(16, 9, 24);
+uniform mat4 clusterView;
+uniform float clusterNear = 1.0;
+uniform float clusterScale = 1.0; // slices count / log(far / near)
 
 struct CascadedShadow {
     sampler2DArrayShadow shadowMap;
@@ -107,7 +145,10 @@ float TechniqueVogelPoint(PointLight light, int layer, float bias, vec3 projCoor
     for (uint i = 0; i < light.samples; i++) {
         const vec2 offset = vogel_disk_sample(i, light.samples, temporal_angle) * (light.texelSize) *  g_shadow_filter_size * penumbra;
         
-        const float depth = texture(PointLightShadowMapArray, vec4(projCoords.xy + offset, layer + light.offset, projCoords.z));
+        //samples are clamped to face tile, so they never read neighbour tiles
+        const vec4 tile = pointLightTiles[layer + light.offset];
+        const vec2 faceCoords = clamp(projCoords.xy + offset, light.texelSize * 0.5, 1.0 - light.texelSize * 0.5);
+        const float depth = texture(PointLightShadowMapArray, vec4(tile.xy + faceCoords * tile.z, tile.w, projCoords.z));
         shadow += projCoords.z + bias > depth ? 1.0 : 0.0;   
     } 
 
@@ -193,11 +234,40 @@ float customMix(float x, float y, float a) {
     return x * (1.0 - a) + y * a;
 }
 
+uvec2 getCluster(vec3 fragPosWorldSpace) {
+    const float depth = -(clusterView * vec4(fragPosWorldSpace, 1.0)).z;
+    const uint slice = uint(clamp(log(max(depth, clusterNear) / clusterNear) * clusterScale, 0.0, float(CLUSTERS_SIZE.z - 1)));
+    const uvec2 tile = min(uvec2(TexCoords * vec2(CLUSTERS_SIZE.xy)), CLUSTERS_SIZE.xy - 1);
+    return clusters[tile.x + tile.y * CLUSTERS_SIZE.x + slice * CLUSTERS_SIZE.x * CLUSTERS_SIZE.y];
+}
+
+//inverse of octahedral encoding of g_buffer.fs
+vec3 decodeNormal(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main() {
     // retrieve data from gbuffer
-    const vec3 FragPos = texture(gPosition, TexCoords).rgb;
-    const vec3 Normal = texture(gNormal, TexCoords).rgb;
-    const float Depth = texture(gNormal, TexCoords).a;
+    vec3 FragPos;
+    vec3 Normal;
+    float Depth;
+    if (compactGBuffer) {
+        const float depth = texture(gDepthTexture, TexCoords).r;
+        const vec4 viewPosition = invProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+        FragPos = (invView * vec4(viewPosition.xyz / viewPosition.w, 1.0)).xyz;
+        Normal = decodeNormal(texture(gNormal, TexCoords).rg);
+        Depth = depth < 1.0 ? depth * -viewPosition.z / viewPosition.w : 0.0;
+    }
+    else {
+        FragPos = texture(gPosition, TexCoords).rgb;
+        Normal = texture(gNormal, TexCoords).rgb;
+        Depth = texture(gNormal, TexCoords).a;
+    }
     vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
     const float Specular = texture(gAlbedoSpec, TexCoords).a;
     const float AmbientOcclusion = texture(ssao, TexCoords).r;
@@ -213,9 +283,12 @@ void main() {
 
     vec2 illuminationSun = calculateIllumination(cascadedShadow.direction, Normal); 
 
+    const uvec2 cluster = getCluster(FragPos);
+
     float illum = illuminationSun.y;
-    for (int idx = 0; idx < pointLightsSize; idx++){
-        vec2 illuminationPoint = calculateIllumination(-normalize(pointLight[idx].Position - FragPos), Normal);
+    for (uint i = 0; i < cluster.y; i++){
+        const ClusterLight light = clusterLights[lightIndices[cluster.x + i]];
+        vec2 illuminationPoint = calculateIllumination(-normalize(light.position - FragPos), Normal);
         illum = max(illum, illuminationPoint.y); // 1 means light, 0 means dark
     }
 
@@ -223,20 +296,22 @@ void main() {
     if (illum > 0.0){
         shadow = max(illuminationSun.y, ShadowCascadedCalculation(FragPos, Normal));
 
-        for (int idx = 0; idx < pointLightsSize; idx++){
-            float distance = length(pointLight[idx].Position - FragPos);
-            float k = distance / pointLight[idx].radius;
+        for (uint i = 0; i < cluster.y; i++){
+            const ClusterLight light = clusterLights[lightIndices[cluster.x + i]];
+            float distance = length(light.position - FragPos);
+            float k = distance / light.radius;
             if (k >= 1.0){
                 continue;
             }
-            vec3 lightDir = -normalize(pointLight[idx].Position - FragPos);
+            vec3 lightDir = -normalize(light.position - FragPos);
             vec2 point = calculateIllumination(lightDir, Normal);
             //if (pointLight[idx].Type == 0){
-                shadow = customMix(shadow, max(point.y, PointLightCalculation(pointLight[idx], FragPos, Normal)) * pow(1.0 - k, 0.2), 1.0 - k);
+                const float pointShadow = light.shadowIdx >= 0 ? PointLightCalculation(pointLight[light.shadowIdx], FragPos, Normal) : 0.0;
+                shadow = customMix(shadow, max(point.y, pointShadow) * pow(1.0 - k, 0.2), 1.0 - k);
            
-                const float attenuation = 1.0 / (1.0 + pointLight[idx].Linear * distance + pointLight[idx].Quadratic * distance * distance);
+                const float attenuation = 1.0 / (1.0 + light.linear * distance + light.quadratic * distance * distance);
             
-                lighting += (calculateLightDiffuse(Normal, -lightDir, Diffuse, pointLight[idx].Color) + calculateSpecular(Normal, -lightDir, viewDir, pointLight[idx].Color, Specular)) * attenuation;
+                lighting += (calculateLightDiffuse(Normal, -lightDir, Diffuse, light.color) + calculateSpecular(Normal, -lightDir, viewDir, light.color, Specular)) * attenuation;
                 
             // } 
             // else{
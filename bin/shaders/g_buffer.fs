@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 layout (location = 0) out highp vec4 gPosition;
 layout (location = 1) out vec4 gNormal;
 layout (location = 2) out vec4 gAlbedoSpec;
@@ -12,15 +12,49 @@ in vec3 ViewPos;
 
 out vec4 FragColor;
 in mat3 TBN;
+flat in uint MaterialIdx;
+
+//layers of material textures in array pages, -1 if material has no such texture
+struct Material {
+    ivec4 layers;
+};
+
+layout(std430, binding = 19) readonly buffer materialsData
+{
+    Material materials[];
+};
 
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
 uniform sampler2D normalMap;
 
+uniform bool materialTable;
+uniform sampler2DArray diffuseArray;
+uniform sampler2DArray normalArray;
+uniform sampler2DArray specularArray;
+
 uniform mat4 PV;
 uniform mat4 P;
 uniform mat4 V;
 
+//positions are not written, normal is packed into two channels
+uniform bool compactGBuffer = false;
+
+//octahedral encoding of unit vector into [0, 1] range of RG16 target
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return n.xy * 0.5 + 0.5;
+}
+
+//normal maps may be compressed to two channels (bc5), so z is always restored from x and y
+vec3 decodeNormal(vec2 rg) {
+    const vec2 xy = rg * 2.0 - 1.0;
+    return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
 void main()
 { 
     // store the fragment position vector in the first gbuffer texture
@@ -31,16 +65,28 @@ void main()
     gNormal.a = gl_FragCoord.z / gl_FragCoord.w; //4 byte for depth buffer
     gViewPosition = ViewPos;
 
-    // obtain normal from normal map in range [0,1]
-    vec3 normal = texture(normalMap, TexCoords).rgb;
-    // transform normal vector to range [-1,1]
-    gNormal.xyz = normalize(TBN * normalize(normal * 2.0 - 1.0));
+    vec3 normal;
+    vec3 albedo;
+    vec4 specular;
+    if (materialTable) {
+        ivec4 layers = materials[MaterialIdx].layers;
+        albedo = layers.x >= 0 ? texture(diffuseArray, vec3(TexCoords, layers.x)).rgb : vec3(1.0);
+        normal = layers.y >= 0 ? decodeNormal(texture(normalArray, vec3(TexCoords, layers.y)).rg) : vec3(0.0, 0.0, 1.0);
+        specular = layers.z >= 0 ? texture(specularArray, vec3(TexCoords, layers.z)) : vec4(1.0);
+    }
+    else {
+        normal = decodeNormal(texture(normalMap, TexCoords).rg);
+        albedo = texture(texture_diffuse1, TexCoords).rgb;
+        specular = texture(texture_specular1, TexCoords);
+    }
+
+    const vec3 worldNormal = normalize(TBN * normal);
+    gNormal.xyz = compactGBuffer ? vec3(encodeNormal(worldNormal), 0.0) : worldNormal;
     
     // and the diffuse per-fragment color
-    gAlbedoSpec.rgb = texture(texture_diffuse1, TexCoords).rgb;
+    gAlbedoSpec.rgb = albedo;
 
     // store specular intensity in gAlbedoSpec's alpha component
-    vec4 specular = texture(texture_specular1, TexCoords);
     gAlbedoSpec.a = (specular.r + specular.g + specular.b) / 3.0;
 
     //gl_FragDepth = gl_FragCoord.z / gl_FragCoord.w; 
@@ -14,6 +14,7 @@ out vec2 TexCoords;
 out vec3 Normal;
 out vec3 ViewPos;
 out mat3 TBN;
+flat out uint MaterialIdx;
 
 layout(std140, binding = 5) uniform SharedMatrices {
     mat4 projection;
@@ -39,6 +40,12 @@ layout(std430, binding = 12) buffer isAnimatedData
     bool animated[];
 };
 
+//row of material table for every entity
+layout(std430, binding = 18) readonly buffer materialIndicesData
+{
+    uint materialIndices[];
+};
+
 void main() {
     mat4 BoneTransform = mat4(0.0f);
     bool withBones = false;
@@ -80,6 +87,7 @@ void main() {
 
     FragPos = worldPos.xyz;
     TexCoords = aTexCoords;
+    MaterialIdx = materialIndices[entityIdx];
 
     TBN[0] = normalize(normalMatrix * aTangents);
     TBN[1] = normalize(normalMatrix * aBiTangents);
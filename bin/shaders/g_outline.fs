@@ -9,6 +9,24 @@ uniform sampler2D gDepth;//this is a normal texture where i store depth in a
 uniform sampler2D gOutlinesP;
 uniform sampler2D gLightsP;
 
+//positions are reconstructed from depth, normal is octahedral encoded
+uniform bool compactGBuffer = false;
+uniform sampler2D gDepthTexture;
+uniform mat4 invProjection;
+
+//the same value as full g buffer keeps in normal alpha, gl_FragCoord.z / gl_FragCoord.w of geometry pass
+float sampleDepth(vec2 uv) {
+    if (!compactGBuffer) {
+        return texture(gDepth, uv).a;
+    }
+    float depth = texture(gDepthTexture, uv).r;
+    if (depth >= 1.0) {
+        return 0.0;
+    }
+    vec4 viewPosition = invProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return depth * -viewPosition.z / viewPosition.w;
+}
+
 void main()
 {    
     vec2 texSize  = textureSize(gOutlinesP, 0).xy;
@@ -19,19 +37,19 @@ void main()
     float yStep = 1.0;
     yStep = yStep / texSize.y;
 
-    float gx = texture(gDepth, TexCoord - vec2(xStep,    0.0)).a * 1.0 +
-               texture(gDepth, TexCoord - vec2(xStep,  yStep)).a * 2.0 +
-               texture(gDepth, TexCoord - vec2(xStep, -yStep)).a * 2.0 -
-               texture(gDepth, TexCoord + vec2(xStep,    0.0)).a * 1.0 -
-               texture(gDepth, TexCoord + vec2(xStep,  yStep)).a * 2.0 -
-               texture(gDepth, TexCoord + vec2(xStep, -yStep)).a * 2.0;
+    float gx = sampleDepth(TexCoord - vec2(xStep,    0.0)) * 1.0 +
+               sampleDepth(TexCoord - vec2(xStep,  yStep)) * 2.0 +
+               sampleDepth(TexCoord - vec2(xStep, -yStep)) * 2.0 -
+               sampleDepth(TexCoord + vec2(xStep,    0.0)) * 1.0 -
+               sampleDepth(TexCoord + vec2(xStep,  yStep)) * 2.0 -
+               sampleDepth(TexCoord + vec2(xStep, -yStep)) * 2.0;
     
-    float gy = texture(gDepth, TexCoord - vec2(0.0,    yStep)).a * 1.0 +
-               texture(gDepth, TexCoord - vec2(xStep,  yStep)).a * 2.0 +
-               texture(gDepth, TexCoord + vec2(0.0,    yStep)).a * 1.0 -
-               texture(gDepth, TexCoord - vec2(0.0,   -yStep)).a * 1.0 -
-               texture(gDepth, TexCoord + vec2(xStep, -yStep)).a * 2.0 -
-               texture(gDepth, TexCoord + vec2(0.0,   -yStep)).a * 1.0;
+    float gy = sampleDepth(TexCoord - vec2(0.0,    yStep)) * 1.0 +
+               sampleDepth(TexCoord - vec2(xStep,  yStep)) * 2.0 +
+               sampleDepth(TexCoord + vec2(0.0,    yStep)) * 1.0 -
+               sampleDepth(TexCoord - vec2(0.0,   -yStep)) * 1.0 -
+               sampleDepth(TexCoord + vec2(xStep, -yStep)) * 2.0 -
+               sampleDepth(TexCoord + vec2(0.0,   -yStep)) * 1.0;
     
     // Calculate edge strength
     float edge = sqrt(gx * gx + gy * gy);
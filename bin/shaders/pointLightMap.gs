@@ -1,22 +1,19 @@
 #version 460 core
     
-layout(triangles, invocations = 6) in;
+layout(triangles) in;
 layout(triangle_strip, max_vertices = 3) out;
 
-layout (std140, binding = 3) uniform LightSpaceMatrices
-{
-    mat4 lightSpaceMatrices[36];
-};
-
-uniform int offset = 0; 
+//one cube face is rendered at once, viewport is its tile in atlas page
+uniform mat4 lightSpaceMatrix;
+uniform int layer = 0;
 
 void main()
 {          
-    for (int i = 0; i < 6; ++i)
+    for (int i = 0; i < 3; ++i)
     {
-        gl_Position = lightSpaceMatrices[gl_InvocationID + offset] * gl_in[i].gl_Position;
-        gl_Layer = gl_InvocationID + offset;
+        gl_Position = lightSpaceMatrix * gl_in[i].gl_Position;
+        gl_Layer = layer;
         EmitVertex();
     }
     EndPrimitive();
-}  
\ No newline at end of file
+}  
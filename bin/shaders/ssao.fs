@@ -6,12 +6,18 @@ in vec2 TexCoords;
 uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 
+//positions are reconstructed from depth, normal is octahedral encoded
+uniform bool compactGBuffer = false;
+uniform sampler2D gDepthTexture;
+uniform mat4 invProjection;
+
 uniform int SAMPLES = 64;
 uniform float INTENSITY = 1.0;
 uniform float SCALE = 2.5;
 uniform float BIAS = 0.1;
 uniform float SAMPLE_RAD = 0.2;
 uniform float MAX_DISTANCE = 0.15;
+uniform float ROTATION = 0.0; //changed every frame when ao is accumulated
 
 #define MOD3 vec3(.1031,.11369,.13787)
 
@@ -30,9 +36,32 @@ vec2 hash22(vec2 p)
     return fract(vec2((p3.x + p3.y)*p3.z, (p3.x+p3.z)*p3.y));
 }
 
+//the same value as full g buffer keeps in normal alpha, gl_FragCoord.z / gl_FragCoord.w of geometry pass
+float sampleDepth(vec2 uv) {
+    if (!compactGBuffer) {
+        return texture(gNormal, uv).a;
+    }
+    float depth = texture(gDepthTexture, uv).r;
+    if (depth >= 1.0) {
+        return 0.0;
+    }
+    vec4 viewPosition = invProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return depth * -viewPosition.z / viewPosition.w;
+}
+
+//inverse of octahedral encoding of g_buffer.fs
+vec3 decodeNormal(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 vec3 getPosition(vec2 uv) {
-    float fl = 1.0 - texture(gNormal, uv).w;
-    float d = texture(gNormal, uv).w;
+    float d = sampleDepth(uv);
+    float fl = 1.0 - d;
        
     vec2 p = uv*2.-1.;
     mat3 ca = mat3(1.,0.,0.,   0.,1.,0.,   0.,0.,-1./1.5);
@@ -44,7 +73,7 @@ vec3 getPosition(vec2 uv) {
 }
 
 vec3 getNormal(vec2 uv) {
-    return texture(gNormal, uv, 0.).xyz;
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv, 0.).xy) : texture(gNormal, uv, 0.).xyz;
 }
 
 vec2 getRandom(vec2 uv) {
@@ -70,7 +99,7 @@ float spiralAO(vec2 uv, vec3 p, vec3 n, float rad)
     float inv = 1. / float(SAMPLES);
     float radius = 0.;
 
-    float rotatePhase = hash12( uv*100. ) * 6.28;
+    float rotatePhase = hash12( uv*100. ) * 6.28 + ROTATION;
     float rStep = inv * rad;
     vec2 spiralUV;
 
@@ -219,8 +219,9 @@ uniform float facL = 1.0;
 
 out float FragColor;
 
+//input can be temporal history which keeps depth in green
 float lum(in vec4 color) {
-    return length(color.xyz);
+    return color.r;
 }
 
 void main()
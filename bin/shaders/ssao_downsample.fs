@@ -0,0 +1,59 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+//full g buffer or previous level of pyramid, which has the same layout
+uniform sampler2D gNormal;
+
+//positions are reconstructed from depth, normal is octahedral encoded
+uniform bool compactGBuffer = false;
+uniform sampler2D gDepthTexture;
+uniform mat4 invProjection;
+
+//the same value as full g buffer keeps in normal alpha, gl_FragCoord.z / gl_FragCoord.w of geometry pass
+float sampleDepth(ivec2 texel) {
+    if (!compactGBuffer) {
+        return texelFetch(gNormal, texel, 0).a;
+    }
+    float depth = texelFetch(gDepthTexture, texel, 0).r;
+    if (depth >= 1.0) {
+        return 0.0;
+    }
+    vec2 uv = (vec2(texel) + 0.5) / vec2(textureSize(gDepthTexture, 0));
+    vec4 viewPosition = invProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return depth * -viewPosition.z / viewPosition.w;
+}
+
+//inverse of octahedral encoding of g_buffer.fs
+vec3 decodeNormal(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 getNormal(ivec2 texel) {
+    return compactGBuffer ? decodeNormal(texelFetch(gNormal, texel, 0).xy) : texelFetch(gNormal, texel, 0).xyz;
+}
+
+//the closest of four texels is kept with its own normal, so thin foreground isn't lost and upsample can match it
+void main() {
+    ivec2 sourceSize = textureSize(gNormal, 0);
+    ivec2 base = ivec2(gl_FragCoord.xy) * 2;
+
+    ivec2 chosen = min(base, sourceSize - 1);
+    float closest = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 texel = min(base + ivec2(i & 1, i >> 1), sourceSize - 1);
+        float depth = sampleDepth(texel);
+        if (depth > 0.0 && (closest == 0.0 || depth < closest)) {
+            closest = depth;
+            chosen = texel;
+        }
+    }
+
+    FragColor = vec4(getNormal(chosen), closest);
+}
@@ -0,0 +1,43 @@
+#version 330 core
+out vec2 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D ssaoInput;
+uniform sampler2D history; //ao in red, view depth in green
+uniform sampler2D gDepthTexture;
+
+uniform mat4 invProjection;
+uniform mat4 invPV;
+uniform mat4 previousPV;
+
+uniform bool historyValid = false;
+uniform float blend = 0.1;
+uniform float rejection = 0.1;
+
+void main() {
+    float ao = texture(ssaoInput, TexCoords).r;
+    float depth = texture(gDepthTexture, TexCoords).r;
+    if (depth >= 1.0) {
+        FragColor = vec2(ao, 0.0);
+        return;
+    }
+
+    vec4 ndc = vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec4 viewPosition = invProjection * ndc;
+    vec4 worldPosition = invPV * ndc;
+    worldPosition /= worldPosition.w;
+
+    //w of previous clip position is view depth which history should have if the same surface was seen there
+    vec4 previousClip = previousPV * worldPosition;
+    vec2 previousUV = previousClip.xy / previousClip.w * 0.5 + 0.5;
+    bool inside = previousClip.w > 0.0 && all(greaterThanEqual(previousUV, vec2(0.0))) && all(lessThanEqual(previousUV, vec2(1.0)));
+    if (historyValid && inside) {
+        vec2 previous = texture(history, previousUV).rg;
+        if (abs(previous.g - previousClip.w) < rejection * previousClip.w) {
+            ao = mix(previous.r, ao, blend);
+        }
+    }
+
+    FragColor = vec2(ao, -viewPosition.z / viewPosition.w);
+}
@@ -0,0 +1,75 @@
+#version 330 core
+out float FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D ssaoInput; //reduced ao
+uniform sampler2D depthNormal; //level of pyramid which ao was computed from
+uniform sampler2D gNormal;
+
+//positions are reconstructed from depth, normal is octahedral encoded
+uniform bool compactGBuffer = false;
+uniform sampler2D gDepthTexture;
+uniform mat4 invProjection;
+
+uniform float depthSharpness = 20.0;
+
+//the same value as full g buffer keeps in normal alpha, gl_FragCoord.z / gl_FragCoord.w of geometry pass
+float sampleDepth(vec2 uv) {
+    if (!compactGBuffer) {
+        return texture(gNormal, uv).a;
+    }
+    float depth = texture(gDepthTexture, uv).r;
+    if (depth >= 1.0) {
+        return 0.0;
+    }
+    vec4 viewPosition = invProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return depth * -viewPosition.z / viewPosition.w;
+}
+
+//inverse of octahedral encoding of g_buffer.fs
+vec3 decodeNormal(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 getNormal(vec2 uv) {
+    return compactGBuffer ? decodeNormal(texture(gNormal, uv).xy) : texture(gNormal, uv).xyz;
+}
+
+//bilinear weights of four reduced texels are scaled by similarity of their depth and normal, so ao doesn't leak over edges
+void main() {
+    float depth = sampleDepth(TexCoords);
+    if (depth <= 0.0) {
+        FragColor = texture(ssaoInput, TexCoords).r;
+        return;
+    }
+    vec3 normal = getNormal(TexCoords);
+
+    ivec2 size = textureSize(ssaoInput, 0);
+    vec2 position = TexCoords * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = fract(position);
+
+    float sum = 0.0;
+    float weights = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), size - 1);
+        vec4 reduced = texelFetch(depthNormal, texel, 0);
+
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float depthWeight = 1.0 / (1.0 + depthSharpness * abs(reduced.a - depth) / depth);
+        float normalWeight = pow(max(dot(reduced.xyz, normal), 0.0), 8.0);
+        float w = bilinear.x * bilinear.y * (depthWeight * normalWeight + 1e-3);
+
+        sum += texelFetch(ssaoInput, texel, 0).r * w;
+        weights += w;
+    }
+
+    FragColor = sum / max(weights, 1e-6);
+}
@@ -21,6 +21,16 @@ layout(std140, binding = 5) uniform SharedMatrices {
 uniform vec3 cameraPos;
 uniform float far;
 uniform float near;
+uniform bool compactGBuffer = false;
+
+//octahedral encoding of unit vector into [0, 1] range of RG16 target
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return n.xy * 0.5 + 0.5;
+}
 
 vec4 grid(vec3 fragPos3D, float scale) {
     vec2 coord = fragPos3D.xz * scale; // use the scale variable to set the distance between the lines
@@ -61,7 +71,7 @@ void main()
     gPosition.rgb = FragPos;
     gPosition.a = gl_FragCoord.z;
     // also store the per-fragment normals into the gbuffer
-    gNormal.xyz = Normal;
+    gNormal.xyz = compactGBuffer ? vec3(encodeNormal(normalize(Normal)), 0.0) : Normal;
     gNormal.a = gl_FragCoord.z / gl_FragCoord.w; //4 byte for depth buffer
 
     gViewPosition = ViewPos;
@@ -0,0 +1,255 @@
+﻿#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace AssetsModule::BlockCompression {
+	namespace {
+		void writeLittleEndian(uint8_t* dst, uint64_t value, int bytes) {
+			for (int i = 0; i < bytes; i++) {
+				dst[i] = static_cast<uint8_t>(value >> (i * 8));
+			}
+		}
+
+		//bc7 fields are packed from the lowest bit of the block
+		struct BitWriter {
+			uint8_t* data;
+			int offset = 0;
+
+			void write(uint32_t value, int bits) {
+				for (int i = 0; i < bits; i++, offset++) {
+					if ((value >> i) & 1u) {
+						data[offset >> 3] |= static_cast<uint8_t>(1u << (offset & 7));
+					}
+				}
+			}
+		};
+
+		//bounding box of the block shrunk a bit inside, so outliers don't stretch the palette,
+		//channels which go against the widest one have their box diagonal flipped
+		void findEndpoints(const uint8_t* rgba, int channels, int* lo, int* hi) {
+			int sums[4] = {};
+			for (int c = 0; c < channels; c++) {
+				lo[c] = 255;
+				hi[c] = 0;
+			}
+			for (int i = 0; i < BLOCK_PIXELS; i++) {
+				for (int c = 0; c < channels; c++) {
+					const int value = rgba[i * 4 + c];
+					lo[c] = std::min(lo[c], value);
+					hi[c] = std::max(hi[c], value);
+					sums[c] += value;
+				}
+			}
+
+			int axis = 0;
+			for (int c = 1; c < channels; c++) {
+				if (hi[c] - lo[c] > hi[axis] - lo[axis]) {
+					axis = c;
+				}
+			}
+
+			for (int c = 0; c < channels; c++) {
+				if (c != axis) {
+					int covariance = 0;
+					for (int i = 0; i < BLOCK_PIXELS; i++) {
+						covariance += (rgba[i * 4 + c] * BLOCK_PIXELS - sums[c]) * (rgba[i * 4 + axis] * BLOCK_PIXELS - sums[axis]);
+					}
+					if (covariance < 0) {
+						std::swap(lo[c], hi[c]);
+					}
+				}
+
+				const int inset = (hi[c] - lo[c]) / 16;
+				lo[c] += inset;
+				hi[c] -= inset;
+			}
+		}
+
+		uint16_t to565(const int* rgb) {
+			return static_cast<uint16_t>(((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5 | (rgb[2] * 31 + 127) / 255);
+		}
+
+		void from565(uint16_t color, int* rgb) {
+			const int r = (color >> 11) & 31;
+			const int g = (color >> 5) & 63;
+			const int b = color & 31;
+			rgb[0] = (r << 3) | (r >> 2);
+			rgb[1] = (g << 2) | (g >> 4);
+			rgb[2] = (b << 3) | (b >> 2);
+		}
+
+		//color0 > color1 keeps four colors palette in bc1, bc3 uses it always
+		void encodeColor(const uint8_t* rgba, uint8_t* block) {
+			int lo[4];
+			int hi[4];
+			findEndpoints(rgba, 3, lo, hi);
+
+			auto color0 = to565(hi);
+			auto color1 = to565(lo);
+			if (color0 < color1) {
+				std::swap(color0, color1);
+			}
+
+			uint32_t indices = 0;
+			if (color0 != color1) {
+				int palette[4][3];
+				from565(color0, palette[0]);
+				from565(color1, palette[1]);
+				for (int c = 0; c < 3; c++) {
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+
+				for (int i = 0; i < BLOCK_PIXELS; i++) {
+					int best = 0;
+					int bestError = std::numeric_limits<int>::max();
+					for (int entry = 0; entry < 4; entry++) {
+						int error = 0;
+						for (int c = 0; c < 3; c++) {
+							const int diff = rgba[i * 4 + c] - palette[entry][c];
+							error += diff * diff;
+						}
+						if (error < bestError) {
+							bestError = error;
+							best = entry;
+						}
+					}
+					indices |= static_cast<uint32_t>(best) << (i * 2);
+				}
+			}
+
+			writeLittleEndian(block, color0, 2);
+			writeLittleEndian(block + 2, color1, 2);
+			writeLittleEndian(block + 4, indices, 4);
+		}
+
+		//7 bit endpoint with shared lowest bit, the bit which gives smaller error over all channels is taken
+		void quantizeBC7Endpoint(const int* value, int* endpoint, uint32_t& pBit) {
+			int bestError = std::numeric_limits<int>::max();
+			for (uint32_t bit = 0; bit < 2; bit++) {
+				int error = 0;
+				int quantized[4];
+				for (int c = 0; c < 4; c++) {
+					quantized[c] = std::clamp((value[c] - static_cast<int>(bit) + 1) >> 1, 0, 127);
+					const int diff = ((quantized[c] << 1) | static_cast<int>(bit)) - value[c];
+					error += diff * diff;
+				}
+				if (error < bestError) {
+					bestError = error;
+					pBit = bit;
+					std::memcpy(endpoint, quantized, sizeof(quantized));
+				}
+			}
+		}
+	}
+
+	void encodeBC1(const uint8_t* rgba, uint8_t* block) {
+		encodeColor(rgba, block);
+	}
+
+	void encodeBC3(const uint8_t* rgba, uint8_t* block) {
+		encodeBC4(rgba, 3, block);
+		encodeColor(rgba, block + 8);
+	}
+
+	void encodeBC4(const uint8_t* rgba, int channel, uint8_t* block) {
+		int lo = 255;
+		int hi = 0;
+		for (int i = 0; i < BLOCK_PIXELS; i++) {
+			lo = std::min<int>(lo, rgba[i * 4 + channel]);
+			hi = std::max<int>(hi, rgba[i * 4 + channel]);
+		}
+
+		//hi > lo gives eight values palette: hi, lo and six values between them from hi side
+		uint64_t indices = 0;
+		if (hi != lo) {
+			const int range = hi - lo;
+			for (int i = 0; i < BLOCK_PIXELS; i++) {
+				const int step = ((hi - rgba[i * 4 + channel]) * 14 + range) / (2 * range);
+				const uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+				indices |= index << (i * 3);
+			}
+		}
+
+		block[0] = static_cast<uint8_t>(hi);
+		block[1] = static_cast<uint8_t>(lo);
+		writeLittleEndian(block + 2, indices, 6);
+	}
+
+	void encodeBC5(const uint8_t* rgba, uint8_t* block) {
+		encodeBC4(rgba, 0, block);
+		encodeBC4(rgba, 1, block + 8);
+	}
+
+	void encodeBC7(const uint8_t* rgba, uint8_t* block) {
+		constexpr int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		int lo[4];
+		int hi[4];
+		findEndpoints(rgba, 4, lo, hi);
+
+		int endpoints[2][4];
+		uint32_t pBits[2] = {};
+		quantizeBC7Endpoint(hi, endpoints[0], pBits[0]);
+		quantizeBC7Endpoint(lo, endpoints[1], pBits[1]);
+
+		int colors[2][4];
+		for (int e = 0; e < 2; e++) {
+			for (int c = 0; c < 4; c++) {
+				colors[e][c] = (endpoints[e][c] << 1) | static_cast<int>(pBits[e]);
+			}
+		}
+
+		int direction[4];
+		int lengthSq = 0;
+		for (int c = 0; c < 4; c++) {
+			direction[c] = colors[1][c] - colors[0][c];
+			lengthSq += direction[c] * direction[c];
+		}
+
+		int indices[BLOCK_PIXELS] = {};
+		if (lengthSq > 0) {
+			for (int i = 0; i < BLOCK_PIXELS; i++) {
+				int projection = 0;
+				for (int c = 0; c < 4; c++) {
+					projection += (rgba[i * 4 + c] - colors[0][c]) * direction[c];
+				}
+				const float weight = std::clamp(static_cast<float>(projection) * 64.f / static_cast<float>(lengthSq), 0.f, 64.f);
+
+				int best = 0;
+				for (int index = 1; index < 16; index++) {
+					if (std::abs(WEIGHTS[index] - weight) < std::abs(WEIGHTS[best] - weight)) {
+						best = index;
+					}
+				}
+				indices[i] = best;
+			}
+		}
+
+		//the highest bit of the first index isn't stored, endpoints are swapped so it is zero, weights are symmetric
+		if (indices[0] & 8) {
+			std::swap(endpoints[0], endpoints[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (auto& index : indices) {
+				index = 15 - index;
+			}
+		}
+
+		std::memset(block, 0, 16);
+		BitWriter writer{ block };
+		writer.write(1u << 6, 7); //mode 6
+		for (int c = 0; c < 4; c++) {
+			writer.write(static_cast<uint32_t>(endpoints[0][c]), 7);
+			writer.write(static_cast<uint32_t>(endpoints[1][c]), 7);
+		}
+		writer.write(pBits[0], 1);
+		writer.write(pBits[1], 1);
+		for (int i = 0; i < BLOCK_PIXELS; i++) {
+			writer.write(static_cast<uint32_t>(indices[i]), i == 0 ? 3 : 4);
+		}
+	}
+}
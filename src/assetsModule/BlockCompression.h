@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <cstdint>
+
+namespace AssetsModule {
+	//encoders of 4x4 blocks of rgba8 pixels, block is 16 pixels row by row, blocks are written in little endian as gpu reads them
+	//quality is traded for speed: endpoints are taken from bounding box of the block and indices are the nearest palette entries
+	namespace BlockCompression {
+		constexpr int BLOCK_SIZE = 4;
+		constexpr int BLOCK_PIXELS = BLOCK_SIZE * BLOCK_SIZE;
+
+		//rgb without alpha, 8 bytes
+		void encodeBC1(const uint8_t* rgba, uint8_t* block);
+		//bc1 color with interpolated alpha, 16 bytes
+		void encodeBC3(const uint8_t* rgba, uint8_t* block);
+		//one channel of pixels, 8 bytes
+		void encodeBC4(const uint8_t* rgba, int channel, uint8_t* block);
+		//red and green as two bc4 blocks, 16 bytes
+		void encodeBC5(const uint8_t* rgba, uint8_t* block);
+		//rgba, only mode 6 is used: one subset with 7 bit endpoints and 4 bit indices, 16 bytes
+		void encodeBC7(const uint8_t* rgba, uint8_t* block);
+	}
+}
@@ -0,0 +1,107 @@
+﻿#include "ChunkCooker.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <tuple>
+
+#include "mathModule/Utils.h"
+#include "propertiesModule/SceneFile.h"
+
+namespace AssetsModule {
+	namespace {
+		constexpr uint32_t NO_MODEL = std::numeric_limits<uint32_t>::max();
+
+		struct WorldTransform {
+			SFE::Math::Vec3 pos = {};
+			SFE::Math::Quaternion<float> rotate = {};
+			SFE::Math::Vec3 scale = { 1.f };
+		};
+	}
+
+	std::vector<ChunkCooker::Chunk> ChunkCooker::split(const SFE::PropertiesModule::SceneFile& scene, float chunkSize) {
+		using SceneFile = SFE::PropertiesModule::SceneFile;
+
+		const auto nodesCount = scene.parents.size();
+		std::vector<WorldTransform> transforms(nodesCount);
+		if (const auto block = scene.findBlock(SceneFile::BlockType::TRANSFORM)) {
+			for (size_t i = 0; i < block->size(); i++) {
+				const auto node = block->nodes[i];
+				if (node >= nodesCount) {
+					continue;
+				}
+
+				//record has the same layout as transform component writes
+				auto reader = block->getRecord(i);
+				SFE::Math::Vec3 rotate;
+				auto& transform = transforms[node];
+				if (reader.read(transform.scale) && reader.read(transform.pos) && reader.read(rotate)) {
+					transform.rotate.eulerToQuaternion(rotate);
+				}
+				else {
+					transform = {};
+				}
+			}
+		}
+
+		//nodes are stored parent first, so parent is already in world space
+		for (size_t node = 0; node < nodesCount; node++) {
+			const auto parent = scene.parents[node];
+			if (parent == SceneFile::NO_PARENT || parent >= node) {
+				continue;
+			}
+
+			const auto& parentTransform = transforms[parent];
+			auto& transform = transforms[node];
+			transform.pos = parentTransform.pos + parentTransform.rotate.rotateVector(parentTransform.scale * transform.pos);
+			transform.rotate = parentTransform.rotate * transform.rotate;
+			transform.scale = parentTransform.scale * transform.scale;
+		}
+
+		std::vector<Chunk> chunks;
+		const auto block = scene.findBlock(SceneFile::BlockType::MODEL);
+		if (!block) {
+			return chunks;
+		}
+
+		std::map<std::tuple<int, int, int>, size_t> chunkIndices;
+		//scene model index to chunk model index, per chunk
+		std::vector<std::vector<uint32_t>> modelIndices;
+		for (size_t i = 0; i < block->size(); i++) {
+			const auto node = block->nodes[i];
+			uint32_t model = 0;
+			auto reader = block->getRecord(i);
+			if (node >= nodesCount || !reader.read(model) || model >= scene.models.size()) {
+				continue;
+			}
+
+			const auto& transform = transforms[node];
+			const auto coords = ChunkFile::getChunk(transform.pos, chunkSize);
+			const auto [it, inserted] = chunkIndices.try_emplace({ coords.x, coords.y, coords.z }, chunks.size());
+			if (inserted) {
+				chunks.push_back({ coords, ChunkFile{} });
+				modelIndices.emplace_back(scene.models.size(), NO_MODEL);
+			}
+
+			auto& file = chunks[it->second].file;
+			auto& chunkModel = modelIndices[it->second][model];
+			if (chunkModel == NO_MODEL) {
+				chunkModel = static_cast<uint32_t>(file.models.size());
+				file.models.push_back(scene.models[model]);
+			}
+
+			file.instances.push_back({ chunkModel, transform.pos, SFE::Math::degrees(transform.rotate.toEuler()), transform.scale });
+		}
+
+		//chunks system creates instances of the same model by slices
+		for (auto& chunk : chunks) {
+			std::ranges::stable_sort(chunk.file.instances, {}, &ChunkFile::Instance::model);
+		}
+
+		std::ranges::sort(chunks, [](const Chunk& lhs, const Chunk& rhs) {
+			return std::tie(lhs.coords.x, lhs.coords.y, lhs.coords.z) < std::tie(rhs.coords.x, rhs.coords.y, rhs.coords.z);
+		});
+
+		return chunks;
+	}
+}
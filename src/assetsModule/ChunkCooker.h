@@ -0,0 +1,24 @@
+﻿#pragma once
+#include <vector>
+
+#include "ChunkFile.h"
+#include "mathModule/Forward.h"
+
+namespace SFE::PropertiesModule {
+	struct SceneFile;
+}
+
+namespace AssetsModule {
+	//splits binary scene into chunk files which chunks system streams
+	//hierarchy is flattened, every node with model becomes instance with world transform in chunk which its world position falls into
+	class ChunkCooker {
+	public:
+		struct Chunk {
+			SFE::Math::IVec3 coords = {};
+			ChunkFile file;
+		};
+
+		//chunks are sorted by coords, chunks without instances aren't returned
+		static std::vector<Chunk> split(const SFE::PropertiesModule::SceneFile& scene, float chunkSize);
+	};
+}
@@ -0,0 +1,69 @@
+﻿#include "ChunkFile.h"
+
+#include <cmath>
+
+#include "propertiesModule/BinaryArchive.h"
+
+namespace AssetsModule {
+	SFE::Math::IVec3 ChunkFile::getChunk(const SFE::Math::Vec3& pos, float chunkSize) {
+		return { static_cast<int>(std::floor(pos.x / chunkSize)), static_cast<int>(std::floor(pos.y / chunkSize)), static_cast<int>(std::floor(pos.z / chunkSize)) };
+	}
+
+	std::string ChunkFile::getPath(const SFE::Math::IVec3& chunk, std::string_view directory) {
+		return std::string(directory) + "/" + std::to_string(chunk.x) + "_" + std::to_string(chunk.y) + "_" + std::to_string(chunk.z) + ".chunk";
+	}
+
+	bool ChunkFile::read(const std::vector<uint8_t>& data) {
+		models.clear();
+		instances.clear();
+
+		SFE::PropertiesModule::BinaryReader reader(data);
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		if (!reader.read(magic) || magic != MAGIC || !reader.read(version) || version != VERSION) {
+			return false;
+		}
+
+		uint32_t modelsCount = 0;
+		reader.read(modelsCount);
+		if (modelsCount > reader.getRemaining() / sizeof(uint32_t)) {
+			return false;
+		}
+		models.resize(modelsCount);
+		for (auto& model : models) {
+			reader.readString(model);
+		}
+
+		reader.readArray(instances);
+		if (!reader.isValid()) {
+			models.clear();
+			instances.clear();
+			return false;
+		}
+
+		//instance with broken model index would be spawned without model
+		for (const auto& instance : instances) {
+			if (instance.model >= models.size()) {
+				models.clear();
+				instances.clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void ChunkFile::write(std::vector<uint8_t>& data) const {
+		data.clear();
+		SFE::PropertiesModule::BinaryWriter writer(data);
+		writer.write(MAGIC);
+		writer.write(VERSION);
+
+		writer.write(static_cast<uint32_t>(models.size()));
+		for (const auto& model : models) {
+			writer.writeString(model);
+		}
+
+		writer.writeArray(std::span<const Instance>(instances));
+	}
+}
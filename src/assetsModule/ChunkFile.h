@@ -0,0 +1,35 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mathModule/Forward.h"
+
+namespace AssetsModule {
+	//cooked content of world chunk, it is read on loading threads and instantiated by chunks system
+	//models are stored once per chunk, instances refer to them by index, instances of the same model should go together, they are created by slices
+	struct ChunkFile {
+		constexpr static uint32_t MAGIC = 0x48434653; //SFCH
+		constexpr static uint32_t VERSION = 1;
+		constexpr static std::string_view DIRECTORY = "chunks";
+
+		struct Instance {
+			uint32_t model = 0;
+			SFE::Math::Vec3 pos = {};
+			SFE::Math::Vec3 rotate = {};
+			SFE::Math::Vec3 scale = { 1.f };
+		};
+
+		std::vector<std::string> models;
+		std::vector<Instance> instances;
+
+		//chunk which position falls into, cooker and chunks system must agree on it
+		static SFE::Math::IVec3 getChunk(const SFE::Math::Vec3& pos, float chunkSize);
+		static std::string getPath(const SFE::Math::IVec3& chunk, std::string_view directory = DIRECTORY);
+
+		//returns false if data is not a chunk of current version, file stays empty then
+		bool read(const std::vector<uint8_t>& data);
+		void write(std::vector<uint8_t>& data) const;
+	};
+}
@@ -1,18 +1,19 @@
 ﻿#pragma once
 
-#include "glWrapper/Buffer.h"
-#include "glWrapper/VertexArray.h"
-#include "modelModule/Vertex.h"
+#include "modelModule/GeometryArena.h"
 
 namespace SFE {
+	//mesh geometry is owned by GeometryArena, this only keeps the handle alive while mesh is registered
 	struct RenderMeshData {
-		GLW::VertexArray vao;
-		GLW::Buffer<GLW::ARRAY_BUFFER, Vertex3D> vboBuf;
-		GLW::Buffer<GLW::ELEMENT_ARRAY_BUFFER, unsigned int> eboBuf;
+		RenderMeshData() = default;
+		RenderMeshData(const RenderMeshData& other) = delete;
+		RenderMeshData& operator=(const RenderMeshData& other) = delete;
+
+		GeometryArena::Handle handle;
 
 		size_t verticesCount = 0;
 		size_t indicesCount = 0;
 		void release();
 		~RenderMeshData();
 	};
-}
\ No newline at end of file
+}
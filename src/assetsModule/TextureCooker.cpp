@@ -0,0 +1,170 @@
+﻿#include "TextureCooker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+
+#include "core/FileSystem.h"
+#include "core/Hash.h"
+#include "core/FramePacing.h"
+#include "logsModule/logger.h"
+#include "propertiesModule/BinaryArchive.h"
+
+namespace AssetsModule {
+	namespace {
+		double toMs(int64_t ns) {
+			return static_cast<double>(ns) / 1'000'000.0;
+		}
+
+		double toMBs(size_t bytes, double ms) {
+			return ms > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+		}
+	}
+
+	bool TextureCooker::cook(const std::string& path, const Settings& settings, TextureImage& image) {
+		std::vector<uint8_t> source;
+		if (!SFE::FileSystem::readBinaryFile(path, source)) {
+			return false;
+		}
+
+		const auto hash = getHash(source, settings);
+		const auto cachePath = getCachePath(hash);
+		if (cacheEnabled && readCache(cachePath, hash, image)) {
+			return true;
+		}
+
+		if (!image.decode(source, settings.flip)) {
+			return false;
+		}
+		image.generateMips(settings.filter);
+		image.compress(settings.compression);
+
+		if (cacheEnabled) {
+			writeCache(cachePath, hash, image);
+		}
+		return true;
+	}
+
+	uint64_t TextureCooker::getHash(std::span<const uint8_t> source, const Settings& settings) {
+		auto hash = SFE::hashBytes(source.data(), source.size());
+		hash = SFE::hashBytes(&VERSION, sizeof(VERSION), hash);
+		hash = SFE::hashBytes(&settings.flip, sizeof(settings.flip), hash);
+		hash = SFE::hashBytes(&settings.filter, sizeof(settings.filter), hash);
+		return SFE::hashBytes(&settings.compression, sizeof(settings.compression), hash);
+	}
+
+	std::string TextureCooker::getCachePath(uint64_t hash) {
+		char name[17];
+		std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+		return std::string(CACHE_FOLDER) + name + ".tex";
+	}
+
+	TextureCooker::BenchmarkResult TextureCooker::benchmark(const std::vector<std::string>& paths, const Settings& settings) {
+		BenchmarkResult result;
+		std::vector<std::vector<uint8_t>> sources;
+		sources.reserve(paths.size());
+		for (const auto& path : paths) {
+			auto& source = sources.emplace_back();
+			if (!SFE::FileSystem::readBinaryFile(path, source)) {
+				SFE_LOG_ERROR("TextureCooker::benchmark can't read %s", path.c_str());
+				sources.pop_back();
+				continue;
+			}
+			result.sourceBytes += source.size();
+		}
+
+		std::vector<TextureImage> images(sources.size());
+		auto start = SFE::CoreModule::monotonicNs();
+		for (size_t i = 0; i < sources.size(); i++) {
+			images[i].decode(sources[i], settings.flip);
+		}
+		result.decodeMs = toMs(SFE::CoreModule::monotonicNs() - start);
+
+		size_t decodedBytes = 0;
+		for (const auto& image : images) {
+			result.textures += !image.mips.empty();
+			result.pixels += static_cast<size_t>(image.width) * image.height;
+			decodedBytes += image.getBytes();
+		}
+
+		start = SFE::CoreModule::monotonicNs();
+		for (auto& image : images) {
+			image.generateMips(settings.filter);
+		}
+		result.mipsMs = toMs(SFE::CoreModule::monotonicNs() - start);
+
+		size_t mipsBytes = 0;
+		for (const auto& image : images) {
+			mipsBytes += image.getBytes();
+		}
+
+		start = SFE::CoreModule::monotonicNs();
+		for (auto& image : images) {
+			image.compress(settings.compression);
+		}
+		result.encodeMs = toMs(SFE::CoreModule::monotonicNs() - start);
+
+		for (const auto& image : images) {
+			result.cookedBytes += image.getBytes();
+		}
+
+		//decode speed is given in source bytes, mips and encode in rgba bytes they read
+		SFE_LOG_INFO("TextureCooker::benchmark %zu textures, %zu pixels, decode: %.1f ms %.1f MB/s, mips: %.1f ms %.1f MB/s, encode: %.1f ms %.1f MB/s, %zu bytes cooked",
+			result.textures, result.pixels, result.decodeMs, toMBs(result.sourceBytes, result.decodeMs), result.mipsMs, toMBs(decodedBytes, result.mipsMs), result.encodeMs, toMBs(mipsBytes, result.encodeMs), result.cookedBytes);
+		return result;
+	}
+
+	std::vector<std::string> TextureCooker::findSources(std::string_view folder) {
+		constexpr std::string_view EXTENSIONS[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".hdr" };
+
+		std::vector<std::string> paths;
+		std::error_code error;
+		for (auto it = std::filesystem::recursive_directory_iterator(folder, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+			if (!it->is_regular_file()) {
+				continue;
+			}
+
+			auto extension = it->path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			if (std::find(std::begin(EXTENSIONS), std::end(EXTENSIONS), extension) != std::end(EXTENSIONS)) {
+				paths.push_back(it->path().generic_string());
+			}
+		}
+		return paths;
+	}
+
+	bool TextureCooker::readCache(const std::string& cachePath, uint64_t hash, TextureImage& image) {
+		std::vector<uint8_t> data;
+		if (!SFE::FileSystem::readBinaryFile(cachePath, data)) {
+			return false;
+		}
+
+		SFE::PropertiesModule::BinaryReader reader(data);
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint64_t cachedHash = 0;
+		reader.read(magic);
+		reader.read(version);
+		reader.read(cachedHash);
+		//broken or foreign file is cooked again and overwritten
+		return reader.isValid() && magic == MAGIC && version == VERSION && cachedHash == hash && image.read(reader);
+	}
+
+	void TextureCooker::writeCache(const std::string& cachePath, uint64_t hash, const TextureImage& image) {
+		std::error_code error;
+		std::filesystem::create_directories(CACHE_FOLDER, error);
+
+		std::vector<uint8_t> data;
+		data.reserve(image.getBytes() + 64);
+		SFE::PropertiesModule::BinaryWriter writer(data);
+		writer.write(MAGIC);
+		writer.write(VERSION);
+		writer.write(hash);
+		image.write(writer);
+
+		if (!SFE::FileSystem::writeBinaryFile(cachePath, data.data(), data.size())) {
+			SFE_LOG_ERROR("TextureCooker::can't write cache %s", cachePath.c_str());
+		}
+	}
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TextureImage.h"
+
+//decodes, builds mips and encodes textures of models folder on start and logs time of every stage
+#define TEXTURE_BENCHMARK 0
+
+namespace AssetsModule {
+	//turns source texture into image with mips, result is kept in cache folder under hash of source bytes and settings,
+	//so the next start reads ready mips instead of decoding, changed source gets new hash and is cooked again
+	//it doesn't touch gl, so it runs on any thread
+	class TextureCooker {
+	public:
+		constexpr static uint32_t MAGIC = 0x58544653; //SFTX
+		constexpr static uint32_t VERSION = 1;
+		constexpr static std::string_view CACHE_FOLDER = "cache/textures/";
+
+		struct Settings {
+			bool flip = false;
+			MipFilter filter = MipFilter::BOX;
+			TextureCompression compression = TextureCompression::NONE;
+		};
+
+		struct BenchmarkResult {
+			size_t textures = 0;
+			size_t sourceBytes = 0;
+			size_t pixels = 0;
+			size_t cookedBytes = 0;
+			double decodeMs = 0.0;
+			double mipsMs = 0.0;
+			double encodeMs = 0.0;
+		};
+
+		inline static bool cacheEnabled = true;
+
+		//returns false if source can't be read or decoded
+		static bool cook(const std::string& path, const Settings& settings, TextureImage& image);
+
+		static uint64_t getHash(std::span<const uint8_t> source, const Settings& settings);
+		static std::string getCachePath(uint64_t hash);
+
+		//stages are measured one by one on calling thread over all textures, cache isn't used
+		static BenchmarkResult benchmark(const std::vector<std::string>& paths, const Settings& settings);
+		//image files of folder and its subfolders
+		static std::vector<std::string> findSources(std::string_view folder);
+
+	private:
+		static bool readCache(const std::string& cachePath, uint64_t hash, TextureImage& image);
+		static void writeCache(const std::string& cachePath, uint64_t hash, const TextureImage& image);
+	};
+}
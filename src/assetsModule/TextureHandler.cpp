@@ -1,12 +1,16 @@
 ﻿#include "TextureHandler.h"
 
-#include <stb_image.h>
+#include <algorithm>
 #include <string>
 
 #include "AssetsManager.h"
+#include "TextureCooker.h"
 #include "core/Engine.h"
+#include "core/FileSystem.h"
+#include "glWrapper/Sync.h"
 #include "multithreading/ThreadPool.h"
 #include "logsModule/logger.h"
+#include "renderModule/TextureStreamer.h"
 
 using namespace AssetsModule;
 
@@ -22,49 +26,63 @@ void TextureHandler::bindTextureToSlot(unsigned slot, Texture* texture) {
 	SFE::GLW::bindTextureToSlot(slot, texture->texture.mType, texture->texture.mId);
 }
 
-Texture* TextureHandler::loadTexture(const std::string& path, bool flip, SFE::GLW::PixelFormat pixelFormat, SFE::GLW::TextureFormat textureFormat, SFE::GLW::PixelDataType pixelType) {
+Texture* TextureHandler::loadTexture(const std::string& path, TextureUsage usage, bool flip, SFE::GLW::PixelFormat pixelFormat, SFE::GLW::TextureFormat textureFormat, SFE::GLW::PixelDataType pixelType) {
 	auto texture = AssetsManager::instance()->getAsset<Texture>(path);
 	if (texture) {
 		return texture;
 	}
 
-	stbi_set_flip_vertically_on_load(flip);
-
-	int texWidth, texHeight, nrChannels;
-	auto data = stbi_load(path.data(), &texWidth, &texHeight, &nrChannels, 4);
-	if (!data) {
-		SFE::LogsModule::Logger::LOG_ERROR("TextureHandler::can't load texture %s", path.c_str());
-		stbi_image_free(data);
+	const auto settings = getSettings(usage, flip);
+	auto image = std::make_shared<TextureImage>();
+	if (!TextureCooker::cook(path, settings, *image)) {
+		SFE_LOG_ERROR("TextureHandler::can't load texture %s", path.c_str());
 		return &TextureHandler::instance()->mDefaultTex;
 	}
 
-	texture = AssetsManager::instance()->createAsset<Texture>(path);
-	texture->texture.mType = SFE::GLW::TextureType::TEXTURE_2D;
+	return createTexture(path, settings, std::move(image), pixelFormat, textureFormat, pixelType);
+}
 
-	texture->texture.parameters.minFilter = SFE::GLW::TextureMinFilter::LINEAR;
-	texture->texture.parameters.magFilter = SFE::GLW::TextureMagFilter::LINEAR;
+std::vector<Texture*> TextureHandler::loadTextures(const std::vector<std::string>& paths, TextureUsage usage, bool flip) {
+	std::vector<Texture*> textures(paths.size(), nullptr);
 
-	texture->texture.parameters.wrap.S = SFE::GLW::TextureWrap::REPEAT;
-	texture->texture.parameters.wrap.T = SFE::GLW::TextureWrap::REPEAT;
+	//the first index of every path which is not loaded yet
+	std::unordered_map<std::string, size_t> firstIndices;
+	std::vector<size_t> toCook;
+	for (size_t i = 0; i < paths.size(); i++) {
+		textures[i] = AssetsManager::instance()->getAsset<Texture>(paths[i]);
+		if (!textures[i] && firstIndices.try_emplace(paths[i], i).second) {
+			toCook.push_back(i);
+		}
+	}
 
-	texture->texture.pixelFormat = pixelFormat;
-	texture->texture.textureFormat = textureFormat;
-	texture->texture.pixelType = pixelType;
-	texture->texture.width = texWidth;
-	texture->texture.height = texHeight;
+	const auto settings = getSettings(usage, flip);
+	std::vector<std::shared_ptr<TextureImage>> images(toCook.size());
+	SFE::ThreadPool::instance()->addBatchTasks(toCook.size(), 1, [&paths, &toCook, &images, &settings](size_t i) {
+		auto image = std::make_shared<TextureImage>();
+		if (TextureCooker::cook(paths[toCook[i]], settings, *image)) {
+			images[i] = std::move(image);
+		}
+	}).waitAll();
 
-	if (SFE::Engine::isMainThread()) {
-		texture->texture.create(data);
-		stbi_image_free(data);
+	//assets manager isn't thread safe, so assets are created here
+	for (size_t i = 0; i < toCook.size(); i++) {
+		const auto& path = paths[toCook[i]];
+		if (images[i]) {
+			textures[toCook[i]] = createTexture(path, settings, std::move(images[i]), SFE::GLW::RGBA8, SFE::GLW::RGBA, SFE::GLW::UNSIGNED_BYTE);
+		}
+		else {
+			SFE_LOG_ERROR("TextureHandler::can't load texture %s", path.c_str());
+			textures[toCook[i]] = &TextureHandler::instance()->mDefaultTex;
+		}
 	}
-	else {
-		SFE::ThreadPool::instance()->addTask<SFE::WorkerType::RESOURCE_LOADING>([id = texture->assetId, data]()mutable {
-			AssetsManager::instance()->getAsset<Texture>(id)->texture.create(data);
-			stbi_image_free(data);
-		});
+
+	for (size_t i = 0; i < paths.size(); i++) {
+		if (!textures[i]) {
+			textures[i] = textures[firstIndices[paths[i]]];
+		}
 	}
 
-	return texture;
+	return textures;
 }
 
 Texture* TextureHandler::loadCubemapTexture(const std::string& path, bool flip) {
@@ -73,7 +91,22 @@ Texture* TextureHandler::loadCubemapTexture(const std::string& path, bool flip)
 		return texture;
 	}
 
-	stbi_set_flip_vertically_on_load(flip);
+	std::vector<std::string> faces{
+		path + "right.jpg",
+		path + "left.jpg",
+		path + "top.jpg",
+		path + "bottom.jpg",
+		path + "front.jpg",
+		path + "back.jpg"
+	};
+
+	std::vector<TextureImage> images(faces.size());
+	SFE::ThreadPool::instance()->addBatchTasks(faces.size(), 1, [&faces, &images, flip](size_t i) {
+		std::vector<uint8_t> source;
+		if (SFE::FileSystem::readBinaryFile(faces[i], source)) {
+			images[i].decode(source, flip);
+		}
+	}).waitAll();
 
 	texture = AssetsManager::instance()->createAsset<Texture>(path);
 	texture->texture.mType = SFE::GLW::TextureType::TEXTURE_CUBE_MAP;
@@ -89,31 +122,133 @@ Texture* TextureHandler::loadCubemapTexture(const std::string& path, bool flip)
 	texture->texture.parameters.apply(&texture->texture);
 	texture->texture.applyPixelStorageMode();
 
-	
-
-	std::vector<std::string> faces{
-		path + "right.jpg",
-		path + "left.jpg",
-		path + "top.jpg",
-		path + "bottom.jpg",
-		path + "front.jpg",
-		path + "back.jpg"
-	};
-
-	int width, height, nrChannels;
 	for (unsigned int i = 0; i < faces.size(); i++) {
-		auto data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-		if (!data) {
-			SFE::LogsModule::Logger::LOG_ERROR("TextureHandler::can't load texture %s", faces[i].c_str());
-			stbi_image_free(data);
+		if (images[i].mips.empty()) {
+			SFE_LOG_ERROR("TextureHandler::can't load texture %s", faces[i].c_str());
 			continue;
 		}
-		
-		texture->texture.image2D(static_cast<int>(SFE::GLW::CubeMapFaces::POSITIVE_X) + i, width, height, SFE::GLW::RGB8, SFE::GLW::RGB, SFE::GLW::UNSIGNED_BYTE, data);
-		stbi_image_free(data);
+
+		const auto& face = images[i].mips.front();
+		texture->texture.image2D(static_cast<int>(SFE::GLW::CubeMapFaces::POSITIVE_X) + i, face.width, face.height, SFE::GLW::RGBA8, SFE::GLW::RGBA, SFE::GLW::UNSIGNED_BYTE, face.data.data());
 	}
 
 	SFE::GLW::bindTextureToSlot(0, texture->texture.mType, 0);
 	
 	return texture;
+}
+
+TextureCooker::Settings TextureHandler::getSettings(TextureUsage usage, bool flip) {
+	return { flip, mipFilter, usage == TextureUsage::NORMAL ? normalCompression : compression };
+}
+
+SFE::GLW::PixelFormat TextureHandler::getPixelFormat(TextureCompression compression, SFE::GLW::PixelFormat uncompressed) {
+	switch (compression) {
+	case TextureCompression::BC1: return SFE::GLW::COMPRESSED_RGB_BC1;
+	case TextureCompression::BC3: return SFE::GLW::COMPRESSED_RGBA_BC3;
+	case TextureCompression::BC5: return SFE::GLW::COMPRESSED_RG_BC5;
+	case TextureCompression::BC7: return SFE::GLW::COMPRESSED_RGBA_BC7;
+	case TextureCompression::NONE: return uncompressed;
+	}
+	return uncompressed;
+}
+
+size_t TextureHandler::getStreamingLevel(const TextureImage& image) {
+	auto level = image.mips.size() - 1;
+	while (level > 0 && std::max(image.mips[level - 1].width, image.mips[level - 1].height) <= STREAMING_MIN_SIZE) {
+		level--;
+	}
+	return level;
+}
+
+Texture* TextureHandler::createTexture(const std::string& path, const TextureCooker::Settings& settings, std::shared_ptr<const TextureImage> image, SFE::GLW::PixelFormat pixelFormat, SFE::GLW::TextureFormat textureFormat, SFE::GLW::PixelDataType pixelType) {
+	const auto levels = image->mips.size();
+
+	auto texture = AssetsManager::instance()->createAsset<Texture>(path);
+	texture->texture.mType = SFE::GLW::TextureType::TEXTURE_2D;
+
+	texture->texture.parameters.minFilter = levels > 1 ? SFE::GLW::TextureMinFilter::LINEAR_MIPMAP_LINEAR : SFE::GLW::TextureMinFilter::LINEAR;
+	texture->texture.parameters.magFilter = SFE::GLW::TextureMagFilter::LINEAR;
+	texture->texture.parameters.maxLevel = static_cast<int>(levels) - 1;
+
+	texture->texture.parameters.wrap.S = SFE::GLW::TextureWrap::REPEAT;
+	texture->texture.parameters.wrap.T = SFE::GLW::TextureWrap::REPEAT;
+
+	texture->texture.pixelFormat = getPixelFormat(image->compression, pixelFormat);
+	texture->texture.textureFormat = textureFormat;
+	texture->texture.pixelType = pixelType;
+	texture->texture.width = image->width;
+	texture->texture.height = image->height;
+
+	SFE::Render::TextureStreamer::Source source{ path, settings };
+	if (SFE::Engine::isRenderThread()) {
+		texture->texture.generate();
+		texture->texture.bind();
+		texture->texture.parameters.apply(&texture->texture);
+		texture->texture.applyPixelStorageMode();
+		uploadLevels(texture->texture, *image, 0, levels);
+		texture->texture.unbind();
+
+		const auto locked = static_cast<uint32_t>(getStreamingLevel(*image));
+		SFE::Render::TextureStreamer::instance()->addTexture(texture->assetId, texture->texture.mId, std::move(source), *image, 0, locked);
+		return texture;
+	}
+
+	SFE::ThreadPool::instance()->addTask<SFE::WorkerType::GPU_UPLOAD>([id = texture->assetId, image = std::move(image), source = std::move(source)]() mutable {
+		auto& texture = AssetsManager::instance()->getAsset<Texture>(id)->texture;
+		const auto first = getStreamingLevel(*image);
+
+		//base level is set before levels, so texture is never sampled from levels which are not uploaded yet
+		texture.parameters.baseLevel = static_cast<int>(first);
+		texture.generate();
+		SFE::GLW::bindTexture(texture.mType, texture.mId);
+		texture.parameters.apply(&texture);
+		texture.applyPixelStorageMode();
+		uploadLevels(texture, *image, first, image->mips.size());
+		SFE::GLW::bindTexture(texture.mType, 0);
+		SFE::GLW::waitGpu();
+
+		//streamer loads the rest when meshes need them
+		if (SFE::Render::TextureStreamer::enabled) {
+			SFE::Render::TextureStreamer::instance()->addTexture(id, texture.mId, std::move(source), *image, static_cast<uint32_t>(first), static_cast<uint32_t>(first));
+			return;
+		}
+
+		streamLevel(id, std::move(image), std::move(source), first);
+	});
+
+	return texture;
+}
+
+void TextureHandler::uploadLevels(const SFE::GLW::Texture& texture, const TextureImage& image, size_t first, size_t last) {
+	for (auto level = first; level < last; level++) {
+		const auto& mip = image.mips[level];
+		if (image.compression == TextureCompression::NONE) {
+			texture.imageLevel2D(static_cast<int>(level), mip.width, mip.height, mip.data.data());
+		}
+		else {
+			texture.compressedImageLevel2D(static_cast<int>(level), mip.width, mip.height, mip.data.size(), mip.data.data());
+		}
+	}
+}
+
+void TextureHandler::streamLevel(size_t assetId, std::shared_ptr<const TextureImage> image, SFE::Render::TextureStreamer::Source source, size_t level) {
+	if (level == 0) {
+		const auto& texture = AssetsManager::instance()->getAsset<Texture>(assetId)->texture;
+		SFE::Render::TextureStreamer::instance()->addTexture(assetId, texture.mId, std::move(source), *image, 0, static_cast<uint32_t>(getStreamingLevel(*image)));
+		return;
+	}
+
+	//every level is a separate task on upload thread, so levels of other textures go between them and level is finished before base level goes below it
+	SFE::ThreadPool::instance()->addTask<SFE::WorkerType::GPU_UPLOAD>([assetId, image = std::move(image), source = std::move(source), level]() mutable {
+		auto& texture = AssetsManager::instance()->getAsset<Texture>(assetId)->texture;
+
+		SFE::GLW::bindTexture(texture.mType, texture.mId);
+		uploadLevels(texture, *image, level - 1, level);
+		texture.parameters.baseLevel = static_cast<int>(level - 1);
+		texture.setParameter(SFE::GLW::BASE_LEVEL, texture.parameters.baseLevel);
+		SFE::GLW::bindTexture(texture.mType, 0);
+		SFE::GLW::waitGpu();
+
+		streamLevel(assetId, std::move(image), std::move(source), level - 1);
+	});
 }
\ No newline at end of file
@@ -2,12 +2,17 @@
 
 #include <array>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "Asset.h"
+#include "TextureCooker.h"
+#include "TextureImage.h"
 #include "containersModule/Singleton.h"
 #include "glWrapper/Texture.h"
+#include "renderModule/TextureStreamer.h"
 
 namespace AssetsModule {
 	class Texture : public Asset {
@@ -25,13 +30,47 @@ namespace AssetsModule {
 		SFE::GLW::Texture texture;
 	};
 
+	//normal maps keep only x and y, so they can be compressed to two channels, shaders restore z
+	enum class TextureUsage : uint8_t {
+		COLOR,
+		NORMAL
+	};
+
+	//textures are cooked by TextureCooker on calling thread or on common workers, so decoding doesn't wait for gl context,
+	//outside render thread mips are uploaded by upload worker from the smallest one, texture is usable after the first step
+	//levels are mutable and every texture is given to TextureStreamer, which drops levels that visible meshes don't need
 	class TextureHandler : public SFE::Singleton<TextureHandler> {
 		friend Singleton;
 	public:
+		//levels which are not bigger than it are uploaded by the first streaming step together
+		constexpr static int STREAMING_MIN_SIZE = 64;
+
+		//settings of textures loaded after change, color textures can use bc1, bc3 or bc7, normal maps use bc5
+		inline static MipFilter mipFilter = MipFilter::BOX;
+		inline static TextureCompression compression = TextureCompression::NONE;
+		inline static TextureCompression normalCompression = TextureCompression::BC5;
+
 		static void bindTextureToSlot(unsigned slot, Texture* texture);
 		Texture mDefaultTex;
 
-		static Texture* loadTexture(const std::string& path, bool flip = false, SFE::GLW::PixelFormat pixelFormat = SFE::GLW::RGBA8, SFE::GLW::TextureFormat textureFormat = SFE::GLW::RGBA, SFE::GLW::PixelDataType pixelType = SFE::GLW::UNSIGNED_BYTE);
+		//pixels are always rgba bytes, pixel format is used only when texture is not compressed
+		static Texture* loadTexture(const std::string& path, TextureUsage usage = TextureUsage::COLOR, bool flip = false, SFE::GLW::PixelFormat pixelFormat = SFE::GLW::RGBA8, SFE::GLW::TextureFormat textureFormat = SFE::GLW::RGBA, SFE::GLW::PixelDataType pixelType = SFE::GLW::UNSIGNED_BYTE);
+		//textures are cooked on common workers at once, result is in order of paths, default texture for broken ones
+		static std::vector<Texture*> loadTextures(const std::vector<std::string>& paths, TextureUsage usage = TextureUsage::COLOR, bool flip = false);
+		//faces are decoded in parallel and uploaded on calling thread, so it should have gl context
 		static Texture* loadCubemapTexture(const std::string& path, bool flip = false);
+
+		static TextureCooker::Settings getSettings(TextureUsage usage, bool flip);
+		static SFE::GLW::PixelFormat getPixelFormat(TextureCompression compression, SFE::GLW::PixelFormat uncompressed = SFE::GLW::RGBA8);
+
+		//levels from it to the end are uploaded by the first streaming step and are never dropped
+		static size_t getStreamingLevel(const TextureImage& image);
+
+	private:
+		static Texture* createTexture(const std::string& path, const TextureCooker::Settings& settings, std::shared_ptr<const TextureImage> image, SFE::GLW::PixelFormat pixelFormat, SFE::GLW::TextureFormat textureFormat, SFE::GLW::PixelDataType pixelType);
+		//levels in [first, last) of bound texture
+		static void uploadLevels(const SFE::GLW::Texture& texture, const TextureImage& image, size_t first, size_t last);
+		//uploads level under the given one and lowers base level to it, then queues the next, the whole texture is given to streamer
+		static void streamLevel(size_t assetId, std::shared_ptr<const TextureImage> image, SFE::Render::TextureStreamer::Source source, size_t level);
 	};
-}
+}
\ No newline at end of file
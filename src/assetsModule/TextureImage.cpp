@@ -0,0 +1,292 @@
+﻿#include "TextureImage.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <stb_image.h>
+
+#include "BlockCompression.h"
+#include "mathModule/Float4.h"
+#include "propertiesModule/BinaryArchive.h"
+
+namespace AssetsModule {
+	namespace {
+		constexpr int KAISER_TAPS = 6;
+		constexpr float KAISER_HALF_WIDTH = 1.5f;
+		constexpr float KAISER_ALPHA = 4.f;
+
+		float besselI0(float x) {
+			float sum = 1.f;
+			float term = 1.f;
+			for (int i = 1; i < 16; i++) {
+				term *= (x * 0.5f / static_cast<float>(i)) * (x * 0.5f / static_cast<float>(i));
+				sum += term;
+			}
+			return sum;
+		}
+
+		//weights of source pixels from 2x - 2 to 2x + 3 for output pixel x, distance is measured in output pixels
+		std::array<float, KAISER_TAPS> makeKaiserWeights() {
+			std::array<float, KAISER_TAPS> weights;
+			float sum = 0.f;
+			for (int tap = 0; tap < KAISER_TAPS; tap++) {
+				const float distance = (static_cast<float>(tap) - 2.5f) * 0.5f;
+				const float x = distance / KAISER_HALF_WIDTH;
+				const float window = std::abs(x) < 1.f ? besselI0(KAISER_ALPHA * std::sqrt(1.f - x * x)) / besselI0(KAISER_ALPHA) : 0.f;
+				const float angle = std::numbers::pi_v<float> * distance;
+				weights[tap] = std::sin(angle) / angle * window;
+				sum += weights[tap];
+			}
+			for (auto& weight : weights) {
+				weight /= sum;
+			}
+			return weights;
+		}
+
+		//odd sizes repeat the last row and column
+		void downsampleBox(const TextureImage::Mip& src, TextureImage::Mip& dst) {
+			const size_t srcRow = static_cast<size_t>(src.width) * 4;
+			for (int y = 0; y < dst.height; y++) {
+				const auto row0 = src.data.data() + std::min(2 * y, src.height - 1) * srcRow;
+				const auto row1 = src.data.data() + std::min(2 * y + 1, src.height - 1) * srcRow;
+				const auto out = dst.data.data() + static_cast<size_t>(y) * dst.width * 4;
+
+				int x = 0;
+#ifdef SFE_SSE
+				//two output pixels from four source pixels of both rows
+				const auto zero = _mm_setzero_si128();
+				const auto rounding = _mm_set1_epi16(2);
+				for (; x + 2 <= dst.width && 2 * x + 4 <= src.width; x += 2) {
+					const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+					const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+					const auto lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+					const auto hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+					auto sum = _mm_unpacklo_epi64(_mm_add_epi16(lo, _mm_srli_si128(lo, 8)), _mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+					sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(sum, sum));
+				}
+#endif
+				for (; x < dst.width; x++) {
+					const auto x0 = std::min(2 * x, src.width - 1) * 4;
+					const auto x1 = std::min(2 * x + 1, src.width - 1) * 4;
+					for (int c = 0; c < 4; c++) {
+						out[x * 4 + c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+					}
+				}
+			}
+		}
+
+		//separable, rows are filtered into floats first, edges are clamped
+		void downsampleKaiser(const TextureImage::Mip& src, TextureImage::Mip& dst) {
+			static const auto weights = makeKaiserWeights();
+
+			std::vector<float> rows(static_cast<size_t>(src.height) * dst.width * 4);
+			for (int y = 0; y < src.height; y++) {
+				const auto row = src.data.data() + static_cast<size_t>(y) * src.width * 4;
+				for (int x = 0; x < dst.width; x++) {
+					auto sum = SFE::Math::Float4::zero();
+					for (int tap = 0; tap < KAISER_TAPS; tap++) {
+						const auto sx = std::clamp(2 * x - 2 + tap, 0, src.width - 1);
+						sum = sum + SFE::Math::Float4::loadBytes(row + sx * 4) * weights[tap];
+					}
+					sum.store(rows.data() + (static_cast<size_t>(y) * dst.width + x) * 4);
+				}
+			}
+
+			for (int y = 0; y < dst.height; y++) {
+				const auto out = dst.data.data() + static_cast<size_t>(y) * dst.width * 4;
+				for (int x = 0; x < dst.width; x++) {
+					auto sum = SFE::Math::Float4::zero();
+					for (int tap = 0; tap < KAISER_TAPS; tap++) {
+						const auto sy = std::clamp(2 * y - 2 + tap, 0, src.height - 1);
+						sum = sum + SFE::Math::Float4::load(rows.data() + (static_cast<size_t>(sy) * dst.width + x) * 4) * weights[tap];
+					}
+					sum.storeBytes(out + x * 4);
+				}
+			}
+		}
+	}
+
+	bool TextureImage::decode(std::span<const uint8_t> data, bool flip) {
+		clear();
+		if (data.empty() || data.size() > static_cast<size_t>(std::numeric_limits<int>::max())) {
+			return false;
+		}
+
+		int w = 0;
+		int h = 0;
+		int channels = 0;
+		auto pixels = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &w, &h, &channels, 4);
+		if (!pixels) {
+			return false;
+		}
+
+		auto& mip = mips.emplace_back();
+		mip.width = w;
+		mip.height = h;
+		mip.data.resize(static_cast<size_t>(w) * h * 4);
+
+		const size_t rowBytes = static_cast<size_t>(w) * 4;
+		for (int y = 0; y < h; y++) {
+			const auto srcRow = flip ? h - 1 - y : y;
+			std::memcpy(mip.data.data() + y * rowBytes, pixels + srcRow * rowBytes, rowBytes);
+		}
+		stbi_image_free(pixels);
+
+		width = w;
+		height = h;
+		return true;
+	}
+
+	void TextureImage::generateMips(MipFilter filter) {
+		assert(compression == TextureCompression::NONE);
+		if (mips.empty() || compression != TextureCompression::NONE) {
+			return;
+		}
+
+		mips.resize(1);
+		if (filter == MipFilter::NONE) {
+			return;
+		}
+
+		while (mips.back().width > 1 || mips.back().height > 1) {
+			Mip mip;
+			mip.width = std::max(1, mips.back().width / 2);
+			mip.height = std::max(1, mips.back().height / 2);
+			mip.data.resize(static_cast<size_t>(mip.width) * mip.height * 4);
+
+			if (filter == MipFilter::KAISER) {
+				downsampleKaiser(mips.back(), mip);
+			}
+			else {
+				downsampleBox(mips.back(), mip);
+			}
+			mips.push_back(std::move(mip));
+		}
+	}
+
+	void TextureImage::compress(TextureCompression target) {
+		if (target == TextureCompression::NONE || compression != TextureCompression::NONE) {
+			return;
+		}
+
+		const auto blockBytes = getBlockBytes(target);
+		uint8_t pixels[BlockCompression::BLOCK_PIXELS * 4];
+		for (auto& mip : mips) {
+			const int blocksX = (mip.width + 3) / 4;
+			const int blocksY = (mip.height + 3) / 4;
+			std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+			auto block = blocks.data();
+			for (int by = 0; by < blocksY; by++) {
+				for (int bx = 0; bx < blocksX; bx++, block += blockBytes) {
+					//pixels out of small or odd mip repeat the edge
+					for (int y = 0; y < BlockCompression::BLOCK_SIZE; y++) {
+						const auto sy = std::min(by * 4 + y, mip.height - 1);
+						for (int x = 0; x < BlockCompression::BLOCK_SIZE; x++) {
+							const auto sx = std::min(bx * 4 + x, mip.width - 1);
+							std::memcpy(pixels + (y * 4 + x) * 4, mip.data.data() + (static_cast<size_t>(sy) * mip.width + sx) * 4, 4);
+						}
+					}
+
+					switch (target) {
+					case TextureCompression::BC1: BlockCompression::encodeBC1(pixels, block); break;
+					case TextureCompression::BC3: BlockCompression::encodeBC3(pixels, block); break;
+					case TextureCompression::BC5: BlockCompression::encodeBC5(pixels, block); break;
+					case TextureCompression::BC7: BlockCompression::encodeBC7(pixels, block); break;
+					case TextureCompression::NONE: break;
+					}
+				}
+			}
+
+			mip.data = std::move(blocks);
+		}
+
+		compression = target;
+	}
+
+	size_t TextureImage::getBytes() const {
+		size_t bytes = 0;
+		for (const auto& mip : mips) {
+			bytes += mip.data.size();
+		}
+		return bytes;
+	}
+
+	size_t TextureImage::getBlockBytes(TextureCompression compression) {
+		switch (compression) {
+		case TextureCompression::BC1: return 8;
+		case TextureCompression::BC3:
+		case TextureCompression::BC5:
+		case TextureCompression::BC7: return 16;
+		case TextureCompression::NONE: return 0;
+		}
+		return 0;
+	}
+
+	size_t TextureImage::getMipBytes(int width, int height, TextureCompression compression) {
+		if (compression == TextureCompression::NONE) {
+			return static_cast<size_t>(width) * height * 4;
+		}
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(compression);
+	}
+
+	void TextureImage::write(SFE::PropertiesModule::BinaryWriter& writer) const {
+		writer.write(compression);
+		writer.write(static_cast<int32_t>(width));
+		writer.write(static_cast<int32_t>(height));
+		writer.write(static_cast<uint32_t>(mips.size()));
+		for (const auto& mip : mips) {
+			writer.write(static_cast<int32_t>(mip.width));
+			writer.write(static_cast<int32_t>(mip.height));
+			writer.writeArray(std::span<const uint8_t>(mip.data));
+		}
+	}
+
+	bool TextureImage::read(SFE::PropertiesModule::BinaryReader& reader) {
+		clear();
+
+		int32_t w = 0;
+		int32_t h = 0;
+		uint32_t mipsCount = 0;
+		reader.read(compression);
+		reader.read(w);
+		reader.read(h);
+		reader.read(mipsCount);
+		//chain of 32 levels covers any size gl allows
+		if (!reader.isValid() || compression > TextureCompression::BC7 || w <= 0 || h <= 0 || mipsCount == 0 || mipsCount > 32) {
+			clear();
+			return false;
+		}
+
+		mips.resize(mipsCount);
+		for (auto& mip : mips) {
+			int32_t mipWidth = 0;
+			int32_t mipHeight = 0;
+			reader.read(mipWidth);
+			reader.read(mipHeight);
+			reader.readArray(mip.data);
+			if (!reader.isValid() || mipWidth <= 0 || mipHeight <= 0 || mip.data.size() != getMipBytes(mipWidth, mipHeight, compression)) {
+				clear();
+				return false;
+			}
+			mip.width = mipWidth;
+			mip.height = mipHeight;
+		}
+
+		width = w;
+		height = h;
+		return true;
+	}
+
+	void TextureImage::clear() {
+		width = 0;
+		height = 0;
+		compression = TextureCompression::NONE;
+		mips.clear();
+	}
+}
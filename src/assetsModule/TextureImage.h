@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace SFE::PropertiesModule {
+	class BinaryReader;
+	class BinaryWriter;
+}
+
+namespace AssetsModule {
+	enum class TextureCompression : uint32_t {
+		NONE,
+		BC1, //rgb, alpha is dropped
+		BC3, //rgba
+		BC5, //red and green only, for two channel data
+		BC7, //rgba
+	};
+
+	enum class MipFilter : uint32_t {
+		NONE, //only the first level
+		BOX,
+		KAISER, //sharper, windowed sinc
+	};
+
+	//decoded texture with its mip chain, it is cooked on any thread, tests/TextureImageTests.cpp covers mips, compression and cache format
+	//pixels are rgba8 until compression, compressed mips are rows of 4x4 blocks
+	struct TextureImage {
+		struct Mip {
+			int width = 0;
+			int height = 0;
+			std::vector<uint8_t> data;
+		};
+
+		int width = 0;
+		int height = 0;
+		TextureCompression compression = TextureCompression::NONE;
+		std::vector<Mip> mips;
+
+		//file bytes of any format stb_image reads, rows are flipped here, so global stb flag isn't touched from loading threads
+		bool decode(std::span<const uint8_t> data, bool flip);
+		//builds chain down to 1x1 from the first level, image should not be compressed yet
+		void generateMips(MipFilter filter);
+		void compress(TextureCompression target);
+
+		size_t getBytes() const;
+
+		static size_t getBlockBytes(TextureCompression compression);
+		static size_t getMipBytes(int width, int height, TextureCompression compression);
+
+		void write(SFE::PropertiesModule::BinaryWriter& writer) const;
+		//returns false if data is broken, image stays empty then
+		bool read(SFE::PropertiesModule::BinaryReader& reader);
+
+		void clear();
+	};
+}
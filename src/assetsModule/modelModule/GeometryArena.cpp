@@ -0,0 +1,293 @@
+﻿#include "GeometryArena.h"
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+
+#include "core/Engine.h"
+#include "debugModule/Benchmark.h"
+
+namespace SFE {
+	GeometryArena::Handle GeometryArena::allocate(const Mesh<Vertex3D>& mesh) {
+		if (mesh.vertices.empty()) {
+			return {};
+		}
+
+		PendingUpload upload;
+		upload.vertices = mesh.vertices;
+		upload.indices = mesh.indices;
+		if (upload.indices.empty()) {
+			upload.indices.resize(upload.vertices.size());
+			std::iota(upload.indices.begin(), upload.indices.end(), 0u);
+		}
+
+		const auto verticesCount = static_cast<uint32_t>(upload.vertices.size());
+		const auto indicesCount = static_cast<uint32_t>(upload.indices.size());
+
+		std::unique_lock lock(mMutex);
+
+		uint32_t pageIdx = 0;
+		uint32_t vertexOffset = OffsetAllocator::INVALID_OFFSET;
+		uint32_t indexOffset = OffsetAllocator::INVALID_OFFSET;
+		for (; pageIdx < mPages.size(); pageIdx++) {
+			auto& page = *mPages[pageIdx];
+			vertexOffset = page.vertices.allocate(verticesCount);
+			if (vertexOffset == OffsetAllocator::INVALID_OFFSET) {
+				continue;
+			}
+
+			indexOffset = page.indices.allocate(indicesCount);
+			if (indexOffset != OffsetAllocator::INVALID_OFFSET) {
+				break;
+			}
+
+			page.vertices.free(vertexOffset);
+			vertexOffset = OffsetAllocator::INVALID_OFFSET;
+		}
+
+		if (pageIdx == mPages.size()) {
+			//mesh bigger than page gets its own one
+			auto& page = *mPages.emplace_back(std::make_unique<Page>());
+			page.vertices.reset(std::max(PAGE_VERTICES, verticesCount));
+			page.indices.reset(std::max(PAGE_INDICES, indicesCount));
+
+			vertexOffset = page.vertices.allocate(verticesCount);
+			indexOffset = page.indices.allocate(indicesCount);
+		}
+
+		const auto id = allocateRecord();
+		auto& record = mRecords[id];
+		record.page = pageIdx;
+		record.vertexOffset = vertexOffset;
+		record.verticesCount = verticesCount;
+		record.indexOffset = indexOffset;
+		record.indicesCount = indicesCount;
+		record.alive = true;
+		record.uploaded = false;
+
+		upload.handle = { id, record.generation };
+		mPendingUploads.emplace_back(std::move(upload));
+
+		return { id, record.generation };
+	}
+
+	void GeometryArena::release(Handle handle) {
+		std::unique_lock lock(mMutex);
+		if (!isValid(handle)) {
+			return;
+		}
+
+		//gl keeps old data for commands which are already sent, new data uploaded to this range is ordered after them
+		auto& record = mRecords[handle.id];
+		auto& page = *mPages[record.page];
+		page.vertices.free(record.vertexOffset);
+		page.indices.free(record.indexOffset);
+
+		record.alive = false;
+		record.uploaded = false;
+		record.generation++;
+		mFreeRecords.push_back(handle.id);
+	}
+
+	GeometryArena::Range GeometryArena::getRange(Handle handle) const {
+		std::shared_lock lock(mMutex);
+		if (!isValid(handle)) {
+			return {};
+		}
+
+		const auto& record = mRecords[handle.id];
+		if (!record.uploaded) {
+			return {};
+		}
+
+		return { mPages[record.page]->vao.getID(), static_cast<int32_t>(record.vertexOffset), record.indexOffset, record.verticesCount, record.indicesCount };
+	}
+
+	void GeometryArena::update() {
+		FUNCTION_BENCHMARK;
+		assert(Engine::isRenderThread());
+
+		std::unique_lock lock(mMutex);
+
+		for (auto& page : mPages) {
+			if (!page->vao.getID()) {
+				createPageObjects(*page);
+			}
+		}
+
+		if (!mPendingUploads.empty()) {
+			FUNCTION_BENCHMARK_NAMED(upload);
+			for (auto& upload : mPendingUploads) {
+				//released before upload
+				if (!isValid(upload.handle)) {
+					continue;
+				}
+
+				auto& record = mRecords[upload.handle.id];
+				auto& page = *mPages[record.page];
+
+				page.vbo->bind();
+				page.vbo->setData(upload.vertices.size(), upload.vertices.data(), record.vertexOffset);
+				page.ebo->bind();
+				page.ebo->setData(upload.indices.size(), upload.indices.data(), record.indexOffset);
+
+				record.uploaded = true;
+			}
+			mPendingUploads.clear();
+
+			VertexBuffer::bindDefaultBuffer();
+			IndexBuffer::bindDefaultBuffer();
+		}
+
+		for (size_t i = 0; i < mPages.size(); i++) {
+			const auto& page = *mPages[i];
+			const auto fragmented = [](const OffsetAllocator& allocator) {
+				return allocator.getFree() > allocator.getCapacity() / 4 && allocator.getFragmentation() > defragmentationThreshold;
+			};
+
+			if (fragmented(page.vertices) || fragmented(page.indices)) {
+				lock.unlock();
+				defragment(i);
+				break;
+			}
+		}
+	}
+
+	void GeometryArena::defragment(size_t pageIdx) {
+		FUNCTION_BENCHMARK;
+		assert(Engine::isRenderThread());
+
+		std::unique_lock lock(mMutex);
+		if (pageIdx >= mPages.size()) {
+			return;
+		}
+
+		auto& page = *mPages[pageIdx];
+		if (!page.vao.getID()) {
+			createPageObjects(page);
+		}
+
+		std::unordered_map<uint32_t, uint32_t> vertexMoves;
+		for (const auto& move : page.vertices.defragment()) {
+			vertexMoves[move.from] = move.to;
+		}
+
+		std::unordered_map<uint32_t, uint32_t> indexMoves;
+		for (const auto& move : page.indices.defragment()) {
+			indexMoves[move.from] = move.to;
+		}
+
+		//data is copied into new buffers, so source and destination ranges never overlap
+		auto vbo = std::make_unique<VertexBuffer>();
+		vbo->generate();
+		vbo->bind();
+		vbo->allocateData(page.vertices.getCapacity());
+
+		auto ebo = std::make_unique<IndexBuffer>();
+		ebo->generate();
+		ebo->bind();
+		ebo->allocateData(page.indices.getCapacity());
+
+		for (auto& record : mRecords) {
+			if (!record.alive || record.page != pageIdx) {
+				continue;
+			}
+
+			const auto vertexIt = vertexMoves.find(record.vertexOffset);
+			const auto vertexOffset = vertexIt != vertexMoves.end() ? vertexIt->second : record.vertexOffset;
+			const auto indexIt = indexMoves.find(record.indexOffset);
+			const auto indexOffset = indexIt != indexMoves.end() ? indexIt->second : record.indexOffset;
+
+			//not uploaded meshes will be uploaded to the new place
+			if (record.uploaded) {
+				GLW::bindBuffer<GLW::COPY_READ_BUFFER>(page.vbo->getID());
+				GLW::bindBuffer<GLW::COPY_WRITE_BUFFER>(vbo->getID());
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, record.vertexOffset * sizeof(Vertex3D), vertexOffset * sizeof(Vertex3D), record.verticesCount * sizeof(Vertex3D));
+
+				GLW::bindBuffer<GLW::COPY_READ_BUFFER>(page.ebo->getID());
+				GLW::bindBuffer<GLW::COPY_WRITE_BUFFER>(ebo->getID());
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, record.indexOffset * sizeof(uint32_t), indexOffset * sizeof(uint32_t), record.indicesCount * sizeof(uint32_t));
+			}
+
+			record.vertexOffset = vertexOffset;
+			record.indexOffset = indexOffset;
+		}
+
+		GLW::bindDefaultBuffer<GLW::COPY_READ_BUFFER>();
+		GLW::bindDefaultBuffer<GLW::COPY_WRITE_BUFFER>();
+
+		page.vbo = std::move(vbo);
+		page.ebo = std::move(ebo);
+		bindPageBuffers(page);
+	}
+
+	GeometryArena::Stats GeometryArena::getStats() const {
+		std::shared_lock lock(mMutex);
+
+		Stats stats;
+		stats.pages = mPages.size();
+		stats.meshes = mRecords.size() - mFreeRecords.size();
+		stats.pendingUploads = mPendingUploads.size();
+		for (const auto& page : mPages) {
+			stats.usedVertices += page->vertices.getUsed();
+			stats.capacityVertices += page->vertices.getCapacity();
+			stats.usedIndices += page->indices.getUsed();
+			stats.capacityIndices += page->indices.getCapacity();
+			stats.fragmentation = std::max({ stats.fragmentation, page->vertices.getFragmentation(), page->indices.getFragmentation() });
+		}
+
+		return stats;
+	}
+
+	bool GeometryArena::isValid(Handle handle) const {
+		return handle.id < mRecords.size() && mRecords[handle.id].alive && mRecords[handle.id].generation == handle.generation;
+	}
+
+	uint32_t GeometryArena::allocateRecord() {
+		if (!mFreeRecords.empty()) {
+			const auto id = mFreeRecords.back();
+			mFreeRecords.pop_back();
+			return id;
+		}
+
+		mRecords.emplace_back();
+		return static_cast<uint32_t>(mRecords.size() - 1);
+	}
+
+	void GeometryArena::createPageObjects(Page& page) {
+		page.vao.generate();
+
+		page.vbo = std::make_unique<VertexBuffer>();
+		page.vbo->generate();
+		page.vbo->bind();
+		page.vbo->allocateData(page.vertices.getCapacity());
+
+		page.ebo = std::make_unique<IndexBuffer>();
+		page.ebo->generate();
+		page.ebo->bind();
+		page.ebo->allocateData(page.indices.getCapacity());
+
+		bindPageBuffers(page);
+	}
+
+	void GeometryArena::bindPageBuffers(Page& page) {
+		page.vao.bind();
+		page.vbo->bind();
+		page.ebo->bind();
+
+		page.vao.addAttribute(0, &Vertex3D::position, true);
+		page.vao.addAttribute(1, &Vertex3D::normal, true);
+		page.vao.addAttribute(2, &Vertex3D::texCoords, true);
+		page.vao.addAttribute(3, &Vertex3D::tangent, true);
+		page.vao.addAttribute(4, &Vertex3D::biTangent, true);
+
+		page.vao.addAttribute(5, &Vertex3D::boneIDs); //todo only for dynamic mesh
+		page.vao.addAttribute(6, &Vertex3D::weights, false);
+
+		//entity index attribute 7 is bound by Batcher to its own instance buffer
+
+		GLW::VertexArray::bindDefault();
+		VertexBuffer::bindDefaultBuffer();
+	}
+}
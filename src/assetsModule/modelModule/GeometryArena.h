@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+#include "Mesh.h"
+#include "containersModule/OffsetAllocator.h"
+#include "containersModule/Singleton.h"
+#include "glWrapper/Buffer.h"
+#include "glWrapper/VertexArray.h"
+
+namespace SFE {
+	//all Vertex3D meshes live in a few big pages with one vao, vertex and index buffer per page
+	//meshes are sub-allocated from pages and drawn with baseVertex and firstIndex, so draws of different meshes can be merged into one multi draw
+	class GeometryArena : public Singleton<GeometryArena> {
+	public:
+		constexpr static uint32_t PAGE_VERTICES = 1 << 18;
+		constexpr static uint32_t PAGE_INDICES = 1 << 20;
+
+		//page is compacted in update when its free space is split more than this
+		inline static float defragmentationThreshold = 0.5f;
+
+		//stays the same when mesh is moved by defragmentation, generation protects from reused ids of released meshes
+		struct Handle {
+			uint32_t id = std::numeric_limits<uint32_t>::max();
+			uint32_t generation = 0;
+
+			bool isValid() const { return id != std::numeric_limits<uint32_t>::max(); }
+		};
+
+		//vao is 0 while mesh is not uploaded yet or handle is released
+		struct Range {
+			unsigned vao = 0;
+			int32_t baseVertex = 0;
+			uint32_t firstIndex = 0;
+			uint32_t verticesCount = 0;
+			uint32_t indicesCount = 0;
+		};
+
+		struct Stats {
+			size_t pages = 0;
+			size_t meshes = 0;
+			size_t pendingUploads = 0;
+			size_t usedVertices = 0;
+			size_t capacityVertices = 0;
+			size_t usedIndices = 0;
+			size_t capacityIndices = 0;
+			float fragmentation = 0.f; //the worst page
+		};
+
+		//can be called from any thread, data is copied and uploaded to gpu in update on render thread
+		//mesh without indices gets trivial ones, so every mesh can be drawn by indexed commands
+		Handle allocate(const Mesh<Vertex3D>& mesh);
+		void release(Handle handle);
+
+		Range getRange(Handle handle) const;
+
+		//render thread only, creates gl objects of new pages, uploads pending meshes and compacts one fragmented page
+		void update();
+		//render thread only
+		void defragment(size_t pageIdx);
+
+		Stats getStats() const;
+
+	private:
+		using VertexBuffer = GLW::Buffer<GLW::ARRAY_BUFFER, Vertex3D>;
+		using IndexBuffer = GLW::Buffer<GLW::ELEMENT_ARRAY_BUFFER, uint32_t>;
+
+		struct Page {
+			OffsetAllocator vertices;
+			OffsetAllocator indices;
+
+			GLW::VertexArray vao;
+			std::unique_ptr<VertexBuffer> vbo;
+			std::unique_ptr<IndexBuffer> ebo;
+		};
+
+		struct Record {
+			uint32_t page = 0;
+			uint32_t vertexOffset = OffsetAllocator::INVALID_OFFSET;
+			uint32_t verticesCount = 0;
+			uint32_t indexOffset = OffsetAllocator::INVALID_OFFSET;
+			uint32_t indicesCount = 0;
+			uint32_t generation = 0;
+			bool alive = false;
+			bool uploaded = false;
+		};
+
+		struct PendingUpload {
+			Handle handle;
+			std::vector<Vertex3D> vertices;
+			std::vector<uint32_t> indices;
+		};
+
+		bool isValid(Handle handle) const;
+		uint32_t allocateRecord();
+		void createPageObjects(Page& page);
+		void bindPageBuffers(Page& page);
+
+		std::vector<std::unique_ptr<Page>> mPages;
+		std::vector<Record> mRecords;
+		std::vector<uint32_t> mFreeRecords;
+		std::vector<PendingUpload> mPendingUploads;
+
+		mutable std::shared_mutex mMutex;
+	};
+}
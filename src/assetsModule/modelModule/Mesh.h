@@ -25,6 +25,7 @@ namespace SFE {
 		Material material;
 		Math::Mat4 transform;
 		FrustumModule::AABB aabb;
+		float uvDensity = 0.f; //uv units per world unit of transformed mesh, 0 when mesh has no area
 	};
 
 	using MeshObject3D = MeshObject<Vertex3D>;
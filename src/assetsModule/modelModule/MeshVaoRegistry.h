@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <mutex>
 #include <unordered_map>
 
 #include "Mesh.h"
@@ -6,6 +7,7 @@
 #include "containersModule/Singleton.h"
 
 namespace SFE {
+	//maps meshes to their GeometryArena handles, can be used from any thread
 	class MeshVaoRegistry : public Singleton<MeshVaoRegistry> {
 	public:
 		const RenderMeshData& get(Mesh<Vertex3D>* mesh);
@@ -15,5 +17,6 @@ namespace SFE {
 
 	private:
 		std::unordered_map<Mesh<Vertex3D>*, RenderMeshData> mMeshVAO;
+		std::recursive_mutex mMutex;
 	};
-}
+}
\ No newline at end of file
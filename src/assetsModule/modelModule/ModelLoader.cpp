@@ -1,5 +1,7 @@
 ﻿#include "ModelLoader.h"
 
+#include <cmath>
+
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
@@ -44,7 +46,7 @@ AssetsModule::Model* ModelLoader::load(const std::string& path) {
 	Assimp::Importer import;//todo create own format with aabb, materials, etc
 	const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-		SFE::LogsModule::Logger::LOG_ERROR("ASSIMP:: %s", import.GetErrorString());
+		SFE_LOG_ERROR("ASSIMP:: %s", import.GetErrorString());
 		return nullptr;
 	}
 	
@@ -74,6 +76,7 @@ AssetsModule::Model* ModelLoader::load(const std::string& path) {
 
 		//mesh.aabb = SFE::FrustumModule::AABB(minAABB / 100.f, maxAABB / 100.f);
 		mesh.aabb = SFE::FrustumModule::AABB(minAABB, maxAABB);
+		mesh.uvDensity = computeUvDensity(mesh.mesh, mesh.transform);
 	}
 	mtx.lock();
 	asset = AssetsManager::instance()->createAsset<Model>(path, std::move(meshes), std::move(armatur), std::move(animations));
@@ -94,6 +97,7 @@ std::tuple<SFE::Tree<SFE::MeshObject3D>, Armature> ModelLoader::loadModel(const
 	SFE::Tree<SFE::MeshObject3D> meshes;
 	Armature armat;
 
+	loadSceneTextures(scene, directory);
 	processNode(scene->mRootNode, scene, directory, meshes, armat);
 
 	return { meshes, armat };
@@ -281,6 +285,29 @@ int ModelLoader::extractLodLevel(const std::string& meshName) {
 	return std::atoi(meshName.substr(i + 4, meshName.size() - i).c_str());
 }
 
+float ModelLoader::computeUvDensity(const SFE::Mesh3D& mesh, const SFE::Math::Mat4& transform) {
+	std::vector<SFE::Math::Vec3> positions(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		positions[i] = transform * SFE::Math::Vec4(mesh.vertices[i].position, 1.f);
+	}
+
+	//both areas are doubled, so it doesn't matter for ratio
+	double area = 0.0;
+	double uvArea = 0.0;
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+		const auto a = mesh.indices[i];
+		const auto b = mesh.indices[i + 1];
+		const auto c = mesh.indices[i + 2];
+		area += SFE::Math::length(SFE::Math::cross(positions[b] - positions[a], positions[c] - positions[a]));
+
+		const auto uvB = mesh.vertices[b].texCoords - mesh.vertices[a].texCoords;
+		const auto uvC = mesh.vertices[c].texCoords - mesh.vertices[a].texCoords;
+		uvArea += std::abs(uvB.x * uvC.y - uvB.y * uvC.x);
+	}
+
+	return area > 0.0 ? static_cast<float>(std::sqrt(uvArea / area)) : 0.f;
+}
+
 void ModelLoader::processMesh(aiMesh* assimpMesh, const aiScene* scene, const std::string& directory, SFE::MeshObject3D& meshObject, Armature& armature) {
 	//meshObject.mesh.lod = extractLodLevel(meshNode->mName.data); //todo lods support, probably not throug model, but load it as separate meshes instead
 
@@ -293,13 +320,43 @@ void ModelLoader::processMesh(aiMesh* assimpMesh, const aiScene* scene, const st
 std::vector<Texture*> ModelLoader::loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& directory) {
 	std::vector<Texture*> textures;
 	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
-		aiString str;
-		mat->GetTexture(type, i, &str);
+		textures.emplace_back(TextureHandler::loadTexture(getTexturePath(mat, type, i, directory), getTextureUsage(type)));
+	}
+	return textures;
+}
+
+std::string ModelLoader::getTexturePath(aiMaterial* mat, aiTextureType type, unsigned index, const std::string& directory) {
+	aiString str;
+	mat->GetTexture(type, index, &str);
 
-		std::string path = std::string(str.C_Str());
-		path.erase(0, std::string(str.C_Str()).find_last_of("\\") + 1);
+	std::string path = std::string(str.C_Str());
+	path.erase(0, path.find_last_of("\\") + 1);
 
-		textures.emplace_back(TextureHandler::loadTexture(directory + "/" + path));
+	return directory + "/" + path;
+}
+
+void ModelLoader::loadSceneTextures(const aiScene* scene, const std::string& directory) {
+	//textures of all materials are cooked together, meshes find them loaded then
+	std::vector<std::string> colorPaths;
+	std::vector<std::string> normalPaths;
+	for (auto i = 0u; i < scene->mNumMaterials; i++) {
+		const auto material = scene->mMaterials[i];
+		for (const auto type : { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS }) {
+			auto& paths = getTextureUsage(type) == TextureUsage::NORMAL ? normalPaths : colorPaths;
+			for (auto j = 0u; j < material->GetTextureCount(type); j++) {
+				paths.push_back(getTexturePath(material, type, j, directory));
+			}
+		}
 	}
-	return textures;
+
+	if (!colorPaths.empty()) {
+		TextureHandler::loadTextures(colorPaths, TextureUsage::COLOR);
+	}
+	if (!normalPaths.empty()) {
+		TextureHandler::loadTextures(normalPaths, TextureUsage::NORMAL);
+	}
+}
+
+TextureUsage ModelLoader::getTextureUsage(aiTextureType type) {
+	return type == aiTextureType_NORMALS ? TextureUsage::NORMAL : TextureUsage::COLOR;
 }
@@ -28,6 +28,8 @@ namespace AssetsModule {
 		static std::tuple<SFE::Tree<SFE::MeshObject3D>, Armature> loadModel(const aiScene* scene, const std::string& path);
 
 		static int extractLodLevel(const std::string& meshName);
+		//square root of uv area over area of triangles, texture streaming takes texel density of mesh from it
+		static float computeUvDensity(const SFE::Mesh3D& mesh, const SFE::Math::Mat4& transform);
 
 		static void processNode(aiNode* node, const aiScene* scene, const std::string& directory, SFE::Tree<SFE::MeshObject3D>& meshes, Armature& armature);
 		static void processMesh(aiMesh* assimpMesh, const aiScene* scene, const std::string& directory, SFE::MeshObject3D& rawModel, Armature& armature);
@@ -38,5 +40,8 @@ namespace AssetsModule {
 		static void readVerticesData(std::vector<SFE::Vertex3D>& vector, unsigned numVertices, aiMesh* aiMesh);
 
 		static std::vector<Texture*> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& directory);
+		static std::string getTexturePath(aiMaterial* mat, aiTextureType type, unsigned index, const std::string& directory);
+		static void loadSceneTextures(const aiScene* scene, const std::string& directory);
+		static TextureUsage getTextureUsage(aiTextureType type);
 	};
 }
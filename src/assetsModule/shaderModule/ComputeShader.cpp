@@ -0,0 +1,17 @@
+﻿#include "ComputeShader.h"
+
+#include "glWrapper/Shader.h"
+#include "logsModule/logger.h"
+
+using namespace SFE::ShaderModule;
+
+std::vector<ShaderBase::Stage> ComputeShader::getStages() const {
+	return { { GLW::ShaderType::COMPUTE, computePath } };
+}
+
+std::string_view ComputeShader::getComputePath() {
+	return computePath;
+}
+
+ComputeShader::ComputeShader(const char* csPath, size_t hash) : ShaderBase(hash), computePath(csPath) {
+}
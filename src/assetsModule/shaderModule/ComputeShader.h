@@ -0,0 +1,22 @@
+﻿#pragma once
+#include "ShaderBase.h"
+
+namespace SFE::ShaderModule {
+	class ComputeShader : public ShaderBase {
+		friend class ShaderController;
+	public:
+		ComputeShader(const ComputeShader& other) = delete;
+		ComputeShader(ComputeShader&& other) noexcept = delete;
+		ComputeShader& operator=(const ComputeShader& other) = delete;
+		ComputeShader& operator=(ComputeShader&& other) noexcept = delete;
+
+		std::string_view getComputePath();
+	protected:
+		ComputeShader() = default;
+		ComputeShader(const char* csPath, size_t hash);
+
+		std::vector<Stage> getStages() const override;
+	private:
+		std::string computePath;
+	};
+}
@@ -5,20 +5,8 @@
 
 using namespace SFE::ShaderModule;
 
-bool GeometryShader::compile() {
-	id = GLW::createProgram();
-	
-	const char* errorStr;
-
-	auto success = true;
-	success |= GLW::compileShader(loadShaderCode(vertexPath.c_str()).c_str(), GLW::ShaderType::VERTEX, id, errorStr);
-	success |= GLW::compileShader(loadShaderCode(fragmentPath.c_str()).c_str(), GLW::ShaderType::FRAGMENT, id, errorStr);
-	success |= GLW::compileShader(loadShaderCode(geometryPath.c_str()).c_str(), GLW::ShaderType::GEOMETRY, id, errorStr);
-
-	if (!success){
-		LogsModule::Logger::LOG_ERROR("[%s, %s, %s] error downloading\n%s", vertexPath.c_str(), fragmentPath.c_str(), geometryPath.c_str(), errorStr);
-	}
-	return success;
+std::vector<ShaderBase::Stage> GeometryShader::getStages() const {
+	return { { GLW::ShaderType::VERTEX, vertexPath }, { GLW::ShaderType::FRAGMENT, fragmentPath }, { GLW::ShaderType::GEOMETRY, geometryPath } };
 }
 
 std::string_view GeometryShader::getVertexPath() {
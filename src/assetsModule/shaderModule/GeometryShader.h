@@ -9,14 +9,15 @@ namespace SFE::ShaderModule {
 		GeometryShader(GeometryShader&& other) noexcept = delete;
 		GeometryShader& operator=(const GeometryShader& other) = delete;
 		GeometryShader& operator=(GeometryShader&& other) noexcept = delete;
-		bool compile() override;
-		
+
 		std::string_view getVertexPath();
 		std::string_view getFragmentPath();
 		std::string_view getGeometryPath();
 	protected:
 		GeometryShader() = default;
 		GeometryShader(const char* vsPath, const char* fsPath, const char* gsPath, size_t hash);
+
+		std::vector<Stage> getStages() const override;
 	private:
 		std::string vertexPath;
 		std::string fragmentPath;
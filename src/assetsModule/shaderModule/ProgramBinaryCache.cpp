@@ -0,0 +1,89 @@
+﻿#include "ProgramBinaryCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "core/FileSystem.h"
+#include "core/Hash.h"
+#include "logsModule/logger.h"
+#include "propertiesModule/BinaryArchive.h"
+
+namespace SFE::ShaderModule {
+	uint64_t ProgramBinaryCache::getHash(std::span<const Source> sources) {
+		auto hash = hashBytes(&VERSION, sizeof(VERSION), getDriverHash());
+		for (const auto& [type, code] : sources) {
+			hash = hashBytes(&type, sizeof(type), hash);
+			hash = hashString(code, hash);
+		}
+		return hash;
+	}
+
+	uint64_t ProgramBinaryCache::getDriverHash() {
+		static const auto hash = [] {
+			auto result = FNV_BASIS;
+			for (const auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+				const auto value = reinterpret_cast<const char*>(glGetString(name));
+				result = hashString(value ? value : "", result);
+			}
+			return result;
+		}();
+		return hash;
+	}
+
+	std::string ProgramBinaryCache::getCachePath(uint64_t hash) {
+		char name[17];
+		std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+		return std::string(CACHE_FOLDER) + name + ".bin";
+	}
+
+	bool ProgramBinaryCache::load(unsigned programId, uint64_t hash) {
+		std::vector<uint8_t> data;
+		if (!FileSystem::readBinaryFile(getCachePath(hash), data)) {
+			return false;
+		}
+
+		PropertiesModule::BinaryReader reader(data);
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint64_t cachedHash = 0;
+		uint32_t format = 0;
+		std::vector<uint8_t> binary;
+		reader.read(magic);
+		reader.read(version);
+		reader.read(cachedHash);
+		reader.read(format);
+		reader.readArray(binary);
+		//broken or foreign file is compiled again and overwritten
+		if (!reader.isValid() || magic != MAGIC || version != VERSION || cachedHash != hash || binary.empty()) {
+			return false;
+		}
+
+		return GLW::programBinary(programId, format, binary);
+	}
+
+	void ProgramBinaryCache::save(unsigned programId, uint64_t hash) {
+		uint32_t format = 0;
+		std::vector<uint8_t> binary;
+		if (!GLW::getProgramBinary(programId, format, binary)) {
+			return;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(CACHE_FOLDER, error);
+
+		std::vector<uint8_t> data;
+		data.reserve(binary.size() + 32);
+		PropertiesModule::BinaryWriter writer(data);
+		writer.write(MAGIC);
+		writer.write(VERSION);
+		writer.write(hash);
+		writer.write(format);
+		writer.writeArray<uint8_t>(binary);
+
+		const auto path = getCachePath(hash);
+		if (!FileSystem::writeBinaryFile(path, data.data(), data.size())) {
+			SFE_LOG_ERROR("ProgramBinaryCache::can't write cache %s", path.c_str());
+		}
+	}
+}
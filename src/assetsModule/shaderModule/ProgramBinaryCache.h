@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "glWrapper/Shader.h"
+
+namespace SFE::ShaderModule {
+	//linked programs are kept in cache folder under hash of their sources and driver, so the next start links them from binary,
+	//changed source or updated driver gives new hash and program is compiled again
+	class ProgramBinaryCache {
+	public:
+		constexpr static uint32_t MAGIC = 0x50534653; //SFSP
+		constexpr static uint32_t VERSION = 1;
+		constexpr static std::string_view CACHE_FOLDER = "cache/shaders/";
+
+		inline static bool enabled = true;
+
+		using Source = std::pair<GLW::ShaderType, std::string>;
+
+		//needs current gl context, driver is a part of hash
+		static uint64_t getHash(std::span<const Source> sources);
+		//vendor, renderer and version of context, it is read once
+		static uint64_t getDriverHash();
+		static std::string getCachePath(uint64_t hash);
+
+		//returns false if there is no binary or driver rejects it, program should be compiled from sources then
+		static bool load(unsigned programId, uint64_t hash);
+		//program should be linked with retrievable hint
+		static void save(unsigned programId, uint64_t hash);
+	};
+}
@@ -16,12 +16,13 @@ namespace SFE::ShaderModule {
 		Shader& operator=(const Shader& other) = delete;
 		Shader& operator=(Shader&& other) noexcept = delete;
 
-		bool compile() override;
 		std::string_view getVertexPath();
 		std::string_view getFragmentPath();
 	protected:
 		Shader() = default;
 		Shader(const char* vertexPath, const char* fragmentPath, size_t hash);
+
+		std::vector<Stage> getStages() const override;
 	private:
 		std::string vertexPath;
 		std::string fragmentPath;
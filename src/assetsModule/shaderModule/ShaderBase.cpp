@@ -1,5 +1,6 @@
 #include "ShaderBase.h"
 
+#include "ProgramBinaryCache.h"
 #include "ShaderController.h"
 #include "core/FileSystem.h"
 #include "glWrapper/Shader.h"
@@ -16,6 +17,69 @@ std::string ShaderBase::loadShaderCode(std::string_view path) {
 	return shaderCode;
 }
 
+bool ShaderBase::compile() {
+	startCompile();
+	return finishCompile();
+}
+
+std::string ShaderBase::getName() const {
+	std::string name;
+	for (const auto& stage : getStages()) {
+		name += name.empty() ? "" : ", ";
+		name += stage.path;
+	}
+	return name;
+}
+
+void ShaderBase::startCompile() {
+	id = GLW::createProgram();
+	mCompilingStages.clear();
+
+	const auto stages = getStages();
+	std::vector<ProgramBinaryCache::Source> sources;
+	sources.reserve(stages.size());
+	for (const auto& stage : stages) {
+		sources.emplace_back(stage.type, loadShaderCode(stage.path));
+	}
+
+	mSourceHash = ProgramBinaryCache::getHash(sources);
+	if (ProgramBinaryCache::enabled && ProgramBinaryCache::load(id, mSourceHash)) {
+		return;
+	}
+
+	GLW::setProgramBinaryRetrievable(id);
+	for (const auto& [type, code] : sources) {
+		mCompilingStages.push_back(GLW::attachShader(id, code.c_str(), type));
+	}
+	GLW::linkProgram(id);
+}
+
+bool ShaderBase::finishCompile() {
+	//program from cache is linked already
+	if (!isCompiling()) {
+		return true;
+	}
+
+	std::string error;
+	const auto success = GLW::getLinkStatus(id, error);
+	if (!success) {
+		for (const auto shader : mCompilingStages) {
+			error += GLW::getShaderLog(shader);
+		}
+		SFE_LOG_ERROR("[%s] error downloading\n%s", getName().c_str(), error.c_str());
+	}
+
+	for (const auto shader : mCompilingStages) {
+		GLW::releaseShader(id, shader);
+	}
+	mCompilingStages.clear();
+
+	if (success && ProgramBinaryCache::enabled) {
+		ProgramBinaryCache::save(id, mSourceHash);
+	}
+	return success;
+}
+
 unsigned ShaderBase::getID() const {
 	return id;
 }
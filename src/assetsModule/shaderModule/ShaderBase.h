@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <string>
+#include <vector>
 
 #include "glWrapper/Shader.h"
 #include "glWrapper/Texture.h"
@@ -36,25 +37,40 @@ namespace SFE::ShaderModule {
 
 		static std::string loadShaderCode(std::string_view path);
 
-		virtual bool compile() = 0;
+		//program is linked from binary cache or compiled from sources, hot reload calls it again for the same object
+		bool compile();
 		void use() const;
 		unsigned int getID() const;
 
 		template <typename T>
 		void setUniform(std::string_view, const T&) const { static_assert(sizeof(T) == 0, "setUniform is not implemented for this type."); }
 
-		std::string vertexCode;
-		std::string fragmentCode;
-
 		inline size_t getHash() const { return mHash; }
+		//paths of stages for logs
+		std::string getName() const;
 	protected:
+		struct Stage {
+			GLW::ShaderType type = GLW::ShaderType::NONE;
+			std::string_view path;
+		};
+
 		virtual ~ShaderBase();
 		ShaderBase() = default;
 		ShaderBase(size_t hash) : mHash(hash) {};
 
+		virtual std::vector<Stage> getStages() const = 0;
+
 		unsigned int id = 0;
 	private:
+		//commands are sent to driver without waiting for result, so programs started one by one are compiled together
+		void startCompile();
+		//waits for link, logs errors and keeps binary in cache
+		bool finishCompile();
+		bool isCompiling() const { return !mCompilingStages.empty(); }
+
 		size_t mHash = 0;
+		uint64_t mSourceHash = 0;
+		std::vector<unsigned> mCompilingStages;
 	};
 
 	template <>
@@ -1,10 +1,14 @@
 ﻿#include "ShaderController.h"
 
+#include <algorithm>
 #include <ranges>
 
+#include "ComputeShader.h"
 #include "GeometryShader.h"
 #include "Shader.h"
+#include "core/FramePacing.h"
 #include "glWrapper/Shader.h"
+#include "logsModule/logger.h"
 
 using namespace SFE;
 using namespace SFE::ShaderModule;
@@ -28,9 +32,7 @@ ShaderBase* ShaderController::loadVertexFragmentShader(const std::string& vertex
 	if (it != shaders.end()) {
 		return it->second;
 	}
-	auto shader = new Shader(vertexPath.c_str(), fragmentPath.c_str(), hash);
-	shader->compile();
-	return shaders.emplace(hash, shader).first->second;
+	return addShader(hash, new Shader(vertexPath.c_str(), fragmentPath.c_str(), hash));
 }
 
 ShaderBase* ShaderController::loadGeometryShader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath) {
@@ -39,14 +41,63 @@ ShaderBase* ShaderController::loadGeometryShader(const std::string& vertexPath,
 	if (it != shaders.end()) {
 		return it->second;
 	}
-	auto shader = new GeometryShader(vertexPath.c_str(), fragmentPath.c_str(), geometryPath.c_str(), hash);
-	shader->compile();
+	return addShader(hash, new GeometryShader(vertexPath.c_str(), fragmentPath.c_str(), geometryPath.c_str(), hash));
+}
+
+ShaderBase* ShaderController::loadComputeShader(const std::string& computePath) {
+	size_t hash = hasher(computePath);
+	const auto it = shaders.find(hash);
+	if (it != shaders.end()) {
+		return it->second;
+	}
+	return addShader(hash, new ComputeShader(computePath.c_str(), hash));
+}
+
+ShaderBase* ShaderController::addShader(size_t hash, ShaderBase* shader) {
+	shader->startCompile();
+	if (batchDepth > 0) {
+		compiling.push_back(shader);
+	}
+	else {
+		shader->finishCompile();
+	}
+
+	programs[shader->getID()] = shader;
 	return shaders.emplace(hash, shader).first->second;
 }
 
+void ShaderController::finishCompile(ShaderBase* shader) {
+	if (shader->isCompiling()) {
+		std::erase(compiling, shader);
+		shader->finishCompile();
+	}
+}
+
 void ShaderController::recompileShader(ShaderBase* shader) {
+	finishCompile(shader);
+	programs.erase(shader->getID());
 	deleteShaderGL(shader->getID());
 	shader->compile();
+	programs[shader->getID()] = shader;
+}
+
+void ShaderController::beginBatch() {
+	batchDepth++;
+}
+
+void ShaderController::endBatch() {
+	if (batchDepth == 0 || --batchDepth > 0) {
+		return;
+	}
+
+	const auto start = CoreModule::monotonicNs();
+	const auto count = compiling.size();
+	for (const auto shader : compiling) {
+		shader->finishCompile();
+	}
+	compiling.clear();
+
+	SFE_LOG_INFO("ShaderController::%zu programs are compiled, waited %.1f ms, parallel compile: %s", count, static_cast<double>(CoreModule::monotonicNs() - start) / 1'000'000.0, GLW::parallelShaderCompile ? "on" : "off");
 }
 
 void ShaderController::initDefaultShader() {
@@ -92,6 +143,8 @@ void ShaderController::removeShader(ShaderBase* shader) {
 		return;
 	}
 
+	finishCompile(shader);
+	programs.erase(shader->getID());
 	shaders.erase(shader->mHash);
 }
 
@@ -100,11 +153,6 @@ const std::unordered_map<size_t, ShaderBase*>& ShaderController::getShaders() {
 }
 
 ShaderBase* ShaderController::getShader(size_t shaderID) {
-	for (auto shader : shaders) {
-		if (shader.second->getID() == shaderID) {
-			return shader.second;
-		}
-	}
-
-	return nullptr;
+	const auto it = programs.find(static_cast<unsigned int>(shaderID));
+	return it != programs.end() ? it->second : nullptr;
 }
\ No newline at end of file
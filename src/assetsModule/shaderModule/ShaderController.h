@@ -1,11 +1,15 @@
 ﻿#pragma once
 
+#include <unordered_map>
+#include <vector>
+
 #include "Shader.h"
 #include "containersModule/Singleton.h"
 
 #define SHADER_CONTROLLER ::SFE::ShaderModule::ShaderController::instance()
 
 namespace SFE::ShaderModule {
+	//programs are loaded by paths once, passes keep returned pointers, recompile keeps the same object, so pointers survive hot reload
 	class ShaderController : public Singleton<ShaderController> {
 		friend Singleton;
 	public:
@@ -14,11 +18,18 @@ namespace SFE::ShaderModule {
 		void init() override;
 		ShaderBase* loadVertexFragmentShader(const std::string& vertexPath, const std::string& fragmentPath);
 		ShaderBase* loadGeometryShader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath);
+		ShaderBase* loadComputeShader(const std::string& computePath);
 		void recompileShader(ShaderBase* shader);
 
+		//programs loaded between them are compiled together, driver with parallel shader compile links them on its threads,
+		//returned programs can be used at once, use waits for link of that program only
+		void beginBatch();
+		void endBatch();
+
 		void initDefaultShader();
 		void useShader(unsigned int ID);
 		void useDefaultShader();
+		unsigned int getCurrentShader() const { return currentShader; }
 		void deleteShaderGL(unsigned int ID);
 		void deleteShader(ShaderBase* shader);
 		void deleteShader(size_t shaderHash);
@@ -29,7 +40,15 @@ namespace SFE::ShaderModule {
 		ShaderBase* getShader(size_t shaderID);
 
 	private:
+		ShaderBase* addShader(size_t hash, ShaderBase* shader);
+		//result of program which is compiled in batch is checked before it is changed or deleted
+		void finishCompile(ShaderBase* shader);
+
 		std::unordered_map<size_t, ShaderBase*> shaders;
+		//by gl id of program
+		std::unordered_map<unsigned int, ShaderBase*> programs;
+		std::vector<ShaderBase*> compiling;
+		int batchDepth = 0;
 		std::hash<std::string> hasher;
 
 		unsigned int currentShader = 0;
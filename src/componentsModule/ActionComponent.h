@@ -7,6 +7,7 @@ namespace SFE::ComponentsModule {
 		float progress = 0.f;
 		float time = 0.f;
 		bool loop = false;
+		uint8_t step = 0;
 
 		Math::Vec3 initialPos = {};
 	};
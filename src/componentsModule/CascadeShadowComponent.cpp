@@ -1,4 +1,7 @@
-#include "CascadeShadowComponent.h"
+﻿#include "CascadeShadowComponent.h"
+
+#include <algorithm>
+#include <cmath>
 
 #include "CameraComponent.h"
 #include "TransformComponent.h"
@@ -18,38 +21,20 @@ namespace SFE::ComponentsModule {
 	}
 
 	std::vector<Math::Vec4> CascadeShadowComponent::getFrustumCornersWorldSpace(const Math::Mat4& projView) {
-		const auto inv = Math::inverse(projView);
-
-		std::vector<Math::Vec4> frustumCorners;
-		for (unsigned int x = 0; x < 2; ++x) {
-			for (unsigned int y = 0; y < 2; ++y) {
-				for (unsigned int z = 0; z < 2; ++z) {
-					const Math::Vec4 pt = inv * Math::Vec4(
-						2.0f * static_cast<float>(x) - 1.0f,
-						2.0f * static_cast<float>(y) - 1.0f,
-						2.0f * static_cast<float>(z) - 1.0f,
-						1.0f
-					);
-
-					frustumCorners.push_back(pt / pt.w);
-				}
-			}
-		}
-
-		return frustumCorners;
+		return Render::CascadePlanner::getFrustumCornersWorldSpace(projView);
 	}
 
 	void CascadeShadowComponent::markDirty() {
 		mDirty = true;
 	}
 
-	void CascadeShadowComponent::calculateLightSpaceMatrices(const MathModule::PerspectiveProjection& projection, const Math::Mat4& view) {
+	void CascadeShadowComponent::calculateLightSpaceMatrices(const MathModule::PerspectiveProjection& projection, const Math::Mat4& view, const Math::Mat4& lightTransform) {
 		if (!mLightMatricesCache.empty()) {
 			return;
 		}
 
 		updateCascades(projection);
-		updateLightSpaceMatrices(view);
+		updateLightSpaceMatrices(view, lightTransform);
 	}
 
 	const std::vector<Math::Mat4>& CascadeShadowComponent::getLightSpaceMatrices() {
@@ -113,6 +98,51 @@ namespace SFE::ComponentsModule {
 		shadowIntensity = data["shadow_intensity"].asFloat();
 	}
 
+	void CascadeShadowComponent::serialize(PropertiesModule::BinaryWriter& data) {
+		data.writeArray(std::span<const float>(shadowCascadeLevels));
+		data.write(resolution);
+
+		data.write(static_cast<uint32_t>(cascades.size()));
+		for (const auto& cascade : cascades) {
+			data.write(cascade.bias);
+			data.write(cascade.samples);
+			data.write(cascade.texelSize);
+			data.write(cascade.zMult);
+		}
+
+		data.write(shadowIntensity);
+	}
+
+	void CascadeShadowComponent::deserialize(PropertiesModule::BinaryReader& data) {
+		std::vector<float> levels;
+		Math::Vec2 cascadesResolution;
+		uint32_t cascadesCount = 0;
+		if (!data.readArray(levels) || !data.read(cascadesResolution) || !data.read(cascadesCount)) {
+			return;
+		}
+		shadowCascadeLevels = std::move(levels);
+		resolution = cascadesResolution;
+
+		auto cam = ECSHandler::getSystem<SFE::SystemsModule::CameraSystem>()->getCurrentCamera();
+		auto& cameraProjection = ECSHandler::registry().getComponent<CameraComponent>(cam)->getProjection();
+
+		updateCascades(cameraProjection);
+		for (uint32_t i = 0; i < cascadesCount; i++) {
+			ShadowCascade cascadeData;
+			if (!data.read(cascadeData.bias) || !data.read(cascadeData.samples) || !data.read(cascadeData.texelSize) || !data.read(cascadeData.zMult)) {
+				return;
+			}
+			if (i < cascades.size()) {
+				cascades[i].bias = cascadeData.bias;
+				cascades[i].samples = cascadeData.samples;
+				cascades[i].texelSize = cascadeData.texelSize;
+				cascades[i].zMult = cascadeData.zMult;
+			}
+		}
+
+		data.read(shadowIntensity);
+	}
+
 	void CascadeShadowComponent::updateCascades(const MathModule::PerspectiveProjection& cameraProjection) {
 		if (mCameraProjection == cameraProjection && !mDirty) {
 			return;
@@ -140,45 +170,11 @@ namespace SFE::ComponentsModule {
 
 	}
 
-	void CascadeShadowComponent::updateLightSpaceMatrices(const Math::Mat4& cameraView) {
+	void CascadeShadowComponent::updateLightSpaceMatrices(const Math::Mat4& cameraView, const Math::Mat4& lightTransform) {
 		mLightSpaceMatrices.clear();
 
 		for (auto& shadowCascade : cascades) {
-			const auto corners = getFrustumCornersWorldSpace(shadowCascade.viewProjection.getProjectionsMatrix(), cameraView);
-
-			Math::Vec4 frustumCenter = corners[0];
-			for (size_t i = 1u; i < 8; i++) {
-				frustumCenter += corners[i];
-			}
-			frustumCenter /= 8.f;
-
-			auto tc = ECSHandler::registry().getComponent<TransformComponent>(getEntityId());
-
-			auto s = Math::normalize(tc->getRight());
-			auto u = Math::normalize(tc->getUp());
-			auto f = Math::normalize(tc->getForward());
-
-			auto eye = Math::Vec3(frustumCenter) - f;
-
-			Math::Mat4 lightView(1);
-			lightView[0][0] = s.x;
-			lightView[1][0] = s.y;
-			lightView[2][0] = s.z;
-			lightView[0][1] = u.x;
-			lightView[1][1] = u.y;
-			lightView[2][1] = u.z;
-			lightView[0][2] = -f.x;
-			lightView[1][2] = -f.y;
-			lightView[2][2] = -f.z;
-			lightView[3][0] = -Math::dot(s, eye);
-			lightView[3][1] = -Math::dot(u, eye);
-			lightView[3][2] = Math::dot(f, eye);
-			
-			auto projViewMatrix = getLightSpaceMatrix(corners, lightView, shadowCascade.zMult.x, shadowCascade.zMult.y);
-
-			mLightSpaceMatrices.push_back(projViewMatrix);
-
-			shadowCascade.frustum = SFE::FrustumModule::createFrustum(projViewMatrix);
+			mLightSpaceMatrices.push_back(Render::CascadePlanner::updateLightMatrix(shadowCascade, cameraView, lightTransform, resolution.x, stablePadding));
 		}
 	}
 
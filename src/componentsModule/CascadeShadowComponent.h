@@ -7,25 +7,18 @@
 #include "assetsModule/modelModule/BoundingVolume.h"
 #include "mathModule/Projection.h"
 #include "propertiesModule/Serializable.h"
+#include "renderModule/CascadePlanner.h"
 
 
 namespace SFE::ComponentsModule {
-	struct ShadowCascade {
-		SFE::FrustumModule::Frustum frustum = {};
-		SFE::MathModule::PerspectiveProjection viewProjection {};
-		float bias = 0.f;
-		int samples = 64;
-
-		Math::Vec2 zMult = { 1.f,1.f };
-		Math::Vec2 texelSize = {};
-	};
+	using ShadowCascade = Render::ShadowCascade;
 
 	class CascadeShadowComponent : public ecss::ComponentInterface, PropertiesModule::Serializable {
 	public:
 		CascadeShadowComponent(ecss::SectorId id) : ComponentInterface(id) {};
 
 		void updateCascades(const MathModule::PerspectiveProjection& cameraProjection);
-		void updateLightSpaceMatrices(const Math::Mat4& cameraView);
+		void updateLightSpaceMatrices(const Math::Mat4& cameraView, const Math::Mat4& lightTransform);
 
 		static SFE::Math::Mat4 getLightSpaceMatrix(const std::vector<SFE::Math::Vec4>& corners, const SFE::Math::Mat4& lightView, float nearMultiplier = 1.f, float farMultiplier = 1.f);
 		static std::vector<Math::Vec4> getFrustumCornersWorldSpace(const Math::Mat4& proj, const Math::Mat4& view);
@@ -35,15 +28,20 @@ namespace SFE::ComponentsModule {
 		std::vector<float> shadowCascadeLevels;
 		Math::Vec2 resolution = {};
 
+		//part of cascade radius added around camera frustum, bigger value keeps cached cascades longer but lowers shadow resolution
+		inline static float stablePadding = 0.15f;
+
 		MathModule::PerspectiveProjection mCameraProjection = {};
 
 
 		void markDirty();
-		void calculateLightSpaceMatrices(const MathModule::PerspectiveProjection& projection, const Math::Mat4& view);
+		void calculateLightSpaceMatrices(const MathModule::PerspectiveProjection& projection, const Math::Mat4& view, const Math::Mat4& lightTransform);
 		const std::vector<Math::Mat4>& getLightSpaceMatrices();
 
 		void serialize(Json::Value& data) override;
 		void deserialize(const Json::Value& data) override;
+		void serialize(PropertiesModule::BinaryWriter& data) override;
+		void deserialize(PropertiesModule::BinaryReader& data) override;
 		float shadowIntensity = 1.f;
 
 		void cacheMatrices();
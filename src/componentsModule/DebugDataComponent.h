@@ -8,6 +8,7 @@ namespace SFE::ComponentsModule {
 	class DebugDataComponent {
 	public:
 		DebugDataComponent() = default;
+		//code which changes id of existing node notifies NODE_UPDATED, component doesn't know its entity
 		std::string stringId;
 	};
 }
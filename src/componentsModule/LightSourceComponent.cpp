@@ -1,5 +1,7 @@
 ﻿#include "LightSourceComponent.h"
 
+#include "propertiesModule/PropertiesSystem.h"
+
 LightSourceComponent::LightSourceComponent(ecss::SectorId id, eLightType type) : ComponentInterface(id), mType(type) {
 }
 //offset - frustums count for light source, this offset used in light shader
@@ -76,9 +78,116 @@ int LightSourceComponent::getSamples() const {
 }
 
 void LightSourceComponent::serialize(Json::Value& data) {
+	data["Type"] = static_cast<int>(mType);
+	data["Intensity"] = mIntensity;
+
+	data["Color"].append(mLightColor.x);
+	data["Color"].append(mLightColor.y);
+	data["Color"].append(mLightColor.z);
+
+	data["Bias"] = mBias;
+	data["TexelSize"].append(mTexelSize.x);
+	data["TexelSize"].append(mTexelSize.y);
+	data["Samples"] = mSamples;
 
+	data["Linear"] = mLinear;
+	data["Quadratic"] = mQuadratic;
+	data["Radius"] = mRadius;
+	data["Near"] = mNear;
+	data["WithShadows"] = mWithShadows;
 }
 
 void LightSourceComponent::deserialize(const Json::Value& data) {
+	using namespace SFE::PropertiesModule;
+
+	if (auto val = JsonUtils::getValue(data, "Type")) {
+		setType(static_cast<eLightType>(val->asInt()));
+	}
+	if (auto val = JsonUtils::getValue(data, "Intensity")) {
+		setIntensity(val->asFloat());
+	}
+	if (auto val = JsonUtils::getValueArray(data, "Color")) {
+		setLightColor(JsonUtils::getVec3(*val));
+	}
+
+	if (auto val = JsonUtils::getValue(data, "Bias")) {
+		setBias(val->asFloat());
+	}
+	if (auto val = JsonUtils::getValueArray(data, "TexelSize")) {
+		setTexelSize(JsonUtils::getVec2(*val));
+	}
+	if (auto val = JsonUtils::getValue(data, "Samples")) {
+		setSamples(val->asInt());
+	}
+
+	if (auto val = JsonUtils::getValue(data, "Linear")) {
+		mLinear = val->asFloat();
+	}
+	if (auto val = JsonUtils::getValue(data, "Quadratic")) {
+		mQuadratic = val->asFloat();
+	}
+	if (auto val = JsonUtils::getValue(data, "Radius")) {
+		mRadius = val->asFloat();
+	}
+	if (auto val = JsonUtils::getValue(data, "Near")) {
+		mNear = val->asFloat();
+	}
+	if (auto val = JsonUtils::getValue(data, "WithShadows")) {
+		mWithShadows = val->asBool();
+	}
+}
+
+void LightSourceComponent::serialize(SFE::PropertiesModule::BinaryWriter& data) {
+	data.write(mType);
+	data.write(mIntensity);
+	data.write(mLightColor);
+	data.write(mBias);
+	data.write(mTexelSize);
+	data.write(mSamples);
+	data.write(mLinear);
+	data.write(mQuadratic);
+	data.write(mRadius);
+	data.write(mNear);
+	data.write(mWithShadows);
+}
+
+void LightSourceComponent::deserialize(SFE::PropertiesModule::BinaryReader& data) {
+	eLightType type;
+	float intensity;
+	SFE::Math::Vec3 color;
+	float bias;
+	SFE::Math::Vec2 texelSize;
+	int samples;
+	float linear;
+	float quadratic;
+	float radius;
+	float near;
+	bool withShadows;
+	//reader fails all reads after the first failed one, so one check after all reads is enough
+	data.read(type);
+	data.read(intensity);
+	data.read(color);
+	data.read(bias);
+	data.read(texelSize);
+	data.read(samples);
+	data.read(linear);
+	data.read(quadratic);
+	data.read(radius);
+	data.read(near);
+	data.read(withShadows);
+	if (!data.isValid()) {
+		return;
+	}
 
+	setType(type);
+	setIntensity(intensity);
+	setLightColor(color);
+	setBias(bias);
+	setTexelSize(texelSize);
+	setSamples(samples);
+	mLinear = linear;
+	mQuadratic = quadratic;
+	mRadius = radius;
+	mNear = near;
+	mWithShadows = withShadows;
 }
@@ -39,6 +39,8 @@ namespace SFE::ComponentsModule {
 
 		void serialize(Json::Value& data) override;
 		void deserialize(const Json::Value& data) override;
+		void serialize(PropertiesModule::BinaryWriter& data) override;
+		void deserialize(PropertiesModule::BinaryReader& data) override;
 		float mLinear = 0.1f;
 		float mQuadratic = 0.0001f;
 		float mRadius = 100.f;
@@ -27,6 +27,7 @@ namespace SFE::ComponentsModule {
 
 	struct MaterialComponent {
 		Materials materials;
+		uint32_t tableIndex = 0; //row in material table, it is set by render system in draw registry copy
 	};
 }
 
@@ -1,12 +1,15 @@
 ﻿#pragma once
+#include "assetsModule/modelModule/GeometryArena.h"
 #include "assetsModule/modelModule/Model.h"
 
 namespace SFE::ComponentsModule {
 	struct MeshComponent {
 		struct MeshData {
-			unsigned int vaoId = 0;
+			GeometryArena::Handle mesh;
 			int verticesCount = 0;
 			int indicesCount = 0;
+			FrustumModule::AABB bounds;
+			float uvDensity = 0.f;
 		};
 
 		Graph<MeshData> meshGraph;
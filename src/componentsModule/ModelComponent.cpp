@@ -5,6 +5,7 @@
 #include "assetsModule/modelModule/ModelLoader.h"
 #include "assetsModule/modelModule/Model.h"
 #include "core/ECSHandler.h"
+#include "systemsModule/TasksManager.h"
 #include "systemsModule/systems/AABBSystem.h"
 
 
@@ -65,6 +66,14 @@ const AssetsModule::Model::LOD& ModelComponent::getModelLowestDetails() const {
 	return mModel->back();
 }
 
+void ModelComponent::init(AssetsModule::Model* model) {
+	mPath = model->assetPath;
+	boneMatrices = model->getDefaultBoneMatrices();
+	armature = model->getArmature();
+	addMeshData(model->getLODs());
+	SFE::SystemsModule::TasksManager::instance()->notify({ getEntityId(), SFE::SystemsModule::NODE_UPDATED });
+}
+
 void ModelComponent::setModel(std::vector<AssetsModule::Model::LOD>* data) {
 	mModel = data;
 }
@@ -81,8 +90,20 @@ void ModelComponent::deserialize(const Json::Value& data) {
 	}
 
 	if (model) {
-		boneMatrices = model->getDefaultBoneMatrices();
-		armature = model->getArmature();
-		addMeshData(model->getLODs());
+		init(model);
+	}
+}
+
+void ModelComponent::serialize(PropertiesModule::BinaryWriter& data) {
+	data.writeString(mPath);
+}
+
+void ModelComponent::deserialize(PropertiesModule::BinaryReader& data) {
+	if (!data.readString(mPath)) {
+		return;
+	}
+
+	if (auto model = AssetsModule::ModelLoader::instance()->load(mPath)) {
+		init(model);
 	}
 }
\ No newline at end of file
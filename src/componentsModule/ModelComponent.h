@@ -60,10 +60,7 @@ namespace SFE::ComponentsModule {
 	class ModelComponent : public ecss::ComponentInterface, public PropertiesModule::Serializable {
 	public:
 		ModelComponent(ecss::SectorId id) : ComponentInterface(id) {};
-		void init(AssetsModule::Model* model) {
-			mPath = model->assetPath;
-			addMeshData(model->getLODs());
-		}
+		void init(AssetsModule::Model* model);
 
 		const AssetsModule::Model::LOD& getModel();
 		AssetsModule::Model::LOD& getModel(size_t LOD) const;
@@ -74,6 +71,9 @@ namespace SFE::ComponentsModule {
 
 		void serialize(Json::Value& data) override;
 		void deserialize(const Json::Value& data) override;
+		//model is loaded synchronously, scene loader keeps models in its own table and loads them once
+		void serialize(PropertiesModule::BinaryWriter& data) override;
+		void deserialize(PropertiesModule::BinaryReader& data) override;
 		std::string mPath = "";
 
 		AssetsModule::Armature armature;
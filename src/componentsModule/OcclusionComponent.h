@@ -1,13 +1,13 @@
 ﻿#pragma once
-#include "glWrapper/Query.h"
+#include <vector>
+
+#include "assetsModule/modelModule/BoundingVolume.h"
 
 namespace SFE::ComponentsModule {
 	struct OcclusionComponent {
 		OcclusionComponent() {}
 
 		~OcclusionComponent() {}
-		GLW::Query<GLW::QueryType::SAMPLES_PASSED>* query = nullptr;
-
 		bool occluded = false;
 
 		std::vector<FrustumModule::AABB> occluderAABB; //occluder is smaller bounding volume  representing object shape which can occlude other objects, it is should be the shape equal or smaller then object itself, (for tree it is only the tree tunk itself)
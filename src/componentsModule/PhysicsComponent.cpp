@@ -6,10 +6,7 @@
 PhysicsComponent::~PhysicsComponent() {
 	if (ECSHandler::isAlive()) {
 		if (auto system = ECSHandler::getSystem<SFE::SystemsModule::Physics>()) {
-			JPH::BodyInterface& body_interface = system->physics_system->GetBodyInterface();
-
-			body_interface.RemoveBody(mBodyID);
-			body_interface.DestroyBody(mBodyID);
+			system->removeBody(mBodyID);
 		}
 	}
 }
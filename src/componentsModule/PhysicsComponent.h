@@ -5,6 +5,7 @@
 #include "Jolt/Physics/Body/BodyID.h"
 #include "Jolt/Physics/Body/BodyInterface.h"
 #include "mathModule/Forward.h"
+#include "mathModule/Quaternion.h"
 
 
 namespace SFE::ComponentsModule {
@@ -12,9 +13,10 @@ namespace SFE::ComponentsModule {
 	public:
 		JPH::BodyID mBodyID;
 
+		//state which body and transform had after the last sync, changes of transform are pushed to body only when they differ
 		SFE::Math::Vec3 lastPos = {};
-		SFE::Math::Vec3 lastRotate = {};
-		bool isSleeping = false;
+		SFE::Math::Quaternion<float> lastRotation = { 1.f, 0.f, 0.f, 0.f };
+		uint64_t interpolatedTick = 0;
 
 		PhysicsComponent(const JPH::BodyID& id) : mBodyID(id) {}
 
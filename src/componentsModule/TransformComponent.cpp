@@ -27,31 +27,64 @@ namespace SFE::ComponentsModule {
 	}
 	void TransformComponent::setPos(const Math::Vec3& pos) {
 		std::unique_lock lock(mtx);
-		if (mPos != pos) {	markDirty(); }
+		if (mPos != pos) {
+			markDirty();
+			mVersion = nextVersion();
+		}
 
 		mPos = pos;
 	}
 
 	//x - pitch, y - yaw, z - roll
 	const Math::Vec3& TransformComponent::getRotate() const {
-		std::shared_lock lock(mtx);
+		{
+			std::shared_lock lock(mtx);
+			if (!mEulerDirty) {
+				return mRotate;
+			}
+		}
+
+		std::unique_lock lock(mtx);
+		if (mEulerDirty) {
+			mRotate = Math::degrees(mRotateQuaternion.toEuler());
+			mEulerDirty = false;
+		}
 		return mRotate;
 	}
 
 	void TransformComponent::setPitch(float x) {
-		setRotate({ x, mRotate.y, mRotate.z });
+		const auto rotate = getRotate();
+		setRotate({ x, rotate.y, rotate.z });
 	}
 	void TransformComponent::setYaw(float y) {
-		setRotate({ mRotate.x, y, mRotate.z });
+		const auto rotate = getRotate();
+		setRotate({ rotate.x, y, rotate.z });
 	}
 	void TransformComponent::setRoll(float z) {
-		setRotate({ mRotate.x, mRotate.y, z });
+		const auto rotate = getRotate();
+		setRotate({ rotate.x, rotate.y, z });
 	}
 	void TransformComponent::setRotate(const SFE::Math::Vec3& rotate) {
 		std::unique_lock lock(mtx);
-		if (this->mRotate != rotate) { markDirty(); }
+		if (this->mRotate != rotate || mEulerDirty) {
+			markDirty();
+			mVersion = nextVersion();
+		}
 
 		this->mRotate = rotate;
+		mQuaternionDirty = true;
+		mEulerDirty = false;
+	}
+
+	void TransformComponent::setPosAndRotation(const Math::Vec3& pos, const Math::Quaternion<float>& rotation) {
+		std::unique_lock lock(mtx);
+		markDirty();
+		mVersion = nextVersion();
+
+		mPos = pos;
+		mRotateQuaternion = rotation;
+		mQuaternionDirty = false;
+		mEulerDirty = true;
 	}
 
 	const Math::Vec3& TransformComponent::getScale() const {
@@ -74,7 +107,10 @@ namespace SFE::ComponentsModule {
 	}
 	void TransformComponent::setScale(const SFE::Math::Vec3& scale) {
 		std::unique_lock lock(mtx);
-		if (mScale != scale) { markDirty();	}
+		if (mScale != scale) {
+			markDirty();
+			mVersion = nextVersion();
+		}
 
 		mScale = scale;
 	}
@@ -107,7 +143,10 @@ namespace SFE::ComponentsModule {
 			}
 			mDirty = false;
 
-			mRotateQuaternion.eulerToQuaternion(mRotate);
+			if (mQuaternionDirty) {
+				mRotateQuaternion.eulerToQuaternion(mRotate);
+				mQuaternionDirty = false;
+			}
 		}
 		
 		auto newTransform = calculateLocalTransform();
@@ -177,7 +216,13 @@ namespace SFE::ComponentsModule {
 		return mDirty;
 	}
 
+	uint64_t TransformComponent::getVersion() const {
+		std::shared_lock lock(mtx);
+		return mVersion;
+	}
+
 	void TransformComponent::serialize(Json::Value& data) {
+		const auto rotate = getRotate();
 		std::shared_lock lock(mtx);
 
 		data["Scale"].append(mScale.x);
@@ -188,9 +233,9 @@ namespace SFE::ComponentsModule {
 		data["Pos"].append(mPos.y);
 		data["Pos"].append(mPos.z);
 
-		data["Rotate"].append(mRotate.x);
-		data["Rotate"].append(mRotate.y);
-		data["Rotate"].append(mRotate.z);
+		data["Rotate"].append(rotate.x);
+		data["Rotate"].append(rotate.y);
+		data["Rotate"].append(rotate.z);
 	}
 
 	void TransformComponent::deserialize(const Json::Value& data) {
@@ -207,6 +252,28 @@ namespace SFE::ComponentsModule {
 		}
 	}
 
+	void TransformComponent::serialize(PropertiesModule::BinaryWriter& data) {
+		const auto rotate = getRotate();
+		std::shared_lock lock(mtx);
+
+		data.write(mScale);
+		data.write(mPos);
+		data.write(rotate);
+	}
+
+	void TransformComponent::deserialize(PropertiesModule::BinaryReader& data) {
+		Math::Vec3 scale;
+		Math::Vec3 pos;
+		Math::Vec3 rotate;
+		if (!data.read(scale) || !data.read(pos) || !data.read(rotate)) {
+			return;
+		}
+
+		setScale(scale);
+		setPos(pos);
+		setRotate(rotate);
+	}
+
 	TransformComponent::~TransformComponent() {
 
 	}
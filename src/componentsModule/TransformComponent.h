@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <atomic>
 #include <shared_mutex>
 
 #include "mathModule/Forward.h"
@@ -15,6 +16,9 @@ namespace SFE::ComponentsModule {
 			: ecss::ComponentInterface(other),
 			  PropertiesModule::Serializable(other),
 			  mDirty(other.mDirty),
+			  mQuaternionDirty(other.mQuaternionDirty),
+			  mEulerDirty(other.mEulerDirty),
+			  mVersion(other.mVersion),
 			  mRotateQuaternion(other.mRotateQuaternion),
 			  mTransform(other.mTransform),
 			  mPos(other.mPos),
@@ -27,6 +31,9 @@ namespace SFE::ComponentsModule {
 			ecss::ComponentInterface::operator =(other);
 			PropertiesModule::Serializable::operator =(other);
 			mDirty = other.mDirty;
+			mQuaternionDirty = other.mQuaternionDirty;
+			mEulerDirty = other.mEulerDirty;
+			mVersion = other.mVersion;
 			mRotateQuaternion = other.mRotateQuaternion;
 			mTransform = other.mTransform;
 			mPos = other.mPos;
@@ -39,6 +46,9 @@ namespace SFE::ComponentsModule {
 			: ecss::ComponentInterface(std::move(other)),
 			  PropertiesModule::Serializable(std::move(other)),
 			  mDirty(other.mDirty),
+			  mQuaternionDirty(other.mQuaternionDirty),
+			  mEulerDirty(other.mEulerDirty),
+			  mVersion(other.mVersion),
 			  mRotateQuaternion(std::move(other.mRotateQuaternion)),
 		      mTransform(std::move(other.mTransform)),
 			  mPos(std::move(other.mPos)),
@@ -51,6 +61,9 @@ namespace SFE::ComponentsModule {
 			ecss::ComponentInterface::operator =(std::move(other));
 			PropertiesModule::Serializable::operator =(std::move(other));
 			mDirty = other.mDirty;
+			mQuaternionDirty = other.mQuaternionDirty;
+			mEulerDirty = other.mEulerDirty;
+			mVersion = other.mVersion;
 			mTransform = std::move(other.mTransform);
 			mRotateQuaternion = std::move(other.mRotateQuaternion);
 			mPos = std::move(other.mPos);
@@ -60,6 +73,8 @@ namespace SFE::ComponentsModule {
 		}
 
 		TransformComponent(ecss::SectorId id) : ComponentInterface(id) { markDirty(); };
+		//component is dirty but TRANSFORM_UPDATE isn't sent, creator notifies all created entities at once
+		TransformComponent(ecss::SectorId id, const Math::Vec3& pos, const Math::Vec3& rotate, const Math::Vec3& scale) : ComponentInterface(id), mDirty(true), mPos(pos), mScale(scale), mRotate(rotate) {}
 		~TransformComponent() override;
 
 		const Math::Vec3& getPos(bool global = false) const;
@@ -74,6 +89,8 @@ namespace SFE::ComponentsModule {
 		void setYaw(float y);
 		void setRoll(float z);
 		void setRotate(const Math::Vec3& rotate);
+		//rotation is kept as it is, euler angles are calculated from it only when they are asked
+		void setPosAndRotation(const Math::Vec3& pos, const Math::Quaternion<float>& rotation);
 
 		const Math::Vec3& getScale() const;
 		Math::Vec3 getGlobalScale() const;
@@ -100,21 +117,32 @@ namespace SFE::ComponentsModule {
 
 		void markDirty();
 		bool isDirty() const;
+		//stamp of the last change of position, rotation or scale, stamps are unique among all components,
+		//so component created on place of destroyed one never has its stamp
+		uint64_t getVersion() const;
 
 		void deserialize(const Json::Value& data) override;
 		void serialize(Json::Value& data) override;
+		void deserialize(PropertiesModule::BinaryReader& data) override;
+		void serialize(PropertiesModule::BinaryWriter& data) override;
 
 	private:
 		bool mDirty = false;
+		bool mQuaternionDirty = true; //euler angles were changed
+		mutable bool mEulerDirty = false; //quaternion was set directly
+		uint64_t mVersion = nextVersion();
 
 		Math::Quaternion<float> mRotateQuaternion;
 		Math::Mat4 mTransform = Math::Mat4{ 1.f };
 
 		Math::Vec3 mPos = {0.f};
 		Math::Vec3 mScale = { 1.f };
-		Math::Vec3 mRotate = { 0.f }; 
+		mutable Math::Vec3 mRotate = { 0.f }; 
 		
 		mutable std::shared_mutex mtx;
+
+		static uint64_t nextVersion() { return ++sVersions; }
+		inline static std::atomic<uint64_t> sVersions = 0;
 	};
 
 	struct TransformMatComp {
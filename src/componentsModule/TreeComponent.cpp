@@ -1,6 +1,7 @@
 ﻿#include "TreeComponent.h"
 
 #include "core/ECSHandler.h"
+#include "systemsModule/TasksManager.h"
 
 namespace SFE::ComponentsModule {
 	void TreeComponent::setParent(ecss::SectorId id) {
@@ -8,7 +9,8 @@ namespace SFE::ComponentsModule {
 			return;
 		}
 
-		mParentEntity = id;		
+		mParentEntity = id;
+		SystemsModule::TasksManager::instance()->notify({ getEntityId(), SystemsModule::NODE_UPDATED });
 	}
 
 	ecss::SectorId TreeComponent::getParent() const {
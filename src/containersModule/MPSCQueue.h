@@ -0,0 +1,111 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <cstdint>
+
+namespace SFE {
+	//bounded lock-free queue, any amount of producers, single consumer
+	//producers never block - if queue is full tryPush returns false and it is up to caller to drop or retry
+	template<typename T, size_t Capacity>
+	class MPSCQueue {
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MPSCQueue capacity should be power of two");
+
+		struct alignas(64) Cell {
+			std::atomic<size_t> sequence;
+			T data;
+		};
+
+	public:
+		MPSCQueue() : mCells(std::make_unique<Cell[]>(Capacity)) {
+			for (size_t i = 0; i < Capacity; i++) {
+				mCells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		//fill - callable which writes value into the cell, it allows to format data directly inside the queue without extra copy
+		template<typename Fill>
+		bool tryEmplace(Fill&& fill) {
+			Cell* cell = nullptr;
+			size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+			while (true) {
+				cell = &mCells[pos & (Capacity - 1)];
+				const size_t seq = cell->sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0) {
+					if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				}
+				else if (diff < 0) {
+					return false; //full
+				}
+				else {
+					pos = mEnqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+
+			fill(cell->data);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		bool tryPush(const T& value) {
+			return tryEmplace([&value](T& cell) { cell = value; });
+		}
+
+		bool tryPush(T&& value) {
+			return tryEmplace([&value](T& cell) { cell = std::move(value); });
+		}
+
+		//consumer side, only one thread can call it
+		template<typename Consume>
+		bool tryConsume(Consume&& consume) {
+			const size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+			Cell& cell = mCells[pos & (Capacity - 1)];
+			const size_t seq = cell.sequence.load(std::memory_order_acquire);
+			if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) {
+				return false; //empty or producer didn't finish writing yet
+			}
+
+			consume(cell.data);
+			cell.sequence.store(pos + Capacity, std::memory_order_release);
+			mDequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+			return true;
+		}
+
+		bool tryPop(T& value) {
+			return tryConsume([&value](T& cell) { value = std::move(cell); });
+		}
+
+		//consumes everything available at the moment of call, returns consumed count
+		template<typename Consume>
+		size_t consumeAll(Consume&& consume) {
+			size_t count = 0;
+			while (tryConsume(consume)) {
+				count++;
+			}
+
+			return count;
+		}
+
+		//approximate, can be used only for statistics
+		size_t sizeApprox() const {
+			const auto enqueue = mEnqueuePos.load(std::memory_order_relaxed);
+			const auto dequeue = mDequeuePos.load(std::memory_order_relaxed);
+			return enqueue > dequeue ? enqueue - dequeue : 0;
+		}
+
+		constexpr static size_t capacity() { return Capacity; }
+
+	private:
+		std::unique_ptr<Cell[]> mCells;
+		alignas(64) std::atomic<size_t> mEnqueuePos = 0;
+		alignas(64) std::atomic<size_t> mDequeuePos = 0;
+	};
+}
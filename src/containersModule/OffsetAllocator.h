@@ -0,0 +1,183 @@
+﻿#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace SFE {
+	//sub-allocator of abstract range [0, capacity), it doesn't own memory, so it is used for gpu buffers where only offsets matter
+	//best fit search by free block size, neighbour free blocks are merged back on free
+	class OffsetAllocator {
+	public:
+		constexpr static uint32_t INVALID_OFFSET = std::numeric_limits<uint32_t>::max();
+
+		//allocation moved by defragment, data of size elements should be copied from -> to
+		struct Move {
+			uint32_t from = 0;
+			uint32_t to = 0;
+			uint32_t size = 0;
+		};
+
+		explicit OffsetAllocator(uint32_t capacity = 0) {
+			reset(capacity);
+		}
+
+		void reset(uint32_t capacity) {
+			mCapacity = capacity;
+			mUsed = 0;
+			mFreeByOffset.clear();
+			mFreeBySize.clear();
+			mAllocations.clear();
+
+			if (capacity) {
+				insertFreeBlock(0, capacity);
+			}
+		}
+
+		//returns INVALID_OFFSET when there is no free block big enough
+		uint32_t allocate(uint32_t size) {
+			if (size == 0) {
+				return INVALID_OFFSET;
+			}
+
+			const auto sizeIt = mFreeBySize.lower_bound(size);
+			if (sizeIt == mFreeBySize.end()) {
+				return INVALID_OFFSET;
+			}
+
+			const auto offset = sizeIt->second;
+			const auto blockSize = sizeIt->first;
+			eraseFreeBlock(mFreeByOffset.find(offset));
+
+			if (blockSize > size) {
+				insertFreeBlock(offset + size, blockSize - size);
+			}
+
+			mAllocations.emplace(offset, size);
+			mUsed += size;
+
+			return offset;
+		}
+
+		void free(uint32_t offset) {
+			const auto allocationIt = mAllocations.find(offset);
+			assert(allocationIt != mAllocations.end());
+			if (allocationIt == mAllocations.end()) {
+				return;
+			}
+
+			auto size = allocationIt->second;
+			mUsed -= size;
+			mAllocations.erase(allocationIt);
+
+			auto next = mFreeByOffset.lower_bound(offset);
+			if (next != mFreeByOffset.begin()) {
+				const auto prev = std::prev(next);
+				if (prev->first + prev->second == offset) {
+					offset = prev->first;
+					size += prev->second;
+					eraseFreeBlock(prev);
+				}
+			}
+
+			if (next != mFreeByOffset.end() && offset + size == next->first) {
+				size += next->second;
+				eraseFreeBlock(next);
+			}
+
+			insertFreeBlock(offset, size);
+		}
+
+		//new space is added to the end, it is merged with the last free block
+		void grow(uint32_t newCapacity) {
+			if (newCapacity <= mCapacity) {
+				return;
+			}
+
+			auto offset = mCapacity;
+			auto size = newCapacity - mCapacity;
+			mCapacity = newCapacity;
+
+			if (!mFreeByOffset.empty()) {
+				const auto last = std::prev(mFreeByOffset.end());
+				if (last->first + last->second == offset) {
+					offset = last->first;
+					size += last->second;
+					eraseFreeBlock(last);
+				}
+			}
+
+			insertFreeBlock(offset, size);
+		}
+
+		//moves allocations to the beginning keeping their order, after it all free space is one block at the end
+		//moves are sorted by offset and every destination is lower than source, so they can be applied one by one in place
+		std::vector<Move> defragment() {
+			std::vector<Move> moves;
+
+			std::map<uint32_t, uint32_t> allocations;
+			uint32_t offset = 0;
+			for (const auto& [from, size] : mAllocations) {
+				if (from != offset) {
+					moves.push_back({ from, offset, size });
+				}
+				allocations.emplace(offset, size);
+				offset += size;
+			}
+
+			mAllocations = std::move(allocations);
+			mFreeByOffset.clear();
+			mFreeBySize.clear();
+			if (offset < mCapacity) {
+				insertFreeBlock(offset, mCapacity - offset);
+			}
+
+			return moves;
+		}
+
+		uint32_t getAllocationSize(uint32_t offset) const {
+			const auto it = mAllocations.find(offset);
+			return it != mAllocations.end() ? it->second : 0;
+		}
+
+		uint32_t getCapacity() const { return mCapacity; }
+		uint32_t getUsed() const { return mUsed; }
+		uint32_t getFree() const { return mCapacity - mUsed; }
+		uint32_t getLargestFreeBlock() const { return mFreeBySize.empty() ? 0 : std::prev(mFreeBySize.end())->first; }
+		size_t getAllocationsCount() const { return mAllocations.size(); }
+		size_t getFreeBlocksCount() const { return mFreeByOffset.size(); }
+
+		//0 - free space is one block, close to 1 - free space is split into a lot of small blocks
+		float getFragmentation() const {
+			const auto free = getFree();
+			return free ? 1.f - static_cast<float>(getLargestFreeBlock()) / static_cast<float>(free) : 0.f;
+		}
+
+	private:
+		void insertFreeBlock(uint32_t offset, uint32_t size) {
+			mFreeByOffset.emplace(offset, size);
+			mFreeBySize.emplace(size, offset);
+		}
+
+		void eraseFreeBlock(std::map<uint32_t, uint32_t>::iterator it) {
+			auto [first, last] = mFreeBySize.equal_range(it->second);
+			for (; first != last; ++first) {
+				if (first->second == it->first) {
+					mFreeBySize.erase(first);
+					break;
+				}
+			}
+			mFreeByOffset.erase(it);
+		}
+
+		uint32_t mCapacity = 0;
+		uint32_t mUsed = 0;
+
+		std::map<uint32_t, uint32_t> mFreeByOffset; //offset -> size
+		std::multimap<uint32_t, uint32_t> mFreeBySize; //size -> offset
+		std::map<uint32_t, uint32_t> mAllocations; //offset -> size
+	};
+}
@@ -2,16 +2,17 @@
 
 #include "ECSHandler.h"
 #include "Engine.h"
-#include "imgui.h"
 #include "InputHandler.h"
 #include "multithreading/ThreadPool.h"
 #include "assetsModule/modelModule/ModelLoader.h"
 #include "assetsModule/shaderModule/ShaderController.h"
-#include "debugModule/imguiDecorator.h"
 #include "systemsModule/SystemManager.h"
+#include "systemsModule/systems/PhysicsSystem.h"
+#include "systemsModule/systems/RenderSystem.h"
 #include "assetsModule/AssetsManager.h"
-#include "backends/imgui_impl_opengl3.h"
 #include "debugModule/Benchmark.h"
+#include "debugModule/GpuProfiler.h"
+#include "debugModule/LogWindow.h"
 #include "mathModule/Forward.h"
 #include "renderModule/TextRenderer.h"
 
@@ -20,6 +21,39 @@ namespace SFE::CoreModule {
 		FUNCTION_BENCHMARK;
 
 		ECSHandler::systemManager().update(dt);
+
+		//physics ticks slower than frames, its bodies are moved between ticks here
+		if (const auto physics = ECSHandler::getSystem<SystemsModule::Physics>()) {
+			physics->interpolate();
+		}
+	}
+
+	std::shared_ptr<SystemsModule::RenderSnapshot> Core::extractRenderData() {
+		FUNCTION_BENCHMARK;
+
+		if (const auto render = ECSHandler::getSystem<SystemsModule::RenderSystem>()) {
+			return render->extract();
+		}
+
+		return nullptr;
+	}
+
+	void Core::syncUpdate(float dt) {
+		FUNCTION_BENCHMARK;
+
+		ECSHandler::systemManager().debugUpdate(dt);
+		if (const auto render = ECSHandler::getSystem<SystemsModule::RenderSystem>()) {
+			render->syncSimulation();
+		}
+	}
+
+	void Core::renderUpdate(float dt, std::shared_ptr<SystemsModule::RenderSnapshot> renderData) {
+		FUNCTION_BENCHMARK;
+
+		if (const auto render = ECSHandler::getSystem<SystemsModule::RenderSystem>()) {
+			render->setSnapshot(std::move(renderData));
+		}
+		ECSHandler::systemManager().renderUpdate(dt);
 		ThreadPool::instance()->syncUpdate();
 	}
 
@@ -35,6 +69,8 @@ namespace SFE::CoreModule {
 
 		ThreadPool::terminate();
 		ECSHandler::terminate();
+		Debug::GpuProfiler::terminate();
+		Debug::LogWindow::terminate();
 
 		AssetsModule::AssetsManager::terminate();
 	}
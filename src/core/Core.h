@@ -1,4 +1,9 @@
 ﻿#pragma once
+#include <memory>
+
+namespace SFE::SystemsModule {
+	struct RenderSnapshot;
+}
 
 namespace SFE::CoreModule {
 	class Core {
@@ -7,6 +12,11 @@ namespace SFE::CoreModule {
 		~Core();
 
 		void update(float dt);
+		//main thread, copy of simulation state for render of this frame
+		std::shared_ptr<SystemsModule::RenderSnapshot> extractRenderData();
+		//render thread while simulation waits, systems can read and change main registry there
+		void syncUpdate(float dt);
+		void renderUpdate(float dt, std::shared_ptr<SystemsModule::RenderSnapshot> renderData);
 		void init();
 	};
 }
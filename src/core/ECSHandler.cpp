@@ -1,6 +1,7 @@
 ﻿#include "ECSHandler.h"
 
 #include "assetsModule/AssetsManager.h"
+#include "assetsModule/TextureCooker.h"
 #include "assetsModule/modelModule/MeshVaoRegistry.h"
 #include "assetsModule/modelModule/ModelLoader.h"
 #include "componentsModule/ArmatureComponent.h"
@@ -9,6 +10,8 @@
 #include "componentsModule/OcTreeComponent.h"
 #include "componentsModule/OcclusionComponent.h"
 #include "componentsModule/TransformComponent.h"
+#include "core/Prefab.h"
+#include "debugModule/Benchmark.h"
 #include "propertiesModule/PropertiesSystem.h"
 
 #include "systemsModule/SystemManager.h"
@@ -16,6 +19,7 @@
 
 #include "systemsModule/systems/AABBSystem.h"
 #include "systemsModule/systems/ActionSystem.h"
+#include "systemsModule/systems/AutosaveSystem.h"
 #include "systemsModule/systems/CameraSystem.h"
 #include "systemsModule/systems/ChunksSystem.h"
 #include "systemsModule/systems/LODSystem.h"
@@ -63,93 +67,50 @@ void ECSHandler::initSystems() {
 	mSystemManager.addTickSystems<SFE::SystemsModule::CameraSystem>(256);
 
 
-	mSystemManager.addRootSystems<SFE::SystemsModule::RenderSystem>();
+	//instantiates streamed chunks under frame budget
+	mSystemManager.addRootSystems<SFE::SystemsModule::ChunksSystem>();
+	//copies changed scene nodes for saver thread
+	mSystemManager.addRootSystems<SFE::SystemsModule::AutosaveSystem>();
+
+	mSystemManager.addRenderSystems<SFE::SystemsModule::RenderSystem>();
 
 	SFE::ThreadPool::instance()->addTask([]() {
-		SFE::PropertiesModule::PropertiesSystem::loadScene("shadowsTest.json");
+		const auto scene = SFE::PropertiesModule::PropertiesSystem::loadScene("shadowsTest.json");
+		auto autosave = getSystem<SFE::SystemsModule::AutosaveSystem>();
+		if (autosave && scene != ecss::INVALID_ID) {
+			autosave->track(scene, "autosave.scene");
+		}
+#if SCENE_BENCHMARK
+		SFE::PropertiesModule::PropertiesSystem::benchmark("serializedScene.json", 100'000);
+#endif
+#if TEXTURE_BENCHMARK
+		AssetsModule::TextureCooker::benchmark(AssetsModule::TextureCooker::findSources("models"), { false, AssetsModule::MipFilter::KAISER, AssetsModule::TextureCompression::BC7 });
+#endif
 		
 		auto path = "models/vampire.fbx";
 		//auto path = "models/box_moving.fbx";
 		//auto path = "models/cube.fbx";
 		auto model = AssetsModule::ModelLoader::instance()->load(path);
+
+		//SFE_PREFAB_BENCHMARK=100000 measures instantiation and destruction of that many instances
+		if (const auto count = SFE::CoreModule::Prefab::getBenchmarkCount(); count > 0) {
+			SFE::CoreModule::Prefab::benchmark(model, count);
+		}
+
+		std::vector<SFE::CoreModule::Prefab::Placement> placements;
 		for (auto i = 0; i < 40; i++) {
 			for (auto j = 0; j < 10; j++) {
 				for (auto k = 0; k < 1; k++) {
-					if (!SFE::Engine::instance()->isAlive()) {
-						return;
-					}
-					auto entity = ECSHandler::registry().takeEntity();
-
-					ECSHandler::addComponent<SFE::ComponentsModule::AABBComponent>(entity);
-					ECSHandler::addComponent<OcTreeComponent>(entity);
-					auto modelComp = ECSHandler::addComponent<ModelComponent>(entity, entity);
-
-					modelComp->mPath = path;
-					modelComp->boneMatrices = model->getDefaultBoneMatrices();
-					modelComp->armature = model->getArmature();
-					modelComp->setModel(model->getLODs());
-
-					auto transformComp = ECSHandler::addComponent<TransformComponent>(entity, entity);
-					transformComp->setPos({ i * 100.f, k*100.f, j * 100.f });
-					transformComp->setScale({ 0.10f });
-					ECSHandler::addComponent<IsDrawableComponent>(entity);
-
-					if (modelComp && !modelComp->getModel().meshes.empty()) {
-						auto meshComp = ECSHandler::addComponent<MeshComponent>(entity);
-						meshComp->meshGraph.fill<SFE::MeshObject3D>(model->getMeshTree(), [](const SFE::MeshObject3D& meshObj) {
-							return MeshComponent::MeshData {
-								SFE::MeshVaoRegistry::instance()->get(const_cast<SFE::Mesh3D*>(&meshObj.mesh)).vao.getID(),
-								static_cast<int>(meshObj.mesh.vertices.size()),
-								static_cast<int>(meshObj.mesh.indices.size())
-							};
-						});
-
-						SFE::SystemsModule::TasksManager::instance()->notify({ entity, SFE::SystemsModule::TaskType::MESH_UPDATED });
-
-						if (modelComp->getModel().meshes[0]->material.materialTextures.size()) {
-							auto materialComp = ECSHandler::addComponent<MaterialComponent>(entity);
-							meshComp->meshModel = model;
-							for (auto& mat : modelComp->getModel().meshes[0]->material.materialTextures) {
-								materialComp->materials.addMaterial({ mat.second.uniformSlot, mat.second.texture->mId, mat.second.texture->mType });
-							}
-							SFE::SystemsModule::TasksManager::instance()->notify({ entity, SFE::SystemsModule::TaskType::MATERIAL_UPDATED });
-						}
-
-						if (modelComp->armature.bones.size()) {
-							auto armatureComp = ECSHandler::addComponent<SFE::ComponentsModule::ArmatureComponent>(entity);
-							armatureComp->armature = modelComp->armature;
-
-							auto armatureBonesComp = ECSHandler::registry().addComponent<SFE::ComponentsModule::ArmatureBonesComponent>(entity);
-							std::ranges::copy(modelComp->boneMatrices, armatureBonesComp->boneMatrices.begin());
-
-							SFE::SystemsModule::TasksManager::instance()->notify({ entity, SFE::SystemsModule::TaskType::ARMATURE_UPDATED });
-						}
-					}
-
-					if (model->getAnimations().size()) {
-						auto animComp = ECSHandler::addComponent<SFE::ComponentsModule::AnimationComponent>(entity);
-						animComp->mCurrentAnimation = &model->getAnimations()[0];
-						animComp->mCurrentTime = static_cast<float>(i);
-					}
-					
-
-
-
-					/*auto oclC = ECSHandler::addComponent<SFE::ComponentsModule::OcclusionComponent>(entity);
-					oclC->query = new SFE::GLW::Query<SFE::GLW::QueryType::SAMPLES_PASSED>();
-					oclC->query->generate();
-					auto center = SFE::Math::Vec3{ i * 40.f, k * 40.f, j * 40.f };
-					auto min = center - SFE::Math::Vec3{ 10.f, 10.f, 10.f };
-					auto max = center + SFE::Math::Vec3{ 10.f, 10.f, 10.f};
-
-					auto minB = center - SFE::Math::Vec3{ 9.f, 9.f, 9.f };
-					auto maxB = center + SFE::Math::Vec3{ 9.f, 9.f, 9.f };*/
-					//oclC->occludeeAABB.push_back(SFE::FrustumModule::AABB(min, max));
-					//if (i == 0 && j == 0) {
-					//oclC->occluderAABB.push_back(SFE::FrustumModule::AABB(minB, maxB));
-					//}
+					placements.push_back({ { i * 100.f, k * 100.f, j * 100.f }, {}, { 0.10f }, static_cast<float>(i) });
 				}
 			}
 		}
+
+		if (!SFE::Engine::instance()->isAlive()) {
+			return;
+		}
+
+		FUNCTION_BENCHMARK_NAMED(spawn_instances);
+		SFE::CoreModule::Prefab(model).instantiate(placements);
 	});
 }
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "containersModule/Singleton.h"
 #include "ecss/Registry.h"
+#include "systemsModule/ParallelForEach.h"
 #include "systemsModule/SystemManager.h"
 #include "systemsModule/systems/RenderSystem.h"
 
@@ -19,6 +20,16 @@ public:
 		return instance()->mRegistry;
 	}
 
+	template<typename... Components, typename Func>
+	inline static void parallelForEach(size_t chunkSize, Func&& fn) {
+		SFE::SystemsModule::parallelForEach<Components...>(registry(), chunkSize, std::forward<Func>(fn));
+	}
+
+	template<typename... Components, typename Result, typename Map, typename Combine>
+	inline static Result parallelReduce(size_t chunkSize, Result identity, Map&& map, Combine&& combine) {
+		return SFE::SystemsModule::parallelReduce<Components...>(registry(), chunkSize, std::move(identity), std::forward<Map>(map), std::forward<Combine>(combine));
+	}
+
 	template<typename CompType, class ...Args>
 	inline static CompType* addComponent(ecss::EntityId entity, Args&&... args) {
 		auto comp = instance()->mRegistry.addComponent<CompType>(entity, std::forward<Args>(args)...);
@@ -5,6 +5,9 @@
 
 #include "Core.h"
 #include "InputHandler.h"
+#include "debugModule/Benchmark.h"
+#include "debugModule/GpuProfiler.h"
+#include "debugModule/LogWindow.h"
 #include "glWrapper/CapabilitiesStack.h"
 #include "glWrapper/Depth.h"
 #include "glWrapper/Draw.h"
@@ -32,11 +35,13 @@ namespace SFE {
 
 	void Engine::initThread() {
 		if (!mWindow) {
-			SFE::LogsModule::Logger::LOG_FATAL(false, "Try to initialize thread without context, forgot to call createWindow?");
+			SFE_LOG_FATAL(false, "Try to initialize thread without context, forgot to call createWindow?");
 			return;
 		}
 
 		mMainThreadID = std::this_thread::get_id();
+		mRenderThreadID = mMainThreadID;
+		Debug::LogWindow::instance();
 		glfwMakeContextCurrent(mWindow->getWindow());
 		mCore.init();
 
@@ -50,12 +55,12 @@ namespace SFE {
 			}
 		};
 
-		SFE::LogsModule::Logger::LOG_INFO("engine thread initialized");
+		SFE_LOG_INFO("engine thread initialized");
 	}
 
 	void Engine::initRender() {
 		if(!mWindow) {
-			SFE::LogsModule::Logger::LOG_FATAL(false, "Try to initialize render without context, forgot to call createWindow?");
+			SFE_LOG_FATAL(false, "Try to initialize render without context, forgot to call createWindow?");
 			return;
 		}
 
@@ -70,7 +75,72 @@ namespace SFE {
 
 		SFE::GLW::setDepthDistance(mWindow->getScreenData().far);
 
-		SFE::LogsModule::Logger::LOG_INFO("engine render initialized");
+		//callbacks are installed on main thread, frame is built on render thread
+		mImGui.init(mWindow->getWindow());
+
+		startRenderThread();
+
+		SFE_LOG_INFO("engine render initialized");
+	}
+
+	void Engine::startRenderThread() {
+		if (mRenderThread.joinable()) {
+			return;
+		}
+
+		ThreadPool::instance()->initLoadingContext();
+
+		//context can be current only in one thread
+		glfwMakeContextCurrent(nullptr);
+		mRenderThread = std::thread([this]() {
+			renderLoop();
+		});
+	}
+
+	void Engine::stopRenderThread() {
+		if (!mRenderThread.joinable()) {
+			return;
+		}
+
+		mFrameQueue.close();
+		mRenderThread.join();
+
+		mRenderThreadID = mMainThreadID;
+		if (mWindow) {
+			glfwMakeContextCurrent(mWindow->getWindow());
+		}
+	}
+
+	void Engine::renderLoop() {
+		mRenderThreadID = std::this_thread::get_id();
+		glfwMakeContextCurrent(mWindow->getWindow());
+
+		FramePacket frame;
+		while (mFrameQueue.pop(frame)) {
+			renderFrame(frame);
+		}
+
+		glfwMakeContextCurrent(nullptr);
+	}
+
+	void Engine::renderFrame(FramePacket& frame) {
+		FUNCTION_BENCHMARK;
+
+		const auto gpuProfiler = Debug::GpuProfiler::instance();
+		gpuProfiler->beginFrame();
+
+		mImGui.preDraw(frame.input);
+		mCore.syncUpdate(frame.dt);
+		markSynced(frame.index);
+
+		mCore.renderUpdate(frame.dt, std::move(frame.renderData));
+		mImGui.draw();
+
+		gpuProfiler->endFrame();
+
+		gpuProfiler->beginSwap();
+		getWindow()->swapBuffers();
+		gpuProfiler->endSwap();
 	}
 
 
@@ -91,14 +161,40 @@ namespace SFE {
 		}
 		
 		updateDelta();
-		
-		mCore.update(mDeltaTime);
-	
+
 		glfwPollEvents();
 
-		getWindow()->swapBuffers();
+		mCore.update(mDeltaTime);
 
-		fpsSync(maxFPS);
+		FramePacket frame = { mFrameIndex++, mDeltaTime, mImGui.takeInput(mDeltaTime), mCore.extractRenderData() };
+		if (mRenderThread.joinable()) {
+			//blocks while render thread is busy with previous frames
+			const auto index = frame.index;
+			if (mFrameQueue.push(std::move(frame))) {
+				waitSynced(index);
+			}
+		}
+		else {
+			renderFrame(frame);
+		}
+
+		mFrameLimiter.setRate(maxFPS);
+		mFrameLimiter.wait();
+	}
+
+	void Engine::waitSynced(uint64_t frameIndex) {
+		FUNCTION_BENCHMARK;
+
+		auto lock = std::unique_lock(mSyncMutex);
+		mSyncCondition.wait(lock, [this, frameIndex] { return mSyncedFrames > frameIndex; });
+	}
+
+	void Engine::markSynced(uint64_t frameIndex) {
+		{
+			auto lock = std::unique_lock(mSyncMutex);
+			mSyncedFrames = frameIndex + 1;
+		}
+		mSyncCondition.notify_all();
 	}
 
 	float Engine::getDeltaTime() const {
@@ -109,13 +205,23 @@ namespace SFE {
 		return mFPS;
 	}
 
+	CoreModule::FrameTimeStats Engine::getFrameTimeStats() const {
+		return mFrameTimes.getStats(maxFPS > 0 ? 1'000'000'000 / maxFPS : 0);
+	}
+
 	void Engine::updateDelta() {
-		const auto currentFrame = static_cast<float>(glfwGetTime());
-		mDeltaTime = currentFrame - mLastFrame;
+		const auto currentFrame = CoreModule::monotonicNs();
+		const auto deltaNs = mLastFrame ? currentFrame - mLastFrame : 0;
 		mLastFrame = currentFrame;
+		if (deltaNs) {
+			mFrameTimes.add(deltaNs);
+		}
+
+		const auto delta = static_cast<float>(static_cast<double>(deltaNs) / 1'000'000'000.0);
+		mDeltaTime = delta;
 
 		mFramesCounter++;
-		mFramesTimer += mDeltaTime;
+		mFramesTimer += delta;
 		if (mFramesTimer >= 1.f) {
 			mFPS = mFramesCounter;
 			mFramesCounter = 0;
@@ -145,13 +251,13 @@ namespace SFE {
 		return mMainThreadID == std::this_thread::get_id();
 	}
 
-	Engine::~Engine() {
-		destroyWindow();
+	bool Engine::isRenderThread() {
+		return mRenderThreadID.load(std::memory_order_relaxed) == std::this_thread::get_id();
 	}
 
-	void Engine::fpsSync(int fps) const {
-		if (mDeltaTime < 1.f / fps) {
-			std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int>((1.f / fps - mDeltaTime) * 1000.f * 1000.f)));
-		}
+	Engine::~Engine() {
+		stopRenderThread();
+		mImGui.destroyContext();
+		destroyWindow();
 	}
 }
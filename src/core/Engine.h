@@ -1,10 +1,17 @@
 ﻿#pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 #include "Core.h"
+#include "FramePacing.h"
 #include "InputHandler.h"
 #include "containersModule/Singleton.h"
+#include "debugModule/imguiDecorator.h"
+#include "multithreading/BoundedQueue.h"
 
 class Camera;
 
@@ -25,11 +32,18 @@ namespace SFE {
 		float getDeltaTime() const;
 		int getFPS() const;
 
+		//frame times of simulation thread, jitter is calculated against maxFPS
+		CoreModule::FrameTimeStats getFrameTimeStats() const;
+		const CoreModule::FrameTimeHistogram& getFrameTimeHistogram() const { return mFrameTimes; }
+		CoreModule::FrameLimiter& getFrameLimiter() { return mFrameLimiter; }
+
 		bool isAlive() const;
 
 		GLFWwindow* getMainWindow() const;
 		Render::Window* getWindow() const;
 		static bool isMainThread();
+		//thread which owns gl context, it is main thread until render thread is started
+		static bool isRenderThread();
 
 		int maxFPS = 60;
 
@@ -38,15 +52,44 @@ namespace SFE {
 		~Engine() override;
 
 	private:
-		void fpsSync(int fps) const;
+		struct FramePacket {
+			uint64_t index = 0;
+			float dt = 0.f;
+			Debug::ImGuiDecorator::Input input;
+			std::shared_ptr<SystemsModule::RenderSnapshot> renderData;
+		};
+
 		void updateDelta();
 		bool checkNeedClose();
 
-		float mLastFrame = 0.f;
-		float mDeltaTime = 0.f;
+		void startRenderThread();
+		void stopRenderThread();
+		void renderLoop();
+		void renderFrame(FramePacket& frame);
+		//simulation waits while render thread runs sync update of frame, debug windows and gizmos change simulation data there
+		void waitSynced(uint64_t frameIndex);
+		void markSynced(uint64_t frameIndex);
+
+		int64_t mLastFrame = 0;
+		std::atomic<float> mDeltaTime = 0.f;
 		float mFramesTimer = 0.f;
 		int mFramesCounter = 0;
-		int mFPS = 0;
+		std::atomic_int mFPS = 0;
+
+		CoreModule::FrameLimiter mFrameLimiter;
+		CoreModule::FrameTimeHistogram mFrameTimes;
+
+		//one frame waits in the queue while previous one is rendering, so simulation is never more than one frame ahead of render
+		constexpr static inline size_t MAX_QUEUED_FRAMES = 1;
+		BoundedQueue<FramePacket, MAX_QUEUED_FRAMES> mFrameQueue;
+		std::thread mRenderThread;
+		uint64_t mFrameIndex = 0;
+
+		std::mutex mSyncMutex;
+		std::condition_variable mSyncCondition;
+		uint64_t mSyncedFrames = 0;
+
+		Debug::ImGuiDecorator mImGui;
 
 
 		bool mAlive = false;
@@ -55,6 +98,7 @@ namespace SFE {
 		
 		Render::Window* mWindow = nullptr;
 		inline static std::thread::id mMainThreadID;
+		inline static std::atomic<std::thread::id> mRenderThreadID;
 	};
 }
 
@@ -19,7 +19,7 @@ namespace SFE {
 
 		inputFile.open(path.data());
 		if (!inputFile.is_open()) {
-			LogsModule::Logger::LOG_ERROR("FileSystem::FILE_NOT_SUCCESSFULLY_READ: %s", path);
+			SFE_LOG_ERROR("FileSystem::FILE_NOT_SUCCESSFULLY_READ: %s", path);
 			return false;
 		}
 
@@ -38,7 +38,7 @@ namespace SFE {
 
 		outputFile.open(path.data());
 		if (!outputFile.is_open()) {
-			LogsModule::Logger::LOG_ERROR("FileSystem::FILE_NOT_SUCCESSFULLY_WRITE: %s", path);
+			SFE_LOG_ERROR("FileSystem::FILE_NOT_SUCCESSFULLY_WRITE: %s", path);
 			return false;
 		}
 
@@ -48,11 +48,41 @@ namespace SFE {
 		return true;
 	}
 
+	bool FileSystem::readBinaryFile(std::string_view path, std::vector<uint8_t>& data) {
+		std::ifstream inputFile(path.data(), std::ios::binary | std::ios::ate);
+		if (!inputFile.is_open()) {
+			SFE_LOG_ERROR("FileSystem::FILE_NOT_SUCCESSFULLY_READ: %s", path.data());
+			return false;
+		}
+
+		const auto size = static_cast<size_t>(inputFile.tellg());
+		inputFile.seekg(0);
+		data.resize(size);
+		if (!inputFile.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size))) {
+			SFE_LOG_ERROR("FileSystem::FILE_NOT_SUCCESSFULLY_READ: %s", path.data());
+			data.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool FileSystem::writeBinaryFile(std::string_view path, const void* data, size_t size) {
+		std::ofstream outputFile(path.data(), std::ios::binary | std::ios::trunc);
+		if (!outputFile.is_open()) {
+			SFE_LOG_ERROR("FileSystem::FILE_NOT_SUCCESSFULLY_WRITE: %s", path.data());
+			return false;
+		}
+
+		outputFile.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		return static_cast<bool>(outputFile);
+	}
+
 	bool FileSystem::readJson(std::string_view path, Json::Value& root, bool withComments) {
 		std::ifstream ifs;
 		ifs.open(path.data());
 		if (!ifs.is_open()) {
-			LogsModule::Logger::LOG_ERROR("FileSystem::readJson can not open file: %s", path.data());
+			SFE_LOG_ERROR("FileSystem::readJson can not open file: %s", path.data());
 			return false;
 		}
 
@@ -65,7 +95,7 @@ namespace SFE {
 		ifs.close();
 
 		if (!success) {
-			LogsModule::Logger::LOG_ERROR("FileSystem::readJson %s", errs.c_str());
+			SFE_LOG_ERROR("FileSystem::readJson %s", errs.c_str());
 			return false;
 		}
 
@@ -76,7 +106,7 @@ namespace SFE {
 		std::ofstream ofs;
 		ofs.open(path.data());
 		if (!ofs.is_open()) {
-			LogsModule::Logger::LOG_ERROR("FileSystem::writeJson can not open file: %s", path.data());
+			SFE_LOG_ERROR("FileSystem::writeJson can not open file: %s", path.data());
 			return false;
 		}
 
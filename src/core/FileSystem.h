@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <vector>
 #include <json/value.h>
 
 namespace SFE {
@@ -9,6 +11,10 @@ namespace SFE {
 		static bool readFile(std::string_view path, std::string& file);
 		static bool writeFile(std::string_view path, std::string& file);
 
+		//whole file without text conversions
+		static bool readBinaryFile(std::string_view path, std::vector<uint8_t>& data);
+		static bool writeBinaryFile(std::string_view path, const void* data, size_t size);
+
 		static bool readJson(std::string_view path, Json::Value& root, bool withComments = false);
 		static bool writeJson(std::string_view path, const Json::Value& root);
 		static Json::Value readJson(std::string_view path, bool withComments = false);
@@ -0,0 +1,156 @@
+﻿#include "FramePacing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace SFE::CoreModule {
+	int64_t monotonicNs() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	FrameLimiter::FrameLimiter(double rate, int64_t spinWindowNs) {
+		setRate(rate);
+		setSpinWindow(spinWindowNs);
+	}
+
+	void FrameLimiter::setRate(double rate) {
+		if (rate == mRate) {
+			return;
+		}
+
+		mRate = rate;
+		mPeriod = rate > 0.0 ? static_cast<int64_t>(1'000'000'000.0 / rate) : 0;
+		reset();
+	}
+
+	void FrameLimiter::setSpinWindow(int64_t spinWindowNs) {
+		mSpinWindow = std::max<int64_t>(spinWindowNs, 0);
+		mAdaptiveSpin = mSpinWindow;
+	}
+
+	void FrameLimiter::reset() {
+		mNextDeadline = 0;
+	}
+
+	void FrameLimiter::wait() {
+		if (mPeriod <= 0) {
+			return;
+		}
+
+		auto now = monotonicNs();
+		if (mNextDeadline == 0) {
+			mNextDeadline = now + mPeriod;
+			return;
+		}
+
+		if (now >= mNextDeadline) {
+			//late, start new schedule from now instead of rushing several frames
+			mNextDeadline = now + mPeriod;
+			return;
+		}
+
+		const auto sleepUntil = mNextDeadline - mAdaptiveSpin;
+		if (now < sleepUntil) {
+			std::this_thread::sleep_for(std::chrono::nanoseconds(sleepUntil - now));
+			now = monotonicNs();
+
+			const auto overshoot = now - sleepUntil;
+			if (overshoot > mAdaptiveSpin) {
+				mAdaptiveSpin = std::min(overshoot + overshoot / 4, mPeriod / 2);
+			}
+			else {
+				//decay back to configured window
+				mAdaptiveSpin = std::max(mSpinWindow, mAdaptiveSpin - (mAdaptiveSpin - mSpinWindow) / 16);
+			}
+		}
+
+		while (now < mNextDeadline) {
+			std::this_thread::yield();
+			now = monotonicNs();
+		}
+
+		mNextDeadline += mPeriod;
+	}
+
+	FixedTimestep::FixedTimestep(double rate, uint32_t maxSteps) : mMaxSteps(std::max(maxSteps, 1u)) {
+		mStep = static_cast<int64_t>(1'000'000'000.0 / std::max(rate, 0.001));
+		mStepSeconds = static_cast<float>(static_cast<double>(mStep) / 1'000'000'000.0);
+	}
+
+	FrameTimeHistogram::FrameTimeHistogram(size_t capacity) {
+		mSamples.resize(std::max<size_t>(capacity, 1));
+	}
+
+	void FrameTimeHistogram::add(int64_t frameNs) {
+		std::unique_lock lock(mMutex);
+		mSamples[mHead] = frameNs;
+		mHead = (mHead + 1) % mSamples.size();
+		mCount = std::min(mCount + 1, mSamples.size());
+	}
+
+	void FrameTimeHistogram::reset() {
+		std::unique_lock lock(mMutex);
+		mHead = 0;
+		mCount = 0;
+	}
+
+	FrameTimeStats FrameTimeHistogram::getStats(int64_t targetNs) const {
+		std::vector<int64_t> samples;
+		{
+			std::unique_lock lock(mMutex);
+			samples.assign(mSamples.begin(), mSamples.begin() + static_cast<long long>(mCount));
+		}
+
+		FrameTimeStats stats;
+		stats.samples = samples.size();
+		if (samples.empty()) {
+			return stats;
+		}
+
+		constexpr double toMs = 1.0 / 1'000'000.0;
+		const auto percentile = [](std::vector<int64_t>& values, double p) {
+			const auto idx = std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())));
+			return values[idx];
+		};
+
+		double sum = 0.0;
+		for (auto sample : samples) {
+			sum += static_cast<double>(sample);
+		}
+		const auto avg = sum / static_cast<double>(samples.size());
+
+		std::ranges::sort(samples);
+		stats.avgMs = avg * toMs;
+		stats.p50Ms = static_cast<double>(percentile(samples, 0.5)) * toMs;
+		stats.p99Ms = static_cast<double>(percentile(samples, 0.99)) * toMs;
+		stats.maxMs = static_cast<double>(samples.back()) * toMs;
+
+		const auto target = targetNs > 0 ? targetNs : static_cast<int64_t>(avg);
+		for (auto& sample : samples) {
+			sample = std::abs(sample - target);
+		}
+		std::ranges::sort(samples);
+		stats.jitterP50Ms = static_cast<double>(percentile(samples, 0.5)) * toMs;
+		stats.jitterP99Ms = static_cast<double>(percentile(samples, 0.99)) * toMs;
+		stats.jitterMaxMs = static_cast<double>(samples.back()) * toMs;
+
+		return stats;
+	}
+
+	std::vector<uint32_t> FrameTimeHistogram::getBuckets(int64_t bucketNs, size_t bucketsCount) const {
+		std::vector<uint32_t> buckets(bucketsCount, 0);
+		if (!bucketsCount || bucketNs <= 0) {
+			return buckets;
+		}
+
+		std::unique_lock lock(mMutex);
+		for (size_t i = 0; i < mCount; i++) {
+			const auto idx = std::min(static_cast<size_t>(std::max<int64_t>(mSamples[i], 0) / bucketNs), bucketsCount - 1);
+			buckets[idx]++;
+		}
+
+		return buckets;
+	}
+}
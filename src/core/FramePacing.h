@@ -0,0 +1,108 @@
+﻿#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace SFE::CoreModule {
+	//steady clock in nanoseconds, never goes back and doesn't lose precision like float glfwGetTime
+	int64_t monotonicNs();
+
+	//waits until absolute deadline - sleeps most of the time and spins the last part, because os sleep overshoots by scheduler slice
+	//spin window grows automatically when the os oversleeps more than it, and slowly goes back to the configured value
+	class FrameLimiter {
+	public:
+		FrameLimiter(double rate = 60.0, int64_t spinWindowNs = 1'000'000);
+
+		//0 or less - no limit
+		void setRate(double rate);
+		double getRate() const { return mRate; }
+
+		void setSpinWindow(int64_t spinWindowNs);
+		int64_t getSpinWindow() const { return mSpinWindow; }
+		int64_t getAdaptiveSpinWindow() const { return mAdaptiveSpin; }
+
+		//blocks until the next frame deadline, if frame was late the schedule is restarted from now
+		void wait();
+		void reset();
+
+	private:
+		double mRate = 0.0;
+		int64_t mPeriod = 0;
+		int64_t mSpinWindow = 0;
+		int64_t mAdaptiveSpin = 0;
+		int64_t mNextDeadline = 0;
+	};
+
+	//accumulates real time and gives it back in equal steps, so simulation doesn't depend on how precise thread wake ups are
+	class FixedTimestep {
+	public:
+		FixedTimestep(double rate, uint32_t maxSteps = 4);
+
+		//calls step(dt) as many times as accumulated time allows, returns count of steps
+		//if simulation is too far behind, the rest is dropped instead of spiral of death
+		template<typename Step>
+		uint32_t advance(int64_t elapsedNs, Step&& step) {
+			mAccumulator += elapsedNs;
+
+			uint32_t steps = 0;
+			while (mAccumulator >= mStep && steps < mMaxSteps) {
+				step(mStepSeconds);
+				mAccumulator -= mStep;
+				steps++;
+			}
+
+			if (mAccumulator >= mStep) {
+				mDropped += mAccumulator / mStep;
+				mAccumulator %= mStep;
+			}
+
+			return steps;
+		}
+
+		//part of the step which is accumulated but not simulated yet, for interpolation
+		float getAlpha() const { return static_cast<float>(mAccumulator) / static_cast<float>(mStep); }
+		int64_t getStepNs() const { return mStep; }
+		float getStepSeconds() const { return mStepSeconds; }
+		int64_t getDroppedSteps() const { return mDropped; }
+
+	private:
+		int64_t mStep = 0;
+		float mStepSeconds = 0.f;
+		int64_t mAccumulator = 0;
+		int64_t mDropped = 0;
+		uint32_t mMaxSteps = 4;
+	};
+
+	struct FrameTimeStats {
+		size_t samples = 0;
+		double avgMs = 0.0;
+		double p50Ms = 0.0;
+		double p99Ms = 0.0;
+		double maxMs = 0.0;
+		//deviation from target frame time
+		double jitterP50Ms = 0.0;
+		double jitterP99Ms = 0.0;
+		double jitterMaxMs = 0.0;
+	};
+
+	//last frame times, can be written and read from different threads
+	class FrameTimeHistogram {
+	public:
+		FrameTimeHistogram(size_t capacity = 1024);
+
+		void add(int64_t frameNs);
+		void reset();
+
+		//targetNs - expected frame time for jitter calculation, 0 - average is used
+		FrameTimeStats getStats(int64_t targetNs = 0) const;
+
+		//count of samples per bucketNs wide bucket, starting from zero, last bucket contains everything above
+		std::vector<uint32_t> getBuckets(int64_t bucketNs, size_t bucketsCount) const;
+
+	private:
+		mutable std::mutex mMutex;
+		std::vector<int64_t> mSamples;
+		size_t mHead = 0;
+		size_t mCount = 0;
+	};
+}
@@ -0,0 +1,25 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace SFE {
+	//fnv-1a, 64 bit, results are stored in cache files, so it must not change between runs and platforms
+	constexpr uint64_t FNV_BASIS = 14695981039346656037ull;
+	constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = FNV_BASIS) {
+		const auto bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * FNV_PRIME;
+		}
+		return hash;
+	}
+
+	//length is hashed too, so borders of strings are a part of hash
+	inline uint64_t hashString(std::string_view value, uint64_t hash = FNV_BASIS) {
+		const auto length = value.size();
+		hash = hashBytes(&length, sizeof(length), hash);
+		return hashBytes(value.data(), value.size(), hash);
+	}
+}
@@ -0,0 +1,264 @@
+﻿#include "Prefab.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "ECSHandler.h"
+#include "Engine.h"
+#include "FramePacing.h"
+#include "assetsModule/modelModule/MeshVaoRegistry.h"
+#include "componentsModule/DebugDataComponent.h"
+#include "componentsModule/IsDrawableComponent.h"
+#include "componentsModule/ModelComponent.h"
+#include "componentsModule/OcTreeComponent.h"
+#include "componentsModule/TransformComponent.h"
+#include "componentsModule/TreeComponent.h"
+#include "logsModule/logger.h"
+#include "multithreading/ThreadPool.h"
+#include "propertiesModule/PropertiesSystem.h"
+#include "systemsModule/SystemManager.h"
+#include "systemsModule/TasksManager.h"
+#include "systemsModule/systems/OcTreeSystem.h"
+#include "systemsModule/systems/RenderSystem.h"
+
+namespace SFE::CoreModule {
+	Prefab::Prefab(AssetsModule::Model* model) : mModel(model) {
+		if (!mModel) {
+			return;
+		}
+
+		//mesh graph is filled once, instances copy it instead of going through extractor for every node
+		const auto& meshTree = mModel->getMeshTree();
+		const auto lods = mModel->getLODs();
+		mHasMesh = lods && !lods->empty() && !lods->front().meshes.empty();
+		if (mHasMesh) {
+			mMesh.meshGraph.fill<MeshObject3D>(meshTree, [](const MeshObject3D& meshObj) {
+				return ComponentsModule::MeshComponent::MeshData {
+					MeshVaoRegistry::instance()->get(const_cast<Mesh3D*>(&meshObj.mesh)).handle,
+					static_cast<int>(meshObj.mesh.vertices.size()),
+					static_cast<int>(meshObj.mesh.indices.size()),
+					meshObj.aabb,
+					meshObj.uvDensity
+				};
+			});
+
+			const auto& materialTextures = lods->front().meshes[0]->material.materialTextures;
+			mHasMaterial = !materialTextures.empty();
+			if (mHasMaterial) {
+				mMesh.meshModel = mModel;
+				for (auto& mat : materialTextures) {
+					mMaterial.materials.addMaterial({ mat.second.uniformSlot, mat.second.texture->mId, mat.second.texture->mType });
+				}
+			}
+
+			mHasArmature = !mModel->getArmature().bones.empty();
+			if (mHasArmature) {
+				mArmature.armature = mModel->getArmature();
+				std::ranges::copy(mModel->getDefaultBoneMatrices(), mBones.boneMatrices.begin());
+			}
+		}
+
+		mHasAnimation = !mModel->getAnimations().empty();
+	}
+
+	std::vector<ecss::EntityId> Prefab::instantiate(std::span<const Placement> placements) const {
+		std::vector<ecss::EntityId> entities;
+		instantiate(placements, entities);
+		return entities;
+	}
+
+	void Prefab::instantiate(std::span<const Placement> placements, std::vector<ecss::EntityId>& entities) const {
+		if (placements.empty()) {
+			return;
+		}
+
+		auto& registry = ECSHandler::registry();
+		std::vector<ecss::EntityId> created;
+		created.reserve(placements.size());
+		for (size_t i = 0; i < placements.size(); i++) {
+			created.push_back(registry.takeEntity());
+		}
+
+		//component containers are filled one by one, so every container grows once and its sectors are written in order
+		for (size_t i = 0; i < created.size(); i++) {
+			const auto& placement = placements[i];
+			registry.addComponent<TransformComponent>(created[i], created[i], placement.pos, placement.rotate, placement.scale);
+		}
+		for (const auto entity : created) {
+			registry.addComponent<ComponentsModule::AABBComponent>(entity);
+		}
+		for (const auto entity : created) {
+			registry.addComponent<OcTreeComponent>(entity);
+		}
+
+		if (mModel) {
+			for (const auto entity : created) {
+				auto modelComp = registry.addComponent<ModelComponent>(entity, entity);
+				modelComp->mPath = mModel->assetPath;
+				modelComp->boneMatrices = mModel->getDefaultBoneMatrices();
+				modelComp->armature = mModel->getArmature();
+				modelComp->setModel(mModel->getLODs());
+			}
+			for (const auto entity : created) {
+				registry.addComponent<IsDrawableComponent>(entity);
+			}
+		}
+
+		if (mHasMesh) {
+			for (const auto entity : created) {
+				registry.addComponent<ComponentsModule::MeshComponent>(entity, mMesh);
+			}
+		}
+
+		if (mHasMaterial) {
+			for (const auto entity : created) {
+				registry.addComponent<ComponentsModule::MaterialComponent>(entity, mMaterial);
+			}
+		}
+
+		if (mHasArmature) {
+			for (const auto entity : created) {
+				registry.addComponent<ComponentsModule::ArmatureComponent>(entity, mArmature);
+			}
+			for (const auto entity : created) {
+				registry.addComponent<ComponentsModule::ArmatureBonesComponent>(entity, mBones);
+			}
+		}
+
+		if (mHasAnimation) {
+			for (size_t i = 0; i < created.size(); i++) {
+				auto animComp = registry.addComponent<ComponentsModule::AnimationComponent>(created[i]);
+				animComp->mCurrentAnimation = &mModel->getAnimations()[0];
+				animComp->mCurrentTime = placements[i].animationTime;
+			}
+		}
+
+		const auto tasks = SystemsModule::TasksManager::instance();
+		tasks->notify(created, SystemsModule::TRANSFORM_UPDATE);
+		if (mHasMesh) {
+			tasks->notify(created, SystemsModule::MESH_UPDATED);
+		}
+		if (mHasMaterial) {
+			tasks->notify(created, SystemsModule::MATERIAL_UPDATED);
+		}
+		if (mHasArmature) {
+			tasks->notify(created, SystemsModule::ARMATURE_UPDATED);
+		}
+
+		entities.insert(entities.end(), created.begin(), created.end());
+	}
+
+	Prefab::BenchmarkResult Prefab::benchmark(AssetsModule::Model* model, size_t count) {
+		BenchmarkResult result;
+		result.instances = count;
+
+		const auto side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+		std::vector<Placement> placements(count);
+		for (size_t i = 0; i < count; i++) {
+			placements[i].pos = { static_cast<float>(i % side) * 100.f, static_cast<float>(i / side % side) * 100.f, static_cast<float>(i / (side * side)) * 100.f };
+		}
+
+		//building of prefab is part of the cost, it is done once per spawn request
+		auto start = monotonicNs();
+		const Prefab prefab(model);
+		auto entities = prefab.instantiate(placements);
+		result.instantiateMs = static_cast<double>(monotonicNs() - start) / 1'000'000.0;
+
+		//systems only queue notified entities, transforms are processed on next update and render copies dirty components for two extracts,
+		//sync tasks are executed once per rendered frame, so instances are destroyed after all of them
+		constexpr size_t SETTLE_FRAMES = 3;
+		for (size_t i = 0; i < SETTLE_FRAMES; i++) {
+			const auto frame = ThreadPool::instance()->addTask<WorkerType::SYNC>([] {});
+			while (frame.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+				if (!Engine::instance()->isAlive()) {
+					return result;
+				}
+			}
+		}
+
+		start = monotonicNs();
+		destroy(entities);
+		result.destroyMs = static_cast<double>(monotonicNs() - start) / 1'000'000.0;
+
+		SFE_LOG_INFO("Prefab::benchmark %zu instances of %s, instantiate: %.1f ms, destroy: %.1f ms", count, model ? model->assetPath.c_str() : "empty prefab", result.instantiateMs, result.destroyMs);
+		return result;
+	}
+
+	size_t Prefab::getBenchmarkCount() {
+		const auto value = std::getenv("SFE_PREFAB_BENCHMARK");
+		return value ? static_cast<size_t>(std::strtoull(value, nullptr, 10)) : 0;
+	}
+
+	void Prefab::destroy(std::vector<ecss::EntityId>& entities) {
+		const auto octrees = ECSHandler::getSystem<SystemsModule::OcTreeSystem>();
+		for (const auto entity : entities) {
+			const auto octreeComp = ECSHandler::registry().getComponent<OcTreeComponent>(entity);
+			if (!octrees || !octreeComp) {
+				continue;
+			}
+
+			for (const auto& octreePos : octreeComp->mParentOcTrees) {
+				if (const auto octree = octrees->getOctree(octreePos)) {
+					auto lock = octree->writeLock();
+					octree->erase(entity);
+				}
+			}
+		}
+
+		ECSHandler::registry().destroyEntities(entities);
+	}
+
+	void Prefab::fillTree(ecss::EntityId entity, const Json::Value& properties) {
+		if (!properties.isObject()) {
+			return;
+		}
+
+		if (properties.isMember("id")) {
+			auto debugData = ECSHandler::registry().addComponent<DebugDataComponent>(entity);
+			debugData->stringId = properties["id"].asString();
+			SystemsModule::TasksManager::instance()->notify({ entity, SystemsModule::NODE_UPDATED });
+		}
+		//todo this all is dirty, need to refactor and make common logic
+		ECSHandler::registry().addComponent<ComponentsModule::AABBComponent>(entity);
+		ECSHandler::registry().addComponent<OcTreeComponent>(entity);
+		PropertiesModule::PropertiesSystem::applyProperties(entity, properties);
+		ECSHandler::registry().addComponent<IsDrawableComponent>(entity);
+		auto modelComp = ECSHandler::registry().getComponent<ModelComponent>(entity);
+		if (modelComp && !modelComp->getModel().meshes.empty()) {
+			auto meshComp = ECSHandler::registry().addComponent<MeshComponent>(entity);
+			meshComp->meshGraph.root().value = { MeshVaoRegistry::instance()->get(&modelComp->getModel().meshes[0]->mesh).handle, static_cast<int>(modelComp->getModel().meshes[0]->mesh.vertices.size()), static_cast<int>(modelComp->getModel().meshes[0]->mesh.indices.size()), modelComp->getModel().meshes[0]->aabb, modelComp->getModel().meshes[0]->uvDensity };
+			if (auto renderSys = ECSHandler::systemManager().getSystem<SFE::SystemsModule::RenderSystem>()) {
+				renderSys->markDirty<MeshComponent>(entity);
+			}
+
+			auto materialComp = ECSHandler::registry().addComponent<MaterialComponent>(entity);
+			for (auto& mat : modelComp->getModel().meshes[0]->material.materialTextures) {
+				materialComp->materials.addMaterial({ mat.second.uniformSlot, mat.second.texture->mId, mat.second.texture->mType});
+			}
+			if (auto renderSys = ECSHandler::systemManager().getSystem<SFE::SystemsModule::RenderSystem>()) {
+				renderSys->markDirty<MaterialComponent>(entity);
+			}
+
+			auto armatureComp = ECSHandler::registry().addComponent<ComponentsModule::ArmatureComponent>(entity);
+			auto armatureBonesComp = ECSHandler::registry().addComponent<ComponentsModule::ArmatureBonesComponent>(entity);
+			
+			armatureComp->armature = modelComp->armature;
+
+			std::ranges::copy(modelComp->boneMatrices, armatureBonesComp->boneMatrices.begin());
+			if (auto renderSys = ECSHandler::systemManager().getSystem<SFE::SystemsModule::RenderSystem>()) {
+				renderSys->markDirty<SFE::ComponentsModule::ArmatureComponent>(entity);
+			}
+		}
+		
+		auto treeComp = ECSHandler::registry().addComponent<TreeComponent>(entity, entity);
+
+		if (properties.isMember("Children") && properties["Children"].isArray()) {
+			for (auto element : properties["Children"]) {
+				auto child = ECSHandler::registry().takeEntity();				
+				fillTree(child, element);
+				treeComp->addChildEntity(child);
+			}
+		}
+	}
+}
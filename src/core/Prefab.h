@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <span>
+#include <vector>
+#include <json/value.h>
+
+#include "componentsModule/ArmatureComponent.h"
+#include "componentsModule/MaterialComponent.h"
+#include "componentsModule/MeshComponent.h"
+#include "ecss/Types.h"
+#include "mathModule/Forward.h"
+
+namespace SFE::CoreModule {
+	//components of model instance are built once from model, instances are created in bulk:
+	//entities are taken together, every component type is added for all of them in one pass and every system is notified once
+	class Prefab {
+	public:
+		struct Placement {
+			Math::Vec3 pos = {};
+			Math::Vec3 rotate = {};
+			Math::Vec3 scale = { 1.f };
+			float animationTime = 0.f;
+		};
+
+		struct BenchmarkResult {
+			size_t instances = 0;
+			double instantiateMs = 0.0;
+			double destroyMs = 0.0;
+		};
+
+		explicit Prefab(AssetsModule::Model* model);
+
+		std::vector<ecss::EntityId> instantiate(std::span<const Placement> placements) const;
+		//appends entities, so caller can instantiate in slices
+		void instantiate(std::span<const Placement> placements, std::vector<ecss::EntityId>& entities) const;
+
+		AssetsModule::Model* getModel() const { return mModel; }
+
+		//instances are placed on grid and destroyed when systems handled their notifications, waits for frames, so it is called from worker
+		static BenchmarkResult benchmark(AssetsModule::Model* model, size_t count);
+		//instances count of benchmark on start, it is read from SFE_PREFAB_BENCHMARK environment variable, 0 if it isn't set
+		static size_t getBenchmarkCount();
+
+		//entities know their octrees, so only they are erased instead of walking whole octrees
+		static void destroy(std::vector<ecss::EntityId>& entities);
+
+		//old per entity path of json scenes, components are added and systems are notified for every node separately
+		static void fillTree(ecss::EntityId entity, const Json::Value& properties);
+
+	private:
+		AssetsModule::Model* mModel = nullptr;
+
+		bool mHasMesh = false;
+		bool mHasMaterial = false;
+		bool mHasArmature = false;
+		bool mHasAnimation = false;
+
+		ComponentsModule::MeshComponent mMesh;
+		ComponentsModule::MaterialComponent mMaterial;
+		ComponentsModule::ArmatureComponent mArmature;
+		ComponentsModule::ArmatureBonesComponent mBones;
+	};
+}
@@ -1,10 +1,15 @@
 ﻿#include "Engine.h"
+#include "logsModule/LogSinks.h"
+#include "logsModule/logger.h"
 
 #if defined(VLD)
 #include "vld.h"
 #endif
 
 int main() {
+	SFE::LogsModule::Logger::addSink(new SFE::LogsModule::StdoutSink());
+	SFE::LogsModule::Logger::addSink(new SFE::LogsModule::FileSink("engine.log"));
+
 	if (!glfwInit()) {
 		return -1;
 	}
@@ -22,5 +27,7 @@ int main() {
 	SFE::Engine::terminate();
 	glfwTerminate();
 
+	SFE::LogsModule::Logger::shutdown();
+
 	return 0;
 }
@@ -83,13 +83,13 @@ namespace SFE::Debug {
 				time.delta = delta;
 
 				if (log) {
-					LogsModule::Logger::LOG_INFO("%s : delta - < %d s: %d: ms: %d mu: %d ns >", id.c_str(), time.seconds, time.millisecond, time.microsecond, time.nanosecond);
+					SFE_LOG_INFO("%s : delta - < %d s: %d: ms: %d mu: %d ns >", id.c_str(), time.seconds, time.millisecond, time.microsecond, time.nanosecond);
 				}
 
 				return time;
 			}
 			
-			LogsModule::Logger::LOG_ERROR("\"%s\" benchmark was not started", id.c_str());
+			SFE_LOG_ERROR("\"%s\" benchmark was not started", id.c_str());
 
 			return {};
 		}
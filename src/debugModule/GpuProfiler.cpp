@@ -0,0 +1,220 @@
+﻿#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <mutex>
+
+#include "imgui.h"
+#include "core/Engine.h"
+
+namespace SFE::Debug {
+	namespace {
+		Benchmark::Time toTime(uint64_t nanoseconds) {
+			const auto delta = static_cast<long long>(nanoseconds);
+
+			Benchmark::Time time;
+			time.seconds = delta / 1'000'000'000;
+			time.millisecond = delta / 1'000'000 % 1'000;
+			time.microsecond = delta / 1'000 % 1'000;
+			time.nanosecond = delta % 1'000;
+			time.delta = delta;
+
+			return time;
+		}
+
+		void pushMeasure(BenchmarkSystem::MeasureData& data, uint64_t nanoseconds) {
+			data.measurements.push_back(toTime(nanoseconds));
+			data.plotData.push_back(static_cast<float>(nanoseconds));
+			if (data.measurements.size() > 100) {
+				data.measurements.erase(data.measurements.begin());
+				data.plotData.erase(data.plotData.begin());
+			}
+		}
+
+		float toMs(std::chrono::steady_clock::duration duration) {
+			return std::chrono::duration<float, std::milli>(duration).count();
+		}
+	}
+
+	void GpuProfiler::beginFrame() {
+		if (!mEnabled || mFrameStarted) {
+			return;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		if (mPool.getFrameIndex() > 0) {
+			cpuFrame(mCurrentFrame).frame = toMs(now - mFrameStart);
+		}
+
+		mPool.init();
+		mCurrentFrame = mPool.getFrameIndex();
+		cpuFrame(mCurrentFrame) = { mCurrentFrame };
+
+		mFrameStart = now;
+		mPool.beginFrame();
+		mFrameStarted = true;
+	}
+
+	void GpuProfiler::endFrame() {
+		if (!mFrameStarted) {
+			return;
+		}
+
+		cpuFrame(mCurrentFrame).cpuSubmit = toMs(std::chrono::steady_clock::now() - mFrameStart);
+		mPool.endFrame();
+		mFrameStarted = false;
+
+		collectResults();
+	}
+
+	void GpuProfiler::beginSwap() {
+		mSwapStart = std::chrono::steady_clock::now();
+	}
+
+	void GpuProfiler::endSwap() {
+		if (!mEnabled) {
+			return;
+		}
+
+		cpuFrame(mCurrentFrame).swapWait = toMs(std::chrono::steady_clock::now() - mSwapStart);
+	}
+
+	size_t GpuProfiler::beginScope(const std::string& name) {
+		if (!mFrameStarted) {
+			return Pool::INVALID_SCOPE;
+		}
+
+		return mPool.beginScope(name);
+	}
+
+	void GpuProfiler::endScope(size_t scope) {
+		if (!mFrameStarted) {
+			return;
+		}
+
+		mPool.endScope(scope);
+	}
+
+	void GpuProfiler::setEnabled(bool enabled) {
+		if (mEnabled == enabled) {
+			return;
+		}
+
+		if (!enabled) {
+			endFrame();
+			mPool.release();
+		}
+		mEnabled = enabled;
+	}
+
+	void GpuProfiler::collectResults() {
+		std::vector<FramePacing> resolved;
+		std::vector<Pool::FrameResult> frames;
+		mPool.consume([&frames](Pool::FrameResult& frame) {
+			frames.push_back(std::move(frame));
+		});
+
+		if (frames.empty()) {
+			return;
+		}
+
+		{
+			auto benchmark = BenchmarkSystem::instance();
+			std::unique_lock lock(benchmark->mtx);
+			auto& gpu = benchmark->measurements["GPU"];
+			auto& pacing = benchmark->measurements["FramePacing"];
+
+			for (auto& frame : frames) {
+				auto& cpu = cpuFrame(frame.frameIndex);
+				if (cpu.frameIndex != frame.frameIndex) {
+					continue; //cpu part was already overwritten, it can happen only after long pause
+				}
+
+				cpu.gpu = static_cast<float>(frame.duration()) / 1'000'000.f;
+
+				pushMeasure(gpu.second, frame.duration());
+				for (auto& scope : frame.scopes) {
+					pushMeasure(gpu.first["[" + scope.name + "]"], scope.duration());
+				}
+
+				pushMeasure(pacing.first["[cpu submit]"], static_cast<uint64_t>(cpu.cpuSubmit * 1'000'000.f));
+				pushMeasure(pacing.first["[gpu]"], frame.duration());
+				pushMeasure(pacing.first["[swap wait]"], static_cast<uint64_t>(cpu.swapWait * 1'000'000.f));
+				pushMeasure(pacing.second, static_cast<uint64_t>(cpu.frame * 1'000'000.f));
+
+				resolved.push_back(cpu);
+			}
+		}
+
+		mLastPasses = std::move(frames.back().scopes);
+		for (auto& frame : resolved) {
+			mHistory.push_back(frame);
+		}
+		if (mHistory.size() > HISTORY_SIZE) {
+			mHistory.erase(mHistory.begin(), mHistory.begin() + static_cast<long long>(mHistory.size() - HISTORY_SIZE));
+		}
+	}
+
+	void GpuProfiler::drawDebugWindow() {
+		if (!mDebugWindow) {
+			return;
+		}
+
+		if (ImGui::Begin("Frame pacing", &mDebugWindow)) {
+			bool enabled = mEnabled;
+			if (ImGui::Checkbox("enabled", &enabled)) {
+				setEnabled(enabled);
+			}
+			ImGui::Text("gpu latency: %zu frames, dropped: %llu", Pool::latency(), static_cast<unsigned long long>(mPool.getDroppedFrames()));
+
+			if (!mHistory.empty()) {
+				std::vector<float> cpuSubmit, gpu, swapWait, frame;
+				float maxValue = 0.f;
+				for (const auto& pacing : mHistory) {
+					cpuSubmit.push_back(pacing.cpuSubmit);
+					gpu.push_back(pacing.gpu);
+					swapWait.push_back(pacing.swapWait);
+					frame.push_back(pacing.frame);
+					maxValue = std::max({ maxValue, pacing.cpuSubmit, pacing.gpu, pacing.swapWait, pacing.frame });
+				}
+
+				const auto& last = mHistory.back();
+				const ImVec2 plotSize = { 0.f, 50.f };
+				ImGui::PlotLines("frame", frame.data(), static_cast<int>(frame.size()), 0, std::to_string(last.frame).c_str(), 0.f, maxValue, plotSize);
+				ImGui::PlotLines("cpu submit", cpuSubmit.data(), static_cast<int>(cpuSubmit.size()), 0, std::to_string(last.cpuSubmit).c_str(), 0.f, maxValue, plotSize);
+				ImGui::PlotLines("gpu", gpu.data(), static_cast<int>(gpu.size()), 0, std::to_string(last.gpu).c_str(), 0.f, maxValue, plotSize);
+				ImGui::PlotLines("swap wait", swapWait.data(), static_cast<int>(swapWait.size()), 0, std::to_string(last.swapWait).c_str(), 0.f, maxValue, plotSize);
+			}
+
+			const auto engine = Engine::instance();
+			const auto stats = engine->getFrameTimeStats();
+			if (stats.samples) {
+				ImGui::Text("frame ms p50: %.3f p99: %.3f max: %.3f", stats.p50Ms, stats.p99Ms, stats.maxMs);
+				ImGui::Text("jitter ms p50: %.3f p99: %.3f max: %.3f", stats.jitterP50Ms, stats.jitterP99Ms, stats.jitterMaxMs);
+				ImGui::Text("limiter spin window: %.3f ms", static_cast<double>(engine->getFrameLimiter().getAdaptiveSpinWindow()) / 1'000'000.0);
+
+				//0.25 ms buckets up to 50 ms
+				std::vector<float> histogram;
+				for (auto count : engine->getFrameTimeHistogram().getBuckets(250'000, 200)) {
+					histogram.push_back(static_cast<float>(count));
+				}
+				ImGui::PlotHistogram("frame times", histogram.data(), static_cast<int>(histogram.size()), 0, "0..50 ms", 0.f, FLT_MAX, { 0.f, 60.f });
+			}
+
+			if (!mLastPasses.empty() && ImGui::BeginTable("gpu passes", 2)) {
+				ImGui::TableSetupColumn("pass");
+				ImGui::TableSetupColumn("gpu ms");
+				ImGui::TableHeadersRow();
+				for (const auto& pass : mLastPasses) {
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(pass.name.c_str());
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", static_cast<float>(pass.duration()) / 1'000'000.f);
+				}
+				ImGui::EndTable();
+			}
+		}
+		ImGui::End();
+	}
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "TimerQueryPool.h"
+#include "containersModule/Singleton.h"
+#include "glWrapper/Query.h"
+
+#if !BENCHMARK_ENABLED
+#define GPU_BENCHMARK_NAMED_STR(name)
+#else
+#define GPU_BENCHMARK_NAMED_STR(name) SFE::Debug::GpuScope MAKE_UNIQUE(gpuScopeObj) = SFE::Debug::GpuScope(name);
+#endif
+
+namespace SFE::Debug {
+	//all values in ms
+	struct FramePacing {
+		uint64_t frameIndex = 0;
+		float cpuSubmit = 0.f; //from frame start till the last gl command of the frame
+		float gpu = 0.f;       //from first till last gpu timestamp of the frame
+		float swapWait = 0.f;  //time inside swapBuffers
+		float frame = 0.f;     //full cpu frame
+	};
+
+	//gpu side of the profiler, results are merged into BenchmarkSystem under "GPU" and "FramePacing" names with few frames delay
+	//should be used only from the thread which owns gl context
+	class GpuProfiler : public Singleton<GpuProfiler> {
+		friend Singleton;
+	public:
+		using Pool = TimerQueryPool<GLW::TimestampQueryBackend, 4, 64>;
+
+		void beginFrame();
+		//call after the last gl command of the frame, before swapBuffers
+		void endFrame();
+		void beginSwap();
+		void endSwap();
+
+		size_t beginScope(const std::string& name);
+		void endScope(size_t scope);
+
+		void setEnabled(bool enabled);
+		bool isEnabled() const { return mEnabled; }
+
+		const std::vector<FramePacing>& getFramePacing() const { return mHistory; }
+		const std::vector<Pool::ScopeResult>& getLastPasses() const { return mLastPasses; }
+
+		void drawDebugWindow();
+		bool mDebugWindow = false;
+
+	protected:
+		GpuProfiler() = default;
+		~GpuProfiler() override = default;
+
+	private:
+		void collectResults();
+		FramePacing& cpuFrame(uint64_t frameIndex) { return mCpuFrames[frameIndex % mCpuFrames.size()]; }
+
+		Pool mPool;
+
+		bool mEnabled = true;
+		bool mFrameStarted = false;
+		uint64_t mCurrentFrame = 0;
+
+		std::chrono::steady_clock::time_point mFrameStart;
+		std::chrono::steady_clock::time_point mSwapStart;
+
+		//cpu timings wait here until gpu part of the same frame is resolved
+		std::array<FramePacing, 16> mCpuFrames;
+		std::vector<FramePacing> mHistory;
+		std::vector<Pool::ScopeResult> mLastPasses;
+
+		constexpr static size_t HISTORY_SIZE = 100;
+	};
+
+	struct GpuScope final {
+		GpuScope(const std::string& name) : scope(GpuProfiler::instance()->beginScope(name)) {}
+		~GpuScope() { GpuProfiler::instance()->endScope(scope); }
+
+		size_t scope;
+	};
+}
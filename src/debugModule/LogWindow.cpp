@@ -0,0 +1,43 @@
+﻿#include "LogWindow.h"
+
+#include "imgui.h"
+#include "logsModule/LogSinks.h"
+
+namespace SFE::Debug {
+	void LogWindow::init() {
+		//logger owns the sink
+		mSink = new LogsModule::RingBufferSink();
+		LogsModule::Logger::addSink(mSink);
+	}
+
+	LogWindow::~LogWindow() {
+		LogsModule::Logger::removeSink(mSink);
+	}
+
+	void LogWindow::drawDebugWindow() {
+		if (!mDebugWindow) {
+			return;
+		}
+
+		if (ImGui::Begin("Log", &mDebugWindow)) {
+			using LogsModule::Logger;
+			ImGui::Text("queue: %zu, dropped: %zu, suppressed: %zu", Logger::getQueueSize(), Logger::getDroppedCount(), Logger::getSuppressedCount());
+
+			if (ImGui::Button("benchmark")) {
+				mBenchmark = Logger::benchmark();
+				mBenchmarked = true;
+			}
+			if (mBenchmarked) {
+				ImGui::Text("log call: avg %.1f ns, p50 %.1f ns, p99 %.1f ns, max %.1f ns, dropped %zu", mBenchmark.avgNs, mBenchmark.p50Ns, mBenchmark.p99Ns, mBenchmark.maxNs, mBenchmark.dropped);
+			}
+
+			ImGui::Separator();
+			char line[LogsModule::LOG_MESSAGE_SIZE + 128];
+			for (const auto& record : mSink->getRecords(SHOWN_RECORDS)) {
+				LogsModule::formatRecord(record, line, sizeof(line));
+				ImGui::TextUnformatted(line);
+			}
+		}
+		ImGui::End();
+	}
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+#include "containersModule/Singleton.h"
+#include "logsModule/logger.h"
+
+namespace SFE::LogsModule {
+	class RingBufferSink;
+}
+
+namespace SFE::Debug {
+	//last records of the logger and its counters, records are kept from the moment window is created
+	class LogWindow : public Singleton<LogWindow> {
+		friend Singleton;
+	public:
+		void init() override;
+		void drawDebugWindow();
+
+		bool mDebugWindow = true;
+
+	protected:
+		LogWindow() = default;
+		~LogWindow() override;
+
+	private:
+		constexpr static size_t SHOWN_RECORDS = 64;
+
+		LogsModule::RingBufferSink* mSink = nullptr;
+		LogsModule::Logger::BenchmarkResult mBenchmark;
+		bool mBenchmarked = false;
+	};
+}
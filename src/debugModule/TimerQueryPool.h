@@ -0,0 +1,241 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SFE::Debug {
+	//gpu timestamps pool, results are read back with Latency frames delay and only if they are already available, so it never stalls the pipeline
+	//Backend is a plain struct, it allows to check bookkeeping without gl context:
+	//	using Handle = ...;
+	//	void create(Handle* handles, size_t count);
+	//	void destroy(Handle* handles, size_t count);
+	//	void timestamp(Handle handle);
+	//	bool available(Handle handle);  //true also means that all previous queries are available
+	//	uint64_t result(Handle handle); //nanoseconds
+	template<typename Backend, size_t Latency = 4, size_t MaxScopes = 64>
+	class TimerQueryPool {
+		static_assert(Latency >= 2, "TimerQueryPool needs at least two frames in flight");
+
+		using Handle = typename Backend::Handle;
+
+		//frame begin, frame end, then begin/end pair per scope
+		constexpr static size_t QUERIES_PER_FRAME = 2 + MaxScopes * 2;
+
+		struct FrameSlot {
+			std::array<Handle, QUERIES_PER_FRAME> queries{};
+			std::array<std::string, MaxScopes> names;
+			std::array<bool, MaxScopes> closed{};
+			uint64_t frameIndex = 0;
+			size_t scopesCount = 0;
+			bool pending = false;
+		};
+
+	public:
+		constexpr static size_t INVALID_SCOPE = static_cast<size_t>(-1);
+
+		struct ScopeResult {
+			std::string name;
+			uint64_t begin = 0;
+			uint64_t end = 0;
+
+			uint64_t duration() const { return end > begin ? end - begin : 0; }
+		};
+
+		struct FrameResult {
+			uint64_t frameIndex = 0;
+			uint64_t begin = 0;
+			uint64_t end = 0;
+			std::vector<ScopeResult> scopes;
+
+			uint64_t duration() const { return end > begin ? end - begin : 0; }
+		};
+
+		TimerQueryPool(Backend backend = {}) : mBackend(std::move(backend)) {}
+
+		~TimerQueryPool() {
+			release();
+		}
+
+		TimerQueryPool(const TimerQueryPool&) = delete;
+		TimerQueryPool& operator=(const TimerQueryPool&) = delete;
+
+		void init() {
+			if (mInitialized) {
+				return;
+			}
+
+			for (auto& slot : mSlots) {
+				mBackend.create(slot.queries.data(), slot.queries.size());
+			}
+			mInitialized = true;
+		}
+
+		void release() {
+			if (!mInitialized) {
+				return;
+			}
+
+			for (auto& slot : mSlots) {
+				mBackend.destroy(slot.queries.data(), slot.queries.size());
+				slot.pending = false;
+			}
+			mInitialized = false;
+			mInFrame = false;
+		}
+
+		void beginFrame() {
+			if (!mInitialized || mInFrame) {
+				return;
+			}
+
+			auto& slot = mSlots[mFrame % Latency];
+			if (slot.pending) {
+				//gpu is more than Latency frames behind, don't wait for it, just lose this frame
+				if (!tryResolve(slot)) {
+					slot.pending = false;
+					mDroppedFrames++;
+				}
+			}
+
+			slot.frameIndex = mFrame;
+			slot.scopesCount = 0;
+			mBackend.timestamp(slot.queries[0]);
+			mInFrame = true;
+		}
+
+		void endFrame() {
+			if (!mInFrame) {
+				return;
+			}
+
+			auto& slot = mSlots[mFrame % Latency];
+			//query which was never issued has no result, so close forgotten scopes with the frame end
+			for (size_t i = 0; i < slot.scopesCount; i++) {
+				if (!slot.closed[i]) {
+					endScope(i);
+				}
+			}
+			mBackend.timestamp(slot.queries[1]);
+			slot.pending = true;
+			mInFrame = false;
+			mFrame++;
+
+			poll();
+		}
+
+		//returns scope id for endScope, INVALID_SCOPE if frame is not started or scopes limit is reached
+		size_t beginScope(const std::string& name) {
+			if (!mInFrame) {
+				return INVALID_SCOPE;
+			}
+
+			auto& slot = mSlots[mFrame % Latency];
+			if (slot.scopesCount >= MaxScopes) {
+				mOverflowScopes++;
+				return INVALID_SCOPE;
+			}
+
+			const auto scope = slot.scopesCount++;
+			slot.names[scope] = name;
+			slot.closed[scope] = false;
+			mBackend.timestamp(slot.queries[2 + scope * 2]);
+
+			return scope;
+		}
+
+		void endScope(size_t scope) {
+			if (!mInFrame || scope == INVALID_SCOPE) {
+				return;
+			}
+
+			auto& slot = mSlots[mFrame % Latency];
+			if (scope >= slot.scopesCount || slot.closed[scope]) {
+				return;
+			}
+
+			slot.closed[scope] = true;
+			mBackend.timestamp(slot.queries[2 + scope * 2 + 1]);
+		}
+
+		//reads every finished frame from oldest to newest, stops on the first one which is not ready yet
+		void poll() {
+			for (size_t i = Latency; i > 0; i--) {
+				if (mFrame < i) {
+					continue;
+				}
+
+				auto& slot = mSlots[(mFrame - i) % Latency];
+				if (!slot.pending || slot.frameIndex != mFrame - i) {
+					continue;
+				}
+
+				if (!tryResolve(slot)) {
+					break;
+				}
+			}
+		}
+
+		//moves resolved frames to the caller, returns count of frames
+		template<typename Func>
+		size_t consume(Func&& func) {
+			const auto count = mResolved.size();
+			for (auto& frame : mResolved) {
+				func(frame);
+			}
+			mResolved.clear();
+
+			return count;
+		}
+
+		uint64_t getFrameIndex() const { return mFrame; }
+		uint64_t getDroppedFrames() const { return mDroppedFrames; }
+		uint64_t getOverflowScopes() const { return mOverflowScopes; }
+		bool isInitialized() const { return mInitialized; }
+
+		constexpr static size_t latency() { return Latency; }
+
+		Backend& getBackend() { return mBackend; }
+
+	private:
+		bool tryResolve(FrameSlot& slot) {
+			//frame end timestamp is the last query of the frame, if it is ready all previous are ready too
+			if (!mBackend.available(slot.queries[1])) {
+				return false;
+			}
+
+			FrameResult frame;
+			frame.frameIndex = slot.frameIndex;
+			frame.begin = mBackend.result(slot.queries[0]);
+			frame.end = mBackend.result(slot.queries[1]);
+			frame.scopes.reserve(slot.scopesCount);
+			for (size_t i = 0; i < slot.scopesCount; i++) {
+				auto& scope = frame.scopes.emplace_back();
+				scope.name = std::move(slot.names[i]);
+				scope.begin = mBackend.result(slot.queries[2 + i * 2]);
+				scope.end = mBackend.result(slot.queries[2 + i * 2 + 1]);
+			}
+
+			slot.pending = false;
+			if (mResolved.size() >= MAX_RESOLVED) {
+				mResolved.erase(mResolved.begin());
+			}
+			mResolved.push_back(std::move(frame));
+
+			return true;
+		}
+
+		constexpr static size_t MAX_RESOLVED = Latency * 4; //if nobody consumes results, keep only the latest
+
+		Backend mBackend;
+		std::array<FrameSlot, Latency> mSlots;
+		std::vector<FrameResult> mResolved;
+
+		uint64_t mFrame = 0;
+		uint64_t mDroppedFrames = 0;
+		uint64_t mOverflowScopes = 0;
+		bool mInFrame = false;
+		bool mInitialized = false;
+	};
+}
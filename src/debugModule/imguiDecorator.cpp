@@ -4,10 +4,62 @@
 
 #include "Benchmark.h"
 #include "imgui.h"
-#include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 namespace SFE::Debug {
+	namespace {
+		//glfw callbacks have no user data, engine has one window with imgui
+		ImGuiDecorator* installed = nullptr;
+		GLFWkeyfun prevKeyCallback = nullptr;
+		GLFWcharfun prevCharCallback = nullptr;
+		GLFWmousebuttonfun prevMouseButtonCallback = nullptr;
+		GLFWcursorposfun prevCursorPosCallback = nullptr;
+		GLFWscrollfun prevScrollCallback = nullptr;
+		GLFWwindowfocusfun prevFocusCallback = nullptr;
+
+		ImGuiKey toImGuiKey(int key) {
+			if (key >= GLFW_KEY_A && key <= GLFW_KEY_Z) {
+				return static_cast<ImGuiKey>(ImGuiKey_A + (key - GLFW_KEY_A));
+			}
+			if (key >= GLFW_KEY_0 && key <= GLFW_KEY_9) {
+				return static_cast<ImGuiKey>(ImGuiKey_0 + (key - GLFW_KEY_0));
+			}
+			if (key >= GLFW_KEY_F1 && key <= GLFW_KEY_F12) {
+				return static_cast<ImGuiKey>(ImGuiKey_F1 + (key - GLFW_KEY_F1));
+			}
+
+			switch (key) {
+			case GLFW_KEY_TAB: return ImGuiKey_Tab;
+			case GLFW_KEY_LEFT: return ImGuiKey_LeftArrow;
+			case GLFW_KEY_RIGHT: return ImGuiKey_RightArrow;
+			case GLFW_KEY_UP: return ImGuiKey_UpArrow;
+			case GLFW_KEY_DOWN: return ImGuiKey_DownArrow;
+			case GLFW_KEY_PAGE_UP: return ImGuiKey_PageUp;
+			case GLFW_KEY_PAGE_DOWN: return ImGuiKey_PageDown;
+			case GLFW_KEY_HOME: return ImGuiKey_Home;
+			case GLFW_KEY_END: return ImGuiKey_End;
+			case GLFW_KEY_INSERT: return ImGuiKey_Insert;
+			case GLFW_KEY_DELETE: return ImGuiKey_Delete;
+			case GLFW_KEY_BACKSPACE: return ImGuiKey_Backspace;
+			case GLFW_KEY_SPACE: return ImGuiKey_Space;
+			case GLFW_KEY_ENTER: return ImGuiKey_Enter;
+			case GLFW_KEY_KP_ENTER: return ImGuiKey_KeypadEnter;
+			case GLFW_KEY_ESCAPE: return ImGuiKey_Escape;
+			case GLFW_KEY_MINUS: return ImGuiKey_Minus;
+			case GLFW_KEY_PERIOD: return ImGuiKey_Period;
+			case GLFW_KEY_LEFT_CONTROL: return ImGuiKey_LeftCtrl;
+			case GLFW_KEY_LEFT_SHIFT: return ImGuiKey_LeftShift;
+			case GLFW_KEY_LEFT_ALT: return ImGuiKey_LeftAlt;
+			case GLFW_KEY_LEFT_SUPER: return ImGuiKey_LeftSuper;
+			case GLFW_KEY_RIGHT_CONTROL: return ImGuiKey_RightCtrl;
+			case GLFW_KEY_RIGHT_SHIFT: return ImGuiKey_RightShift;
+			case GLFW_KEY_RIGHT_ALT: return ImGuiKey_RightAlt;
+			case GLFW_KEY_RIGHT_SUPER: return ImGuiKey_RightSuper;
+			default: return ImGuiKey_None;
+			}
+		}
+	}
+
 	void ImGuiDecorator::init(GLFWwindow* window) {
 		if (context || !window) {
 			return;
@@ -16,14 +68,116 @@ namespace SFE::Debug {
 		IMGUI_CHECKVERSION();
 		context = ImGui::CreateContext();
 
-		ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_ViewportsEnable | ImGuiConfigFlags_DockingEnable;
+		//viewports need platform backend, cursor shape can't be changed from render thread
+		auto& io = ImGui::GetIO();
+		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable | ImGuiConfigFlags_NoMouseCursorChange;
+		io.BackendPlatformName = "sfe_glfw_forwarding";
 
 		setStyle();
 
-		ImGui_ImplGlfw_InitForOpenGL(window, true);
+		installCallbacks(window);
 		ImGui_ImplOpenGL3_Init("#version 330");
 	}
 
+	void ImGuiDecorator::installCallbacks(GLFWwindow* window) {
+		mWindow = window;
+		installed = this;
+
+		//previous callbacks are called too, so engine input handler still gets events
+		prevKeyCallback = glfwSetKeyCallback(window, [](GLFWwindow* w, int key, int scancode, int action, int mods) {
+			if (prevKeyCallback) {
+				prevKeyCallback(w, key, scancode, action, mods);
+			}
+			if (installed && action != GLFW_REPEAT) {
+				installed->addEvent({ Event::KEY, key, mods, action == GLFW_PRESS });
+			}
+		});
+		prevCharCallback = glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int c) {
+			if (prevCharCallback) {
+				prevCharCallback(w, c);
+			}
+			if (installed) {
+				installed->addEvent({ Event::CHAR, static_cast<int>(c) });
+			}
+		});
+		prevMouseButtonCallback = glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int button, int action, int mods) {
+			if (prevMouseButtonCallback) {
+				prevMouseButtonCallback(w, button, action, mods);
+			}
+			if (installed) {
+				installed->addEvent({ Event::MOUSE_BUTTON, button, mods, action == GLFW_PRESS });
+			}
+		});
+		prevCursorPosCallback = glfwSetCursorPosCallback(window, [](GLFWwindow* w, double x, double y) {
+			if (prevCursorPosCallback) {
+				prevCursorPosCallback(w, x, y);
+			}
+			if (installed) {
+				installed->addEvent({ Event::MOUSE_POS, 0, 0, false, x, y });
+			}
+		});
+		prevScrollCallback = glfwSetScrollCallback(window, [](GLFWwindow* w, double x, double y) {
+			if (prevScrollCallback) {
+				prevScrollCallback(w, x, y);
+			}
+			if (installed) {
+				installed->addEvent({ Event::SCROLL, 0, 0, false, x, y });
+			}
+		});
+		prevFocusCallback = glfwSetWindowFocusCallback(window, [](GLFWwindow* w, int focused) {
+			if (prevFocusCallback) {
+				prevFocusCallback(w, focused);
+			}
+			if (installed) {
+				installed->addEvent({ Event::FOCUS, focused });
+			}
+		});
+	}
+
+	void ImGuiDecorator::restoreCallbacks() {
+		if (!mWindow) {
+			return;
+		}
+
+		glfwSetKeyCallback(mWindow, prevKeyCallback);
+		glfwSetCharCallback(mWindow, prevCharCallback);
+		glfwSetMouseButtonCallback(mWindow, prevMouseButtonCallback);
+		glfwSetCursorPosCallback(mWindow, prevCursorPosCallback);
+		glfwSetScrollCallback(mWindow, prevScrollCallback);
+		glfwSetWindowFocusCallback(mWindow, prevFocusCallback);
+
+		installed = nullptr;
+		mWindow = nullptr;
+	}
+
+	void ImGuiDecorator::addEvent(const Event& event) {
+		mEvents.push_back(event);
+	}
+
+	ImGuiDecorator::Input ImGuiDecorator::takeInput(float dt) {
+		Input input;
+		input.dt = dt;
+		if (!mWindow) {
+			return input;
+		}
+
+		input.events = std::move(mEvents);
+		mEvents.clear();
+
+		int width = 0, height = 0;
+		int displayWidth = 0, displayHeight = 0;
+		glfwGetWindowSize(mWindow, &width, &height);
+		glfwGetFramebufferSize(mWindow, &displayWidth, &displayHeight);
+		input.width = static_cast<float>(width);
+		input.height = static_cast<float>(height);
+		if (width > 0 && height > 0) {
+			input.framebufferScaleX = static_cast<float>(displayWidth) / static_cast<float>(width);
+			input.framebufferScaleY = static_cast<float>(displayHeight) / static_cast<float>(height);
+		}
+
+		return input;
+	}
+
 	void ImGuiDecorator::setStyle() {
 		ImGuiIO& io = ImGui::GetIO();
 
@@ -103,7 +257,7 @@ namespace SFE::Debug {
 #endif
 	}
 
-	void ImGuiDecorator::preDraw() {
+	void ImGuiDecorator::preDraw(const Input& input) {
 		if (!context) {
 			return;
 		}
@@ -119,7 +273,45 @@ namespace SFE::Debug {
 
 
 		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
+
+		auto& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(input.width, input.height);
+		io.DisplayFramebufferScale = ImVec2(input.framebufferScaleX, input.framebufferScaleY);
+		io.DeltaTime = input.dt > 0.f ? input.dt : 1.f / 60.f;
+
+		for (const auto& event : input.events) {
+			switch (event.type) {
+			case Event::KEY: {
+				io.AddKeyEvent(ImGuiMod_Ctrl, event.mods & GLFW_MOD_CONTROL);
+				io.AddKeyEvent(ImGuiMod_Shift, event.mods & GLFW_MOD_SHIFT);
+				io.AddKeyEvent(ImGuiMod_Alt, event.mods & GLFW_MOD_ALT);
+				io.AddKeyEvent(ImGuiMod_Super, event.mods & GLFW_MOD_SUPER);
+				const auto key = toImGuiKey(event.code);
+				if (key != ImGuiKey_None) {
+					io.AddKeyEvent(key, event.down);
+				}
+				break;
+			}
+			case Event::CHAR:
+				io.AddInputCharacter(static_cast<unsigned int>(event.code));
+				break;
+			case Event::MOUSE_BUTTON:
+				if (event.code >= 0 && event.code < ImGuiMouseButton_COUNT) {
+					io.AddMouseButtonEvent(event.code, event.down);
+				}
+				break;
+			case Event::MOUSE_POS:
+				io.AddMousePosEvent(static_cast<float>(event.x), static_cast<float>(event.y));
+				break;
+			case Event::SCROLL:
+				io.AddMouseWheelEvent(static_cast<float>(event.x), static_cast<float>(event.y));
+				break;
+			case Event::FOCUS:
+				io.AddFocusEvent(event.code != 0);
+				break;
+			}
+		}
+
 		ImGui::NewFrame();
 	}
 
@@ -131,12 +323,6 @@ namespace SFE::Debug {
 
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-		if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
-			auto backup_current_context = glfwGetCurrentContext();
-			ImGui::UpdatePlatformWindows();
-			ImGui::RenderPlatformWindowsDefault();
-			glfwMakeContextCurrent(backup_current_context);
-		}
 
 		if (previous) {
 			ImGui::SetCurrentContext(previous);
@@ -150,7 +336,7 @@ namespace SFE::Debug {
 		}
 
 		ImGui_ImplOpenGL3_Shutdown();
-		ImGui_ImplGlfw_Shutdown();
+		restoreCallbacks();
 		ImGui::DestroyContext();
 		context = nullptr;
 	}
@@ -1,20 +1,63 @@
 ﻿#pragma once
 
+#include <vector>
+
 struct ImGuiContext;
 struct GLFWwindow;
 
 namespace SFE::Debug {
+	//frame is built on render thread, glfw can be used only from main thread,
+	//so events are collected by glfw callbacks and replayed into imgui in preDraw instead of imgui glfw backend
 	class ImGuiDecorator {
 	public:
+		struct Event {
+			enum Type {
+				KEY,
+				CHAR,
+				MOUSE_BUTTON,
+				MOUSE_POS,
+				SCROLL,
+				FOCUS,
+			};
+
+			Type type = KEY;
+			int code = 0; //key, button, character or focus
+			int mods = 0;
+			bool down = false;
+			double x = 0.0;
+			double y = 0.0;
+		};
+
+		struct Input {
+			std::vector<Event> events;
+			float width = 0.f;
+			float height = 0.f;
+			float framebufferScaleX = 1.f;
+			float framebufferScaleY = 1.f;
+			float dt = 0.f;
+		};
+
+		//main thread, context has to be current
 		void init(GLFWwindow*);
 		void setStyle();
-		void preDraw();
+		//main thread, after glfwPollEvents
+		Input takeInput(float dt);
+		//render thread
+		void preDraw(const Input& input);
 		void draw();
 		void destroyContext();
 
 	public:
 		ImGuiContext* context = nullptr;
 		ImGuiContext* previous = nullptr;
+
+	private:
+		void installCallbacks(GLFWwindow* window);
+		void restoreCallbacks();
+		void addEvent(const Event& event);
+
+		GLFWwindow* mWindow = nullptr;
+		std::vector<Event> mEvents; //main thread only
 	};
 }
 
@@ -59,6 +59,10 @@ namespace SFE::GLW {
 		glDrawElementsInstanced(mode, size, static_cast<GLenum>(type), place, instancesCount);
 	}
 
+	constexpr inline void drawElementsInstancedBaseVertex(RenderMode mode, GLsizei size, RenderDataType type, GLsizei instancesCount, const void* place, GLint baseVertex) {
+		glDrawElementsInstancedBaseVertex(mode, size, static_cast<GLenum>(type), place, instancesCount, baseVertex);
+	}
+
 	constexpr inline void drawArraysInstancing(RenderMode mode, GLsizei size, GLsizei instancesCount, GLint first = 0) {
 		glDrawArraysInstanced(mode, first, size, instancesCount);
 	}
@@ -112,6 +116,31 @@ namespace SFE::GLW {
 		VertexArray::bindDefault();
 	}
 
+	constexpr inline void multiDrawElementsIndirect(RenderMode mode, size_t commandsOffset, size_t drawCount, RenderDataType indicesType = RenderDataType::UNSIGNED_INT, size_t stride = 0) {
+		glMultiDrawElementsIndirect(mode, static_cast<GLenum>(indicesType), reinterpret_cast<const void*>(commandsOffset), static_cast<GLsizei>(drawCount), static_cast<GLsizei>(stride));
+	}
+
+	enum MemoryBarrierBit : uint32_t {
+		VERTEX_ATTRIB_ARRAY_BARRIER = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+		ELEMENT_ARRAY_BARRIER = GL_ELEMENT_ARRAY_BARRIER_BIT,
+		UNIFORM_BARRIER = GL_UNIFORM_BARRIER_BIT,
+		COMMAND_BARRIER = GL_COMMAND_BARRIER_BIT,
+		SHADER_STORAGE_BARRIER = GL_SHADER_STORAGE_BARRIER_BIT,
+		TEXTURE_FETCH_BARRIER = GL_TEXTURE_FETCH_BARRIER_BIT,
+		SHADER_IMAGE_ACCESS_BARRIER = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT,
+		FRAMEBUFFER_BARRIER = GL_FRAMEBUFFER_BARRIER_BIT,
+		BUFFER_UPDATE_BARRIER = GL_BUFFER_UPDATE_BARRIER_BIT,
+		ALL_BARRIER = GL_ALL_BARRIER_BITS
+	};
+
+	inline void dispatchCompute(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) {
+		glDispatchCompute(groupsX, groupsY, groupsZ);
+	}
+
+	inline void memoryBarrier(uint32_t barriers) {
+		glMemoryBarrier(barriers);
+	}
+
 	struct LineWidth : StateStack<float, LineWidth> {
 		void apply(float* data) override {
 			if (!data) {
@@ -37,6 +37,14 @@ namespace SFE::GLW {
 		addAttachmentTexture(attachment, texture->mId);
 	}
 
+	void Framebuffer::skipAttachment() {
+		attachments.push_back(GL_NONE);
+	}
+
+	void Framebuffer::clearAttachments() {
+		attachments.clear();
+	}
+
 	void Framebuffer::addAttachmentTexture(AttachmentType attachment, unsigned texture) {
 		addAttachmentTexture(static_cast<int>(attachment), texture);
 	}
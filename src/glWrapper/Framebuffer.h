@@ -83,6 +83,10 @@ namespace SFE::GLW {
 
 		void addAttachmentTexture(AttachmentType attachment, unsigned texture);
 		void addAttachmentTexture(AttachmentType attachment, Texture* texture);
+		//draw buffer without texture, fragment output with this location is discarded
+		void skipAttachment();
+		//draw buffers are collected again when render targets are recreated, new textures replace old ones
+		void clearAttachments();
 
 		static void bindFramebuffer(unsigned id = 0);
 		static void bindDefaultFramebuffer();
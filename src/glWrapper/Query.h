@@ -45,7 +45,7 @@ namespace SFE::GLW {
 			return glIsQuery(ids[idx]);
 		}
 		void generate() {
-			glGenQueries(1, ids);
+			glGenQueries(Count, ids);
 		}
 		
 		void begin(size_t idx = 0) {
@@ -56,6 +56,17 @@ namespace SFE::GLW {
 			glEndQuery(static_cast<unsigned int>(type));
 		}
 
+		//only for TIMESTAMP queries, writes gpu time when all previous commands are finished
+		void counter(size_t idx = 0) {
+			glQueryCounter(ids[idx], GL_TIMESTAMP);
+		}
+
+		bool isAvailable(size_t idx = 0) {
+			int res = 0;
+			glGetQueryObjectiv(ids[idx], GL_QUERY_RESULT_AVAILABLE, &res);
+			return res;
+		}
+
 		void getResult(unsigned int& res, size_t idx = 0, QueryResult resultType = QueryResult::QUERY_RESULT) {
 			glGetQueryObjectuiv(ids[idx], static_cast<GLenum>(resultType), &res);
 		}
@@ -78,4 +89,33 @@ namespace SFE::GLW {
 
 	template<QueryType Type>
 	using Query = Queries<1, Type>;
-}
\ No newline at end of file
+
+	//backend for Debug::TimerQueryPool
+	struct TimestampQueryBackend {
+		using Handle = unsigned int;
+
+		void create(Handle* handles, size_t count) {
+			glGenQueries(static_cast<GLsizei>(count), handles);
+		}
+
+		void destroy(Handle* handles, size_t count) {
+			glDeleteQueries(static_cast<GLsizei>(count), handles);
+		}
+
+		void timestamp(Handle handle) {
+			glQueryCounter(handle, GL_TIMESTAMP);
+		}
+
+		bool available(Handle handle) {
+			int res = 0;
+			glGetQueryObjectiv(handle, GL_QUERY_RESULT_AVAILABLE, &res);
+			return res;
+		}
+
+		uint64_t result(Handle handle) {
+			uint64_t res = 0;
+			glGetQueryObjectui64v(handle, GL_QUERY_RESULT, &res);
+			return res;
+		}
+	};
+}
@@ -1,5 +1,11 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "glad/glad.h"
 #include "unordered_map"
 
@@ -31,29 +37,111 @@ namespace SFE::GLW {
 		glUseProgram(programId);
 	}
 
-	constexpr bool checkCompileErrors(unsigned int shader, const char*& result) {
-		int success;
-		char infoLog[1024];
-		glGetProgramiv(shader, GL_LINK_STATUS, &success);
-		if (!success) {
-			glGetProgramInfoLog(shader, 1024, nullptr, infoLog);
-			result = infoLog;
+	//KHR_parallel_shader_compile isn't in generated glad, so window loads it after context creation
+	constexpr GLenum MAX_SHADER_COMPILER_THREADS = 0x91B0;
+	inline bool parallelShaderCompile = false;
+
+	inline bool hasExtension(std::string_view name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++) {
+			const auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (extension && name == extension) {
+				return true;
+			}
 		}
+		return false;
+	}
 
-		return success;
+	//driver compiles and links on its own threads, so only query of link status waits for program
+	inline bool initParallelShaderCompile(GLADloadproc load) {
+		using MaxShaderCompilerThreads = void (APIENTRYP)(GLuint count);
+		MaxShaderCompilerThreads maxThreads = nullptr;
+		if (hasExtension("GL_KHR_parallel_shader_compile")) {
+			maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(load("glMaxShaderCompilerThreadsKHR"));
+		}
+		else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+			maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(load("glMaxShaderCompilerThreadsARB"));
+		}
+
+		parallelShaderCompile = maxThreads != nullptr;
+		if (parallelShaderCompile) {
+			//driver chooses count of threads itself
+			maxThreads(0xFFFFFFFF);
+		}
+		return parallelShaderCompile;
 	}
 
-	constexpr bool compileShader(const char* shaderCode, ShaderType type, unsigned shaderId, const char*& res) {
+	//stage is compiled and attached without waiting, its log is read after link if link fails
+	inline unsigned attachShader(unsigned programId, const char* shaderCode, ShaderType type) {
 		const auto shader = glCreateShader(static_cast<GLenum>(type));
 		glShaderSource(shader, 1, &shaderCode, nullptr);
 		glCompileShader(shader);
+		glAttachShader(programId, shader);
+		return shader;
+	}
 
-		glAttachShader(shaderId, shader);
-
-		glLinkProgram(shaderId);
-		const auto success = checkCompileErrors(shaderId, res);
+	inline void releaseShader(unsigned programId, unsigned shader) {
+		glDetachShader(programId, shader);
 		glDeleteShader(shader);
+	}
+
+	inline void linkProgram(unsigned programId) {
+		glLinkProgram(programId);
+	}
+
+	//blocks until program is linked
+	inline bool getLinkStatus(unsigned programId, std::string& log) {
+		GLint success = 0;
+		glGetProgramiv(programId, GL_LINK_STATUS, &success);
+		if (!success) {
+			GLint length = 0;
+			glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &length);
+			log.resize(static_cast<size_t>(std::max(length, 1)));
+			glGetProgramInfoLog(programId, length, nullptr, log.data());
+		}
+		return success;
+	}
+
+	inline std::string getShaderLog(unsigned shader) {
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (success) {
+			return {};
+		}
+
+		GLint length = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+		glGetShaderInfoLog(shader, length, nullptr, log.data());
+		return log;
+	}
+
+	//hint should be set before link, otherwise driver may not keep binary
+	inline void setProgramBinaryRetrievable(unsigned programId) {
+		glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	inline bool getProgramBinary(unsigned programId, uint32_t& format, std::vector<uint8_t>& data) {
+		GLint length = 0;
+		glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) {
+			return false;
+		}
+
+		GLenum binaryFormat = 0;
+		data.resize(static_cast<size_t>(length));
+		glGetProgramBinary(programId, length, &length, &binaryFormat, data.data());
+		data.resize(static_cast<size_t>(length));
+		format = binaryFormat;
+		return length > 0;
+	}
 
+	//returns false if driver rejects binary, program stays not linked then and can be compiled from sources
+	inline bool programBinary(unsigned programId, uint32_t format, const std::vector<uint8_t>& data) {
+		glProgramBinary(programId, format, data.data(), static_cast<GLsizei>(data.size()));
+		GLint success = 0;
+		glGetProgramiv(programId, GL_LINK_STATUS, &success);
 		return success;
 	}
 
@@ -0,0 +1,13 @@
+﻿#pragma once
+
+#include "glad/glad.h"
+
+namespace SFE::GLW {
+	//blocks until commands of current context are complete on gpu, objects changed by them are ready for other contexts then
+	//https://registry.khronos.org/OpenGL-Refpages/gl4/html/glFenceSync.xhtml
+	inline void waitGpu() {
+		const auto fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+	}
+}
@@ -98,6 +98,11 @@ namespace SFE::GLW {
 		DEPTH_COMPONENT16 = GL_DEPTH_COMPONENT16,
 		DEPTH_COMPONENT24 = GL_DEPTH_COMPONENT24,
 		DEPTH_COMPONENT32 = GL_DEPTH_COMPONENT32,
+		//s3tc formats come from extension which is not in glad, values are from EXT_texture_compression_s3tc
+		COMPRESSED_RGB_BC1 = 0x83F0,
+		COMPRESSED_RGBA_BC3 = 0x83F3,
+		COMPRESSED_RG_BC5 = GL_COMPRESSED_RG_RGTC2,
+		COMPRESSED_RGBA_BC7 = GL_COMPRESSED_RGBA_BPTC_UNORM,
 	};
 
 	enum TextureFormat : unsigned {
@@ -406,6 +411,33 @@ namespace SFE::GLW {
 			bindTextureToSlot(0, mType, 0);
 		}
 
+		//immutable storage of all levels, they are filled by subImage2D or compressedSubImage2D
+		void createStorage2D(int levels) {
+			clear();
+			generate();
+
+			bindTextureToSlot(0, mType, mId);
+
+			glTexStorage2D(mType, levels, pixelFormat, width, height);
+			parameters.apply(this);
+			applyPixelStorageMode();
+
+			bindTextureToSlot(0, mType, 0);
+		}
+
+		void createStorage3D(int levels) {
+			clear();
+			generate();
+
+			bindTextureToSlot(0, mType, mId);
+
+			glTexStorage3D(mType, levels, pixelFormat, width, height, depth);
+			parameters.apply(this);
+			applyPixelStorageMode();
+
+			bindTextureToSlot(0, mType, 0);
+		}
+
 		void generate() {
 			glGenTextures(1, &mId);
 		}
@@ -432,6 +464,34 @@ namespace SFE::GLW {
 			glTexSubImage2D(mType, 0, xoffset, yoffset, w, h, format, type, data);
 		}
 
+		//whole level of bound texture
+		void subImage2D(int level, int w, int h, const void* data) const {
+			glTexSubImage2D(mType, level, 0, 0, w, h, textureFormat, pixelType, data);
+		}
+
+		void compressedSubImage2D(int level, int w, int h, size_t size, const void* data) const {
+			glCompressedTexSubImage2D(mType, level, 0, 0, w, h, pixelFormat, static_cast<GLsizei>(size), data);
+		}
+
+		//mutable level of bound texture, unlike storage it can be released later, so streamed textures use it
+		void imageLevel2D(int level, int w, int h, const void* data) const {
+			glTexImage2D(mType, level, pixelFormat, w, h, 0, textureFormat, pixelType, data);
+		}
+
+		void compressedImageLevel2D(int level, int w, int h, size_t size, const void* data) const {
+			glCompressedTexImage2D(mType, level, pixelFormat, w, h, 0, static_cast<GLsizei>(size), data);
+		}
+
+		//level becomes empty and driver frees its memory, it should be under base level already
+		void releaseLevel2D(int level, bool compressed) const {
+			if (compressed) {
+				compressedImageLevel2D(level, 0, 0, 0, nullptr);
+			}
+			else {
+				imageLevel2D(level, 0, 0, nullptr);
+			}
+		}
+
 		void setParameter(SFE::GLW::TextureIParameter param, unsigned value) const {
 			glTexParameteri(mType, param, value);
 		}
@@ -470,4 +530,13 @@ namespace SFE::GLW {
 
 		bindTextureToSlot(slot, texture->mType, texture->mId);
 	}
+
+	//whole level of one layer of array texture which is bound to TEXTURE_2D_ARRAY
+	inline void layerSubImage(int level, int layer, int w, int h, TextureFormat format, PixelDataType type, const void* data) {
+		glTexSubImage3D(TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, format, type, data);
+	}
+
+	inline void compressedLayerSubImage(int level, int layer, int w, int h, PixelFormat format, size_t size, const void* data) {
+		glCompressedTexSubImage3D(TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, format, static_cast<GLsizei>(size), data);
+	}
 }
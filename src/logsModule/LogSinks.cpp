@@ -0,0 +1,150 @@
+#include "LogSinks.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#ifdef __APPLE__
+#include <os/log.h>
+#else
+#include <REND.h>
+#endif
+
+namespace SFE::LogsModule {
+	const char* levelName(eLogLevel level) {
+		switch (level) {
+		case eLogLevel::WARNING:
+			return "WARNING:  ";
+		case eLogLevel::ERROR_:
+			return "ERROR:  ";
+		case eLogLevel::FATAL:
+			return "FATAL:  ";
+		case eLogLevel::INFO:
+		default:
+			return "";
+		}
+	}
+
+	size_t formatRecord(const LogRecord& record, char* out, size_t size) {
+		const time_t t = static_cast<time_t>(record.timestamp / 1'000'000'000);
+		tm buf;
+#if defined(_WIN32)
+		localtime_s(&buf, &t);
+#else
+		localtime_r(&t, &buf);
+#endif
+
+		size_t len = strftime(out, size, "%d/%m/%y %H:%M:%S ", &buf);
+		int written = 0;
+		if (record.suppressed) {
+			written = snprintf(out + len, size - len, "[%u] %s%.*s (%u similar messages suppressed)\n", record.threadId, levelName(record.level), static_cast<int>(record.length), record.message, record.suppressed);
+		}
+		else {
+			written = snprintf(out + len, size - len, "[%u] %s%.*s\n", record.threadId, levelName(record.level), static_cast<int>(record.length), record.message);
+		}
+
+		if (written > 0) {
+			len = std::min(size - 1, len + static_cast<size_t>(written));
+		}
+
+		return len;
+	}
+
+	void PlatformSink::write(const LogRecord& record) {
+		char line[LOG_MESSAGE_SIZE + 128];
+		formatRecord(record, line, sizeof(line));
+
+#ifdef __APPLE__
+		uint8_t logType = OS_LOG_TYPE_INFO;
+		switch (record.level) {
+		case eLogLevel::WARNING:
+		case eLogLevel::ERROR_:
+			logType = OS_LOG_TYPE_ERROR;
+			break;
+		case eLogLevel::FATAL:
+			logType = OS_LOG_TYPE_FAULT;
+			break;
+		default:
+			break;
+		}
+		os_log_with_type(OS_LOG_DEFAULT, os_log_type_t(logType), "%s", line);
+#else
+		OutputDebugString(line);
+#endif
+	}
+
+	void StdoutSink::write(const LogRecord& record) {
+		char line[LOG_MESSAGE_SIZE + 128];
+		const auto len = formatRecord(record, line, sizeof(line));
+		fwrite(line, 1, len, record.level >= eLogLevel::ERROR_ ? stderr : stdout);
+	}
+
+	void StdoutSink::flush() {
+		fflush(stdout);
+		fflush(stderr);
+	}
+
+	FileSink::FileSink(const std::string& path, bool append) {
+#if defined(_WIN32)
+		fopen_s(&mFile, path.c_str(), append ? "ab" : "wb");
+#else
+		mFile = fopen(path.c_str(), append ? "ab" : "wb");
+#endif
+		if (mFile) {
+			setvbuf(mFile, nullptr, _IOFBF, 64 * 1024);
+		}
+	}
+
+	FileSink::~FileSink() {
+		if (mFile) {
+			fclose(mFile);
+		}
+	}
+
+	void FileSink::write(const LogRecord& record) {
+		if (!mFile) {
+			return;
+		}
+
+		char line[LOG_MESSAGE_SIZE + 128];
+		const auto len = formatRecord(record, line, sizeof(line));
+		fwrite(line, 1, len, mFile);
+	}
+
+	void FileSink::flush() {
+		if (mFile) {
+			fflush(mFile);
+		}
+	}
+
+	RingBufferSink::RingBufferSink(size_t capacity) {
+		mRecords.resize(std::max<size_t>(capacity, 1));
+	}
+
+	void RingBufferSink::write(const LogRecord& record) {
+		std::unique_lock lock(mMutex);
+		mRecords[mHead] = record;
+		mHead = (mHead + 1) % mRecords.size();
+		mWritten++;
+	}
+
+	std::vector<LogRecord> RingBufferSink::getRecords(size_t maxCount) const {
+		std::unique_lock lock(mMutex);
+		const auto count = std::min({ mWritten, mRecords.size(), maxCount });
+
+		std::vector<LogRecord> result;
+		result.reserve(count);
+		auto idx = (mHead + mRecords.size() - count) % mRecords.size();
+		for (size_t i = 0; i < count; i++) {
+			result.push_back(mRecords[idx]);
+			idx = (idx + 1) % mRecords.size();
+		}
+
+		return result;
+	}
+
+	size_t RingBufferSink::getWrittenCount() const {
+		std::unique_lock lock(mMutex);
+		return mWritten;
+	}
+}
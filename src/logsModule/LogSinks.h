@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+
+namespace SFE::LogsModule {
+	//sinks are called only from logger thread (or from caller thread after Logger::shutdown), so they don't need own synchronization for writing
+	class LogSink {
+	public:
+		virtual ~LogSink() = default;
+		virtual void write(const LogRecord& record) = 0;
+		virtual void flush() {}
+
+		eLogLevel minLevel = eLogLevel::INFO;
+	};
+
+	//"dd/mm/yy HH:MM:SS LEVEL:  message" returns written length
+	size_t formatRecord(const LogRecord& record, char* out, size_t size);
+	const char* levelName(eLogLevel level);
+
+	//OutputDebugString on windows, os_log on apple
+	class PlatformSink : public LogSink {
+	public:
+		void write(const LogRecord& record) override;
+	};
+
+	class StdoutSink : public LogSink {
+	public:
+		void write(const LogRecord& record) override;
+		void flush() override;
+	};
+
+	class FileSink : public LogSink {
+	public:
+		FileSink(const std::string& path, bool append = false);
+		~FileSink() override;
+
+		void write(const LogRecord& record) override;
+		void flush() override;
+
+		bool isOpen() const { return mFile; }
+
+	private:
+		FILE* mFile = nullptr;
+	};
+
+	//keeps last Capacity records in memory, for debug windows and crash reports
+	class RingBufferSink : public LogSink {
+	public:
+		RingBufferSink(size_t capacity = 512);
+
+		void write(const LogRecord& record) override;
+
+		//copy of last stored records from oldest to newest, can be called from any thread
+		std::vector<LogRecord> getRecords(size_t maxCount = std::numeric_limits<size_t>::max()) const;
+		size_t getWrittenCount() const;
+
+	private:
+		mutable std::mutex mMutex;
+		std::vector<LogRecord> mRecords;
+		size_t mHead = 0;
+		size_t mWritten = 0;
+	};
+}
@@ -1,64 +1,454 @@
 #include "logger.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#ifdef __APPLE__
-#include <os/log.h>
-#else
-#include <REND.h>
-#endif
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-#include "chrono"
-#include <sstream>
-#include <ctime>
-#include <iomanip>
+#include "LogSinks.h"
+#include "containersModule/MPSCQueue.h"
 
 using namespace SFE::LogsModule;
 
-void Logger::logMessage(const eLogLevel level, const char* msg) {
-	auto t = time(nullptr);
-	
-	std::ostringstream oss;
-	tm buf;
-#ifdef __APPLE__
-	localtime_r(&t ,&buf);
-	uint8_t logType;
-#else
-	localtime_s(&buf, &t);
-#endif
-
-	oss << std::put_time(&buf, "%d/%m/%y %H:%M:%S ");
-
-	switch (level) {
-	case eLogLevel::WARNING:
-#ifdef __APPLE__
-		logType = OS_LOG_TYPE_ERROR;
-#endif
-		oss << "WARNING:  ";
-		break;
-	case eLogLevel::ERROR_:
-#ifdef __APPLE__
-		logType = OS_LOG_TYPE_ERROR;
-#endif
-		oss << "ERROR:  ";
-		break;
-	case eLogLevel::INFO:
-#ifdef __APPLE__
-		logType = OS_LOG_TYPE_INFO;
-#endif
-		break;
-	case eLogLevel::FATAL:
-#ifdef __APPLE__
-		logType = OS_LOG_TYPE_FAULT;
-#endif
-		oss << "FATAL:  ";
+namespace {
+	int64_t nowNs() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	}
-	oss << msg << "\n";
-#ifdef __APPLE__
-	os_log_with_type(OS_LOG_DEFAULT, os_log_type_t(logType), "%s", oss.str().c_str());
-#else
-	OutputDebugString(oss.str().c_str());
-#endif
+
+	int64_t steadyNs() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint32_t currentThreadId() {
+		static std::atomic<uint32_t> counter = 0;
+		thread_local const uint32_t id = counter++;
+		return id;
+	}
+
+	//call sites are identified by format string address, so it costs one hash of pointer, no string compare
+	class RateLimiter {
+		constexpr static size_t SLOTS = 512;
+		constexpr static size_t PROBES = 8;
+		constexpr static int64_t WINDOW = 1'000'000'000;
+
+		struct Slot {
+			std::atomic<const char*> site = nullptr;
+			std::atomic<int64_t> windowStart = 0;
+			std::atomic<uint32_t> count = 0;
+			std::atomic<uint32_t> suppressed = 0;
+		};
+
+	public:
+		bool pass(const char* site, uint32_t& suppressed) {
+			const auto limit = mLimit.load(std::memory_order_relaxed);
+			if (!limit) {
+				return true;
+			}
+
+			auto slot = findSlot(site);
+			if (!slot) {
+				return true; //table is full, don't limit
+			}
+
+			const auto now = steadyNs();
+			auto start = slot->windowStart.load(std::memory_order_relaxed);
+			if (now - start > WINDOW) {
+				if (slot->windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+					slot->count.store(0, std::memory_order_relaxed);
+				}
+			}
+
+			if (slot->count.fetch_add(1, std::memory_order_relaxed) >= limit) {
+				slot->suppressed.fetch_add(1, std::memory_order_relaxed);
+				mPending.fetch_add(1, std::memory_order_relaxed);
+				mTotal.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			suppressed = slot->suppressed.exchange(0, std::memory_order_relaxed);
+			mPending.fetch_sub(suppressed, std::memory_order_relaxed);
+			return true;
+		}
+
+		//call site which went quiet never logs the count with its next message, so logger thread reports it after the window
+		template<typename Func>
+		void takeSuppressed(bool all, Func&& report) {
+			if (!mPending.load(std::memory_order_relaxed)) {
+				return;
+			}
+
+			const auto now = steadyNs();
+			for (auto& slot : mSlots) {
+				const auto site = slot.site.load(std::memory_order_acquire);
+				if (!site || !slot.suppressed.load(std::memory_order_relaxed)) {
+					continue;
+				}
+				if (!all && now - slot.windowStart.load(std::memory_order_relaxed) <= WINDOW) {
+					continue;
+				}
+
+				if (const auto count = slot.suppressed.exchange(0, std::memory_order_relaxed)) {
+					mPending.fetch_sub(count, std::memory_order_relaxed);
+					report(site, count);
+				}
+			}
+		}
+
+		bool hasPending() const { return mPending.load(std::memory_order_relaxed); }
+		size_t getTotal() const { return mTotal.load(std::memory_order_relaxed); }
+
+		std::atomic<uint32_t> mLimit = 100;
+
+	private:
+		Slot* findSlot(const char* site) {
+			auto idx = (reinterpret_cast<uintptr_t>(site) >> 3) * 0x9E3779B97F4A7C15ull;
+			for (size_t i = 0; i < PROBES; i++) {
+				auto& slot = mSlots[(idx + i) % SLOTS];
+				auto current = slot.site.load(std::memory_order_acquire);
+				if (current == site) {
+					return &slot;
+				}
+
+				if (!current && slot.site.compare_exchange_strong(current, site, std::memory_order_acq_rel)) {
+					return &slot;
+				}
+
+				if (current == site) {
+					return &slot;
+				}
+			}
+
+			return nullptr;
+		}
+
+		Slot mSlots[SLOTS];
+		std::atomic<uint32_t> mPending = 0;
+		std::atomic<size_t> mTotal = 0;
+	};
+
+	RateLimiter& rateLimiter() {
+		static RateLimiter limiter;
+		return limiter;
+	}
+
+	class LogWorker {
+	public:
+		constexpr static size_t QUEUE_SIZE = 2048;
+		constexpr static size_t IDLE_SPINS = 2000;
+
+		static LogWorker& instance() {
+			static LogWorker worker;
+			return worker;
+		}
+
+		LogWorker() {
+			mSinks.push_back(new PlatformSink());
+			mRunning = true;
+			mThread = std::thread([this] { run(); });
+		}
+
+		~LogWorker() {
+			stop();
+			for (auto sink : mSinks) {
+				delete sink;
+			}
+		}
+
+		void push(eLogLevel level, const char* msg, uint32_t suppressed) {
+			if (!mRunning.load(std::memory_order_acquire)) {
+				LogRecord record;
+				fill(record, level, msg, suppressed);
+				std::unique_lock lock(mSinksMutex);
+				writeToSinks(record);
+				flushSinks();
+				return;
+			}
+
+			const bool pushed = mQueue.tryEmplace([level, msg, suppressed](LogRecord& record) {
+				fill(record, level, msg, suppressed);
+			});
+
+			if (!pushed) {
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+				if (level != eLogLevel::FATAL) {
+					return;
+				}
+
+				//fatal message should not be lost, wait for the space
+				while (!mQueue.tryEmplace([level, msg, suppressed](LogRecord& record) { fill(record, level, msg, suppressed); })) {
+					wake();
+					std::this_thread::yield();
+				}
+			}
+
+			wakeIfSleeping();
+		}
+
+		void flush() {
+			if (!mRunning.load(std::memory_order_acquire)) {
+				std::unique_lock lock(mSinksMutex);
+				flushSinks();
+				return;
+			}
+
+			const auto target = mConsumed.load(std::memory_order_acquire) + mQueue.sizeApprox();
+			mFlushRequested.store(true, std::memory_order_release);
+			wake();
+			while (mRunning.load(std::memory_order_acquire) && mFlushed.load(std::memory_order_acquire) < target) {
+				mFlushRequested.store(true, std::memory_order_release);
+				wake();
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+
+		void stop() {
+			if (!mRunning.exchange(false)) {
+				return;
+			}
+
+			wake();
+			if (mThread.joinable()) {
+				mThread.join();
+			}
+
+			//somebody could push while the thread was finishing
+			std::unique_lock lock(mSinksMutex);
+			mQueue.consumeAll([this](LogRecord& record) { writeToSinks(record); });
+			reportSuppressed(true);
+			flushSinks();
+		}
+
+		void addSink(LogSink* sink) {
+			std::unique_lock lock(mSinksMutex);
+			mSinks.push_back(sink);
+		}
+
+		void removeSink(LogSink* sink) {
+			std::unique_lock lock(mSinksMutex);
+			if (std::erase(mSinks, sink)) {
+				sink->flush();
+				delete sink;
+			}
+		}
+
+		size_t getQueueSize() const { return mQueue.sizeApprox(); }
+
+		std::atomic<size_t> mDropped = 0;
+		std::atomic_bool mMuted = false;
+
+	private:
+		static void fill(LogRecord& record, eLogLevel level, const char* msg, uint32_t suppressed) {
+			record.level = level;
+			record.timestamp = nowNs();
+			record.threadId = currentThreadId();
+			record.suppressed = suppressed;
+			const auto len = strnlen(msg, LOG_MESSAGE_SIZE - 1);
+			memcpy(record.message, msg, len);
+			record.message[len] = '\0';
+			record.length = static_cast<uint32_t>(len);
+		}
+
+		void writeToSinks(const LogRecord& record) {
+			if (mMuted.load(std::memory_order_relaxed) && record.level != eLogLevel::FATAL) {
+				return;
+			}
+
+			for (auto sink : mSinks) {
+				if (record.level >= sink->minLevel) {
+					sink->write(record);
+				}
+			}
+		}
+
+		//sinks mutex should be locked
+		void reportSuppressed(bool all) {
+			rateLimiter().takeSuppressed(all, [this](const char* site, uint32_t count) {
+				LogRecord record;
+				fill(record, eLogLevel::WARNING, "", 0);
+				const auto written = snprintf(record.message, LOG_MESSAGE_SIZE, "%u messages were suppressed by rate limit: %s", count, site);
+				record.length = static_cast<uint32_t>(std::clamp(written, 0, static_cast<int>(LOG_MESSAGE_SIZE - 1)));
+				writeToSinks(record);
+			});
+		}
+
+		void flushSinks() {
+			for (auto sink : mSinks) {
+				sink->flush();
+			}
+		}
+
+		void wake() {
+			mWakeCounter.fetch_add(1, std::memory_order_release);
+			mWakeCounter.notify_one();
+		}
+
+		void wakeIfSleeping() {
+			//pairs with the fence in run, either consumer sees the record or producer sees sleeping flag
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (mSleeping.load(std::memory_order_relaxed) && mSleeping.exchange(false, std::memory_order_relaxed)) {
+				wake();
+			}
+		}
+
+		void run() {
+			while (mRunning.load(std::memory_order_acquire)) {
+				const auto wakeValue = mWakeCounter.load(std::memory_order_acquire);
+
+				size_t consumed = 0;
+				{
+					std::unique_lock lock(mSinksMutex);
+					consumed = mQueue.consumeAll([this](LogRecord& record) { writeToSinks(record); });
+					mConsumed.fetch_add(consumed, std::memory_order_release);
+
+					if (mFlushRequested.exchange(false, std::memory_order_acq_rel)) {
+						reportSuppressed(true);
+						flushSinks();
+						mFlushed.store(mConsumed.load(std::memory_order_relaxed), std::memory_order_release);
+					}
+				}
+
+				if (consumed) {
+					mIdleSpins = 0;
+					continue;
+				}
+
+				//logs usually come in bursts, stay awake for a while so producers don't pay for the wake up syscall
+				if (mIdleSpins++ < IDLE_SPINS) {
+					std::this_thread::yield();
+					continue;
+				}
+				mIdleSpins = 0;
+
+				{
+					std::unique_lock lock(mSinksMutex);
+					reportSuppressed(false);
+				}
+
+				//suppressed counts wait for the end of their window, so thread can't sleep until somebody logs
+				if (rateLimiter().hasPending()) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+					continue;
+				}
+
+				mSleeping.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (mQueue.sizeApprox() == 0 && !mFlushRequested.load(std::memory_order_acquire)) {
+					mWakeCounter.wait(wakeValue, std::memory_order_acquire);
+				}
+				mSleeping.store(false, std::memory_order_relaxed);
+			}
+		}
+
+		SFE::MPSCQueue<LogRecord, QUEUE_SIZE> mQueue;
+
+		std::mutex mSinksMutex;
+		std::vector<LogSink*> mSinks;
+
+		std::thread mThread;
+		std::atomic_bool mRunning = false;
+		std::atomic_bool mSleeping = false;
+		std::atomic_bool mFlushRequested = false;
+		std::atomic<uint32_t> mWakeCounter = 0;
+		size_t mIdleSpins = 0;
+
+		std::atomic<size_t> mConsumed = 0;
+		std::atomic<size_t> mFlushed = 0; //consumed count at the moment of last sinks flush
+	};
+
+}
+
+bool Logger::rateLimit(eLogLevel level, const char* callSite, uint32_t& suppressed) {
+	if (level == eLogLevel::FATAL) {
+		return true;
+	}
+
+	return rateLimiter().pass(callSite, suppressed);
+}
+
+void Logger::logMessage(const eLogLevel level, const char* msg, uint32_t suppressed) {
+	auto& worker = LogWorker::instance();
+	worker.push(level, msg, suppressed);
+
 	if (level == eLogLevel::FATAL) {
+		worker.flush();
 		assert(false && msg);
 	}
 }
+
+void Logger::flush() {
+	LogWorker::instance().flush();
+}
+
+void Logger::shutdown() {
+	LogWorker::instance().stop();
+}
+
+void Logger::setRateLimit(uint32_t messagesPerSecond) {
+	rateLimiter().mLimit.store(messagesPerSecond, std::memory_order_relaxed);
+}
+
+void Logger::addSink(LogSink* sink) {
+	if (sink) {
+		LogWorker::instance().addSink(sink);
+	}
+}
+
+void Logger::removeSink(LogSink* sink) {
+	LogWorker::instance().removeSink(sink);
+}
+
+size_t Logger::getDroppedCount() {
+	return LogWorker::instance().mDropped.load(std::memory_order_relaxed);
+}
+
+size_t Logger::getSuppressedCount() {
+	return rateLimiter().getTotal();
+}
+
+size_t Logger::getQueueSize() {
+	return LogWorker::instance().getQueueSize();
+}
+
+Logger::BenchmarkResult Logger::benchmark(size_t iterations) {
+	BenchmarkResult result;
+	if (!iterations) {
+		return result;
+	}
+
+	auto& worker = LogWorker::instance();
+	worker.flush();
+
+	const auto prevLimit = rateLimiter().mLimit.exchange(0);
+	const auto droppedBefore = worker.mDropped.load();
+	worker.mMuted = true;
+
+	std::vector<int64_t> samples;
+	samples.resize(iterations);
+
+	const auto start = steadyNs();
+	for (size_t i = 0; i < iterations; i++) {
+		const auto callStart = steadyNs();
+		LOG_INFO("logger benchmark message %zu, value %f, text %s", i, static_cast<double>(i) * 0.5, "payload");
+		samples[i] = steadyNs() - callStart;
+	}
+	const auto total = steadyNs() - start;
+
+	worker.flush();
+	worker.mMuted = false;
+	rateLimiter().mLimit = prevLimit;
+
+	std::ranges::sort(samples);
+	result.avgNs = static_cast<double>(total) / static_cast<double>(iterations);
+	result.p50Ns = static_cast<double>(samples[iterations / 2]);
+	result.p99Ns = static_cast<double>(samples[std::min(iterations - 1, iterations * 99 / 100)]);
+	result.maxNs = static_cast<double>(samples.back());
+	result.dropped = worker.mDropped.load() - droppedBefore;
+
+	LOG_INFO("Logger::benchmark %zu calls: avg %.1f ns, p50 %.1f ns, p99 %.1f ns, max %.1f ns, dropped %zu", iterations, result.avgNs, result.p50Ns, result.p99Ns, result.maxNs, result.dropped);
+
+	return result;
+}
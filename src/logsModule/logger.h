@@ -1,10 +1,23 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cwchar>
 #include <stdio.h>
 #include <wchar.h>
 
+//minimal level which will be compiled into binary, calls below it are removed by "if constexpr" and cost nothing
+//0 - INFO, 1 - WARNING, 2 - ERROR, 3 - FATAL
+#ifndef SFE_LOG_MIN_LEVEL
+#define SFE_LOG_MIN_LEVEL 0
+#endif
+
+//removed calls don't evaluate their arguments either, so logging should go through these macros
+#define SFE_LOG_INFO(...) do { if constexpr (SFE_LOG_MIN_LEVEL <= 0) { SFE::LogsModule::Logger::LOG_INFO(__VA_ARGS__); } } while (false)
+#define SFE_LOG_WARNING(...) do { if constexpr (SFE_LOG_MIN_LEVEL <= 1) { SFE::LogsModule::Logger::LOG_WARNING(__VA_ARGS__); } } while (false)
+#define SFE_LOG_ERROR(...) do { if constexpr (SFE_LOG_MIN_LEVEL <= 2) { SFE::LogsModule::Logger::LOG_ERROR(__VA_ARGS__); } } while (false)
+#define SFE_LOG_FATAL(...) SFE::LogsModule::Logger::LOG_FATAL(__VA_ARGS__)
+
 namespace SFE::LogsModule {
 	enum class eLogLevel {
 		INFO,
@@ -13,41 +26,65 @@ namespace SFE::LogsModule {
 		FATAL
 	};
 
+	constexpr size_t LOG_MESSAGE_SIZE = 2048;
+
+	class LogSink;
+
+	//structured log entry, it is formatted on the calling thread and passed to sinks as is, sinks decide how to print it
+	struct LogRecord {
+		eLogLevel level = eLogLevel::INFO;
+		int64_t timestamp = 0; //nanoseconds since epoch
+		uint32_t threadId = 0;
+		uint32_t suppressed = 0; //how many same messages was dropped by rate limiter before this one
+		uint32_t length = 0;
+		char message[LOG_MESSAGE_SIZE];
+	};
+
 	class Logger {
-		inline static char msgBuf[2048];
+		//per thread buffer, so threads never share formatting memory
+		inline static thread_local char msgBuf[LOG_MESSAGE_SIZE];
 
 		template <typename... Args>
 		static const char* format_internal(const char* msg,const Args&... args) {
-			snprintf(msgBuf, 2048, msg, args...);
+			snprintf(msgBuf, LOG_MESSAGE_SIZE, msg, args...);
 			return msgBuf;
 		}
 
-		template <typename... Args>
-		static void log(eLogLevel level, const char* msg,const Args&... args) {
-			constexpr size_t count = sizeof...(args);
-			if (count > 0) {
-				msg = format_internal(msg, args...);
+		template <eLogLevel Level, typename... Args>
+		static void log(const char* msg,const Args&... args) {
+			if constexpr (static_cast<int>(Level) >= SFE_LOG_MIN_LEVEL) {
+				uint32_t suppressed = 0;
+				if (!rateLimit(Level, msg, suppressed)) {
+					return;
+				}
+
+				constexpr size_t count = sizeof...(args);
+				if constexpr (count > 0) {
+					msg = format_internal(msg, args...);
+				}
+
+				logMessage(Level, msg, suppressed);
 			}
-			
-			logMessage(level, msg);
 		}
 
-		static void logMessage(eLogLevel level, const char* msg);
+		//returns false if message from this call site should be dropped, suppressed - count of messages dropped since last passed one
+		static bool rateLimit(eLogLevel level, const char* callSite, uint32_t& suppressed);
+		static void logMessage(eLogLevel level, const char* msg, uint32_t suppressed = 0);
 
 	public:
 		template <typename... Args>
 		static void LOG_INFO(const char* msg,const Args&... args) {
-			log(eLogLevel::INFO, msg, args...);
+			log<eLogLevel::INFO>(msg, args...);
 		}
 
 		template <typename... Args>
 		static void LOG_ERROR(const char* msg,const Args&... args) {
-			log(eLogLevel::ERROR_, msg, args...);
+			log<eLogLevel::ERROR_>(msg, args...);
 		}
 
 		template <typename... Args>
 		static void LOG_WARNING(const char* msg,const Args&... args) {
-			log(eLogLevel::WARNING, msg, args...);
+			log<eLogLevel::WARNING>(msg, args...);
 		}
 
 		template <typename... Args>
@@ -56,7 +93,37 @@ namespace SFE::LogsModule {
 				return;
 			}
 
-			log(eLogLevel::FATAL, msg, args...);
+			log<eLogLevel::FATAL>(msg, args...);
 		}
+
+		//blocks until everything that was logged before the call is written by sinks
+		static void flush();
+		//stops sink thread, logs after it are written synchronously
+		static void shutdown();
+
+		//messages from one call site (format string) above this count per second are dropped, 0 - disabled
+		static void setRateLimit(uint32_t messagesPerSecond);
+
+		//logger takes ownership of the sink, platform sink is added by default
+		static void addSink(LogSink* sink);
+		//removes and deletes the sink
+		static void removeSink(LogSink* sink);
+
+		//messages which didn't fit into the queue
+		static size_t getDroppedCount();
+		//messages dropped by rate limiter, counts of every call site are reported to sinks too
+		static size_t getSuppressedCount();
+		static size_t getQueueSize();
+
+		struct BenchmarkResult {
+			double avgNs = 0.0;
+			double p50Ns = 0.0;
+			double p99Ns = 0.0;
+			double maxNs = 0.0;
+			size_t dropped = 0;
+		};
+
+		//measures cost of a formatted log call on the calling thread (format + enqueue), sinks output is muted while it runs
+		static BenchmarkResult benchmark(size_t iterations = 100000);
 	};
 }
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SFE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace SFE::Math {
+	//four floats at once, scalar fallback keeps the same results where SSE2 isn't available
+	//comparisons return lane masks which are used by select and movemask
+#ifdef SFE_SSE
+	struct Float4 {
+		__m128 v;
+
+		static Float4 zero() { return { _mm_setzero_ps() }; }
+		static Float4 set(float a) { return { _mm_set1_ps(a) }; }
+		static Float4 set(float a, float b, float c, float d) { return { _mm_setr_ps(a, b, c, d) }; }
+		static Float4 load(const float* ptr) { return { _mm_loadu_ps(ptr) }; }
+		static Float4 loadBytes(const uint8_t* ptr) {
+			int32_t bytes;
+			std::memcpy(&bytes, ptr, sizeof(bytes));
+			const auto zero = _mm_setzero_si128();
+			return { _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero)) };
+		}
+		void store(float* ptr) const { _mm_storeu_ps(ptr, v); }
+		//rounds and saturates to [0, 255]
+		void storeBytes(uint8_t* ptr) const {
+			const auto words = _mm_packs_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+			const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+			std::memcpy(ptr, &bytes, sizeof(bytes));
+		}
+
+		friend Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+		friend Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+		friend Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+		friend Float4 operator*(Float4 a, float b) { return { _mm_mul_ps(a.v, _mm_set1_ps(b)) }; }
+		friend Float4 min(Float4 a, Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+		friend Float4 max(Float4 a, Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+
+		friend Float4 operator<=(Float4 a, Float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+		friend Float4 operator>=(Float4 a, Float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+		friend Float4 operator&(Float4 a, Float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+		//a where mask is set, b otherwise
+		friend Float4 select(Float4 mask, Float4 a, Float4 b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+		//bit i is set when lane i of mask is set
+		friend int movemask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+	};
+#else
+	struct Float4 {
+		float v[4];
+
+		static Float4 zero() { return { { 0.f, 0.f, 0.f, 0.f } }; }
+		static Float4 set(float a) { return { { a, a, a, a } }; }
+		static Float4 set(float a, float b, float c, float d) { return { { a, b, c, d } }; }
+		static Float4 load(const float* ptr) { return { { ptr[0], ptr[1], ptr[2], ptr[3] } }; }
+		static Float4 loadBytes(const uint8_t* ptr) { return { { static_cast<float>(ptr[0]), static_cast<float>(ptr[1]), static_cast<float>(ptr[2]), static_cast<float>(ptr[3]) } }; }
+		void store(float* ptr) const { std::memcpy(ptr, v, sizeof(v)); }
+		void storeBytes(uint8_t* ptr) const {
+			for (int i = 0; i < 4; i++) {
+				ptr[i] = static_cast<uint8_t>(std::clamp(std::lround(v[i]), 0l, 255l));
+			}
+		}
+
+		template<typename Op>
+		static Float4 apply(Float4 a, Float4 b, Op op) { return { { op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3]) } }; }
+		static float lane(bool set) { return std::bit_cast<float>(set ? ~0u : 0u); }
+		static bool isSet(float mask) { return std::bit_cast<uint32_t>(mask) != 0; }
+
+		friend Float4 operator+(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+		friend Float4 operator-(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+		friend Float4 operator*(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+		friend Float4 operator*(Float4 a, float b) { return a * set(b); }
+		friend Float4 min(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return std::min(x, y); }); }
+		friend Float4 max(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return std::max(x, y); }); }
+
+		friend Float4 operator<=(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return lane(x <= y); }); }
+		friend Float4 operator>=(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return lane(x >= y); }); }
+		friend Float4 operator&(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return lane(isSet(x) && isSet(y)); }); }
+		friend Float4 select(Float4 mask, Float4 a, Float4 b) {
+			Float4 res;
+			for (int i = 0; i < 4; i++) {
+				res.v[i] = isSet(mask.v[i]) ? a.v[i] : b.v[i];
+			}
+			return res;
+		}
+		friend int movemask(Float4 mask) {
+			int res = 0;
+			for (int i = 0; i < 4; i++) {
+				res |= isSet(mask.v[i]) << i;
+			}
+			return res;
+		}
+	};
+#endif
+}
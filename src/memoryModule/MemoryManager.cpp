@@ -13,15 +13,15 @@ MemoryManager::MemoryManager(size_t memoryCapacity) : mMemoryCapacity(memoryCapa
 	globalMemoryAddress = malloc(mMemoryCapacity);
 
 	if (!globalMemoryAddress) {
-		LogsModule::Logger::LOG_FATAL(globalMemoryAddress, "Failed to allocate %d bytes of memory!", mMemoryCapacity);
+		SFE_LOG_FATAL(globalMemoryAddress, "Failed to allocate %d bytes of memory!", mMemoryCapacity);
 		return;
 	}
-	LogsModule::Logger::LOG_INFO("%u bytes of memory allocated.", mMemoryCapacity);
+	SFE_LOG_INFO("%u bytes of memory allocated.", mMemoryCapacity);
 
 	allocator = new StackAllocator();
 	allocator->init(mMemoryCapacity, globalMemoryAddress);
 
-	LogsModule::Logger::LOG_FATAL(allocator, "Failed to create memory allocator!");
+	SFE_LOG_FATAL(allocator, "Failed to create memory allocator!");
 }
 
 MemoryManager::~MemoryManager() {
@@ -35,16 +35,16 @@ MemoryManager::~MemoryManager() {
 
 void MemoryManager::checkMemoryLeaks() {
 	if (!pendingMemory.empty()) {
-		LogsModule::Logger::LOG_FATAL(false, "!!!  M E M O R Y   L E A K   D E T E C T E D  !!!");
+		SFE_LOG_FATAL(false, "!!!  M E M O R Y   L E A K   D E T E C T E D  !!!");
 
 		for (auto& i : pendingMemory) {
 			auto it = std::ranges::find_if(freedMemory, [i](const void* a) {
 				return i.second == a;
 			});
-			LogsModule::Logger::LOG_FATAL(it != freedMemory.end(), "\'%s\' memory user didn't release allocated memory %p!", i.first, i.second);
+			SFE_LOG_FATAL(it != freedMemory.end(), "\'%s\' memory user didn't release allocated memory %p!", i.first, i.second);
 		}
 	}
 	else {
-		LogsModule::Logger::LOG_INFO("No memory leaks detected.");
+		SFE_LOG_INFO("No memory leaks detected.");
 	}
 }
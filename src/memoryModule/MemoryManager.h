@@ -33,7 +33,7 @@ namespace SFE::MemoryModule {
 		~MemoryManager();
 
 		inline void* allocate(size_t memSize, size_t user) {
-			LogsModule::Logger::LOG_INFO("%zu allocated %d bytes of global memory.", user, memSize);
+			SFE_LOG_INFO("%zu allocated %d bytes of global memory.", user, memSize);
 
 			void* pMemory = allocator->allocate(memSize, alignof(uint8_t));
 			pendingMemory.emplace_back(user, pMemory);
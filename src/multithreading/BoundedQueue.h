@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace SFE {
+	//blocking queue with fixed capacity, producer waits when it is full, consumer waits when it is empty
+	//used for handing frames from simulation thread to render thread, so it gives natural backpressure
+	template<typename T, size_t Capacity>
+	class BoundedQueue {
+		static_assert(Capacity > 0);
+
+	public:
+		//returns false if queue was closed
+		bool push(T value) {
+			auto lock = std::unique_lock(mMutex);
+			mNotFull.wait(lock, [this] { return mSize < Capacity || mClosed; });
+			if (mClosed) {
+				return false;
+			}
+
+			mItems[(mHead + mSize) % Capacity] = std::move(value);
+			mSize++;
+			lock.unlock();
+			mNotEmpty.notify_one();
+
+			return true;
+		}
+
+		//returns false if queue was closed and all items were consumed
+		bool pop(T& value) {
+			auto lock = std::unique_lock(mMutex);
+			mNotEmpty.wait(lock, [this] { return mSize > 0 || mClosed; });
+			if (mSize == 0) {
+				return false;
+			}
+
+			value = std::move(mItems[mHead]);
+			mHead = (mHead + 1) % Capacity;
+			mSize--;
+			lock.unlock();
+			mNotFull.notify_one();
+
+			return true;
+		}
+
+		bool tryPop(T& value) {
+			auto lock = std::unique_lock(mMutex);
+			if (mSize == 0) {
+				return false;
+			}
+
+			value = std::move(mItems[mHead]);
+			mHead = (mHead + 1) % Capacity;
+			mSize--;
+			lock.unlock();
+			mNotFull.notify_one();
+
+			return true;
+		}
+
+		//wakes up everybody, push fails after it, pop returns remaining items
+		void close() {
+			{
+				auto lock = std::unique_lock(mMutex);
+				mClosed = true;
+			}
+			mNotFull.notify_all();
+			mNotEmpty.notify_all();
+		}
+
+		size_t size() {
+			auto lock = std::unique_lock(mMutex);
+			return mSize;
+		}
+
+		constexpr static size_t capacity() { return Capacity; }
+
+	private:
+		std::mutex mMutex;
+		std::condition_variable mNotFull;
+		std::condition_variable mNotEmpty;
+
+		std::array<T, Capacity> mItems{};
+		size_t mHead = 0;
+		size_t mSize = 0;
+		bool mClosed = false;
+	};
+}
@@ -0,0 +1,71 @@
+﻿#include "JoltJobSystem.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "ThreadPool.h"
+#include "core/FramePacing.h"
+
+namespace SFE {
+	JoltJobSystem::JoltJobSystem(JPH::uint maxJobs, JPH::uint maxBarriers, int maxConcurrency) : JobSystemWithBarrier(maxBarriers), mMaxConcurrency(std::max(maxConcurrency, 1)) {
+		mJobs.Init(maxJobs, maxJobs);
+	}
+
+	JoltJobSystem::~JoltJobSystem() {
+		//queued tasks keep references to jobs of free list
+		while (mInFlight.load(std::memory_order_acquire) != 0) {
+			std::this_thread::yield();
+		}
+	}
+
+	JoltJobSystem::JobHandle JoltJobSystem::CreateJob(const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies) {
+		JPH::uint32 index;
+		while ((index = mJobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies)) == AvailableJobs::cInvalidObjectIndex) {
+			JPH_ASSERT(false, "JoltJobSystem::no jobs available");
+			std::this_thread::yield();
+		}
+
+		auto job = &mJobs.Get(index);
+		//handle keeps job alive, it can be finished before return
+		JobHandle handle(job);
+		if (inNumDependencies == 0) {
+			QueueJob(job);
+		}
+		return handle;
+	}
+
+	void JoltJobSystem::QueueJob(Job* inJob) {
+		inJob->AddRef();
+		const auto inFlight = mInFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+		auto maxInFlight = mMaxInFlight.load(std::memory_order_relaxed);
+		while (inFlight > maxInFlight && !mMaxInFlight.compare_exchange_weak(maxInFlight, inFlight, std::memory_order_relaxed)) {}
+
+		ThreadPool::instance()->addTask([this, inJob, queued = CoreModule::monotonicNs()]() {
+			mQueueWaitNs.fetch_add(static_cast<uint64_t>(CoreModule::monotonicNs() - queued), std::memory_order_relaxed);
+			mJobsCount.fetch_add(1, std::memory_order_relaxed);
+
+			//job which was already taken by waiting thread isn't executed twice
+			inJob->Execute();
+			inJob->Release();
+			mInFlight.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	void JoltJobSystem::QueueJobs(Job** inJobs, JPH::uint inNumJobs) {
+		for (JPH::uint i = 0; i < inNumJobs; i++) {
+			QueueJob(inJobs[i]);
+		}
+	}
+
+	void JoltJobSystem::FreeJob(Job* inJob) {
+		mJobs.DestructObject(inJob);
+	}
+
+	JoltJobSystem::Stats JoltJobSystem::takeStats() {
+		Stats stats;
+		stats.jobs = mJobsCount.exchange(0, std::memory_order_relaxed);
+		stats.queueWaitNs = mQueueWaitNs.exchange(0, std::memory_order_relaxed);
+		stats.maxInFlight = mMaxInFlight.exchange(0, std::memory_order_relaxed);
+		return stats;
+	}
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+
+namespace SFE {
+	//jolt jobs are executed by common workers of ThreadPool instead of threads of their own, so physics shares workers with other systems
+	//thread which waits on barrier executes jobs of this barrier too, so step goes on even when all workers are busy
+	class JoltJobSystem final : public JPH::JobSystemWithBarrier {
+	public:
+		struct Stats {
+			uint64_t jobs = 0;
+			uint64_t queueWaitNs = 0; //sum of time from queueing to start on worker
+			uint32_t maxInFlight = 0;
+		};
+
+		JoltJobSystem(JPH::uint maxJobs, JPH::uint maxBarriers, int maxConcurrency);
+		~JoltJobSystem() override;
+
+		int GetMaxConcurrency() const override { return mMaxConcurrency; }
+		JobHandle CreateJob(const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies = 0) override;
+
+		//stats since previous call
+		Stats takeStats();
+
+	protected:
+		void QueueJob(Job* inJob) override;
+		void QueueJobs(Job** inJobs, JPH::uint inNumJobs) override;
+		void FreeJob(Job* inJob) override;
+
+	private:
+		using AvailableJobs = JPH::FixedSizeFreeList<Job>;
+		AvailableJobs mJobs;
+		int mMaxConcurrency = 1;
+
+		std::atomic<uint32_t> mInFlight = 0;
+		std::atomic<uint64_t> mJobsCount = 0;
+		std::atomic<uint64_t> mQueueWaitNs = 0;
+		std::atomic<uint32_t> mMaxInFlight = 0;
+	};
+}
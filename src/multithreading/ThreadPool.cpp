@@ -9,16 +9,41 @@ namespace SFE {
 
 	ThreadPool::~ThreadPool() {
 		glfwDestroyWindow(mLoadingWindow);
+		glfwDestroyWindow(mUploadWindow);
+	}
+
+	void ThreadPool::initLoadingContext() {
+		if (mLoadingWindow) {
+			return;
+		}
+
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // Create an invisible window
+		mLoadingWindow = glfwCreateWindow(1, 1, "loading", nullptr, Engine::instance()->getMainWindow());
+		mUploadWindow = glfwCreateWindow(1, 1, "upload", nullptr, Engine::instance()->getMainWindow());
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	}
+
+	void ThreadPool::wait(const std::shared_future<void>& future) {
+		if (!future.valid()) {
+			return;
+		}
+
+		if (!mCommonWorkers.isWorkerThread()) {
+			future.wait();
+			return;
+		}
+
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			//task we wait for can be queued behind others, help to drain the queue instead of blocking a worker
+			if (!mCommonWorkers.tryExecuteTask()) {
+				future.wait_for(std::chrono::microseconds(100));
+			}
+		}
 	}
 
 	void ThreadPool::syncUpdate() {
 		FUNCTION_BENCHMARK;
-		if (!mLoadingWindow) {
-			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // Create an invisible window
-			mLoadingWindow = glfwCreateWindow(1, 1, "loading", nullptr, Engine::instance()->getMainWindow());
-			glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
-		}
-		while (!mSyncTasks.empty()) { //mainThreadTasksQueue can be popped only in main thread, and update calling only in main thread, so it safe to check empty without lock
+		while (!mSyncTasks.empty()) { //sync queue can be popped only in render thread, and update calling only in render thread, so it safe to check empty without lock
 			auto task = std::move(mSyncTasks.front());
 			{
 				std::lock_guard lock(mSyncMtx);
@@ -46,4 +71,12 @@ namespace SFE {
 			glfwMakeContextCurrent(nullptr);
 		});
 	}
+
+	std::shared_future<void> ThreadPool::addUploadTask(std::function<void()>&& task) {
+		return mUploadWorkers.addTask([this, task]() {
+			glfwMakeContextCurrent(mUploadWindow);
+			task();
+			glfwMakeContextCurrent(nullptr);
+		});
+	}
 }
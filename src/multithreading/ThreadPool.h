@@ -12,6 +12,7 @@
 #include <core/Engine.h>
 
 #include "containersModule/Singleton.h"
+#include "multithreading/WorkersPool.h"
 
 namespace SFE {
 
@@ -44,77 +45,16 @@ namespace SFE {
 			futures.push_back(future);
 		}
 
-		void waitAll() const {
-			for (auto& future : futures) {
-				future.wait();
-			}
-			futures.clear();
-		}
-	};
-
-	template<size_t Size>
-	struct WorkersPool {
-		WorkersPool() {
-			mWorkers.reserve(Size);
-
-			for (auto i = 0u; i < Size; i++) {
-				mWorkers.emplace_back(std::thread([this, task = std::packaged_task<void()>()]()mutable {
-					while (!mTerminating) {
-						mMutex.lock();
-						if (mTasksQueue.size()) {
-							task = std::move(mTasksQueue.front());
-							mTasksQueue.pop();
-							mMutex.unlock();
-
-							task();
-						}
-						else {
-							mMutex.unlock();
-							auto mtx = std::unique_lock(mMutex);
-							mCondition.wait(mtx);
-						}
-					}
-				}));
-			}
-		}
-
-		~WorkersPool() {
-			mTerminating = true;
-			
-			mMutex.lock();
-			mCondition.notify_all();
-			mMutex.unlock();
-			
-
-			for (auto& worker : mWorkers) {
-				worker.join();
-			}
-		}
-
-		std::shared_future<void> addTask(std::function<void()>&& task) {
-			std::lock_guard lock(mMutex);
-			mTasksQueue.emplace(std::packaged_task(std::move(task)));
-			auto future = mTasksQueue.back().get_future();
-			mCondition.notify_one();
-
-			return future;
-		}
-
-	private:
-		std::vector<std::thread> mWorkers;
-		std::queue<std::packaged_task<void()>> mTasksQueue;
-
-		std::mutex mMutex;
-		std::condition_variable mCondition;
-
-		bool mTerminating = false;
+		//common worker executes queued common tasks meanwhile, so nested waits can't starve the pool, other threads just block
+		void waitAll() const;
 	};
 
 	enum class WorkerType {
 		COMMON,
 		RENDER,
 		SYNC,
-		RESOURCE_LOADING
+		RESOURCE_LOADING,
+		GPU_UPLOAD //one thread with its own shared context, so uploads are executed in order, task waits for gpu before other threads use its results
 	};
 
 	class ThreadPool : public Singleton<ThreadPool> {
@@ -151,29 +91,52 @@ namespace SFE {
 				return addTaskToSynchronization(std::move(task));
 			case WorkerType::RESOURCE_LOADING:
 				return addLoadingTask(std::move(task));
+			case WorkerType::GPU_UPLOAD:
+				return addUploadTask(std::move(task));
 			}
 
 			assert(false);
 			return {};
 		}
 
-		void syncUpdate();//todo create separate thread with opengl shared context
+		size_t getCommonWorkersCount() const { return mCommonWorkers.size(); }
+
+		//waits for future, common worker executes queued common tasks while it isn't ready.
+		//main and render threads don't help, any queued task can be long and would stall their frame
+		void wait(const std::shared_future<void>& future);
+
+		//executes SYNC tasks, called from render thread
+		void syncUpdate();
+		//glfw windows can be created only from main thread, so shared contexts for loading and upload workers are created before render thread start
+		void initLoadingContext();
 
 	private:
 		std::shared_future<void> addTaskToSynchronization(std::function<void()>&& task);
 		std::shared_future<void> addLoadingTask(std::function<void()>&& task);
+		std::shared_future<void> addUploadTask(std::function<void()>&& task);
 
-		constexpr static inline uint8_t MAX_WORKERS = 128;
+		//main, render and physics tick threads, common tasks are short cpu work, so more workers than free cores only add switches
+		constexpr static inline uint8_t DEDICATED_THREADS = 3;
 		constexpr static inline uint8_t RENDER_WORKERS = 16;
 		constexpr static inline uint8_t LOADING_WORKERS = 8;
 
-		WorkersPool<MAX_WORKERS> mCommonWorkers;
-		WorkersPool<RENDER_WORKERS> mRenderWorkers;
-		WorkersPool<LOADING_WORKERS> mLoadingWorkers;
+		WorkersPool mCommonWorkers{ getWorkersCount(DEDICATED_THREADS) };
+		WorkersPool mRenderWorkers{ RENDER_WORKERS };
+		WorkersPool mLoadingWorkers{ LOADING_WORKERS };
+		WorkersPool mUploadWorkers{ 1 };
 
 		std::queue<std::packaged_task<void()>> mSyncTasks;
 		std::mutex mSyncMtx;
 
 		GLFWwindow* mLoadingWindow = nullptr;
+		//context can be current only on one thread, so uploads don't share it with loading workers
+		GLFWwindow* mUploadWindow = nullptr;
 	};
+
+	inline void FuturesBunch::waitAll() const {
+		for (auto& future : futures) {
+			ThreadPool::instance()->wait(future);
+		}
+		futures.clear();
+	}
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+﻿#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace SFE {
+	//threads which are busy all the time get their own cores, so pool for cpu tasks doesn't compete with them
+	inline size_t getWorkersCount(size_t dedicatedThreads) {
+		const size_t hardware = std::max(std::thread::hardware_concurrency(), 1u);
+		return hardware > dedicatedThreads ? hardware - dedicatedThreads : 1;
+	}
+
+	struct WorkersPool {
+		explicit WorkersPool(size_t size) {
+			mWorkers.reserve(size);
+
+			for (auto i = 0u; i < size; i++) {
+				mWorkers.emplace_back(std::thread([this, task = std::packaged_task<void()>()]()mutable {
+					sCurrentPool = this;
+					while (!mTerminating) {
+						{
+							auto mtx = std::unique_lock(mMutex);
+							mCondition.wait(mtx, [this] { return mTerminating || !mTasksQueue.empty(); });
+							if (mTasksQueue.empty()) {
+								continue;
+							}
+
+							task = std::move(mTasksQueue.front());
+							mTasksQueue.pop();
+						}
+
+						task();
+					}
+				}));
+			}
+		}
+
+		~WorkersPool() {
+			mMutex.lock();
+			mTerminating = true;
+			mCondition.notify_all();
+			mMutex.unlock();
+
+
+			for (auto& worker : mWorkers) {
+				worker.join();
+			}
+		}
+
+		std::shared_future<void> addTask(std::function<void()>&& task) {
+			std::lock_guard lock(mMutex);
+			mTasksQueue.emplace(std::packaged_task(std::move(task)));
+			auto future = mTasksQueue.back().get_future();
+			mCondition.notify_one();
+
+			return future;
+		}
+
+		size_t size() const { return mWorkers.size(); }
+
+		bool isWorkerThread() const { return sCurrentPool == this; }
+
+		//pops one queued task and executes it on calling thread, returns false if queue is empty
+		bool tryExecuteTask() {
+			std::packaged_task<void()> task;
+			{
+				std::lock_guard lock(mMutex);
+				if (mTasksQueue.empty()) {
+					return false;
+				}
+
+				task = std::move(mTasksQueue.front());
+				mTasksQueue.pop();
+			}
+
+			task();
+			return true;
+		}
+
+	private:
+		std::vector<std::thread> mWorkers;
+		std::queue<std::packaged_task<void()>> mTasksQueue;
+
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+
+		bool mTerminating = false;
+
+		//pool which owns calling thread
+		static inline thread_local const WorkersPool* sCurrentPool = nullptr;
+	};
+}
@@ -0,0 +1,52 @@
+﻿#include "BinaryArchive.h"
+
+#include <cstring>
+
+namespace SFE::PropertiesModule {
+	void BinaryWriter::write(const void* value, size_t size) {
+		if (!size) {
+			return;
+		}
+		const auto offset = mData.size();
+		mData.resize(offset + size);
+		std::memcpy(mData.data() + offset, value, size);
+	}
+
+	void BinaryWriter::writeString(std::string_view value) {
+		write(static_cast<uint32_t>(value.size()));
+		write(value.data(), value.size());
+	}
+
+	bool BinaryReader::read(void* value, size_t size) {
+		if (!mValid || size > mData.size() - mOffset) {
+			mValid = false;
+			return false;
+		}
+		if (size) {
+			std::memcpy(value, mData.data() + mOffset, size);
+		}
+		mOffset += size;
+		return true;
+	}
+
+	bool BinaryReader::readString(std::string& value) {
+		uint32_t length = 0;
+		if (!read(length) || length > getRemaining()) {
+			mValid = false;
+			value.clear();
+			return false;
+		}
+		value.assign(reinterpret_cast<const char*>(mData.data() + mOffset), length);
+		mOffset += length;
+		return true;
+	}
+
+	bool BinaryReader::skip(size_t size) {
+		if (!mValid || size > mData.size() - mOffset) {
+			mValid = false;
+			return false;
+		}
+		mOffset += size;
+		return true;
+	}
+}
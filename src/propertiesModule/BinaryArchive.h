@@ -0,0 +1,79 @@
+﻿#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace SFE::PropertiesModule {
+	//values are written as they lie in memory, so archive is read on the machine with the same byte order
+	class BinaryWriter {
+	public:
+		explicit BinaryWriter(std::vector<uint8_t>& data) : mData(data) {}
+
+		void write(const void* value, size_t size);
+
+		template<typename T>
+		void write(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			write(&value, sizeof(T));
+		}
+
+		void writeString(std::string_view value);
+
+		template<typename T>
+		void writeArray(std::span<const T> values) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			write(static_cast<uint32_t>(values.size()));
+			write(values.data(), values.size_bytes());
+		}
+
+		size_t getSize() const { return mData.size(); }
+
+	private:
+		std::vector<uint8_t>& mData;
+	};
+
+	//reads values in order of writing, the first read out of data makes reader invalid and all next reads fail,
+	//so caller can check reader once after all reads
+	class BinaryReader {
+	public:
+		explicit BinaryReader(std::span<const uint8_t> data) : mData(data) {}
+
+		bool read(void* value, size_t size);
+
+		template<typename T>
+		bool read(T& value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			return read(&value, sizeof(T));
+		}
+
+		bool readString(std::string& value);
+
+		template<typename T>
+		bool readArray(std::vector<T>& values) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			uint32_t count = 0;
+			if (!read(count) || count > getRemaining() / std::max<size_t>(sizeof(T), 1)) {
+				mValid = false;
+				values.clear();
+				return false;
+			}
+			values.resize(count);
+			return read(values.data(), values.size() * sizeof(T));
+		}
+
+		bool skip(size_t size);
+
+		bool isValid() const { return mValid; }
+		size_t getOffset() const { return mOffset; }
+		size_t getRemaining() const { return mValid ? mData.size() - mOffset : 0; }
+
+	private:
+		std::span<const uint8_t> mData;
+		size_t mOffset = 0;
+		bool mValid = true;
+	};
+}
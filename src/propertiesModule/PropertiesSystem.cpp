@@ -1,7 +1,10 @@
 #include "propertiesModule/PropertiesSystem.h"
 #include "core/FileSystem.h"
 
+#include <filesystem>
+
 #include "assetsModule/modelModule/MeshVaoRegistry.h"
+#include "assetsModule/modelModule/ModelLoader.h"
 #include "componentsModule/ArmatureComponent.h"
 #include "componentsModule/CascadeShadowComponent.h"
 #include "componentsModule/DebugDataComponent.h"
@@ -13,83 +16,358 @@
 #include "componentsModule/TransformComponent.h"
 #include "componentsModule/TreeComponent.h"
 #include "core/ECSHandler.h"
+#include "core/FramePacing.h"
+#include "core/Prefab.h"
+#include "logsModule/logger.h"
 #include "multithreading/ThreadPool.h"
+#include "systemsModule/TasksManager.h"
 
 namespace SFE::PropertiesModule {
+	namespace {
+		//components which are equal for all nodes of the same model, they are copied instead of being built for every node
+		struct ModelTemplate {
+			bool built = false;
+			bool hasMesh = false;
+			MeshComponent mesh;
+			MaterialComponent material;
+			ComponentsModule::ArmatureComponent armature;
+			ComponentsModule::ArmatureBonesComponent bones;
+
+			void build(ModelComponent& modelComp) {
+				built = true;
+				const auto& lod = modelComp.getModel();
+				hasMesh = !lod.meshes.empty();
+				if (!hasMesh) {
+					return;
+				}
+
+				auto& meshObj = lod.meshes[0];
+				mesh.meshGraph.root().value = { MeshVaoRegistry::instance()->get(&meshObj->mesh).handle, static_cast<int>(meshObj->mesh.vertices.size()), static_cast<int>(meshObj->mesh.indices.size()), meshObj->aabb, meshObj->uvDensity };
+				for (auto& mat : meshObj->material.materialTextures) {
+					material.materials.addMaterial({ mat.second.uniformSlot, mat.second.texture->mId, mat.second.texture->mType });
+				}
+				armature.armature = modelComp.armature;
+				std::ranges::copy(modelComp.boneMatrices, bones.boneMatrices.begin());
+			}
+		};
+	}
+
 	ecss::EntityId PropertiesSystem::loadScene(std::string_view path) {
 		if (!FileSystem::isFileExists(path)) {
-			return {};
+			return ecss::INVALID_ID;
+		}
+
+		if (path.ends_with(SceneFile::EXTENSION)) {
+			return loadBinaryScene(path);
 		}
 
 		auto scene = ECSHandler::registry().takeEntity();
 
-		fillTree(scene, FileSystem::readJson(path));
+		CoreModule::Prefab::fillTree(scene, FileSystem::readJson(path));
 
 		return scene;
 	}
 
-	void PropertiesSystem::applyProperties(ecss::EntityId entity, const Json::Value& properties) {
+	ecss::EntityId PropertiesSystem::loadBinaryScene(std::string_view path) {
+		std::vector<uint8_t> data;
+		if (!FileSystem::readBinaryFile(path, data)) {
+			return ecss::INVALID_ID;
+		}
+
+		SceneFile scene;
+		if (!scene.read(data)) {
+			SFE_LOG_ERROR("PropertiesSystem::loadBinaryScene %s is not a scene of version %u", path.data(), SceneFile::VERSION);
+			return ecss::INVALID_ID;
+		}
+
+		return instantiateScene(scene);
+	}
+
+	ecss::EntityId PropertiesSystem::instantiateScene(const SceneFile& scene) {
+		constexpr size_t TRANSFORMS_BATCH = 4096;
+
+		if (scene.parents.empty()) {
+			return ecss::INVALID_ID;
+		}
+
+		//every model is asked once, loading threads load them while nodes are created
+		std::vector<AssetsModule::Model*> models(scene.models.size(), nullptr);
+		FuturesBunch modelLoads;
+		modelLoads.reserve(scene.models.size());
+		for (size_t i = 0; i < scene.models.size(); i++) {
+			modelLoads.add(ThreadPool::instance()->addTask<WorkerType::RESOURCE_LOADING>([&models, &path = scene.models[i], i] {
+				models[i] = AssetsModule::ModelLoader::instance()->load(path);
+			}));
+		}
+
+		auto& registry = ECSHandler::registry();
+		std::vector<ecss::EntityId> entities(scene.parents.size());
+		for (auto& entity : entities) {
+			entity = registry.takeEntity();
+		}
+
+		for (size_t node = 0; node < entities.size(); node++) {
+			if (!scene.ids[node].empty()) {
+				registry.addComponent<DebugDataComponent>(entities[node])->stringId = scene.ids[node];
+			}
+		}
+		for (const auto entity : entities) {
+			registry.addComponent<ComponentsModule::AABBComponent>(entity);
+		}
+		for (const auto entity : entities) {
+			registry.addComponent<OcTreeComponent>(entity);
+		}
+		for (const auto entity : entities) {
+			registry.addComponent<IsDrawableComponent>(entity);
+		}
+
+		//parent is always before its children, so children are linked in the same order as json loader links them
+		for (const auto entity : entities) {
+			registry.addComponent<TreeComponent>(entity, entity);
+		}
+		for (size_t node = 0; node < entities.size(); node++) {
+			if (scene.parents[node] != SceneFile::NO_PARENT) {
+				registry.getComponent<TreeComponent>(entities[scene.parents[node]])->addChildEntity(entities[node]);
+			}
+		}
+
+		const auto tasks = SystemsModule::TasksManager::instance();
+		if (const auto block = scene.findBlock(SceneFile::BlockType::TRANSFORM)) {
+			//transform is created dirty, so setters don't notify transform system from workers, it gets all nodes at once
+			std::vector<ecss::EntityId> transformEntities(block->size());
+			for (size_t i = 0; i < block->size(); i++) {
+				transformEntities[i] = entities[block->nodes[i]];
+				registry.addComponent<TransformComponent>(transformEntities[i], transformEntities[i], Math::Vec3{ 0.f }, Math::Vec3{ 0.f }, Math::Vec3{ 1.f });
+			}
+
+			std::vector<TransformComponent*> transforms(block->size());
+			for (size_t i = 0; i < block->size(); i++) {
+				transforms[i] = registry.getComponent<TransformComponent>(transformEntities[i]);
+			}
+			ThreadPool::instance()->addBatchTasks(block->size(), TRANSFORMS_BATCH, [block, &transforms](size_t i) {
+				auto record = block->getRecord(i);
+				transforms[i]->deserialize(record);
+			}).waitAll();
+
+			tasks->notify(transformEntities, SystemsModule::TRANSFORM_UPDATE);
+		}
+
+		modelLoads.waitAll();
+		for (size_t i = 0; i < models.size(); i++) {
+			if (!models[i]) {
+				SFE_LOG_ERROR("PropertiesSystem::instantiateScene can't load model %s", scene.models[i].c_str());
+			}
+		}
+		if (const auto block = scene.findBlock(SceneFile::BlockType::MODEL)) {
+			std::vector<ecss::EntityId> modelEntities;
+			std::vector<uint32_t> entityModels;
+			modelEntities.reserve(block->size());
+			entityModels.reserve(block->size());
+			for (size_t i = 0; i < block->size(); i++) {
+				auto record = block->getRecord(i);
+				uint32_t model = 0;
+				if (!record.read(model) || model >= models.size()) {
+					SFE_LOG_ERROR("PropertiesSystem::instantiateScene broken model record of node %u", block->nodes[i]);
+					continue;
+				}
+
+				const auto entity = entities[block->nodes[i]];
+				auto modelComp = registry.addComponent<ModelComponent>(entity, entity);
+				if (models[model]) {
+					modelComp->init(models[model]);
+				}
+				else {
+					modelComp->mPath = scene.models[model];
+				}
+				modelEntities.push_back(entity);
+				entityModels.push_back(model);
+			}
+
+			std::vector<ModelTemplate> templates(models.size());
+			std::vector<ecss::EntityId> meshEntities;
+			std::vector<const ModelTemplate*> meshTemplates;
+			for (size_t i = 0; i < modelEntities.size(); i++) {
+				auto& modelTemplate = templates[entityModels[i]];
+				if (!modelTemplate.built) {
+					modelTemplate.build(*registry.getComponent<ModelComponent>(modelEntities[i]));
+				}
+				if (modelTemplate.hasMesh) {
+					meshEntities.push_back(modelEntities[i]);
+					meshTemplates.push_back(&modelTemplate);
+				}
+			}
+
+			for (size_t i = 0; i < meshEntities.size(); i++) {
+				registry.addComponent<MeshComponent>(meshEntities[i], meshTemplates[i]->mesh);
+			}
+			for (size_t i = 0; i < meshEntities.size(); i++) {
+				registry.addComponent<MaterialComponent>(meshEntities[i], meshTemplates[i]->material);
+			}
+			for (size_t i = 0; i < meshEntities.size(); i++) {
+				registry.addComponent<ComponentsModule::ArmatureComponent>(meshEntities[i], meshTemplates[i]->armature);
+			}
+			for (size_t i = 0; i < meshEntities.size(); i++) {
+				registry.addComponent<ComponentsModule::ArmatureBonesComponent>(meshEntities[i], meshTemplates[i]->bones);
+			}
+
+			if (!meshEntities.empty()) {
+				tasks->notify(meshEntities, SystemsModule::MESH_UPDATED);
+				tasks->notify(meshEntities, SystemsModule::MATERIAL_UPDATED);
+				tasks->notify(meshEntities, SystemsModule::ARMATURE_UPDATED);
+			}
+		}
+
+		return entities.front();
+	}
+
+	bool PropertiesSystem::saveBinaryScene(ecss::EntityId root, std::string_view path) {
+		SceneFile scene;
+		fillSceneFile(root, scene);
+
+		std::vector<uint8_t> data;
+		scene.write(data);
+		return FileSystem::writeBinaryFile(path, data.data(), data.size());
+	}
+
+	bool PropertiesSystem::convertScene(std::string_view jsonPath, std::string_view scenePath) {
+		Json::Value json;
+		if (!FileSystem::readJson(jsonPath, json)) {
+			return false;
+		}
+
+		SceneFile scene;
+		fillSceneFile(json, scene);
+
+		std::vector<uint8_t> data;
+		scene.write(data);
+		return FileSystem::writeBinaryFile(scenePath, data.data(), data.size());
+	}
+
+	void PropertiesSystem::fillSceneFile(ecss::EntityId entity, SceneFile& scene, uint32_t parent) {
 		if (entity == ecss::INVALID_ID) {
 			return;
 		}
-		if (!properties.isMember("Properties")) {
-			return;
+
+		const auto debugData = ECSHandler::registry().getComponent<DebugDataComponent>(entity);
+		const auto node = scene.addNode(parent, debugData ? debugData->stringId : std::string());
+
+		if (auto transform = ECSHandler::registry().getComponent<TransformComponent>(entity)) {
+			scene.getBlock(SceneFile::BlockType::TRANSFORM).addRecord(node, [transform](BinaryWriter& writer) { transform->serialize(writer); });
 		}
 
-		deserializeProperty<ModelComponent>(entity, properties["Properties"]);
-		deserializeProperty<TransformComponent>(entity, properties["Properties"]);
+		if (auto modelComp = ECSHandler::registry().getComponent<ModelComponent>(entity)) {
+			const auto model = scene.addModel(modelComp->mPath);
+			scene.getBlock(SceneFile::BlockType::MODEL).addRecord(node, [model](BinaryWriter& writer) { writer.write(model); });
+		}
+
+		if (auto treeComp = ECSHandler::registry().getComponent<TreeComponent>(entity)) {
+			for (auto child : treeComp->getChildren()) {
+				fillSceneFile(child, scene, node);
+			}
+		}
 	}
 
-	void PropertiesSystem::fillTree(ecss::EntityId entity, const Json::Value& properties) {
+	void PropertiesSystem::fillSceneFile(const Json::Value& properties, SceneFile& scene, uint32_t parent) {
 		if (!properties.isObject()) {
 			return;
 		}
 
-		if (properties.isMember("id")) {
-			auto debugData = ECSHandler::registry().addComponent<DebugDataComponent>(entity);
-			debugData->stringId = properties["id"].asString();
-		}
-		//todo this all is dirty, need to refactor and make common logic
-		ECSHandler::registry().addComponent<ComponentsModule::AABBComponent>(entity);
-		ECSHandler::registry().addComponent<OcTreeComponent>(entity);
-		applyProperties(entity, properties);
-		ECSHandler::registry().addComponent<IsDrawableComponent>(entity);
-		auto modelComp = ECSHandler::registry().getComponent<ModelComponent>(entity);
-		if (modelComp && !modelComp->getModel().meshes.empty()) {
-			auto meshComp = ECSHandler::registry().addComponent<MeshComponent>(entity);
-			meshComp->meshGraph.root().value = { MeshVaoRegistry::instance()->get(&modelComp->getModel().meshes[0]->mesh).vao.getID(), static_cast<int>(modelComp->getModel().meshes[0]->mesh.vertices.size()), static_cast<int>(modelComp->getModel().meshes[0]->mesh.indices.size()) };
-			if (auto renderSys = ECSHandler::systemManager().getSystem<SFE::SystemsModule::RenderSystem>()) {
-				renderSys->markDirty<MeshComponent>(entity);
+		const auto node = scene.addNode(parent, properties.isMember("id") ? properties["id"].asString() : std::string());
+
+		if (properties.isMember("Properties")) {
+			const auto& nodeProperties = properties["Properties"];
+			if (auto data = JsonUtils::getValue(nodeProperties, TypeName<TransformComponent>::name())) {
+				//component is created dirty, so its setters don't notify transform system about entity which doesn't exist
+				TransformComponent transform(ecss::INVALID_ID, Math::Vec3{ 0.f }, Math::Vec3{ 0.f }, Math::Vec3{ 1.f });
+				transform.deserialize(*data);
+				scene.getBlock(SceneFile::BlockType::TRANSFORM).addRecord(node, [&transform](BinaryWriter& writer) { transform.serialize(writer); });
 			}
 
-			auto materialComp = ECSHandler::registry().addComponent<MaterialComponent>(entity);
-			for (auto& mat : modelComp->getModel().meshes[0]->material.materialTextures) {
-				materialComp->materials.addMaterial({ mat.second.uniformSlot, mat.second.texture->mId, mat.second.texture->mType});
+			if (auto data = JsonUtils::getValue(nodeProperties, TypeName<ModelComponent>::name())) {
+				const auto path = JsonUtils::getValue(*data, "ModelPath");
+				const auto model = scene.addModel(path ? path->asString() : std::string());
+				scene.getBlock(SceneFile::BlockType::MODEL).addRecord(node, [model](BinaryWriter& writer) { writer.write(model); });
 			}
-			if (auto renderSys = ECSHandler::systemManager().getSystem<SFE::SystemsModule::RenderSystem>()) {
-				renderSys->markDirty<MaterialComponent>(entity);
+		}
+
+		if (properties.isMember("Children") && properties["Children"].isArray()) {
+			for (const auto& element : properties["Children"]) {
+				fillSceneFile(element, scene, node);
 			}
+		}
+	}
 
-			auto armatureComp = ECSHandler::registry().addComponent<ComponentsModule::ArmatureComponent>(entity);
-			auto armatureBonesComp = ECSHandler::registry().addComponent<ComponentsModule::ArmatureBonesComponent>(entity);
-			
-			armatureComp->armature = modelComp->armature;
+	PropertiesSystem::BenchmarkResult PropertiesSystem::benchmark(std::string_view jsonPath, size_t nodesCount) {
+		constexpr std::string_view BENCHMARK_JSON = "sceneBenchmark.json";
+		constexpr std::string_view BENCHMARK_SCENE = "sceneBenchmark.scene";
+		constexpr float COPY_OFFSET = 100.f;
 
-			std::ranges::copy(modelComp->boneMatrices, armatureBonesComp->boneMatrices.begin());
-			if (auto renderSys = ECSHandler::systemManager().getSystem<SFE::SystemsModule::RenderSystem>()) {
-				renderSys->markDirty<SFE::ComponentsModule::ArmatureComponent>(entity);
-			}
+		BenchmarkResult result;
+		Json::Value source;
+		if (!FileSystem::readJson(jsonPath, source) || !source.isMember("Children") || !source["Children"].isArray() || source["Children"].empty()) {
+			SFE_LOG_ERROR("PropertiesSystem::benchmark %s has no children to repeat", jsonPath.data());
+			return result;
 		}
-		
-		auto treeComp = ECSHandler::registry().addComponent<TreeComponent>(entity, entity);
 
-		if (properties.isMember("Children") && properties["Children"].isArray()) {
-			for (auto element : properties["Children"]) {
-				auto child = ECSHandler::registry().takeEntity();				
-				fillTree(child, element);
-				treeComp->addChildEntity(child);
+		const auto children = source["Children"];
+		auto& scaledChildren = source["Children"];
+		scaledChildren = Json::arrayValue;
+		for (size_t i = 0; scaledChildren.size() < nodesCount; i++) {
+			auto child = children[static_cast<Json::ArrayIndex>(i % children.size())];
+			const auto copy = i / children.size();
+			if (child.isMember("id")) {
+				child["id"] = child["id"].asString() + "_" + std::to_string(copy);
 			}
+			if (child.isMember("Properties") && child["Properties"].isMember("TransformComponent")) {
+				auto& pos = child["Properties"]["TransformComponent"]["Pos"];
+				if (pos.isArray() && pos.size() == 3) {
+					pos[0] = pos[0].asFloat() + static_cast<float>(copy % 100) * COPY_OFFSET;
+					pos[2] = pos[2].asFloat() + static_cast<float>(copy / 100) * COPY_OFFSET;
+				}
+			}
+			scaledChildren.append(std::move(child));
+		}
+
+		if (!FileSystem::writeJson(BENCHMARK_JSON, source) || !convertScene(BENCHMARK_JSON, BENCHMARK_SCENE)) {
+			return result;
 		}
+		result.jsonBytes = std::filesystem::file_size(BENCHMARK_JSON);
+		result.binaryBytes = std::filesystem::file_size(BENCHMARK_SCENE);
+
+		//models are loaded before measure, so the format which goes first doesn't pay for them
+		std::vector<uint8_t> data;
+		SceneFile scene;
+		FileSystem::readBinaryFile(BENCHMARK_SCENE, data);
+		scene.read(data);
+		for (const auto& model : scene.models) {
+			AssetsModule::ModelLoader::instance()->load(model);
+		}
+		result.nodes = scene.parents.size();
+
+		auto start = CoreModule::monotonicNs();
+		auto root = loadScene(BENCHMARK_JSON);
+		result.jsonMs = static_cast<double>(CoreModule::monotonicNs() - start) / 1'000'000.0;
+		destroyScene(root);
+
+		start = CoreModule::monotonicNs();
+		root = loadScene(BENCHMARK_SCENE);
+		result.binaryMs = static_cast<double>(CoreModule::monotonicNs() - start) / 1'000'000.0;
+		destroyScene(root);
+
+		SFE_LOG_INFO("PropertiesSystem::benchmark %zu nodes, json: %.1f ms %ju bytes, binary: %.1f ms %ju bytes", result.nodes, result.jsonMs, result.jsonBytes, result.binaryMs, result.binaryBytes);
+		return result;
+	}
+
+	void PropertiesSystem::applyProperties(ecss::EntityId entity, const Json::Value& properties) {
+		if (entity == ecss::INVALID_ID) {
+			return;
+		}
+		if (!properties.isMember("Properties")) {
+			return;
+		}
+
+		deserializeProperty<ModelComponent>(entity, properties["Properties"]);
+		deserializeProperty<TransformComponent>(entity, properties["Properties"]);
 	}
 
 	Json::Value PropertiesSystem::serializeEntity(ecss::EntityId entity) {
@@ -119,4 +397,15 @@ namespace SFE::PropertiesModule {
 
 		return result;
 	}
+
+	void PropertiesSystem::destroyScene(ecss::EntityId root) {
+		if (root == ecss::INVALID_ID) {
+			return;
+		}
+
+		auto treeComp = ECSHandler::registry().getComponent<TreeComponent>(root);
+		auto nodes = treeComp ? treeComp->getAllNodes() : std::vector<ecss::SectorId>();
+		nodes.push_back(root);
+		ECSHandler::registry().destroyEntities(nodes);
+	}
 }
@@ -2,20 +2,44 @@
 #include <mutex>
 #include <json/value.h>
 
+#include "SceneFile.h"
 #include "TypeName.h"
 #include "core/ECSHandler.h"
 #include "mathModule/Forward.h"
 
+//scales scene to 100k nodes on start, converts it to binary scene and logs time of loading of both formats
+#define SCENE_BENCHMARK 0
+
 namespace SFE::PropertiesModule {
 	class PropertiesSystem {
 	public:
+		struct BenchmarkResult {
+			size_t nodes = 0;
+			double jsonMs = 0.0;
+			double binaryMs = 0.0;
+			uintmax_t jsonBytes = 0;
+			uintmax_t binaryBytes = 0;
+		};
+
+		//files with scene file extension are loaded as binary scenes, others as json
 		static ecss::EntityId loadScene(std::string_view path);
+		static ecss::EntityId loadBinaryScene(std::string_view path);
+		//every component type is created for all nodes in one pass, transforms are read by workers,
+		//models are loaded on loading threads while nodes are created
+		static ecss::EntityId instantiateScene(const SceneFile& scene);
 
-		static void applyProperties(ecss::EntityId entity, const Json::Value& properties);
+		static bool saveBinaryScene(ecss::EntityId root, std::string_view path);
+		static bool convertScene(std::string_view jsonPath, std::string_view scenePath);
+		static void fillSceneFile(ecss::EntityId entity, SceneFile& scene, uint32_t parent = SceneFile::NO_PARENT);
+		static void fillSceneFile(const Json::Value& properties, SceneFile& scene, uint32_t parent = SceneFile::NO_PARENT);
 
-		static void fillTree(ecss::EntityId entity, const Json::Value& properties);
+		//children of json scene are repeated with offset until scene has nodes count, models are loaded before measure
+		static BenchmarkResult benchmark(std::string_view jsonPath, size_t nodesCount);
+
+		static void applyProperties(ecss::EntityId entity, const Json::Value& properties);
 
 		static Json::Value serializeEntity(const ecss::EntityId entity);
+		static void destroyScene(ecss::EntityId root);
 
 		template<class T>
 		static void deserializeProperty(const ecss::EntityId entity, const Json::Value& properties);
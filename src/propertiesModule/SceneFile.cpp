@@ -0,0 +1,135 @@
+﻿#include "SceneFile.h"
+
+#include <algorithm>
+
+namespace SFE::PropertiesModule {
+	uint32_t SceneFile::addNode(uint32_t parent, std::string id) {
+		parents.push_back(parent);
+		ids.push_back(std::move(id));
+		return static_cast<uint32_t>(parents.size() - 1);
+	}
+
+	uint32_t SceneFile::addModel(const std::string& path) {
+		const auto [it, inserted] = mModelIndices.try_emplace(path, static_cast<uint32_t>(models.size()));
+		if (inserted) {
+			models.push_back(path);
+		}
+		return it->second;
+	}
+
+	SceneFile::Block& SceneFile::getBlock(BlockType type) {
+		const auto it = std::ranges::find(blocks, type, &Block::type);
+		if (it != blocks.end()) {
+			return *it;
+		}
+
+		auto& block = blocks.emplace_back();
+		block.type = type;
+		return block;
+	}
+
+	const SceneFile::Block* SceneFile::findBlock(BlockType type) const {
+		const auto it = std::ranges::find(blocks, type, &Block::type);
+		return it != blocks.end() ? &*it : nullptr;
+	}
+
+	bool SceneFile::read(const std::vector<uint8_t>& data) {
+		clear();
+
+		BinaryReader reader(data);
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		if (!reader.read(magic) || magic != MAGIC || !reader.read(version) || version != VERSION) {
+			return false;
+		}
+
+		//parent goes before its children, so tree can be built in one pass over nodes
+		reader.readArray(parents);
+		for (uint32_t node = 0; node < parents.size(); node++) {
+			if (parents[node] != NO_PARENT && parents[node] >= node) {
+				clear();
+				return false;
+			}
+		}
+
+		ids.resize(parents.size());
+		for (auto& id : ids) {
+			reader.readString(id);
+		}
+
+		uint32_t modelsCount = 0;
+		reader.read(modelsCount);
+		if (modelsCount > reader.getRemaining() / sizeof(uint32_t)) {
+			clear();
+			return false;
+		}
+		models.resize(modelsCount);
+		for (uint32_t i = 0; i < modelsCount; i++) {
+			reader.readString(models[i]);
+			mModelIndices.try_emplace(models[i], i);
+		}
+
+		uint32_t blocksCount = 0;
+		reader.read(blocksCount);
+		if (blocksCount > reader.getRemaining() / sizeof(uint32_t)) {
+			clear();
+			return false;
+		}
+		blocks.resize(blocksCount);
+		for (auto& block : blocks) {
+			reader.read(block.type);
+			reader.readArray(block.nodes);
+			reader.readArray(block.offsets);
+			reader.readArray(block.data);
+			if (!reader.isValid()) {
+				break;
+			}
+
+			const auto wrongNode = std::ranges::any_of(block.nodes, [this](uint32_t node) { return node >= parents.size(); });
+			if (wrongNode || block.offsets.size() != block.nodes.size() + 1 || block.offsets.front() != 0 || block.offsets.back() != block.data.size() || !std::ranges::is_sorted(block.offsets)) {
+				clear();
+				return false;
+			}
+		}
+
+		if (!reader.isValid()) {
+			clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	void SceneFile::write(std::vector<uint8_t>& data) const {
+		data.clear();
+		BinaryWriter writer(data);
+		writer.write(MAGIC);
+		writer.write(VERSION);
+
+		writer.writeArray(std::span<const uint32_t>(parents));
+		for (const auto& id : ids) {
+			writer.writeString(id);
+		}
+
+		writer.write(static_cast<uint32_t>(models.size()));
+		for (const auto& model : models) {
+			writer.writeString(model);
+		}
+
+		writer.write(static_cast<uint32_t>(blocks.size()));
+		for (const auto& block : blocks) {
+			writer.write(block.type);
+			writer.writeArray(std::span<const uint32_t>(block.nodes));
+			writer.writeArray(std::span<const uint32_t>(block.offsets));
+			writer.writeArray(std::span<const uint8_t>(block.data));
+		}
+	}
+
+	void SceneFile::clear() {
+		parents.clear();
+		ids.clear();
+		models.clear();
+		blocks.clear();
+		mModelIndices.clear();
+	}
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BinaryArchive.h"
+
+namespace SFE::PropertiesModule {
+	//binary scene, json stays the format which is edited by hand and converted to this one
+	//nodes are stored parent first, components of the same type are stored together in one block, every node has its record there,
+	//records have offsets, so block can be read by several threads. models are kept in table and nodes refer to them by index
+	struct SceneFile {
+		constexpr static uint32_t MAGIC = 0x4E534653; //SFSN
+		constexpr static uint32_t VERSION = 1;
+		constexpr static uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+		constexpr static std::string_view EXTENSION = ".scene";
+
+		//components which scene loader applies, values are kept in file, new types are added to the end
+		enum class BlockType : uint32_t {
+			TRANSFORM,
+			MODEL, //record is index in models table
+		};
+
+		struct Block {
+			BlockType type = BlockType::TRANSFORM;
+			std::vector<uint32_t> nodes;
+			//record of i-th node lies between i-th and next offset
+			std::vector<uint32_t> offsets = { 0 };
+			std::vector<uint8_t> data;
+
+			template<typename Func>
+			void addRecord(uint32_t node, Func&& write) {
+				nodes.push_back(node);
+				BinaryWriter writer(data);
+				write(writer);
+				offsets.push_back(static_cast<uint32_t>(data.size()));
+			}
+
+			BinaryReader getRecord(size_t index) const {
+				return BinaryReader({ data.data() + offsets[index], offsets[index + 1] - offsets[index] });
+			}
+
+			size_t size() const { return nodes.size(); }
+		};
+
+		std::vector<uint32_t> parents;
+		//string id of debug data, empty when node has no id
+		std::vector<std::string> ids;
+		std::vector<std::string> models;
+		std::vector<Block> blocks;
+
+		uint32_t addNode(uint32_t parent, std::string id);
+		uint32_t addModel(const std::string& path);
+
+		Block& getBlock(BlockType type);
+		const Block* findBlock(BlockType type) const;
+
+		//returns false if data is not a scene of current version, file stays empty then
+		bool read(const std::vector<uint8_t>& data);
+		void write(std::vector<uint8_t>& data) const;
+
+		void clear();
+
+	private:
+		std::unordered_map<std::string, uint32_t> mModelIndices;
+	};
+}
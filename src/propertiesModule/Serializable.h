@@ -2,6 +2,8 @@
 
 #include <json/value.h>
 
+#include "BinaryArchive.h"
+
 namespace SFE::PropertiesModule {
 	class Serializable {
 	public:
@@ -9,5 +11,9 @@ namespace SFE::PropertiesModule {
 
 		virtual void serialize(Json::Value& data) = 0;
 		virtual void deserialize(const Json::Value& data) = 0;
+
+		//binary counterpart for scene files, it reads values in the same order as they are written
+		virtual void serialize(BinaryWriter& data) = 0;
+		virtual void deserialize(BinaryReader& data) = 0;
 	};
 }
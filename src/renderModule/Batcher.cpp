@@ -1,16 +1,35 @@
 ﻿#include "Batcher.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "imgui.h"
 #include "assetsModule/TextureHandler.h"
+#include "assetsModule/shaderModule/ShaderController.h"
 #include "componentsModule/MaterialComponent.h"
 #include "componentsModule/TransformComponent.h"
 #include "debugModule/Benchmark.h"
 #include "glWrapper/Buffer.h"
 #include "glWrapper/Draw.h"
+#include "logsModule/logger.h"
 #include "systemsModule/systems/CameraSystem.h"
 
+namespace {
+	bool isSameMaterials(const SFE::ComponentsModule::Materials& a, const SFE::ComponentsModule::Materials& b) {
+		if (a.materialsCount != b.materialsCount) {
+			return false;
+		}
+
+		for (auto i = 0; i < a.materialsCount; i++) {
+			if (a.material[i].slot != b.material[i].slot || a.material[i].textureId != b.material[i].textureId || a.material[i].type != b.material[i].type) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
 void DrawObject::sortTransformAccordingToView(const SFE::Math::Vec3& viewPos) {
 	std::unordered_map<ecss::EntityId, float> distanceCash;
 	std::ranges::sort(entities, [&viewPos, this, &distanceCash](ecss::EntityId a, ecss::EntityId b) {
@@ -28,14 +47,24 @@ void DrawObject::sortTransformAccordingToView(const SFE::Math::Vec3& viewPos) {
 	});
 }
 
-void Batcher::addToDrawList(ecss::EntityId entity, unsigned VAO, size_t vertices, size_t indices, const SFE::ComponentsModule::Materials& textures, const SFE::Math::Mat4& transform) {
-	if (!vertices) {
+void Batcher::addToDrawList(ecss::EntityId entity, SFE::GeometryArena::Handle mesh, const SFE::ComponentsModule::MaterialComponent* material, const SFE::Math::Mat4& transform, const SFE::FrustumModule::AABB* bounds) {
+	if (!mesh.isValid()) {
 		return;
 	}
+
+	static const SFE::ComponentsModule::Materials defaultMaterials;
+	const auto& materials = material ? material->materials : defaultMaterials;
+	const auto materialBindings = SFE::Render::MaterialSystem::instance()->getBindings(material ? material->tableIndex : SFE::Render::MaterialTable::DEFAULT_MATERIAL);
+
+	//with material table instances differ only by layers, without it every instance binds materials of the whole draw
+	const auto sameMaterials = [&materials, &materialBindings](const DrawObject* drawObject) {
+		return SFE::Render::MaterialSystem::enabled ? drawObject->materialBindings == materialBindings : isSameMaterials(drawObject->materialData, materials);
+	};
+
 	DrawObject* drawObj = nullptr;
 	if (drawList.size()) {
 		for (size_t i = drawList.size() - 1; i >= 0; i--) {
-			if (drawList[i]->VAO == VAO && drawList[i]->entities.size() < maxDrawSize) {
+			if (drawList[i]->mesh.id == mesh.id && drawList[i]->mesh.generation == mesh.generation && drawList[i]->entities.size() < maxDrawSize && sameMaterials(drawList[i])) {
 				drawObj = drawList[i];
 				break;
 			}
@@ -53,7 +82,12 @@ void Batcher::addToDrawList(ecss::EntityId entity, unsigned VAO, size_t vertices
 		drawObj->entities.emplace_back(id);
 	}
 	else {
-		drawList.emplace_back(new DrawObject{ VAO, vertices, indices, textures });
+		drawList.emplace_back(new DrawObject{ mesh, materials });
+		drawList.back()->materialBindings = materialBindings;
+		if (bounds) {
+			drawList.back()->hasBounds = true;
+			drawList.back()->bounds = *bounds;
+		}
 		drawList.back()->transforms.reserve(10000);
 		drawList.back()->transforms.resize(id + 1);
 		drawList.back()->transforms[id] = &transform;
@@ -133,38 +167,235 @@ struct BuffersRing {
 
 };
 
-void Batcher::flushAll() {
+namespace {
+	constexpr GLuint ENTITY_IDX_ATTRIBUTE = 7;
+
+	//buffer which entity index attribute of arena vao points to, arena vaos live until exit so ids are never reused
+	//render thread only, it replaces reading the binding back from driver on every draw
+	std::unordered_map<unsigned, unsigned> entityIdxBuffers;
+
+	void setEntityIdxBuffer(unsigned vao, unsigned buffer) {
+		auto& bound = entityIdxBuffers[vao];
+		if (bound == buffer) {
+			return;
+		}
+		bound = buffer;
+
+		SFE::GLW::bindBuffer<SFE::GLW::ARRAY_BUFFER>(buffer);
+		glVertexAttribIPointer(ENTITY_IDX_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0, (void*)0);
+		glEnableVertexAttribArray(ENTITY_IDX_ATTRIBUTE);
+		glVertexAttribDivisor(ENTITY_IDX_ATTRIBUTE, 1);
+	}
+
+	void bindMaterials(const DrawObject* drawObject) {
+		if (SFE::Render::MaterialSystem::enabled) {
+			SFE::Render::MaterialSystem::instance()->bindPages(drawObject->materialBindings);
+			return;
+		}
+
+		//assets live until exit, so lookup by path is done once
+		static auto defaultTex = AssetsModule::TextureHandler::instance()->loadTexture("white.png");
+		static auto defaultNormal = AssetsModule::TextureHandler::instance()->loadTexture("defaultNormal.png", AssetsModule::TextureUsage::NORMAL);
+
+		AssetsModule::TextureHandler::bindTextureToSlot(SFE::DIFFUSE, defaultTex);
+		AssetsModule::TextureHandler::bindTextureToSlot(SFE::NORMALS, defaultNormal);
+		AssetsModule::TextureHandler::bindTextureToSlot(SFE::SPECULAR, defaultTex);
+
+		const auto& materials = drawObject->materialData;
+		for (auto i = 0; i < materials.materialsCount; i++) {
+			const auto& mat = materials.material[i];
+			SFE::GLW::bindTextureToSlot(mat.slot, mat.type, mat.textureId);
+		}
+	}
+
+	bool canShareMaterials(const DrawObject* a, const DrawObject* b) {
+		return SFE::Render::MaterialSystem::enabled ? a->materialBindings == b->materialBindings : isSameMaterials(a->materialData, b->materialData);
+	}
+
+	//buffers for indirect path, binding indices are the same as in shaders/cullInstances.cs
+	struct IndirectBuffers {
+		SFE::GLW::ShaderStorageBuffer<uint32_t, SFE::GLW::DYNAMIC_DRAW> instances;
+		SFE::GLW::ShaderStorageBuffer<uint32_t, SFE::GLW::DYNAMIC_DRAW> instanceDraws;
+		SFE::GLW::ShaderStorageBuffer<SFE::Render::IndirectDrawBounds, SFE::GLW::DYNAMIC_DRAW> bounds;
+		SFE::GLW::ShaderStorageBuffer<SFE::Render::DrawElementsIndirectCommand, SFE::GLW::DYNAMIC_DRAW> commands;
+		//compacted visible entity indices, it is also instanced vertex attribute with entity index
+		SFE::GLW::ShaderStorageBuffer<uint32_t, SFE::GLW::DYNAMIC_COPY> visible;
+
+		bool inited = false;
+
+		void init() {
+			if (inited) {
+				return;
+			}
+			inited = true;
+
+			instances.generate();
+			instanceDraws.generate();
+			bounds.generate();
+			commands.generate();
+			visible.generate();
+		}
+
+		//buffer data is reallocated every flush, so driver gives new storage instead of waiting while gpu reads previous one
+		template<typename Buffer, typename Data>
+		static void upload(Buffer& buffer, int binding, const std::vector<Data>& data) {
+			buffer.bind();
+			buffer.allocateData(data);
+			buffer.setBufferBinding(binding);
+		}
+	};
+}
+
+Batcher::FrameStats Batcher::takeFrameStats() {
+	return { mVaoBinds.exchange(0), mDrawCalls.exchange(0) };
+}
+
+void Batcher::loadShaders() {
+	//multi draw indirect, compute and storage buffers are core since 4.3
+	indirectDrawSupported = GLAD_GL_VERSION_4_3 != 0;
+	if (!indirectDrawSupported) {
+		if (indirectDraw) {
+			SFE_LOG_WARNING("Batcher: gl 4.3 is not available, indirect draw is replaced by instanced draws");
+		}
+		indirectDraw = false;
+		return;
+	}
+
+	mCullShader = SHADER_CONTROLLER->loadComputeShader("shaders/cullInstances.cs");
+}
+
+void Batcher::flushAll(const SFE::FrustumModule::Frustum* cullFrustum) {
+	mFlushList.clear();
+	for (const auto drawObject : drawList) {
+		drawObject->range = SFE::GeometryArena::instance()->getRange(drawObject->mesh);
+		if (drawObject->range.vao) {
+			mFlushList.push_back(drawObject);
+		}
+	}
+
+	if (mFlushList.empty()) {
+		return;
+	}
+
+	//arena meshes are always indexed, so indirect commands fit all of them
+	if (indirectDraw && indirectDrawSupported) {
+		flushIndirect(cullFrustum);
+	}
+	else {
+		flushInstanced();
+	}
+}
+
+void Batcher::flushIndirect(const SFE::FrustumModule::Frustum* cullFrustum) {
+	FUNCTION_BENCHMARK;
+	static IndirectBuffers buffers;
+	buffers.init();
+
+	mIndirectList.clear();
+	for (const auto drawObject : mFlushList) {
+		const auto& range = drawObject->range;
+		mIndirectList.addDraw(range.indicesCount, range.firstIndex, range.baseVertex, drawObject->hasBounds ? &drawObject->bounds : nullptr, drawObject->entities, &drawObject->transforms);
+	}
+
+	if (cpuCulling) {
+		mIndirectList.cull(cullFrustum);
+		IndirectBuffers::upload(buffers.commands, 16, mIndirectList.getCulledCommands());
+		IndirectBuffers::upload(buffers.visible, 17, mIndirectList.getVisibleInstances());
+	}
+	else {
+		FUNCTION_BENCHMARK_NAMED(gpu_culling);
+		IndirectBuffers::upload(buffers.instances, 13, mIndirectList.getInstances());
+		IndirectBuffers::upload(buffers.instanceDraws, 14, mIndirectList.getInstanceDraws());
+		IndirectBuffers::upload(buffers.bounds, 15, mIndirectList.getBounds());
+		IndirectBuffers::upload(buffers.commands, 16, mIndirectList.getCullingCommands());
+
+		buffers.visible.bind();
+		buffers.visible.allocateData(mIndirectList.getInstances().size());
+		buffers.visible.setBufferBinding(17);
+
+		//pass has already chosen its draw shader, it is restored after dispatch
+		const auto drawShader = SHADER_CONTROLLER->getCurrentShader();
+
+		if (!mCullShader) {
+			loadShaders();
+		}
+		const auto cullShader = mCullShader;
+		cullShader->use();
+		cullShader->setUniform("instancesCount", static_cast<int>(mIndirectList.getInstances().size()));
+		cullShader->setUniform("frustumCulling", cullFrustum != nullptr);
+		if (cullFrustum) {
+			const SFE::FrustumModule::Plane* planes[] = { &cullFrustum->leftFace, &cullFrustum->rightFace, &cullFrustum->topFace, &cullFrustum->bottomFace, &cullFrustum->nearFace, &cullFrustum->farFace };
+			for (size_t i = 0; i < std::size(planes); i++) {
+				cullShader->setUniform("frustumPlanes[" + std::to_string(i) + "]", SFE::Math::Vec4(planes[i]->normal, planes[i]->distance));
+			}
+		}
+
+		SFE::GLW::dispatchCompute(static_cast<uint32_t>((mIndirectList.getInstances().size() + 63) / 64));
+		SFE::GLW::memoryBarrier(SFE::GLW::COMMAND_BARRIER | SFE::GLW::VERTEX_ATTRIB_ARRAY_BARRIER);
+
+		SHADER_CONTROLLER->useShader(drawShader);
+	}
+
+	SFE::GLW::bindBuffer<SFE::GLW::DRAW_INDIRECT_BUFFER>(buffers.commands.getID());
+
+	//different meshes of one arena page share vao, so they are merged too
+	unsigned boundVao = 0;
+	size_t first = 0;
+	while (first < mFlushList.size()) {
+		const auto drawObject = mFlushList[first];
+
+		size_t last = first + 1;
+		while (last < mFlushList.size() && mFlushList[last]->range.vao == drawObject->range.vao && canShareMaterials(mFlushList[last], drawObject)) {
+			last++;
+		}
+
+		if (boundVao != drawObject->range.vao) {
+			boundVao = drawObject->range.vao;
+			SFE::GLW::VertexArray::bindArray(boundVao);
+			mVaoBinds++;
+		}
+
+		//attribute pointer is vao state, it is set only once per vao while buffer object stays the same
+		setEntityIdxBuffer(boundVao, buffers.visible.getID());
+
+		bindMaterials(drawObject);
+
+		SFE::GLW::multiDrawElementsIndirect(SFE::GLW::TRIANGLES, first * sizeof(SFE::Render::DrawElementsIndirectCommand), last - first);
+		mDrawCalls++;
+
+		first = last;
+	}
+
+	SFE::GLW::bindDefaultBuffer<SFE::GLW::DRAW_INDIRECT_BUFFER>();
+	SFE::GLW::Buffer<SFE::GLW::SHADER_STORAGE_BUFFER>::bindDefaultBuffer();
+	SFE::GLW::VertexArray::bindDefault();
+}
+
+void Batcher::flushInstanced() {
 	static BuffersRing<5> ring;
 	ring.init(maxDrawSize);
 
-	auto defaultTex = AssetsModule::TextureHandler::instance()->loadTexture("white.png");
-	auto defaultNormal = AssetsModule::TextureHandler::instance()->loadTexture("defaultNormal.png");
-
-	for (auto drawObjects : drawList) {
+	unsigned boundVao = 0;
+	for (auto drawObjects : mFlushList) {
 		auto& entityIdsBuffer = ring.getBuffer();
 
-		SFE::GLW::VertexArray::bindArray(drawObjects->VAO);
+		if (boundVao != drawObjects->range.vao) {
+			boundVao = drawObjects->range.vao;
+			SFE::GLW::VertexArray::bindArray(boundVao);
+			mVaoBinds++;
+		}
 		
 		entityIdsBuffer.bind();
 		entityIdsBuffer.clear();
 		entityIdsBuffer.addData(drawObjects->entities);
-		
 
-		glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, 0, (void*)0); //todo initialize it somehow only once
-		glEnableVertexAttribArray(7);
-		glVertexAttribDivisor(7, 1);
+		setEntityIdxBuffer(boundVao, entityIdsBuffer.getID());
 
-		
-		AssetsModule::TextureHandler::bindTextureToSlot(SFE::DIFFUSE, defaultTex);
-		AssetsModule::TextureHandler::bindTextureToSlot(SFE::NORMALS, defaultNormal);
-		AssetsModule::TextureHandler::bindTextureToSlot(SFE::SPECULAR, defaultTex);
-	
-		for (auto i = 0; i < drawObjects->materialData.materialsCount; i++) {
-			const auto& mat = drawObjects->materialData.material[i];
-			SFE::GLW::bindTextureToSlot(mat.slot, mat.type, mat.textureId);
-		}
+		bindMaterials(drawObjects);
 
-		SFE::GLW::drawVerticesW(drawObjects->verticesCount, drawObjects->indicesCount, drawObjects->entities.size());
+		const auto& range = drawObjects->range;
+		SFE::GLW::drawElementsInstancedBaseVertex(SFE::GLW::TRIANGLES, static_cast<GLsizei>(range.indicesCount), SFE::GLW::RenderDataType::UNSIGNED_INT, static_cast<GLsizei>(drawObjects->entities.size()), reinterpret_cast<const void*>(range.firstIndex * sizeof(uint32_t)), range.baseVertex);
+		mDrawCalls++;
 
 		ring.rotate();
 	}
@@ -1,9 +1,11 @@
 ﻿#pragma once
 
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
 #include <vector>
 
+#include "assetsModule/modelModule/GeometryArena.h"
 #include "assetsModule/modelModule/Mesh.h"
 #include "componentsModule/MaterialComponent.h"
 #include "componentsModule/MeshComponent.h"
@@ -11,28 +13,26 @@
 #include "containersModule/Singleton.h"
 #include "ecss/Types.h"
 #include "glWrapper/Buffer.h"
+#include "renderModule/IndirectDraw.h"
+#include "renderModule/MaterialSystem.h"
 #include "systemsModule/SystemBase.h"
 
-struct DrawObject {
-	friend bool operator==(const DrawObject& lhs, unsigned VAO) {
-		return lhs.VAO == VAO;
-	}
-	friend bool operator!=(const DrawObject& lhs, unsigned VAO) {
-		return !(lhs == VAO);
-	}
+namespace SFE::ShaderModule {
+	class ShaderBase;
+}
 
-	friend bool operator==(const DrawObject& lhs, const DrawObject& rhs) {
-		return lhs.VAO == rhs.VAO;
-	}
-	friend bool operator!=(const DrawObject& lhs, const DrawObject& rhs) {
-		return !(lhs == rhs);
-	}
+struct DrawObject {
+	SFE::GeometryArena::Handle mesh;
+	SFE::ComponentsModule::Materials materialData; //todo make it pointer too
+	//array pages of material table, every instance reads its own material row, so only pages have to match
+	SFE::Render::MaterialTable::Bindings materialBindings;
 
-	unsigned VAO;
+	//mesh place in arena page, it is taken on flush because arena can move mesh between batching and drawing
+	SFE::GeometryArena::Range range;
 
-	size_t verticesCount;
-	size_t indicesCount;
-	SFE::ComponentsModule::Materials materialData; //todo make it pointer too
+	//local space mesh bounds for gpu culling, without them instances are never culled
+	bool hasBounds = false;
+	SFE::FrustumModule::AABB bounds;
 
 	struct Matrices {
 		ecss::EntityId entityID;
@@ -55,6 +55,10 @@ public:
 		bonesBO.generate();
 		bonesBO.bind();
 		bonesBO.setBufferBinding(11);
+
+		materialsBO.generate();
+		materialsBO.bind();
+		materialsBO.setBufferBinding(SFE::Render::MaterialSystem::MATERIAL_INDICES_BINDING);
 	}
 
 	size_t getEntityIdx(ecss::EntityId entity) {
@@ -92,11 +96,23 @@ public:
 		}
 	}
 
+	void updateMaterial(ecss::EntityId entity, uint32_t material, bool bind = true) {
+		if (bind) {
+			materialsBO.bind();
+		}
+
+		materialsBO.setData(1, &material, getEntityIdx(entity));
+		if (bind) {
+			materialsBO.unbind();
+		}
+	}
+
 	std::unordered_map<ecss::EntityId, size_t> dataMap;
 	size_t entities = 0;
 
 	SFE::GLW::ShaderStorageBuffer<SFE::Math::Mat4, SFE::GLW::DYNAMIC_DRAW> transformsBO;
 	SFE::GLW::ShaderStorageBuffer<SFE::Math::Mat4, SFE::GLW::DYNAMIC_DRAW> bonesBO;
+	SFE::GLW::ShaderStorageBuffer<uint32_t, SFE::GLW::DYNAMIC_DRAW> materialsBO; //material table row of every entity
 
 	std::shared_mutex mtx;
 };
@@ -106,12 +122,43 @@ class Batcher {
 public:
 	Batcher() = default;
 
-	void addToDrawList(ecss::EntityId entity, unsigned VAO, size_t vertices, size_t indices, const SFE::ComponentsModule::Materials& material, const SFE::Math::Mat4& transform);
+	//material - nullptr for default material
+	void addToDrawList(ecss::EntityId entity, SFE::GeometryArena::Handle mesh, const SFE::ComponentsModule::MaterialComponent* material, const SFE::Math::Mat4& transform, const SFE::FrustumModule::AABB* bounds = nullptr);
 	void sort(const SFE::Math::Vec3& viewPos = {});
-	void flushAll();
+	//cullFrustum is used only by indirect path, instances outside of it are dropped on gpu
+	void flushAll(const SFE::FrustumModule::Frustum* cullFrustum = nullptr);
 	void clear();
 	SFE::Vector<DrawObject*> drawList;
 
+	//one glMultiDrawElementsIndirect per run of draws with the same vao and materials, instances are culled and compacted by compute shader
+	//needs gl 4.3, loadShaders turns it off on older contexts and batcher falls back to instanced draws
+	inline static bool indirectDraw = true;
+	inline static bool indirectDrawSupported = false;
+	//culling is done by IndirectDrawList on cpu instead of compute shader, to compare results
+	inline static bool cpuCulling = false;
+
+	struct FrameStats {
+		uint32_t vaoBinds = 0;
+		uint32_t drawCalls = 0;
+	};
+	//counters of all batchers since previous call, render system takes them once per frame
+	static FrameStats takeFrameStats();
+
+	//culling program is resolved once, render system loads it with programs of passes
+	static void loadShaders();
+
+private:
+	void flushInstanced();
+	void flushIndirect(const SFE::FrustumModule::Frustum* cullFrustum);
+
+	SFE::Render::IndirectDrawList mIndirectList;
+	std::vector<DrawObject*> mFlushList; //draws with uploaded meshes
+
+	inline static std::atomic<uint32_t> mVaoBinds = 0;
+	inline static std::atomic<uint32_t> mDrawCalls = 0;
+	inline static SFE::ShaderModule::ShaderBase* mCullShader = nullptr;
+
+public:
 	std::vector<GLsync> fences;
 	unsigned maxDrawSize = 10000;
 	int cur = 0;
@@ -0,0 +1,127 @@
+﻿#include "CascadePlanner.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SFE::Render {
+	std::vector<Math::Vec4> CascadePlanner::getFrustumCornersWorldSpace(const Math::Mat4& projView) {
+		const auto inv = Math::inverse(projView);
+
+		std::vector<Math::Vec4> frustumCorners;
+		for (unsigned int x = 0; x < 2; ++x) {
+			for (unsigned int y = 0; y < 2; ++y) {
+				for (unsigned int z = 0; z < 2; ++z) {
+					const Math::Vec4 pt = inv * Math::Vec4(
+						2.0f * static_cast<float>(x) - 1.0f,
+						2.0f * static_cast<float>(y) - 1.0f,
+						2.0f * static_cast<float>(z) - 1.0f,
+						1.0f
+					);
+
+					frustumCorners.push_back(pt / pt.w);
+				}
+			}
+		}
+
+		return frustumCorners;
+	}
+
+	Math::Mat4 CascadePlanner::updateLightMatrix(ShadowCascade& cascade, const Math::Mat4& cameraView, const Math::Mat4& lightTransform, float resolution, float padding) {
+		const auto corners = getFrustumCornersWorldSpace(cascade.viewProjection.getProjectionsMatrix() * cameraView);
+
+		Math::Vec4 frustumCenter = corners[0];
+		for (size_t i = 1u; i < 8; i++) {
+			frustumCenter += corners[i];
+		}
+		frustumCenter /= 8.f;
+
+		const auto s = Math::normalize(Math::Vec3(lightTransform[0]));
+		const auto u = Math::normalize(Math::Vec3(lightTransform[1]));
+		const auto f = Math::normalize(-Math::Vec3(lightTransform[2]));
+
+		//sphere radius doesn't depend on camera rotation, it is rounded to not change because of float errors
+		auto radius = 0.f;
+		for (const auto& corner : corners) {
+			radius = std::max(radius, Math::length(Math::Vec3(corner) - Math::Vec3(frustumCenter)));
+		}
+		radius = std::ceil(radius * 16.f) / 16.f;
+		const auto paddedRadius = radius * (1.f + padding);
+
+		const auto center = Math::Vec3(frustumCenter);
+		const auto offset = center - cascade.stableCenter;
+		const auto insideStable = Math::length(offset) + radius <= cascade.stableRadius;
+		if (!insideStable || cascade.stableRadius != paddedRadius || cascade.stableForward != f) {
+			//center is snapped in light space, so shadow map texels stay on the same world grid after recentering
+			const auto texel = 2.f * paddedRadius / std::max(resolution, 1.f);
+			const auto snap = [texel](float value) { return std::floor(value / texel) * texel; };
+			const auto x = snap(Math::dot(s, center));
+			const auto y = snap(Math::dot(u, center));
+			const auto z = Math::dot(f, center);
+
+			cascade.stableCenter = s * x + u * y + f * z;
+			cascade.stableForward = f;
+			cascade.stableRadius = paddedRadius;
+		}
+
+		const auto eye = cascade.stableCenter - f;
+
+		Math::Mat4 lightView(1);
+		lightView[0][0] = s.x;
+		lightView[1][0] = s.y;
+		lightView[2][0] = s.z;
+		lightView[0][1] = u.x;
+		lightView[1][1] = u.y;
+		lightView[2][1] = u.z;
+		lightView[0][2] = -f.x;
+		lightView[1][2] = -f.y;
+		lightView[2][2] = -f.z;
+		lightView[3][0] = -Math::dot(s, eye);
+		lightView[3][1] = -Math::dot(u, eye);
+		lightView[3][2] = Math::dot(f, eye);
+
+		//stable center is in 1 unit in front of eye
+		const auto stableRadius = cascade.stableRadius;
+		const auto ortho = SFE::MathModule::OrthoProjection({ -stableRadius, -stableRadius }, { stableRadius, stableRadius }, (-1.f - stableRadius) * cascade.zMult.x, (-1.f + stableRadius) * cascade.zMult.y);
+		const auto projViewMatrix = ortho.getProjectionsMatrix() * lightView;
+
+		cascade.frustum = SFE::FrustumModule::createFrustum(projViewMatrix);
+		return projViewMatrix;
+	}
+
+	CascadePlanner::Plan CascadePlanner::plan(const std::vector<Cache>& caches, const std::vector<ShadowCascade>& cascades, const std::vector<Math::Mat4>& matrices,
+		const std::vector<uint8_t>& dirty, const Settings& settings, uint64_t frame) {
+		const auto cascadesCount = std::min(matrices.size(), cascades.size());
+
+		Plan plan;
+		plan.cascades.resize(cascadesCount);
+		plan.refreshStatic.assign(cascadesCount, false);
+		plan.updateDynamic.assign(cascadesCount, false);
+
+		auto budget = settings.staticUpdatesBudget;
+		for (size_t i = 0; i < cascadesCount; i++) {
+			const auto cache = i < caches.size() ? caches[i] : Cache{};
+			auto& planned = plan.cascades[i];
+
+			const auto matrixChanged = !cache.valid || cache.matrix != matrices[i];
+			const auto staticDirty = cache.staticDirty || (i < dirty.size() && dirty[i]) || matrixChanged;
+			plan.refreshStatic[i] = staticDirty && (!cache.valid || budget-- > 0);
+
+			//cascade out of budget keeps old matrix, it is still valid while camera is inside of its padding
+			if (plan.refreshStatic[i]) {
+				planned.matrix = matrices[i];
+				planned.frustum = cascades[i].frustum;
+				planned.valid = true;
+				planned.staticDirty = false;
+			}
+			else {
+				planned = cache;
+				planned.staticDirty = staticDirty;
+			}
+
+			const auto distantFrame = settings.distantCascadesInterval <= 1 || (frame + i) % static_cast<uint64_t>(settings.distantCascadesInterval) == 0;
+			plan.updateDynamic[i] = plan.refreshStatic[i] || static_cast<int>(i) < settings.nearCascadesCount || distantFrame;
+		}
+
+		return plan;
+	}
+}
@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "assetsModule/modelModule/BoundingVolume.h"
+#include "mathModule/Forward.h"
+#include "mathModule/Projection.h"
+
+namespace SFE::Render {
+	struct ShadowCascade {
+		SFE::FrustumModule::Frustum frustum = {};
+		SFE::MathModule::PerspectiveProjection viewProjection {};
+		float bias = 0.f;
+		int samples = 64;
+
+		Math::Vec2 zMult = { 1.f,1.f };
+		Math::Vec2 texelSize = {};
+
+		//cascade covers padded bounding sphere of its camera frustum part, center moves only when sphere goes out of padding
+		//so camera motion keeps the same matrix and cached shadow map stays valid
+		Math::Vec3 stableCenter = {}; //world space, snapped to shadow map texels
+		Math::Vec3 stableForward = {};
+		float stableRadius = 0.f;
+	};
+
+	//cpu part of cascaded shadows, it builds stable light matrices of cascades and decides which cascades are rendered this frame
+	//static casters of cascade are cached in its layer, layer is rendered again when its matrix or static casters change
+	class CascadePlanner {
+	public:
+		struct Settings {
+			int staticUpdatesBudget = 1; //static layers rendered again per frame, cascades without valid cache are not limited by it
+			int nearCascadesCount = 2; //cascades starting from this one get dynamic casters only every distantCascadesInterval frames
+			int distantCascadesInterval = 4;
+		};
+
+		struct Cache {
+			Math::Mat4 matrix = {};
+			FrustumModule::Frustum frustum = {};
+			bool valid = false;
+			bool staticDirty = true;
+		};
+
+		struct Plan {
+			std::vector<Cache> cascades;
+			std::vector<uint8_t> refreshStatic;
+			std::vector<uint8_t> updateDynamic;
+			size_t dynamicCasters = 0;
+		};
+
+		//light matrix of cascade for camera view, frustum of cascade is updated too
+		//padding is part of cascade radius added around camera frustum part, resolution is shadow map width
+		static Math::Mat4 updateLightMatrix(ShadowCascade& cascade, const Math::Mat4& cameraView, const Math::Mat4& lightTransform, float resolution, float padding);
+
+		//caches are cascades state after previous plan, dirty marks cascades which static casters were changed
+		static Plan plan(const std::vector<Cache>& caches, const std::vector<ShadowCascade>& cascades, const std::vector<Math::Mat4>& matrices,
+			const std::vector<uint8_t>& dirty, const Settings& settings, uint64_t frame);
+
+		static std::vector<Math::Vec4> getFrustumCornersWorldSpace(const Math::Mat4& projView);
+	};
+}
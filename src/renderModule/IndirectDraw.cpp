@@ -0,0 +1,46 @@
+﻿#include "IndirectDraw.h"
+
+namespace SFE::Render {
+	void IndirectDrawList::clear() {
+		mCommands.clear();
+		mBounds.clear();
+		mTransforms.clear();
+		mInstances.clear();
+		mInstanceDraws.clear();
+		mCulledCommands.clear();
+		mVisibleInstances.clear();
+	}
+
+	std::vector<DrawElementsIndirectCommand> IndirectDrawList::getCullingCommands() const {
+		auto commands = mCommands;
+		for (auto& command : commands) {
+			command.instanceCount = 0;
+		}
+
+		return commands;
+	}
+
+	void IndirectDrawList::cull(const FrustumModule::Frustum* frustum) {
+		mCulledCommands = getCullingCommands();
+		mVisibleInstances.assign(mInstances.size(), 0);
+
+		for (size_t i = 0; i < mInstances.size(); i++) {
+			const auto drawIdx = mInstanceDraws[i];
+			const auto entityIdx = mInstances[i];
+
+			const auto& bounds = mBounds[drawIdx];
+			if (frustum && bounds.center.w > 0.f) {
+				const auto transforms = mTransforms[drawIdx];
+				if (transforms && entityIdx < transforms->size() && (*transforms)[entityIdx]) {
+					const FrustumModule::AABB aabb(Math::Vec3(bounds.center), bounds.extents.x, bounds.extents.y, bounds.extents.z);
+					if (!aabb.isOnFrustum(*frustum, *(*transforms)[entityIdx])) {
+						continue;
+					}
+				}
+			}
+
+			auto& command = mCulledCommands[drawIdx];
+			mVisibleInstances[command.baseInstance + command.instanceCount++] = entityIdx;
+		}
+	}
+}
@@ -0,0 +1,86 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "assetsModule/modelModule/BoundingVolume.h"
+#include "mathModule/Forward.h"
+
+namespace SFE::Render {
+	//same layout as glMultiDrawElementsIndirect expects
+	struct DrawElementsIndirectCommand {
+		uint32_t count = 0;
+		uint32_t instanceCount = 0;
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0;
+		uint32_t baseInstance = 0;
+	};
+	static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+	//mesh bounds in local space, two vec4 for std430, center.w is 0 when draw has no bounds and can't be culled
+	struct IndirectDrawBounds {
+		Math::Vec4 center;
+		Math::Vec4 extents;
+	};
+
+	//commands and instances layout for indirect drawing, cpu part of shaders/cullInstances.cs
+	//instances of command i are stored at [baseInstance, baseInstance + count of instances), culling compacts visible ones to the beginning of the same range
+	//tests/IndirectDrawTests.cpp checks culling against per instance reference
+	class IndirectDrawList {
+	public:
+		//instances - entity indices in transforms buffer, transforms - indexed by entity index, needed only for cpu culling
+		template<typename Instances>
+		void addDraw(uint32_t indicesCount, uint32_t firstIndex, int32_t baseVertex, const FrustumModule::AABB* bounds, const Instances& instances, const std::vector<const Math::Mat4*>* transforms = nullptr) {
+			const auto drawIdx = static_cast<uint32_t>(mCommands.size());
+
+			auto& command = mCommands.emplace_back();
+			command.count = indicesCount;
+			command.instanceCount = static_cast<uint32_t>(instances.size());
+			command.firstIndex = firstIndex;
+			command.baseVertex = baseVertex;
+			command.baseInstance = static_cast<uint32_t>(mInstances.size());
+
+			if (bounds) {
+				mBounds.push_back({ Math::Vec4(bounds->center, 1.f), Math::Vec4(bounds->extents, 0.f) });
+			}
+			else {
+				mBounds.push_back({});
+			}
+			mTransforms.push_back(transforms);
+
+			for (auto instance : instances) {
+				mInstances.push_back(static_cast<uint32_t>(instance));
+				mInstanceDraws.push_back(drawIdx);
+			}
+		}
+
+		void clear();
+
+		//frustum - nullptr to only compact instances, same as gpu pass with culling disabled
+		//gpu writes visible instances of a draw in any order, here they keep the original one
+		void cull(const FrustumModule::Frustum* frustum);
+
+		//commands with instanceCount reset to zero, gpu culling counts visible instances into it
+		std::vector<DrawElementsIndirectCommand> getCullingCommands() const;
+
+		const std::vector<DrawElementsIndirectCommand>& getCommands() const { return mCommands; }
+		const std::vector<IndirectDrawBounds>& getBounds() const { return mBounds; }
+		const std::vector<uint32_t>& getInstances() const { return mInstances; }
+		const std::vector<uint32_t>& getInstanceDraws() const { return mInstanceDraws; }
+
+		//results of cpu culling
+		const std::vector<DrawElementsIndirectCommand>& getCulledCommands() const { return mCulledCommands; }
+		const std::vector<uint32_t>& getVisibleInstances() const { return mVisibleInstances; }
+
+		bool empty() const { return mCommands.empty(); }
+
+	private:
+		std::vector<DrawElementsIndirectCommand> mCommands;
+		std::vector<IndirectDrawBounds> mBounds;
+		std::vector<const std::vector<const Math::Mat4*>*> mTransforms;
+		std::vector<uint32_t> mInstances;
+		std::vector<uint32_t> mInstanceDraws;
+
+		std::vector<DrawElementsIndirectCommand> mCulledCommands;
+		std::vector<uint32_t> mVisibleInstances;
+	};
+}
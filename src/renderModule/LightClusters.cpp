@@ -0,0 +1,205 @@
+﻿#include "LightClusters.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "mathModule/Float4.h"
+#include "mathModule/MatrixOperations.h"
+
+namespace SFE::Render {
+	namespace {
+		//lights are padded to four with spheres which never touch any froxel
+		constexpr float PADDING_POSITION = 1e18f;
+
+		//squared distance from point to box along one axis, 0 inside
+		Math::Float4 axisDistance(Math::Float4 value, float boxMin, float boxMax) {
+			const auto d = max(Math::Float4::zero(), max(Math::Float4::set(boxMin) - value, value - Math::Float4::set(boxMax)));
+			return d * d;
+		}
+
+		//bit i is set when light i of four touches the box
+		int testSpheres(const float* x, const float* y, const float* z, const float* radius, float minX, float minY, float minZ, float maxX, float maxY, float maxZ) {
+			using Math::Float4;
+			const auto distance = axisDistance(Float4::load(x), minX, maxX) + axisDistance(Float4::load(y), minY, maxY) + axisDistance(Float4::load(z), minZ, maxZ);
+			const auto r = Float4::load(radius);
+			return movemask(distance <= r * r);
+		}
+	}
+
+	void LightClusters::setProjection(const Math::Mat4& projection, float near, float far) {
+		if (mNear == near && mFar == far && mProjection == projection && !mMinX.empty()) {
+			return;
+		}
+
+		mNear = near;
+		mFar = far;
+		mProjection = projection;
+
+		mSliceDepth.resize(CLUSTERS_Z + 1);
+		for (uint32_t z = 0; z <= CLUSTERS_Z; z++) {
+			mSliceDepth[z] = near * std::pow(far / near, static_cast<float>(z) / static_cast<float>(CLUSTERS_Z));
+		}
+
+		for (auto* values : { &mMinX, &mMinY, &mMinZ, &mMaxX, &mMaxY, &mMaxZ }) {
+			values->resize(CLUSTERS_COUNT);
+		}
+
+		//tile corner on near plane, point of the same ray on depth d is corner * d / -corner.z
+		const auto inverseProjection = Math::inverse(projection);
+		const auto corner = [&inverseProjection](uint32_t x, uint32_t y) {
+			const auto ndcX = -1.f + 2.f * static_cast<float>(x) / static_cast<float>(CLUSTERS_X);
+			const auto ndcY = -1.f + 2.f * static_cast<float>(y) / static_cast<float>(CLUSTERS_Y);
+			const auto point = inverseProjection * Math::Vec4(ndcX, ndcY, -1.f, 1.f);
+			return Math::Vec3(point.x / point.w, point.y / point.w, point.z / point.w);
+		};
+
+		for (uint32_t z = 0; z < CLUSTERS_Z; z++) {
+			for (uint32_t y = 0; y < CLUSTERS_Y; y++) {
+				for (uint32_t x = 0; x < CLUSTERS_X; x++) {
+					const auto idx = getClusterIndex(x, y, z);
+					mMinX[idx] = mMinY[idx] = mMinZ[idx] = std::numeric_limits<float>::max();
+					mMaxX[idx] = mMaxY[idx] = mMaxZ[idx] = std::numeric_limits<float>::lowest();
+
+					for (const auto& nearCorner : { corner(x, y), corner(x + 1, y), corner(x, y + 1), corner(x + 1, y + 1) }) {
+						for (const auto depth : { mSliceDepth[z], mSliceDepth[z + 1] }) {
+							const auto scale = depth / -nearCorner.z;
+							mMinX[idx] = std::min(mMinX[idx], nearCorner.x * scale);
+							mMinY[idx] = std::min(mMinY[idx], nearCorner.y * scale);
+							mMinZ[idx] = std::min(mMinZ[idx], -depth);
+							mMaxX[idx] = std::max(mMaxX[idx], nearCorner.x * scale);
+							mMaxY[idx] = std::max(mMaxY[idx], nearCorner.y * scale);
+							mMaxZ[idx] = std::max(mMaxZ[idx], -depth);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void LightClusters::assign(const Math::Mat4& view, const std::vector<Light>& lights, const ParallelFor& parallelFor) {
+		const auto start = std::chrono::steady_clock::now();
+
+		mLightX.resize(lights.size());
+		mLightY.resize(lights.size());
+		mLightZ.resize(lights.size());
+		mLightRadius.resize(lights.size());
+		for (size_t i = 0; i < lights.size(); i++) {
+			const auto position = view * lights[i].position;
+			mLightX[i] = position.x;
+			mLightY[i] = position.y;
+			mLightZ[i] = position.z;
+			mLightRadius[i] = lights[i].radius;
+		}
+
+		mSlices.resize(CLUSTERS_Z);
+		if (parallelFor) {
+			parallelFor(CLUSTERS_Z, [this](size_t slice) { assignSlice(static_cast<uint32_t>(slice)); });
+		}
+		else {
+			for (uint32_t slice = 0; slice < CLUSTERS_Z; slice++) {
+				assignSlice(slice);
+			}
+		}
+
+		mClusters.resize(CLUSTERS_COUNT);
+		mLightIndices.clear();
+		for (uint32_t slice = 0; slice < CLUSTERS_Z; slice++) {
+			const auto& data = mSlices[slice];
+			const auto base = static_cast<uint32_t>(mLightIndices.size());
+			for (uint32_t i = 0; i < CLUSTERS_X * CLUSTERS_Y; i++) {
+				mClusters[slice * CLUSTERS_X * CLUSTERS_Y + i] = { base + data.clusters[i].offset, data.clusters[i].count };
+			}
+			mLightIndices.insert(mLightIndices.end(), data.indices.begin(), data.indices.end());
+		}
+
+		mAssignmentTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	uint32_t LightClusters::getSlice(float depth) const {
+		if (depth <= mNear) {
+			return 0;
+		}
+
+		const auto slice = std::log(depth / mNear) / std::log(mFar / mNear) * static_cast<float>(CLUSTERS_Z);
+		return std::min(static_cast<uint32_t>(slice), CLUSTERS_Z - 1);
+	}
+
+	void LightClusters::assignSlice(uint32_t slice) {
+		auto& data = mSlices[slice];
+		data.slice.clear();
+		data.clusters.assign(CLUSTERS_X * CLUSTERS_Y, {});
+		data.indices.clear();
+
+		//only lights which depth range crosses slice are tested against its froxels
+		const auto sliceNear = mSliceDepth[slice];
+		const auto sliceFar = mSliceDepth[slice + 1];
+		for (size_t i = 0; i < mLightX.size(); i++) {
+			const auto depth = -mLightZ[i];
+			if (depth + mLightRadius[i] < sliceNear || depth - mLightRadius[i] > sliceFar) {
+				continue;
+			}
+
+			data.slice.push(mLightX[i], mLightY[i], mLightZ[i], mLightRadius[i], static_cast<uint32_t>(i));
+		}
+
+		if (data.slice.lights.empty()) {
+			return;
+		}
+
+		const auto pad = [](SliceLights& lights) {
+			const auto paddedCount = (lights.lights.size() + 3) & ~size_t(3);
+			lights.x.resize(paddedCount, PADDING_POSITION);
+			lights.y.resize(paddedCount, PADDING_POSITION);
+			lights.z.resize(paddedCount, PADDING_POSITION);
+			lights.radius.resize(paddedCount, 0.f);
+		};
+		pad(data.slice);
+
+		//lights are filtered by the whole row of tiles first, so every froxel is tested only with lights of its row
+		for (uint32_t row = 0; row < CLUSTERS_Y; row++) {
+			const auto first = getClusterIndex(0, row, slice);
+			const auto last = first + CLUSTERS_X;
+			const auto rowMinX = *std::min_element(&mMinX[first], &mMinX[0] + last);
+			const auto rowMinY = *std::min_element(&mMinY[first], &mMinY[0] + last);
+			const auto rowMaxX = *std::max_element(&mMaxX[first], &mMaxX[0] + last);
+			const auto rowMaxY = *std::max_element(&mMaxY[first], &mMaxY[0] + last);
+
+			auto& rowLights = data.row;
+			rowLights.clear();
+			const auto& sliceLights = data.slice;
+			for (size_t i = 0; i < sliceLights.x.size(); i += 4) {
+				auto mask = testSpheres(&sliceLights.x[i], &sliceLights.y[i], &sliceLights.z[i], &sliceLights.radius[i], rowMinX, rowMinY, mMinZ[first], rowMaxX, rowMaxY, mMaxZ[first]);
+				for (; mask; mask &= mask - 1) {
+					const auto lane = i + std::countr_zero(static_cast<unsigned>(mask));
+					rowLights.push(sliceLights.x[lane], sliceLights.y[lane], sliceLights.z[lane], sliceLights.radius[lane], sliceLights.lights[lane]);
+				}
+			}
+
+			if (rowLights.lights.empty()) {
+				//empty clusters still point to the end, so ranges stay packed
+				for (auto idx = first; idx < last; idx++) {
+					data.clusters[idx - slice * CLUSTERS_X * CLUSTERS_Y].offset = static_cast<uint32_t>(data.indices.size());
+				}
+				continue;
+			}
+			pad(rowLights);
+
+			for (auto idx = first; idx < last; idx++) {
+				auto& cluster = data.clusters[idx - slice * CLUSTERS_X * CLUSTERS_Y];
+				cluster.offset = static_cast<uint32_t>(data.indices.size());
+
+				for (size_t i = 0; i < rowLights.x.size(); i += 4) {
+					auto mask = testSpheres(&rowLights.x[i], &rowLights.y[i], &rowLights.z[i], &rowLights.radius[i], mMinX[idx], mMinY[idx], mMinZ[idx], mMaxX[idx], mMaxY[idx], mMaxZ[idx]);
+					for (; mask; mask &= mask - 1) {
+						data.indices.push_back(rowLights.lights[i + std::countr_zero(static_cast<unsigned>(mask))]);
+					}
+				}
+
+				cluster.count = static_cast<uint32_t>(data.indices.size()) - cluster.offset;
+			}
+		}
+	}
+}
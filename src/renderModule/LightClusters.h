@@ -0,0 +1,106 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "mathModule/Forward.h"
+
+namespace SFE::Render {
+	//clustered light culling, view frustum is split into froxels (screen tiles x exponential depth slices) and every froxel gets compact list of lights touching it
+	//lighting pass uploads clusters and indices, so fragment is shaded only with lights of its own cluster
+	//assignment is covered by tests/LightClustersTests.cpp
+	class LightClusters {
+	public:
+		//should call task(i) for every i in [0, count), it is allowed to do it from different threads
+		using ParallelFor = std::function<void(size_t count, const std::function<void(size_t)>& task)>;
+
+		constexpr static uint32_t CLUSTERS_X = 16;
+		constexpr static uint32_t CLUSTERS_Y = 9;
+		constexpr static uint32_t CLUSTERS_Z = 24;
+		constexpr static uint32_t CLUSTERS_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+		//world space sphere of light influence
+		struct Light {
+			Math::Vec3 position;
+			float radius = 0.f;
+		};
+
+		//range in light indices list, the same layout as uvec2 in shader
+		struct Cluster {
+			uint32_t offset = 0;
+			uint32_t count = 0;
+		};
+
+		//froxels are rebuilt only when projection or planes are changed
+		void setProjection(const Math::Mat4& projection, float near, float far);
+
+		//every slice is processed as separate task, without parallelFor everything is done on calling thread
+		void assign(const Math::Mat4& view, const std::vector<Light>& lights, const ParallelFor& parallelFor = {});
+
+		//index of cluster is x + y * CLUSTERS_X + z * CLUSTERS_X * CLUSTERS_Y, y goes from the bottom of screen
+		static uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t z) { return x + y * CLUSTERS_X + z * CLUSTERS_X * CLUSTERS_Y; }
+		//depth is positive view space distance
+		uint32_t getSlice(float depth) const;
+
+		const std::vector<Cluster>& getClusters() const { return mClusters; }
+		//values are indices in lights vector passed to assign
+		const std::vector<uint32_t>& getLightIndices() const { return mLightIndices; }
+
+		float getNear() const { return mNear; }
+		float getFar() const { return mFar; }
+
+		//time of the last assign in milliseconds
+		float getAssignmentTime() const { return mAssignmentTime; }
+
+	private:
+		//view space lights and froxels are kept as structure of arrays, so four lights are tested against froxel at once
+		struct SliceLights {
+			std::vector<float> x;
+			std::vector<float> y;
+			std::vector<float> z;
+			std::vector<float> radius;
+			std::vector<uint32_t> lights;
+
+			void push(float lightX, float lightY, float lightZ, float lightRadius, uint32_t light) {
+				x.push_back(lightX);
+				y.push_back(lightY);
+				z.push_back(lightZ);
+				radius.push_back(lightRadius);
+				lights.push_back(light);
+			}
+
+			void clear() {
+				x.clear();
+				y.clear();
+				z.clear();
+				radius.clear();
+				lights.clear();
+			}
+		};
+
+		struct SliceData {
+			SliceLights slice;
+			SliceLights row;
+
+			std::vector<Cluster> clusters; //offsets are local for slice
+			std::vector<uint32_t> indices;
+		};
+
+		void assignSlice(uint32_t slice);
+
+		float mNear = 0.f;
+		float mFar = 0.f;
+		Math::Mat4 mProjection = {};
+
+		std::vector<float> mSliceDepth; //CLUSTERS_Z + 1 slice borders
+		std::vector<float> mMinX, mMinY, mMinZ, mMaxX, mMaxY, mMaxZ; //froxels aabb in view space
+
+		std::vector<float> mLightX, mLightY, mLightZ, mLightRadius;
+		std::vector<SliceData> mSlices;
+
+		std::vector<Cluster> mClusters;
+		std::vector<uint32_t> mLightIndices;
+
+		float mAssignmentTime = 0.f;
+	};
+}
@@ -0,0 +1,241 @@
+﻿#include "MaterialSystem.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "assetsModule/modelModule/Material.h"
+#include "core/Engine.h"
+#include "debugModule/Benchmark.h"
+#include "renderModule/TextureStreamer.h"
+
+namespace SFE::Render {
+	void MaterialSystem::init() {
+		mMaterialsBO.generate();
+		mMaterialsBO.bind();
+		mMaterialsBO.setBufferBinding(MATERIALS_BINDING);
+		mMaterialsBO.unbind();
+	}
+
+	uint32_t MaterialSystem::getMaterial(const ComponentsModule::Materials& materials) {
+		assert(Engine::isRenderThread());
+		std::unique_lock lock(mMutex);
+
+		//only diffuse, normal and specular 2d textures are in pages, other slots are ignored
+		MaterialTable::Textures textures{};
+		for (auto i = 0; i < materials.materialsCount; i++) {
+			const auto& material = materials.material[i];
+			const auto slot = getTextureSlot(material.slot);
+			if (slot && material.type == GLW::TEXTURE_2D) {
+				textures[*slot] = material.textureId;
+			}
+		}
+
+		const auto rows = mTable.getRows().size();
+		const auto material = mTable.getMaterial(textures, &MaterialSystem::resolveTexture);
+		mRowsChanged |= mTable.getRows().size() != rows;
+
+		return material;
+	}
+
+	std::optional<MaterialTable::TextureSlot> MaterialSystem::getTextureSlot(int materialSlot) {
+		switch (materialSlot) {
+		case DIFFUSE: return MaterialTable::DIFFUSE_TEXTURE;
+		case NORMALS: return MaterialTable::NORMAL_TEXTURE;
+		case SPECULAR: return MaterialTable::SPECULAR_TEXTURE;
+		default: return std::nullopt;
+		}
+	}
+
+	MaterialTable::Bindings MaterialSystem::getBindings(uint32_t material) const {
+		std::shared_lock lock(mMutex);
+		return material < mTable.getRows().size() ? mTable.getBindings(material) : MaterialTable::Bindings{};
+	}
+
+	void MaterialSystem::update() {
+		FUNCTION_BENCHMARK;
+		assert(Engine::isRenderThread());
+		std::unique_lock lock(mMutex);
+
+		if (mTable.hasPending()) {
+			mRowsChanged |= mTable.resolvePending(&MaterialSystem::resolveTexture);
+		}
+
+		for (size_t i = 0; i < mTable.getPages().size(); i++) {
+			updatePage(i);
+		}
+
+		if (mRowsChanged) {
+			mRowsChanged = false;
+
+			//table is small, it is reuploaded whole and driver gives new storage instead of waiting for gpu
+			mMaterialsBO.bind();
+			mMaterialsBO.allocateData(mTable.getRows());
+			mMaterialsBO.setBufferBinding(MATERIALS_BINDING);
+			mMaterialsBO.unbind();
+		}
+	}
+
+	void MaterialSystem::bindPages(const MaterialTable::Bindings& bindings) const {
+		constexpr int slots[] = { DIFFUSE_ARRAY_SLOT, NORMAL_ARRAY_SLOT, SPECULAR_ARRAY_SLOT };
+		for (size_t i = 0; i < MaterialTable::TEXTURE_SLOTS_COUNT; i++) {
+			const auto page = bindings.pages[i];
+			//material without this texture doesn't sample it, previous page can stay bound
+			if (page >= mPageTextures.size() || !mPageTextures[page].texture) {
+				continue;
+			}
+
+			GLW::bindTextureToSlot(slots[i], GLW::TEXTURE_2D_ARRAY, mPageTextures[page].texture->mId);
+		}
+	}
+
+	size_t MaterialSystem::getPagesCount() const {
+		std::shared_lock lock(mMutex);
+		return mPageTextures.size();
+	}
+
+	size_t MaterialSystem::getMaterialsCount() const {
+		std::shared_lock lock(mMutex);
+		return mTable.getRows().size();
+	}
+
+	std::optional<TextureArrayKey> MaterialSystem::resolveTexture(uint32_t textureId) {
+		if (!glIsTexture(textureId)) {
+			return std::nullopt;
+		}
+
+		GLint width = 0;
+		GLint height = 0;
+		GLint format = 0;
+		GLint baseLevel = 0;
+		GLint maxLevel = 0;
+		GLW::bindTextureToSlot(0, GLW::TEXTURE_2D, textureId);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &baseLevel);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+
+		//levels which are uploaded, the whole chain is copied into page
+		uint32_t levels = 0;
+		for (GLint levelWidth = width; levelWidth > 0 && static_cast<GLint>(levels) <= maxLevel; levels++) {
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, static_cast<GLint>(levels) + 1, GL_TEXTURE_WIDTH, &levelWidth);
+		}
+		GLW::bindTextureToSlot(0, GLW::TEXTURE_2D, 0);
+
+		//streamed texture lowers base level while mips arrive, page copies all levels, so it waits for the first one
+		if (width <= 0 || height <= 0 || baseLevel != 0) {
+			if (baseLevel != 0) {
+				TextureStreamer::instance()->requestFull(textureId);
+			}
+			return std::nullopt;
+		}
+
+		return TextureArrayKey{ static_cast<uint32_t>(format), static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::max(levels, 1u) };
+	}
+
+	void MaterialSystem::updatePage(size_t pageIdx) {
+		const auto& page = mTable.getPages()[pageIdx];
+		if (mPageTextures.size() <= pageIdx) {
+			mPageTextures.resize(pageIdx + 1);
+		}
+
+		auto& pageTexture = mPageTextures[pageIdx];
+		if (pageTexture.loading || (pageTexture.capacity == page.capacity && pageTexture.layers == page.textures.size())) {
+			return;
+		}
+
+		const auto base = std::min(pageTexture.base, page.key.levels - 1);
+		if (pageTexture.capacity != page.capacity) {
+			auto texture = createPageTexture(page, base);
+
+			//grown page keeps already copied layers
+			if (pageTexture.texture && pageTexture.layers) {
+				for (auto level = base; level < page.key.levels; level++) {
+					copyLevel(pageTexture.texture->mId, GL_TEXTURE_2D_ARRAY, 0, level - base, texture->mId, 0, level - base, page.key.width >> level, page.key.height >> level, pageTexture.layers);
+				}
+			}
+
+			pageTexture.texture = std::move(texture);
+			pageTexture.capacity = page.capacity;
+		}
+
+		for (auto layer = pageTexture.layers; layer < page.textures.size(); layer++) {
+			for (auto level = base; level < page.key.levels; level++) {
+				copyLevel(page.textures[layer], GL_TEXTURE_2D, 0, level, pageTexture.texture->mId, static_cast<GLint>(layer), level - base, page.key.width >> level, page.key.height >> level, 1);
+			}
+		}
+		pageTexture.layers = static_cast<uint32_t>(page.textures.size());
+		pageTexture.base = base;
+
+		//page keeps the only full copy, source textures go down to their smallest levels and page levels are streamed instead
+		TextureStreamer::instance()->setPage(pageIdx, page, base);
+	}
+
+	unsigned MaterialSystem::setPageBase(size_t pageIdx, uint32_t base) {
+		assert(Engine::isRenderThread());
+		std::unique_lock lock(mMutex);
+
+		if (pageIdx >= mPageTextures.size() || !mPageTextures[pageIdx].texture) {
+			return 0;
+		}
+
+		const auto& page = mTable.getPages()[pageIdx];
+		auto& pageTexture = mPageTextures[pageIdx];
+		base = std::min(base, page.key.levels - 1);
+		if (base == pageTexture.base) {
+			return pageTexture.texture->mId;
+		}
+
+		//levels which both storages have are copied, finer ones are loaded by streamer
+		auto texture = createPageTexture(page, base);
+		for (auto level = std::max(base, pageTexture.base); level < page.key.levels; level++) {
+			copyLevel(pageTexture.texture->mId, GL_TEXTURE_2D_ARRAY, 0, level - pageTexture.base, texture->mId, 0, level - base, page.key.width >> level, page.key.height >> level, pageTexture.layers);
+		}
+
+		if (base < pageTexture.base) {
+			texture->parameters.baseLevel = static_cast<int>(pageTexture.base - base);
+			texture->bind();
+			texture->setParameter(GLW::BASE_LEVEL, texture->parameters.baseLevel);
+			texture->unbind();
+			pageTexture.loading = true;
+		}
+
+		pageTexture.texture = std::move(texture);
+		pageTexture.base = base;
+
+		return pageTexture.texture->mId;
+	}
+
+	void MaterialSystem::finishPageLoad(size_t pageIdx) {
+		assert(Engine::isRenderThread());
+		std::unique_lock lock(mMutex);
+
+		if (pageIdx < mPageTextures.size()) {
+			mPageTextures[pageIdx].loading = false;
+		}
+	}
+
+	std::unique_ptr<GLW::Texture> MaterialSystem::createPageTexture(const MaterialTable::Page& page, uint32_t base) const {
+		const auto levels = page.key.levels - base;
+
+		auto texture = std::make_unique<GLW::Texture>();
+		texture->mType = GLW::TEXTURE_2D_ARRAY;
+		texture->width = static_cast<int>(std::max(page.key.width >> base, 1u));
+		texture->height = static_cast<int>(std::max(page.key.height >> base, 1u));
+		texture->depth = static_cast<int>(page.capacity);
+		texture->pixelFormat = static_cast<GLW::PixelFormat>(page.key.format);
+		texture->parameters.minFilter = levels > 1 ? GLW::TextureMinFilter::LINEAR_MIPMAP_LINEAR : GLW::TextureMinFilter::LINEAR;
+		texture->parameters.magFilter = GLW::TextureMagFilter::LINEAR;
+		texture->parameters.maxLevel = static_cast<int>(levels) - 1;
+		texture->parameters.wrap.S = GLW::TextureWrap::REPEAT;
+		texture->parameters.wrap.T = GLW::TextureWrap::REPEAT;
+		//storage accepts compressed formats too, layers are copied from textures of the same format
+		texture->createStorage3D(static_cast<int>(levels));
+
+		return texture;
+	}
+
+	void MaterialSystem::copyLevel(unsigned source, unsigned sourceTarget, int sourceLayer, uint32_t sourceLevel, unsigned destination, int destinationLayer, uint32_t destinationLevel, uint32_t width, uint32_t height, uint32_t layers) {
+		glCopyImageSubData(source, sourceTarget, static_cast<GLint>(sourceLevel), 0, 0, sourceLayer, destination, GL_TEXTURE_2D_ARRAY, static_cast<GLint>(destinationLevel), 0, 0, destinationLayer, static_cast<GLsizei>(std::max(width, 1u)), static_cast<GLsizei>(std::max(height, 1u)), static_cast<GLsizei>(layers));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+#include "componentsModule/MaterialComponent.h"
+#include "containersModule/Singleton.h"
+#include "glWrapper/Buffer.h"
+#include "glWrapper/Texture.h"
+#include "renderModule/MaterialTable.h"
+
+namespace SFE::Render {
+	//material textures are copied into 2d array pages, materials are rows of ssbo table indexed per instance
+	//draw only binds array pages, so instances with different materials are drawn by one command
+	class MaterialSystem : public Singleton<MaterialSystem> {
+	public:
+		//texture units of array pages, they differ from legacy material slots because sampler types can't share unit
+		constexpr static int DIFFUSE_ARRAY_SLOT = 20;
+		constexpr static int NORMAL_ARRAY_SLOT = 21;
+		constexpr static int SPECULAR_ARRAY_SLOT = 22;
+
+		//binding indices of shaders/g_buffer.vs and shaders/g_buffer.fs
+		constexpr static int MATERIAL_INDICES_BINDING = 18;
+		constexpr static int MATERIALS_BINDING = 19;
+
+		//per draw texture binds are used when disabled
+		inline static bool enabled = true;
+
+		void init() override;
+
+		//render thread only, textures are copied into pages in update
+		uint32_t getMaterial(const ComponentsModule::Materials& materials);
+		//any thread
+		MaterialTable::Bindings getBindings(uint32_t material) const;
+
+		//render thread only, retries textures which were not loaded yet, copies new layers and uploads table
+		void update();
+		void bindPages(const MaterialTable::Bindings& bindings) const;
+
+		//render thread, pages are streamed as one texture, base is the finest level which page keeps
+		//levels finer than previous base are not filled, they are hidden by base level parameter until finishPageLoad
+		//returns texture which upload worker should fill, 0 if page doesn't exist
+		unsigned setPageBase(size_t pageIdx, uint32_t base);
+		void finishPageLoad(size_t pageIdx);
+
+		size_t getPagesCount() const;
+		size_t getMaterialsCount() const;
+
+	private:
+		struct PageTexture {
+			std::unique_ptr<GLW::Texture> texture;
+			uint32_t capacity = 0;
+			uint32_t layers = 0; //already copied
+			uint32_t base = 0;
+			bool loading = false; //layers are not copied while streamer fills levels
+		};
+
+		static std::optional<TextureArrayKey> resolveTexture(uint32_t textureId);
+		static std::optional<MaterialTable::TextureSlot> getTextureSlot(int materialSlot);
+		void updatePage(size_t pageIdx);
+		std::unique_ptr<GLW::Texture> createPageTexture(const MaterialTable::Page& page, uint32_t base) const;
+		//level of layers range, source is 2d texture or array page
+		static void copyLevel(unsigned source, unsigned sourceTarget, int sourceLayer, uint32_t sourceLevel, unsigned destination, int destinationLayer, uint32_t destinationLevel, uint32_t width, uint32_t height, uint32_t layers);
+
+		MaterialTable mTable;
+		std::vector<PageTexture> mPageTextures;
+
+		GLW::ShaderStorageBuffer<GpuMaterial, GLW::DYNAMIC_DRAW> mMaterialsBO;
+		bool mRowsChanged = false;
+
+		mutable std::shared_mutex mMutex;
+	};
+}
@@ -0,0 +1,87 @@
+﻿#include "MaterialTable.h"
+
+#include <algorithm>
+
+namespace SFE::Render {
+	MaterialTable::MaterialTable() {
+		mRows.emplace_back();
+		mBindings.emplace_back();
+		mRowTextures.push_back({});
+		mMaterials.emplace(mRowTextures.back(), DEFAULT_MATERIAL);
+	}
+
+	uint32_t MaterialTable::getMaterial(const Textures& textures, const TextureResolver& resolver) {
+		const auto it = mMaterials.find(textures);
+		if (it != mMaterials.end()) {
+			return it->second;
+		}
+
+		const auto row = static_cast<uint32_t>(mRows.size());
+		mRows.emplace_back();
+		mBindings.emplace_back();
+		mRowTextures.push_back(textures);
+		mMaterials.emplace(textures, row);
+
+		bool changed = false;
+		if (!resolveRow(row, resolver, changed)) {
+			mPendingRows.push_back(row);
+		}
+
+		return row;
+	}
+
+	bool MaterialTable::resolvePending(const TextureResolver& resolver) {
+		bool changed = false;
+		std::erase_if(mPendingRows, [this, &resolver, &changed](uint32_t row) {
+			return resolveRow(row, resolver, changed);
+		});
+
+		return changed;
+	}
+
+	bool MaterialTable::resolveRow(uint32_t row, const TextureResolver& resolver, bool& changed) {
+		bool resolved = true;
+		for (size_t slot = 0; slot < TEXTURE_SLOTS_COUNT; slot++) {
+			const auto textureId = mRowTextures[row][slot];
+			if (!textureId || mRows[row].layers[slot] >= 0) {
+				continue;
+			}
+
+			auto placeIt = mTextures.find(textureId);
+			if (placeIt == mTextures.end()) {
+				const auto key = resolver(textureId);
+				if (!key) {
+					resolved = false;
+					continue;
+				}
+
+				placeIt = mTextures.emplace(textureId, placeTexture(textureId, *key)).first;
+			}
+
+			mRows[row].layers[slot] = placeIt->second.layer;
+			mBindings[row].pages[slot] = placeIt->second.page;
+			changed = true;
+		}
+
+		return resolved;
+	}
+
+	MaterialTable::Place MaterialTable::placeTexture(uint32_t textureId, const TextureArrayKey& key) {
+		auto pageIt = std::ranges::find_if(mPages, [&key](const Page& page) {
+			return page.key == key && page.textures.size() < MAX_PAGE_LAYERS;
+		});
+
+		if (pageIt == mPages.end()) {
+			pageIt = mPages.insert(mPages.end(), Page{ key, MIN_PAGE_LAYERS, {} });
+		}
+
+		auto& page = *pageIt;
+		if (page.textures.size() == page.capacity) {
+			page.capacity = std::min(page.capacity * 2, MAX_PAGE_LAYERS);
+		}
+
+		page.textures.push_back(textureId);
+
+		return { static_cast<uint32_t>(std::distance(mPages.begin(), pageIt)), static_cast<int32_t>(page.textures.size() - 1) };
+	}
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace SFE::Render {
+	//textures are packed into array pages only with textures of the same format, size and mip chain
+	struct TextureArrayKey {
+		uint32_t format = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t levels = 1;
+
+		bool operator==(const TextureArrayKey& other) const = default;
+	};
+
+	//std430 row of material table, layer -1 means that material has no such texture and shader uses default value
+	struct GpuMaterial {
+		int32_t layers[3] = { -1, -1, -1 }; //diffuse, normal, specular
+		int32_t padding = 0;
+	};
+	static_assert(sizeof(GpuMaterial) == 16);
+
+	//cpu part of material system, it decides which array page and layer every texture gets and builds rows of material table
+	//texture format and size are asked through resolver
+	class MaterialTable {
+	public:
+		enum TextureSlot : uint8_t {
+			DIFFUSE_TEXTURE,
+			NORMAL_TEXTURE,
+			SPECULAR_TEXTURE,
+			TEXTURE_SLOTS_COUNT
+		};
+
+		constexpr static uint32_t INVALID_PAGE = std::numeric_limits<uint32_t>::max();
+		constexpr static uint32_t DEFAULT_MATERIAL = 0;
+		constexpr static uint32_t MIN_PAGE_LAYERS = 4;
+		constexpr static uint32_t MAX_PAGE_LAYERS = 256;
+
+		//texture id of every slot, 0 when material has no texture in slot
+		using Textures = std::array<uint32_t, TEXTURE_SLOTS_COUNT>;
+
+		//nullopt when texture is not created yet, it is asked again in resolvePending
+		using TextureResolver = std::function<std::optional<TextureArrayKey>(uint32_t textureId)>;
+
+		//array pages which should be bound for material, draws of materials with equal bindings can be merged
+		struct Bindings {
+			std::array<uint32_t, TEXTURE_SLOTS_COUNT> pages{ INVALID_PAGE, INVALID_PAGE, INVALID_PAGE };
+
+			bool operator==(const Bindings& other) const = default;
+		};
+
+		struct Page {
+			TextureArrayKey key;
+			uint32_t capacity = 0; //layers count, it doubles up to MAX_PAGE_LAYERS while page is filled
+			std::vector<uint32_t> textures; //texture id of every used layer
+		};
+
+		MaterialTable();
+
+		//materials with the same textures share row
+		uint32_t getMaterial(const Textures& textures, const TextureResolver& resolver);
+		//returns true when some rows got new layers
+		bool resolvePending(const TextureResolver& resolver);
+		bool hasPending() const { return !mPendingRows.empty(); }
+
+		const std::vector<GpuMaterial>& getRows() const { return mRows; }
+		const Bindings& getBindings(uint32_t material) const { return mBindings[material]; }
+		const std::vector<Page>& getPages() const { return mPages; }
+
+	private:
+		struct Place {
+			uint32_t page = INVALID_PAGE;
+			int32_t layer = -1;
+		};
+
+		Place placeTexture(uint32_t textureId, const TextureArrayKey& key);
+		//returns true when row has all its textures placed
+		bool resolveRow(uint32_t row, const TextureResolver& resolver, bool& changed);
+
+		std::vector<GpuMaterial> mRows;
+		std::vector<Bindings> mBindings;
+		std::vector<Textures> mRowTextures;
+		std::vector<uint32_t> mPendingRows;
+
+		std::map<Textures, uint32_t> mMaterials;
+		std::unordered_map<uint32_t, Place> mTextures;
+		std::vector<Page> mPages;
+	};
+}
@@ -0,0 +1,250 @@
+﻿#include "PointShadowScheduler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "mathModule/VectorOperations.h"
+
+namespace SFE::Render {
+	namespace {
+		//light moved less than this keeps its shadow maps
+		constexpr float MOVE_EPSILON = 1e-3f;
+	}
+
+	PointShadowScheduler::PointShadowScheduler() {
+		mAtlas.reset(mSettings.pageSize, mSettings.pagesCount, mSettings.minResolution);
+	}
+
+	void PointShadowScheduler::setSettings(const Settings& settings) {
+		const auto layoutChanged = settings.pageSize != mSettings.pageSize || settings.pagesCount != mSettings.pagesCount || settings.minResolution != mSettings.minResolution;
+		const auto resolutionChanged = settings.maxResolution != mSettings.maxResolution;
+		mSettings = settings;
+		mSettings.maxResolution = std::clamp(std::bit_ceil(std::max(mSettings.maxResolution, 1u)), std::max(mSettings.minResolution, 1u), std::max(mSettings.pageSize, 1u));
+
+		if (layoutChanged) {
+			mAtlas.reset(mSettings.pageSize, mSettings.pagesCount, mSettings.minResolution);
+			mStates.clear();
+		}
+		else if (resolutionChanged) {
+			for (auto& [id, state] : mStates) {
+				if (state.resolution > mSettings.maxResolution) {
+					release(state);
+				}
+			}
+		}
+	}
+
+	float PointShadowScheduler::getScreenSize(const View& view, const Math::Vec3& position, float radius) {
+		const auto distanceSquared = Math::lengthSquared(position - view.position);
+		const auto radiusSquared = radius * radius;
+		if (distanceSquared <= radiusSquared) {
+			return view.screenHeight;
+		}
+
+		//tangent of angular radius of sphere, projected to screen
+		return radius / std::sqrt(distanceSquared - radiusSquared) * view.projectionScale * view.screenHeight;
+	}
+
+	const std::vector<PointShadowScheduler::FaceUpdate>& PointShadowScheduler::update(const View& view, const std::vector<Light>& lights) {
+		mFrame++;
+		mUpdates.clear();
+		mShadows.clear();
+		mStats = {};
+		mStats.lights = lights.size();
+
+		std::vector<std::pair<float, uint32_t>> order;
+		order.reserve(lights.size());
+		for (const auto& light : lights) {
+			auto [it, inserted] = mStates.try_emplace(light.id);
+			auto& state = it->second;
+
+			//casters could change while light wasn't watched, so it is dirty after coming back
+			const auto moved = inserted || state.radius != light.radius || Math::lengthSquared(state.position - light.position) > MOVE_EPSILON * MOVE_EPSILON;
+			const auto wasAway = !inserted && state.seenFrame + 1 < mFrame;
+			if (moved || wasAway || light.castersChanged) {
+				state.dirtyFaces = ALL_FACES;
+			}
+
+			state.position = light.position;
+			state.radius = light.radius;
+			state.importance = getScreenSize(view, light.position, light.radius);
+			state.seenFrame = mFrame;
+
+			order.emplace_back(state.importance, light.id);
+		}
+
+		std::sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) {
+			return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+		});
+		order.resize(std::min(order.size(), static_cast<size_t>(mSettings.maxShadowedLights)));
+
+		//all chosen lights are marked first, so allocation never takes tiles of other chosen light
+		for (const auto& [importance, id] : order) {
+			mStates[id].shadowedFrame = mFrame;
+		}
+
+		std::vector<uint32_t> shadowed;
+		shadowed.reserve(order.size());
+		for (const auto& [importance, id] : order) {
+			auto& state = mStates[id];
+			const auto resolution = chooseResolution(state, importance);
+			if (resolution != state.resolution) {
+				if (allocate(state, resolution, id)) {
+					mStats.reallocations++;
+				}
+				else if (!state.resolution) {
+					continue;
+				}
+			}
+
+			shadowed.push_back(id);
+		}
+
+		//faces without any content go first, then the biggest on screen and the longest waiting
+		struct Candidate {
+			bool empty = false;
+			float priority = 0.f;
+			uint32_t id = 0;
+			uint32_t face = 0;
+		};
+		std::vector<Candidate> candidates;
+		for (const auto id : shadowed) {
+			const auto& state = mStates[id];
+			for (uint32_t face = 0; face < FACES; face++) {
+				if (state.dirtyFaces & 1 << face) {
+					candidates.push_back({ !(state.renderedFaces & 1 << face), state.importance * static_cast<float>(state.dirtyFrames + 1), id, face });
+				}
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) {
+			if (lhs.empty != rhs.empty) {
+				return lhs.empty;
+			}
+			if (lhs.priority != rhs.priority) {
+				return lhs.priority > rhs.priority;
+			}
+			return lhs.id < rhs.id || (lhs.id == rhs.id && lhs.face < rhs.face);
+		});
+
+		const auto updatesCount = std::min(candidates.size(), static_cast<size_t>(mSettings.facesBudget));
+		for (size_t i = 0; i < updatesCount; i++) {
+			const auto& candidate = candidates[i];
+			auto& state = mStates[candidate.id];
+			state.dirtyFaces &= ~(1 << candidate.face);
+			state.renderedFaces |= 1 << candidate.face;
+			mUpdates.push_back({ candidate.id, candidate.face, state.faces[candidate.face] });
+		}
+
+		for (const auto id : shadowed) {
+			auto& state = mStates[id];
+			state.dirtyFrames = state.dirtyFaces ? state.dirtyFrames + 1 : 0;
+
+			if (state.renderedFaces == ALL_FACES) {
+				mShadows.push_back({ id, state.resolution, state.faces });
+				mStats.cachedLights += state.dirtyFaces == 0 && std::none_of(mUpdates.begin(), mUpdates.end(), [id](const FaceUpdate& update) { return update.id == id; });
+			}
+		}
+
+		//lights which are not shadowed for a long time give their tiles back, forgotten lights are removed
+		for (auto it = mStates.begin(); it != mStates.end();) {
+			auto& state = it->second;
+			if (state.seenFrame + mSettings.evictFrames < mFrame) {
+				release(state);
+				it = mStates.erase(it);
+				continue;
+			}
+
+			if (state.resolution && state.shadowedFrame + mSettings.evictFrames < mFrame) {
+				release(state);
+			}
+			++it;
+		}
+
+		mStats.shadowedLights = shadowed.size();
+		mStats.readyLights = mShadows.size();
+		mStats.updatedFaces = mUpdates.size();
+		mStats.pendingFaces = candidates.size() - updatesCount;
+		mStats.usedTexels = mAtlas.getUsedTexels();
+		mStats.capacityTexels = mAtlas.getCapacityTexels();
+
+		return mUpdates;
+	}
+
+	uint32_t PointShadowScheduler::chooseResolution(const State& state, float screenSize) const {
+		const auto target = screenSize * mSettings.resolutionScale;
+		const auto resolution = std::clamp(std::bit_ceil(static_cast<uint32_t>(std::max(target, 1.f))), mSettings.minResolution, mSettings.maxResolution);
+
+		//smaller tiles are taken only when light is noticeably smaller than half of current one, so light on the border doesn't reallocate every frame
+		if (state.resolution && resolution < state.resolution && state.resolution <= mSettings.maxResolution && target > static_cast<float>(state.resolution) * 0.375f) {
+			return state.resolution;
+		}
+
+		return resolution;
+	}
+
+	bool PointShadowScheduler::allocate(State& state, uint32_t resolution, uint32_t id) {
+		std::array<ShadowAtlas::Tile, FACES> faces;
+		const auto tryAllocate = [this, &faces](uint32_t size) {
+			for (uint32_t face = 0; face < FACES; face++) {
+				faces[face] = mAtlas.allocate(size);
+				if (!faces[face].isValid()) {
+					for (uint32_t allocated = 0; allocated < face; allocated++) {
+						mAtlas.free(faces[allocated]);
+					}
+					return false;
+				}
+			}
+			return true;
+		};
+
+		auto size = resolution;
+		if (!tryAllocate(size)) {
+			//tiles of lights which are not shadowed now are freed from the longest unused
+			std::vector<std::pair<uint64_t, uint32_t>> unused;
+			for (const auto& [otherId, other] : mStates) {
+				if (otherId != id && other.resolution && other.shadowedFrame != mFrame) {
+					unused.emplace_back(other.shadowedFrame, otherId);
+				}
+			}
+			std::sort(unused.begin(), unused.end());
+
+			auto allocated = false;
+			for (const auto& [frame, otherId] : unused) {
+				release(mStates[otherId]);
+				if (tryAllocate(size)) {
+					allocated = true;
+					break;
+				}
+			}
+
+			//light with tiles keeps them, light without tiles takes smaller ones
+			while (!allocated && !state.resolution && size / 2 >= mSettings.minResolution) {
+				size /= 2;
+				allocated = tryAllocate(size);
+			}
+
+			if (!allocated) {
+				return false;
+			}
+		}
+
+		//old tiles are released only after new ones are taken, so light keeps its shadows when atlas is full
+		release(state);
+		state.faces = faces;
+		state.resolution = size;
+		state.dirtyFaces = ALL_FACES;
+		state.dirtyFrames = 0;
+		return true;
+	}
+
+	void PointShadowScheduler::release(State& state) {
+		for (auto& tile : state.faces) {
+			mAtlas.free(tile);
+			tile = {};
+		}
+		state.resolution = 0;
+		state.renderedFaces = 0;
+	}
+}
@@ -0,0 +1,119 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ShadowAtlas.h"
+#include "mathModule/Forward.h"
+
+namespace SFE::Render {
+	//decides which point lights get shadows, which atlas tiles their cube faces use and which faces are rendered this frame
+	//face resolution follows light size on screen, faces of lights without changes inside of their radius are kept from previous frames
+	//dirty faces are rendered in order of priority until faces budget is spent, point light pass renders returned faces
+	class PointShadowScheduler {
+	public:
+		constexpr static uint32_t FACES = 6;
+		constexpr static uint8_t ALL_FACES = (1 << FACES) - 1;
+
+		struct Settings {
+			uint32_t pageSize = 4096;
+			uint32_t pagesCount = 3;
+			uint32_t minResolution = 128;
+			uint32_t maxResolution = 1024;
+
+			uint32_t maxShadowedLights = 6;
+			uint32_t facesBudget = 12;
+			float resolutionScale = 1.f; //face resolution relative to light diameter on screen
+			uint32_t evictFrames = 300; //tiles of light which wasn't shadowed for this count of frames are freed
+
+			friend bool operator==(const Settings& lhs, const Settings& rhs) = default;
+		};
+
+		struct View {
+			Math::Vec3 position = {};
+			float projectionScale = 1.f; //projection[1][1]
+			float screenHeight = 1.f;
+		};
+
+		struct Light {
+			uint32_t id = 0;
+			Math::Vec3 position = {};
+			float radius = 0.f;
+			bool castersChanged = false; //some caster inside of radius was moved, added or removed
+		};
+
+		struct FaceUpdate {
+			uint32_t id = 0;
+			uint32_t face = 0;
+			ShadowAtlas::Tile tile;
+		};
+
+		//light which all faces are rendered
+		struct Shadow {
+			uint32_t id = 0;
+			uint32_t resolution = 0;
+			std::array<ShadowAtlas::Tile, FACES> faces;
+		};
+
+		struct Stats {
+			size_t lights = 0;
+			size_t shadowedLights = 0;
+			size_t readyLights = 0;
+			size_t cachedLights = 0; //shadowed lights without dirty faces
+			size_t updatedFaces = 0;
+			size_t pendingFaces = 0; //dirty faces left for next frames
+			size_t reallocations = 0;
+			uint64_t usedTexels = 0;
+			uint64_t capacityTexels = 0;
+		};
+
+		PointShadowScheduler();
+
+		//atlas is cleared when its size is changed
+		void setSettings(const Settings& settings);
+		const Settings& getSettings() const { return mSettings; }
+
+		//lights are all point lights which can be seen this frame, lights which are not passed are dirty when they come back
+		const std::vector<FaceUpdate>& update(const View& view, const std::vector<Light>& lights);
+
+		//sorted by importance, only they should be sampled
+		const std::vector<Shadow>& getShadows() const { return mShadows; }
+		const Stats& getStats() const { return mStats; }
+		const ShadowAtlas& getAtlas() const { return mAtlas; }
+		//light has state until it isn't seen for evictFrames
+		bool isKnown(uint32_t id) const { return mStates.contains(id); }
+
+		//light diameter on screen in pixels
+		static float getScreenSize(const View& view, const Math::Vec3& position, float radius);
+
+	private:
+		struct State {
+			std::array<ShadowAtlas::Tile, FACES> faces;
+			uint32_t resolution = 0;
+			Math::Vec3 position = {};
+			float radius = 0.f;
+			float importance = 0.f;
+
+			uint8_t dirtyFaces = 0;
+			uint8_t renderedFaces = 0; //faces which have content since tiles were allocated
+			uint32_t dirtyFrames = 0;
+			uint64_t seenFrame = 0;
+			uint64_t shadowedFrame = 0;
+		};
+
+		uint32_t chooseResolution(const State& state, float screenSize) const;
+		bool allocate(State& state, uint32_t resolution, uint32_t id);
+		void release(State& state);
+
+		Settings mSettings;
+		ShadowAtlas mAtlas;
+
+		std::unordered_map<uint32_t, State> mStates;
+		std::vector<FaceUpdate> mUpdates;
+		std::vector<Shadow> mShadows;
+		Stats mStats;
+
+		uint64_t mFrame = 0;
+	};
+}
@@ -0,0 +1,314 @@
+﻿#include "RenderGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+
+namespace SFE::Render {
+	namespace {
+		//storage writes are not coherent, so next access needs barrier of its own kind
+		uint32_t getBarrier(RenderGraph::ResourceType type, RenderGraph::Access access) {
+			if (type == RenderGraph::ResourceType::BUFFER) {
+				return access == RenderGraph::Access::INDIRECT ? RenderGraph::COMMAND_BARRIER : RenderGraph::STORAGE_BUFFER_BARRIER;
+			}
+
+			switch (access) {
+			case RenderGraph::Access::ATTACHMENT: return RenderGraph::FRAMEBUFFER_BARRIER;
+			case RenderGraph::Access::SAMPLED: return RenderGraph::TEXTURE_FETCH_BARRIER;
+			case RenderGraph::Access::STORAGE: return RenderGraph::IMAGE_ACCESS_BARRIER;
+			case RenderGraph::Access::INDIRECT: return RenderGraph::COMMAND_BARRIER;
+			}
+			return RenderGraph::NO_BARRIER;
+		}
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ResourceId resource, Access access) {
+		mGraph.addAccess(mPass, resource, access, false);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ResourceId resource, Access access) {
+		mGraph.addAccess(mPass, resource, access, true);
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffect() {
+		mGraph.mPasses[mPass].sideEffect = true;
+		mGraph.mCompiled = false;
+		return *this;
+	}
+
+	void RenderGraph::clear() {
+		mPasses.clear();
+		mResources.clear();
+		mOrder.clear();
+		mPhysicalTextures.clear();
+		mStats = {};
+		mError.clear();
+		mCompiled = false;
+	}
+
+	RenderGraph::ResourceId RenderGraph::createTexture(const std::string& name, const TextureDesc& desc) {
+		mCompiled = false;
+		auto& resource = mResources.emplace_back();
+		resource.name = name;
+		resource.desc = desc;
+		resource.transient = true;
+		return static_cast<ResourceId>(mResources.size() - 1);
+	}
+
+	RenderGraph::ResourceId RenderGraph::importResource(const std::string& name, ResourceType type, bool output) {
+		mCompiled = false;
+		const auto id = findResource(name);
+		if (id != INVALID_RESOURCE && !mResources[id].transient) {
+			mResources[id].output |= output;
+			return id;
+		}
+
+		auto& resource = mResources.emplace_back();
+		resource.name = name;
+		resource.type = type;
+		resource.output = output;
+		return static_cast<ResourceId>(mResources.size() - 1);
+	}
+
+	RenderGraph::ResourceId RenderGraph::findResource(const std::string& name) const {
+		const auto it = std::find_if(mResources.begin(), mResources.end(), [&name](const Resource& resource) { return resource.name == name; });
+		return it != mResources.end() ? static_cast<ResourceId>(it - mResources.begin()) : INVALID_RESOURCE;
+	}
+
+	RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name, std::function<void()> execute) {
+		mCompiled = false;
+		auto& pass = mPasses.emplace_back();
+		pass.name = name;
+		pass.execute = std::move(execute);
+		return PassBuilder(*this, static_cast<PassId>(mPasses.size() - 1));
+	}
+
+	void RenderGraph::addAccess(PassId pass, ResourceId resource, Access access, bool write) {
+		//resource of pass which wasn't added is skipped, so passes can be turned off
+		if (resource == INVALID_RESOURCE) {
+			return;
+		}
+		assert(resource < mResources.size());
+		if (resource >= mResources.size()) {
+			return;
+		}
+		mCompiled = false;
+		mPasses[pass].accesses.push_back({ resource, access, write });
+	}
+
+	bool RenderGraph::compile() {
+		mOrder.clear();
+		mPhysicalTextures.clear();
+		mStats = {};
+		mError.clear();
+		mCompiled = false;
+
+		buildDependencies();
+		cull();
+		if (!sort()) {
+			mOrder.clear();
+			return false;
+		}
+		alias();
+		findBarriers();
+
+		mStats.passes = mPasses.size();
+		mStats.culledPasses = mPasses.size() - mOrder.size();
+		mCompiled = true;
+		return true;
+	}
+
+	void RenderGraph::executePass(PassId pass) const {
+		if (mPasses[pass].execute) {
+			mPasses[pass].execute();
+		}
+	}
+
+	void RenderGraph::buildDependencies() {
+		std::vector<std::vector<PassId>> writers(mResources.size());
+		for (PassId pass = 0; pass < mPasses.size(); pass++) {
+			mPasses[pass].dependencies.clear();
+			mPasses[pass].culled = false;
+			for (const auto& access : mPasses[pass].accesses) {
+				auto& resourceWriters = writers[access.resource];
+				if (access.write && (resourceWriters.empty() || resourceWriters.back() != pass)) {
+					resourceWriters.push_back(pass);
+				}
+			}
+		}
+
+		const auto addDependency = [this](PassId pass, PassId dependency) {
+			auto& dependencies = mPasses[pass].dependencies;
+			if (pass != dependency && std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end()) {
+				dependencies.push_back(dependency);
+			}
+		};
+
+		//writer modifies result of the previous writer, pure reader sees result of the last one
+		for (const auto& resourceWriters : writers) {
+			for (size_t i = 1; i < resourceWriters.size(); i++) {
+				addDependency(resourceWriters[i], resourceWriters[i - 1]);
+			}
+		}
+
+		for (PassId pass = 0; pass < mPasses.size(); pass++) {
+			for (const auto& access : mPasses[pass].accesses) {
+				const auto& resourceWriters = writers[access.resource];
+				if (!access.write && !resourceWriters.empty() && std::find(resourceWriters.begin(), resourceWriters.end(), pass) == resourceWriters.end()) {
+					addDependency(pass, resourceWriters.back());
+				}
+			}
+		}
+	}
+
+	void RenderGraph::cull() {
+		std::vector<bool> alive(mPasses.size(), false);
+		std::vector<PassId> stack;
+		for (PassId pass = 0; pass < mPasses.size(); pass++) {
+			const auto& accesses = mPasses[pass].accesses;
+			const auto writesOutput = std::any_of(accesses.begin(), accesses.end(), [this](const ResourceAccess& access) {
+				return access.write && mResources[access.resource].output;
+			});
+			if (mPasses[pass].sideEffect || writesOutput) {
+				alive[pass] = true;
+				stack.push_back(pass);
+			}
+		}
+
+		while (!stack.empty()) {
+			const auto pass = stack.back();
+			stack.pop_back();
+			for (const auto dependency : mPasses[pass].dependencies) {
+				if (!alive[dependency]) {
+					alive[dependency] = true;
+					stack.push_back(dependency);
+				}
+			}
+		}
+
+		for (PassId pass = 0; pass < mPasses.size(); pass++) {
+			mPasses[pass].culled = !alive[pass];
+		}
+	}
+
+	bool RenderGraph::sort() {
+		std::vector<uint32_t> dependenciesLeft(mPasses.size(), 0);
+		std::vector<std::vector<PassId>> dependents(mPasses.size());
+		size_t aliveCount = 0;
+		for (PassId pass = 0; pass < mPasses.size(); pass++) {
+			if (mPasses[pass].culled) {
+				continue;
+			}
+			aliveCount++;
+			for (const auto dependency : mPasses[pass].dependencies) {
+				dependents[dependency].push_back(pass);
+				dependenciesLeft[pass]++;
+			}
+		}
+
+		//the earliest added pass is taken from ready ones, so independent passes keep their order
+		std::priority_queue<PassId, std::vector<PassId>, std::greater<>> ready;
+		for (PassId pass = 0; pass < mPasses.size(); pass++) {
+			if (!mPasses[pass].culled && dependenciesLeft[pass] == 0) {
+				ready.push(pass);
+			}
+		}
+
+		while (!ready.empty()) {
+			const auto pass = ready.top();
+			ready.pop();
+			mOrder.push_back({ pass, NO_BARRIER });
+			for (const auto dependent : dependents[pass]) {
+				if (--dependenciesLeft[dependent] == 0) {
+					ready.push(dependent);
+				}
+			}
+		}
+
+		if (mOrder.size() == aliveCount) {
+			return true;
+		}
+
+		mError = "RenderGraph::cycle between passes:";
+		for (PassId pass = 0; pass < mPasses.size(); pass++) {
+			if (!mPasses[pass].culled && dependenciesLeft[pass] != 0) {
+				mError += " " + mPasses[pass].name;
+			}
+		}
+		return false;
+	}
+
+	void RenderGraph::alias() {
+		constexpr auto NOT_USED = std::numeric_limits<uint32_t>::max();
+		std::vector<uint32_t> firstUse(mResources.size(), NOT_USED);
+		std::vector<uint32_t> lastUse(mResources.size(), 0);
+		for (uint32_t position = 0; position < mOrder.size(); position++) {
+			for (const auto& access : mPasses[mOrder[position].pass].accesses) {
+				firstUse[access.resource] = std::min(firstUse[access.resource], position);
+				lastUse[access.resource] = std::max(lastUse[access.resource], position);
+			}
+		}
+
+		std::vector<ResourceId> transients;
+		for (ResourceId resource = 0; resource < mResources.size(); resource++) {
+			mResources[resource].physical = INVALID_PHYSICAL;
+			if (mResources[resource].transient && firstUse[resource] != NOT_USED) {
+				transients.push_back(resource);
+			}
+		}
+		std::stable_sort(transients.begin(), transients.end(), [&firstUse](ResourceId lhs, ResourceId rhs) { return firstUse[lhs] < firstUse[rhs]; });
+
+		//texture takes physical texture of the same desc which was released before its first use
+		std::vector<uint32_t> physicalLastUse;
+		for (const auto resource : transients) {
+			auto& data = mResources[resource];
+			for (uint32_t physical = 0; physical < mPhysicalTextures.size(); physical++) {
+				if (mPhysicalTextures[physical] == data.desc && physicalLastUse[physical] < firstUse[resource]) {
+					data.physical = physical;
+					break;
+				}
+			}
+
+			if (data.physical == INVALID_PHYSICAL) {
+				data.physical = static_cast<uint32_t>(mPhysicalTextures.size());
+				mPhysicalTextures.push_back(data.desc);
+				physicalLastUse.push_back(0);
+				mStats.physicalBytes += data.desc.getBytes();
+			}
+			physicalLastUse[data.physical] = lastUse[resource];
+			mStats.transientBytes += data.desc.getBytes();
+		}
+
+		mStats.transientTextures = transients.size();
+		mStats.physicalTextures = mPhysicalTextures.size();
+	}
+
+	void RenderGraph::findBarriers() {
+		//aliased textures share state of their physical texture, so storage write of previous owner is waited too
+		const auto getKey = [this](ResourceId resource) {
+			const auto& data = mResources[resource];
+			return data.physical != INVALID_PHYSICAL ? data.physical : static_cast<uint32_t>(mPhysicalTextures.size()) + resource;
+		};
+
+		std::vector<bool> storageWritten(mPhysicalTextures.size() + mResources.size(), false);
+		for (auto& compiled : mOrder) {
+			const auto& accesses = mPasses[compiled.pass].accesses;
+			for (const auto& access : accesses) {
+				if (storageWritten[getKey(access.resource)]) {
+					compiled.barriers |= getBarrier(mResources[access.resource].type, access.access);
+				}
+			}
+
+			for (const auto& access : accesses) {
+				if (access.write) {
+					storageWritten[getKey(access.resource)] = access.access == Access::STORAGE;
+				}
+			}
+
+			mStats.barriers += compiled.barriers != NO_BARRIER;
+		}
+	}
+}
@@ -0,0 +1,159 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace SFE::Render {
+	//passes declare which virtual resources they read and write, compiler orders passes by these dependencies, culls passes which results are never used,
+	//gives transient textures with disjoint lifetimes the same physical texture and finds memory barriers between passes
+	//compiler works on declarations only, tests/RenderGraphTests.cpp checks it without context
+	class RenderGraph {
+	public:
+		using ResourceId = uint32_t;
+		using PassId = uint32_t;
+		constexpr static ResourceId INVALID_RESOURCE = std::numeric_limits<ResourceId>::max();
+		constexpr static uint32_t INVALID_PHYSICAL = std::numeric_limits<uint32_t>::max();
+
+		enum class ResourceType : uint8_t {
+			TEXTURE,
+			BUFFER,
+		};
+
+		enum class Access : uint8_t {
+			ATTACHMENT, //framebuffer attachment, blit
+			SAMPLED, //texture fetch, uniform or storage buffer read
+			STORAGE, //image load/store, storage buffer write
+			INDIRECT, //indirect draw or dispatch commands
+		};
+
+		//memory barriers which should be issued before pass, renderer translates them to api bits
+		enum Barrier : uint32_t {
+			NO_BARRIER = 0,
+			TEXTURE_FETCH_BARRIER = 1 << 0,
+			IMAGE_ACCESS_BARRIER = 1 << 1,
+			STORAGE_BUFFER_BARRIER = 1 << 2,
+			COMMAND_BARRIER = 1 << 3,
+			FRAMEBUFFER_BARRIER = 1 << 4,
+		};
+
+		//format is api value which graph only compares, textures with equal desc can share memory
+		struct TextureDesc {
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t format = 0;
+			uint32_t bytesPerTexel = 0;
+
+			uint64_t getBytes() const { return static_cast<uint64_t>(width) * height * bytesPerTexel; }
+
+			friend bool operator==(const TextureDesc& lhs, const TextureDesc& rhs) = default;
+		};
+
+		class PassBuilder {
+		public:
+			PassBuilder(RenderGraph& graph, PassId pass) : mGraph(graph), mPass(pass) {}
+
+			//INVALID_RESOURCE is ignored, so pass doesn't depend on optional passes
+			PassBuilder& read(ResourceId resource, Access access = Access::SAMPLED);
+			PassBuilder& write(ResourceId resource, Access access = Access::ATTACHMENT);
+			//pass is never culled, for passes which change something outside of graph
+			PassBuilder& sideEffect();
+
+			PassId getId() const { return mPass; }
+
+		private:
+			RenderGraph& mGraph;
+			PassId mPass;
+		};
+
+		struct CompiledPass {
+			PassId pass = 0;
+			uint32_t barriers = NO_BARRIER;
+		};
+
+		struct Stats {
+			size_t passes = 0;
+			size_t culledPasses = 0;
+			size_t transientTextures = 0;
+			size_t physicalTextures = 0;
+			size_t barriers = 0;
+			uint64_t transientBytes = 0; //memory which transient textures would take without aliasing
+			uint64_t physicalBytes = 0;
+		};
+
+		void clear();
+
+		//texture which lives only inside of frame, graph decides which physical texture it uses
+		ResourceId createTexture(const std::string& name, const TextureDesc& desc);
+		//resource owned outside of graph, the same name returns the same resource, output resources keep their writers alive
+		ResourceId importResource(const std::string& name, ResourceType type = ResourceType::TEXTURE, bool output = false);
+		ResourceId findResource(const std::string& name) const;
+
+		//passes which are equal by dependencies are executed in order of adding
+		PassBuilder addPass(const std::string& name, std::function<void()> execute);
+
+		//pure readers of resource go after all its writers, writers of the same resource keep order of adding, returns false on cycle
+		bool compile();
+		bool isCompiled() const { return mCompiled; }
+		const std::string& getError() const { return mError; }
+
+		const std::vector<CompiledPass>& getOrder() const { return mOrder; }
+		void executePass(PassId pass) const;
+
+		bool isCulled(PassId pass) const { return mPasses[pass].culled; }
+		const std::string& getPassName(PassId pass) const { return mPasses[pass].name; }
+		size_t getPassesCount() const { return mPasses.size(); }
+
+		const std::string& getResourceName(ResourceId resource) const { return mResources[resource].name; }
+		size_t getResourcesCount() const { return mResources.size(); }
+		bool isTransient(ResourceId resource) const { return mResources[resource].transient; }
+		const TextureDesc& getTextureDesc(ResourceId resource) const { return mResources[resource].desc; }
+		//index in physical textures, INVALID_PHYSICAL for imported resources and transients which nobody uses
+		uint32_t getPhysicalIndex(ResourceId resource) const { return mResources[resource].physical; }
+		const std::vector<TextureDesc>& getPhysicalTextures() const { return mPhysicalTextures; }
+
+		const Stats& getStats() const { return mStats; }
+
+	private:
+		struct ResourceAccess {
+			ResourceId resource = INVALID_RESOURCE;
+			Access access = Access::SAMPLED;
+			bool write = false;
+		};
+
+		struct Pass {
+			std::string name;
+			std::function<void()> execute;
+			std::vector<ResourceAccess> accesses;
+			std::vector<PassId> dependencies;
+			bool sideEffect = false;
+			bool culled = false;
+		};
+
+		struct Resource {
+			std::string name;
+			TextureDesc desc;
+			ResourceType type = ResourceType::TEXTURE;
+			bool transient = false;
+			bool output = false;
+			uint32_t physical = INVALID_PHYSICAL;
+		};
+
+		void addAccess(PassId pass, ResourceId resource, Access access, bool write);
+		void buildDependencies();
+		void cull();
+		bool sort();
+		void alias();
+		void findBarriers();
+
+		std::vector<Pass> mPasses;
+		std::vector<Resource> mResources;
+
+		std::vector<CompiledPass> mOrder;
+		std::vector<TextureDesc> mPhysicalTextures;
+		Stats mStats;
+		std::string mError;
+		bool mCompiled = false;
+	};
+}
@@ -0,0 +1,68 @@
+﻿#include "RenderGraphTextures.h"
+
+#include <cassert>
+
+namespace SFE::Render {
+	namespace {
+		uint32_t getBytesPerTexel(GLW::PixelFormat format) {
+			switch (format) {
+			case GLW::R8: return 1;
+			case GLW::R16F: case GLW::RG8: return 2;
+			case GLW::R32F: case GLW::RG16: case GLW::RG16F: case GLW::RGBA8: case GLW::RGB10_A2: case GLW::R11F_G11F_B10F: return 4;
+			case GLW::DEPTH_COMPONENT24: case GLW::DEPTH_COMPONENT32F: return 4;
+			case GLW::RG32F: case GLW::RGBA16F: return 8;
+			case GLW::RGBA32F: return 16;
+			default: assert(false && "RenderGraphTextures::unsupported format"); return 4;
+			}
+		}
+
+		//textures are never uploaded, so format and type only have to be valid for internal format
+		GLW::TextureFormat getTextureFormat(GLW::PixelFormat format) {
+			switch (format) {
+			case GLW::R8: case GLW::R16F: case GLW::R32F: return GLW::RED;
+			case GLW::RG8: case GLW::RG16: case GLW::RG16F: case GLW::RG32F: return GLW::RG;
+			case GLW::R11F_G11F_B10F: return GLW::RGB;
+			case GLW::DEPTH_COMPONENT24: case GLW::DEPTH_COMPONENT32F: return GLW::DEPTH_COMPONENT;
+			default: return GLW::RGBA;
+			}
+		}
+	}
+
+	RenderGraph::TextureDesc RenderGraphTextures::makeDesc(uint32_t width, uint32_t height, GLW::PixelFormat format) {
+		return { width, height, static_cast<uint32_t>(format), getBytesPerTexel(format) };
+	}
+
+	void RenderGraphTextures::create(const RenderGraph& graph) {
+		clear();
+
+		for (const auto& desc : graph.getPhysicalTextures()) {
+			const auto format = static_cast<GLW::PixelFormat>(desc.format);
+			auto& texture = mTextures.emplace_back(std::make_unique<GLW::Texture>(GLW::TEXTURE_2D));
+			texture->width = static_cast<int>(desc.width);
+			texture->height = static_cast<int>(desc.height);
+			texture->parameters.minFilter = GLW::TextureMinFilter::NEAREST;
+			texture->parameters.magFilter = GLW::TextureMagFilter::NEAREST;
+			texture->pixelFormat = format;
+			texture->textureFormat = getTextureFormat(format);
+			texture->pixelType = GLW::FLOAT;
+			texture->create();
+		}
+
+		mPhysicalIndices.resize(graph.getResourcesCount());
+		for (RenderGraph::ResourceId resource = 0; resource < graph.getResourcesCount(); resource++) {
+			mPhysicalIndices[resource] = graph.getPhysicalIndex(resource);
+		}
+	}
+
+	void RenderGraphTextures::clear() {
+		mTextures.clear();
+		mPhysicalIndices.clear();
+	}
+
+	GLW::Texture* RenderGraphTextures::get(RenderGraph::ResourceId resource) const {
+		if (resource >= mPhysicalIndices.size() || mPhysicalIndices[resource] == RenderGraph::INVALID_PHYSICAL) {
+			return nullptr;
+		}
+		return mTextures[mPhysicalIndices[resource]].get();
+	}
+}
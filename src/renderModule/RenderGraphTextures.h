@@ -0,0 +1,28 @@
+﻿#pragma once
+#include <memory>
+#include <vector>
+
+#include "RenderGraph.h"
+#include "glWrapper/Texture.h"
+
+namespace SFE::Render {
+	//gl textures of compiled render graph, transient textures which share physical index share one texture
+	class RenderGraphTextures {
+	public:
+		//format of desc is GLW::PixelFormat
+		static RenderGraph::TextureDesc makeDesc(uint32_t width, uint32_t height, GLW::PixelFormat format);
+
+		//previous textures are deleted, so passes should take them again
+		void create(const RenderGraph& graph);
+		void clear();
+
+		//nullptr for imported and unused resources
+		GLW::Texture* get(RenderGraph::ResourceId resource) const;
+
+		size_t getTexturesCount() const { return mTextures.size(); }
+
+	private:
+		std::vector<std::unique_ptr<GLW::Texture>> mTextures;
+		std::vector<uint32_t> mPhysicalIndices; //of every graph resource
+	};
+}
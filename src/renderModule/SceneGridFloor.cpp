@@ -65,8 +65,6 @@ void SceneGridFloor::draw() {
 
 	floorShader->use();
 	auto& renderData = ECSHandler::getSystem<SFE::SystemsModule::RenderSystem>()->getRenderData();
-	auto camera = ECSHandler::getSystem<SFE::SystemsModule::CameraSystem>()->getCurrentCamera();
-	auto cameraComp = ECSHandler::registry().getComponent<CameraComponent>(camera);
 
 	floorShader->setUniform("PVM", renderData.current.PV * transform);
     floorShader->setUniform("PV", renderData.current.PV);
@@ -74,8 +72,8 @@ void SceneGridFloor::draw() {
 	
 	floorShader->setUniform("cameraPos", Math::Vec3{renderData.mCameraPos});
 
-	floorShader->setUniform("far", cameraComp->getProjection().getFar());
-	floorShader->setUniform("near", cameraComp->getProjection().getNear());
+	floorShader->setUniform("far", renderData.cameraProjection.getFar());
+	floorShader->setUniform("near", renderData.cameraProjection.getNear());
 
 
 	VAO.bind();
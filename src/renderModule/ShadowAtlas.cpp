@@ -0,0 +1,115 @@
+﻿#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <utility>
+
+namespace SFE::Render {
+	void ShadowAtlas::reset(uint32_t pageSize, uint32_t pagesCount, uint32_t minTileSize) {
+		assert(std::has_single_bit(pageSize) || pageSize == 0);
+		mPageSize = pageSize;
+		mPagesCount = pageSize ? pagesCount : 0;
+		mMinTileSize = std::clamp(std::bit_ceil(std::max(minTileSize, 1u)), 1u, std::max(pageSize, 1u));
+		mTilesCount = 0;
+		mUsedTexels = 0;
+
+		mFree.clear();
+		mFree.resize(getLevel(mMinTileSize) + 1);
+		for (uint32_t page = 0; page < mPagesCount; page++) {
+			mFree[0].insert(makeKey(page, 0, 0));
+		}
+	}
+
+	ShadowAtlas::Tile ShadowAtlas::allocate(uint32_t size) {
+		size = std::max(std::bit_ceil(std::max(size, 1u)), mMinTileSize);
+		if (size > mPageSize) {
+			return {};
+		}
+
+		//the smallest free tile which fits is split until it has requested size
+		const auto level = getLevel(size);
+		for (auto freeLevel = static_cast<int>(level); freeLevel >= 0; freeLevel--) {
+			auto& freeTiles = mFree[freeLevel];
+			if (freeTiles.empty()) {
+				continue;
+			}
+
+			auto tile = fromKey(*freeTiles.begin(), mPageSize >> freeLevel);
+			freeTiles.erase(freeTiles.begin());
+
+			for (auto splitLevel = static_cast<uint32_t>(freeLevel) + 1; splitLevel <= level; splitLevel++) {
+				tile.size /= 2;
+				mFree[splitLevel].insert(makeKey(tile.page, tile.x + tile.size, tile.y));
+				mFree[splitLevel].insert(makeKey(tile.page, tile.x, tile.y + tile.size));
+				mFree[splitLevel].insert(makeKey(tile.page, tile.x + tile.size, tile.y + tile.size));
+			}
+
+			mTilesCount++;
+			mUsedTexels += static_cast<uint64_t>(size) * size;
+			return tile;
+		}
+
+		return {};
+	}
+
+	void ShadowAtlas::free(const Tile& tile) {
+		if (!tile.isValid()) {
+			return;
+		}
+
+		assert(mTilesCount > 0);
+		mTilesCount--;
+		mUsedTexels -= static_cast<uint64_t>(tile.size) * tile.size;
+
+		auto x = tile.x;
+		auto y = tile.y;
+		auto size = tile.size;
+		auto level = getLevel(size);
+		while (level > 0) {
+			const auto parentX = x & ~(size * 2 - 1);
+			const auto parentY = y & ~(size * 2 - 1);
+
+			auto& freeTiles = mFree[level];
+			const auto isFreeOrSelf = [&](uint32_t siblingX, uint32_t siblingY) {
+				return (siblingX == x && siblingY == y) || freeTiles.contains(makeKey(tile.page, siblingX, siblingY));
+			};
+			if (!isFreeOrSelf(parentX, parentY) || !isFreeOrSelf(parentX + size, parentY) || !isFreeOrSelf(parentX, parentY + size) || !isFreeOrSelf(parentX + size, parentY + size)) {
+				break;
+			}
+
+			const std::pair<uint32_t, uint32_t> siblings[] = { { parentX, parentY }, { parentX + size, parentY }, { parentX, parentY + size }, { parentX + size, parentY + size } };
+			for (const auto& [siblingX, siblingY] : siblings) {
+				freeTiles.erase(makeKey(tile.page, siblingX, siblingY));
+			}
+
+			x = parentX;
+			y = parentY;
+			size *= 2;
+			level--;
+		}
+
+		mFree[level].insert(makeKey(tile.page, x, y));
+	}
+
+	uint32_t ShadowAtlas::getLargestFreeTile() const {
+		for (uint32_t level = 0; level < mFree.size(); level++) {
+			if (!mFree[level].empty()) {
+				return mPageSize >> level;
+			}
+		}
+		return 0;
+	}
+
+	uint32_t ShadowAtlas::getLevel(uint32_t size) const {
+		return mPageSize && size ? static_cast<uint32_t>(std::countr_zero(mPageSize) - std::countr_zero(size)) : 0;
+	}
+
+	uint64_t ShadowAtlas::makeKey(uint32_t page, uint32_t x, uint32_t y) {
+		return static_cast<uint64_t>(page) << 48 | static_cast<uint64_t>(y) << 24 | x;
+	}
+
+	ShadowAtlas::Tile ShadowAtlas::fromKey(uint64_t key, uint32_t size) {
+		return { static_cast<uint32_t>(key >> 48), static_cast<uint32_t>(key & 0xFFFFFF), static_cast<uint32_t>(key >> 24 & 0xFFFFFF), size };
+	}
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace SFE::Render {
+	//square shadow map tiles packed into pages of array texture, page is split as quadtree, so every tile size is power of two
+	//free tile is merged back with its three neighbours when all of them are free
+	//only tile bookkeeping lives here, tests/ShadowAtlasTests.cpp checks split and merge
+	class ShadowAtlas {
+	public:
+		struct Tile {
+			uint32_t page = 0;
+			uint32_t x = 0;
+			uint32_t y = 0;
+			uint32_t size = 0;
+
+			bool isValid() const { return size != 0; }
+
+			friend bool operator==(const Tile& lhs, const Tile& rhs) = default;
+		};
+
+		ShadowAtlas(uint32_t pageSize = 0, uint32_t pagesCount = 0, uint32_t minTileSize = 1) {
+			reset(pageSize, pagesCount, minTileSize);
+		}
+
+		//sizes should be power of two, all tiles are freed
+		void reset(uint32_t pageSize, uint32_t pagesCount, uint32_t minTileSize);
+
+		//size is rounded up to power of two and min tile size, returns invalid tile when there is no free space
+		Tile allocate(uint32_t size);
+		void free(const Tile& tile);
+
+		uint32_t getPageSize() const { return mPageSize; }
+		uint32_t getPagesCount() const { return mPagesCount; }
+		uint32_t getMinTileSize() const { return mMinTileSize; }
+
+		size_t getTilesCount() const { return mTilesCount; }
+		uint64_t getUsedTexels() const { return mUsedTexels; }
+		uint64_t getCapacityTexels() const { return static_cast<uint64_t>(mPageSize) * mPageSize * mPagesCount; }
+		//size of the biggest tile which can be allocated now
+		uint32_t getLargestFreeTile() const;
+
+	private:
+		//level 0 is the whole page, every next level has tiles twice smaller
+		uint32_t getLevel(uint32_t size) const;
+		static uint64_t makeKey(uint32_t page, uint32_t x, uint32_t y);
+		static Tile fromKey(uint64_t key, uint32_t size);
+
+		uint32_t mPageSize = 0;
+		uint32_t mPagesCount = 0;
+		uint32_t mMinTileSize = 1;
+
+		//free tiles of every level sorted by page and position, so tiles are taken from the first pages
+		std::vector<std::set<uint64_t>> mFree;
+
+		size_t mTilesCount = 0;
+		uint64_t mUsedTexels = 0;
+	};
+}
@@ -1,8 +1,6 @@
 ﻿#include "Skybox.h"
 
 #include "assetsModule/TextureHandler.h"
-#include "componentsModule/CameraComponent.h"
-#include "componentsModule/TransformComponent.h"
 #include "core/Engine.h"
 #include "assetsModule/modelModule/Mesh.h"
 #include "assetsModule/shaderModule/ShaderController.h"
@@ -10,7 +8,7 @@
 #include "ecss/Registry.h"
 #include "glWrapper/Depth.h"
 #include "glWrapper/Draw.h"
-#include "systemsModule/systems/CameraSystem.h"
+#include "systemsModule/systems/RenderSystem.h"
 #include "systemsModule/SystemManager.h"
 
 using namespace SFE::Render;
@@ -34,7 +32,6 @@ void Skybox::init() {
 
 	skyboxShader->use();
 	skyboxShader->setUniform("skybox", 16);
-	skyboxShader->setUniform("projection", ECSHandler::registry().getComponent<CameraComponent>(ECSHandler::getSystem<SFE::SystemsModule::CameraSystem>()->getCurrentCamera())->getProjection().getProjectionsMatrix());
 
 	cubemapTex = AssetsModule::TextureHandler::instance()->loadCubemapTexture(skyboxPath)->texture.mId;
 	if (cubemapTex == 0) {
@@ -102,8 +99,10 @@ void Skybox::draw() {
 	}
 	skyboxShader->use();
 
-	auto view = ECSHandler::registry().getComponent<TransformComponent>(ECSHandler::getSystem<SFE::SystemsModule::CameraSystem>()->getCurrentCamera())->getViewMatrix();;
-	skyboxShader->setUniform("view", Math::Mat4(Math::Mat3{view}));
+	//camera of the frame comes from render data, projection can be changed by simulation at any frame
+	const auto& camera = ECSHandler::getSystem<SFE::SystemsModule::RenderSystem>()->getRenderData().current;
+	skyboxShader->setUniform("projection", camera.projection);
+	skyboxShader->setUniform("view", Math::Mat4(Math::Mat3{camera.view}));
 	GLW::DepthFuncStack::push(GLW::DepthFunc::LEQUAL);
 
 	GLW::bindTextureToSlot(16, GLW::TEXTURE_CUBE_MAP, cubemapTex);
@@ -0,0 +1,313 @@
+﻿#include "SoftwareOcclusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "mathModule/Float4.h"
+
+namespace SFE::Render {
+	namespace {
+		//vertices behind this w are treated as crossing near plane
+		constexpr float MIN_W = 1e-4f;
+
+		//screen coordinate to pixel index, far off screen values are clamped before cast to not overflow int
+		int toPixel(float value, int size) {
+			return static_cast<int>(std::floor(std::clamp(value, -1.f, static_cast<float>(size))));
+		}
+
+		//box corners, bit 0 - x, bit 1 - y, bit 2 - z
+		void getCorners(const FrustumModule::AABB& aabb, Math::Vec4 (&corners)[8]) {
+			for (int i = 0; i < 8; i++) {
+				corners[i] = Math::Vec4(
+					aabb.center.x + (i & 1 ? aabb.extents.x : -aabb.extents.x),
+					aabb.center.y + (i & 2 ? aabb.extents.y : -aabb.extents.y),
+					aabb.center.z + (i & 4 ? aabb.extents.z : -aabb.extents.z),
+					1.f
+				);
+			}
+		}
+
+		constexpr int BOX_TRIANGLES[12][3] = {
+			{0, 1, 3}, {0, 3, 2}, //-z
+			{4, 7, 5}, {4, 6, 7}, //+z
+			{0, 2, 6}, {0, 6, 4}, //-x
+			{1, 5, 7}, {1, 7, 3}, //+x
+			{0, 4, 5}, {0, 5, 1}, //-y
+			{2, 3, 7}, {2, 7, 6}, //+y
+		};
+	}
+
+	SoftwareOcclusion::SoftwareOcclusion(int width, int height) {
+		resize(width, height);
+	}
+
+	void SoftwareOcclusion::resize(int width, int height) {
+		mTilesX = std::max((width + TILE_WIDTH - 1) / TILE_WIDTH, 1);
+		mTilesY = std::max((height + TILE_HEIGHT - 1) / TILE_HEIGHT, 1);
+		mWidth = mTilesX * TILE_WIDTH;
+		mHeight = mTilesY * TILE_HEIGHT;
+
+		mTileBins.clear();
+		mTileBins.resize(static_cast<size_t>(mTilesX * mTilesY));
+
+		mHiZ.clear();
+		int levelWidth = mWidth;
+		int levelHeight = mHeight;
+		while (true) {
+			auto& level = mHiZ.emplace_back();
+			level.width = levelWidth;
+			level.height = levelHeight;
+			level.depth.assign(static_cast<size_t>(levelWidth * levelHeight), 1.f);
+
+			if (levelWidth == 1 && levelHeight == 1) {
+				break;
+			}
+			levelWidth = std::max((levelWidth + 1) / 2, 1);
+			levelHeight = std::max((levelHeight + 1) / 2, 1);
+		}
+	}
+
+	void SoftwareOcclusion::beginFrame(const Math::Mat4& viewProjection) {
+		mViewProjection = viewProjection;
+		mTriangles.clear();
+		for (auto& bin : mTileBins) {
+			bin.clear();
+		}
+	}
+
+	void SoftwareOcclusion::addOccluder(const FrustumModule::AABB& aabb) {
+		Math::Vec4 corners[8];
+		getCorners(aabb, corners);
+		for (auto& corner : corners) {
+			corner = mViewProjection * corner;
+		}
+
+		for (const auto& triangle : BOX_TRIANGLES) {
+			addTriangle(corners[triangle[0]], corners[triangle[1]], corners[triangle[2]]);
+		}
+	}
+
+	void SoftwareOcclusion::addTriangle(const Math::Vec4& a, const Math::Vec4& b, const Math::Vec4& c) {
+		//no clipping, triangle which crosses near plane just doesn't occlude anything
+		if (a.w < MIN_W || b.w < MIN_W || c.w < MIN_W) {
+			return;
+		}
+
+		ScreenTriangle triangle;
+		const Math::Vec4* vertices[3] = { &a, &b, &c };
+		for (int i = 0; i < 3; i++) {
+			const auto& v = *vertices[i];
+			const float invW = 1.f / v.w;
+			triangle.x[i] = (v.x * invW * 0.5f + 0.5f) * static_cast<float>(mWidth);
+			triangle.y[i] = (v.y * invW * 0.5f + 0.5f) * static_cast<float>(mHeight);
+			triangle.z[i] = v.z * invW * 0.5f + 0.5f;
+		}
+
+		//far plane clipping is skipped too, depth beyond it is clamped so it can't hide anything wrongly
+		for (auto& z : triangle.z) {
+			z = std::min(z, 1.f);
+		}
+
+		mTriangles.push_back(triangle);
+	}
+
+	void SoftwareOcclusion::binTriangles() {
+		for (uint32_t i = 0; i < mTriangles.size(); i++) {
+			const auto& triangle = mTriangles[i];
+			const float minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+			const float maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+			const float minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+			const float maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+
+			if (maxX < 0.f || maxY < 0.f || minX >= static_cast<float>(mWidth) || minY >= static_cast<float>(mHeight)) {
+				continue;
+			}
+
+			const int tileX0 = std::clamp(toPixel(minX, mWidth) / TILE_WIDTH, 0, mTilesX - 1);
+			const int tileX1 = std::clamp(toPixel(maxX, mWidth) / TILE_WIDTH, 0, mTilesX - 1);
+			const int tileY0 = std::clamp(toPixel(minY, mHeight) / TILE_HEIGHT, 0, mTilesY - 1);
+			const int tileY1 = std::clamp(toPixel(maxY, mHeight) / TILE_HEIGHT, 0, mTilesY - 1);
+
+			for (int y = tileY0; y <= tileY1; y++) {
+				for (int x = tileX0; x <= tileX1; x++) {
+					mTileBins[static_cast<size_t>(y * mTilesX + x)].push_back(i);
+				}
+			}
+		}
+	}
+
+	void SoftwareOcclusion::rasterizeTile(size_t tile) {
+		auto& depth = mHiZ[0].depth;
+
+		const int tileX = static_cast<int>(tile) % mTilesX * TILE_WIDTH;
+		const int tileY = static_cast<int>(tile) / mTilesX * TILE_HEIGHT;
+
+		for (int y = tileY; y < tileY + TILE_HEIGHT; y++) {
+			std::fill_n(depth.begin() + y * mWidth + tileX, TILE_WIDTH, 1.f);
+		}
+
+		for (const auto triangleIdx : mTileBins[tile]) {
+			auto triangle = mTriangles[triangleIdx];
+
+			auto area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+			if (std::abs(area) < 1e-8f) {
+				continue;
+			}
+			//both windings are rasterized, inner faces of a box occlude the same as outer
+			if (area < 0.f) {
+				std::swap(triangle.x[1], triangle.x[2]);
+				std::swap(triangle.y[1], triangle.y[2]);
+				std::swap(triangle.z[1], triangle.z[2]);
+				area = -area;
+			}
+
+			const int minX = std::max(toPixel(std::min({ triangle.x[0], triangle.x[1], triangle.x[2] }), mWidth), tileX);
+			const int maxX = std::min(toPixel(std::max({ triangle.x[0], triangle.x[1], triangle.x[2] }), mWidth), tileX + TILE_WIDTH - 1);
+			const int minY = std::max(toPixel(std::min({ triangle.y[0], triangle.y[1], triangle.y[2] }), mHeight), tileY);
+			const int maxY = std::min(toPixel(std::max({ triangle.y[0], triangle.y[1], triangle.y[2] }), mHeight), tileY + TILE_HEIGHT - 1);
+			if (minX > maxX || minY > maxY) {
+				continue;
+			}
+
+			//edge(x, y) = A * x + B * y + C, it is >= 0 inside
+			float edgeA[3], edgeB[3], edgeC[3];
+			for (int i = 0; i < 3; i++) {
+				const int a = (i + 1) % 3;
+				const int b = (i + 2) % 3;
+				edgeA[i] = triangle.y[a] - triangle.y[b];
+				edgeB[i] = triangle.x[b] - triangle.x[a];
+				edgeC[i] = triangle.x[a] * triangle.y[b] - triangle.y[a] * triangle.x[b];
+			}
+
+			//depth plane from barycentrics, edge i is the weight of vertex i
+			const float invArea = 1.f / area;
+			const float zA = (edgeA[0] * triangle.z[0] + edgeA[1] * triangle.z[1] + edgeA[2] * triangle.z[2]) * invArea;
+			const float zB = (edgeB[0] * triangle.z[0] + edgeB[1] * triangle.z[1] + edgeB[2] * triangle.z[2]) * invArea;
+			const float zC = (edgeC[0] * triangle.z[0] + edgeC[1] * triangle.z[1] + edgeC[2] * triangle.z[2]) * invArea;
+
+			//4 pixels aligned to tile, pixel centers are sampled
+			const int startX = tileX + (minX - tileX) / 4 * 4;
+			using Math::Float4;
+			const auto offsets = Float4::set(0.5f, 1.5f, 2.5f, 3.5f);
+			const auto zero = Float4::zero();
+
+			for (int y = minY; y <= maxY; y++) {
+				const float centerY = static_cast<float>(y) + 0.5f;
+				float* row = depth.data() + y * mWidth;
+
+				for (int x = startX; x <= maxX; x += 4) {
+					const auto px = Float4::set(static_cast<float>(x)) + offsets;
+
+					const auto e0 = Float4::set(edgeA[0]) * px + Float4::set(edgeB[0] * centerY + edgeC[0]);
+					const auto e1 = Float4::set(edgeA[1]) * px + Float4::set(edgeB[1] * centerY + edgeC[1]);
+					const auto e2 = Float4::set(edgeA[2]) * px + Float4::set(edgeB[2] * centerY + edgeC[2]);
+					const auto z = Float4::set(zA) * px + Float4::set(zB * centerY + zC);
+
+					const auto current = Float4::load(row + x);
+					//keeps pixels where all three edges are not negative
+					select((e0 >= zero) & (e1 >= zero) & (e2 >= zero), min(current, z), current).store(row + x);
+				}
+			}
+		}
+	}
+
+	void SoftwareOcclusion::buildHiZ(const ParallelFor& parallelFor) {
+		for (size_t levelIdx = 1; levelIdx < mHiZ.size(); levelIdx++) {
+			const auto& src = mHiZ[levelIdx - 1];
+			auto& dst = mHiZ[levelIdx];
+
+			const auto reduceRow = [&src, &dst](size_t y) {
+				const int srcY0 = static_cast<int>(y) * 2;
+				const int srcY1 = std::min(srcY0 + 1, src.height - 1);
+				for (int x = 0; x < dst.width; x++) {
+					const int srcX0 = x * 2;
+					const int srcX1 = std::min(srcX0 + 1, src.width - 1);
+					dst.depth[y * dst.width + x] = std::max({
+						src.depth[srcY0 * src.width + srcX0], src.depth[srcY0 * src.width + srcX1],
+						src.depth[srcY1 * src.width + srcX0], src.depth[srcY1 * src.width + srcX1]
+					});
+				}
+			};
+
+			//small levels are not worth task overhead
+			if (parallelFor && dst.width * dst.height >= 4096) {
+				parallelFor(static_cast<size_t>(dst.height), reduceRow);
+			}
+			else {
+				for (size_t y = 0; y < static_cast<size_t>(dst.height); y++) {
+					reduceRow(y);
+				}
+			}
+		}
+	}
+
+	void SoftwareOcclusion::rasterize(const ParallelFor& parallelFor) {
+		binTriangles();
+
+		const auto tiles = mTileBins.size();
+		if (parallelFor) {
+			parallelFor(tiles, [this](size_t tile) { rasterizeTile(tile); });
+		}
+		else {
+			for (size_t tile = 0; tile < tiles; tile++) {
+				rasterizeTile(tile);
+			}
+		}
+
+		buildHiZ(parallelFor);
+	}
+
+	bool SoftwareOcclusion::isOccluded(const FrustumModule::AABB& aabb) const {
+		Math::Vec4 corners[8];
+		getCorners(aabb, corners);
+
+		float minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max(), minZ = std::numeric_limits<float>::max();
+		float maxX = std::numeric_limits<float>::lowest(), maxY = std::numeric_limits<float>::lowest();
+		for (auto& corner : corners) {
+			const auto clip = mViewProjection * corner;
+			if (clip.w < MIN_W) {
+				return false;
+			}
+
+			const float invW = 1.f / clip.w;
+			const float x = (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(mWidth);
+			const float y = (clip.y * invW * 0.5f + 0.5f) * static_cast<float>(mHeight);
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minZ = std::min(minZ, clip.z * invW * 0.5f + 0.5f);
+		}
+
+		if (maxX < 0.f || maxY < 0.f || minX >= static_cast<float>(mWidth) || minY >= static_cast<float>(mHeight)) {
+			return false;
+		}
+
+		int x0 = std::clamp(toPixel(minX, mWidth), 0, mWidth - 1);
+		int x1 = std::clamp(toPixel(maxX, mWidth), 0, mWidth - 1);
+		int y0 = std::clamp(toPixel(minY, mHeight), 0, mHeight - 1);
+		int y1 = std::clamp(toPixel(maxY, mHeight), 0, mHeight - 1);
+
+		//the lowest level where the rect is not more than 4x4 texels
+		size_t levelIdx = 0;
+		while (levelIdx + 1 < mHiZ.size() && (x1 - x0 >= 4 || y1 - y0 >= 4)) {
+			x0 >>= 1;
+			x1 >>= 1;
+			y0 >>= 1;
+			y1 >>= 1;
+			levelIdx++;
+		}
+
+		const auto& level = mHiZ[levelIdx];
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				if (level.depth[y * level.width + x] >= minZ) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "assetsModule/modelModule/BoundingVolume.h"
+#include "mathModule/Forward.h"
+
+namespace SFE::Render {
+	//cpu occlusion culling, occluders are rasterized into small depth buffer and occludees are tested against max depth pyramid (hi-z) of it
+	//results are ready in the same frame, tests/SoftwareOcclusionTests.cpp covers rasterization and hi-z queries
+	//depth is in [0, 1] range, 1 - far plane, buffer stores the nearest occluder depth per pixel
+	class SoftwareOcclusion {
+	public:
+		//should call task(i) for every i in [0, count), it is allowed to do it from different threads
+		using ParallelFor = std::function<void(size_t count, const std::function<void(size_t)>& task)>;
+
+		constexpr static int TILE_WIDTH = 32;
+		constexpr static int TILE_HEIGHT = 16;
+
+		SoftwareOcclusion(int width = 256, int height = 144);
+
+		//size is rounded up to tiles
+		void resize(int width, int height);
+
+		//clears depth and occluders list
+		void beginFrame(const Math::Mat4& viewProjection);
+		void addOccluder(const FrustumModule::AABB& aabb);
+		//rasterizes all occluders tile by tile and builds hi-z, without parallelFor everything is done on calling thread
+		void rasterize(const ParallelFor& parallelFor = {});
+
+		//true only when aabb is hidden for sure, boxes which cross near plane or are out of screen are never occluded
+		bool isOccluded(const FrustumModule::AABB& aabb) const;
+
+		int getWidth() const { return mWidth; }
+		int getHeight() const { return mHeight; }
+		const std::vector<float>& getDepth() const { return mHiZ[0].depth; }
+
+		size_t getHiZLevelsCount() const { return mHiZ.size(); }
+		const std::vector<float>& getHiZ(size_t level) const { return mHiZ[level].depth; }
+
+		size_t getTrianglesCount() const { return mTriangles.size(); }
+
+	private:
+		struct ScreenTriangle {
+			float x[3];
+			float y[3];
+			float z[3];
+		};
+
+		struct HiZLevel {
+			int width = 0;
+			int height = 0;
+			std::vector<float> depth;
+		};
+
+		void addTriangle(const Math::Vec4& a, const Math::Vec4& b, const Math::Vec4& c);
+		void binTriangles();
+		void rasterizeTile(size_t tile);
+		void buildHiZ(const ParallelFor& parallelFor);
+
+		int mWidth = 0;
+		int mHeight = 0;
+		int mTilesX = 0;
+		int mTilesY = 0;
+
+		Math::Mat4 mViewProjection = {};
+
+		std::vector<ScreenTriangle> mTriangles;
+		std::vector<std::vector<uint32_t>> mTileBins;
+		std::vector<HiZLevel> mHiZ; //level 0 is full resolution depth
+	};
+}
@@ -60,13 +60,13 @@ namespace SFE::Render {
         void load(std::string_view path, uint16_t fontSize = 16) {
             FT_Library ft;
             if (FT_Init_FreeType(&ft)) {
-                LogsModule::Logger::LOG_FATAL(false, "FREETYPE: Could not init FreeType Library");
+                SFE_LOG_FATAL(false, "FREETYPE: Could not init FreeType Library");
                 return;
             }
 
             FT_Face face;
             if (FT_New_Face(ft, path.data(), 0, &face)) {
-                LogsModule::Logger::LOG_FATAL(false, "FREETYPE: Failed to load font %s", path.data());
+                SFE_LOG_FATAL(false, "FREETYPE: Failed to load font %s", path.data());
                 return;
             }
 
@@ -347,7 +347,7 @@ namespace SFE::Render {
 
             GLW::CapabilitiesStack<GLW::BLEND>::push(true);
             GLW::BlendFuncStack::push({ GLW::SRC_ALPHA, GLW::ONE_MINUS_SRC_ALPHA });
-            const auto shader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/text.vs", "shaders/text.fs");
+            const auto shader = mShader;
             shader->use();
             shader->setUniform("textColor", color);
             shader->setUniform("text", 24);
@@ -361,7 +361,8 @@ namespace SFE::Render {
         }
 
         void init() override {
-            const auto shader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/text.vs", "shaders/text.fs");
+            mShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/text.vs", "shaders/text.fs");
+            const auto shader = mShader;
             shader->use();
             shader->setUniform("projection", Math::orthoRH_NO(0.0f, static_cast<float>(Engine::instance()->getWindow()->getScreenData().width), 0.f, static_cast<float>(Engine::instance()->getWindow()->getScreenData().height), -1.f, 1.f));
 
@@ -392,5 +393,6 @@ namespace SFE::Render {
         GLW::VertexArray VAO;
 
         GLW::Buffer<GLW::ARRAY_BUFFER, GlyphVertex, GLW::DYNAMIC_DRAW> VBO;
+        ShaderModule::ShaderBase* mShader = nullptr;
 	};
 }
@@ -0,0 +1,196 @@
+﻿#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace SFE::Render {
+	namespace {
+		//camera inside of bounds sees mesh as close as near plane
+		constexpr float MIN_DISTANCE = 0.01f;
+		constexpr float MIN_TEXELS_PER_PIXEL = 1e-6f;
+	}
+
+	void TextureResidency::addTexture(uint32_t id, TextureDesc desc, uint32_t residentLevel) {
+		if (desc.levelBytes.empty()) {
+			return;
+		}
+
+		auto& state = mStates[id];
+		state = {};
+		desc.lockedLevel = std::min(desc.lockedLevel, static_cast<uint32_t>(desc.levelBytes.size() - 1));
+		state.resident = std::min(residentLevel, desc.lockedLevel);
+		state.target = state.resident;
+		state.desc = std::move(desc);
+	}
+
+	void TextureResidency::removeTexture(uint32_t id) {
+		mStates.erase(id);
+	}
+
+	void TextureResidency::setBusy(uint32_t id, bool busy) {
+		if (const auto it = mStates.find(id); it != mStates.end()) {
+			it->second.busy = busy;
+		}
+	}
+
+	void TextureResidency::setResidentLevel(uint32_t id, uint32_t level) {
+		if (const auto it = mStates.find(id); it != mStates.end()) {
+			it->second.resident = std::min(level, it->second.desc.lockedLevel);
+			it->second.target = it->second.resident;
+			it->second.coarserFrames = 0;
+		}
+	}
+
+	void TextureResidency::request(uint32_t id, uint32_t level) {
+		if (const auto it = mStates.find(id); it != mStates.end()) {
+			it->second.requested = std::min(it->second.requested, static_cast<float>(level));
+		}
+	}
+
+	bool TextureResidency::isBusy(uint32_t id) const {
+		const auto it = mStates.find(id);
+		return it != mStates.end() && it->second.busy;
+	}
+
+	uint32_t TextureResidency::getResidentLevel(uint32_t id) const {
+		const auto it = mStates.find(id);
+		return it != mStates.end() ? it->second.resident : 0;
+	}
+
+	uint32_t TextureResidency::getLockedLevel(uint32_t id) const {
+		const auto it = mStates.find(id);
+		return it != mStates.end() ? it->second.desc.lockedLevel : 0;
+	}
+
+	const TextureResidency::TextureDesc* TextureResidency::getDesc(uint32_t id) const {
+		const auto it = mStates.find(id);
+		return it != mStates.end() ? &it->second.desc : nullptr;
+	}
+
+	float TextureResidency::getRequiredMip(const View& view, const DrawRecord& draw, uint32_t textureSize) {
+		const auto pixelsPerUnit = view.projectionScale * view.screenHeight * 0.5f / std::max(draw.distance, MIN_DISTANCE);
+		const auto texelsPerUnit = (draw.uvDensity > 0.f ? draw.uvDensity : 1.f) * static_cast<float>(textureSize);
+		return std::log2(std::max(texelsPerUnit / pixelsPerUnit, MIN_TEXELS_PER_PIXEL));
+	}
+
+	uint64_t TextureResidency::getBytes(const State& state, uint32_t level) {
+		uint64_t bytes = 0;
+		for (auto i = level; i < state.desc.levelBytes.size(); i++) {
+			bytes += state.desc.levelBytes[i];
+		}
+		return bytes;
+	}
+
+	uint32_t TextureResidency::chooseLevel(State& state) const {
+		const auto locked = static_cast<float>(state.desc.lockedLevel);
+		const auto toLevel = [locked](float mip) {
+			return static_cast<uint32_t>(std::clamp(std::floor(mip), 0.f, locked));
+		};
+
+		const auto seen = state.required != NOT_SEEN;
+		const auto needed = seen ? toLevel(state.required + mSettings.mipBias) : state.desc.lockedLevel;
+		if (needed <= state.resident) {
+			state.coarserFrames = 0;
+			return needed;
+		}
+
+		const auto coarser = seen ? toLevel(state.required + mSettings.mipBias - mSettings.hysteresis) : state.desc.lockedLevel;
+		if (coarser <= state.resident) {
+			state.coarserFrames = 0;
+			return state.resident;
+		}
+
+		return ++state.coarserFrames >= mSettings.dropFrames ? coarser : state.resident;
+	}
+
+	const std::vector<TextureResidency::Change>& TextureResidency::update(const View& view, const std::vector<DrawRecord>& draws) {
+		mChanges.clear();
+		mStats = {};
+		mStats.textures = mStates.size();
+
+		//requested level is exact, bias is applied to levels from draws only
+		for (auto& [id, state] : mStates) {
+			state.required = state.requested != NOT_SEEN ? state.requested - mSettings.mipBias : NOT_SEEN;
+			state.requested = NOT_SEEN;
+		}
+
+		for (const auto& draw : draws) {
+			const auto it = mStates.find(draw.texture);
+			if (it == mStates.end()) {
+				continue;
+			}
+
+			auto& state = it->second;
+			const auto size = std::max(state.desc.width, state.desc.height);
+			state.required = std::min(state.required, getRequiredMip(view, draw, size));
+		}
+
+		uint64_t total = 0;
+		for (auto& [id, state] : mStates) {
+			mStats.visibleTextures += state.required != NOT_SEEN;
+			state.target = state.busy ? state.resident : chooseLevel(state);
+			total += getBytes(state, state.target);
+		}
+		mStats.wantedBytes = total;
+
+		//level which gives the most detail over required is dropped first, it is compared with required one after drop again
+		if (total > mSettings.budgetBytes) {
+			using Candidate = std::pair<float, uint32_t>;
+			std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> candidates;
+			for (const auto& [id, state] : mStates) {
+				if (!state.busy && state.target < state.desc.lockedLevel) {
+					candidates.emplace(static_cast<float>(state.target) - state.required, id);
+				}
+			}
+
+			while (total > mSettings.budgetBytes && !candidates.empty()) {
+				const auto id = candidates.top().second;
+				candidates.pop();
+
+				auto& state = mStates[id];
+				total -= state.desc.levelBytes[state.target];
+				state.target++;
+				if (state.target < state.desc.lockedLevel) {
+					candidates.emplace(static_cast<float>(state.target) - state.required, id);
+				}
+			}
+		}
+
+		//the blurriest textures are loaded first, others wait for next frames
+		std::vector<std::pair<float, uint32_t>> loads;
+		for (auto& [id, state] : mStates) {
+			if (state.target < state.resident) {
+				loads.emplace_back(static_cast<float>(state.resident) - state.required, id);
+			}
+			else if (state.target > state.resident) {
+				mChanges.push_back({ id, state.resident, state.target });
+				state.resident = state.target;
+				mStats.drops++;
+			}
+		}
+
+		std::sort(loads.begin(), loads.end(), [](const auto& lhs, const auto& rhs) {
+			return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+		});
+		for (size_t i = 0; i < loads.size(); i++) {
+			auto& state = mStates[loads[i].second];
+			if (i >= mSettings.maxLoadsPerFrame) {
+				state.target = state.resident;
+				mStats.deferredLoads++;
+				continue;
+			}
+
+			mChanges.push_back({ loads[i].second, state.resident, state.target });
+			state.resident = state.target;
+			mStats.loads++;
+		}
+
+		for (const auto& [id, state] : mStates) {
+			mStats.residentBytes += getBytes(state, state.resident);
+		}
+
+		return mChanges;
+	}
+}
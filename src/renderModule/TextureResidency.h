@@ -0,0 +1,108 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace SFE::Render {
+	//chooses resident mips of streamed textures from draws of visible meshes and memory budget
+	//required mip follows texel density on screen, so draw needs only distance to mesh and how many uv units one world unit of mesh covers
+	//finer level is loaded as soon as it is needed, coarser one is taken only after it was enough for dropFrames, so textures on the edge don't bounce
+	//when wanted levels don't fit budget, levels with the biggest excess of detail are dropped first, unseen textures go first
+	//pure cpu decisions, covered by tests/TextureResidencyTests.cpp
+	class TextureResidency {
+	public:
+		constexpr static float NOT_SEEN = std::numeric_limits<float>::max();
+
+		struct Settings {
+			uint64_t budgetBytes = 512ull * 1024 * 1024;
+			float mipBias = 0.f; //positive gives blurrier textures
+			float hysteresis = 0.25f; //required mip should go this much over coarser level before it is taken
+			uint32_t dropFrames = 60;
+			uint32_t maxLoadsPerFrame = 4;
+
+			friend bool operator==(const Settings& lhs, const Settings& rhs) = default;
+		};
+
+		struct View {
+			float projectionScale = 1.f; //projection[1][1]
+			float screenHeight = 1.f;
+		};
+
+		struct DrawRecord {
+			uint32_t texture = 0;
+			float distance = 0.f; //from camera to the nearest point of mesh bounds
+			float uvDensity = 1.f; //uv units per world unit of mesh
+		};
+
+		struct TextureDesc {
+			uint32_t width = 0;
+			uint32_t height = 0;
+			std::vector<uint64_t> levelBytes; //the first level is the biggest
+			uint32_t lockedLevel = 0; //levels from it to the end are never dropped
+		};
+
+		struct Change {
+			uint32_t texture = 0;
+			uint32_t from = 0;
+			uint32_t to = 0; //new base level, less than from means load
+		};
+
+		struct Stats {
+			size_t textures = 0;
+			size_t visibleTextures = 0;
+			size_t loads = 0;
+			size_t drops = 0;
+			size_t deferredLoads = 0; //over loads limit, they are wanted next frame again
+			uint64_t residentBytes = 0;
+			uint64_t wantedBytes = 0; //without budget
+		};
+
+		void setSettings(const Settings& settings) { mSettings = settings; }
+		const Settings& getSettings() const { return mSettings; }
+
+		//resident level is base level which is uploaded already
+		void addTexture(uint32_t id, TextureDesc desc, uint32_t residentLevel);
+		void removeTexture(uint32_t id);
+		//busy texture keeps its level, it is set while its levels are loading
+		void setBusy(uint32_t id, bool busy);
+		//level which caller uploaded or dropped by itself
+		void setResidentLevel(uint32_t id, uint32_t level);
+		//texture is wanted at least at this level during the next update, as if some draw needed it
+		void request(uint32_t id, uint32_t level);
+
+		//changes are taken as applied, caller should load or drop levels of every returned texture
+		const std::vector<Change>& update(const View& view, const std::vector<DrawRecord>& draws);
+
+		bool contains(uint32_t id) const { return mStates.contains(id); }
+		bool isBusy(uint32_t id) const;
+		uint32_t getResidentLevel(uint32_t id) const;
+		uint32_t getLockedLevel(uint32_t id) const;
+		const TextureDesc* getDesc(uint32_t id) const;
+		const Stats& getStats() const { return mStats; }
+
+		//level at which one texel covers one pixel, negative when texture is magnified
+		static float getRequiredMip(const View& view, const DrawRecord& draw, uint32_t textureSize);
+
+	private:
+		struct State {
+			TextureDesc desc;
+			uint32_t resident = 0;
+			uint32_t target = 0;
+			float required = NOT_SEEN;
+			float requested = NOT_SEEN;
+			uint32_t coarserFrames = 0;
+			bool busy = false;
+		};
+
+		uint32_t chooseLevel(State& state) const;
+		//bytes of level and all coarser ones
+		static uint64_t getBytes(const State& state, uint32_t level);
+
+		Settings mSettings;
+		std::unordered_map<uint32_t, State> mStates;
+		std::vector<Change> mChanges;
+		Stats mStats;
+	};
+}
@@ -0,0 +1,370 @@
+﻿#include "TextureStreamer.h"
+
+#include <cassert>
+
+#include "assetsModule/AssetsManager.h"
+#include "assetsModule/TextureHandler.h"
+#include "core/Engine.h"
+#include "debugModule/Benchmark.h"
+#include "glWrapper/Sync.h"
+#include "logsModule/logger.h"
+#include "multithreading/ThreadPool.h"
+#include "renderModule/MaterialSystem.h"
+
+namespace SFE::Render {
+	void TextureStreamer::addTexture(size_t assetId, uint32_t textureId, Source source, const AssetsModule::TextureImage& image, uint32_t residentLevel, uint32_t lockedLevel) {
+		if (image.mips.empty()) {
+			return;
+		}
+
+		Added added;
+		added.textureId = textureId;
+		added.entry.assetId = assetId;
+		added.entry.source = std::move(source);
+		added.entry.compressed = image.compression != AssetsModule::TextureCompression::NONE;
+		added.desc.width = image.width;
+		added.desc.height = image.height;
+		added.desc.lockedLevel = lockedLevel;
+		added.desc.levelBytes.reserve(image.mips.size());
+		for (const auto& mip : image.mips) {
+			added.desc.levelBytes.push_back(mip.data.size());
+		}
+		added.residentLevel = residentLevel;
+
+		std::unique_lock lock(mMutex);
+		mAdded.push_back(std::move(added));
+	}
+
+	void TextureStreamer::submitDraws(const TextureResidency::View& view, std::vector<TextureResidency::DrawRecord> draws) {
+		std::unique_lock lock(mMutex);
+		mView = view;
+		mDraws = std::move(draws);
+		mDrawsSubmitted = true;
+	}
+
+	void TextureStreamer::update() {
+		FUNCTION_BENCHMARK;
+		assert(Engine::isRenderThread());
+
+		std::vector<Added> added;
+		std::vector<Loaded> loaded;
+		TextureResidency::View view;
+		{
+			std::unique_lock lock(mMutex);
+			added.swap(mAdded);
+			loaded.swap(mLoaded);
+			view = mView;
+			if (mDrawsSubmitted) {
+				mFrameDraws.swap(mDraws);
+				mDraws.clear();
+				mDrawsSubmitted = false;
+			}
+		}
+
+		for (auto& texture : added) {
+			mResidency.addTexture(texture.textureId, std::move(texture.desc), texture.residentLevel);
+			mEntries[texture.textureId] = std::move(texture.entry);
+		}
+
+		for (const auto& page : mChangedPages) {
+			updatePage(page);
+		}
+		mChangedPages.clear();
+
+		const auto pagesUsed = MaterialSystem::enabled;
+
+		for (const auto& texture : loaded) {
+			mLoading--;
+			if (texture.textureId & PAGE_ID) {
+				finishPageLoad(texture);
+			}
+			else if (texture.success) {
+				mResidency.setBusy(texture.textureId, false);
+			}
+			else {
+				mResidency.removeTexture(texture.textureId);
+				mEntries.erase(texture.textureId);
+			}
+		}
+
+		//dropped levels are loaded back, so textures are whole when streaming is off
+		if (!enabled) {
+			mRequested.clear();
+			if (pagesUsed) {
+				dropHeld();
+			}
+
+			for (const auto& [id, entry] : mEntries) {
+				const auto level = mResidency.getResidentLevel(id);
+				if (level != 0 && !mResidency.isBusy(id) && !(pagesUsed && entry.heldByPage)) {
+					mResidency.setResidentLevel(id, 0);
+					mResidency.setBusy(id, true);
+					load(id, entry, level, 0);
+				}
+			}
+
+			for (const auto& [id, page] : mPages) {
+				const auto level = mResidency.getResidentLevel(id);
+				if (level != 0 && !mResidency.isBusy(id)) {
+					mResidency.setResidentLevel(id, 0);
+					changePage(id, level, 0);
+				}
+			}
+			return;
+		}
+
+		for (const auto id : mRequested) {
+			mResidency.request(id, 0);
+		}
+		mRequested.clear();
+
+		//held textures are sampled from pages, so their draws keep levels of the page instead
+		if (pagesUsed) {
+			dropHeld();
+			for (auto& draw : mFrameDraws) {
+				if (const auto it = mLayerPages.find(draw.texture); it != mLayerPages.end()) {
+					draw.texture = it->second;
+				}
+			}
+		}
+
+		if (mResidency.getSettings() != settings) {
+			mResidency.setSettings(settings);
+		}
+
+		for (const auto& change : mResidency.update(view, mFrameDraws)) {
+			if (change.texture & PAGE_ID) {
+				changePage(change.texture, change.from, change.to);
+				continue;
+			}
+
+			const auto it = mEntries.find(change.texture);
+			if (it == mEntries.end()) {
+				continue;
+			}
+
+			if (change.to < change.from) {
+				mResidency.setBusy(change.texture, true);
+				load(change.texture, it->second, change.from, change.to);
+			}
+			else if (!drop(it->second, change.from, change.to)) {
+				mResidency.removeTexture(change.texture);
+				mEntries.erase(it);
+			}
+		}
+	}
+
+	void TextureStreamer::requestFull(uint32_t textureId) {
+		assert(Engine::isRenderThread());
+		mRequested.push_back(textureId);
+	}
+
+	void TextureStreamer::setPage(size_t pageIdx, const MaterialTable::Page& page, uint32_t base) {
+		assert(Engine::isRenderThread());
+		mChangedPages.push_back({ pageIdx, base, page });
+	}
+
+	void TextureStreamer::updatePage(const PageEntry& page) {
+		const auto id = PAGE_ID | static_cast<uint32_t>(page.pageIdx);
+		const auto& key = page.page.key;
+
+		//page level costs the same level of one layer times capacity, unused layers are allocated too
+		const std::vector<uint64_t>* layerBytes = nullptr;
+		auto locked = key.levels - 1;
+		bool reloadable = true;
+		for (const auto texture : page.page.textures) {
+			const auto it = mEntries.find(texture);
+			if (it == mEntries.end()) {
+				reloadable = false;
+				continue;
+			}
+
+			it->second.heldByPage = true;
+			mLayerPages[texture] = id;
+			if (const auto desc = mResidency.getDesc(texture)) {
+				layerBytes = &desc->levelBytes;
+				locked = std::min(locked, desc->lockedLevel);
+			}
+		}
+
+		//layers which streamer doesn't know can't be loaded back, such page keeps all its levels but is still counted
+		TextureResidency::TextureDesc desc;
+		desc.width = key.width;
+		desc.height = key.height;
+		desc.lockedLevel = reloadable ? locked : 0;
+		desc.levelBytes.resize(key.levels);
+		for (uint32_t level = 0; level < key.levels; level++) {
+			const auto bytes = layerBytes && level < layerBytes->size() ? (*layerBytes)[level] : uint64_t(std::max(key.width >> level, 1u)) * std::max(key.height >> level, 1u) * 4;
+			desc.levelBytes[level] = bytes * page.page.capacity;
+		}
+
+		mResidency.addTexture(id, std::move(desc), page.base);
+		mPages[id] = page;
+	}
+
+	void TextureStreamer::changePage(uint32_t id, uint32_t from, uint32_t to) {
+		const auto it = mPages.find(id);
+		if (it == mPages.end()) {
+			return;
+		}
+
+		//coarser page is copied on render thread, finer one is filled by upload worker
+		const auto texture = MaterialSystem::instance()->setPageBase(it->second.pageIdx, to);
+		if (!texture) {
+			mResidency.removeTexture(id);
+			mPages.erase(it);
+			return;
+		}
+
+		it->second.base = to;
+		if (to < from) {
+			mResidency.setBusy(id, true);
+			loadPage(id, texture, from, to);
+		}
+	}
+
+	void TextureStreamer::loadPage(uint32_t id, unsigned texture, uint32_t from, uint32_t to) {
+		mLoading++;
+
+		struct Layer {
+			size_t assetId = 0;
+			Source source;
+			bool compressed = false;
+		};
+
+		std::vector<Layer> layers;
+		for (const auto textureId : mPages[id].page.textures) {
+			//only pages with known layers are dropped, so they are all here
+			const auto it = mEntries.find(textureId);
+			layers.push_back(it != mEntries.end() ? Layer{ it->second.assetId, it->second.source, it->second.compressed } : Layer{});
+		}
+
+		//page levels [0, from - to) are mips [to, from) of every layer
+		ThreadPool::instance()->addTask<WorkerType::GPU_UPLOAD>([this, id, texture, layers = std::move(layers), from, to]() {
+			bool success = true;
+			GLW::bindTexture(GLW::TEXTURE_2D_ARRAY, texture);
+			for (size_t layer = 0; layer < layers.size() && success; layer++) {
+				const auto& source = layers[layer];
+				AssetsModule::TextureImage image;
+				auto asset = AssetsModule::AssetsManager::instance()->getAsset<AssetsModule::Texture>(source.assetId);
+				success = asset && AssetsModule::TextureCooker::cook(source.source.path, source.source.settings, image) && image.mips.size() > from;
+				if (!success) {
+					SFE_LOG_ERROR("TextureStreamer::can't load page levels of texture %s", source.source.path.c_str());
+					break;
+				}
+
+				asset->texture.applyPixelStorageMode();
+				for (auto level = to; level < from; level++) {
+					const auto& mip = image.mips[level];
+					const auto pageLevel = static_cast<int>(level - to);
+					if (source.compressed) {
+						GLW::compressedLayerSubImage(pageLevel, static_cast<int>(layer), mip.width, mip.height, asset->texture.pixelFormat, mip.data.size(), mip.data.data());
+					}
+					else {
+						GLW::layerSubImage(pageLevel, static_cast<int>(layer), mip.width, mip.height, asset->texture.textureFormat, asset->texture.pixelType, mip.data.data());
+					}
+				}
+			}
+
+			if (success) {
+				glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+			}
+			GLW::bindTexture(GLW::TEXTURE_2D_ARRAY, 0);
+			GLW::waitGpu();
+
+			std::unique_lock lock(mMutex);
+			mLoaded.push_back({ id, success, from });
+		});
+	}
+
+	void TextureStreamer::finishPageLoad(const Loaded& loaded) {
+		const auto it = mPages.find(loaded.textureId);
+		if (it == mPages.end()) {
+			return;
+		}
+
+		//levels which failed stay hidden, page goes back to the base it had
+		if (!loaded.success) {
+			MaterialSystem::instance()->setPageBase(it->second.pageIdx, loaded.from);
+			it->second.base = loaded.from;
+			mResidency.setResidentLevel(loaded.textureId, loaded.from);
+		}
+
+		MaterialSystem::instance()->finishPageLoad(it->second.pageIdx);
+		mResidency.setBusy(loaded.textureId, false);
+	}
+
+	void TextureStreamer::dropHeld() {
+		for (auto it = mEntries.begin(); it != mEntries.end();) {
+			const auto id = it->first;
+			const auto locked = mResidency.getLockedLevel(id);
+			const auto level = mResidency.getResidentLevel(id);
+			if (!it->second.heldByPage || level >= locked || mResidency.isBusy(id)) {
+				++it;
+				continue;
+			}
+
+			if (!drop(it->second, level, locked)) {
+				mResidency.removeTexture(id);
+				it = mEntries.erase(it);
+				continue;
+			}
+
+			mResidency.setResidentLevel(id, locked);
+			++it;
+		}
+	}
+
+	void TextureStreamer::load(uint32_t textureId, const Entry& entry, uint32_t from, uint32_t to) {
+		mLoading++;
+
+		//levels are cooked again, cooker reads them from cache, so source isn't decoded
+		ThreadPool::instance()->addTask<WorkerType::GPU_UPLOAD>([this, textureId, entry, from, to]() {
+			AssetsModule::TextureImage image;
+			auto asset = AssetsModule::AssetsManager::instance()->getAsset<AssetsModule::Texture>(entry.assetId);
+			const auto success = asset && AssetsModule::TextureCooker::cook(entry.source.path, entry.source.settings, image) && image.mips.size() > from;
+			if (success) {
+				auto& texture = asset->texture;
+				GLW::bindTexture(texture.mType, texture.mId);
+				texture.applyPixelStorageMode();
+				for (auto level = to; level < from; level++) {
+					const auto& mip = image.mips[level];
+					if (entry.compressed) {
+						texture.compressedImageLevel2D(static_cast<int>(level), mip.width, mip.height, mip.data.size(), mip.data.data());
+					}
+					else {
+						texture.imageLevel2D(static_cast<int>(level), mip.width, mip.height, mip.data.data());
+					}
+				}
+				texture.parameters.baseLevel = static_cast<int>(to);
+				texture.setParameter(GLW::BASE_LEVEL, texture.parameters.baseLevel);
+				GLW::bindTexture(texture.mType, 0);
+			}
+			else {
+				SFE_LOG_ERROR("TextureStreamer::can't load levels of texture %s", entry.source.path.c_str());
+			}
+			GLW::waitGpu();
+
+			std::unique_lock lock(mMutex);
+			mLoaded.push_back({ textureId, success });
+		});
+	}
+
+	bool TextureStreamer::drop(const Entry& entry, uint32_t from, uint32_t to) {
+		auto asset = AssetsModule::AssetsManager::instance()->getAsset<AssetsModule::Texture>(entry.assetId);
+		if (!asset) {
+			return false;
+		}
+
+		//base level goes up first, so texture is never sampled from released level
+		auto& texture = asset->texture;
+		GLW::bindTexture(texture.mType, texture.mId);
+		texture.parameters.baseLevel = static_cast<int>(to);
+		texture.setParameter(GLW::BASE_LEVEL, texture.parameters.baseLevel);
+		for (auto level = from; level < to; level++) {
+			texture.releaseLevel2D(static_cast<int>(level), entry.compressed);
+		}
+		GLW::bindTexture(texture.mType, 0);
+		return true;
+	}
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MaterialTable.h"
+#include "TextureResidency.h"
+#include "assetsModule/TextureCooker.h"
+#include "containersModule/Singleton.h"
+
+namespace SFE::Render {
+	//keeps only levels of textures which visible meshes need, residency decides levels from draws of geometry pass
+	//levels are dropped on render thread and loaded back by upload worker from cooked cache
+	//material pages are streamed as one texture under the same budget, draws of their layers are counted for the page
+	//textures copied into pages keep only their smallest levels while material system is enabled
+	//when streaming is turned off all textures get their levels back
+	class TextureStreamer : public Singleton<TextureStreamer> {
+	public:
+		inline static bool enabled = true;
+
+		//residency id of material page, gl texture ids never reach this bit
+		constexpr static uint32_t PAGE_ID = 0x80000000u;
+
+		//how texture is cooked again when its levels are loaded back
+		struct Source {
+			std::string path;
+			AssetsModule::TextureCooker::Settings settings;
+		};
+
+		TextureResidency::Settings settings;
+
+		//any thread, levels from resident one to the end are uploaded, levels from locked one are never dropped
+		void addTexture(size_t assetId, uint32_t textureId, Source source, const AssetsModule::TextureImage& image, uint32_t residentLevel, uint32_t lockedLevel);
+		//any thread, draws of visible meshes, the last submitted ones are used by update
+		void submitDraws(const TextureResidency::View& view, std::vector<TextureResidency::DrawRecord> draws);
+
+		//render thread, material page waits until texture has all its levels to copy them
+		void requestFull(uint32_t textureId);
+		//render thread, layers of page are copied, base is the finest level page keeps
+		//layer textures are dropped down to locked level while pages are used, page levels are loaded back from their sources
+		void setPage(size_t pageIdx, const MaterialTable::Page& page, uint32_t base);
+
+		//render thread
+		void update();
+		const TextureResidency::Stats& getStats() const { return mResidency.getStats(); }
+		size_t getLoadingCount() const { return mLoading; }
+
+	private:
+		struct Entry {
+			size_t assetId = 0;
+			Source source;
+			bool compressed = false;
+			bool heldByPage = false;
+		};
+
+		struct Added {
+			uint32_t textureId = 0;
+			Entry entry;
+			TextureResidency::TextureDesc desc;
+			uint32_t residentLevel = 0;
+		};
+
+		struct Loaded {
+			uint32_t textureId = 0;
+			bool success = false;
+			uint32_t from = 0;
+		};
+
+		struct PageEntry {
+			size_t pageIdx = 0;
+			uint32_t base = 0;
+			MaterialTable::Page page;
+		};
+
+		void load(uint32_t textureId, const Entry& entry, uint32_t from, uint32_t to);
+		void updatePage(const PageEntry& page);
+		void changePage(uint32_t id, uint32_t from, uint32_t to);
+		void loadPage(uint32_t id, unsigned texture, uint32_t from, uint32_t to);
+		void finishPageLoad(const Loaded& loaded);
+		//returns false if texture asset is removed
+		bool drop(const Entry& entry, uint32_t from, uint32_t to);
+		//held textures go down to locked level as soon as they aren't loading
+		void dropHeld();
+
+		TextureResidency mResidency;
+		std::unordered_map<uint32_t, Entry> mEntries;
+		size_t mLoading = 0;
+
+		//render thread only, asked by material system before entries of textures could be added
+		std::vector<uint32_t> mRequested;
+		std::vector<PageEntry> mChangedPages;
+		std::unordered_map<uint32_t, PageEntry> mPages; //by residency id
+		std::unordered_map<uint32_t, uint32_t> mLayerPages; //layer texture -> page residency id
+
+		std::mutex mMutex;
+		std::vector<Added> mAdded;
+		std::vector<Loaded> mLoaded;
+		TextureResidency::View mView;
+		std::vector<TextureResidency::DrawRecord> mDraws;
+		bool mDrawsSubmitted = false;
+		std::vector<TextureResidency::DrawRecord> mFrameDraws;
+	};
+}
@@ -1,12 +1,18 @@
 ﻿#pragma once
+#include "assetsModule/modelModule/GeometryArena.h"
 #include "assetsModule/modelModule/Mesh.h"
 #include "glWrapper/Draw.h"
 
 namespace SFE::Render {
 
-	template<typename VertexType>
-	void drawMesh(GLW::RenderMode mode, Mesh<VertexType> mesh, unsigned vao) {
-		GLW::drawVertices(mode, vao, mesh.vertices.size(), mesh.indices.size());
+	inline void drawMesh(GLW::RenderMode mode, const GeometryArena::Range& range) {
+		if (!range.vao) {
+			return;
+		}
+
+		GLW::VertexArray::bindArray(range.vao);
+		GLW::drawElementsInstancedBaseVertex(mode, static_cast<GLsizei>(range.indicesCount), GLW::RenderDataType::UNSIGNED_INT, 1, reinterpret_cast<const void*>(range.firstIndex * sizeof(uint32_t)), range.baseVertex);
+		GLW::VertexArray::bindDefault();
 	}
 
 	template<typename VertexType>
@@ -4,6 +4,7 @@
 #include "componentsModule/FrustumComponent.h"
 #include "componentsModule/ModelComponent.h"
 #include "core/Engine.h"
+#include "renderModule/RenderGraph.h"
 #include "renderModule/Utils.h"
 #include "systemsModule/systems/RenderSystem.h"
 #include "assetsModule/modelModule/BoundingVolume.h"
@@ -39,39 +40,90 @@
 using namespace SFE::Render::RenderPasses;
 
 void CascadedShadowPass::prepare() {
-	if (!ECSHandler::registry().getComponent<CascadeShadowComponent>(mShadowSource)) {
+	auto& renderData = ECSHandler::getSystem<SystemsModule::RenderSystem>()->getRenderData();
+	const auto& shadows = renderData.nextCascadeShadows;
+	if (shadows.cascades.empty()) {
 		return;
 	}
 
 	auto curPassData = getContainer().getCurrentPassData();
-	curPassData->mStatus = RenderPreparingStatus::PREPARING;
-	auto& renderData = ECSHandler::getSystem<SystemsModule::RenderSystem>()->getRenderData();
-	ThreadPool::instance()->addTask<WorkerType::RENDER>([nextRegistry = renderData.nextRegistry, this, curPassData, camProj = renderData.nextCameraProjection, view = renderData.next.view]() mutable {
+	auto staticPassData = mStaticData.getCurrentPassData();
+	curPassData->setStatus(RenderPreparingStatus::PREPARING);
+
+	SFE::Vector<ecss::EntityId> dynamicCasters;
+	dynamicCasters.reserve(mDynamicCasters.size());
+	for (const auto& [entity, _] : mDynamicCasters) {
+		dynamicCasters.push_back(entity);
+	}
+	dynamicCasters.sort();
+
+	//cascades and matrices are copied from snapshot, they were calculated on main thread for camera of the frame
+	auto& plan = mPlans[curPassData];
+	ThreadPool::instance()->addTask<WorkerType::RENDER>([nextRegistry = renderData.nextRegistry, this, curPassData, staticPassData, &plan, camProj = renderData.nextCameraProjection, camPos = renderData.mNextCameraPos,
+		cascades = shadows.cascades, matrices = shadows.matrices, caches = mCascades, changedCasters = std::move(mChangedCasters), dynamicCasters = std::move(dynamicCasters), frame = mFrame]() mutable {
 		FUNCTION_BENCHMARK;
 
 		curPassData->getBatcher().clear();
-		auto shadowsComp = ECSHandler::registry().getComponent<CascadeShadowComponent>(mShadowSource);
-		if (!shadowsComp) {
-			curPassData->mStatus = RenderPreparingStatus::READY;
-			return;
+		staticPassData->getBatcher().clear();
+		plan = {};
+
+		const auto cascadesCount = std::min(matrices.size(), cascades.size());
+		caches.resize(cascadesCount);
+
+		//caster which became dynamic is still in static layer, caster which became static is not there yet
+		std::vector<uint8_t> dirty(cascadesCount, false);
+		if (!changedCasters.empty()) {
+			FUNCTION_BENCHMARK_NAMED(changed_casters);
+			changedCasters.sort();
+			changedCasters.removeDuplicatesSorted();
+			for (auto [ent, transform, meshComp] : ECSHandler::drawRegistry(nextRegistry).forEach<const ComponentsModule::TransformMatComp, const MeshComponent>({ changedCasters }, false)) {
+				if (!transform || !meshComp) {
+					continue;
+				}
+
+				for (size_t i = 0; i < cascadesCount; i++) {
+					if (dirty[i]) {
+						continue;
+					}
+
+					for (const auto& mesh : meshComp->meshGraph) {
+						if (mesh.value.bounds.isOnFrustum(cascades[i].frustum, transform->mTransform) || (caches[i].valid && mesh.value.bounds.isOnFrustum(caches[i].frustum, transform->mTransform))) {
+							dirty[i] = true;
+							break;
+						}
+					}
+				}
+			}
 		}
 
-		shadowsComp->calculateLightSpaceMatrices(camProj, view);
+		plan = CascadePlanner::plan(caches, cascades, matrices, dirty, { staticUpdatesBudget, nearCascadesCount, distantCascadesInterval }, frame);
 
-		SFE::Vector<ecss::EntityId> entities;
+		SFE::Vector<ecss::EntityId> staticEntities;
+		SFE::Vector<ecss::EntityId> dynamicEntities;
 		{
 			FUNCTION_BENCHMARK_NAMED(octree);
 
-			const auto& cascades = shadowsComp->cascades;
-
 			const auto octreeSys = ECSHandler::getSystem<SystemsModule::OcTreeSystem>();
-			for (auto& cascade : cascades) {
-				for (auto& treePos : octreeSys->getAABBOctrees(cascade.frustum.generateAABB())) {
+			for (size_t i = 0; i < cascadesCount; i++) {
+				if (!plan.updateDynamic[i]) {
+					continue;
+				}
+
+				const auto& frustum = plan.cascades[i].frustum;
+				const auto refreshStatic = plan.refreshStatic[i];
+				for (auto& treePos : octreeSys->getAABBOctrees(frustum.generateAABB())) {
 					if (const auto tree = octreeSys->getOctree(treePos)) {
 						auto lock = tree->readLock();
-						tree->forEachObjectInFrustum(cascade.frustum, [&entities, &cascade](const auto& obj, bool entirely) {
-							if (entirely || FrustumModule::AABB::isOnFrustum(cascade.frustum, obj.pos, obj.size)) {
-								entities.emplace_back(obj.data);
+						tree->forEachObjectInFrustum(frustum, [&](const auto& obj, bool entirely) {
+							if (!entirely && !FrustumModule::AABB::isOnFrustum(frustum, obj.pos, obj.size)) {
+								return;
+							}
+
+							if (dynamicCasters.containsSorted(obj.data)) {
+								dynamicEntities.emplace_back(obj.data);
+							}
+							else if (refreshStatic) {
+								staticEntities.emplace_back(obj.data);
 							}
 						});
 					}
@@ -79,17 +131,17 @@ void CascadedShadowPass::prepare() {
 			}
 		}
 
-		if (entities.empty()) {
-			curPassData->mStatus = RenderPreparingStatus::READY;
-			return;
-		}
-		entities.sort();
-		entities.removeDuplicatesSorted();
-		{
-			auto& batcher = curPassData->getBatcher();
+		const auto sortPos = cascadesCount ? camPos - cascades.front().stableForward * camProj.getFar() : camPos;
+		const auto addCasters = [nextRegistry, sortPos](SFE::Vector<ecss::EntityId>& entities, Batcher& batcher) {
+			if (entities.empty()) {
+				return;
+			}
+			entities.sort();
+			entities.removeDuplicatesSorted();
+
 			{
 				FUNCTION_BENCHMARK_NAMED(addedToBatcher)
-					
+
 				for (auto [ent, transform, meshComp, oclComp] : ECSHandler::drawRegistry(nextRegistry).forEach<const ComponentsModule::TransformMatComp, const MeshComponent, const ComponentsModule::OccludedComponent>({ entities }, false)) {
 					if (!meshComp) {
 						continue;
@@ -99,20 +151,27 @@ void CascadedShadowPass::prepare() {
 					}
 
 					for (const auto& mesh : meshComp->meshGraph) {
-						batcher.addToDrawList(ent, mesh.value.vaoId, mesh.value.verticesCount, mesh.value.indicesCount, {}, transform->mTransform);
+						batcher.addToDrawList(ent, mesh.value.mesh, nullptr, transform->mTransform, &mesh.value.bounds);
 					}
-
 				}
 			}
 			FUNCTION_BENCHMARK_NAMED(sort)
-			batcher.sort({100.f,1300.f, 600.f});//todo
-		}
-		curPassData->mStatus = RenderPreparingStatus::READY;
+			//front to back from the light
+			batcher.sort(sortPos);
+		};
+
+		addCasters(staticEntities, staticPassData->getBatcher());
+		addCasters(dynamicEntities, curPassData->getBatcher());
+		plan.dynamicCasters = dynamicEntities.size();
+
+		curPassData->setStatus(RenderPreparingStatus::READY);
 	});
+	mChangedCasters.clear();
 }
 
 CascadedShadowPass::CascadedShadowPass() {
 	getContainer().init(2);
+	mStaticData.init(2);
 }
 
 CascadedShadowPass::~CascadedShadowPass() {
@@ -144,6 +203,7 @@ void CascadedShadowPass::init() {
 	//cmp->updateCascades(cameraProjection);
 	transform->setRotate({ -0.4f * 180.f,0.f, 0.4f * 5.f });
 
+	mDepthShader = SHADER_CONTROLLER->loadGeometryShader("shaders/cascadeShadowMap.vs", "shaders/cascadeShadowMap.fs", "shaders/cascadeShadowMap.gs");
 	initRender();
 }
 
@@ -173,6 +233,23 @@ void CascadedShadowPass::initRender() {
 	lightFBO.setReadBuffer(GLW::NONE);
 	lightFBO.finalize();
 
+	//static casters cache, it is never sampled, layers are copied to lightDepthMap
+	staticDepthMap.width = lightDepthMap.width;
+	staticDepthMap.height = lightDepthMap.height;
+	staticDepthMap.depth = lightDepthMap.depth;
+	staticDepthMap.pixelFormat = GLW::DEPTH_COMPONENT32;
+	staticDepthMap.textureFormat = GLW::DEPTH_COMPONENT;
+	staticDepthMap.pixelType = GLW::FLOAT;
+	staticDepthMap.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
+	staticDepthMap.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
+	staticDepthMap.create3D();
+
+	staticFBO.bind();
+	staticFBO.addAttachmentTexture(GLW::AttachmentType::DEPTH, &staticDepthMap);
+	staticFBO.setDrawBuffer(GLW::NONE);
+	staticFBO.setReadBuffer(GLW::NONE);
+	staticFBO.finalize();
+
 	{
 		matricesUBO.generate();
 		auto guard = matricesUBO.lock();
@@ -184,6 +261,11 @@ void CascadedShadowPass::initRender() {
 }
 
 
+void CascadedShadowPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+	graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+		.write(graph.importResource(GraphResources::CASCADE_SHADOW_MAP));
+}
+
 void CascadedShadowPass::render(SystemsModule::RenderData& renderDataHandle) {
 	if (!mInited) {
 		return;
@@ -197,39 +279,89 @@ void CascadedShadowPass::render(SystemsModule::RenderData& renderDataHandle) {
 	{
 		FUNCTION_BENCHMARK_NAMED(_wait_lock);
 		const auto curPassData = getContainer().getCurrentPassData();
-		while(curPassData->mStatus != RenderPreparingStatus::READY) {
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		}
+		curPassData->waitReady();
 	}
 
-	auto shadowsComp = ECSHandler::registry().getComponent<CascadeShadowComponent>(mShadowSource);
-	if (!shadowsComp) {
+	const auto& shadows = renderDataHandle.cascadeShadows;
+	if (shadows.cascades.empty()) {
 		return;
 	}
-	
-	const auto lightMatrices = shadowsComp->getLightSpaceMatrices();//todo copy, because of crash below
 
 	const auto curPassData = getContainer().getCurrentPassData();
+	const auto staticPassData = mStaticData.getCurrentPassData();
+	const auto plan = mPlans[curPassData];
+
+	//caches are updated before next prepare, so it gets state with this frame plan applied
+	applyPlan(plan);
+	updateCasters(renderDataHandle);
+	mFrame++;
+
 	getContainer().rotate();
+	mStaticData.rotate();
 	prepare();
 
 	updateRenderData(renderDataHandle);
 
-	if (!lightMatrices.empty()) {
+	if (plan.cascades.empty()) {
+		return;
+	}
+
+	{
 		FUNCTION_BENCHMARK_NAMED(_bind_ubo);
+		std::vector<Math::Mat4> lightMatrices;
+		lightMatrices.reserve(mCascades.size());
+		for (const auto& cascade : mCascades) {
+			lightMatrices.push_back(cascade.matrix);
+		}
+
 		auto guard = matricesUBO.lock();
-		matricesUBO.setData(lightMatrices);//todo crashes when calculateLightSpaceMatrices called from another thread
+		matricesUBO.setData(lightMatrices);
 	}
 
-	GLW::ViewportStack::push({ {static_cast<int>(shadowsComp->resolution.x), static_cast<int>(shadowsComp->resolution.y)} });
-	lightFBO.bind();
-	GLW::clear(GLW::ColorBit::DEPTH);
+	//bit per cascade, geometry shader emits triangles only to layers from mask
+	int staticMask = 0;
+	int dynamicMask = 0;
+	for (size_t i = 0; i < plan.cascades.size(); i++) {
+		staticMask |= plan.refreshStatic[i] ? 1 << i : 0;
+		dynamicMask |= plan.updateDynamic[i] ? 1 << i : 0;
+	}
+
+	if (!dynamicMask) {
+		return;
+	}
+
+	const auto width = static_cast<int>(shadows.resolution.x);
+	const auto height = static_cast<int>(shadows.resolution.y);
+	GLW::ViewportStack::push({ {width, height} });
 
-	const auto simpleDepthShader = SHADER_CONTROLLER->loadGeometryShader("shaders/cascadeShadowMap.vs", "shaders/cascadeShadowMap.fs", "shaders/cascadeShadowMap.gs");
+	const auto simpleDepthShader = mDepthShader;
 	simpleDepthShader->use();
+
+	if (staticMask) {
+		FUNCTION_BENCHMARK_NAMED(_flush_static);
+		const float clearDepth = 1.f;
+		for (size_t i = 0; i < plan.cascades.size(); i++) {
+			if (plan.refreshStatic[i]) {
+				glClearTexSubImage(staticDepthMap.mId, 0, 0, 0, static_cast<GLint>(i), width, height, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+			}
+		}
+
+		staticFBO.bind();
+		simpleDepthShader->setUniform("layersMask", staticMask);
+		staticPassData->getBatcher().flushAll();
+	}
+
+	//updated cascades start from cached static casters, dynamic ones are drawn over them with depth test
+	for (size_t i = 0; i < plan.cascades.size(); i++) {
+		if (plan.updateDynamic[i]) {
+			glCopyImageSubData(staticDepthMap.mId, GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), lightDepthMap.mId, GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), width, height, 1);
+		}
+	}
+
 	{
 		FUNCTION_BENCHMARK_NAMED(_flush);
+		lightFBO.bind();
+		simpleDepthShader->setUniform("layersMask", dynamicMask);
 		curPassData->getBatcher().flushAll();
 	}
 
@@ -237,19 +369,65 @@ void CascadedShadowPass::render(SystemsModule::RenderData& renderDataHandle) {
 	GLW::ViewportStack::pop();
 }
 
+void CascadedShadowPass::applyPlan(const CascadePlanner::Plan& plan) {
+	mData.staticUpdatedCascades = 0;
+	mData.dynamicUpdatedCascades = 0;
+	mData.reusedCascades = 0;
+	mData.dynamicCasters = plan.dynamicCasters;
+
+	mCascades = plan.cascades;
+	for (size_t i = 0; i < plan.cascades.size(); i++) {
+		if (plan.refreshStatic[i]) {
+			mData.staticUpdatedCascades++;
+		}
+		else if (plan.updateDynamic[i]) {
+			mData.dynamicUpdatedCascades++;
+		}
+		else {
+			mData.reusedCascades++;
+		}
+	}
+}
+
+void CascadedShadowPass::updateCasters(const SystemsModule::RenderData& renderDataHandle) {
+	for (const auto entity : renderDataHandle.changedCasters) {
+		auto [it, inserted] = mDynamicCasters.try_emplace(entity, mFrame);
+		it->second = mFrame;
+		if (inserted) {
+			mChangedCasters.push_back(entity);
+		}
+	}
+
+	for (auto it = mDynamicCasters.begin(); it != mDynamicCasters.end();) {
+		if (mFrame - it->second > static_cast<uint64_t>(staticCasterFrames)) {
+			mChangedCasters.push_back(it->first);
+			it = mDynamicCasters.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
 void CascadedShadowPass::updateRenderData(SystemsModule::RenderData& renderDataHandle) {
-	auto shadowsComp = ECSHandler::registry().getComponent<CascadeShadowComponent>(mShadowSource);
 	renderDataHandle.mCascadedShadowsPassData = &mData;
 
 	renderDataHandle.mCascadedShadowsPassData->shadowMapTexture = lightDepthMap.mId;
-	renderDataHandle.mCascadedShadowsPassData->lightDirection = ECSHandler::registry().getComponent<TransformComponent>(mShadowSource)->getForward();
-	renderDataHandle.mCascadedShadowsPassData->lightColor = ECSHandler::registry().getComponent<LightSourceComponent>(mShadowSource)->getLightColor();
-	renderDataHandle.mCascadedShadowsPassData->resolution = shadowsComp->resolution;
-	renderDataHandle.mCascadedShadowsPassData->cameraFarPlane = shadowsComp->cascades.back().viewProjection.getFar();
-	renderDataHandle.mCascadedShadowsPassData->shadowCascadeLevels = shadowsComp->shadowCascadeLevels;
+	if (const auto sun = renderDataHandle.findLight(mShadowSource)) {
+		renderDataHandle.mCascadedShadowsPassData->lightDirection = sun->getForward();
+		renderDataHandle.mCascadedShadowsPassData->lightColor = sun->color;
+	}
 	renderDataHandle.mCascadedShadowsPassData->shadows = mShadowSource;
-	renderDataHandle.mCascadedShadowsPassData->shadowCascades = shadowsComp->cascades;
-	renderDataHandle.mCascadedShadowsPassData->shadowsIntensity = shadowsComp->shadowIntensity;
+
+	const auto& shadows = renderDataHandle.cascadeShadows;
+	if (shadows.cascades.empty()) {
+		return;
+	}
+	renderDataHandle.mCascadedShadowsPassData->resolution = shadows.resolution;
+	renderDataHandle.mCascadedShadowsPassData->cameraFarPlane = shadows.cascades.back().viewProjection.getFar();
+	renderDataHandle.mCascadedShadowsPassData->shadowCascadeLevels = shadows.levels;
+	renderDataHandle.mCascadedShadowsPassData->shadowCascades = shadows.cascades;
+	renderDataHandle.mCascadedShadowsPassData->shadowsIntensity = shadows.intensity;
 }
 
 void CascadedShadowPass::debug(SystemsModule::RenderData& renderDataHandle) {
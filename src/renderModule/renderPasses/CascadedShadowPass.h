@@ -1,17 +1,23 @@
 ﻿#pragma once
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "assetsModule/shaderModule/ShaderBase.h"
 #include "componentsModule/CascadeShadowComponent.h"
+#include "containersModule/Vector.h"
 #include "glWrapper/Buffer.h"
 #include "glWrapper/Framebuffer.h"
+#include "renderModule/CascadePlanner.h"
 
 #include "renderModule/renderPasses/RenderPass.h"
 
 
 namespace SFE::Render::RenderPasses {
 
+	//static casters are rendered into cached layers only when cascade is dirty, every updated cascade copies its cached layer and gets dynamic casters on top
+	//caster is dynamic while its transform, mesh or bones were changed during last staticCasterFrames frames
 	class CascadedShadowPass : public RenderPassWithData {
 	public:
 		void prepare() override;
@@ -27,22 +33,52 @@ namespace SFE::Render::RenderPasses {
 			ecss::EntityId shadows;
 			std::vector<ComponentsModule::ShadowCascade> shadowCascades;
 			float shadowsIntensity = 0.f;
+
+			//cascades of the last frame which static layer was rendered again, which got only dynamic casters and which were reused
+			uint32_t staticUpdatedCascades = 0;
+			uint32_t dynamicUpdatedCascades = 0;
+			uint32_t reusedCascades = 0;
+			size_t dynamicCasters = 0;
 		};
 
+		//static layers rendered again per frame, cascades without valid cache are not limited by it
+		inline static int staticUpdatesBudget = 1;
+		//cascades starting from this one get dynamic casters only every distantCascadesInterval frames
+		inline static int nearCascadesCount = 2;
+		inline static int distantCascadesInterval = 4;
+		inline static int staticCasterFrames = 60;
+
 		CascadedShadowPass();
 		~CascadedShadowPass() override;
 		void init() override;
 		void initRender();
 
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 	private:
 		void updateRenderData(SystemsModule::RenderData& renderDataHandle);
 		void debug(SystemsModule::RenderData& renderDataHandle);
+		void updateCasters(const SystemsModule::RenderData& renderDataHandle);
+		void applyPlan(const CascadePlanner::Plan& plan);
 
 		GLW::Framebuffer lightFBO;
 		GLW::Texture lightDepthMap{GLW::TEXTURE_2D_ARRAY};
 
+		GLW::Framebuffer staticFBO;
+		GLW::Texture staticDepthMap{GLW::TEXTURE_2D_ARRAY};
+
 		GLW::Buffer<GLW::UNIFORM_BUFFER, Math::Mat4, GLW::DYNAMIC_DRAW> matricesUBO;
+		ShaderModule::ShaderBase* mDepthShader = nullptr;
+
+		RenderPassRingBuffer mStaticData;
+		//decided by prepare task for the frame it prepares
+		std::unordered_map<RenderPassData*, CascadePlanner::Plan> mPlans;
+
+		//render thread only, copies are given to prepare task
+		std::vector<CascadePlanner::Cache> mCascades;
+		std::unordered_map<ecss::EntityId, uint64_t> mDynamicCasters; //entity -> frame of the last change
+		SFE::Vector<ecss::EntityId> mChangedCasters; //became dynamic or static since the last prepare
+		uint64_t mFrame = 0;
 
 		ecss::EntityId mShadowSource;
 		bool mInited = false;
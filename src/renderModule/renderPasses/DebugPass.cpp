@@ -12,6 +12,7 @@
 #include "glWrapper/CapabilitiesStack.h"
 #include "glWrapper/Draw.h"
 #include "glWrapper/VertexArray.h"
+#include "renderModule/RenderGraph.h"
 #include "renderModule/SceneGridFloor.h"
 #include "renderModule/Utils.h"
 #include "systemsModule/systems/CameraSystem.h"
@@ -46,19 +47,27 @@ namespace SFE::Render::RenderPasses {
 	}
 
 	DebugPass::~DebugPass() {}
+
+	void DebugPass::init() {
+		mTrianglesShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/simpleColoredTriangle.vs", "shaders/simpleColoredTriangle.fs");
+		mLinesShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/xyzLines.vs", "shaders/colored_lines.fs");
+		mDepthQuadShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/debugQuadDepth.vs", "shaders/debugQuadDepth.fs");
+	}
 	
 
 		
+	void DebugPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+		graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+			.write(graph.importResource(GraphResources::BACKBUFFER, RenderGraph::ResourceType::TEXTURE, true));
+	}
+
 	void DebugPass::render(SystemsModule::RenderData& renderDataHandle) {
 		FUNCTION_BENCHMARK;
 
-		for (auto [entId, gizmoComp] : ECSHandler::registry().forEach<ComponentsModule::GizmoComponent>()) {
-			gizmoComp->gizmo.setEntity(entId);
-			gizmoComp->gizmo.update();
-		}
+		//gizmos are updated by render system on sync with simulation
 
 		if (!Utils::renderTriangles.empty()) {
-			auto triangleShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/simpleColoredTriangle.vs", "shaders/simpleColoredTriangle.fs");
+			const auto triangleShader = mTrianglesShader;
 			triangleShader->use();
 			triangleShader->setUniform("PVM", renderDataHandle.current.PV);
 			triangleShader->setUniform("viewPos", renderDataHandle.mCameraPos);
@@ -86,7 +95,7 @@ namespace SFE::Render::RenderPasses {
 		
 
 		if (!Utils::renderVertices.empty()) {
-			auto coloredLines = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/xyzLines.vs", "shaders/colored_lines.fs");
+			const auto coloredLines = mLinesShader;
 			coloredLines->use();
 			coloredLines->setUniform("PVM", renderDataHandle.current.PV);
 			linesVBO.bind();
@@ -120,10 +129,10 @@ namespace SFE::Render::RenderPasses {
 		//grid.draw();
 
 		auto& renderData = ECSHandler::getSystem<SFE::SystemsModule::RenderSystem>()->getRenderData();
-		CascadeShadowComponent::debugDraw(ECSHandler::registry().getComponent<CascadeShadowComponent>(renderData.mCascadedShadowsPassData->shadows)->getCacheLightSpaceMatrices(), renderData.next.projection, renderData.next.view);
+		CascadeShadowComponent::debugDraw(CascadeShadowComponent::getCacheLightSpaceMatrices(), renderData.next.projection, renderData.next.view);
 
 		if (!renderData.mCascadedShadowsPassData->shadowCascadeLevels.empty() && ECSHandler::getSystem<SFE::SystemsModule::RenderSystem>()->isShadowsDebugData()) {
-			auto sh = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/debugQuadDepth.vs", "shaders/debugQuadDepth.fs");
+			const auto sh = mDepthQuadShader;
 			sh->use();
 			sh->setUniform("depthMap", 31);
 			
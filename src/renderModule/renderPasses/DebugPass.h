@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include "assetsModule/shaderModule/ShaderBase.h"
 #include "glWrapper/Buffer.h"
 #include "glWrapper/VertexArray.h"
 #include "renderModule/Utils.h"
@@ -9,11 +10,18 @@ namespace SFE::Render::RenderPasses {
 	public:
 		DebugPass();
 		~DebugPass();
+		void init() override;
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 		GLW::VertexArray trianglesVAO;
 		GLW::Buffer<GLW::ARRAY_BUFFER, Utils::Triangle> trianglesVBO;
 
 		GLW::VertexArray linesVAO;
 		GLW::Buffer<GLW::ARRAY_BUFFER, Math::Vec3> linesVBO;
+
+	private:
+		ShaderModule::ShaderBase* mTrianglesShader = nullptr;
+		ShaderModule::ShaderBase* mLinesShader = nullptr;
+		ShaderModule::ShaderBase* mDepthQuadShader = nullptr;
 	};
 }
@@ -4,12 +4,14 @@
 #include "glWrapper/Buffer.h"
 #include "glWrapper/CapabilitiesStack.h"
 #include "mathModule/Utils.h"
+#include "renderModule/RenderGraph.h"
 
 namespace SFE::Render::RenderPasses {
 	GUIPass::~GUIPass() {}
 
 	void GUIPass::init() {
-		const auto shader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/2dshader.vs", "shaders/2dshader.fs");
+		mShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/2dshader.vs", "shaders/2dshader.fs");
+		const auto shader = mShader;
 
 		shader->use();
 		shader->setUniform("projection", Math::orthoRH_NO(0.0f, static_cast<float>(Engine::instance()->getWindow()->getScreenData().width), 0.f, static_cast<float>(Engine::instance()->getWindow()->getScreenData().height), -1.f, 1.f));
@@ -22,13 +24,18 @@ namespace SFE::Render::RenderPasses {
 		VBO.unbind();
 	}
 
+	void GUIPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+		graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+			.write(graph.importResource(GraphResources::BACKBUFFER, RenderGraph::ResourceType::TEXTURE, true));
+	}
+
 	void GUIPass::render(SystemsModule::RenderData& renderDataHandle) {
 		if (registry.getAllEntities().empty()) {
 			return;
 		}
 		GLW::CapabilitiesStack<GLW::DEPTH_TEST>::push(false);
 
-		const auto shader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/2dshader.vs", "shaders/2dshader.fs");
+		const auto shader = mShader;
 		shader->use();
 		
 
@@ -36,12 +36,16 @@ namespace SFE::Render::RenderPasses {
 
 		~GUIPass() override;
 		void init() override;
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 
 		static inline ecss::Registry registry;
 
 		GLW::VertexArray VAO;
 		GLW::Buffer<GLW::ARRAY_BUFFER, Vertex, GLW::DYNAMIC_DRAW> VBO;
+
+	private:
+		ShaderModule::ShaderBase* mShader = nullptr;
 	};
 }
 
@@ -5,6 +5,9 @@
 #include "assetsModule/TextureHandler.h"
 #include "assetsModule/modelModule/MeshVaoRegistry.h"
 #include "assetsModule/modelModule/ModelLoader.h"
+#include "renderModule/MaterialSystem.h"
+#include "renderModule/RenderGraphTextures.h"
+#include "renderModule/TextureStreamer.h"
 #include "renderModule/Utils.h"
 #include "assetsModule/shaderModule/ShaderController.h"
 #include "componentsModule/ArmatureComponent.h"
@@ -22,6 +25,7 @@
 #include "debugModule/Benchmark.h"
 #include "ecss/Registry.h"
 #include "logsModule/logger.h"
+#include "mathModule/MatrixOperations.h"
 #include "systemsModule/systems/CameraSystem.h"
 #include "systemsModule/systems/OcTreeSystem.h"
 #include "systemsModule/systems/RenderSystem.h"
@@ -33,10 +37,11 @@ using namespace SFE::Render::RenderPasses;
 void GeometryPass::prepare() {
 	auto curPassData = getContainer().getCurrentPassData();
 	auto outlineData = mOutlineData.getCurrentPassData();
-	curPassData->mStatus = RenderPreparingStatus::PREPARING;
+	curPassData->setStatus(RenderPreparingStatus::PREPARING);
 
 	auto& renderData = ECSHandler::getSystem<SFE::SystemsModule::RenderSystem>()->getRenderData();
-	ThreadPool::instance()->addTask<WorkerType::RENDER>([nextRegistry = renderData.nextRegistry, this, curPassData, camFrustum = renderData.mNextCamFrustum, camPos = renderData.mCameraPos, outlineData]() mutable {
+	const TextureResidency::View streamingView{ renderData.next.projection[1][1], static_cast<float>(Engine::instance()->getWindow()->getScreenData().renderH) };
+	ThreadPool::instance()->addTask<WorkerType::RENDER>([nextRegistry = renderData.nextRegistry, this, curPassData, camFrustum = renderData.mNextCamFrustum, camPos = renderData.mCameraPos, outlineData, streamingView, streaming = TextureStreamer::enabled]() mutable {
 		FUNCTION_BENCHMARK;
 		curPassData->getBatcher().clear();
 		outlineData->getBatcher().clear();
@@ -58,7 +63,7 @@ void GeometryPass::prepare() {
 		}
 
 		if (entities.empty()) {
-			curPassData->mStatus = RenderPreparingStatus::READY;
+			curPassData->setStatus(RenderPreparingStatus::READY);
 			return;
 		}
 		entities.sort();
@@ -67,6 +72,7 @@ void GeometryPass::prepare() {
 		{
 			FUNCTION_BENCHMARK_NAMED(addedToBatcher);
 			auto& batcher = curPassData->getBatcher();
+			std::vector<TextureResidency::DrawRecord> streamingDraws;
 			for (auto [ent, transform, meshComp, matComp, oclComp] : ECSHandler::drawRegistry(nextRegistry).forEach<const ComponentsModule::TransformMatComp, const MeshComponent, const MaterialComponent, const ComponentsModule::OccludedComponent>({entities}, false)) {
 				if (!meshComp) {
 					continue;
@@ -76,10 +82,31 @@ void GeometryPass::prepare() {
 				}
 
 				for (const auto& mesh : meshComp->meshGraph) {
-					batcher.addToDrawList(ent, mesh.value.vaoId, mesh.value.verticesCount, mesh.value.indicesCount, matComp ? matComp->materials : ComponentsModule::Materials{}, transform->mTransform);
+					batcher.addToDrawList(ent, mesh.value.mesh, matComp, transform->mTransform, &mesh.value.bounds);
+				}
+
+				//texture streamer needs distance to mesh and its texel density in world units for every visible texture
+				if (streaming && matComp) {
+					const auto& matrix = transform->mTransform;
+					const auto scale = std::max({ Math::length(Math::Vec3(matrix[0])), Math::length(Math::Vec3(matrix[1])), Math::length(Math::Vec3(matrix[2])), 1e-6f });
+					for (const auto& mesh : meshComp->meshGraph) {
+						const auto& bounds = mesh.value.bounds;
+						const auto center = bounds.calculateGlobalCenter(matrix);
+						const auto distance = std::max(Math::length(center - camPos) - Math::length(bounds.extents) * scale, 0.f);
+						for (uint8_t i = 0; i < matComp->materials.materialsCount; i++) {
+							const auto textureId = matComp->materials.material[i].textureId;
+							if (textureId != 0) {
+								streamingDraws.push_back({ textureId, distance, mesh.value.uvDensity / scale });
+							}
+						}
+					}
 				}
 			}
 			batcher.sort(camPos);
+
+			if (streaming) {
+				TextureStreamer::instance()->submitDraws(streamingView, std::move(streamingDraws));
+			}
 		}
 
 		{
@@ -94,13 +121,13 @@ void GeometryPass::prepare() {
 				}
 
 				for (const auto& mesh : meshComp->meshGraph) {
-					outlineBatcher.addToDrawList(entity, mesh.value.vaoId, mesh.value.verticesCount, mesh.value.indicesCount, {}, transform->mTransform);
+					outlineBatcher.addToDrawList(entity, mesh.value.mesh, nullptr, transform->mTransform);
 				}
 			}
 
 			//outlineBatcher.sort(ECSHandler::registry().getComponent<TransformComponent>(ECSHandler::getSystem<SFE::SystemsModule::CameraSystem>()->getCurrentCamera())->getPos());
 		}
-		curPassData->mStatus = RenderPreparingStatus::READY;
+		curPassData->setStatus(RenderPreparingStatus::READY);
 	});
 }
 
@@ -113,87 +140,70 @@ void GeometryPass::init() {
 	mOutlineData.init(2);
 	getContainer().init(2);
 
-	const auto w = Engine::instance()->getWindow()->getScreenData().renderW;
-	const auto h = Engine::instance()->getWindow()->getScreenData().renderH;
-
-	// position color buffer
-	mData.positionBuffer.width = w;
-	mData.positionBuffer.height = h;
-	mData.positionBuffer.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.positionBuffer.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.positionBuffer.pixelFormat = GLW::RGBA32F;
-	mData.positionBuffer.textureFormat = GLW::RGBA;
-	mData.positionBuffer.pixelType = GLW::FLOAT;
-	mData.positionBuffer.create();
-	
-	mData.normalBuffer.width = w;
-	mData.normalBuffer.height = h;
-	mData.normalBuffer.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.normalBuffer.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.normalBuffer.pixelFormat = GLW::RGBA16F;
-	mData.normalBuffer.textureFormat = GLW::RGBA;
-	mData.normalBuffer.pixelType = GLW::FLOAT;
-	mData.normalBuffer.create();
-
-	// color + specular color buffer
-	mData.albedoBuffer.width = w;
-	mData.albedoBuffer.height = h;
-	mData.albedoBuffer.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.albedoBuffer.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.albedoBuffer.pixelFormat = GLW::RGBA16F;
-	mData.albedoBuffer.textureFormat = GLW::RGBA;
-	mData.albedoBuffer.pixelType = GLW::UNSIGNED_BYTE;
-	mData.albedoBuffer.create();
-
-	// viewPos buffer
-	mData.viewPositionBuffer.width = w;
-	mData.viewPositionBuffer.height = h;
-	mData.viewPositionBuffer.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.viewPositionBuffer.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.viewPositionBuffer.pixelFormat = GLW::RGBA32F;
-	mData.viewPositionBuffer.textureFormat = GLW::RGBA;
-	mData.viewPositionBuffer.pixelType = GLW::UNSIGNED_BYTE;
-	mData.viewPositionBuffer.create();
-
-	// outline buffer
-	mData.outlinesBuffer.width = w;
-	mData.outlinesBuffer.height = h;
-	mData.outlinesBuffer.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.outlinesBuffer.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.outlinesBuffer.pixelFormat = GLW::RGBA8;
-	mData.outlinesBuffer.textureFormat = GLW::RGBA;
-	mData.outlinesBuffer.pixelType = GLW::UNSIGNED_BYTE;
-	mData.outlinesBuffer.create();
-
-	// light buffer
-	mData.lightsBuffer.width = w;
-	mData.lightsBuffer.height = h;
-	mData.lightsBuffer.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.lightsBuffer.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.lightsBuffer.pixelFormat = GLW::RGBA8;
-	mData.lightsBuffer.textureFormat = GLW::RGBA;
-	mData.lightsBuffer.pixelType = GLW::UNSIGNED_BYTE;
-	mData.lightsBuffer.create();
+	mGBufferShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/g_buffer.vs", "shaders/g_buffer.fs");
+	mGBufferOutlinesShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/g_buffer_outlines.vs", "shaders/g_buffer_outlines.fs");
+	mOutlineShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/g_outline.vs", "shaders/g_outline.fs");
+}
 
-	mData.gFramebuffer.bind();
+void GeometryPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+	const auto w = static_cast<uint32_t>(Engine::instance()->getWindow()->getScreenData().renderW);
+	const auto h = static_cast<uint32_t>(Engine::instance()->getWindow()->getScreenData().renderH);
 
-	mData.gFramebuffer.addAttachmentTexture(0, &mData.positionBuffer);
-	mData.gFramebuffer.addAttachmentTexture(1, &mData.normalBuffer);
-	mData.gFramebuffer.addAttachmentTexture(2, &mData.albedoBuffer);
-	mData.gFramebuffer.addAttachmentTexture(3, &mData.viewPositionBuffer);
-	//mData.gFramebuffer.addAttachmentTexture(4, &mData.outlinesBuffer);
-	//mData.gFramebuffer.addAttachmentTexture(5, &mData.lightsBuffer);
+	mData.compact = compactGBuffer;
+	if (mData.compact) {
+		mPosition = RenderGraph::INVALID_RESOURCE;
+		mViewPosition = RenderGraph::INVALID_RESOURCE;
+		mNormal = graph.createTexture(GraphResources::G_NORMAL, RenderGraphTextures::makeDesc(w, h, GLW::RG16));
+		mAlbedo = graph.createTexture(GraphResources::G_ALBEDO, RenderGraphTextures::makeDesc(w, h, GLW::RGBA8));
+	}
+	else {
+		mPosition = graph.createTexture(GraphResources::G_POSITION, RenderGraphTextures::makeDesc(w, h, GLW::RGBA32F));
+		mViewPosition = graph.createTexture(GraphResources::G_VIEW_POSITION, RenderGraphTextures::makeDesc(w, h, GLW::RGBA32F));
+		mNormal = graph.createTexture(GraphResources::G_NORMAL, RenderGraphTextures::makeDesc(w, h, GLW::RGBA16F));
+		mAlbedo = graph.createTexture(GraphResources::G_ALBEDO, RenderGraphTextures::makeDesc(w, h, GLW::RGBA16F));
+	}
+	mOutlines = graph.createTexture(GraphResources::G_OUTLINES, RenderGraphTextures::makeDesc(w, h, GLW::RGBA8));
+	//24 bits as default framebuffer has, so lighting pass can blit it
+	mDepth = graph.createTexture(GraphResources::G_DEPTH, RenderGraphTextures::makeDesc(w, h, GLW::DEPTH_COMPONENT24));
+
+	graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+		.write(mPosition)
+		.write(mNormal)
+		.write(mAlbedo)
+		.write(mViewPosition)
+		.write(mOutlines)
+		.read(mDepth)
+		.write(mDepth);
+}
 
-	// create and attach depth buffer (renderbuffer)
-	mData.rboDepth.generate();
-	mData.rboDepth.bind();
-	mData.rboDepth.storage(GLW::DEPTH_COMPONENT24, w, h);
+void GeometryPass::bindResources(const RenderGraphTextures& textures) {
+	mData.positionBuffer = textures.get(mPosition);
+	mData.normalBuffer = textures.get(mNormal);
+	mData.albedoBuffer = textures.get(mAlbedo);
+	mData.viewPositionBuffer = textures.get(mViewPosition);
+	mData.outlinesBuffer = textures.get(mOutlines);
+	mData.depthBuffer = textures.get(mDepth);
 
-	mData.gFramebuffer.addRenderbuffer(GLW::AttachmentType::DEPTH, mData.rboDepth.id);
+	//shaders keep the same output locations in both modes, outputs of positions are discarded in compact one
+	mData.gFramebuffer.bind();
+	mData.gFramebuffer.clearAttachments();
+	if (mData.compact) {
+		mData.gFramebuffer.skipAttachment();
+	}
+	else {
+		mData.gFramebuffer.addAttachmentTexture(0, mData.positionBuffer);
+	}
+	mData.gFramebuffer.addAttachmentTexture(1, mData.normalBuffer);
+	mData.gFramebuffer.addAttachmentTexture(2, mData.albedoBuffer);
+	if (!mData.compact) {
+		mData.gFramebuffer.addAttachmentTexture(3, mData.viewPositionBuffer);
+	}
+	mData.gFramebuffer.addAttachmentTexture(GLW::AttachmentType::DEPTH, mData.depthBuffer);
 	mData.gFramebuffer.finalize();
 
 	mData.outlineFramebuffer.bind();
-	mData.outlineFramebuffer.addAttachmentTexture(0, &mData.outlinesBuffer);
+	mData.outlineFramebuffer.clearAttachments();
+	mData.outlineFramebuffer.addAttachmentTexture(0, mData.outlinesBuffer);
 	mData.outlineFramebuffer.finalize();
 
 	GLW::Framebuffer::bindDefaultFramebuffer();
@@ -214,7 +224,7 @@ void GeometryPass::render(SystemsModule::RenderData& renderDataHandle) {
 	{
 		FUNCTION_BENCHMARK_NAMED(_wait_lock);
 		const auto curPassData = getContainer().getCurrentPassData();
-		while (curPassData->mStatus != RenderPreparingStatus::READY) {}//todo do some logic on main thread while waiting preparing
+		curPassData->waitReady();
 	}
 
 	const auto curPassData = getContainer().getCurrentPassData();
@@ -227,15 +237,20 @@ void GeometryPass::render(SystemsModule::RenderData& renderDataHandle) {
 	GLW::clear(GLW::ColorBit::DEPTH_COLOR);
 	
 	if (!curPassData->getBatcher().drawList.empty()) {
-		auto shaderGeometryPass = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/g_buffer.vs", "shaders/g_buffer.fs");
+		const auto shaderGeometryPass = mGBufferShader;
 		shaderGeometryPass->use();
 		shaderGeometryPass->setUniform<int>("texture_diffuse1", SFE::DIFFUSE);
 		shaderGeometryPass->setUniform<int>("normalMap", SFE::NORMALS);
 		shaderGeometryPass->setUniform<int>("texture_specular1", SFE::SPECULAR);
 		shaderGeometryPass->setUniform("outline", false);
+		shaderGeometryPass->setUniform("compactGBuffer", mData.compact);
+		shaderGeometryPass->setUniform("materialTable", Render::MaterialSystem::enabled);
+		shaderGeometryPass->setUniform<int>("diffuseArray", Render::MaterialSystem::DIFFUSE_ARRAY_SLOT);
+		shaderGeometryPass->setUniform<int>("normalArray", Render::MaterialSystem::NORMAL_ARRAY_SLOT);
+		shaderGeometryPass->setUniform<int>("specularArray", Render::MaterialSystem::SPECULAR_ARRAY_SLOT);
 
 		FUNCTION_BENCHMARK_NAMED(_flush)
-		curPassData->getBatcher().flushAll();
+		curPassData->getBatcher().flushAll(&renderDataHandle.mCamFrustum);
 	}
 
 	if (!outlineData->getBatcher().drawList.empty()) {
@@ -244,19 +259,20 @@ void GeometryPass::render(SystemsModule::RenderData& renderDataHandle) {
 		mData.outlineFramebuffer.bind();
 		GLW::clear(GLW::ColorBit::COLOR);
 
-		auto g_buffer_outlines = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/g_buffer_outlines.vs", "shaders/g_buffer_outlines.fs");
-		g_buffer_outlines->use();
+		mGBufferOutlinesShader->use();
 
 		outlineData->getBatcher().flushAll();
-		bindTextureToSlot(26, &mData.normalBuffer);
-		bindTextureToSlot(27, &mData.outlinesBuffer);
-		bindTextureToSlot(25, &mData.lightsBuffer);
+		bindTextureToSlot(26, mData.normalBuffer);
+		bindTextureToSlot(27, mData.outlinesBuffer);
+		bindTextureToSlot(25, mData.depthBuffer);
 
-		auto outlineG = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/g_outline.vs", "shaders/g_outline.fs");
+		const auto outlineG = mOutlineShader;
 		outlineG->use();
 		outlineG->setUniform("gDepth", 26);
 		outlineG->setUniform("gOutlinesP", 27);
-		outlineG->setUniform("gLightsP", 25);
+		outlineG->setUniform("gDepthTexture", 25);
+		outlineG->setUniform("compactGBuffer", mData.compact);
+		outlineG->setUniform("invProjection", Math::inverse(renderDataHandle.current.projection));
 
 		Utils::renderQuad();
 		GLW::Framebuffer::bindDefaultFramebuffer();
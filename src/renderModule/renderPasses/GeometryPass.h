@@ -4,9 +4,10 @@
 #include <thread>
 #include <vector>
 
+#include "assetsModule/shaderModule/ShaderBase.h"
 #include "glWrapper/Framebuffer.h"
-#include "glWrapper/Renderbuffer.h"
 #include "logsModule/logger.h"
+#include "renderModule/RenderGraph.h"
 #include "renderModule/renderPasses/RenderPass.h"
 
 class Batcher;
@@ -17,28 +18,47 @@ namespace SFE::Render::RenderPasses {
 	class GeometryPass : public RenderPassWithData {
 	public:
 		void prepare() override;
+
+		//compact g buffer has no position targets, they are reconstructed from depth, normals are octahedral encoded in RG16 and albedo is RGBA8
+		//full one keeps world and view positions in RGBA32F and normals with albedo in RGBA16F, it is read when render graph is built
+		inline static bool compactGBuffer = true;
+
 		struct Data {
 			GLW::Framebuffer gFramebuffer;
-			GLW::Texture positionBuffer{GLW::TEXTURE_2D};
-			GLW::Texture viewPositionBuffer{GLW::TEXTURE_2D};
-			GLW::Texture outlinesBuffer{GLW::TEXTURE_2D};
-			GLW::Texture lightsBuffer{GLW::TEXTURE_2D};
-			GLW::Texture normalBuffer{GLW::TEXTURE_2D};
-			GLW::Texture albedoBuffer{GLW::TEXTURE_2D};
-
-			GLW::Renderbuffer rboDepth;
+			//textures are owned by render graph, position buffers are nullptr in compact mode
+			GLW::Texture* positionBuffer = nullptr;
+			GLW::Texture* viewPositionBuffer = nullptr;
+			GLW::Texture* outlinesBuffer = nullptr;
+			GLW::Texture* normalBuffer = nullptr;
+			GLW::Texture* albedoBuffer = nullptr;
+			GLW::Texture* depthBuffer = nullptr;
+			bool compact = false;
+
 			GLW::Framebuffer outlineFramebuffer;
 		};
 
 
 		
 		void init() override;
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
+		void bindResources(const RenderGraphTextures& textures) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 	private:
 		bool mInited = false;
 		Data mData;
+
+		RenderGraph::ResourceId mPosition = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mNormal = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mAlbedo = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mViewPosition = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mOutlines = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mDepth = RenderGraph::INVALID_RESOURCE;
 		bool needClearOutlines = false;
 
+		ShaderModule::ShaderBase* mGBufferShader = nullptr;
+		ShaderModule::ShaderBase* mGBufferOutlinesShader = nullptr;
+		ShaderModule::ShaderBase* mOutlineShader = nullptr;
+
 		RenderPassRingBuffer mOutlineData;
 	};
 }
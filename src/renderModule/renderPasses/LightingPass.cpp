@@ -1,5 +1,11 @@
 ﻿#include "LightingPass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
 #include "assetsModule/TextureHandler.h"
+#include "renderModule/RenderGraph.h"
 #include "renderModule/Utils.h"
 #include "assetsModule/shaderModule/ShaderController.h"
 #include "systemsModule/systems/RenderSystem.h"
@@ -10,6 +16,8 @@
 #include "core/ECSHandler.h"
 #include "debugModule/Benchmark.h"
 #include "ecss/Registry.h"
+#include "mathModule/MatrixOperations.h"
+#include "multithreading/ThreadPool.h"
 #include "renderModule/SceneGridFloor.h"
 #include "systemsModule/SystemsPriority.h"
 
@@ -20,11 +28,129 @@ LightingPass::LightingPass() {
 
 }
 
+void LightingPass::init() {
+	mLightsBO.generate();
+	mClustersBO.generate();
+	mLightIndicesBO.generate();
+
+	mLightingShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/deferred_shading.vs", "shaders/deferred_shading.fs");
+	mSkyShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/sky.vs", "shaders/sky.fs");
+}
+
+void LightingPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+	graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+		.read(graph.findResource(GraphResources::G_POSITION))
+		.read(graph.findResource(GraphResources::G_NORMAL))
+		.read(graph.findResource(GraphResources::G_ALBEDO))
+		.read(graph.findResource(GraphResources::G_OUTLINES))
+		.read(graph.findResource(GraphResources::SSAO_BLUR))
+		.read(graph.findResource(GraphResources::G_DEPTH))
+		.read(graph.findResource(GraphResources::G_DEPTH), RenderGraph::Access::ATTACHMENT)
+		.read(graph.importResource(GraphResources::CASCADE_SHADOW_MAP))
+		.read(graph.importResource(GraphResources::POINT_SHADOW_ATLAS))
+		.write(graph.importResource(GraphResources::BACKBUFFER, RenderGraph::ResourceType::TEXTURE, true));
+}
+
+void LightingPass::updateClusters(SystemsModule::RenderData& renderDataHandle) {
+	FUNCTION_BENCHMARK;
+	renderDataHandle.mLightingPassData = &mData;
+
+	const auto& screenData = Engine::instance()->getWindow()->getScreenData();
+	mClusters.setProjection(renderDataHandle.current.projection, screenData.near, screenData.far);
+
+	mLights.clear();
+	mGpuLights.clear();
+	const auto& shadowEntities = renderDataHandle.mPointPassData->shadowEntities;
+	for (const auto& light : renderDataHandle.lights) {
+		if (light.type != ComponentsModule::eLightType::POINT) {
+			continue;
+		}
+
+		const auto& position = light.position;
+		if (!FrustumModule::Sphere::isOnFrustum(renderDataHandle.mCamFrustum, position, light.radius)) {
+			continue;
+		}
+
+		//light shadow map is rendered by point light pass, other lights are shaded without shadows
+		const auto shadowIt = std::find(shadowEntities.begin(), shadowEntities.end(), light.entity);
+		const auto shadowIdx = static_cast<int32_t>(std::distance(shadowEntities.begin(), shadowIt));
+
+		const auto& color = light.color;
+		mLights.push_back({ position, light.radius });
+		mGpuLights.push_back({
+			{ position.x, position.y, position.z }, light.radius,
+			{ color.x, color.y, color.z }, light.linear,
+			light.quadratic, shadowIt != shadowEntities.end() && shadowIdx < MAX_SHADOWED_POINT_LIGHTS ? shadowIdx : -1
+		});
+	}
+
+	const auto parallelFor = [](size_t count, const std::function<void(size_t)>& task) {
+		ThreadPool::instance()->addBatchTasks(count, 4, task).waitAll();
+	};
+	mClusters.assign(renderDataHandle.current.view, mLights, parallelFor);
+
+	mData.lightsCount = mLights.size();
+	mData.lightIndicesCount = mClusters.getLightIndices().size();
+	mData.assignmentTime = mClusters.getAssignmentTime();
+
+	//empty buffers can't be bound, so there is always at least one element
+	if (mGpuLights.empty()) {
+		mGpuLights.emplace_back();
+	}
+	const auto& indices = mClusters.getLightIndices();
+	const uint32_t emptyIndex = 0;
+
+	//data is reallocated every frame, so driver gives new storage instead of waiting while gpu reads previous one
+	mLightsBO.bind();
+	mLightsBO.allocateData(mGpuLights);
+	mLightsBO.setBufferBinding(LIGHTS_BINDING);
+
+	mClustersBO.bind();
+	mClustersBO.allocateData(mClusters.getClusters());
+	mClustersBO.setBufferBinding(CLUSTERS_BINDING);
+
+	mLightIndicesBO.bind();
+	mLightIndicesBO.allocateData(std::max<size_t>(indices.size(), 1), indices.empty() ? &emptyIndex : indices.data());
+	mLightIndicesBO.setBufferBinding(LIGHT_INDICES_BINDING);
+	mLightIndicesBO.unbind();
+
+	runBenchmark(renderDataHandle);
+}
+
+void LightingPass::runBenchmark(const SystemsModule::RenderData& renderDataHandle) {
+	if (mData.benchmarkLights <= 0) {
+		mData.benchmarkTime = 0.f;
+		return;
+	}
+
+	//lights are spread around camera with fixed seed, so results of different frames can be compared
+	if (mBenchmarkLights.size() != static_cast<size_t>(mData.benchmarkLights)) {
+		const auto range = std::min(Engine::instance()->getWindow()->getScreenData().far, 500.f);
+		std::mt19937 generator(0);
+		std::uniform_real_distribution offset(-range, range);
+		std::uniform_real_distribution radius(1.f, 20.f);
+
+		mBenchmarkLights.resize(mData.benchmarkLights);
+		for (auto& light : mBenchmarkLights) {
+			light.position = renderDataHandle.mCameraPos + Math::Vec3(offset(generator), offset(generator) * 0.25f, offset(generator));
+			light.radius = radius(generator);
+		}
+	}
+
+	const auto& screenData = Engine::instance()->getWindow()->getScreenData();
+	mBenchmarkClusters.setProjection(renderDataHandle.current.projection, screenData.near, screenData.far);
+	mBenchmarkClusters.assign(renderDataHandle.current.view, mBenchmarkLights, [](size_t count, const std::function<void(size_t)>& task) {
+		ThreadPool::instance()->addBatchTasks(count, 4, task).waitAll();
+	});
+	mData.benchmarkTime = mBenchmarkClusters.getAssignmentTime();
+}
+
 void LightingPass::render(SystemsModule::RenderData& renderDataHandle) {
 	FUNCTION_BENCHMARK;
+	updateClusters(renderDataHandle);
 	GLW::clear(GLW::ColorBit::DEPTH_COLOR);
 
-	auto shaderLightingPass = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/deferred_shading.vs", "shaders/deferred_shading.fs");
+	const auto shaderLightingPass = mLightingShader;
 
 	shaderLightingPass->use();
 	shaderLightingPass->setUniform("gPosition", 0);
@@ -33,31 +159,48 @@ void LightingPass::render(SystemsModule::RenderData& renderDataHandle) {
 	shaderLightingPass->setUniform("ssao", 3);
 	shaderLightingPass->setUniform("shadows", 4);
 	shaderLightingPass->setUniform("gOutlines", 5);
+	shaderLightingPass->setUniform("gDepthTexture", 6);
+	shaderLightingPass->setUniform("compactGBuffer", renderDataHandle.mGeometryPassData->compact);
+	shaderLightingPass->setUniform("invProjection", Math::inverse(renderDataHandle.current.projection));
+	shaderLightingPass->setUniform("invView", Math::inverse(renderDataHandle.current.view));
 
-	shaderLightingPass->setUniform("pointLightsSize", static_cast<int>(renderDataHandle.mPointPassData->shadowEntities.size()));
 	shaderLightingPass->setUniform("PointLightShadowMapArray", 30);
 
+	shaderLightingPass->setUniform("clusterView", renderDataHandle.current.view);
+	shaderLightingPass->setUniform("clusterNear", mClusters.getNear());
+	shaderLightingPass->setUniform("clusterScale", static_cast<float>(LightClusters::CLUSTERS_Z) / std::log(mClusters.getFar() / mClusters.getNear()));
+
 	shaderLightingPass->setUniform("fogStart", Engine::instance()->getWindow()->getScreenData().far * 0.9f);
 	shaderLightingPass->setUniform("screenDrawData.far", Engine::instance()->getWindow()->getScreenData().far);
 
 	int offsetSum = 0;
-	for (size_t i = 0; i < renderDataHandle.mPointPassData->shadowEntities.size(); i++) {
-		auto tc = ECSHandler::registry().getComponent<TransformComponent>(renderDataHandle.mPointPassData->shadowEntities[i]);
-		auto lightComp = ECSHandler::registry().getComponent<LightSourceComponent>(renderDataHandle.mPointPassData->shadowEntities[i]);
-
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Position").c_str(), tc->getPos(true));
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].texelSize").c_str(), Math::Vec2{lightComp->getTexelSize().x, lightComp->getTexelSize().y});
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].bias").c_str(), lightComp->getBias());
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].samples").c_str(), lightComp->getSamples());
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].radius").c_str(), lightComp->mRadius);
+	const auto& pointPassData = *renderDataHandle.mPointPassData;
+	const auto shadowedLights = std::min(pointPassData.shadowEntities.size(), static_cast<size_t>(MAX_SHADOWED_POINT_LIGHTS));
+	for (size_t i = 0; i < pointPassData.faceTiles.size() && i < MAX_SHADOWED_POINT_LIGHTS * SFE::Render::PointShadowScheduler::FACES; i++) {
+		shaderLightingPass->setUniform(("pointLightTiles[" + std::to_string(i) + "]").c_str(), pointPassData.faceTiles[i]);
+	}
+
+	for (size_t i = 0; i < shadowedLights; i++) {
+		const auto light = renderDataHandle.findLight(pointPassData.shadowEntities[i]);
+		if (!light) {
+			continue;
+		}
+
+		//filter offsets and bias are in texels of face tile
+		const auto texelSize = 1.f / static_cast<float>(pointPassData.resolutions[i]);
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Position").c_str(), light->position);
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].texelSize").c_str(), Math::Vec2{ texelSize, texelSize });
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].bias").c_str(), light->bias);
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].samples").c_str(), light->samples);
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].radius").c_str(), light->radius);
 		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].offset").c_str(), offsetSum);
 
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Color").c_str(), lightComp->getLightColor());
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Color").c_str(), light->color);
 
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Linear").c_str(), lightComp->mLinear);
-		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Quadratic").c_str(), lightComp->mQuadratic);
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Linear").c_str(), light->linear);
+		shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Quadratic").c_str(), light->quadratic);
 
-		if (lightComp->getType() == ComponentsModule::eLightType::POINT) {
+		if (light->type == ComponentsModule::eLightType::POINT) {
 			shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Type").c_str(), 0);
 			shaderLightingPass->setUniform(("pointLight[" + std::to_string(i) + "].Layers").c_str(), 6);
 		}
@@ -67,7 +210,7 @@ void LightingPass::render(SystemsModule::RenderData& renderDataHandle) {
 		}
 
 
-		offsetSum += lightComp->getTypeOffset(lightComp->getType());
+		offsetSum += LightSourceComponent::getTypeOffset(light->type);
 	}
 
 	if (!renderDataHandle.mCascadedShadowsPassData->shadowCascadeLevels.empty()) {
@@ -94,11 +237,14 @@ void LightingPass::render(SystemsModule::RenderData& renderDataHandle) {
 	// set light uniforms
 	shaderLightingPass->setUniform("viewPos", renderDataHandle.mCameraPos);
 
-	GLW::bindTextureToSlot(0, &renderDataHandle.mGeometryPassData->positionBuffer);
-	GLW::bindTextureToSlot(1, &renderDataHandle.mGeometryPassData->normalBuffer);
-	GLW::bindTextureToSlot(2, &renderDataHandle.mGeometryPassData->albedoBuffer);
-	GLW::bindTextureToSlot(3, &renderDataHandle.mSSAOPassData->mSsaoColorBufferBlur);
-	GLW::bindTextureToSlot(5, &renderDataHandle.mGeometryPassData->outlinesBuffer);
+	if (renderDataHandle.mGeometryPassData->positionBuffer) {
+		GLW::bindTextureToSlot(0, renderDataHandle.mGeometryPassData->positionBuffer);
+	}
+	GLW::bindTextureToSlot(1, renderDataHandle.mGeometryPassData->normalBuffer);
+	GLW::bindTextureToSlot(2, renderDataHandle.mGeometryPassData->albedoBuffer);
+	GLW::bindTextureToSlot(3, renderDataHandle.mSSAOPassData->mSsaoColorBufferBlur);
+	GLW::bindTextureToSlot(5, renderDataHandle.mGeometryPassData->outlinesBuffer);
+	GLW::bindTextureToSlot(6, renderDataHandle.mGeometryPassData->depthBuffer);
 
 	Utils::renderQuad();
 
@@ -161,7 +307,7 @@ void LightingPass::render(SystemsModule::RenderData& renderDataHandle) {
 
 
 		if (enableSky) {
-			auto sky = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/sky.vs", "shaders/sky.fs");
+			const auto sky = mSkyShader;
 			sky->use();
 			sky->setUniform("view", renderDataHandle.current.view);
 			sky->setUniform("projection", renderDataHandle.current.projection);
@@ -1,12 +1,66 @@
 ﻿#pragma once
+#include <vector>
+
+#include "assetsModule/shaderModule/ShaderBase.h"
+#include "glWrapper/Buffer.h"
+#include "renderModule/LightClusters.h"
 #include "renderModule/renderPasses/RenderPass.h"
 
 namespace SFE::Render::RenderPasses {
 	class LightingPass : public RenderPass {
 	public:
+		struct Data {
+			size_t lightsCount = 0;
+			size_t lightIndicesCount = 0;
+			float assignmentTime = 0.f;
+
+			//synthetic lights which are only assigned to clusters to measure assignment time, they are not drawn
+			int benchmarkLights = 0;
+			float benchmarkTime = 0.f;
+		};
+
+		//the same as MAX_POINT_LIGHTS_SIZE in deferred_shading.fs
+		constexpr static int MAX_SHADOWED_POINT_LIGHTS = 6;
+
+		constexpr static int LIGHTS_BINDING = 20;
+		constexpr static int CLUSTERS_BINDING = 21;
+		constexpr static int LIGHT_INDICES_BINDING = 22;
+
 		LightingPass();
+		void init() override;
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 	private:
+		//std430 layout of ClusterLight in deferred_shading.fs
+		struct GpuLight {
+			float position[3];
+			float radius;
+			float color[3];
+			float linear;
+			float quadratic;
+			int32_t shadowIdx; //index in pointLight uniforms, -1 for light without shadows
+			int32_t padding[2];
+		};
+		static_assert(sizeof(GpuLight) == 48);
+
+		void updateClusters(SystemsModule::RenderData& renderDataHandle);
+		void runBenchmark(const SystemsModule::RenderData& renderDataHandle);
+
 		bool skyParams = false;
+
+		LightClusters mClusters;
+		LightClusters mBenchmarkClusters;
+		std::vector<LightClusters::Light> mLights;
+		std::vector<LightClusters::Light> mBenchmarkLights;
+		std::vector<GpuLight> mGpuLights;
+
+		GLW::ShaderStorageBuffer<GpuLight, GLW::DYNAMIC_DRAW> mLightsBO;
+		GLW::ShaderStorageBuffer<LightClusters::Cluster, GLW::DYNAMIC_DRAW> mClustersBO;
+		GLW::ShaderStorageBuffer<uint32_t, GLW::DYNAMIC_DRAW> mLightIndicesBO;
+
+		ShaderModule::ShaderBase* mLightingShader = nullptr;
+		ShaderModule::ShaderBase* mSkyShader = nullptr;
+
+		Data mData;
 	};
 }
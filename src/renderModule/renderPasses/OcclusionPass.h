@@ -1,19 +1,19 @@
 ﻿#pragma once
 #include "RenderPass.h"
 #include "core/Engine.h"
-#include "glWrapper/Framebuffer.h"
+#include "renderModule/SoftwareOcclusion.h"
 
 namespace SFE::Render::RenderPasses {
+	//occluders are rasterized on cpu, so OccludedComponent is ready before geometry and shadows are batched
 	class OcclusionPass : public RenderPass {
 	public:
 		~OcclusionPass() override;
 		void init() override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 
-		GLW::Framebuffer occlusionFrameBuffer;
-		GLW::Texture depthTex;
+		bool enabled = true;
 
-		const float w = Engine::instance()->getWindow()->getScreenData().renderW / 16.f;
-		const float h = Engine::instance()->getWindow()->getScreenData().renderH / 16.f;
+	private:
+		SoftwareOcclusion mOcclusion;
 	};
 }
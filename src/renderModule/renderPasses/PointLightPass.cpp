@@ -1,40 +1,44 @@
 ﻿#include "PointLightPass.h"
 
-#include <shared_mutex>
+#include <algorithm>
 
 #include "assetsModule/shaderModule/ShaderController.h"
-#include "componentsModule/CameraComponent.h"
-#include "componentsModule/CascadeShadowComponent.h"
-#include "componentsModule/IsDrawableComponent.h"
 #include "componentsModule/LightSourceComponent.h"
-#include "componentsModule/ModelComponent.h"
+#include "componentsModule/MeshComponent.h"
+#include "componentsModule/OcclusionComponent.h"
 #include "componentsModule/TransformComponent.h"
+#include "containersModule/Vector.h"
 #include "core/ECSHandler.h"
+#include "core/Engine.h"
 #include "debugModule/Benchmark.h"
 #include "ecss/Registry.h"
 #include "glWrapper/ViewportStack.h"
+#include "renderModule/RenderGraph.h"
 
-#include "logsModule/logger.h"
-#include "systemsModule/systems/CameraSystem.h"
 #include "systemsModule/systems/OcTreeSystem.h"
 #include "systemsModule/systems/RenderSystem.h"
-#include "systemsModule/SystemManager.h"
-#include "systemsModule/SystemsPriority.h"
 
 namespace SFE::Render::RenderPasses {
 	void PointLightPass::init() {
 		lightProjection = SFE::MathModule::PerspectiveProjection(90.f, 1.f, 0.01f, 100);
 		freeBuffers();
 
+		auto settings = mScheduler.getSettings();
+		settings.pageSize = ATLAS_PAGE_SIZE;
+		settings.pagesCount = ATLAS_PAGES;
+		settings.maxShadowedLights = std::min(settings.maxShadowedLights, MAX_SHADOWED_LIGHTS);
+		mScheduler.setSettings(settings);
+		data.settings = mScheduler.getSettings();
+
 		mLightDepthMaps.parameters.minFilter = GLW::TextureMinFilter::LINEAR;
 		mLightDepthMaps.parameters.magFilter = GLW::TextureMagFilter::LINEAR;
 		mLightDepthMaps.parameters.wrap.S = GLW::TextureWrap::CLAMP_TO_EDGE;
 		mLightDepthMaps.parameters.wrap.T = GLW::TextureWrap::CLAMP_TO_EDGE;
 		mLightDepthMaps.parameters.compareMode = GLW::TextureCompareMode::COMPARE_REF_TO_TEXTURE;
 		mLightDepthMaps.parameters.compareFunc = GLW::CompareFunc::LESS;
-		mLightDepthMaps.width = shadowResolution;
-		mLightDepthMaps.height = shadowResolution;
-		mLightDepthMaps.depth = maxShadowFaces;
+		mLightDepthMaps.width = ATLAS_PAGE_SIZE;
+		mLightDepthMaps.height = ATLAS_PAGE_SIZE;
+		mLightDepthMaps.depth = ATLAS_PAGES;
 		mLightDepthMaps.pixelFormat = GLW::DEPTH_COMPONENT32;
 		mLightDepthMaps.textureFormat = GLW::DEPTH_COMPONENT;
 		mLightDepthMaps.pixelType = GLW::FLOAT;
@@ -49,142 +53,233 @@ namespace SFE::Render::RenderPasses {
 
 		auto guard = mMatricesUBO.lock();
 		mMatricesUBO.generate();
-		mMatricesUBO.reserve(maxShadowFaces);
+		mMatricesUBO.reserve(MAX_SHADOWED_LIGHTS * PointShadowScheduler::FACES);
 		mMatricesUBO.setBufferBinding(lightMatricesBinding);
 
 		GLW::Framebuffer::bindDefaultFramebuffer();
+
+		mDepthShader = SHADER_CONTROLLER->loadGeometryShader("shaders/cascadeShadowMap.vs", "shaders/cascadeShadowMap.fs", "shaders/pointLightMap.gs");
 	}
 
 	void PointLightPass::freeBuffers() const {
 	}
 
+	void PointLightPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+		graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+			.write(graph.importResource(GraphResources::POINT_SHADOW_ATLAS));
+	}
+
 	void PointLightPass::render(SystemsModule::RenderData& renderDataHandle) {
 		FUNCTION_BENCHMARK
-		lightMatrices.clear();
-		frustums.clear();
 		renderDataHandle.mPointPassData = &data;
-		data.shadowEntities.clear();
 
-		offsets.clear();
-		
-		for (const auto& [entity,lightSource, transform] : ECSHandler::registry().forEach<LightSourceComponent, TransformComponent>()) {
-			//todo check is light side frustum in camera frustum, and filter it to ignore light sources which is not on your screen
-			if (!FrustumModule::SquareAABB::isOnFrustum(renderDataHandle.mCamFrustum, transform->getPos(true), lightSource->mRadius)) {
+		//atlas layout is fixed by texture, other settings can be changed from debug window
+		data.settings.pageSize = ATLAS_PAGE_SIZE;
+		data.settings.pagesCount = ATLAS_PAGES;
+		data.settings.maxShadowedLights = std::min(data.settings.maxShadowedLights, MAX_SHADOWED_LIGHTS);
+		if (!(data.settings == mScheduler.getSettings())) {
+			mScheduler.setSettings(data.settings);
+			data.settings = mScheduler.getSettings();
+		}
+
+		mLights.clear();
+		for (const auto& light : renderDataHandle.lights) {
+			if (light.type != ComponentsModule::eLightType::POINT) {
+				continue;
+			}
+
+			if (!FrustumModule::Sphere::isOnFrustum(renderDataHandle.mCamFrustum, light.position, light.radius)) {
 				continue;
 			}
 
-			//todo some dirty logic
-			switch (lightSource->getType()) {
-			case ComponentsModule::eLightType::DIRECTIONAL: {
-				/*float shadowHeight = 100.f;
-				float shadowWidth = 100.f;
-				SFE::MathModule::OrthoProjection proj = SFE::MathModule::OrthoProjection({ -shadowWidth * 0.5f, -shadowHeight * 0.5f }, { shadowWidth * 0.5f, shadowHeight * 0.5f }, 0.01f, lightSource.mRadius);
+			mLights.push_back({ light.entity, light.position, light.radius, false });
+		}
+
+		markChangedCasters(renderDataHandle);
+
+		const auto& screenData = Engine::instance()->getWindow()->getScreenData();
+		const PointShadowScheduler::View view{ renderDataHandle.mCameraPos, renderDataHandle.current.projection[1][1], static_cast<float>(screenData.renderH) };
+		const auto& updates = mScheduler.update(view, mLights);
+
+		if (!updates.empty()) {
+			renderFaces(updates, renderDataHandle);
+		}
+
+		updateData();
+
+		GLW::bindTextureToSlot(30, &mLightDepthMaps);
+	}
+
+	void PointLightPass::markChangedCasters(const SystemsModule::RenderData& renderDataHandle) {
+		if (renderDataHandle.changedCasters.empty()) {
+			return;
+		}
+
+		FUNCTION_BENCHMARK;
+		std::unordered_map<ecss::EntityId, size_t> lightsIndices;
+		std::vector<FrustumModule::Frustum> lightBoxes;
+		lightBoxes.reserve(mLights.size());
+		for (size_t i = 0; i < mLights.size(); i++) {
+			const auto& light = mLights[i];
+			lightsIndices.emplace(light.id, i);
 
-				lightMatrices.push_back(proj.getProjectionsMatrix() * owner->getComponent<TransformComponent>()->getViewMatrix());
-				frustums.push_back(SFE::FrustumModule::createFrustum(lightMatrices.back()));*/
-				break;
+			const auto box = SFE::MathModule::OrthoProjection({ -light.radius, -light.radius }, { light.radius, light.radius }, -light.radius, light.radius);
+			lightBoxes.push_back(FrustumModule::createFrustum(box.getProjectionsMatrix() * Math::translate(Math::Mat4(1.f), -light.position)));
+		}
+
+		const auto markLight = [this, &lightsIndices](ecss::EntityId light) {
+			if (const auto it = lightsIndices.find(light); it != lightsIndices.end()) {
+				mLights[it->second].castersChanged = true;
 			}
-			case ComponentsModule::eLightType::POINT: {
-				data.shadowEntities.push_back(entity);
-				offsets.emplace_back(entity, lightSource->getTypeOffset(lightSource->getType()));
-				
-				fillMatrix(transform->getPos(true), lightSource->mNear, lightSource->mRadius);
-				break;
+		};
+
+		SFE::Vector<ecss::EntityId> changedCasters;
+		changedCasters.assign(renderDataHandle.changedCasters.begin(), renderDataHandle.changedCasters.end());
+		changedCasters.sort();
+		changedCasters.removeDuplicatesSorted();
+
+		for (auto [ent, transform, meshComp] : ECSHandler::drawRegistry(renderDataHandle.currentRegistry).forEach<const ComponentsModule::TransformMatComp, const MeshComponent>({ changedCasters }, false)) {
+			if (!transform || !meshComp) {
+				continue;
 			}
-			case ComponentsModule::eLightType::PERSPECTIVE: {
-				//lightProjection.setFar(lightSource.mRadius);//here possible some fov settings
-				//lightMatrices.push_back(lightProjection.getProjectionsMatrix() * owner->getComponent<TransformComponent>()->getViewMatrix());
-				//frustums.push_back(SFE::FrustumModule::createFrustum(lightMatrices.back()));
-				break;
+
+			//caster which has left light radius still is in its shadow map
+			auto& touchedLights = mCasterLights[ent];
+			for (const auto light : touchedLights) {
+				markLight(light);
 			}
-			default:;
+			touchedLights.clear();
+
+			for (size_t i = 0; i < mLights.size(); i++) {
+				for (const auto& mesh : meshComp->meshGraph) {
+					if (mesh.value.bounds.isOnFrustum(lightBoxes[i], transform->mTransform)) {
+						mLights[i].castersChanged = true;
+						touchedLights.push_back(mLights[i].id);
+						break;
+					}
+				}
 			}
-		}
 
-		if (offsets.empty()) {
-			return;
+			if (touchedLights.empty()) {
+				mCasterLights.erase(ent);
+			}
 		}
+	}
 
-		if (!lightMatrices.empty()) {
-			auto guard = mMatricesUBO.lock();
-			mMatricesUBO.setData(lightMatrices);
-		}
+	void PointLightPass::renderFaces(const std::vector<PointShadowScheduler::FaceUpdate>& updates, const SystemsModule::RenderData& renderDataHandle) {
+		FUNCTION_BENCHMARK;
 
-		GLW::bindTextureToSlot(30, &mLightDepthMaps);
 		lightFramebuffer.bind();
-		GLW::ViewportStack::push({ {shadowResolution, shadowResolution} });
-		GLW::clear(GLW::ColorBit::DEPTH);
-
-		int offsetSum = 0;
-		for (auto& offset : offsets) {
-			auto simpleDepthShader = SHADER_CONTROLLER->loadGeometryShader("shaders/cascadeShadowMap.vs", "shaders/cascadeShadowMap.fs", "shaders/pointLightMap.gs");
-			simpleDepthShader->use();
-			simpleDepthShader->setUniform("offset", offsetSum);
-
-			auto ocTreeSystem = ECSHandler::getSystem<SystemsModule::OcTreeSystem>();
-			ocTreeSystem->readLock();
-
-			std::vector<ecss::SectorId> entities;
- 
-			for (auto& [coords, tree] : ocTreeSystem->mOctrees) {
-				auto lock = tree.readLock();
-				tree.forEachObject([this, &entities, offsetSum, &offset](const auto& obj) {
-					for (auto i = offsetSum; i < offset.second + offsetSum; i++) {
-						if (FrustumModule::AABB::isOnFrustum(frustums[i], obj.pos + SFE::Math::Vec3(obj.size.x, -obj.size.y, obj.size.z) * 0.5f, obj.size)){
-							entities.emplace_back(obj.data);
-							break;
-						}
-					}
-						
-					
-					
-				}, [this, offsetSum, &offset](const SFE::Math::Vec3& pos, float size, auto&) {
-					for (auto i = offsetSum; i < offset.second + offsetSum; i++) {
-						if (OcTree<ecss::EntityId>::isOnFrustum(frustums[i], pos, size)) {
-							return true;
-						}
+		const auto simpleDepthShader = mDepthShader;
+		simpleDepthShader->use();
+
+		const auto octreeSys = ECSHandler::getSystem<SystemsModule::OcTreeSystem>();
+		const float clearDepth = 1.f;
+
+		for (const auto& update : updates) {
+			const auto lightIt = std::find_if(mLights.begin(), mLights.end(), [&update](const PointShadowScheduler::Light& light) { return light.id == update.id; });
+			const auto lightSource = renderDataHandle.findLight(update.id);
+			if (lightIt == mLights.end() || !lightSource) {
+				continue;
+			}
+
+			const auto matrix = getFaceMatrix(lightIt->position, lightSource->nearPlane, lightIt->radius, update.face);
+			mFaceMatrices[update.id][update.face] = matrix;
+			const auto frustum = FrustumModule::createFrustum(matrix);
+
+			const auto& tile = update.tile;
+			glClearTexSubImage(mLightDepthMaps.mId, 0, static_cast<GLint>(tile.x), static_cast<GLint>(tile.y), static_cast<GLint>(tile.page), static_cast<GLsizei>(tile.size), static_cast<GLsizei>(tile.size), 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+
+			SFE::Vector<ecss::EntityId> entities;
+			{
+				FUNCTION_BENCHMARK_NAMED(octree);
+				for (auto& treePos : octreeSys->getAABBOctrees(frustum.generateAABB())) {
+					if (const auto tree = octreeSys->getOctree(treePos)) {
+						auto lock = tree->readLock();
+						tree->forEachObjectInFrustum(frustum, [&](const auto& obj, bool entirely) {
+							if (entirely || FrustumModule::AABB::isOnFrustum(frustum, obj.pos, obj.size)) {
+								entities.emplace_back(obj.data);
+							}
+						});
 					}
-					return false;
-				});
+				}
 			}
 
-			/*std::sort(entities.begin(), entities.end());
-			for (const auto& [entity, mod, draw, trans  ] : ECSHandler::registry().forEach<const ModelComponent, const IsDrawableComponent, const TransformComponent>(entities)) {
-				if (!trans || !mod || !draw) {
+			if (entities.empty()) {
+				continue;
+			}
+			entities.sort();
+			entities.removeDuplicatesSorted();
+
+			mBatcher.clear();
+			for (auto [ent, transform, meshComp, oclComp] : ECSHandler::drawRegistry(renderDataHandle.currentRegistry).forEach<const ComponentsModule::TransformMatComp, const MeshComponent, const ComponentsModule::OccludedComponent>({ entities }, false)) {
+				if (!transform || !meshComp) {
+					continue;
+				}
+				if (oclComp && oclComp->occluded) {
 					continue;
 				}
 
-				const auto& transformMatrix = trans->getTransform();
-				for (auto& mesh : mod->getModelLowestDetails().meshes) {
-					batcher.addToDrawList(mesh->getVAO(), mesh->mData.vertices.size(), mesh->mData.indices.size(), mesh->mMaterial, transformMatrix, {});
+				for (const auto& mesh : meshComp->meshGraph) {
+					mBatcher.addToDrawList(ent, mesh.value.mesh, nullptr, transform->mTransform, &mesh.value.bounds);
 				}
 			}
-			batcher.sort(ECSHandler::registry().getComponent<TransformComponent>(offset.first)->getPos(true));
+			mBatcher.sort(lightIt->position);
 
-			offsetSum += offset.second;
-			
-			batcher.flushAll(true);*/
+			//tile is the viewport, so clipping by face frustum keeps triangles inside of it
+			simpleDepthShader->setUniform("lightSpaceMatrix", matrix);
+			simpleDepthShader->setUniform("layer", static_cast<int>(tile.page));
+			GLW::ViewportStack::push({ { static_cast<int>(tile.size), static_cast<int>(tile.size) }, { static_cast<int>(tile.x), static_cast<int>(tile.y) } });
+			mBatcher.flushAll(&frustum);
+			GLW::ViewportStack::pop();
 		}
 
 		GLW::Framebuffer::bindDefaultFramebuffer();
-		GLW::ViewportStack::pop();
 	}
 
-	void PointLightPass::fillMatrix(Math::Vec3 globalLightPos, float lightNear, float lightRadius) {
-		lightProjection.setNearFar(lightNear, lightRadius);
+	void PointLightPass::updateData() {
+		const auto& shadows = mScheduler.getShadows();
+		const auto pageSize = static_cast<float>(ATLAS_PAGE_SIZE);
 
-		const auto transform = Math::translate(Math::Mat4(1.0f), globalLightPos);
+		data.shadowEntities.clear();
+		data.faceTiles.clear();
+		data.resolutions.clear();
+		data.stats = mScheduler.getStats();
 
-		for (auto angle : { 0.f, 90.f, -90.f, 180.f }) {
-			//todo rotate matrix instead creating rotated copy
-			lightMatrices.push_back(lightProjection.getProjectionsMatrix() * Math::inverse(Math::rotate(transform, Math::radians(angle), { 0.f,1.f,0.f })));
-			frustums.push_back(SFE::FrustumModule::createFrustum(lightMatrices.back()));
+		std::vector<Math::Mat4> lightMatrices;
+		for (const auto& shadow : shadows) {
+			const auto matricesIt = mFaceMatrices.find(shadow.id);
+			if (matricesIt == mFaceMatrices.end() || data.shadowEntities.size() >= MAX_SHADOWED_LIGHTS) {
+				continue;
+			}
+
+			data.shadowEntities.push_back(shadow.id);
+			data.resolutions.push_back(shadow.resolution);
+			for (const auto& tile : shadow.faces) {
+				data.faceTiles.emplace_back(static_cast<float>(tile.x) / pageSize, static_cast<float>(tile.y) / pageSize, static_cast<float>(tile.size) / pageSize, static_cast<float>(tile.page));
+			}
+			lightMatrices.insert(lightMatrices.end(), matricesIt->second.begin(), matricesIt->second.end());
 		}
 
-		for (auto angle : { 90.f, -90.f }) {
-			auto res = Math::rotate(transform, Math::radians(angle), { 1.f,0.f,0.f });
-			lightMatrices.push_back(lightProjection.getProjectionsMatrix() * Math::inverse(res));
-			frustums.push_back(SFE::FrustumModule::createFrustum(lightMatrices.back()));
+		//matrices of lights which are forgotten by scheduler are not needed anymore
+		std::erase_if(mFaceMatrices, [this](const auto& matrices) {
+			return !mScheduler.isKnown(matrices.first);
+		});
+
+		if (!lightMatrices.empty()) {
+			auto guard = mMatricesUBO.lock();
+			mMatricesUBO.setData(lightMatrices);
 		}
 	}
+
+	Math::Mat4 PointLightPass::getFaceMatrix(const Math::Vec3& globalLightPos, float lightNear, float lightRadius, uint32_t face) {
+		lightProjection.setNearFar(lightNear, lightRadius);
+
+		const auto transform = Math::translate(Math::Mat4(1.0f), globalLightPos);
+
+		//faces order is +0, +90, -90, +180 degrees around y, then +90 and -90 degrees around x
+		constexpr float angles[] = { 0.f, 90.f, -90.f, 180.f, 90.f, -90.f };
+		const auto axis = face < 4 ? Math::Vec3{ 0.f, 1.f, 0.f } : Math::Vec3{ 1.f, 0.f, 0.f };
+		return lightProjection.getProjectionsMatrix() * Math::inverse(Math::rotate(transform, Math::radians(angles[face]), axis));
+	}
 }
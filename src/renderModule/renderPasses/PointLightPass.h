@@ -1,38 +1,68 @@
 ﻿#pragma once
+#include <array>
 #include <limits>
+#include <unordered_map>
 
 #include "assetsModule/modelModule/BoundingVolume.h"
+#include "assetsModule/shaderModule/ShaderBase.h"
 #include "mathModule/Projection.h"
 #include "ecss/Types.h"
 #include "glWrapper/Buffer.h"
 #include "glWrapper/Framebuffer.h"
+#include "renderModule/Batcher.h"
+#include "renderModule/PointShadowScheduler.h"
 #include "renderModule/renderPasses/RenderPass.h"
 
 namespace SFE::Render::RenderPasses {
+	//cube faces of point lights are tiles of shadow atlas, scheduler picks their resolution and which of them are rendered this frame
+	//face is rendered again only when light or some caster inside of its radius was changed, other faces are kept from previous frames
 	class PointLightPass : public RenderPass {
 	public:
+		//size of uniform arrays in lighting shader
+		constexpr static uint32_t MAX_SHADOWED_LIGHTS = 6;
+		constexpr static uint32_t ATLAS_PAGE_SIZE = 4096;
+		constexpr static uint32_t ATLAS_PAGES = 3;
+
 		struct Data {
+			//lights which all faces are rendered, sorted by size on screen
 			std::vector<ecss::SectorId> shadowEntities;
+			//PointShadowScheduler::FACES per shadow entity, xy - tile offset in page uv, z - tile size in page uv, w - page
+			std::vector<Math::Vec4> faceTiles;
+			std::vector<uint32_t> resolutions;
+
+			PointShadowScheduler::Stats stats;
+			//applied on the next frame, page size and count are fixed by atlas texture
+			PointShadowScheduler::Settings settings;
 		};
 
 		void init() override;
 		void freeBuffers() const;
 
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 	private:
+		void markChangedCasters(const SystemsModule::RenderData& renderDataHandle);
+		void renderFaces(const std::vector<PointShadowScheduler::FaceUpdate>& updates, const SystemsModule::RenderData& renderDataHandle);
+		void updateData();
+
+		Math::Mat4 getFaceMatrix(const Math::Vec3& globalLightPos, float lightNear, float lightRadius, uint32_t face);
+
 		GLW::Framebuffer lightFramebuffer;
+		ShaderModule::ShaderBase* mDepthShader = nullptr;
 		GLW::Texture mLightDepthMaps{GLW::TEXTURE_2D_ARRAY};
 
 		GLW::Buffer<GLW::UNIFORM_BUFFER, Math::Mat4, GLW::DYNAMIC_DRAW> mMatricesUBO;
 
-		void fillMatrix(Math::Vec3 globalLightPos, float lightNear, float lightRadius);
 		SFE::MathModule::PerspectiveProjection lightProjection;
-		std::vector<Math::Mat4> lightMatrices;
-		std::vector<FrustumModule::Frustum> frustums;
-		std::vector<std::pair<ecss::SectorId, int>> offsets;
 
-		const int shadowResolution = 1024;
-		const int maxShadowFaces = 36;
+		PointShadowScheduler mScheduler;
+		std::vector<PointShadowScheduler::Light> mLights;
+		//matrices which faces were rendered with, they are sampled until face is rendered again
+		std::unordered_map<ecss::EntityId, std::array<Math::Mat4, PointShadowScheduler::FACES>> mFaceMatrices;
+		//lights which radius moved caster touched last time, so its leaving makes them dirty too
+		std::unordered_map<ecss::EntityId, std::vector<ecss::EntityId>> mCasterLights;
+		Batcher mBatcher;
+
 		const int lightMatricesBinding = 3;
 
 		Data data{};
@@ -1,7 +1,13 @@
 ﻿#include "RenderPass.h"
 
+#include "renderModule/RenderGraph.h"
+
 using namespace SFE::Render;
 
+void RenderPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+	graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); }).sideEffect();
+}
+
 void RenderPass::setPriority(size_t priority) {
 	mPriority = priority;
 }
@@ -9,3 +15,11 @@ void RenderPass::setPriority(size_t priority) {
 size_t RenderPass::getPriority() const {
 	return mPriority;
 }
+
+void RenderPass::setName(const std::string& name) {
+	mName = name;
+}
+
+const std::string& RenderPass::getName() const {
+	return mName;
+}
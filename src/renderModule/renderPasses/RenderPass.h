@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <future>
+#include <string>
 #include <vector>
 
 #include "renderModule/Batcher.h"
@@ -12,6 +13,23 @@ namespace SFE {
 
 namespace SFE::Render {
 	class Renderer;
+	class RenderGraph;
+	class RenderGraphTextures;
+
+	//names of render graph resources which are shared between passes
+	namespace GraphResources {
+		inline constexpr auto BACKBUFFER = "backbuffer";
+		inline constexpr auto G_POSITION = "gPosition";
+		inline constexpr auto G_NORMAL = "gNormal";
+		inline constexpr auto G_ALBEDO = "gAlbedo";
+		inline constexpr auto G_VIEW_POSITION = "gViewPosition"; //only in full g buffer, as G_POSITION
+		inline constexpr auto G_OUTLINES = "gOutlines";
+		inline constexpr auto G_DEPTH = "gDepth";
+		inline constexpr auto SSAO = "ssao";
+		inline constexpr auto SSAO_BLUR = "ssaoBlur";
+		inline constexpr auto CASCADE_SHADOW_MAP = "cascadeShadowMap";
+		inline constexpr auto POINT_SHADOW_ATLAS = "pointShadowAtlas";
+	}
 
 	enum class RenderPreparingStatus {
 		NONE,
@@ -23,6 +41,21 @@ namespace SFE::Render {
 	public:
 		virtual ~RenderPassData() = default;
 		Batcher& getBatcher() { return mBatcher; }
+
+		void setStatus(RenderPreparingStatus status) {
+			mStatus.store(status, std::memory_order_release);
+			mStatus.notify_all();
+		}
+
+		//sleeps until prepare task is finished instead of spinning
+		void waitReady() const {
+			auto status = mStatus.load(std::memory_order_acquire);
+			while (status != RenderPreparingStatus::READY) {
+				mStatus.wait(status, std::memory_order_acquire);
+				status = mStatus.load(std::memory_order_acquire);
+			}
+		}
+
 		std::atomic<RenderPreparingStatus> mStatus = RenderPreparingStatus::READY; //default status is ready for passes without render data
 
 	private:
@@ -34,11 +67,18 @@ namespace SFE::Render {
 		virtual ~RenderPass() = default;
 		virtual void render(SystemsModule::RenderData& renderDataHandle) = 0;
 		virtual void init() {}
+		//declares resources which pass reads and writes, default pass has side effects, so it is never culled and keeps priority order
+		virtual void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle);
+		//called after graph is compiled and its textures are created
+		virtual void bindResources(const RenderGraphTextures& textures) {}
 		void setPriority(size_t priority);
 		size_t getPriority() const;
+		void setName(const std::string& name);
+		const std::string& getName() const;
 
 	private:
 		size_t mPriority = 0;
+		std::string mName;
 	};
 
 	class RenderPassRingBuffer {
@@ -1,56 +1,133 @@
 ﻿#include "SSAOPass.h"
 
+#include <bit>
 #include <random>
 #include <gtc/random.hpp>
 
 #include "imgui.h"
 #include "assetsModule/TextureHandler.h"
+#include "renderModule/RenderGraphTextures.h"
 #include "renderModule/Utils.h"
 #include "assetsModule/shaderModule/ShaderController.h"
+#include "core/ECSHandler.h"
 #include "debugModule/Benchmark.h"
+#include "glWrapper/ViewportStack.h"
 #include "logsModule/logger.h"
+#include "mathModule/MatrixOperations.h"
 #include "systemsModule/systems/RenderSystem.h"
 #include "systemsModule/SystemsPriority.h"
 
 using namespace SFE::Render::RenderPasses;
 
+namespace {
+	constexpr auto SSAO_DEPTH_NORMAL_HALF = "ssaoDepthNormalHalf";
+	constexpr auto SSAO_DEPTH_NORMAL_QUARTER = "ssaoDepthNormalQuarter";
+	constexpr auto SSAO_LOW_BLUR = "ssaoLowBlur";
+	constexpr auto SSAO_HISTORY = "ssaoHistory";
+}
+
 float lerp(float a, float b, float f) {
 	return a + f * (b - a);
 }
 
-void SSAOPass::init() {
-	
-	mData.mSsaoFbo.bind();
+void SSAOPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+	const auto w = static_cast<uint32_t>(Engine::instance()->getWindow()->getScreenData().renderW);
+	const auto h = static_cast<uint32_t>(Engine::instance()->getWindow()->getScreenData().renderH);
+
+	mBuiltResolution = mData.resolution;
+	const auto divider = static_cast<uint32_t>(mBuiltResolution);
+	const auto levels = static_cast<uint32_t>(std::countr_zero(divider));
+	const auto aoW = std::max(w / divider, 1u);
+	const auto aoH = std::max(h / divider, 1u);
+
+	//every level is twice smaller than previous one, ao uses the last one
+	const char* levelNames[] = { SSAO_DEPTH_NORMAL_HALF, SSAO_DEPTH_NORMAL_QUARTER };
+	for (uint32_t level = 0; level < mDepthNormal.size(); level++) {
+		mDepthNormal[level] = level < levels ? graph.createTexture(levelNames[level], RenderGraphTextures::makeDesc(std::max(w >> (level + 1), 1u), std::max(h >> (level + 1), 1u), GLW::RGBA16F)) : RenderGraph::INVALID_RESOURCE;
+	}
+
+	mSsao = graph.createTexture(GraphResources::SSAO, RenderGraphTextures::makeDesc(aoW, aoH, GLW::R8));
+	mSsaoLowBlur = levels ? graph.createTexture(SSAO_LOW_BLUR, RenderGraphTextures::makeDesc(aoW, aoH, GLW::R8)) : RenderGraph::INVALID_RESOURCE;
+	mSsaoBlur = graph.createTexture(GraphResources::SSAO_BLUR, RenderGraphTextures::makeDesc(w, h, GLW::R8));
+	mHistory = graph.importResource(SSAO_HISTORY);
+
+	graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+		.read(graph.findResource(GraphResources::G_VIEW_POSITION))
+		.read(graph.findResource(GraphResources::G_NORMAL))
+		.read(graph.findResource(GraphResources::G_DEPTH))
+		.write(mDepthNormal[0])
+		.read(mDepthNormal[0])
+		.write(mDepthNormal[1])
+		.read(mDepthNormal[1])
+		.write(mSsao)
+		.read(mSsao)
+		.read(mHistory)
+		.write(mHistory)
+		.write(mSsaoLowBlur)
+		.read(mSsaoLowBlur)
+		.write(mSsaoBlur);
+}
+
+void SSAOPass::bindResources(const RenderGraphTextures& textures) {
+	mData.mSsaoColorBuffer = textures.get(mSsao);
+	mData.mSsaoColorBufferBlur = textures.get(mSsaoBlur);
+	mData.mSsaoLowBlur = textures.get(mSsaoLowBlur);
+	for (uint32_t level = 0; level < mDepthNormal.size(); level++) {
+		mData.mDepthNormal[level] = textures.get(mDepthNormal[level]);
+		if (mData.mDepthNormal[level]) {
+			mData.mDepthNormalFbo[level].bind();
+			mData.mDepthNormalFbo[level].clearAttachments();
+			mData.mDepthNormalFbo[level].addAttachmentTexture(0, mData.mDepthNormal[level]);
+			mData.mDepthNormalFbo[level].finalize();
+			GLW::Framebuffer::bindDefaultFramebuffer();
+		}
+	}
 
-	// SSAO color buffer
-	mData.mSsaoColorBuffer.width = Engine::instance()->getWindow()->getScreenData().renderW;
-	mData.mSsaoColorBuffer.height = Engine::instance()->getWindow()->getScreenData().renderH;
-	mData.mSsaoColorBuffer.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.mSsaoColorBuffer.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.mSsaoColorBuffer.pixelFormat = GLW::R8;
-	mData.mSsaoColorBuffer.textureFormat = GLW::RED;
-	mData.mSsaoColorBuffer.pixelType = GLW::FLOAT;
-	mData.mSsaoColorBuffer.create();
-
-	mData.mSsaoColorBufferBlur.width = Engine::instance()->getWindow()->getScreenData().renderW;
-	mData.mSsaoColorBufferBlur.height = Engine::instance()->getWindow()->getScreenData().renderH;
-	mData.mSsaoColorBufferBlur.parameters.minFilter = GLW::TextureMinFilter::NEAREST;
-	mData.mSsaoColorBufferBlur.parameters.magFilter = GLW::TextureMagFilter::NEAREST;
-	mData.mSsaoColorBufferBlur.pixelFormat = GLW::R8;
-	mData.mSsaoColorBufferBlur.textureFormat = GLW::RED;
-	mData.mSsaoColorBufferBlur.pixelType = GLW::FLOAT;
-	mData.mSsaoColorBufferBlur.create();
-	
-	mData.mSsaoFbo.addAttachmentTexture(0, &mData.mSsaoColorBuffer);
+	mData.mSsaoFbo.bind();
+	mData.mSsaoFbo.clearAttachments();
+	mData.mSsaoFbo.addAttachmentTexture(0, mData.mSsaoColorBuffer);
 	mData.mSsaoFbo.finalize();
 
-	// and blur stage
+	// and blur stage, in reduced resolution it is followed by upsample to full one
 	mData.mSsaoBlurFbo.bind();
-	mData.mSsaoBlurFbo.addAttachmentTexture(0, &mData.mSsaoColorBufferBlur);
+	mData.mSsaoBlurFbo.clearAttachments();
+	mData.mSsaoBlurFbo.addAttachmentTexture(0, mData.mSsaoLowBlur ? mData.mSsaoLowBlur : mData.mSsaoColorBufferBlur);
 	mData.mSsaoBlurFbo.finalize();
 
+	if (mData.mSsaoLowBlur) {
+		mData.mUpsampleFbo.bind();
+		mData.mUpsampleFbo.clearAttachments();
+		mData.mUpsampleFbo.addAttachmentTexture(0, mData.mSsaoColorBufferBlur);
+		mData.mUpsampleFbo.finalize();
+		GLW::Framebuffer::bindDefaultFramebuffer();
+	}
+
+	for (size_t i = 0; i < mHistoryTextures.size(); i++) {
+		auto& history = mHistoryTextures[i];
+		history = std::make_unique<GLW::Texture>(GLW::TEXTURE_2D);
+		history->width = mData.mSsaoColorBuffer->width;
+		history->height = mData.mSsaoColorBuffer->height;
+		history->parameters.minFilter = GLW::TextureMinFilter::LINEAR;
+		history->parameters.magFilter = GLW::TextureMagFilter::LINEAR;
+		history->parameters.wrap = { GLW::TextureWrap::CLAMP_TO_EDGE, GLW::TextureWrap::CLAMP_TO_EDGE, GLW::TextureWrap::CLAMP_TO_EDGE };
+		history->pixelFormat = GLW::RG16F;
+		history->textureFormat = GLW::RG;
+		history->pixelType = GLW::FLOAT;
+		history->create();
+
+		mData.mTemporalFbo[i].bind();
+		mData.mTemporalFbo[i].clearAttachments();
+		mData.mTemporalFbo[i].addAttachmentTexture(0, history.get());
+		mData.mTemporalFbo[i].finalize();
+		GLW::Framebuffer::bindDefaultFramebuffer();
+	}
+	mHistoryValid = false;
+
 	GLW::Framebuffer::bindDefaultFramebuffer();
 	GLW::Framebuffer::bindDefaultFramebuffer();
+}
+
+void SSAOPass::init() {
 	// generate sample kernel
 	// ----------------------
 
@@ -90,7 +167,14 @@ void SSAOPass::init() {
 	mData.mNoiseTexture.pixelType = GLW::FLOAT;
 	mData.mNoiseTexture.create(ssaoNoise.data());
 
-	auto shaderSSAO = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao.fs");
+	//programs are resolved before uniforms are set, so they are compiled together
+	mSsaoShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao.fs");
+	mBlurShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao_blur.fs");
+	mDownsampleShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao_downsample.fs");
+	mTemporalShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao_temporal.fs");
+	mUpsampleShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao_upsample.fs");
+
+	const auto shaderSSAO = mSsaoShader;
 	shaderSSAO->use();
 	shaderSSAO->setUniform("gPosition", 0);
 	shaderSSAO->setUniform("gNormal", 1);
@@ -104,7 +188,7 @@ void SSAOPass::init() {
 		shaderSSAO->setUniform(("samples[" + std::to_string(i) + "]").c_str(), mData.mSsaoKernel[i]);
 	}
 
-	auto shaderSSAOBlur = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao_blur.fs");
+	const auto shaderSSAOBlur = mBlurShader;
 	shaderSSAOBlur->use();
 	shaderSSAOBlur->setUniform("ssaoInput", 0);
 
@@ -116,91 +200,229 @@ void SSAOPass::init() {
 	shaderSSAOBlur->setUniform("sigmaS", mData.sigmaS);
 	shaderSSAOBlur->setUniform("facS", facS);
 
+	const auto shaderDownsample = mDownsampleShader;
+	shaderDownsample->use();
+	shaderDownsample->setUniform("gNormal", 0);
+	shaderDownsample->setUniform("gDepthTexture", 1);
+
+	const auto shaderTemporal = mTemporalShader;
+	shaderTemporal->use();
+	shaderTemporal->setUniform("ssaoInput", 0);
+	shaderTemporal->setUniform("history", 1);
+	shaderTemporal->setUniform("gDepthTexture", 2);
+
+	const auto shaderUpsample = mUpsampleShader;
+	shaderUpsample->use();
+	shaderUpsample->setUniform("ssaoInput", 0);
+	shaderUpsample->setUniform("depthNormal", 1);
+	shaderUpsample->setUniform("gNormal", 2);
+	shaderUpsample->setUniform("gDepthTexture", 3);
 }
 
-void SSAOPass::render(SystemsModule::RenderData& renderDataHandle) {
-	FUNCTION_BENCHMARK
-	auto shaderSSAO = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao.fs");
-	auto shaderSSAOBlur = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/ssao.vs", "shaders/ssao_blur.fs");
-	{
-		/*if (ImGui::BeginMainMenuBar()) {
-			if (ImGui::BeginMenu("Debug")) {
-				if (ImGui::BeginMenu("Systems debug")) {
-					ImGui::Checkbox("SSAO", &ssaoDebugWindow);
-					ImGui::EndMenu();
-				}
-				ImGui::EndMenu();
-			}
-		}
-		ImGui::EndMainMenuBar();*/
+void SSAOPass::drawDebugWindow() {
+	if (!ssaoDebugWindow) {
+		return;
 	}
 
-	if (ssaoDebugWindow) {
-		if (ImGui::Begin("SSAO", &ssaoDebugWindow)) {
-			shaderSSAO->use();
-			if (ImGui::DragInt("kernelSize", &mData.mKernelSize)) {
-				shaderSSAO->setUniform("kernelSize", mData.mKernelSize);
-			}
-			if (ImGui::DragFloat("radius", &mData.mRadius, 0.01f)) {
-				shaderSSAO->setUniform("radius", mData.mRadius);
-			}
-			if (ImGui::DragFloat("bias", &mData.mBias, 0.001f)) {
-				shaderSSAO->setUniform("BIAS", mData.mBias);
-			}
-			if (ImGui::DragFloat("intencity", &mData.intencity, 0.1f)) {
-				shaderSSAO->setUniform("INTENSITY", mData.intencity);
+	const auto shaderSSAO = mSsaoShader;
+	const auto shaderSSAOBlur = mBlurShader;
+	if (ImGui::Begin("SSAO", &ssaoDebugWindow)) {
+		constexpr Resolution resolutions[] = { Resolution::FULL, Resolution::HALF, Resolution::QUARTER };
+		const char* resolutionNames[] = { "full", "half", "quarter" };
+		auto resolution = static_cast<int>(std::countr_zero(static_cast<uint32_t>(mData.resolution)));
+		if (ImGui::Combo("resolution", &resolution, resolutionNames, 3)) {
+			mData.resolution = resolutions[resolution];
+			if (mData.resolution != mBuiltResolution) {
+				ECSHandler::getSystem<SystemsModule::RenderSystem>()->requestRenderGraphRebuild();
 			}
+		}
+		if (ImGui::Checkbox("temporal accumulation", &mData.temporal)) {
+			mHistoryValid = false;
+		}
+		if (mData.temporal) {
+			ImGui::DragInt("samples per frame", &mData.temporalSamples, 1.f, 1, 64);
+			ImGui::SliderFloat("history blend", &mData.temporalBlend, 0.01f, 1.f);
+			ImGui::SliderFloat("history rejection", &mData.historyRejection, 0.01f, 1.f);
+		}
+		if (mBuiltResolution != Resolution::FULL) {
+			ImGui::SliderFloat("upsample depth sharpness", &mData.upsampleDepthSharpness, 0.f, 100.f);
+		}
+		ImGui::Text("ao: %dx%d, samples: %d", mData.mSsaoColorBuffer->width, mData.mSsaoColorBuffer->height, mData.temporal ? mData.temporalSamples : mData.samples);
 
-			if (ImGui::DragFloat("scale", &mData.scale, 0.1f)) {
-				shaderSSAO->setUniform("SCALE", mData.scale);
-			}
+		ImGui::Separator();
+		shaderSSAO->use();
+		if (ImGui::DragInt("kernelSize", &mData.mKernelSize)) {
+			shaderSSAO->setUniform("kernelSize", mData.mKernelSize);
+		}
+		if (ImGui::DragFloat("radius", &mData.mRadius, 0.01f)) {
+			shaderSSAO->setUniform("radius", mData.mRadius);
+		}
+		if (ImGui::DragFloat("bias", &mData.mBias, 0.001f)) {
+			shaderSSAO->setUniform("BIAS", mData.mBias);
+		}
+		if (ImGui::DragFloat("intencity", &mData.intencity, 0.1f)) {
+			shaderSSAO->setUniform("INTENSITY", mData.intencity);
+		}
 
-			if (ImGui::DragFloat("sample_rad", &mData.sample_rad, 0.1f)) {
-				shaderSSAO->setUniform("SAMPLE_RAD", mData.sample_rad);
-			}
+		if (ImGui::DragFloat("scale", &mData.scale, 0.1f)) {
+			shaderSSAO->setUniform("SCALE", mData.scale);
+		}
 
-			if (ImGui::DragFloat("max_distance", &mData.max_distance, 0.1f)) {
-				shaderSSAO->setUniform("MAX_DISTANCE", mData.max_distance);
-			}
-			if (ImGui::DragInt("samples", &mData.samples)) {
-				shaderSSAO->setUniform("SAMPLES", mData.samples);
-			}
+		if (ImGui::DragFloat("sample_rad", &mData.sample_rad, 0.1f)) {
+			shaderSSAO->setUniform("SAMPLE_RAD", mData.sample_rad);
+		}
 
-			if (ImGui::DragFloat("sigmaS", &mData.sigmaS, 0.01f, 0.000001f)) {
-				shaderSSAOBlur->use();
-				float facS = -1.f / (2.f * mData.sigmaS * mData.sigmaS);
+		if (ImGui::DragFloat("max_distance", &mData.max_distance, 0.1f)) {
+			shaderSSAO->setUniform("MAX_DISTANCE", mData.max_distance);
+		}
+		ImGui::DragInt("samples", &mData.samples);
 
-				shaderSSAOBlur->setUniform("sigmaS", mData.sigmaS);
-				shaderSSAOBlur->setUniform("facS", facS);
-			}
-			if (ImGui::DragFloat("sigmaL", &mData.sigmaL, 0.01f, 0.000001f)) {
-				shaderSSAOBlur->use();
-				float facL = -1.f / (2.f * mData.sigmaL * mData.sigmaL);
-				shaderSSAOBlur->setUniform("sigmaL", mData.sigmaL);
-				shaderSSAOBlur->setUniform("facL", facL);
-			}
+		if (ImGui::DragFloat("sigmaS", &mData.sigmaS, 0.01f, 0.000001f)) {
+			shaderSSAOBlur->use();
+			float facS = -1.f / (2.f * mData.sigmaS * mData.sigmaS);
+
+			shaderSSAOBlur->setUniform("sigmaS", mData.sigmaS);
+			shaderSSAOBlur->setUniform("facS", facS);
+		}
+		if (ImGui::DragFloat("sigmaL", &mData.sigmaL, 0.01f, 0.000001f)) {
+			shaderSSAOBlur->use();
+			float facL = -1.f / (2.f * mData.sigmaL * mData.sigmaL);
+			shaderSSAOBlur->setUniform("sigmaL", mData.sigmaL);
+			shaderSSAOBlur->setUniform("facL", facL);
 		}
-		ImGui::End();
 	}
-	
+	ImGui::End();
+}
+
+void SSAOPass::downsample(SystemsModule::RenderData& renderDataHandle) {
+	const auto shaderDownsample = mDownsampleShader;
+	shaderDownsample->use();
+	shaderDownsample->setUniform("invProjection", Math::inverse(renderDataHandle.current.projection));
+	GLW::bindTextureToSlot(1, renderDataHandle.mGeometryPassData->depthBuffer);
+
+	//the first level reads g buffer, next ones read previous level which has layout of full g buffer
+	GLW::Texture* source = renderDataHandle.mGeometryPassData->normalBuffer;
+	auto compact = renderDataHandle.mGeometryPassData->compact;
+	for (size_t level = 0; level < mData.mDepthNormal.size() && mData.mDepthNormal[level]; level++) {
+		const auto target = mData.mDepthNormal[level];
+		mData.mDepthNormalFbo[level].bind();
+		GLW::ViewportStack::push({ { target->width, target->height } });
+		shaderDownsample->setUniform("compactGBuffer", compact);
+		GLW::bindTextureToSlot(0, source);
+		Utils::renderQuad();
+		GLW::ViewportStack::pop();
+		GLW::Framebuffer::bindDefaultFramebuffer();
+
+		source = target;
+		compact = false;
+	}
+}
+
+void SSAOPass::accumulate(SystemsModule::RenderData& renderDataHandle) {
+	const auto previous = mHistoryIndex;
+	mHistoryIndex = (mHistoryIndex + 1) % mHistoryTextures.size();
+
+	const auto shaderTemporal = mTemporalShader;
+	mData.mTemporalFbo[mHistoryIndex].bind();
+	GLW::ViewportStack::push({ { mHistoryTextures[mHistoryIndex]->width, mHistoryTextures[mHistoryIndex]->height } });
+	shaderTemporal->use();
+	shaderTemporal->setUniform("invProjection", Math::inverse(renderDataHandle.current.projection));
+	shaderTemporal->setUniform("invPV", Math::inverse(renderDataHandle.current.PV));
+	shaderTemporal->setUniform("previousPV", mPreviousPV);
+	shaderTemporal->setUniform("historyValid", mHistoryValid);
+	shaderTemporal->setUniform("blend", mData.temporalBlend);
+	shaderTemporal->setUniform("rejection", mData.historyRejection);
+	GLW::bindTextureToSlot(0, mData.mSsaoColorBuffer);
+	GLW::bindTextureToSlot(1, mHistoryTextures[previous].get());
+	GLW::bindTextureToSlot(2, renderDataHandle.mGeometryPassData->depthBuffer);
+	Utils::renderQuad();
+	GLW::ViewportStack::pop();
+	GLW::Framebuffer::bindDefaultFramebuffer();
+
+	mHistoryValid = true;
+}
+
+void SSAOPass::upsample(SystemsModule::RenderData& renderDataHandle) {
+	const auto shaderUpsample = mUpsampleShader;
+	const auto levels = std::countr_zero(static_cast<uint32_t>(mBuiltResolution));
+	mData.mUpsampleFbo.bind();
+	shaderUpsample->use();
+	shaderUpsample->setUniform("compactGBuffer", renderDataHandle.mGeometryPassData->compact);
+	shaderUpsample->setUniform("invProjection", Math::inverse(renderDataHandle.current.projection));
+	shaderUpsample->setUniform("depthSharpness", mData.upsampleDepthSharpness);
+	GLW::bindTextureToSlot(0, mData.mSsaoLowBlur);
+	GLW::bindTextureToSlot(1, mData.mDepthNormal[levels - 1]);
+	GLW::bindTextureToSlot(2, renderDataHandle.mGeometryPassData->normalBuffer);
+	GLW::bindTextureToSlot(3, renderDataHandle.mGeometryPassData->depthBuffer);
+	Utils::renderQuad();
+	GLW::Framebuffer::bindDefaultFramebuffer();
+}
+
+void SSAOPass::render(SystemsModule::RenderData& renderDataHandle) {
+	FUNCTION_BENCHMARK
+	const auto shaderSSAO = mSsaoShader;
+	const auto shaderSSAOBlur = mBlurShader;
+	drawDebugWindow();
+
+	const auto reduced = mBuiltResolution != Resolution::FULL;
+	if (reduced) {
+		downsample(renderDataHandle);
+	}
+
+	//reduced ao reads the last level of pyramid, it has layout of full g buffer
+	const auto levels = std::countr_zero(static_cast<uint32_t>(mBuiltResolution));
+	const auto aoViewport = GLW::ViewportState{ { mData.mSsaoColorBuffer->width, mData.mSsaoColorBuffer->height } };
+
 	mData.mSsaoFbo.bind();
+	GLW::ViewportStack::push(aoViewport);
 	GLW::clear(GLW::ColorBit::COLOR);
 	shaderSSAO->use();
 	shaderSSAO->setUniform("projection", renderDataHandle.current.projection);
+	shaderSSAO->setUniform("compactGBuffer", !reduced && renderDataHandle.mGeometryPassData->compact);
+	shaderSSAO->setUniform("invProjection", Math::inverse(renderDataHandle.current.projection));
+	shaderSSAO->setUniform("gDepthTexture", 3);
+	shaderSSAO->setUniform("SAMPLES", mData.temporal ? mData.temporalSamples : mData.samples);
+	//golden angle rotation of spiral, so accumulated frames take different samples
+	shaderSSAO->setUniform("ROTATION", mData.temporal ? static_cast<float>(mFrame % 64) * 2.39996f : 0.f);
 
-	GLW::bindTextureToSlot(0, &renderDataHandle.mGeometryPassData->viewPositionBuffer);
-	GLW::bindTextureToSlot(1, &renderDataHandle.mGeometryPassData->normalBuffer);
+	if (reduced) {
+		GLW::bindTextureToSlot(1, mData.mDepthNormal[levels - 1]);
+	}
+	else {
+		if (renderDataHandle.mGeometryPassData->viewPositionBuffer) {
+			GLW::bindTextureToSlot(0, renderDataHandle.mGeometryPassData->viewPositionBuffer);
+		}
+		GLW::bindTextureToSlot(1, renderDataHandle.mGeometryPassData->normalBuffer);
+	}
+	GLW::bindTextureToSlot(3, renderDataHandle.mGeometryPassData->depthBuffer);
 	GLW::bindTextureToSlot(2, &mData.mNoiseTexture);
 	Utils::renderQuad();
-	
+	GLW::ViewportStack::pop();
+	GLW::Framebuffer::bindDefaultFramebuffer();
+
+	GLW::Texture* aoSource = mData.mSsaoColorBuffer;
+	if (mData.temporal) {
+		accumulate(renderDataHandle);
+		aoSource = mHistoryTextures[mHistoryIndex].get();
+	}
+	else {
+		mHistoryValid = false;
+	}
 
 	mData.mSsaoBlurFbo.bind();
+	GLW::ViewportStack::push(aoViewport);
 	GLW::clear(GLW::ColorBit::COLOR);
 	shaderSSAOBlur->use();
-	GLW::bindTextureToSlot(0, &mData.mSsaoColorBuffer);
+	GLW::bindTextureToSlot(0, aoSource);
 	Utils::renderQuad();
-
-	mData.mSsaoBlurFbo.bindDefaultFramebuffer();
+	GLW::ViewportStack::pop();
 	GLW::Framebuffer::bindDefaultFramebuffer();
+
+	if (reduced) {
+		upsample(renderDataHandle);
+	}
+
+	mPreviousPV = renderDataHandle.current.PV;
+	mFrame++;
 	renderDataHandle.mSSAOPassData = &mData;
 }
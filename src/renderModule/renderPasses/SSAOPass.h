@@ -1,24 +1,41 @@
 ﻿#pragma once
 
+#include <array>
+#include <memory>
 #include <vector>
 
+#include "assetsModule/shaderModule/ShaderBase.h"
 #include "glWrapper/Framebuffer.h"
+#include "renderModule/RenderGraph.h"
 #include "renderModule/renderPasses/RenderPass.h"
 
 namespace SFE::Render::RenderPasses {
 	class SSAOPass : public RenderPass {
 	public:
+		//ao is computed at render resolution divided by it, reduced one is upsampled by depth and normal aware filter
+		enum class Resolution : uint32_t {
+			FULL = 1,
+			HALF = 2,
+			QUARTER = 4,
+		};
+
 		struct Data {
 			std::vector<Math::Vec3> mSsaoKernel;
 			GLW::Texture mNoiseTexture{GLW::TEXTURE_2D};
 			GLW::Framebuffer mSsaoFbo;
 			GLW::Framebuffer mSsaoBlurFbo;
-			GLW::Texture mSsaoColorBuffer{GLW::TEXTURE_2D};
-			GLW::Texture mSsaoColorBufferBlur{GLW::TEXTURE_2D};
+			std::array<GLW::Framebuffer, 2> mDepthNormalFbo; //half and quarter levels
+			std::array<GLW::Framebuffer, 2> mTemporalFbo; //one for every history texture
+			GLW::Framebuffer mUpsampleFbo;
+			//textures are owned by render graph, blur one is full resolution ao which lighting reads
+			GLW::Texture* mSsaoColorBuffer = nullptr;
+			GLW::Texture* mSsaoColorBufferBlur = nullptr;
+			GLW::Texture* mSsaoLowBlur = nullptr;
+			std::array<GLW::Texture*, 2> mDepthNormal = {}; //view normal with depth in alpha, as full g buffer keeps it
 			int mKernelSize = 16;
 			float mRadius = 0.5f;
 			float mBias = 0.7f;
-			int samples = 16;
+			int samples = 64;
 			float intencity = 1.5f;
 			float scale = 0.5f;
 			float sample_rad = 1.2f;
@@ -26,13 +43,49 @@ namespace SFE::Render::RenderPasses {
 
 			float sigmaS = 1.0f;
 			float sigmaL = 1.2f;
+
+			//resolution change rebuilds render graph
+			Resolution resolution = Resolution::HALF;
+			//every frame rotates samples and is blended with reprojected history, so less samples converge to the same result
+			bool temporal = true;
+			int temporalSamples = 16;
+			float temporalBlend = 0.1f; //weight of current frame
+			float historyRejection = 0.1f; //relative depth difference after which history is dropped
+			float upsampleDepthSharpness = 20.f;
 		};
 		
 		void init() override;
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
+		void bindResources(const RenderGraphTextures& textures) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
 	private:
+		void downsample(SystemsModule::RenderData& renderDataHandle);
+		void accumulate(SystemsModule::RenderData& renderDataHandle);
+		void upsample(SystemsModule::RenderData& renderDataHandle);
+		void drawDebugWindow();
+
+		RenderGraph::ResourceId mSsao = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mSsaoBlur = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mSsaoLowBlur = RenderGraph::INVALID_RESOURCE;
+		RenderGraph::ResourceId mHistory = RenderGraph::INVALID_RESOURCE;
+		std::array<RenderGraph::ResourceId, 2> mDepthNormal = { RenderGraph::INVALID_RESOURCE, RenderGraph::INVALID_RESOURCE };
+
+		//history lives between frames, so it is owned by pass, ping pong of ao in red and view depth in green
+		std::array<std::unique_ptr<GLW::Texture>, 2> mHistoryTextures;
+		uint32_t mHistoryIndex = 0;
+		bool mHistoryValid = false;
+		//RenderData::current becomes next frame matrices, so previous ones are kept for reprojection
+		Math::Mat4 mPreviousPV = {};
+		uint32_t mFrame = 0;
+
+		ShaderModule::ShaderBase* mSsaoShader = nullptr;
+		ShaderModule::ShaderBase* mBlurShader = nullptr;
+		ShaderModule::ShaderBase* mDownsampleShader = nullptr;
+		ShaderModule::ShaderBase* mTemporalShader = nullptr;
+		ShaderModule::ShaderBase* mUpsampleShader = nullptr;
 
-		bool ssaoDebugWindow = false;
+		Resolution mBuiltResolution = Resolution::FULL; //resolution of created textures
+		bool ssaoDebugWindow = true;
 		Data mData{};
 	};
 }
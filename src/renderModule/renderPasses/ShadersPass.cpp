@@ -10,6 +10,7 @@
 #include "debugModule/Benchmark.h"
 #include "ecss/Registry.h"
 #include "renderModule/glUtils.h"
+#include "renderModule/RenderGraph.h"
 #include "systemsModule/systems/CameraSystem.h"
 #include "systemsModule/systems/RenderSystem.h"
 #include "systemsModule/systems/ShaderSystem.h"
@@ -19,6 +20,26 @@
 
 SFE::Render::RenderPasses::ShadersPass::ShadersPass() {}
 
+void SFE::Render::RenderPasses::ShadersPass::init() {
+	mTestShader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/testSh.vs", "shaders/testSh.fs");
+}
+
+void SFE::Render::RenderPasses::ShadersPass::setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) {
+	//shaders draw into all g buffer attachments and sample them
+	const auto position = graph.findResource(GraphResources::G_POSITION);
+	const auto normal = graph.findResource(GraphResources::G_NORMAL);
+	const auto albedo = graph.findResource(GraphResources::G_ALBEDO);
+	graph.addPass(getName(), [this, &renderDataHandle]() { render(renderDataHandle); })
+		.read(position)
+		.read(normal)
+		.read(albedo)
+		.write(position)
+		.write(normal)
+		.write(albedo)
+		.write(graph.findResource(GraphResources::G_VIEW_POSITION))
+		.write(graph.findResource(GraphResources::G_DEPTH));
+}
+
 void SFE::Render::RenderPasses::ShadersPass::render(SystemsModule::RenderData& renderDataHandle) {
 	FUNCTION_BENCHMARK;
 
@@ -41,17 +62,16 @@ void SFE::Render::RenderPasses::ShadersPass::render(SystemsModule::RenderData& r
 
 	renderDataHandle.mGeometryPassData->gFramebuffer.bind();
 
-	const auto shader = SHADER_CONTROLLER->loadVertexFragmentShader("shaders/testSh.vs", "shaders/testSh.fs");
+	const auto shader = mTestShader;
 	shader->use();
 
 	shader->setUniform("cameraPos", Math::Vec3{renderDataHandle.mCameraPos});
 
-	auto camera = ECSHandler::getSystem<SFE::SystemsModule::CameraSystem>()->getCurrentCamera();
-	auto cameraComp = ECSHandler::registry().getComponent<CameraComponent>(camera);
-	shader->setUniform("far", cameraComp->getProjection().getFar());
-	shader->setUniform("near", cameraComp->getProjection().getNear());
+	shader->setUniform("far", renderDataHandle.cameraProjection.getFar());
+	shader->setUniform("near", renderDataHandle.cameraProjection.getNear());
+	shader->setUniform("compactGBuffer", renderDataHandle.mGeometryPassData->compact);
 
-	drawMesh(GLW::TRIANGLES, mesh, SFE::MeshVaoRegistry::instance()->get(&mesh).vao.getID());
+	drawMesh(GLW::TRIANGLES, GeometryArena::instance()->getRange(SFE::MeshVaoRegistry::instance()->get(&mesh).handle));
 	GLW::Framebuffer::bindDefaultFramebuffer();
 
 	const auto& drawableEntities = ECSHandler::getSystem<SystemsModule::ShaderSystem>()->drawableEntities;
@@ -61,7 +81,7 @@ void SFE::Render::RenderPasses::ShadersPass::render(SystemsModule::RenderData& r
 
 	renderDataHandle.mGeometryPassData->gFramebuffer.bind();
 
-	auto& cameraPos = ECSHandler::registry().getComponent<TransformComponent>(ECSHandler::getSystem<SFE::SystemsModule::CameraSystem>()->getCurrentCamera())->getPos();
+	const auto& cameraPos = renderDataHandle.mCameraPos;
 	Batcher batcher;
 	auto flush = [this, &renderDataHandle, &batcher, &cameraPos](size_t shaderId) {
 		const auto shader = SHADER_CONTROLLER->getShader(shaderId);
@@ -72,10 +92,14 @@ void SFE::Render::RenderPasses::ShadersPass::render(SystemsModule::RenderData& r
 		shader->setUniform("V", renderDataHandle.current.view);
 		shader->setUniform("PV", renderDataHandle.current.PV);
 
-		GLW::bindTextureToSlot(0, &renderDataHandle.mGeometryPassData->positionBuffer);
-		GLW::bindTextureToSlot(1, &renderDataHandle.mGeometryPassData->normalBuffer);
-		GLW::bindTextureToSlot(2, &renderDataHandle.mGeometryPassData->albedoBuffer);
+		//compact g buffer has no position buffer
+		if (renderDataHandle.mGeometryPassData->positionBuffer) {
+			GLW::bindTextureToSlot(0, renderDataHandle.mGeometryPassData->positionBuffer);
+		}
+		GLW::bindTextureToSlot(1, renderDataHandle.mGeometryPassData->normalBuffer);
+		GLW::bindTextureToSlot(2, renderDataHandle.mGeometryPassData->albedoBuffer);
 
+		shader->setUniform("compactGBuffer", renderDataHandle.mGeometryPassData->compact);
 		shader->setUniform("gPosition", 0);
 		shader->setUniform("gNormal", 1);
 		shader->setUniform("gAlbedoSpec", 2);
@@ -1,10 +1,16 @@
 ﻿#pragma once
+#include "assetsModule/shaderModule/ShaderBase.h"
 #include "renderModule/renderPasses/RenderPass.h"
 
 namespace SFE::Render::RenderPasses {
 	class ShadersPass : public RenderPass {
 	public:
 		ShadersPass();
+		void init() override;
+		void setup(RenderGraph& graph, SystemsModule::RenderData& renderDataHandle) override;
 		void render(SystemsModule::RenderData& renderDataHandle) override;
+
+	private:
+		ShaderModule::ShaderBase* mTestShader = nullptr;
 	};
 }
@@ -0,0 +1,108 @@
+﻿#pragma once
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "ecss/Registry.h"
+#include "multithreading/ThreadPool.h"
+
+namespace SFE::SystemsModule {
+	//sectors of First component container split into pieces of chunkSize going in storage order
+	//sectors are sorted by id, so every piece is one id range [first sector id, first id of next piece) and forEach over it walks component arrays linearly
+	//sectors without alive First component are skipped by forEach, so pieces can hold a bit less than chunkSize entities
+	template<typename First>
+	std::vector<ecss::EntitiesRanges> splitToChunks(ecss::Registry& registry, size_t chunkSize) {
+		using Component = std::remove_const_t<First>;
+
+		std::vector<ecss::EntitiesRanges> chunks;
+		if (!chunkSize) {
+			chunkSize = 1;
+		}
+
+		auto lock = registry.containerReadLock<Component>();
+		const auto container = registry.getComponentContainer<Component>();
+		const size_t count = container->size();
+
+		chunks.reserve(count / chunkSize + 1);
+		for (size_t begin = 0; begin < count; begin += chunkSize) {
+			const auto end = begin + chunkSize;
+			const ecss::EntityId first = container->getSector(begin)->id;
+			const ecss::EntityId last = end < count ? container->getSector(end)->id : container->getSector(count - 1)->id + 1;
+
+			auto& chunk = chunks.emplace_back();
+			chunk.ranges.emplace_back(first, last);
+		}
+
+		return chunks;
+	}
+
+	//calls fn(entity, Components*...) for every entity which has first component, chunks are processed on COMMON workers
+	//first chunk is processed on calling thread, function returns when all chunks are done
+	//components after the first one can be nullptr, same as in registry.forEach
+	template<typename... Components, typename Func>
+	void parallelForEach(ecss::Registry& registry, size_t chunkSize, Func&& fn, bool lock = true) {
+		static_assert(sizeof...(Components) > 0);
+		using First = std::tuple_element_t<0, std::tuple<Components...>>;
+
+		const auto chunks = splitToChunks<First>(registry, chunkSize);
+		if (chunks.empty()) {
+			return;
+		}
+
+		const auto processChunk = [&registry, &fn, lock](const ecss::EntitiesRanges& chunk) {
+			for (auto&& components : registry.forEach<Components...>(chunk, lock)) {
+				std::apply(fn, components);
+			}
+		};
+
+		FuturesBunch futures;
+		futures.reserve(chunks.size() - 1);
+		for (size_t i = 1; i < chunks.size(); i++) {
+			futures.add(ThreadPool::instance()->addTask([&processChunk, &chunk = chunks[i]]() {
+				processChunk(chunk);
+			}));
+		}
+
+		processChunk(chunks[0]);
+		futures.waitAll();
+	}
+
+	//map(Result& partial, entity, Components*...) accumulates chunk result, combine(Result& total, const Result& partial) merges them
+	//partials are merged in chunk order on calling thread, so result doesn't depend on which worker finished first
+	template<typename... Components, typename Result, typename Map, typename Combine>
+	Result parallelReduce(ecss::Registry& registry, size_t chunkSize, Result identity, Map&& map, Combine&& combine, bool lock = true) {
+		static_assert(sizeof...(Components) > 0);
+		using First = std::tuple_element_t<0, std::tuple<Components...>>;
+
+		const auto chunks = splitToChunks<First>(registry, chunkSize);
+		if (chunks.empty()) {
+			return identity;
+		}
+
+		std::vector<Result> partials(chunks.size(), identity);
+		const auto processChunk = [&registry, &map, lock](const ecss::EntitiesRanges& chunk, Result& partial) {
+			for (auto&& components : registry.forEach<Components...>(chunk, lock)) {
+				std::apply([&map, &partial](auto&&... args) {
+					map(partial, args...);
+				}, components);
+			}
+		};
+
+		FuturesBunch futures;
+		futures.reserve(chunks.size() - 1);
+		for (size_t i = 1; i < chunks.size(); i++) {
+			futures.add(ThreadPool::instance()->addTask([&processChunk, &chunk = chunks[i], &partial = partials[i]]() {
+				processChunk(chunk, partial);
+			}));
+		}
+
+		processChunk(chunks[0], partials[0]);
+		futures.waitAll();
+
+		for (const auto& partial : partials) {
+			combine(identity, partial);
+		}
+
+		return identity;
+	}
+}
@@ -106,6 +106,16 @@ namespace ecss {
 
 			onNotify();
 		}
+
+		void notifyBatch(const std::vector<EntityId>& entitiesToAdd, SFE::SystemsModule::TaskType type) override {
+			auto& entities = mUpdatedEntities[type];
+
+			entities.mutex.lock();
+			entities.entities.insert(entities.entities.end(), entitiesToAdd.begin(), entitiesToAdd.end());
+			entities.mutex.unlock();
+
+			onNotify();
+		}
 	
 	protected:
 		struct EntitiesContainer {
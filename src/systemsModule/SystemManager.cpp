@@ -9,7 +9,7 @@ namespace ecss {
 	SystemManager::~SystemManager() {
 		SystemManagerAlive = false;
 		for (auto& tickThread : mTickSystemThreads) {
-			tickThread.join();
+			tickThread->thread.join();
 		}
 
 		for (const auto system : mSystemsMap) {
@@ -17,22 +17,28 @@ namespace ecss {
 		}
 	}
 
-	std::thread SystemManager::startTickSystem(System* system, float ticks) {
+	void SystemManager::startTickSystem(System* system, float ticks) {
 		system->setTick(ticks);
-		return std::thread([system] {
-			float mLastFrame = 0.f;
-			
+
+		auto& tickThread = mTickSystemThreads.emplace_back(std::make_unique<TickThread>());
+		tickThread->system = system;
+		tickThread->thread = std::thread([system, tickThread = tickThread.get()] {
+			//limiter wakes thread close to the tick, timestep makes the amount of updates exact even if wake up was late
+			SFE::CoreModule::FrameLimiter limiter(system->getTicks());
+			SFE::CoreModule::FixedTimestep timestep(system->getTicks());
+			auto lastTick = SFE::CoreModule::monotonicNs();
+
 			while (SystemManagerAlive) {
-				const auto currentFrame = static_cast<float>(glfwGetTime());
-				const auto mDeltaTime = currentFrame - mLastFrame;
-				mLastFrame = currentFrame;
+				limiter.wait();
 
-				system->update(mDeltaTime);
+				const auto now = SFE::CoreModule::monotonicNs();
+				const auto elapsed = now - lastTick;
+				lastTick = now;
+				tickThread->intervals.add(elapsed);
 
-				const auto tickDelta = 1.f / system->getTicks();
-				if (mDeltaTime < tickDelta) {
-					std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int>((tickDelta - mDeltaTime) * 1000.f * 1000.f)));
-				}
+				timestep.advance(elapsed, [system](float dt) {
+					system->update(dt);
+				});
 			}
 		});
 	}
@@ -43,8 +49,20 @@ namespace ecss {
 		for (const auto system : mMainThreadSystems) {
 			system->update(dt);
 		}
+	}
+
+	void SystemManager::renderUpdate(float_t dt) {
+		FUNCTION_BENCHMARK;
+
+		for (const auto system : mRenderThreadSystems) {
+			system->update(dt);
+		}
+	}
 
-		for (auto system : mSystemsMap) {
+	void SystemManager::debugUpdate(float_t dt) {
+		FUNCTION_BENCHMARK;
+
+		for (const auto system : mSystemsMap) {
 			system->debugUpdate(dt);
 		}
 	}
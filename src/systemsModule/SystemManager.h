@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+#include <memory>
+
+#include "core/FramePacing.h"
 #include "systemsModule/SystemBase.h"
 
 namespace ecss {
@@ -10,7 +13,12 @@ namespace ecss {
 		SystemManager() = default;
 		~SystemManager();
 		
+		//simulation thread
 		void update(float_t dt);
+		//render thread, owns gl context
+		void renderUpdate(float_t dt);
+		//render thread while simulation thread waits, debug windows are drawn with imgui and read data of all systems
+		void debugUpdate(float_t dt);
 		
 		template <class T>
 		T* getSystem() {
@@ -41,18 +49,44 @@ namespace ecss {
 			(mMainThreadSystems.push_back(createSystem<ARGS>()), ...);
 		}
 
+		//systems which use gl, they are updated from render thread
+		template <class... ARGS>
+		void addRenderSystems() {
+			(mRenderThreadSystems.push_back(createSystem<ARGS>()), ...);
+		}
+
 		template <class... ARGS>
 		void addTickSystems(float ticks = 32) {
-			(mTickSystemThreads.push_back(startTickSystem(createSystem<ARGS>(), ticks)), ...);
+			(startTickSystem(createSystem<ARGS>(), ticks), ...);
+		}
+
+		//real intervals between updates of tick system, nullptr if system is not a tick one
+		template <class T>
+		const SFE::CoreModule::FrameTimeHistogram* getTickHistogram() {
+			const auto system = getSystem<T>();
+			for (auto& tickThread : mTickSystemThreads) {
+				if (tickThread->system == system) {
+					return &tickThread->intervals;
+				}
+			}
+
+			return nullptr;
 		}
 
 	private:
-		std::thread startTickSystem(System* system, float ticks = 32);
+		struct TickThread {
+			System* system = nullptr;
+			SFE::CoreModule::FrameTimeHistogram intervals{ 256 };
+			std::thread thread;
+		};
+
+		void startTickSystem(System* system, float ticks = 32);
 
 		std::vector<System*> mSystemsMap;
 
 		std::vector<System*> mMainThreadSystems;
+		std::vector<System*> mRenderThreadSystems;
 
-		std::vector<std::thread> mTickSystemThreads;
+		std::vector<std::unique_ptr<TickThread>> mTickSystemThreads;
 	};
 }
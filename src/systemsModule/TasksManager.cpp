@@ -6,6 +6,16 @@ namespace SFE::SystemsModule {
 		}
 	}
 
+	void TasksManager::notify(const std::vector<ecss::EntityId>& entities, TaskType type) const {
+		if (entities.empty()) {
+			return;
+		}
+
+		for (auto worker : workers[type]) {
+			worker->notifyBatch(entities, type);
+		}
+	}
+
 	void TasksManager::addWorker(TaskWorker* worker, TaskType type) {
 		workers[type].push_back(worker);
 	}
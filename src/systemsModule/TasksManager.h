@@ -2,6 +2,7 @@
 #include <array>
 #include <queue>
 #include <unordered_map>
+#include <vector>
 
 #include "containersModule/Singleton.h"
 #include "ecss/Types.h"
@@ -16,6 +17,7 @@ namespace SFE::SystemsModule {
 		ARMATURE_UPDATED,
 		MESH_UPDATED,
 		MATERIAL_UPDATED,
+		NODE_UPDATED, //parent, id or model of node changed, its transform can stay the same
 
 		COUNT
 	};
@@ -32,6 +34,8 @@ namespace SFE::SystemsModule {
 	public:
 
 		void notify(Task task) const;
+		//the same task for many entities, every worker is woken up once
+		void notify(const std::vector<ecss::EntityId>& entities, TaskType type) const;
 		void addWorker(TaskWorker* worker, TaskType type);
 
 	private:
@@ -47,5 +51,10 @@ namespace SFE::SystemsModule {
 
 		virtual ~TaskWorker() = default;
 		virtual void notify(Task task) = 0;
+		virtual void notifyBatch(const std::vector<ecss::EntityId>& entities, TaskType type) {
+			for (const auto entity : entities) {
+				notify({ entity, type });
+			}
+		}
 	};
 }
@@ -5,9 +5,11 @@
 #include "core/ECSHandler.h"
 
 void SFE::SystemsModule::ActionSystem::update(float dt) {
-	static std::map<unsigned, int> step;
-	
-	for (auto [entity, action, transform] : ECSHandler::registry().forEach<ComponentsModule::ActionComponent, TransformComponent>()) {
+	ECSHandler::parallelForEach<ComponentsModule::ActionComponent, TransformComponent>(128, [dt](ecss::EntityId entity, ComponentsModule::ActionComponent* action, TransformComponent* transform) {
+		if (!transform) {
+			return;
+		}
+
 		if (action->progress == 0.f) {
 			action->initialPos = transform->getPos();
 		}
@@ -16,9 +18,9 @@ void SFE::SystemsModule::ActionSystem::update(float dt) {
 		action->loop = true;
 
 		if (action->progress >= 1.f) {
-			step[entity]++;
-			if (step[entity] == 4) {
-				step[entity] = 0;
+			action->step++;
+			if (action->step == 4) {
+				action->step = 0;
 			}
 			if (action->loop) {
 				action->progress = 0.f;
@@ -26,10 +28,10 @@ void SFE::SystemsModule::ActionSystem::update(float dt) {
 			else {
 				action->progress = 1.f;
 			}
-			continue;
+			return;
 		}
 
-		switch(step[entity]) {
+		switch(action->step) {
 		case 0: {
 			auto pos = action->initialPos;
 			pos.y += std::sin(action->progress * Math::pi<float>() * 60.f) * 0.5f;
@@ -60,7 +62,5 @@ void SFE::SystemsModule::ActionSystem::update(float dt) {
 		}
 		default:;
 		}
-		
-		
-	}
+	});
 }
@@ -0,0 +1,320 @@
+﻿#include "AutosaveSystem.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "imgui.h"
+#include "componentsModule/DebugDataComponent.h"
+#include "componentsModule/ModelComponent.h"
+#include "componentsModule/TransformComponent.h"
+#include "componentsModule/TreeComponent.h"
+#include "core/ECSHandler.h"
+#include "core/FileSystem.h"
+#include "logsModule/logger.h"
+#include "propertiesModule/SceneFile.h"
+
+namespace SFE::SystemsModule {
+	AutosaveSystem::AutosaveSystem() : System({ SFE::SystemsModule::TaskType::TRANSFORM_UPDATE, SFE::SystemsModule::TaskType::NODE_UPDATED }) {}
+
+	AutosaveSystem::~AutosaveSystem() {
+		if (mSave.valid()) {
+			mSave.wait();
+		}
+	}
+
+	void AutosaveSystem::notify(Task task) {
+		if (!mTracking) {
+			return;
+		}
+		std::lock_guard lock(mJournalMutex);
+		mChangedEntities.push_back(task.entity);
+	}
+
+	void AutosaveSystem::notifyBatch(const std::vector<ecss::EntityId>& entities, TaskType type) {
+		if (!mTracking) {
+			return;
+		}
+		std::lock_guard lock(mJournalMutex);
+		mChangedEntities.insert(mChangedEntities.end(), entities.begin(), entities.end());
+	}
+
+	void AutosaveSystem::track(ecss::EntityId root, std::string path) {
+		std::lock_guard lock(mJournalMutex);
+		mPendingRoot = root;
+		mPendingPath = std::move(path);
+		mTracking = true;
+	}
+
+	void AutosaveSystem::update(float dt) {
+		{
+			std::unique_lock lock(mJournalMutex);
+			if (mPendingRoot != ecss::INVALID_ID) {
+				const auto root = mPendingRoot;
+				auto path = std::move(mPendingPath);
+				mPendingRoot = ecss::INVALID_ID;
+				lock.unlock();
+				startTracking(root, std::move(path));
+			}
+			else if (mChangedEntities.size() > JOURNAL_COMPACT_SIZE) {
+				std::ranges::sort(mChangedEntities);
+				const auto [first, last] = std::ranges::unique(mChangedEntities);
+				mChangedEntities.erase(first, last);
+			}
+		}
+
+		if (mRoot == ecss::INVALID_ID || !debugData.mEnabled) {
+			return;
+		}
+
+		mTimer += dt;
+		if ((mTimer < intervalSeconds && !mSaveRequested) || isSaving()) {
+			return;
+		}
+		mTimer = 0.f;
+		mSaveRequested = false;
+
+		takeSnapshot();
+	}
+
+	void AutosaveSystem::startTracking(ecss::EntityId root, std::string path) {
+		//saver thread owns saved scene, previous save is finished before it is dropped
+		if (mSave.valid()) {
+			mSave.wait();
+		}
+		mSavedNodes.clear();
+		mSavedVersions.clear();
+		mRoot = root;
+		mTimer = 0.f;
+
+		//the first save has all nodes, it is the only one which walks whole tree
+		std::vector<ecss::EntityId> nodes = { root };
+		if (const auto tree = ECSHandler::registry().getComponent<TreeComponent>(root)) {
+			const auto children = tree->getAllNodes();
+			nodes.insert(nodes.end(), children.begin(), children.end());
+		}
+
+		std::lock_guard lock(mJournalMutex);
+		mPath = std::move(path);
+		mChangedEntities = std::move(nodes);
+		mSaveRequested = true;
+	}
+
+	bool AutosaveSystem::isInScene(ecss::EntityId entity, ecss::EntityId& parent) const {
+		parent = ecss::INVALID_ID;
+		if (entity == mRoot) {
+			return true;
+		}
+
+		const auto tree = ECSHandler::registry().getComponent<TreeComponent>(entity);
+		if (!tree) {
+			return false;
+		}
+
+		parent = tree->getParent();
+		auto current = parent;
+		for (size_t depth = 0; current != ecss::INVALID_ID && depth < MAX_TREE_DEPTH; depth++) {
+			if (current == mRoot) {
+				return true;
+			}
+			const auto parentTree = ECSHandler::registry().getComponent<TreeComponent>(current);
+			if (!parentTree) {
+				return false;
+			}
+			current = parentTree->getParent();
+		}
+		return false;
+	}
+
+	void AutosaveSystem::takeSnapshot() {
+		const auto start = CoreModule::monotonicNs();
+
+		std::vector<ecss::EntityId> changed;
+		{
+			std::lock_guard lock(mJournalMutex);
+			changed.swap(mChangedEntities);
+		}
+		std::ranges::sort(changed);
+		const auto [first, last] = std::ranges::unique(changed);
+		changed.erase(first, last);
+
+		//children are notified when their parent moves, their record stays the same, so they are skipped
+		auto& registry = ECSHandler::registry();
+		std::vector<NodeRecord> records;
+		for (size_t i = 0; i < changed.size(); i++) {
+			const auto entity = changed[i];
+			const auto saved = mSavedVersions.find(entity);
+			ecss::EntityId parent = ecss::INVALID_ID;
+			if (!registry.contains(entity) || !isInScene(entity, parent)) {
+				if (saved != mSavedVersions.end()) {
+					mSavedVersions.erase(saved);
+					records.push_back({ entity, ecss::INVALID_ID, true });
+				}
+				continue;
+			}
+
+			const auto transform = registry.getComponent<TransformComponent>(entity);
+			const auto debugData = registry.getComponent<DebugDataComponent>(entity);
+			const auto modelComp = registry.getComponent<ModelComponent>(entity);
+
+			//model hash of node without model differs from hash of empty path
+			SavedVersion version;
+			version.transform = transform ? transform->getVersion() : 0;
+			version.parent = parent;
+			version.id = debugData ? std::hash<std::string>{}(debugData->stringId) : 0;
+			version.model = modelComp ? std::hash<std::string>{}(modelComp->mPath) + 1 : 0;
+			if (saved != mSavedVersions.end() && saved->second == version) {
+				continue;
+			}
+
+			//subtree of node which was moved into scene wasn't saved, its nodes have no changes of their own
+			if (saved == mSavedVersions.end()) {
+				if (const auto tree = registry.getComponent<TreeComponent>(entity)) {
+					const auto children = tree->getAllNodes();
+					changed.insert(changed.end(), children.begin(), children.end());
+				}
+			}
+			mSavedVersions[entity] = version;
+
+			auto& record = records.emplace_back();
+			record.entity = entity;
+			record.parent = parent;
+			if (debugData) {
+				record.id = debugData->stringId;
+			}
+			if (transform) {
+				PropertiesModule::BinaryWriter writer(record.transform);
+				transform->serialize(writer);
+			}
+			if (modelComp) {
+				record.hasModel = true;
+				record.model = modelComp->mPath;
+			}
+		}
+
+		mLastDelta = records.size();
+		mSnapshotTimes.add(CoreModule::monotonicNs() - start);
+		if (records.empty()) {
+			return;
+		}
+
+		mSave = ThreadPool::instance()->addTask<WorkerType::RESOURCE_LOADING>([this, records = std::move(records), path = mPath, root = mRoot]() mutable {
+			const auto writeStart = CoreModule::monotonicNs();
+			applyDelta(records);
+			if (writeScene(path, root)) {
+				mSaves++;
+			}
+			else {
+				mFailedSaves++;
+			}
+			mLastWriteNs = CoreModule::monotonicNs() - writeStart;
+		});
+	}
+
+	bool AutosaveSystem::isSaving() const {
+		return mSave.valid() && mSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+	}
+
+	void AutosaveSystem::applyDelta(std::vector<NodeRecord>& records) {
+		//nodes of removed node aren't reachable from root anymore, so they aren't written until they are moved to scene again
+		for (auto& record : records) {
+			if (record.removed) {
+				mSavedNodes.erase(record.entity);
+				continue;
+			}
+
+			auto& node = mSavedNodes[record.entity];
+			node.parent = record.parent;
+			node.id = std::move(record.id);
+			node.transform = std::move(record.transform);
+			node.hasModel = record.hasModel;
+			node.model = std::move(record.model);
+		}
+	}
+
+	bool AutosaveSystem::writeScene(const std::string& path, ecss::EntityId root) {
+		std::unordered_map<ecss::EntityId, std::vector<ecss::EntityId>> children;
+		for (const auto& [entity, node] : mSavedNodes) {
+			if (node.parent != ecss::INVALID_ID) {
+				children[node.parent].push_back(entity);
+			}
+		}
+
+		//nodes are written parent first
+		PropertiesModule::SceneFile scene;
+		std::vector<std::pair<ecss::EntityId, uint32_t>> stack = { { root, PropertiesModule::SceneFile::NO_PARENT } };
+		while (!stack.empty()) {
+			const auto [entity, parent] = stack.back();
+			stack.pop_back();
+
+			const auto it = mSavedNodes.find(entity);
+			if (it == mSavedNodes.end()) {
+				continue;
+			}
+
+			const auto& node = it->second;
+			const auto index = scene.addNode(parent, node.id);
+			if (!node.transform.empty()) {
+				scene.getBlock(PropertiesModule::SceneFile::BlockType::TRANSFORM).addRecord(index, [&node](PropertiesModule::BinaryWriter& writer) {
+					writer.write(node.transform.data(), node.transform.size());
+				});
+			}
+			if (node.hasModel) {
+				const auto model = scene.addModel(node.model);
+				scene.getBlock(PropertiesModule::SceneFile::BlockType::MODEL).addRecord(index, [model](PropertiesModule::BinaryWriter& writer) { writer.write(model); });
+			}
+
+			if (auto nodeChildren = children.find(entity); nodeChildren != children.end()) {
+				std::ranges::sort(nodeChildren->second, std::greater{});
+				for (const auto child : nodeChildren->second) {
+					stack.emplace_back(child, index);
+				}
+			}
+		}
+
+		std::vector<uint8_t> data;
+		scene.write(data);
+		mLastWriteBytes = data.size();
+
+		//previous save stays whole if write fails or is interrupted
+		const auto tempPath = path + ".tmp";
+		if (!FileSystem::writeBinaryFile(tempPath, data.data(), data.size())) {
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, path, error);
+		if (error) {
+			SFE_LOG_ERROR("AutosaveSystem::can not replace %s: %s", path.c_str(), error.message().c_str());
+			return false;
+		}
+		return true;
+	}
+
+	void AutosaveSystem::debugUpdate(float dt) {
+		if (!debugData.mWindow) {
+			return;
+		}
+
+		if (ImGui::Begin("Autosave", &debugData.mWindow)) {
+			ImGui::Checkbox("enabled", &debugData.mEnabled);
+			ImGui::DragFloat("interval, s", &intervalSeconds, 1.f, 1.f, 600.f);
+			if (ImGui::Button("save now")) {
+				requestSave();
+			}
+
+			std::string path;
+			{
+				std::lock_guard lock(mJournalMutex);
+				path = mPath;
+			}
+
+			const auto stats = mSnapshotTimes.getStats();
+			ImGui::Text("path: %s", path.c_str());
+			ImGui::Text("last delta: %zu nodes", mLastDelta.load());
+			ImGui::Text("snapshot: avg %.3f ms, max %.3f ms", stats.avgMs, stats.maxMs);
+			ImGui::Text("last write: %.2f ms, %zu bytes", static_cast<double>(mLastWriteNs.load()) / 1'000'000.0, mLastWriteBytes.load());
+			ImGui::Text("saves: %zu, failed: %zu", mSaves.load(), mFailedSaves.load());
+		}
+		ImGui::End();
+	}
+}
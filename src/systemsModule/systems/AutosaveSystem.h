@@ -0,0 +1,109 @@
+﻿#pragma once
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "systemsModule/SystemBase.h"
+#include "core/FramePacing.h"
+
+namespace SFE::SystemsModule {
+	struct AutosaveDebugData {
+		bool mEnabled = true;
+		bool mWindow = true;
+	};
+
+	//scene is saved by deltas: transform and node notifications give changed entities, main thread copies only nodes which record
+	//(transform version, parent, id and model) differs from saved one, saver thread applies them to its own copy of scene and writes
+	//binary scene to temporary file which replaces previous save. node which comes into scene brings its subtree with it
+	class AutosaveSystem : public ecss::System {
+	public:
+		AutosaveSystem();
+		~AutosaveSystem() override;
+
+		void notify(Task task) override;
+		void notifyBatch(const std::vector<ecss::EntityId>& entities, TaskType type) override;
+		void update(float dt) override;
+		void debugUpdate(float dt) override;
+
+		void* getDebugData() override { return &debugData; }
+
+		//scene is taken on the next update, its first save has all nodes
+		void track(ecss::EntityId root, std::string path);
+		//changes are saved on the next update without waiting for interval
+		void requestSave() { mSaveRequested = true; }
+
+		float intervalSeconds = 30.f;
+
+	private:
+		//copy of node which was changed since the last save
+		struct NodeRecord {
+			ecss::EntityId entity = ecss::INVALID_ID;
+			ecss::EntityId parent = ecss::INVALID_ID;
+			bool removed = false;
+			std::string id;
+			std::vector<uint8_t> transform; //serialized component, empty if node has no transform
+			bool hasModel = false;
+			std::string model;
+		};
+
+		//what main thread knows about saved node, node is copied again when any part differs
+		struct SavedVersion {
+			uint64_t transform = 0;
+			ecss::EntityId parent = ecss::INVALID_ID;
+			size_t id = 0;
+			size_t model = 0;
+
+			bool operator==(const SavedVersion&) const = default;
+		};
+
+		struct SavedNode {
+			ecss::EntityId parent = ecss::INVALID_ID;
+			std::string id;
+			std::vector<uint8_t> transform;
+			bool hasModel = false;
+			std::string model;
+		};
+
+		void startTracking(ecss::EntityId root, std::string path);
+		bool isInScene(ecss::EntityId entity, ecss::EntityId& parent) const;
+		void takeSnapshot();
+		bool isSaving() const;
+
+		//saver thread
+		void applyDelta(std::vector<NodeRecord>& records);
+		bool writeScene(const std::string& path, ecss::EntityId root);
+
+		AutosaveDebugData debugData;
+
+		std::mutex mJournalMutex;
+		std::vector<ecss::EntityId> mChangedEntities;
+		std::atomic_bool mTracking = false;
+		ecss::EntityId mPendingRoot = ecss::INVALID_ID;
+		std::string mPendingPath;
+
+		//main thread, path is written under journal mutex because debug window reads it on render thread
+		ecss::EntityId mRoot = ecss::INVALID_ID;
+		std::string mPath;
+		std::unordered_map<ecss::EntityId, SavedVersion> mSavedVersions;
+		float mTimer = 0.f;
+		std::atomic_bool mSaveRequested = false;
+		std::shared_future<void> mSave;
+
+		//saver thread, only one save is in flight
+		std::unordered_map<ecss::EntityId, SavedNode> mSavedNodes;
+
+		CoreModule::FrameTimeHistogram mSnapshotTimes{ 64 };
+		std::atomic_size_t mLastDelta = 0;
+		std::atomic<int64_t> mLastWriteNs = 0;
+		std::atomic_size_t mLastWriteBytes = 0;
+		std::atomic_size_t mSaves = 0;
+		std::atomic_size_t mFailedSaves = 0;
+
+		//journal of entities is compacted when it grows over this size between saves
+		constexpr static inline size_t JOURNAL_COMPACT_SIZE = 1 << 16;
+		constexpr static inline size_t MAX_TREE_DEPTH = 256;
+	};
+}
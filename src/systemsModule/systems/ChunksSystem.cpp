@@ -1,127 +1,295 @@
 ﻿#include "ChunksSystem.h"
 
-#include <random>
+#include <algorithm>
+#include <filesystem>
 
-#include "CameraSystem.h"
 #include "imgui.h"
 #include "OcTreeSystem.h"
+#include "assetsModule/ChunkCooker.h"
 #include "assetsModule/modelModule/ModelLoader.h"
-#include "componentsModule/CameraComponent.h"
-#include "componentsModule/IsDrawableComponent.h"
-#include "componentsModule/ModelComponent.h"
-#include "componentsModule/OcTreeComponent.h"
 #include "componentsModule/TransformComponent.h"
 #include "core/ECSHandler.h"
-#include "debugModule/Benchmark.h"
+#include "core/FileSystem.h"
+#include "logsModule/logger.h"
+#include "propertiesModule/PropertiesSystem.h"
+#include "renderModule/Utils.h"
 
 namespace SFE::SystemsModule {
-	ChunksSystem::ChunksSystem() : System({ SFE::SystemsModule::TaskType::CAMERA_UPDATED }) {
-		//ChunksSystem::updateAsync({ ECSHandler::getSystem<CameraSystem>()->getCurrentCamera() });
+	ChunksSystem::ChunksSystem() : System({ SFE::SystemsModule::TaskType::CAMERA_UPDATED }) {}
+
+	uint64_t ChunksSystem::getKey(const Chunk& chunk) {
+		constexpr auto BITS = 21;
+		constexpr auto MASK = (uint64_t{ 1 } << BITS) - 1;
+		return (static_cast<uint64_t>(chunk.x) & MASK) << BITS * 2 | (static_cast<uint64_t>(chunk.y) & MASK) << BITS | (static_cast<uint64_t>(chunk.z) & MASK);
 	}
 
-	void ChunksSystem::updateAsync(const std::vector<ecss::SectorId>& entitiesToProcess) {
-		auto curCam = entitiesToProcess.front();
-		auto curChunkCoords = ECSHandler::registry().getComponent<TransformComponent>(curCam)->getPos(true);
+	int ChunksSystem::getDistance(const Chunk& lhs, const Chunk& rhs) {
+		return std::max({ std::abs(lhs.x - rhs.x), std::abs(lhs.y - rhs.y), std::abs(lhs.z - rhs.z) });
+	}
 
-		auto calcMinus = [size = static_cast<int>(CHUNK_SIZE)](float val) {
-			auto remainder = [size](float val) {
-				return static_cast<int>(std::fabs(val)) % size;
-			};
-			val = std::round(val);
-			if (val < 0.f) {
-				return val + remainder(val) - size;
+	ChunksSystem::Chunk ChunksSystem::getChunk(const Math::Vec3& pos) const {
+		return AssetsModule::ChunkFile::getChunk(pos, CHUNK_SIZE);
+	}
+
+	Math::Vec3 ChunksSystem::getCenter(const Chunk& chunk) const {
+		return Math::Vec3{ static_cast<float>(chunk.x) + 0.5f, static_cast<float>(chunk.y) + 0.5f, static_cast<float>(chunk.z) + 0.5f } * CHUNK_SIZE;
+	}
+
+	size_t ChunksSystem::cookScene(std::string_view scenePath, std::string_view directory) {
+		using PropertiesModule::SceneFile;
+
+		SceneFile scene;
+		if (scenePath.ends_with(SceneFile::EXTENSION)) {
+			std::vector<uint8_t> data;
+			if (!FileSystem::readBinaryFile(scenePath, data) || !scene.read(data)) {
+				SFE_LOG_ERROR("ChunksSystem::cookScene %s is not a scene of version %u", scenePath.data(), SceneFile::VERSION);
+				return 0;
 			}
-			else if (val > 0.f) {
-				return val - remainder(val);
+		}
+		else {
+			Json::Value json;
+			if (!FileSystem::readJson(scenePath, json)) {
+				return 0;
 			}
+			PropertiesModule::PropertiesSystem::fillSceneFile(json, scene);
+		}
 
-			return 0.f;
-		};
+		//chunk which became empty would be streamed with old content otherwise
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		for (auto it = std::filesystem::directory_iterator(directory, error); !error && it != std::filesystem::directory_iterator(); it.increment(error)) {
+			if (it->path().extension() == ".chunk") {
+				std::filesystem::remove(it->path(), error);
+			}
+		}
 
-		curChunkCoords.x = calcMinus(curChunkCoords.x);
-		curChunkCoords.y = calcMinus(curChunkCoords.y);
-		curChunkCoords.z = calcMinus(curChunkCoords.z);
+		size_t written = 0;
+		std::vector<uint8_t> data;
+		for (const auto& chunk : AssetsModule::ChunkCooker::split(scene, CHUNK_SIZE)) {
+			chunk.file.write(data);
+			written += FileSystem::writeBinaryFile(AssetsModule::ChunkFile::getPath(chunk.coords, directory), data.data(), data.size());
+		}
+
+		SFE_LOG_INFO("ChunksSystem::cookScene %s is split into %zu chunks", scenePath.data(), written);
+		return written;
+	}
+
+	void ChunksSystem::updateAsync(const std::vector<ecss::SectorId>& entitiesToProcess) {
+		const auto transform = ECSHandler::registry().getComponent<TransformComponent>(entitiesToProcess.front());
+		if (!transform) {
+			return;
+		}
+		const auto pos = transform->getPos(true);
+		const auto now = CoreModule::monotonicNs();
+
+		std::lock_guard lock(mMutex);
+		//velocity is smoothed, so single jump of camera doesn't turn priorities around
+		if (mCameraTime) {
+			const auto seconds = static_cast<float>(now - mCameraTime) / 1'000'000'000.f;
+			if (seconds > 0.f) {
+				mCameraVelocity = Math::mix(mCameraVelocity, (pos - mCameraPos) / seconds, 0.25f);
+			}
+		}
+		mCameraPos = pos;
+		mCameraTime = now;
 
-		if (mCurrentChunk == curChunkCoords) {
+		const auto current = getChunk(pos);
+		if (current == mCurrentChunk) {
 			return;
 		}
+		mCurrentChunk = current;
 
-		mCurrentChunk = curChunkCoords;
-		mDeleted = 0;
-		mCreated = 0;
+		if (debugData.mClear) {
+			for (auto it = mChunks.begin(); it != mChunks.end();) {
+				auto& data = it->second;
+				if (getDistance(data.coords, current) <= CHUNK_DEEP + UNLOAD_MARGIN) {
+					++it;
+					continue;
+				}
 
-		std::vector<Chunk> chunkClearTasksQueue = mChunks;
-		std::vector<Chunk> chunkLoadTasksQueue;
+				if (data.state == State::LOADING) {
+					data.unloaded = true;
+					++it;
+					continue;
+				}
 
-		mChunks.clear();
-		for (float x = -CHUNK_DEEP; x <= CHUNK_DEEP; x++) {
-			for (float y = -CHUNK_DEEP; y <= CHUNK_DEEP; y++) {
-				for (float z = -CHUNK_DEEP; z <= CHUNK_DEEP; z++) {
-					mChunks.emplace_back(mCurrentChunk + Math::Vec3{ x, y, z } * CHUNK_SIZE);
-					auto it = std::find(chunkClearTasksQueue.begin(), chunkClearTasksQueue.end(), mChunks.back());
-					if (it == chunkClearTasksQueue.end()) {
-						chunkLoadTasksQueue.emplace_back(mChunks.back());
+				unloadChunk(data);
+				it = mChunks.erase(it);
+			}
+		}
+
+		for (int x = -CHUNK_DEEP; x <= CHUNK_DEEP; x++) {
+			for (int y = -CHUNK_DEEP; y <= CHUNK_DEEP; y++) {
+				for (int z = -CHUNK_DEEP; z <= CHUNK_DEEP; z++) {
+					const auto chunk = current + Chunk{ x, y, z };
+					const auto key = getKey(chunk);
+					auto [it, inserted] = mChunks.try_emplace(key);
+					if (inserted) {
+						it->second.coords = chunk;
+						mQueued.push_back(key);
 					}
 					else {
-						chunkClearTasksQueue.erase(it);
+						//camera came back before file of chunk was read
+						it->second.unloaded = false;
 					}
 				}
 			}
 		}
 
-		if (!mUpdateQueue.empty()) {
-			mUpdateQueue.push({ std::move(chunkLoadTasksQueue), std::move(chunkClearTasksQueue) });
+		dispatchLoads();
+	}
+
+	void ChunksSystem::dispatchLoads() {
+		if (!debugData.mCreate) {
 			return;
 		}
 
-		mUpdateQueue.push({ std::move(chunkLoadTasksQueue), std::move(chunkClearTasksQueue) });
-		ThreadPool::instance()->addTask([this] {
-			while (!mUpdateQueue.empty()) {
-				auto taskContainers = mUpdateQueue.front();
-				if (debugData.mClear) {
-					std::vector<ecss::SectorId> entitiesToDelete;
-					for (auto& chunk : taskContainers.second) {
-						clearChunk(chunk);
-						ECSHandler::getSystem<OcTreeSystem>()->forEachOctreeInAABB(FrustumModule::AABB{{chunk + CHUNK_SIZE * 0.5f}, CHUNK_SIZE * 0.5f, CHUNK_SIZE * 0.5f, CHUNK_SIZE * 0.5f}, [&entitiesToDelete](OcTreeSystem::SysOcTree& octree) mutable {
-							auto lock = octree.readLock();
-							octree.forEach([octree, &entitiesToDelete](auto& obj) mutable {
-								auto octreeComp = ECSHandler::registry().getComponent<OcTreeComponent>(obj.data);
-								assert(octreeComp);
-								if (!octreeComp->mParentOcTrees.empty()) {
-									auto it = std::find(octreeComp->mParentOcTrees.begin(), octreeComp->mParentOcTrees.end(), octree.mPos);
-									if (it != octreeComp->mParentOcTrees.end()) {
-										octreeComp->mParentOcTrees.erase(it);
-									}
-									
-								}
-								
-								if (octreeComp->mParentOcTrees.empty()) {
-									entitiesToDelete.push_back(obj.data);
-								}
-							});
-							lock.unlock();
-							octree.clear();
-							/*auto wLock = octree.writeLock();
-							ECSHandler::getSystem<OcTreeSystem>()->deleteOctree(octree.mPos);
-							wLock.unlock();*/
-						});
-					}
+		//chunks which were unloaded or are already loading stay in queue until here
+		std::erase_if(mQueued, [this](uint64_t key) {
+			const auto it = mChunks.find(key);
+			return it == mChunks.end() || it->second.state != State::QUEUED;
+		});
 
-					mDeleted += entitiesToDelete.size();
-					ECSHandler::registry().destroyEntities(entitiesToDelete);
-				}
+		//queue is short, so the nearest chunk to predicted camera position is searched only when there is free loading slot
+		const auto predicted = mCameraPos + mCameraVelocity * predictionSeconds;
+		while (mLoadsInFlight < MAX_LOADS_IN_FLIGHT && !mQueued.empty()) {
+			const auto best = std::min_element(mQueued.begin(), mQueued.end(), [this, &predicted](uint64_t lhs, uint64_t rhs) {
+				return Math::lengthSquared(getCenter(mChunks[lhs].coords) - predicted) < Math::lengthSquared(getCenter(mChunks[rhs].coords) - predicted);
+			});
 
-				for (auto& chunk : taskContainers.first) {
-					loadChunk(chunk);
-				}
-				mFutures.waitAll();
-				mUpdateQueue.pop();
+			auto& data = mChunks[*best];
+			data.state = State::LOADING;
+			mLoadsInFlight++;
+			ThreadPool::instance()->addTask<WorkerType::RESOURCE_LOADING>([this, chunk = data.coords] {
+				loadChunk(chunk);
+			});
+			mQueued.erase(best);
+		}
+	}
+
+	void ChunksSystem::readChunk(Chunk chunk, AssetsModule::ChunkFile& file, std::vector<std::unique_ptr<CoreModule::Prefab>>& prefabs) {
+		//chunk without file is empty space, it becomes resident too, so it isn't requested again
+		const auto path = AssetsModule::ChunkFile::getPath(chunk);
+		if (!FileSystem::isFileExists(path)) {
+			return;
+		}
+
+		std::vector<uint8_t> data;
+		if (!FileSystem::readBinaryFile(path, data)) {
+			SFE_LOG_ERROR("ChunksSystem::readChunk can't read %s", path.c_str());
+			return;
+		}
+
+		//broken chunk stays empty, nothing of partly read file is instantiated
+		if (!file.read(data)) {
+			SFE_LOG_ERROR("ChunksSystem::readChunk %s is not a chunk of version %u", path.c_str(), AssetsModule::ChunkFile::VERSION);
+			file = {};
+			return;
+		}
+
+		//models are loaded and prefabs are built on this thread, main thread only creates entities
+		prefabs.reserve(file.models.size());
+		for (const auto& model : file.models) {
+			prefabs.push_back(std::make_unique<CoreModule::Prefab>(AssetsModule::ModelLoader::instance()->load(model)));
+		}
+	}
+
+	void ChunksSystem::loadChunk(Chunk chunk) {
+		auto file = std::make_unique<AssetsModule::ChunkFile>();
+		std::vector<std::unique_ptr<CoreModule::Prefab>> prefabs;
+		readChunk(chunk, *file, prefabs);
+
+		std::lock_guard lock(mMutex);
+		mLoadsInFlight--;
+
+		const auto key = getKey(chunk);
+		const auto it = mChunks.find(key);
+		if (it != mChunks.end() && it->second.state == State::LOADING) {
+			if (it->second.unloaded) {
+				mChunks.erase(it);
 			}
-		});
+			else {
+				it->second.state = State::LOADED;
+				it->second.file = std::move(file);
+				it->second.prefabs = std::move(prefabs);
+				mLoaded.push_back(key);
+			}
+		}
+
+		dispatchLoads();
+	}
+
+	void ChunksSystem::unloadChunk(ChunkData& data) {
+		if (!data.entities.empty()) {
+			mUnloadedEntities.push_back(std::move(data.entities));
+		}
+	}
+
+	void ChunksSystem::update(float dt) {
+		const auto start = CoreModule::monotonicNs();
+		const auto deadline = start + static_cast<int64_t>(instantiateBudgetMs * 1'000'000.f);
+
+		std::unique_lock lock(mMutex);
+		auto unloaded = std::move(mUnloadedEntities);
+		mUnloadedEntities.clear();
+
+		const auto created = mCreated.load();
+		size_t finished = 0;
+		for (; finished < mLoaded.size(); finished++) {
+			const auto it = mChunks.find(mLoaded[finished]);
+			if (it == mChunks.end() || it->second.state != State::LOADED) {
+				continue;
+			}
+
+			if (!instantiate(it->second, deadline)) {
+				break;
+			}
+
+			it->second.state = State::RESIDENT;
+			it->second.file.reset();
+			it->second.prefabs.clear();
+		}
+		mLoaded.erase(mLoaded.begin(), mLoaded.begin() + finished);
+		lock.unlock();
+
+		for (auto& entities : unloaded) {
+			mDeleted += entities.size();
+			CoreModule::Prefab::destroy(entities);
+		}
+
+		mInstantiatedLastFrame = mCreated - created;
+		if (mInstantiatedLastFrame || !unloaded.empty()) {
+			mInstantiateTimes.add(CoreModule::monotonicNs() - start);
+		}
+	}
 
+	bool ChunksSystem::instantiate(ChunkData& data, int64_t deadline) {
+		//instances of the same model are created by slices, clock is read between slices
+		constexpr size_t SLICE_SIZE = 64;
+
+		const auto& instances = data.file->instances;
+		std::vector<CoreModule::Prefab::Placement> placements;
+		placements.reserve(SLICE_SIZE);
+		while (data.nextInstance < instances.size()) {
+			if (CoreModule::monotonicNs() >= deadline) {
+				return false;
+			}
+
+			const auto model = instances[data.nextInstance].model;
+			placements.clear();
+			while (data.nextInstance < instances.size() && placements.size() < SLICE_SIZE && instances[data.nextInstance].model == model) {
+				const auto& instance = instances[data.nextInstance++];
+				placements.push_back({ instance.pos, instance.rotate, instance.scale });
+			}
+
+			data.prefabs[model]->instantiate(placements, data.entities);
+			mCreated += placements.size();
+		}
+
+		return true;
 	}
 
-	void ChunksSystem::debugUpdate(float dt) {		
+	void ChunksSystem::debugUpdate(float dt) {
 		if (debugData.mChunksDraw) {
 			constexpr static Math::Mat4 rotate = {
 					{1.f,0.f,0.f,0.f},
@@ -130,66 +298,65 @@ namespace SFE::SystemsModule {
 					{0.f,0.f,0.f,1.f}
 			};
 
-			for (auto& chunkPos : mChunks) {
-
-				constexpr static auto notEmptyColor = Math::Vec4(0.5f, 0.5f, 0.5f, 0.08f);
+			constexpr static auto residentColor = Math::Vec4(0.5f, 0.5f, 0.5f, 0.08f);
+			constexpr static auto loadingColor = Math::Vec4(0.8f, 0.6f, 0.1f, 0.08f);
 
+			std::lock_guard lock(mMutex);
+			for (const auto& [key, data] : mChunks) {
 				Render::Utils::renderCubeMesh(
 					Math::Vec3(0.f, 0.f, 0.f),
 					Math::Vec3(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE),
-					rotate, Math::Vec3(chunkPos), notEmptyColor
+					rotate, Math::Vec3(data.coords) * CHUNK_SIZE, data.state == State::RESIDENT ? residentColor : loadingColor
 				);
 			}
 		}
-	}
-
-	void ChunksSystem::clearChunk(const Chunk& chunk) {
-		if (!debugData.mClear) {
-			return;
-		}		
-	}
 
-	void ChunksSystem::loadChunk(const Chunk& chunk) {
-		if (!debugData.mCreate) {
+		if (!debugData.mWindow) {
 			return;
 		}
-		return;
-		mFutures.add(ThreadPool::instance()->addTask([this, chunk]() {
-			auto cubeModel = AssetsModule::ModelLoader::instance()->load("models/cube.fbx");
-			float step = 250.f;
-
-			std::random_device rd;
-			std::mt19937 generator(rd());
-
-			// Define the distribution for the range -5.0f to 15.0f
-			std::uniform_real_distribution<float> distribution(-5.0f, 15.0f);
-			std::uniform_real_distribution<float> distribution1(1.f, 3.0f);
-			std::uniform_int_distribution<int> distribution2(0, 1);
-
-			//ECSHandler::registry().reserve<SFE::ComponentsModule::AABBComponent, OcTreeComponent, ModelComponent, TransformComponent>(24*24*24);
-
-			for (auto i = 1; i < 33; i+=1) {
-				for (auto y = 1; y < 33; y+=1) {
-					for (auto z = 1; z < 33 ; z+=1) {
-						if (distribution2(generator)) {
-							continue;
-						}
-						auto cube = ECSHandler::registry().takeEntity();
-						++mCreated;
-
-						float randomValue = distribution(generator);
-						float randomValue2 = distribution1(generator);
-						ECSHandler::registry().addComponent<SFE::ComponentsModule::AABBComponent>(cube);
-						ECSHandler::registry().addComponent<OcTreeComponent>(cube);
-						/*ECSHandler::registry().addComponentWithInit<ModelComponent>(cube, [cubeModel](ModelComponent* comp) { comp->init(cubeModel); }, cube);
-						ECSHandler::registry().addComponentWithInit<TransformComponent>(cube, [chunk, i ,step,y,z, randomValue, randomValue2](TransformComponent* comp) {
-							comp->setPos(chunk + Math::Vec3{ i* step, y* step + randomValue, z* step });
-							comp->setScale({ randomValue2 * 0.1f, randomValue2 * 0.1f, randomValue2 * 0.1f });
-						}, cube);*/
-					}
+
+		if (ImGui::Begin("Chunks", &debugData.mWindow)) {
+			ImGui::Checkbox("load", &debugData.mCreate);
+			ImGui::Checkbox("unload", &debugData.mClear);
+			ImGui::Checkbox("draw chunks", &debugData.mChunksDraw);
+			ImGui::DragFloat("instantiate budget, ms", &instantiateBudgetMs, 0.1f, 0.1f, 16.f);
+			ImGui::DragFloat("prediction, s", &predictionSeconds, 0.05f, 0.f, 5.f);
+
+			//chunks which are already resident keep old content until they are unloaded
+			ImGui::InputText("scene", debugData.mCookPath.data(), debugData.mCookPath.size());
+			ImGui::SameLine();
+			if (mCooking) {
+				ImGui::Text("cooking...");
+			}
+			else if (ImGui::Button("cook")) {
+				mCooking = true;
+				ThreadPool::instance()->addTask<WorkerType::RESOURCE_LOADING>([this, path = std::string(debugData.mCookPath.data())] {
+					cookScene(path);
+					mCooking = false;
+				});
+			}
+
+			size_t resident = 0;
+			size_t pendingUnloads = 0;
+			{
+				std::lock_guard lock(mMutex);
+				for (const auto& [key, data] : mChunks) {
+					resident += data.state == State::RESIDENT;
+				}
+				for (const auto& entities : mUnloadedEntities) {
+					pendingUnloads += entities.size();
 				}
+
+				ImGui::Text("chunk: %d %d %d", mCurrentChunk.x, mCurrentChunk.y, mCurrentChunk.z);
+				ImGui::Text("chunks: %zu, resident: %zu", mChunks.size(), resident);
+				ImGui::Text("queued: %zu, loading: %zu, waiting for instantiation: %zu", mQueued.size(), mLoadsInFlight, mLoaded.size());
 			}
-		}));
+
+			const auto stats = mInstantiateTimes.getStats();
+			ImGui::Text("instantiated last frame: %zu, entities waiting for release: %zu", mInstantiatedLastFrame, pendingUnloads);
+			ImGui::Text("instantiation: avg %.2f ms, p99 %.2f ms, max %.2f ms", stats.avgMs, stats.p99Ms, stats.maxMs);
+			ImGui::Text("created: %zu, deleted: %zu", mCreated.load(), mDeleted.load());
+		}
+		ImGui::End();
 	}
 }
-
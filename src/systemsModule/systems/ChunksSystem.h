@@ -1,41 +1,105 @@
 ﻿#pragma once
+#include <array>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 #include "systemsModule/SystemBase.h"
 #include "mathModule/Forward.h"
 #include "OcTreeSystem.h"
+#include "assetsModule/ChunkFile.h"
+#include "core/FramePacing.h"
+#include "core/Prefab.h"
 
 namespace SFE::SystemsModule {
 	struct ChunksDebugData {
 		bool mCreate = true;
 		bool mClear = true;
 		bool mChunksDraw = false;
+		bool mWindow = true;
+		std::array<char, 256> mCookPath = { "shadowsTest.json" };
 	};
 
+	//chunks around camera are streamed: cooked chunk files are read on loading threads in order of distance to predicted camera position,
+	//their entities are instantiated on main thread under time budget, chunks are unloaded only when camera went farther than load radius plus margin
 	class ChunksSystem : public ecss::System {
 	public:
-		using Chunk = Math::Vec3;
+		using Chunk = Math::IVec3;
 
 		ChunksSystem();
+		void update(float dt) override;
 		void updateAsync(const std::vector<ecss::SectorId>& entitiesToProcess) override;
 		void debugUpdate(float dt) override;
 
-		void clearChunk(const Chunk& chunk);
-		void loadChunk(const Chunk& chunk);
-
 		void* getDebugData() override { return &debugData; }
 
+		//splits json or binary scene into chunk files of this system, files of previous cook are removed, returns count of written chunks
+		static size_t cookScene(std::string_view scenePath, std::string_view directory = AssetsModule::ChunkFile::DIRECTORY);
+
+		//time of main thread which entities instantiation can take every frame
+		float instantiateBudgetMs = 2.f;
+		//camera position is predicted this far ahead, chunks in front of moving camera are loaded first
+		float predictionSeconds = 1.f;
+
 	private:
+		enum class State : uint8_t {
+			QUEUED,
+			LOADING,
+			LOADED,
+			RESIDENT
+		};
+
+		struct ChunkData {
+			Chunk coords;
+			State state = State::QUEUED;
+			//chunk which went out of range during loading is erased when its file is read
+			bool unloaded = false;
+			std::unique_ptr<AssetsModule::ChunkFile> file;
+			std::vector<std::unique_ptr<CoreModule::Prefab>> prefabs;
+			size_t nextInstance = 0;
+			std::vector<ecss::EntityId> entities;
+		};
+
+		static uint64_t getKey(const Chunk& chunk);
+		static int getDistance(const Chunk& lhs, const Chunk& rhs);
+		Chunk getChunk(const Math::Vec3& pos) const;
+		Math::Vec3 getCenter(const Chunk& chunk) const;
+
+		//called under mutex
+		void dispatchLoads();
+		void loadChunk(Chunk chunk);
+		//file and prefabs stay empty when chunk has no file or it is broken
+		static void readChunk(Chunk chunk, AssetsModule::ChunkFile& file, std::vector<std::unique_ptr<CoreModule::Prefab>>& prefabs);
+		void unloadChunk(ChunkData& data);
+		//returns false when budget ended before all instances of chunk were created
+		bool instantiate(ChunkData& data, int64_t deadline);
+
 		ChunksDebugData debugData;
 
-		std::vector<Chunk> mChunks;
-		Chunk mCurrentChunk;
-		
+		std::mutex mMutex;
+		std::unordered_map<uint64_t, ChunkData> mChunks;
+		std::vector<uint64_t> mQueued;
+		std::vector<uint64_t> mLoaded;
+		std::vector<std::vector<ecss::EntityId>> mUnloadedEntities;
+		size_t mLoadsInFlight = 0;
+
+		Chunk mCurrentChunk = { std::numeric_limits<int>::max() };
+		Math::Vec3 mCameraPos = {};
+		Math::Vec3 mCameraVelocity = {};
+		int64_t mCameraTime = 0;
+
+		CoreModule::FrameTimeHistogram mInstantiateTimes{ 256 };
+		size_t mInstantiatedLastFrame = 0;
 		std::atomic_size_t mDeleted = 0;
 		std::atomic_size_t mCreated = 0;
-		
-		std::queue<std::pair<std::vector<Chunk>, std::vector<Chunk>>> mUpdateQueue;
+		std::atomic_bool mCooking = false;
 
-		FuturesBunch mFutures;
 		constexpr static inline float CHUNK_SIZE = OcTreeSystem::OCTREE_SIZE * 2;//this size should be divided by octree size
-		constexpr static inline uint8_t CHUNK_DEEP = 1;
+		constexpr static inline int CHUNK_DEEP = 1;
+		//hysteresis, chunk is unloaded when it is farther than CHUNK_DEEP + UNLOAD_MARGIN chunks
+		constexpr static inline int UNLOAD_MARGIN = 1;
+		constexpr static inline size_t MAX_LOADS_IN_FLIGHT = 4;
 	};
 }
@@ -22,12 +22,12 @@ void LODSystem::update(float_t dt) {
 	}
 
 	auto playerPos = ECSHandler::registry().getComponent<TransformComponent>(playerCamera)->getPos(true);
-	for (const auto& [entity, isDraw, transform, lodObject] : ECSHandler::registry().forEach<const IsDrawableComponent, const TransformComponent, ModelComponent>()) {
-		if (!isDraw) {
-			continue;
+	ECSHandler::parallelForEach<const IsDrawableComponent, const TransformComponent, ModelComponent>(256, [playerPos](ecss::EntityId entity, const IsDrawableComponent* isDraw, const TransformComponent* transform, ModelComponent* lodObject) {
+		if (!isDraw || !transform) {
+			return;
 		}
 		if (!lodObject) {
-			continue;
+			return;
 		}
 		float value = 0.f;
 		//if (lodObject.getLodType() == ComponentsModule::eLodType::SCREEN_SPACE) {
@@ -53,7 +53,7 @@ void LODSystem::update(float_t dt) {
 
 		lodObject->mLOD.setLodLevel(lodLevel);
 		lodObject->mLOD.setCurrentLodValue(value);
-	}
+	});
 }
 
 //float LODSystem::calculateScreenSpaceArea(const AssetsModule::Mesh* mesh, const ecss::EntityHandle& camera, TransformComponent* meshTransform) {
@@ -1,48 +1,303 @@
 ﻿#include "PhysicsSystem.h"
 
+#include <algorithm>
+
+#include "imgui.h"
 #include "componentsModule/TransformComponent.h"
+#include "componentsModule/TreeComponent.h"
 #include "Jolt/Renderer/DebugRenderer.h"
 #include "renderModule/Utils.h"
+#include "systemsModule/systems/RenderSystem.h"
 
 namespace SFE::SystemsModule {
 
 	using namespace JPH;
 
-	void Physics::update(float dt) {
+	namespace {
+		bool isSameRotation(const Math::Quaternion<float>& lhs, const Math::Quaternion<float>& rhs) {
+			return lhs.w == rhs.w && lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+		}
+	}
+
+	void Physics::notify(Task task) {
+		std::lock_guard lock(mJournalMutex);
+		mMovedEntities.push_back(task.entity);
+	}
+
+	void Physics::notifyBatch(const std::vector<ecss::EntityId>& entities, TaskType type) {
+		std::lock_guard lock(mJournalMutex);
+		mMovedEntities.insert(mMovedEntities.end(), entities.begin(), entities.end());
+	}
+
+	PhysicsComponent* Physics::addBody(ecss::EntityId entity, BodyCreationSettings settings, EActivation activation) {
+		settings.mUserData = entity;
+		const auto id = physics_system->GetBodyInterface().CreateAndAddBody(settings, activation);
+		if (id.IsInvalid()) {
+			return nullptr;
+		}
+
+		auto component = ECSHandler::registry().addComponent<PhysicsComponent>(entity, id);
+		component->lastPos = toVec3(settings.mPosition);
+		component->lastRotation = toQuat(settings.mRotation);
+		return component;
+	}
+
+	void Physics::removeBody(const BodyID& id) {
+		std::lock_guard lock(mRemovedMutex);
+		mRemovedBodies.push_back(id);
+	}
+
+	void Physics::removeBodies() {
+		{
+			std::lock_guard lock(mRemovedMutex);
+			std::swap(mRemovedBodies, mRemovingBodies);
+		}
+
+		if (!mRemovingBodies.empty()) {
+			auto& bodyInterface = physics_system->GetBodyInterface();
+			bodyInterface.RemoveBodies(mRemovingBodies.data(), static_cast<int>(mRemovingBodies.size()));
+			bodyInterface.DestroyBodies(mRemovingBodies.data(), static_cast<int>(mRemovingBodies.size()));
+
+			//removed bodies were deactivated, they shouldn't be synced
+			std::sort(mRemovingBodies.begin(), mRemovingBodies.end());
+			body_activation_listener.forgetBodies(mRemovingBodies);
+			mRemovingBodies.clear();
+		}
+	}
+
+	void Physics::pushTransforms(float dt) {
+		{
+			std::lock_guard lock(mJournalMutex);
+			std::swap(mMovedEntities, mPushingEntities);
+		}
+
+		pushedBodies = 0;
+		if (mPushingEntities.empty()) {
+			return;
+		}
+
+		std::sort(mPushingEntities.begin(), mPushingEntities.end());
+		mPushingEntities.erase(std::unique(mPushingEntities.begin(), mPushingEntities.end()), mPushingEntities.end());
+
 		auto& bodyInterface = physics_system->GetBodyInterface();
-		for (const auto& [entity, physicsComp, transform] : ECSHandler::registry().forEach<PhysicsComponent, TransformComponent>()) {
+		std::lock_guard interpolationLock(mInterpolationMutex);
+		for (const auto entity : mPushingEntities) {
+			const auto physicsComp = ECSHandler::registry().getComponent<PhysicsComponent>(entity);
+			if (!physicsComp) {
+				continue;
+			}
+			const auto transform = ECSHandler::registry().getComponent<TransformComponent>(entity);
 			if (!transform) {
 				continue;
 			}
-			const auto& pos = transform->getPos(true);
-			if (pos != physicsComp->lastPos || transform->getRotate() != physicsComp->lastRotate) {
-				bodyInterface.SetPositionAndRotationWhenChanged(physicsComp->mBodyID, toVec3(pos), toQuat(transform->getQuaternion()), EActivation::Activate);
 
-				physicsComp->lastPos = pos;
+			//bodies which were created without addBody get their entity here
+			if (bodyInterface.GetUserData(physicsComp->mBodyID) != entity) {
+				bodyInterface.SetUserData(physicsComp->mBodyID, entity);
+			}
+
+			//transform which was changed by previous pull or by interpolation follows the body
+			const auto pos = transform->getPos(true);
+			const auto rotation = transform->getQuaternion();
+			if (pos == physicsComp->lastPos && isSameRotation(rotation, physicsComp->lastRotation)) {
+				continue;
+			}
+			physicsComp->lastPos = pos;
+			physicsComp->lastRotation = rotation;
+
+			if (bodyInterface.GetMotionType(physicsComp->mBodyID) == EMotionType::Kinematic) {
+				bodyInterface.MoveKinematic(physicsComp->mBodyID, toVec3(pos), toQuat(rotation), dt);
 			}
+			else {
+				bodyInterface.SetPositionAndRotation(physicsComp->mBodyID, toVec3(pos), toQuat(rotation), EActivation::Activate);
+			}
+			pushedBodies++;
+		}
+		mPushingEntities.clear();
+	}
 
-			if (bodyInterface.IsActive(physicsComp->mBodyID) == physicsComp->isSleeping) {
+	void Physics::pullTransforms(float dt) {
+		mSyncBodies.clear();
+		physics_system->GetActiveBodies(EBodyType::RigidBody, mSyncBodies);
+		body_activation_listener.takeDeactivated(mSyncBodies);
+
+		//bodies are removed only by this thread, so they can be read without locks
+		pulledBodies = 0;
+		mTick++;
+		mNextInterpolatedBodies.clear();
+		const auto& bodyInterface = physics_system->GetBodyInterfaceNoLock();
+		for (const auto& id : mSyncBodies) {
+			const auto entity = static_cast<ecss::EntityId>(bodyInterface.GetUserData(id));
+			const auto physicsComp = ECSHandler::registry().getComponent<PhysicsComponent>(entity);
+			if (!physicsComp || physicsComp->mBodyID != id) {
 				continue;
 			}
 
-			physicsComp->lastPos = toVec3(bodyInterface.GetCenterOfMassPosition(physicsComp->mBodyID));
-			transform->setPos(physicsComp->lastPos);
+			RVec3 position;
+			Quat rotation;
+			bodyInterface.GetPositionAndRotation(id, position, rotation);
+
+			const auto pos = toVec3(position);
+			const auto rotate = toQuat(rotation);
+			if (pos == physicsComp->lastPos && isSameRotation(rotate, physicsComp->lastRotation)) {
+				continue;
+			}
+
+			const auto transform = ECSHandler::registry().getComponent<TransformComponent>(entity);
+			if (!transform) {
+				continue;
+			}
 
-			physicsComp->lastRotate = Math::degrees(toVec3(bodyInterface.GetRotation(physicsComp->mBodyID).GetEulerAngles()));
-			transform->setRotate(physicsComp->lastRotate);
+			//transform always has the state of the last tick, interpolation moves only what is drawn
+			transform->setPosAndRotation(pos, rotate);
+			if (interpolation) {
+				mNextInterpolatedBodies.push_back({ entity, physicsComp->lastPos, pos, physicsComp->lastRotation, rotate });
+				physicsComp->interpolatedTick = mTick;
+			}
+			physicsComp->lastPos = pos;
+			physicsComp->lastRotation = rotate;
+			pulledBodies++;
+		}
+
+		std::lock_guard lock(mInterpolationMutex);
+		if (!interpolation) {
+			mInterpolatedBodies.clear();
+			return;
+		}
+
+		//bodies which stopped this tick didn't reach their last state yet, it is written once more
+		for (const auto& body : mInterpolatedBodies) {
+			if (body.fromPos == body.toPos && isSameRotation(body.fromRotation, body.toRotation)) {
+				continue;
+			}
+			const auto physicsComp = ECSHandler::registry().getComponent<PhysicsComponent>(body.entity);
+			if (physicsComp && physicsComp->interpolatedTick != mTick) {
+				mNextInterpolatedBodies.push_back({ body.entity, body.toPos, body.toPos, body.toRotation, body.toRotation });
+			}
+		}
+
+		std::swap(mInterpolatedBodies, mNextInterpolatedBodies);
+		mInterpolationStartNs = CoreModule::monotonicNs();
+		mInterpolationStepNs = std::max(static_cast<int64_t>(dt * 1'000'000'000.0), int64_t{ 1 });
+	}
+
+	void Physics::interpolate() {
+		std::lock_guard lock(mInterpolationMutex);
+		if (mInterpolatedBodies.empty()) {
+			return;
+		}
+
+		const auto render = ECSHandler::getSystem<RenderSystem>();
+		if (!render) {
+			return;
+		}
+
+		auto& registry = ECSHandler::registry();
+		const auto alpha = std::clamp(static_cast<float>(CoreModule::monotonicNs() - mInterpolationStartNs) / static_cast<float>(mInterpolationStepNs), 0.f, 1.f);
+		for (auto& body : mInterpolatedBodies) {
+			//body which already reached its state isn't written every frame
+			if (body.alpha == alpha) {
+				continue;
+			}
+			body.alpha = alpha;
+
+			const auto transform = registry.getComponent<TransformComponent>(body.entity);
+			if (!transform || !registry.getComponent<ComponentsModule::TransformMatComp>(body.entity)) {
+				continue;
+			}
+
+			//blend goes only to draw registries, children are still drawn with state of the last tick
+			const auto pos = Math::mix(body.fromPos, body.toPos, alpha);
+			const auto scale = transform->getScale();
+			auto matrix = Math::Mat4{ { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f }, { pos.x, pos.y, pos.z, 1.f } }
+				* Math::slerp(body.fromRotation, body.toRotation, alpha).toMat4()
+				* Math::Mat4{ { scale.x, 0.f, 0.f, 0.f }, { 0.f, scale.y, 0.f, 0.f }, { 0.f, 0.f, scale.z, 0.f }, { 0.f, 0.f, 0.f, 1.f } };
+			if (const auto tree = registry.getComponent<ComponentsModule::TreeComponent>(body.entity)) {
+				if (const auto parentTransform = registry.getComponent<TransformComponent>(tree->getParent())) {
+					matrix = parentTransform->getTransform() * matrix;
+				}
+			}
+
+			render->setInterpolatedTransform(body.entity, matrix);
 		}
+	}
 
-		// If you take larger steps than 1 / 60th of a second you need to do multiple collision steps in order to keep the simulation stable. Do 1 collision step per 1 / 60th of a second (round up).
-		//dt *= 0.5f;
-		const int cCollisionSteps = 20 * static_cast<int>(std::ceil(dt * 60.f));
-		if (!cCollisionSteps) {
+	void Physics::update(float dt) {
+		const auto tickStart = CoreModule::monotonicNs();
+		removeBodies();
+		pushTransforms(dt);
+
+		if (dt <= 0.f) {
 			return;
 		}
+
+		//collision steps are not longer than fixed step, so simulation is stable with any tick rate, epsilon keeps exact multiples from extra step
+		const auto neededSteps = std::max(static_cast<int>(std::ceil(dt * substepRate - 0.001f)), 1);
+		const auto collisionSteps = std::min(neededSteps, std::max(maxSubsteps, 1));
+		cappedTicks += neededSteps > collisionSteps;
+
+		//jolt pool is made only for comparison, its threads compete with engine workers while it exists
+		JobSystem* jobSystem = job_system;
+		if (!useEngineJobSystem) {
+			if (!jolt_job_system) {
+				jolt_job_system = new JobSystemThreadPool(cMaxPhysicsJobs, cMaxPhysicsBarriers, thread::hardware_concurrency() - 1);
+			}
+			jobSystem = jolt_job_system;
+		}
+
 		// Step the world
-		physics_system->Update(dt, cCollisionSteps, temp_allocator, job_system);
+		const auto stepStart = CoreModule::monotonicNs();
+		physics_system->Update(dt, collisionSteps, temp_allocator, jobSystem);
+		stepTimes.add(CoreModule::monotonicNs() - stepStart);
+		stepsCount++;
+
+		pullTransforms(dt);
+
+		const auto tickNs = CoreModule::monotonicNs() - tickStart;
+		tickTimes.add(tickNs);
+		overBudgetTicks += tickNs > static_cast<int64_t>(budgetMs * 1'000'000.f);
 	}
 
 	void Physics::debugUpdate(float dt) {
+		if (debugWindow) {
+			if (ImGui::Begin("Physics", &debugWindow)) {
+				if (ImGui::Checkbox("engine job system", &useEngineJobSystem)) {
+					stepTimes.reset();
+					tickTimes.reset();
+				}
+				ImGui::Checkbox("interpolation", &interpolation);
+				ImGui::DragFloat("substep rate", &substepRate, 1.f, 15.f, 480.f);
+				ImGui::DragInt("max substeps", &maxSubsteps, 1.f, 1, 32);
+				ImGui::DragFloat("budget, ms", &budgetMs, 0.1f, 0.1f, 100.f);
+
+				auto reportPersisted = contact_listener.reportPersisted.load();
+				if (ImGui::Checkbox("report persisted contacts", &reportPersisted)) {
+					contact_listener.reportPersisted = reportPersisted;
+				}
+
+				const auto stats = stepTimes.getStats();
+				ImGui::Text("bodies: %u, steps: %llu", physics_system->GetNumBodies(), static_cast<unsigned long long>(stepsCount));
+				ImGui::Text("synced bodies, pushed: %zu, pulled: %zu", pushedBodies, pulledBodies);
+				ImGui::Text("step: avg %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms", stats.avgMs, stats.p50Ms, stats.p99Ms, stats.maxMs);
+
+				//share of one core which physics takes, tick with sync should fit into budget of frame
+				const auto tickStats = tickTimes.getStats();
+				ImGui::Text("tick: avg %.2f ms, p99 %.2f ms, max %.2f ms, cpu %.1f%%", tickStats.avgMs, tickStats.p99Ms, tickStats.maxMs, getTicks() > 0.f ? tickStats.avgMs * getTicks() / 10.0 : 0.0);
+				ImGui::Text("over budget ticks: %llu, capped ticks: %llu", static_cast<unsigned long long>(overBudgetTicks), static_cast<unsigned long long>(cappedTicks));
+				ImGui::Text("contacts in queue: %zu, dropped: %llu", contact_listener.events.sizeApprox(), static_cast<unsigned long long>(contact_listener.dropped.load()));
+
+				//queue wait is time which jobs spend behind tasks of other systems, it shows contention for workers
+				const auto newStats = job_system->takeStats();
+				if (newStats.jobs) {
+					jobStats = newStats;
+				}
+				ImGui::Text("engine jobs: %llu, avg queue wait: %.1f us, max in flight: %u", static_cast<unsigned long long>(jobStats.jobs),
+					jobStats.jobs ? static_cast<double>(jobStats.queueWaitNs) / static_cast<double>(jobStats.jobs) / 1000.0 : 0.0, jobStats.maxInFlight);
+				ImGui::Text("concurrency: %d, jolt threads: %s", job_system->GetMaxConcurrency(), jolt_job_system ? "created" : "none");
+			}
+			ImGui::End();
+		}
+
 		/*class renderer : public DebugRenderer {
 		public:
 			renderer() {
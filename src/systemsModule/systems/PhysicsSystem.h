@@ -16,13 +16,20 @@
 
 // STL includes
 #include <iostream>
+#include <algorithm>
 #include <cstdarg>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "systemsModule/SystemBase.h"
 #include "componentsModule/PhysicsComponent.h"
+#include "containersModule/MPSCQueue.h"
 #include "core/ECSHandler.h"
+#include "core/FramePacing.h"
 #include "mathModule/Quaternion.h"
+#include "multithreading/JoltJobSystem.h"
+#include "multithreading/ThreadPool.h"
 
 // Disable common warnings triggered by Jolt, you can use JPH_SUPPRESS_WARNING_PUSH / JPH_SUPPRESS_WARNING_POP to store and restore the warning state
 JPH_SUPPRESS_WARNINGS
@@ -35,6 +42,10 @@ namespace JPH {
 		return { q.x, q.y, q.z, q.w };
 	}
 
+	inline SFE::Math::Quaternion<float> toQuat(const Quat& q) {
+		return { q.GetW(), q.GetX(), q.GetY(), q.GetZ() };
+	}
+
 	inline Vec3 toVec3(const SFE::Math::Vec3& v) {
 		return { v.x, v.y, v.z };
 	}
@@ -160,40 +171,110 @@ public:
 	}
 };
 
-// An example contact listener
+namespace SFE::SystemsModule {
+	//entities are user data of bodies, removed contact has no manifold, so its point and normal are zero
+	struct ContactEvent {
+		enum class Type : uint8_t {
+			ADDED,
+			PERSISTED,
+			REMOVED
+		};
+
+		Type type = Type::ADDED;
+		ecss::EntityId first = ecss::INVALID_ID;
+		ecss::EntityId second = ecss::INVALID_ID;
+		Math::Vec3 point = {};
+		Math::Vec3 normal = {};
+		float depth = 0.f;
+	};
+}
+
+//callbacks are called from jobs of step, events are only written to lock-free queue, so jobs never wait for each other or for gameplay
 class MyContactListener : public JPH::ContactListener
 {
 public:
-	// See: ContactListener
-	JPH::ValidateResult	OnContactValidate(const JPH::Body& inBody1, const JPH::Body& inBody2, JPH::RVec3Arg inBaseOffset, const JPH::CollideShapeResult& inCollisionResult) override {
-		std::cout << "Contact validate callback" << std::endl;
-		// Allows you to ignore a contact before it is created (using layers to not make objects collide is cheaper!)
-		return JPH::ValidateResult::AcceptAllContactsForThisBodyPair;
-	}
+	constexpr static size_t QUEUE_SIZE = 4096;
 
 	void OnContactAdded(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold, JPH::ContactSettings& ioSettings) override {
-		std::cout << "A contact was added" << std::endl;
+		push(SFE::SystemsModule::ContactEvent::Type::ADDED, inBody1, inBody2, inManifold);
 	}
 
+	//persisted contact is reported every step for every touching pair, it is the most of events, so it is optional
 	void OnContactPersisted(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold, JPH::ContactSettings& ioSettings) override {
-		std::cout << "A contact was persisted" << std::endl;
+		if (reportPersisted.load(std::memory_order_relaxed)) {
+			push(SFE::SystemsModule::ContactEvent::Type::PERSISTED, inBody1, inBody2, inManifold);
+		}
 	}
 
+	//bodies can be already removed at this point, so entities are read from user data without locks by physics system
 	void OnContactRemoved(const JPH::SubShapeIDPair& inSubShapePair) override {
-		std::cout << "A contact was removed" << std::endl;
+		if (!bodyInterface) {
+			return;
+		}
+
+		const auto first = static_cast<ecss::EntityId>(bodyInterface->GetUserData(inSubShapePair.GetBody1ID()));
+		const auto second = static_cast<ecss::EntityId>(bodyInterface->GetUserData(inSubShapePair.GetBody2ID()));
+		const auto pushed = events.tryEmplace([first, second](SFE::SystemsModule::ContactEvent& event) {
+			event = {};
+			event.type = SFE::SystemsModule::ContactEvent::Type::REMOVED;
+			event.first = first;
+			event.second = second;
+		});
+		if (!pushed) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	SFE::MPSCQueue<SFE::SystemsModule::ContactEvent, QUEUE_SIZE> events;
+	//events which didn't fit into queue because gameplay didn't drain it in time
+	std::atomic<uint64_t> dropped = 0;
+	std::atomic_bool reportPersisted = false;
+	const JPH::BodyInterface* bodyInterface = nullptr;
+
+private:
+	void push(SFE::SystemsModule::ContactEvent::Type type, const JPH::Body& body1, const JPH::Body& body2, const JPH::ContactManifold& manifold) {
+		const auto pushed = events.tryEmplace([&](SFE::SystemsModule::ContactEvent& event) {
+			event.type = type;
+			event.first = static_cast<ecss::EntityId>(body1.GetUserData());
+			event.second = static_cast<ecss::EntityId>(body2.GetUserData());
+			event.point = JPH::toVec3(manifold.GetWorldSpaceContactPointOn1(0));
+			event.normal = JPH::toVec3(manifold.mWorldSpaceNormal);
+			event.depth = manifold.mPenetrationDepth;
+		});
+		if (!pushed) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
 	}
 };
 
-// An example activation listener
+//bodies which fell asleep during step are not in active list anymore, so their last state is synced by this list
 class MyBodyActivationListener : public JPH::BodyActivationListener {
 public:
-	void OnBodyActivated(const JPH::BodyID& inBodyID, JPH::uint64 inBodyUserData) override {
-		std::cout << "A body got activated" << std::endl;
-	}
+	void OnBodyActivated(const JPH::BodyID& inBodyID, JPH::uint64 inBodyUserData) override {}
 
 	void OnBodyDeactivated(const JPH::BodyID& inBodyID, JPH::uint64 inBodyUserData) override {
-		std::cout << "A body went to sleep" << std::endl;
+		std::lock_guard lock(mMutex);
+		mDeactivated.push_back(inBodyID);
+	}
+
+	void takeDeactivated(std::vector<JPH::BodyID>& bodies) {
+		std::lock_guard lock(mMutex);
+		bodies.insert(bodies.end(), mDeactivated.begin(), mDeactivated.end());
+		mDeactivated.clear();
+	}
+
+	//destroyed body ids can be reused by new bodies, so their events are dropped, other pending events are kept.
+	//bodies should be sorted
+	void forgetBodies(const std::vector<JPH::BodyID>& bodies) {
+		std::lock_guard lock(mMutex);
+		std::erase_if(mDeactivated, [&bodies](const JPH::BodyID& id) {
+			return std::binary_search(bodies.begin(), bodies.end(), id);
+		});
 	}
+
+private:
+	std::mutex mMutex;
+	std::vector<JPH::BodyID> mDeactivated;
 };
 
 
@@ -240,10 +321,21 @@ namespace SFE::SystemsModule {
 		// malloc / free.
 		JPH::TempAllocatorImpl* temp_allocator;
 
-		// We need a job system that will execute physics jobs on multiple threads. Typically
-		// you would implement the JobSystem interface yourself and let Jolt Physics run on top
-		// of your own job scheduler. JobSystemThreadPool is an example implementation.
-		JPH::JobSystemThreadPool* job_system;
+		//jobs of physics step are executed by common workers of engine thread pool
+		SFE::JoltJobSystem* job_system;
+		//own threads of jolt, created only when they are selected in debug window to compare with engine workers
+		JPH::JobSystemThreadPool* jolt_job_system = nullptr;
+		bool useEngineJobSystem = true;
+
+		//duration of whole Update of physics system
+		CoreModule::FrameTimeHistogram stepTimes{ 256 };
+		//duration of whole tick with removal and sync of bodies, it is compared with budget
+		CoreModule::FrameTimeHistogram tickTimes{ 256 };
+		float budgetMs = 4.f;
+		uint64_t overBudgetTicks = 0;
+		SFE::JoltJobSystem::Stats jobStats;
+		uint64_t stepsCount = 0;
+		bool debugWindow = true;
 
 		// A body activation listener gets notified when bodies activate and go to sleep
 		// Note that this is called from a job so whatever you do here needs to be thread safe.
@@ -255,7 +347,8 @@ namespace SFE::SystemsModule {
 			// Registering one is entirely optional.
 		MyContactListener contact_listener;
 
-		Physics() {
+		//reloaded transforms are the journal of changes which are pushed to bodies
+		Physics() : ecss::System({ TRAHSFORM_RELOADED }) {
 			
 			// Register allocation hook
 			JPH::RegisterDefaultAllocator();
@@ -275,7 +368,8 @@ namespace SFE::SystemsModule {
 			physics_system = new JPH::PhysicsSystem();
 			
 
-			job_system = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, JPH::thread::hardware_concurrency() - 1);
+			//jobs run on common workers and tick thread helps on barriers
+			job_system = new SFE::JoltJobSystem(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, static_cast<int>(SFE::ThreadPool::instance()->getCommonWorkersCount()) + 1);
 			// Now we can create the actual physics system.
 			
 			physics_system->Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints, broad_phase_layer_interface, object_vs_broadphase_layer_filter, object_vs_object_layer_filter);
@@ -285,6 +379,7 @@ namespace SFE::SystemsModule {
 
 			physics_system->SetGravity({ 0.f,-100.f,0.f });
 			physics_system->SetContactListener(&contact_listener);
+			contact_listener.bodyInterface = &physics_system->GetBodyInterfaceNoLock();
 		}
 
 		~Physics() override {
@@ -297,11 +392,74 @@ namespace SFE::SystemsModule {
 
 			delete temp_allocator;
 			delete job_system;
+			delete jolt_job_system;
 
 			delete physics_system;
 		}
 
 		void update(float dt) override;
 		void debugUpdate(float dt) override;
+		void notify(Task task) override;
+		void notifyBatch(const std::vector<ecss::EntityId>& entities, TaskType type) override;
+
+		//user data of body is its entity, so active bodies find their transforms without search
+		PhysicsComponent* addBody(ecss::EntityId entity, JPH::BodyCreationSettings settings, JPH::EActivation activation = JPH::EActivation::Activate);
+		//body is removed on physics thread before next step, so step and sync never see half removed bodies
+		void removeBody(const JPH::BodyID& id);
+
+		//main thread, once per frame, moves drawn matrices of bodies between two last states of physics, transforms keep the last one
+		void interpolate();
+
+		//gameplay drains contacts once per frame, only one thread can do it, returns count of events
+		template<typename Consume>
+		size_t consumeContacts(Consume&& consume) {
+			return contact_listener.events.consumeAll([&consume](const ContactEvent& event) { consume(event); });
+		}
+
+		//tick is split into collision steps not longer than 1 / substepRate, cap keeps slow ticks from taking even more time
+		float substepRate = 60.f;
+		int maxSubsteps = 4;
+		//ticks where cap made collision steps longer than fixed step
+		uint64_t cappedTicks = 0;
+
+		//without interpolation bodies are drawn jumping with rate of ticks, with it they are drawn one tick behind the physics
+		bool interpolation = true;
+
+		//bodies synced during the last tick
+		size_t pushedBodies = 0;
+		size_t pulledBodies = 0;
+
+	private:
+		void removeBodies();
+		//moved transforms are written to their bodies, kinematic bodies are moved with velocity, others are teleported
+		void pushTransforms(float dt);
+		//state of active bodies and bodies which fell asleep this step is written to transforms or given to interpolation
+		void pullTransforms(float dt);
+
+		std::mutex mJournalMutex;
+		std::vector<ecss::EntityId> mMovedEntities;
+		std::vector<ecss::EntityId> mPushingEntities;
+
+		std::mutex mRemovedMutex;
+		std::vector<JPH::BodyID> mRemovedBodies;
+		std::vector<JPH::BodyID> mRemovingBodies;
+
+		JPH::BodyIDVector mSyncBodies;
+
+		struct InterpolatedBody {
+			ecss::EntityId entity = ecss::INVALID_ID;
+			Math::Vec3 fromPos = {};
+			Math::Vec3 toPos = {};
+			Math::Quaternion<float> fromRotation = {};
+			Math::Quaternion<float> toRotation = {};
+			float alpha = -1.f;
+		};
+
+		std::mutex mInterpolationMutex;
+		std::vector<InterpolatedBody> mInterpolatedBodies;
+		std::vector<InterpolatedBody> mNextInterpolatedBodies;
+		int64_t mInterpolationStartNs = 0;
+		int64_t mInterpolationStepNs = 1;
+		uint64_t mTick = 0;
 	};
 }
\ No newline at end of file
@@ -2,15 +2,18 @@
 #include "renderModule/Utils.h"
 
 #include <algorithm>
+#include <iterator>
 
 #include "CameraSystem.h"
 #include "imgui.h"
 #include "OcTreeSystem.h"
 #include "systemsModule/SystemManager.h"
 #include "systemsModule/SystemsPriority.h"
+#include "assetsModule/modelModule/GeometryArena.h"
 #include "assetsModule/shaderModule/ShaderController.h"
 #include "componentsModule/ArmatureComponent.h"
 #include "componentsModule/CameraComponent.h"
+#include "componentsModule/GizmoComponent.h"
 #include "componentsModule/IsDrawableComponent.h"
 #include "componentsModule/LightSourceComponent.h"
 #include "componentsModule/ModelComponent.h"
@@ -19,7 +22,14 @@
 #include "core/ECSHandler.h"
 #include "core/Engine.h"
 #include "debugModule/Benchmark.h"
+#include "debugModule/GpuProfiler.h"
+#include "debugModule/LogWindow.h"
 #include "ecss/Registry.h"
+#include "glWrapper/Draw.h"
+#include "logsModule/logger.h"
+#include "multithreading/ThreadPool.h"
+#include "renderModule/MaterialSystem.h"
+#include "renderModule/TextureStreamer.h"
 #include "renderModule/Utils.h"
 #include "renderModule/renderPasses/CascadedShadowPass.h"
 #include "renderModule/renderPasses/LightingPass.h"
@@ -34,9 +44,20 @@
 #include "renderModule/renderPasses/OcclusionPass.h"
 
 namespace SFE::SystemsModule {
+	namespace {
+		uint32_t toGLBarriers(uint32_t barriers) {
+			uint32_t result = 0;
+			result |= barriers & Render::RenderGraph::TEXTURE_FETCH_BARRIER ? GLW::TEXTURE_FETCH_BARRIER : 0;
+			result |= barriers & Render::RenderGraph::IMAGE_ACCESS_BARRIER ? GLW::SHADER_IMAGE_ACCESS_BARRIER : 0;
+			result |= barriers & Render::RenderGraph::STORAGE_BUFFER_BARRIER ? GLW::SHADER_STORAGE_BARRIER : 0;
+			result |= barriers & Render::RenderGraph::COMMAND_BARRIER ? GLW::COMMAND_BARRIER : 0;
+			result |= barriers & Render::RenderGraph::FRAMEBUFFER_BARRIER ? GLW::FRAMEBUFFER_BARRIER : 0;
+			return result;
+		}
+	}
 
 	template <typename PassType>
-	void RenderSystem::addRenderPass() {
+	void RenderSystem::addRenderPass(const std::string& name) {
 		size_t i = 0;
 		for (; i < RENDER_PASSES_PRIORITY.size(); i++) {
 			if (RENDER_PASSES_PRIORITY[i] == typeid(PassType).hash_code()) {
@@ -52,6 +73,7 @@ namespace SFE::SystemsModule {
 		auto pass = new PassType();
 		pass->init();
 		pass->setPriority(i);
+		pass->setName(name);
 
 		mRenderPasses.emplace_back(pass);
 
@@ -63,15 +85,21 @@ namespace SFE::SystemsModule {
 	RenderSystem::RenderSystem() : System({ SFE::SystemsModule::TaskType::TRAHSFORM_RELOADED , SFE::SystemsModule::TaskType::ARMATURE_UPDATED, MATERIAL_UPDATED, MESH_UPDATED }) {
 		mRenderPasses.reserve(RENDER_PASSES_PRIORITY.size());
 
-		addRenderPass<Render::RenderPasses::OcclusionPass>();
-		addRenderPass<Render::RenderPasses::CascadedShadowPass>();//todo passes shoudle be created according to settings
-		addRenderPass<Render::RenderPasses::PointLightPass>();
-		addRenderPass<Render::RenderPasses::GeometryPass>();
-		addRenderPass<Render::RenderPasses::ShadersPass>();
-		addRenderPass<Render::RenderPasses::LightingPass>();
-		addRenderPass<Render::RenderPasses::SSAOPass>();
-		addRenderPass<Render::RenderPasses::DebugPass>();
-		addRenderPass<Render::RenderPasses::GUIPass>();
+		//passes load their programs in init, so all of them are compiled together
+		SHADER_CONTROLLER->beginBatch();
+		addRenderPass<Render::RenderPasses::OcclusionPass>("OcclusionPass");
+		addRenderPass<Render::RenderPasses::CascadedShadowPass>("CascadedShadowPass");//todo passes shoudle be created according to settings
+		addRenderPass<Render::RenderPasses::PointLightPass>("PointLightPass");
+		addRenderPass<Render::RenderPasses::GeometryPass>("GeometryPass");
+		addRenderPass<Render::RenderPasses::ShadersPass>("ShadersPass");
+		addRenderPass<Render::RenderPasses::LightingPass>("LightingPass");
+		addRenderPass<Render::RenderPasses::SSAOPass>("SSAOPass");
+		addRenderPass<Render::RenderPasses::DebugPass>("DebugPass");
+		addRenderPass<Render::RenderPasses::GUIPass>("GUIPass");
+		Batcher::loadShaders();
+		SHADER_CONTROLLER->endBatch();
+
+		buildRenderGraph();
 
 		cameraMatricesUBO.generate();
 		auto guard = cameraMatricesUBO.lock();
@@ -79,55 +107,81 @@ namespace SFE::SystemsModule {
 		cameraMatricesUBO.setBufferBinding(5);
 	}
 
-	void RenderSystem:: update(float_t dt) {
-		FUNCTION_BENCHMARK;
+	void RenderSystem::buildRenderGraph() {
+		mRenderGraph.clear();
 
-		mRenderData.current = mRenderData.next;
-		mRenderData.cameraProjection = mRenderData.nextCameraProjection;
+		//passes are declared by priority, so it orders passes which don't depend on each other
+		for (const auto renderPass : mRenderPasses) {
+			renderPass->setup(mRenderGraph, mRenderData);
+		}
 
-		mRenderData.mCameraPos = mRenderData.mNextCameraPos;
-		mRenderData.mViewDir = mRenderData.mNextViewDir;
-		mRenderData.mCamFrustum = mRenderData.mNextCamFrustum;
+		const auto compiled = mRenderGraph.compile();
+		SFE_LOG_FATAL(compiled, "RenderSystem::render graph is not compiled: %s", mRenderGraph.getError().c_str());
+		assert(compiled);
 
-		{
-			auto lock = cameraMatricesUBO.lock();
-			cameraMatricesUBO.setData(1, &mRenderData.current);
+		mGraphTextures.create(mRenderGraph);
+		for (const auto renderPass : mRenderPasses) {
+			renderPass->bindResources(mGraphTextures);
 		}
+	}
+
+	std::shared_ptr<RenderSnapshot> RenderSystem::extract() {
+		FUNCTION_BENCHMARK;
 
-		auto playerCamera = ECSHandler::getSystem<CameraSystem>()->getCurrentCamera();
+		auto snapshot = std::make_shared<RenderSnapshot>();
+
+		const auto playerCamera = ECSHandler::getSystem<CameraSystem>()->getCurrentCamera();
 		const auto cameraComp = ECSHandler::registry().getComponent<CameraComponent>(playerCamera);
 		const auto transformComp = ECSHandler::registry().getComponent<TransformComponent>(playerCamera);
 
-		mRenderData.nextCameraProjection = cameraComp->getProjection();
-		mRenderData.next.projection = mRenderData.nextCameraProjection.getProjectionsMatrix();
-		mRenderData.next.view = transformComp->getViewMatrix();
-		mRenderData.next.PV = mRenderData.next.projection * mRenderData.next.view;
-
-		mRenderData.mNextCameraPos = transformComp->getPos(true);
-		mRenderData.mNextViewDir = normalize(transformComp->getForward());
-		mRenderData.mNextCamFrustum = cameraComp->getFrustum();
+		snapshot->cameraProjection = cameraComp->getProjection();
+		snapshot->camera.projection = snapshot->cameraProjection.getProjectionsMatrix();
+		snapshot->camera.view = transformComp->getViewMatrix();
+		snapshot->camera.PV = snapshot->camera.projection * snapshot->camera.view;
 
-		mRenderData.rotate();
-		int i = 0;
-		for (const auto renderPass : mRenderPasses) {
-			FUNCTION_BENCHMARK_NAMED_STR("pass " + std::to_string(i));
-			renderPass->render(mRenderData);
-			i++;
+		snapshot->cameraPos = transformComp->getPos(true);
+		snapshot->viewDir = normalize(transformComp->getForward());
+		snapshot->cameraFrustum = cameraComp->getFrustum();
+		{
+			auto lock = std::unique_lock(mCameraFrustumMutex);
+			mCameraFrustum = snapshot->cameraFrustum;
 		}
-		Render::TextRenderer::instance()->renderText("FPS: " + std::to_string(Engine::instance()->getFPS()), 10.f, 50.f, 1.f, Math::Vec3{1.f, 0.f, 0.f}, Render::FontsRegistry::instance()->getFont("fonts/DroidSans.ttf", 20));
-		Render::TextRenderer::instance()->renderText("dt: " + std::to_string(Engine::instance()->getDeltaTime()), 10.f, 80.f, 1.f, Math::Vec3{1.f, 0.f, 0.f}, Render::FontsRegistry::instance()->getFont("fonts/DroidSans.ttf", 20));
 
-		prepareDataForNextFrame();
-	}
+		{
+			FUNCTION_BENCHMARK_NAMED(occlusion);
+			ecss::EntitiesRanges entities;
+			const auto octreeSys = ECSHandler::getSystem<OcTreeSystem>();
+			const auto& frustum = snapshot->cameraFrustum;
+			std::mutex addMtx;
+			auto aabbOctrees = octreeSys->getAABBOctrees(frustum.generateAABB());
+			ThreadPool::instance()->addBatchTasks(aabbOctrees.size(), 5, [&aabbOctrees, octreeSys, &addMtx, &frustum, &entities](size_t it) {
+				if (auto treeIt = octreeSys->getOctree(aabbOctrees[it])) {
+					auto lock = treeIt->readLock();
+					treeIt->forEachObjectInFrustum(frustum, [&entities, &frustum, &addMtx](const auto& obj, bool entirely) {
+						if (entirely || FrustumModule::AABB::isOnFrustum(frustum, obj.pos, obj.size)) {
+							std::unique_lock lock(addMtx);
+							entities.insert(obj.data);
+						}
+					});
+				}
+			}).waitAll();
 
-	void RenderSystem::debugUpdate(float dt) {
-		return;
-	}
+			if (!entities.empty()) {
+				for (auto [entity, occlusion] : ECSHandler::registry().forEach<const ComponentsModule::OcclusionComponent>(entities)) {
+					if (!occlusion) {
+						continue;
+					}
 
-	void RenderSystem::prepareDataForNextFrame() {
-		FUNCTION_BENCHMARK;
+					snapshot->occluders.insert(snapshot->occluders.end(), occlusion->occluderAABB.begin(), occlusion->occluderAABB.end());
+					if (!occlusion->occludeeAABB.empty()) {
+						snapshot->occludees.push_back({ entity, occlusion->occludeeAABB });
+					}
+				}
+			}
+		}
 
 		std::vector<SFE::Vector<std::pair<ecss::EntityId, uint8_t>>> dir;
+		std::vector<std::pair<ecss::EntityId, ComponentsModule::TransformMatComp>> interpolated;
 		{
 			FUNCTION_BENCHMARK_NAMED(dirties_copy);
 			dirtiesMutex.lock();
@@ -137,58 +191,371 @@ namespace SFE::SystemsModule {
 					return val.second-- <= 1;
 				});
 			}
+
+			//blended matrix stays for two frames like dirty components, so both draw registries get it
+			interpolated.reserve(mInterpolatedTransforms.size());
+			for (auto it = mInterpolatedTransforms.begin(); it != mInterpolatedTransforms.end();) {
+				auto& [transform, frames] = it->second;
+				interpolated.emplace_back(it->first, ComponentsModule::TransformMatComp{ transform });
+				it = frames-- <= 1 ? mInterpolatedTransforms.erase(it) : std::next(it);
+			}
 			dirtiesMutex.unlock();
 		}
 
-		//prepare data for next frame
 		{
-			FUNCTION_BENCHMARK_NAMED(copy_components_transform_armat);
-			int id = 0;
-			for (auto entities : dir) {
+			FUNCTION_BENCHMARK_NAMED(copy_components);
+			auto& registry = ECSHandler::registry();
+			for (size_t id = 0; id < dir.size(); id++) {
+				const auto& entities = dir[id];
 				if (entities.empty()) {
-					id++;
 					continue;
 				}
-				if (id == getDirtyId<ComponentsModule::TransformMatComp>()) {//todo support deleting
-					auto lock = ECSHandler::registry().containerReadLock<ComponentsModule::TransformMatComp>();
-					DrawDataHolder::instance()->transformsBO.bind();
+
+				if (id == getDirtyId<ComponentsModule::TransformMatComp>()) {
+					auto lock = registry.containerReadLock<ComponentsModule::TransformMatComp>();
 					for (auto [entId, _] : entities) {
-						auto component = ECSHandler::registry().getComponentNotSafe<ComponentsModule::TransformMatComp>(entId);
-						ECSHandler::drawRegistry(mRenderData.currentRegistry).copyComponentToEntity(entId, component);
-						DrawDataHolder::instance()->updateTransform(entId, component->mTransform, false);
+						if (const auto component = registry.getComponentNotSafe<ComponentsModule::TransformMatComp>(entId)) {
+							snapshot->transforms.emplace_back(entId, *component);
+						}
 					}
-					DrawDataHolder::instance()->transformsBO.unbind();
 				}
 				else if (id == getDirtyId<ComponentsModule::ArmatureBonesComponent>()) {
-					auto lock = ECSHandler::registry().containerReadLock<ComponentsModule::ArmatureBonesComponent>();
-					DrawDataHolder::instance()->bonesBO.bind();
-
+					auto lock = registry.containerReadLock<ComponentsModule::ArmatureBonesComponent>();
 					for (auto [entId, _] : entities) {
-						auto component = ECSHandler::registry().getComponentNotSafe<ComponentsModule::ArmatureBonesComponent>(entId);
-						ECSHandler::drawRegistry(mRenderData.currentRegistry).copyComponentToEntity(entId, component);						
-						DrawDataHolder::instance()->updateBones(entId, component->boneMatrices.data(), false);
+						if (const auto component = registry.getComponentNotSafe<ComponentsModule::ArmatureBonesComponent>(entId)) {
+							snapshot->bones.emplace_back(entId, *component);
+						}
 					}
-					DrawDataHolder::instance()->bonesBO.unbind();
 				}
 				else if (id == getDirtyId<MeshComponent>()) {
-					auto lock = ECSHandler::registry().containerReadLock<MeshComponent>();
+					auto lock = registry.containerReadLock<MeshComponent>();
+					auto materialsLock = registry.containerReadLock<MaterialComponent>();
 					for (auto [entId, _] : entities) {
-						ECSHandler::drawRegistry(mRenderData.currentRegistry).copyComponentToEntity(entId, ECSHandler::registry().getComponentNotSafe<MeshComponent>(entId));
+						if (const auto component = registry.getComponentNotSafe<MeshComponent>(entId)) {
+							snapshot->meshes.push_back({ entId, *component, registry.getComponentNotSafe<MaterialComponent>(entId) != nullptr });
+						}
 					}
 				}
 				else if (id == getDirtyId<MaterialComponent>()) {
-					auto lock = ECSHandler::registry().containerReadLock<MaterialComponent>();
+					auto lock = registry.containerReadLock<MaterialComponent>();
 					for (auto [entId, _] : entities) {
-						ECSHandler::drawRegistry(mRenderData.currentRegistry).copyComponentToEntity(entId, ECSHandler::registry().getComponentNotSafe<MaterialComponent>(entId));
+						if (const auto component = registry.getComponentNotSafe<MaterialComponent>(entId)) {
+							snapshot->materials.emplace_back(entId, *component);
+						}
 					}
 				}
-				id++;
 			}
-			{
-				FUNCTION_BENCHMARK_NAMED(copy_components);
-				// todo i need some system which will handle dirty for render components, may be it should be render system itself, then when i updating draw registry
-				ECSHandler::drawRegistry(mRenderData.currentRegistry).copyComponentsArrayToRegistry<OutlineComponent>(ECSHandler::registry().getComponentContainer<OutlineComponent>());
-				ECSHandler::drawRegistry(mRenderData.currentRegistry).copyComponentsArrayToRegistry<ComponentsModule::OccludedComponent>(ECSHandler::registry().getComponentContainer<ComponentsModule::OccludedComponent>());
+
+			//blended matrices are copied after matrices of the last tick, so they override them in draw registry
+			snapshot->transforms.insert(snapshot->transforms.end(), interpolated.begin(), interpolated.end());
+
+			for (const auto& [entity, outline] : registry.forEach<const OutlineComponent>()) {
+				snapshot->outlines.push_back(entity);
+			}
+			std::ranges::sort(snapshot->outlines);
+
+			//matrices are calculated here, so render thread and its workers don't touch the component
+			for (const auto& [entity, shadows, transform] : registry.forEach<CascadeShadowComponent, TransformComponent>()) {
+				shadows->calculateLightSpaceMatrices(snapshot->cameraProjection, snapshot->camera.view, transform->getTransform());
+				snapshot->cascadeShadows = {
+					entity, shadows->cascades, shadows->getLightSpaceMatrices(), shadows->shadowCascadeLevels, shadows->resolution, shadows->shadowIntensity
+				};
+				break;
+			}
+
+			for (const auto& [entity, lightSource, transform] : registry.forEach<LightSourceComponent, TransformComponent>()) {
+				snapshot->lights.push_back({
+					entity, lightSource->getType(), transform->getTransform(), transform->getPos(true), lightSource->getLightColor(),
+					lightSource->mRadius, lightSource->mNear, lightSource->mLinear, lightSource->mQuadratic, lightSource->getBias(), lightSource->getSamples()
+				});
+			}
+		}
+
+		return snapshot;
+	}
+
+	void RenderSystem::syncSimulation() {
+		FUNCTION_BENCHMARK;
+
+		//animations of occluded entities are paused by simulation
+		for (const auto& [entity, occluded] : mRenderData.occlusionResults) {
+			if (const auto occlusion = ECSHandler::registry().getComponent<ComponentsModule::OcclusionComponent>(entity)) {
+				occlusion->occluded = occluded;
+			}
+		}
+
+		//gizmos move entities of simulation, their lines are drawn by debug pass of this frame
+		for (auto [entId, gizmoComp] : ECSHandler::registry().forEach<ComponentsModule::GizmoComponent>()) {
+			gizmoComp->gizmo.setEntity(entId);
+			gizmoComp->gizmo.update();
+		}
+	}
+
+	void RenderSystem:: update(float_t dt) {
+		FUNCTION_BENCHMARK;
+
+		if (!mSnapshot) {
+			return;
+		}
+		const auto snapshot = std::move(mSnapshot);
+
+		mRenderData.current = mRenderData.next;
+		mRenderData.cameraProjection = mRenderData.nextCameraProjection;
+
+		mRenderData.mCameraPos = mRenderData.mNextCameraPos;
+		mRenderData.mViewDir = mRenderData.mNextViewDir;
+		mRenderData.mCamFrustum = mRenderData.mNextCamFrustum;
+
+		{
+			auto lock = cameraMatricesUBO.lock();
+			cameraMatricesUBO.setData(1, &mRenderData.current);
+		}
+
+		mRenderData.nextCameraProjection = snapshot->cameraProjection;
+		mRenderData.next = snapshot->camera;
+		mRenderData.cascadeShadows = std::move(mRenderData.nextCascadeShadows);
+		mRenderData.nextCascadeShadows = std::move(snapshot->cascadeShadows);
+		mRenderData.nextOccluders = std::move(snapshot->occluders);
+		mRenderData.nextOccludees = std::move(snapshot->occludees);
+		mRenderData.mNextCameraPos = snapshot->cameraPos;
+		mRenderData.mNextViewDir = snapshot->viewDir;
+		mRenderData.mNextCamFrustum = snapshot->cameraFrustum;
+		mRenderData.lights = std::move(snapshot->lights);
+
+		mRenderData.rotate();
+
+		//meshes created since previous frame are uploaded before passes take their ranges
+		GeometryArena::instance()->update();
+		Render::MaterialSystem::instance()->update();
+		Render::TextureStreamer::instance()->update();
+
+		if (mRenderGraphDirty) {
+			mRenderGraphDirty = false;
+			buildRenderGraph();
+		}
+
+		for (const auto& [pass, barriers] : mRenderGraph.getOrder()) {
+			FUNCTION_BENCHMARK_NAMED_STR(mRenderGraph.getPassName(pass));
+			GPU_BENCHMARK_NAMED_STR(mRenderGraph.getPassName(pass));
+			if (barriers != Render::RenderGraph::NO_BARRIER) {
+				GLW::memoryBarrier(toGLBarriers(barriers));
+			}
+			mRenderGraph.executePass(pass);
+		}
+		mBatcherStats = Batcher::takeFrameStats();
+		Render::TextRenderer::instance()->renderText("FPS: " + std::to_string(Engine::instance()->getFPS()), 10.f, 50.f, 1.f, Math::Vec3{1.f, 0.f, 0.f}, Render::FontsRegistry::instance()->getFont("fonts/DroidSans.ttf", 20));
+		Render::TextRenderer::instance()->renderText("dt: " + std::to_string(Engine::instance()->getDeltaTime()), 10.f, 80.f, 1.f, Math::Vec3{1.f, 0.f, 0.f}, Render::FontsRegistry::instance()->getFont("fonts/DroidSans.ttf", 20));
+
+		prepareDataForNextFrame(*snapshot);
+	}
+
+	void RenderSystem::debugUpdate(float dt) {
+		Debug::GpuProfiler::instance()->drawDebugWindow();
+		Debug::LogWindow::instance()->drawDebugWindow();
+
+		if (mGeometryDebugWindow) {
+			if (ImGui::Begin("Geometry", &mGeometryDebugWindow)) {
+				ImGui::Text("vao binds: %u, draw calls: %u", mBatcherStats.vaoBinds, mBatcherStats.drawCalls);
+				if (Batcher::indirectDrawSupported) {
+					ImGui::Checkbox("indirect draw", &Batcher::indirectDraw);
+				}
+				else {
+					ImGui::Text("indirect draw: needs gl 4.3");
+				}
+
+				uint32_t gBufferBytes = 0;
+				for (const auto name : { Render::GraphResources::G_POSITION, Render::GraphResources::G_VIEW_POSITION, Render::GraphResources::G_NORMAL, Render::GraphResources::G_ALBEDO, Render::GraphResources::G_DEPTH }) {
+					const auto resource = mRenderGraph.findResource(name);
+					gBufferBytes += resource != Render::RenderGraph::INVALID_RESOURCE ? mRenderGraph.getTextureDesc(resource).bytesPerTexel : 0;
+				}
+				ImGui::Text("g buffer: %s, %u bytes per pixel", Render::RenderPasses::GeometryPass::compactGBuffer ? "compact" : "full", gBufferBytes);
+
+				const auto stats = GeometryArena::instance()->getStats();
+				ImGui::Text("arena pages: %zu, meshes: %zu, pending uploads: %zu", stats.pages, stats.meshes, stats.pendingUploads);
+				ImGui::Text("vertices: %zu / %zu", stats.usedVertices, stats.capacityVertices);
+				ImGui::Text("indices: %zu / %zu", stats.usedIndices, stats.capacityIndices);
+				ImGui::Text("fragmentation: %.2f", stats.fragmentation);
+				ImGui::SliderFloat("defragmentation threshold", &GeometryArena::defragmentationThreshold, 0.f, 1.f);
+
+				ImGui::Separator();
+				ImGui::Checkbox("material table", &Render::MaterialSystem::enabled);
+				ImGui::Text("materials: %zu, texture array pages: %zu", Render::MaterialSystem::instance()->getMaterialsCount(), Render::MaterialSystem::instance()->getPagesCount());
+
+				ImGui::Separator();
+				auto streamer = Render::TextureStreamer::instance();
+				ImGui::Checkbox("texture streaming", &Render::TextureStreamer::enabled);
+				const auto& streaming = streamer->getStats();
+				ImGui::Text("textures: %zu, visible: %zu, loading: %zu", streaming.textures, streaming.visibleTextures, streamer->getLoadingCount());
+				ImGui::Text("loads: %zu, drops: %zu, deferred: %zu", streaming.loads, streaming.drops, streaming.deferredLoads);
+				ImGui::Text("resident: %.1f MB, wanted: %.1f MB", static_cast<double>(streaming.residentBytes) / (1024.0 * 1024.0), static_cast<double>(streaming.wantedBytes) / (1024.0 * 1024.0));
+
+				auto& settings = streamer->settings;
+				int budgetMb = static_cast<int>(settings.budgetBytes / (1024 * 1024));
+				if (ImGui::SliderInt("budget, MB", &budgetMb, 16, 4096)) {
+					settings.budgetBytes = static_cast<uint64_t>(budgetMb) * 1024 * 1024;
+				}
+				ImGui::SliderFloat("mip bias", &settings.mipBias, -2.f, 4.f);
+				ImGui::SliderFloat("hysteresis", &settings.hysteresis, 0.f, 1.f);
+				const auto sliderU32 = [](const char* label, uint32_t* value, uint32_t min, uint32_t max) {
+					ImGui::SliderScalar(label, ImGuiDataType_U32, value, &min, &max);
+				};
+				sliderU32("drop frames", &settings.dropFrames, 1, 600);
+				sliderU32("loads per frame", &settings.maxLoadsPerFrame, 1, 64);
+			}
+			ImGui::End();
+		}
+
+		if (mLightsDebugWindow && mRenderData.mLightingPassData) {
+			if (ImGui::Begin("Light clusters", &mLightsDebugWindow)) {
+				auto& data = *mRenderData.mLightingPassData;
+				ImGui::Text("visible point lights: %zu, light indices: %zu", data.lightsCount, data.lightIndicesCount);
+				ImGui::Text("assignment: %.3f ms", data.assignmentTime);
+
+				ImGui::SliderInt("benchmark lights", &data.benchmarkLights, 0, 10000);
+				if (data.benchmarkLights > 0) {
+					ImGui::Text("benchmark assignment: %.3f ms", data.benchmarkTime);
+				}
+			}
+			ImGui::End();
+		}
+
+		if (mShadowsDebugWindow && mRenderData.mCascadedShadowsPassData) {
+			if (ImGui::Begin("Shadow cascades", &mShadowsDebugWindow)) {
+				const auto& data = *mRenderData.mCascadedShadowsPassData;
+				ImGui::Text("static updated: %u, dynamic updated: %u, reused: %u", data.staticUpdatedCascades, data.dynamicUpdatedCascades, data.reusedCascades);
+				ImGui::Text("dynamic casters: %zu", data.dynamicCasters);
+
+				using Render::RenderPasses::CascadedShadowPass;
+				ImGui::SliderInt("static updates budget", &CascadedShadowPass::staticUpdatesBudget, 0, 4);
+				ImGui::SliderInt("near cascades", &CascadedShadowPass::nearCascadesCount, 0, 6);
+				ImGui::SliderInt("distant cascades interval", &CascadedShadowPass::distantCascadesInterval, 1, 16);
+				ImGui::SliderInt("static caster frames", &CascadedShadowPass::staticCasterFrames, 1, 600);
+				ImGui::SliderFloat("cascade padding", &ComponentsModule::CascadeShadowComponent::stablePadding, 0.f, 1.f);
+			}
+			ImGui::End();
+		}
+
+		if (mPointShadowsDebugWindow && mRenderData.mPointPassData) {
+			if (ImGui::Begin("Point light shadows", &mPointShadowsDebugWindow)) {
+				auto& data = *mRenderData.mPointPassData;
+				const auto& stats = data.stats;
+				ImGui::Text("visible lights: %zu, shadowed: %zu, ready: %zu, cached: %zu", stats.lights, stats.shadowedLights, stats.readyLights, stats.cachedLights);
+				ImGui::Text("updated faces: %zu, pending faces: %zu, reallocations: %zu", stats.updatedFaces, stats.pendingFaces, stats.reallocations);
+				ImGui::Text("atlas: %.1f / %.1f Mtexels", static_cast<double>(stats.usedTexels) / 1e6, static_cast<double>(stats.capacityTexels) / 1e6);
+
+				auto& settings = data.settings;
+				const auto sliderU32 = [](const char* label, uint32_t* value, uint32_t min, uint32_t max) {
+					ImGui::SliderScalar(label, ImGuiDataType_U32, value, &min, &max);
+				};
+				sliderU32("faces budget", &settings.facesBudget, 0, 36);
+				sliderU32("shadowed lights", &settings.maxShadowedLights, 0, Render::RenderPasses::PointLightPass::MAX_SHADOWED_LIGHTS);
+				ImGui::SliderFloat("resolution scale", &settings.resolutionScale, 0.1f, 4.f);
+				sliderU32("max resolution", &settings.maxResolution, settings.minResolution, settings.pageSize);
+				sliderU32("evict frames", &settings.evictFrames, 1, 1000);
+			}
+			ImGui::End();
+		}
+
+		if (mRenderGraphDebugWindow) {
+			if (ImGui::Begin("Render graph", &mRenderGraphDebugWindow)) {
+				const auto& stats = mRenderGraph.getStats();
+				ImGui::Text("passes: %zu, culled: %zu, barriers: %zu", stats.passes, stats.culledPasses, stats.barriers);
+				ImGui::Text("transient textures: %zu, physical: %zu", stats.transientTextures, stats.physicalTextures);
+				ImGui::Text("transient memory: %.1f MB, allocated: %.1f MB", static_cast<double>(stats.transientBytes) / (1024.0 * 1024.0), static_cast<double>(stats.physicalBytes) / (1024.0 * 1024.0));
+
+				ImGui::Separator();
+				for (const auto& [pass, barriers] : mRenderGraph.getOrder()) {
+					ImGui::Text("%s, barriers: 0x%x", mRenderGraph.getPassName(pass).c_str(), barriers);
+				}
+				for (Render::RenderGraph::PassId pass = 0; pass < mRenderGraph.getPassesCount(); pass++) {
+					if (mRenderGraph.isCulled(pass)) {
+						ImGui::TextDisabled("%s, culled", mRenderGraph.getPassName(pass).c_str());
+					}
+				}
+
+				ImGui::Separator();
+				for (Render::RenderGraph::ResourceId resource = 0; resource < mRenderGraph.getResourcesCount(); resource++) {
+					if (mRenderGraph.isTransient(resource)) {
+						const auto& desc = mRenderGraph.getTextureDesc(resource);
+						ImGui::Text("%s: %ux%u, physical %u", mRenderGraph.getResourceName(resource).c_str(), desc.width, desc.height, mRenderGraph.getPhysicalIndex(resource));
+					}
+				}
+			}
+			ImGui::End();
+		}
+	}
+
+	void RenderSystem::prepareDataForNextFrame(RenderSnapshot& snapshot) {
+		FUNCTION_BENCHMARK;
+
+		//prepare data for next frame
+		auto& drawRegistry = ECSHandler::drawRegistry(mRenderData.currentRegistry);
+		const auto drawData = DrawDataHolder::instance();
+		mRenderData.changedCasters.clear();
+		{
+			FUNCTION_BENCHMARK_NAMED(copy_components_transform_armat);
+			if (!snapshot.transforms.empty()) {//todo support deleting
+				drawData->transformsBO.bind();
+				for (auto& [entId, component] : snapshot.transforms) {
+					drawRegistry.copyComponentToEntity(entId, &component);
+					drawData->updateTransform(entId, component.mTransform, false);
+					mRenderData.changedCasters.push_back(entId);
+				}
+				drawData->transformsBO.unbind();
+			}
+
+			if (!snapshot.bones.empty()) {
+				drawData->bonesBO.bind();
+				for (auto& [entId, component] : snapshot.bones) {
+					drawRegistry.copyComponentToEntity(entId, &component);
+					drawData->updateBones(entId, component.boneMatrices.data(), false);
+					mRenderData.changedCasters.push_back(entId);
+				}
+				drawData->bonesBO.unbind();
+			}
+
+			if (!snapshot.meshes.empty()) {
+				drawData->materialsBO.bind();
+				for (auto& [entId, component, hasMaterial] : snapshot.meshes) {
+					drawRegistry.copyComponentToEntity(entId, &component);
+					mRenderData.changedCasters.push_back(entId);
+					//entities without material read default row of material table
+					if (!hasMaterial) {
+						drawData->updateMaterial(entId, Render::MaterialTable::DEFAULT_MATERIAL, false);
+					}
+				}
+				drawData->materialsBO.unbind();
+			}
+
+			if (!snapshot.materials.empty()) {
+				drawData->materialsBO.bind();
+				for (auto& [entId, component] : snapshot.materials) {
+					component.tableIndex = Render::MaterialSystem::instance()->getMaterial(component.materials);
+					drawRegistry.copyComponentToEntity(entId, &component);
+					drawData->updateMaterial(entId, component.tableIndex, false);
+				}
+				drawData->materialsBO.unbind();
+			}
+		}
+
+		{
+			FUNCTION_BENCHMARK_NAMED(copy_components);
+			//outlines are taken from simulation every frame, draw registry keeps only the difference
+			auto& outlines = mOutlines[mRenderData.currentRegistry];
+			std::vector<ecss::EntityId> removedOutlines;
+			std::ranges::set_difference(outlines, snapshot.outlines, std::back_inserter(removedOutlines));
+			if (!removedOutlines.empty()) {
+				drawRegistry.removeComponent<OutlineComponent>(removedOutlines);
+			}
+			for (const auto entity : snapshot.outlines) {
+				if (!std::ranges::binary_search(outlines, entity)) {
+					drawRegistry.addComponent<OutlineComponent>(entity);
+				}
+			}
+			outlines = std::move(snapshot.outlines);
+
+			for (const auto& [entity, occluded] : mRenderData.occlusionResults) {
+				drawRegistry.addComponent<ComponentsModule::OccludedComponent>(entity)->occluded = occluded;
 			}
 		}
 	}
@@ -209,6 +576,21 @@ namespace SFE::SystemsModule {
 		}
 	}
 
+	void RenderSystem::notifyBatch(const std::vector<ecss::EntityId>& entities, TaskType type) {
+		if (type == ARMATURE_UPDATED) {
+			markDirty<ComponentsModule::ArmatureBonesComponent>(entities);
+		}
+		else if (type == MATERIAL_UPDATED) {
+			markDirty<ComponentsModule::MaterialComponent>(entities);
+		}
+		else if (type == MESH_UPDATED) {
+			markDirty<ComponentsModule::MeshComponent>(entities);
+		}
+		else {
+			TaskWorker::notifyBatch(entities, type);
+		}
+	}
+
 	RenderSystem::~RenderSystem() {
 		for (const auto renderPass : mRenderPasses) {
 			delete renderPass;
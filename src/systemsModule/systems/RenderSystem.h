@@ -1,16 +1,25 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "assetsModule/modelModule/BoundingVolume.h"
 #include "componentsModule/ArmatureComponent.h"
+#include "componentsModule/LightSourceComponent.h"
+#include "componentsModule/MaterialComponent.h"
+#include "componentsModule/MeshComponent.h"
 #include "componentsModule/OcclusionComponent.h"
 #include "componentsModule/OutlineComponent.h"
 #include "componentsModule/TransformComponent.h"
 #include "systemsModule/SystemBase.h"
+#include "renderModule/RenderGraph.h"
+#include "renderModule/RenderGraphTextures.h"
 #include "renderModule/renderPasses/RenderPass.h"
 #include "renderModule/renderPasses/CascadedShadowPass.h"
 #include "renderModule/renderPasses/GeometryPass.h"
+#include "renderModule/renderPasses/LightingPass.h"
 #include "renderModule/renderPasses/PointLightPass.h"
 #include "renderModule/renderPasses/SSAOPass.h"
 
@@ -34,6 +43,67 @@ namespace SFE::SystemsModule {
 		Math::Mat4 PV = {};
 	};
 
+	//simulation state which render of frame needs, it is copied on main thread after systems update,
+	//so render thread doesn't read main registry while next frame is simulated
+	struct RenderSnapshot {
+		struct Light {
+			ecss::EntityId entity = 0;
+			ComponentsModule::eLightType type = ComponentsModule::eLightType::NONE;
+			Math::Mat4 transform = Math::Mat4{ 1.f };
+			Math::Vec3 position = {};
+			Math::Vec3 color = {};
+			float radius = 0.f;
+			float nearPlane = 0.f;
+			float linear = 0.f;
+			float quadratic = 0.f;
+			float bias = 0.f;
+			int samples = 0;
+
+			Math::Vec3 getForward() const { return -Math::Vec3(transform[2]); }
+		};
+
+		struct Mesh {
+			ecss::EntityId entity = 0;
+			MeshComponent mesh;
+			bool hasMaterial = false;
+		};
+
+		struct Occludee {
+			ecss::EntityId entity = 0;
+			std::vector<FrustumModule::AABB> aabbs;
+		};
+
+		//cascades and their light matrices are calculated for camera of this snapshot
+		struct CascadeShadows {
+			ecss::EntityId entity = ecss::INVALID_ID;
+			std::vector<ComponentsModule::ShadowCascade> cascades;
+			std::vector<Math::Mat4> matrices;
+			std::vector<float> levels;
+			Math::Vec2 resolution = {};
+			float intensity = 0.f;
+		};
+
+		RenderMatrices camera;
+		MathModule::PerspectiveProjection cameraProjection = {};
+		FrustumModule::Frustum cameraFrustum;
+		Math::Vec3 cameraPos = {};
+		Math::Vec3 viewDir = {};
+
+		//dirty components, every entity stays dirty for two frames, so both draw registries get it
+		std::vector<std::pair<ecss::EntityId, ComponentsModule::TransformMatComp>> transforms;
+		std::vector<std::pair<ecss::EntityId, ComponentsModule::ArmatureBonesComponent>> bones;
+		std::vector<Mesh> meshes;
+		std::vector<std::pair<ecss::EntityId, MaterialComponent>> materials;
+
+		std::vector<ecss::EntityId> outlines; //sorted
+		std::vector<Light> lights;
+		CascadeShadows cascadeShadows;
+
+		//occlusion volumes of entities in camera frustum
+		std::vector<FrustumModule::AABB> occluders;
+		std::vector<Occludee> occludees;
+	};
+
 	struct RenderData {
 		FrustumModule::Frustum mCamFrustum;
 		FrustumModule::Frustum mNextCamFrustum;
@@ -49,13 +119,33 @@ namespace SFE::SystemsModule {
 		MathModule::PerspectiveProjection cameraProjection = {};
 		MathModule::PerspectiveProjection nextCameraProjection =  {};
 
+		RenderSnapshot::CascadeShadows cascadeShadows;
+		RenderSnapshot::CascadeShadows nextCascadeShadows;
+
 		Render::RenderPasses::CascadedShadowPass::Data* mCascadedShadowsPassData;
 		Render::RenderPasses::PointLightPass::Data* mPointPassData;
 		Render::RenderPasses::GeometryPass::Data* mGeometryPassData;
 		Render::RenderPasses::SSAOPass::Data* mSSAOPassData;
+		Render::RenderPasses::LightingPass::Data* mLightingPassData = nullptr;
 
 		RenderMode mRenderType = RenderMode::DEFAULT;
 
+		//entities which transform, mesh or bones were copied to draw registry last frame, shadow caches find moved casters by it
+		std::vector<ecss::EntityId> changedCasters;
+
+		std::vector<RenderSnapshot::Light> lights;
+		const RenderSnapshot::Light* findLight(ecss::EntityId entity) const {
+			const auto it = std::ranges::find(lights, entity, &RenderSnapshot::Light::entity);
+			return it != lights.end() ? &*it : nullptr;
+		}
+
+		//occlusion volumes of the next snapshot, occlusion pass rasterizes them for the next camera
+		std::vector<FrustumModule::AABB> nextOccluders;
+		std::vector<RenderSnapshot::Occludee> nextOccludees;
+
+		//occludees tested by occlusion pass this frame, they are copied to draw registry and to simulation on sync
+		std::vector<std::pair<ecss::EntityId, bool>> occlusionResults;
+
 		uint8_t currentRegistry = 0;
 		uint8_t nextRegistry = 1;
 
@@ -73,8 +163,21 @@ namespace SFE::SystemsModule {
 		void debugUpdate(float dt) override;
 		inline void setRenderType(RenderMode type) { mRenderData.mRenderType = type; }
 		inline RenderData& getRenderData() { return mRenderData; }
+		//passes changed their resources, graph is built again before next frame
+		inline void requestRenderGraphRebuild() { mRenderGraphDirty = true; }
+
+		//main thread
+		std::shared_ptr<RenderSnapshot> extract();
+		//render thread while simulation waits, results of render which simulation uses are written back here
+		void syncSimulation();
+		void setSnapshot(std::shared_ptr<RenderSnapshot> snapshot) { mSnapshot = std::move(snapshot); }
+		//camera frustum of the last snapshot, for systems which aren't on render thread
+		FrustumModule::Frustum getCameraFrustum() const {
+			auto lock = std::unique_lock(mCameraFrustumMutex);
+			return mCameraFrustum;
+		}
 
-		void prepareDataForNextFrame();
+		void prepareDataForNextFrame(RenderSnapshot& snapshot);
 
 		bool isShadowsDebugData() const {
 			return mShadowsDebugDataDraw;
@@ -89,6 +192,23 @@ namespace SFE::SystemsModule {
 		}
 
 		void notify(Task task) override;
+		void notifyBatch(const std::vector<ecss::EntityId>& entities, TaskType type) override;
+
+		template<typename CompType>
+		void markDirty(const std::vector<ecss::EntityId>& ids) {
+			if constexpr
+			(
+				std::is_same_v<CompType, MaterialComponent> ||
+				std::is_same_v<CompType, ComponentsModule::TransformMatComp> ||
+				std::is_same_v<CompType, ComponentsModule::ArmatureBonesComponent> ||
+				std::is_same_v<CompType, OutlineComponent> ||
+				std::is_same_v<CompType, MeshComponent> ||
+				std::is_same_v<CompType, ComponentsModule::OccludedComponent>
+			)
+			{
+				markDirtyImpl<CompType>(ids);
+			}
+		}
 
 		template<typename CompType>
 		void markDirty(ecss::EntityId id) {
@@ -106,6 +226,13 @@ namespace SFE::SystemsModule {
 			}
 		}
 
+		//physics blends bodies between ticks, blended matrix goes only to draw registries,
+		//TransformMatComp of simulation is written only by transform notifications and keeps state of the last tick
+		void setInterpolatedTransform(ecss::EntityId id, const Math::Mat4& transform) {
+			auto lock = std::unique_lock(dirtiesMutex);
+			mInterpolatedTransforms[id] = { transform, 2 };
+		}
+
 		template<typename T>
 		void markRemoved(ecss::EntityId id) {
 			auto lock = std::unique_lock(dirtiesMutex);
@@ -120,6 +247,11 @@ namespace SFE::SystemsModule {
 		}
 		
 		bool mShadowsDebugDataDraw = false;
+		bool mGeometryDebugWindow = true;
+		bool mLightsDebugWindow = true;
+		bool mShadowsDebugWindow = true;
+		bool mPointShadowsDebugWindow = true;
+		bool mRenderGraphDebugWindow = true;
 	private:
 
 		template<typename T>
@@ -139,17 +271,57 @@ namespace SFE::SystemsModule {
 			}
 		}
 
+		//dirty entities are looked up in set once instead of linear search for every id
+		template<typename T>
+		void markDirtyImpl(const std::vector<ecss::EntityId>& ids) {
+			auto lock = std::unique_lock(dirtiesMutex);
+			auto dirtyId = getDirtyId<T>();
+			if (dirties.size() <= dirtyId) {
+				dirties.resize(dirtyId + 1);
+			}
+			auto& entities = dirties[dirtyId];
+
+			std::unordered_map<ecss::EntityId, size_t> existing;
+			existing.reserve(entities.size());
+			for (size_t i = 0; i < entities.size(); i++) {
+				existing.emplace(entities[i].first, i);
+			}
+
+			entities.reserve(entities.size() + ids.size());
+			for (const auto id : ids) {
+				if (const auto it = existing.find(id); it != existing.end()) {
+					entities[it->second].second = 2;
+				}
+				else {
+					existing.emplace(id, entities.size());
+					entities.emplace_back(id, 2);
+				}
+			}
+		}
+
 		std::vector<SFE::Vector<std::pair<ecss::EntityId, uint8_t>>> dirties;
 		std::unordered_map<ecss::ECSType, SFE::Vector<std::pair<ecss::EntityId, uint8_t>>> removed;
+		std::unordered_map<ecss::EntityId, std::pair<Math::Mat4, uint8_t>> mInterpolatedTransforms;
 		std::shared_mutex dirtiesMutex;
 
+		Batcher::FrameStats mBatcherStats; //of the last rendered frame
+
 		
 
 		template<typename PassType>
-		inline void addRenderPass();
+		inline void addRenderPass(const std::string& name);
+		//passes declare their resources, graph is compiled and its transient textures are created, it is done again on rebuild request
+		void buildRenderGraph();
 
 		RenderData mRenderData;
+		std::shared_ptr<RenderSnapshot> mSnapshot;
+		FrustumModule::Frustum mCameraFrustum;
+		mutable std::mutex mCameraFrustumMutex;
+		std::vector<ecss::EntityId> mOutlines[2]; //per draw registry
 		std::vector<Render::RenderPass*> mRenderPasses;
+		Render::RenderGraph mRenderGraph;
+		Render::RenderGraphTextures mGraphTextures;
+		bool mRenderGraphDirty = false;
 		std::shared_future<void> updateLock;
 		GLW::Buffer<GLW::UNIFORM_BUFFER, RenderMatrices, GLW::DYNAMIC_DRAW> cameraMatricesUBO;
 	};
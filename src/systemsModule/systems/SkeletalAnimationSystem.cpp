@@ -27,7 +27,7 @@ namespace SFE::SystemsModule {
 				return;
 			}
 			
-			auto& camFrustum = renderSys->getRenderData().mCamFrustum;
+			const auto camFrustum = renderSys->getCameraFrustum();
 			for (auto& treePos : octreeSys->getAABBOctrees(camFrustum.generateAABB())) {
 				if (const auto tree = octreeSys->getOctree(treePos)) {
 					auto lock = tree->readLock();
@@ -47,19 +47,7 @@ namespace SFE::SystemsModule {
 		entities.removeDuplicatesSorted();
 		FUNCTION_BENCHMARK;
 
-		SFE::Vector<ecss::EntityId> entitiesToUpdate;
-		for (auto [entity, component ] : ECSHandler::registry().forEach<ComponentsModule::AnimationComponent>()) {
-			entitiesToUpdate.emplace_back(entity);
-		}
-
-		auto lock = ThreadPool::instance()->addBatchTasks(entitiesToUpdate.size(), 100, [&entitiesToUpdate, this](size_t idx) {
-			auto entityId = entitiesToUpdate[idx];
-			auto animationComp = ECSHandler::registry().getComponent<ComponentsModule::AnimationComponent>(entityId);
-			if (!animationComp) {
-				return;
-			}
-
-			auto [armatureComp, armBones, ocComp] = ECSHandler::registry().getComponents<ComponentsModule::ArmatureComponent, ComponentsModule::ArmatureBonesComponent, const ComponentsModule::OcclusionComponent>(entityId);
+		ECSHandler::parallelForEach<ComponentsModule::AnimationComponent, ComponentsModule::ArmatureComponent, ComponentsModule::ArmatureBonesComponent, const ComponentsModule::OcclusionComponent>(100, [this](ecss::EntityId entityId, ComponentsModule::AnimationComponent* animationComp, ComponentsModule::ArmatureComponent* armatureComp, ComponentsModule::ArmatureBonesComponent* armBones, const ComponentsModule::OcclusionComponent* ocComp) {
 			if (!animationComp || !armatureComp || !armBones) {
 				return;
 			}
@@ -81,8 +69,6 @@ namespace SFE::SystemsModule {
 				}
 			}
 		});
-
-		lock.waitAll();
 	}
 
 	template <typename KeyType>
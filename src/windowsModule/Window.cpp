@@ -1,10 +1,11 @@
 #include "Window.h"
 
+#include "glWrapper/Shader.h"
 #include "logsModule/logger.h"
 
 namespace SFE::Render {
 	void errorCallback(int error, const char* description) {
-		LogsModule::Logger::LOG_ERROR("GLFW Error: %d, %s\n", error, description);
+		SFE_LOG_ERROR("GLFW Error: %d, %s\n", error, description);
 	}
 
 	WindowSystem::~WindowSystem() {
@@ -82,7 +83,7 @@ namespace SFE::Render {
 		hints.apply();
 		mWindow = glfwCreateWindow(w, h, title.c_str(), nullptr, share);
 		if (!mWindow) {
-			LogsModule::Logger::LOG_FATAL(false, "Failed to create glfw window \"%s\"", title.c_str());
+			SFE_LOG_FATAL(false, "Failed to create glfw window \"%s\"", title.c_str());
 			return;
 		}
 		windows[mWindow] = this;
@@ -97,7 +98,8 @@ namespace SFE::Render {
 
 		if (!share) {
 			glfwMakeContextCurrent(mWindow);
-			LogsModule::Logger::LOG_FATAL(gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)), "Failed to initialize GLAD");
+			SFE_LOG_FATAL(gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)), "Failed to initialize GLAD");
+			GLW::initParallelShaderCompile(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 			glfwMakeContextCurrent(nullptr);
 		}
 
@@ -0,0 +1,195 @@
+﻿#include <cmath>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "mathModule/Forward.h"
+#include "renderModule/CascadePlanner.h"
+
+using namespace SFE;
+using namespace SFE::Render;
+
+namespace {
+	constexpr float RESOLUTION = 1024.f;
+	constexpr float PADDING = 0.15f;
+
+	Math::Mat4 translation(const Math::Vec3& pos) {
+		return Math::Mat4{ { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f }, { pos.x, pos.y, pos.z, 1.f } };
+	}
+
+	//camera view of camera at pos
+	Math::Mat4 cameraView(const Math::Vec3& pos) {
+		return translation(-pos);
+	}
+
+	Math::Mat4 lightTransform(const Math::Vec3& eulerDegrees) {
+		Math::Quaternion<float> rotation;
+		rotation.eulerToQuaternion(eulerDegrees);
+		return rotation.toMat4();
+	}
+
+	ShadowCascade makeCascade(float near, float far) {
+		ShadowCascade cascade;
+		cascade.viewProjection = { 45.f, 16.f / 9.f, near, far };
+		return cascade;
+	}
+
+	bool isWhole(float value) {
+		return std::fabs(value - std::round(value)) < 1e-2f;
+	}
+
+	void centerIsSnappedToTexels() {
+		const auto light = lightTransform({ -60.f, 0.f, 10.f });
+		auto cascade = makeCascade(0.1f, 50.f);
+		CascadePlanner::updateLightMatrix(cascade, cameraView({ 3.3f, 1.7f, -8.2f }), light, RESOLUTION, PADDING);
+
+		const auto texel = 2.f * cascade.stableRadius / RESOLUTION;
+		SFE_CHECK(isWhole(Math::dot(Math::normalize(Math::Vec3(light[0])), cascade.stableCenter) / texel));
+		SFE_CHECK(isWhole(Math::dot(Math::normalize(Math::Vec3(light[1])), cascade.stableCenter) / texel));
+	}
+
+	void cameraPartIsInsideCascade() {
+		const auto light = lightTransform({ -60.f, 0.f, 10.f });
+		const auto view = cameraView({ 10.f, 2.f, 5.f });
+		auto cascade = makeCascade(0.1f, 50.f);
+		const auto matrix = CascadePlanner::updateLightMatrix(cascade, view, light, RESOLUTION, PADDING);
+
+		for (const auto& corner : CascadePlanner::getFrustumCornersWorldSpace(cascade.viewProjection.getProjectionsMatrix() * view)) {
+			const auto clip = matrix * corner;
+			SFE_CHECK(std::fabs(clip.x / clip.w) <= 1.f);
+			SFE_CHECK(std::fabs(clip.y / clip.w) <= 1.f);
+			SFE_CHECK(std::fabs(clip.z / clip.w) <= 1.f);
+		}
+	}
+
+	void smallCameraMoveKeepsMatrix() {
+		const auto light = lightTransform({ -60.f, 0.f, 10.f });
+		auto cascade = makeCascade(0.1f, 50.f);
+		const auto first = CascadePlanner::updateLightMatrix(cascade, cameraView({}), light, RESOLUTION, PADDING);
+		const auto center = cascade.stableCenter;
+
+		//padding is 15% of radius which is bigger than 20 units for this cascade
+		const auto moved = CascadePlanner::updateLightMatrix(cascade, cameraView({ 0.5f, 0.f, 0.5f }), light, RESOLUTION, PADDING);
+		SFE_CHECK(moved == first);
+		SFE_CHECK(cascade.stableCenter == center);
+
+		const auto far = CascadePlanner::updateLightMatrix(cascade, cameraView({ 30.f, 0.f, 0.f }), light, RESOLUTION, PADDING);
+		SFE_CHECK(far != first);
+		SFE_CHECK(cascade.stableCenter != center);
+	}
+
+	void lightRotationRecenters() {
+		auto cascade = makeCascade(0.1f, 50.f);
+		const auto first = CascadePlanner::updateLightMatrix(cascade, cameraView({}), lightTransform({ -60.f, 0.f, 10.f }), RESOLUTION, PADDING);
+		const auto rotated = CascadePlanner::updateLightMatrix(cascade, cameraView({}), lightTransform({ -50.f, 0.f, 10.f }), RESOLUTION, PADDING);
+
+		SFE_CHECK(rotated != first);
+		SFE_CHECK(cascade.stableForward == Math::normalize(-Math::Vec3(lightTransform({ -50.f, 0.f, 10.f })[2])));
+	}
+
+	struct Frame {
+		std::vector<ShadowCascade> cascades;
+		std::vector<Math::Mat4> matrices;
+	};
+
+	Frame makeFrame(const Math::Vec3& cameraPos) {
+		Frame frame;
+		frame.cascades = { makeCascade(0.1f, 20.f), makeCascade(20.f, 100.f), makeCascade(100.f, 400.f) };
+		for (auto& cascade : frame.cascades) {
+			frame.matrices.push_back(CascadePlanner::updateLightMatrix(cascade, cameraView(cameraPos), lightTransform({ -60.f, 0.f, 10.f }), RESOLUTION, PADDING));
+		}
+		return frame;
+	}
+
+	const std::vector<uint8_t> NOT_DIRTY(3, false);
+
+	void newCascadesIgnoreBudget() {
+		const auto frame = makeFrame({});
+		const auto plan = CascadePlanner::plan({}, frame.cascades, frame.matrices, NOT_DIRTY, { 1, 2, 4 }, 0);
+
+		SFE_CHECK(plan.cascades.size() == 3);
+		for (size_t i = 0; i < 3; i++) {
+			SFE_CHECK(plan.refreshStatic[i]);
+			SFE_CHECK(plan.updateDynamic[i]);
+			SFE_CHECK(plan.cascades[i].valid);
+			SFE_CHECK(!plan.cascades[i].staticDirty);
+			SFE_CHECK(plan.cascades[i].matrix == frame.matrices[i]);
+		}
+	}
+
+	void cachedCascadesAreReused() {
+		const auto frame = makeFrame({});
+		const auto first = CascadePlanner::plan({}, frame.cascades, frame.matrices, NOT_DIRTY, { 1, 2, 4 }, 0);
+		const auto second = CascadePlanner::plan(first.cascades, frame.cascades, frame.matrices, NOT_DIRTY, { 1, 2, 4 }, 1);
+
+		for (size_t i = 0; i < 3; i++) {
+			SFE_CHECK(!second.refreshStatic[i]);
+		}
+	}
+
+	void budgetLimitsStaticUpdates() {
+		const auto frame = makeFrame({});
+		const auto first = CascadePlanner::plan({}, frame.cascades, frame.matrices, NOT_DIRTY, { 1, 2, 4 }, 0);
+
+		//all cascades are recentered, only one of them is rendered again per frame
+		const auto moved = makeFrame({ 1000.f, 0.f, 0.f });
+		const auto second = CascadePlanner::plan(first.cascades, moved.cascades, moved.matrices, NOT_DIRTY, { 1, 2, 4 }, 1);
+		SFE_CHECK(second.refreshStatic[0]);
+		SFE_CHECK(!second.refreshStatic[1]);
+		SFE_CHECK(!second.refreshStatic[2]);
+		SFE_CHECK(second.cascades[0].matrix == moved.matrices[0]);
+		//cascades out of budget keep matrix of their cache and stay dirty
+		SFE_CHECK(second.cascades[1].matrix == frame.matrices[1]);
+		SFE_CHECK(second.cascades[1].staticDirty);
+
+		const auto third = CascadePlanner::plan(second.cascades, moved.cascades, moved.matrices, NOT_DIRTY, { 1, 2, 4 }, 2);
+		SFE_CHECK(!third.refreshStatic[0]);
+		SFE_CHECK(third.refreshStatic[1]);
+		SFE_CHECK(!third.refreshStatic[2]);
+
+		const auto fourth = CascadePlanner::plan(third.cascades, moved.cascades, moved.matrices, NOT_DIRTY, { 1, 2, 4 }, 3);
+		SFE_CHECK(fourth.refreshStatic[2]);
+		SFE_CHECK(fourth.cascades[2].matrix == moved.matrices[2]);
+	}
+
+	void changedCastersRefreshCascade() {
+		const auto frame = makeFrame({});
+		const auto first = CascadePlanner::plan({}, frame.cascades, frame.matrices, NOT_DIRTY, { 1, 2, 4 }, 0);
+		const auto second = CascadePlanner::plan(first.cascades, frame.cascades, frame.matrices, { false, true, false }, { 1, 2, 4 }, 1);
+
+		SFE_CHECK(!second.refreshStatic[0]);
+		SFE_CHECK(second.refreshStatic[1]);
+		SFE_CHECK(!second.refreshStatic[2]);
+		SFE_CHECK(second.updateDynamic[1]);
+	}
+
+	void distantCascadesUpdateByInterval() {
+		const auto frame = makeFrame({});
+		auto caches = CascadePlanner::plan({}, frame.cascades, frame.matrices, NOT_DIRTY, { 1, 2, 4 }, 0).cascades;
+
+		//only the last cascade is distant, it gets dynamic casters when (frame + 2) % 4 == 0
+		size_t distantUpdates = 0;
+		for (uint64_t i = 1; i <= 8; i++) {
+			const auto plan = CascadePlanner::plan(caches, frame.cascades, frame.matrices, NOT_DIRTY, { 1, 2, 4 }, i);
+			SFE_CHECK(plan.updateDynamic[0]);
+			SFE_CHECK(plan.updateDynamic[1]);
+			SFE_CHECK(plan.updateDynamic[2] == ((i + 2) % 4 == 0));
+			distantUpdates += plan.updateDynamic[2];
+			caches = plan.cascades;
+		}
+		SFE_CHECK(distantUpdates == 2);
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "centerIsSnappedToTexels", centerIsSnappedToTexels },
+		{ "cameraPartIsInsideCascade", cameraPartIsInsideCascade },
+		{ "smallCameraMoveKeepsMatrix", smallCameraMoveKeepsMatrix },
+		{ "lightRotationRecenters", lightRotationRecenters },
+		{ "newCascadesIgnoreBudget", newCascadesIgnoreBudget },
+		{ "cachedCascadesAreReused", cachedCascadesAreReused },
+		{ "budgetLimitsStaticUpdates", budgetLimitsStaticUpdates },
+		{ "changedCastersRefreshCascade", changedCastersRefreshCascade },
+		{ "distantCascadesUpdateByInterval", distantCascadesUpdateByInterval },
+	});
+}
@@ -0,0 +1,171 @@
+﻿#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "assetsModule/ChunkCooker.h"
+#include "propertiesModule/SceneFile.h"
+
+using namespace AssetsModule;
+using SFE::PropertiesModule::BinaryWriter;
+using SFE::PropertiesModule::SceneFile;
+using SFE::Math::IVec3;
+using SFE::Math::Vec3;
+
+namespace {
+	constexpr float CHUNK_SIZE = 100.f;
+
+	uint32_t addNode(SceneFile& scene, uint32_t parent, const Vec3& pos, const Vec3& rotate = {}, const Vec3& scale = { 1.f }) {
+		const auto node = scene.addNode(parent, {});
+		scene.getBlock(SceneFile::BlockType::TRANSFORM).addRecord(node, [&](BinaryWriter& writer) {
+			writer.write(scale);
+			writer.write(pos);
+			writer.write(rotate);
+		});
+		return node;
+	}
+
+	void setModel(SceneFile& scene, uint32_t node, const std::string& path) {
+		const auto model = scene.addModel(path);
+		scene.getBlock(SceneFile::BlockType::MODEL).addRecord(node, [model](BinaryWriter& writer) { writer.write(model); });
+	}
+
+	bool near(const Vec3& lhs, const Vec3& rhs) {
+		return std::abs(lhs.x - rhs.x) < 1e-3f && std::abs(lhs.y - rhs.y) < 1e-3f && std::abs(lhs.z - rhs.z) < 1e-3f;
+	}
+
+	const ChunkCooker::Chunk* findChunk(const std::vector<ChunkCooker::Chunk>& chunks, const IVec3& coords) {
+		for (const auto& chunk : chunks) {
+			if (chunk.coords == coords) {
+				return &chunk;
+			}
+		}
+		return nullptr;
+	}
+
+	void chunkOfPosition() {
+		SFE_CHECK(ChunkFile::getChunk({ 0.f, 99.9f, 100.f }, CHUNK_SIZE) == IVec3(0, 0, 1));
+		SFE_CHECK(ChunkFile::getChunk({ -0.1f, -100.f, -100.1f }, CHUNK_SIZE) == IVec3(-1, -1, -2));
+		SFE_CHECK(ChunkFile::getPath({ -1, 0, 2 }) == "chunks/-1_0_2.chunk");
+		SFE_CHECK(ChunkFile::getPath({ 3, 4, 5 }, "cooked") == "cooked/3_4_5.chunk");
+	}
+
+	void splitsByChunkCoords() {
+		SceneFile scene;
+		const auto root = scene.addNode(SceneFile::NO_PARENT, {});
+		setModel(scene, addNode(scene, root, { 10.f, 0.f, 10.f }), "tree");
+		setModel(scene, addNode(scene, root, { 50.f, 0.f, 90.f }), "rock");
+		setModel(scene, addNode(scene, root, { 20.f, 0.f, 30.f }), "tree");
+		setModel(scene, addNode(scene, root, { -10.f, 0.f, 250.f }), "tree");
+		//node without model isn't cooked
+		addNode(scene, root, { 500.f, 0.f, 500.f });
+
+		const auto chunks = ChunkCooker::split(scene, CHUNK_SIZE);
+		SFE_CHECK(chunks.size() == 2);
+		//sorted by coords
+		SFE_CHECK(chunks[0].coords == IVec3(-1, 0, 2));
+		SFE_CHECK(chunks[1].coords == IVec3(0, 0, 0));
+
+		const auto& first = chunks[1].file;
+		SFE_CHECK(first.models.size() == 2);
+		SFE_CHECK(first.models[0] == "tree" && first.models[1] == "rock");
+		SFE_CHECK(first.instances.size() == 3);
+		//instances of the same model go together, order of scene is kept inside model
+		SFE_CHECK(first.instances[0].model == 0 && near(first.instances[0].pos, { 10.f, 0.f, 10.f }));
+		SFE_CHECK(first.instances[1].model == 0 && near(first.instances[1].pos, { 20.f, 0.f, 30.f }));
+		SFE_CHECK(first.instances[2].model == 1 && near(first.instances[2].pos, { 50.f, 0.f, 90.f }));
+
+		//chunk has only models it uses
+		const auto& second = chunks[0].file;
+		SFE_CHECK(second.models.size() == 1 && second.models[0] == "tree");
+		SFE_CHECK(second.instances.size() == 1 && second.instances[0].model == 0);
+	}
+
+	void flattensHierarchy() {
+		SceneFile scene;
+		//parent in chunk 0 moves child into chunk 1 by x
+		const auto parent = addNode(scene, SceneFile::NO_PARENT, { 90.f, 0.f, 0.f }, { 0.f, 0.f, 90.f }, { 2.f });
+		const auto child = addNode(scene, parent, { 0.f, -10.f, 0.f }, { 0.f, 0.f, 0.f }, { 0.5f, 1.f, 1.f });
+		setModel(scene, child, "lamp");
+		setModel(scene, parent, "pole");
+
+		const auto chunks = ChunkCooker::split(scene, CHUNK_SIZE);
+		SFE_CHECK(chunks.size() == 2);
+
+		const auto pole = findChunk(chunks, { 0, 0, 0 });
+		SFE_CHECK(pole && pole->file.instances.size() == 1);
+		SFE_CHECK(pole && near(pole->file.instances[0].scale, { 2.f, 2.f, 2.f }));
+
+		//rotation by 90 degrees around z turns -y into +x, parent scale doubles offset
+		const auto lamp = findChunk(chunks, { 1, 0, 0 });
+		SFE_CHECK(lamp && lamp->file.instances.size() == 1);
+		if (lamp) {
+			const auto& instance = lamp->file.instances[0];
+			SFE_CHECK(lamp->file.models[instance.model] == "lamp");
+			SFE_CHECK(near(instance.pos, { 110.f, 0.f, 0.f }));
+			SFE_CHECK(near(instance.rotate, { 0.f, 0.f, 90.f }));
+			SFE_CHECK(near(instance.scale, { 1.f, 2.f, 2.f }));
+		}
+	}
+
+	void streamerReadsCookedChunks() {
+		SceneFile scene;
+		std::vector<Vec3> positions;
+		for (int i = 0; i < 64; i++) {
+			const Vec3 pos = { static_cast<float>(i * 37 % 500) - 250.f, static_cast<float>(i % 3) * 60.f, static_cast<float>(i * 53 % 400) - 200.f };
+			positions.push_back(pos);
+			setModel(scene, addNode(scene, SceneFile::NO_PARENT, pos), "model" + std::to_string(i % 5));
+		}
+
+		//files as chunks system finds them: by path of chunk which camera position falls into
+		std::unordered_map<std::string, std::vector<uint8_t>> files;
+		size_t instances = 0;
+		for (const auto& chunk : ChunkCooker::split(scene, CHUNK_SIZE)) {
+			chunk.file.write(files[ChunkFile::getPath(chunk.coords)]);
+			instances += chunk.file.instances.size();
+		}
+		SFE_CHECK(instances == positions.size());
+
+		for (size_t i = 0; i < positions.size(); i++) {
+			const auto it = files.find(ChunkFile::getPath(ChunkFile::getChunk(positions[i], CHUNK_SIZE)));
+			SFE_CHECK(it != files.end());
+			if (it == files.end()) {
+				continue;
+			}
+
+			ChunkFile file;
+			SFE_CHECK(file.read(it->second));
+			bool found = false;
+			for (const auto& instance : file.instances) {
+				found |= near(instance.pos, positions[i]) && file.models[instance.model] == "model" + std::to_string(i % 5);
+			}
+			SFE_CHECK(found);
+		}
+	}
+
+	void brokenRecordsAreSkipped() {
+		SceneFile scene;
+		const auto node = addNode(scene, SceneFile::NO_PARENT, { 1.f, 1.f, 1.f });
+		setModel(scene, node, "model");
+		//model index out of table
+		scene.getBlock(SceneFile::BlockType::MODEL).addRecord(node, [](BinaryWriter& writer) { writer.write(uint32_t{ 7 }); });
+		//record of node which doesn't exist
+		scene.getBlock(SceneFile::BlockType::MODEL).addRecord(42, [](BinaryWriter& writer) { writer.write(uint32_t{ 0 }); });
+
+		const auto chunks = ChunkCooker::split(scene, CHUNK_SIZE);
+		SFE_CHECK(chunks.size() == 1);
+		SFE_CHECK(chunks.size() == 1 && chunks[0].file.instances.size() == 1);
+		SFE_CHECK(ChunkCooker::split(SceneFile{}, CHUNK_SIZE).empty());
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "chunk of position", chunkOfPosition },
+		{ "splits by chunk coords", splitsByChunkCoords },
+		{ "flattens hierarchy", flattensHierarchy },
+		{ "streamer reads cooked chunks", streamerReadsCookedChunks },
+		{ "broken records are skipped", brokenRecordsAreSkipped },
+	});
+}
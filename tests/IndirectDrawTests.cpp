@@ -0,0 +1,209 @@
+﻿#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "mathModule/Forward.h"
+#include "mathModule/Utils.h"
+#include "renderModule/IndirectDraw.h"
+
+using namespace SFE;
+
+namespace {
+	Math::Mat4 translation(const Math::Vec3& pos) {
+		Math::Mat4 transform{ 1.f };
+		transform[3] = Math::Vec4(pos, 1.f);
+		return transform;
+	}
+
+	//camera in origin looking to -z
+	FrustumModule::Frustum cameraFrustum() {
+		return FrustumModule::createFrustum(Math::perspectiveRH_NO(Math::radians(60.f), 1.5f, 0.1f, 100.f));
+	}
+
+	struct Scene {
+		std::vector<Math::Mat4> matrices;
+		std::vector<const Math::Mat4*> transforms;
+
+		struct Draw {
+			uint32_t indicesCount;
+			uint32_t firstIndex;
+			int32_t baseVertex;
+			bool hasBounds;
+			FrustumModule::AABB bounds;
+			std::vector<uint32_t> entities;
+		};
+		std::vector<Draw> draws;
+
+		void fill(Render::IndirectDrawList& list) const {
+			for (const auto& draw : draws) {
+				list.addDraw(draw.indicesCount, draw.firstIndex, draw.baseVertex, draw.hasBounds ? &draw.bounds : nullptr, draw.entities, &transforms);
+			}
+		}
+	};
+
+	Scene randomScene(uint32_t seed, size_t entities, size_t draws) {
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-60.f, 60.f);
+		std::uniform_real_distribution<float> extent(0.1f, 4.f);
+		std::uniform_int_distribution<size_t> entity(0, entities - 1);
+
+		Scene scene;
+		scene.matrices.reserve(entities);
+		for (size_t i = 0; i < entities; i++) {
+			scene.matrices.push_back(translation({ position(random), position(random), position(random) }));
+		}
+		for (const auto& matrix : scene.matrices) {
+			scene.transforms.push_back(&matrix);
+		}
+
+		for (size_t i = 0; i < draws; i++) {
+			auto& draw = scene.draws.emplace_back();
+			draw.indicesCount = 36 + static_cast<uint32_t>(i) * 3;
+			draw.firstIndex = static_cast<uint32_t>(i) * 1000;
+			draw.baseVertex = static_cast<int32_t>(i) * 500;
+			draw.hasBounds = i % 7 != 3;
+			draw.bounds = FrustumModule::AABB(Math::Vec3{ 0.f }, extent(random), extent(random), extent(random));
+
+			const auto count = entity(random) % 50 + 1;
+			for (size_t j = 0; j < count; j++) {
+				draw.entities.push_back(static_cast<uint32_t>(entity(random)));
+			}
+		}
+
+		return scene;
+	}
+
+	//what the instanced path draws: every instance of every draw with its own command, culling is done per instance without compaction
+	void checkAgainstReference(const Scene& scene, const Render::IndirectDrawList& list, const FrustumModule::Frustum* frustum) {
+		const auto& commands = list.getCulledCommands();
+		const auto& visible = list.getVisibleInstances();
+		SFE_CHECK(commands.size() == scene.draws.size());
+		SFE_CHECK(visible.size() == list.getInstances().size());
+
+		uint32_t baseInstance = 0;
+		for (size_t i = 0; i < scene.draws.size() && i < commands.size(); i++) {
+			const auto& draw = scene.draws[i];
+			const auto& command = commands[i];
+
+			std::vector<uint32_t> expected;
+			for (const auto entity : draw.entities) {
+				if (!frustum || !draw.hasBounds || draw.bounds.isOnFrustum(*frustum, scene.matrices[entity])) {
+					expected.push_back(entity);
+				}
+			}
+
+			SFE_CHECK(command.count == draw.indicesCount);
+			SFE_CHECK(command.firstIndex == draw.firstIndex);
+			SFE_CHECK(command.baseVertex == draw.baseVertex);
+			SFE_CHECK(command.baseInstance == baseInstance);
+			SFE_CHECK(command.instanceCount == expected.size());
+
+			const std::vector<uint32_t> actual(visible.begin() + command.baseInstance, visible.begin() + command.baseInstance + command.instanceCount);
+			SFE_CHECK(actual == expected);
+
+			baseInstance += static_cast<uint32_t>(draw.entities.size());
+		}
+	}
+
+	void layout() {
+		Scene scene = randomScene(1, 200, 20);
+		Render::IndirectDrawList list;
+		scene.fill(list);
+
+		SFE_CHECK(!list.empty());
+		SFE_CHECK(list.getCommands().size() == scene.draws.size());
+		SFE_CHECK(list.getBounds().size() == scene.draws.size());
+
+		size_t instance = 0;
+		for (size_t i = 0; i < scene.draws.size(); i++) {
+			const auto& draw = scene.draws[i];
+			const auto& command = list.getCommands()[i];
+			SFE_CHECK(command.baseInstance == instance);
+			SFE_CHECK(command.instanceCount == draw.entities.size());
+			SFE_CHECK((list.getBounds()[i].center.w > 0.f) == draw.hasBounds);
+
+			for (const auto entity : draw.entities) {
+				SFE_CHECK(list.getInstances()[instance] == entity);
+				SFE_CHECK(list.getInstanceDraws()[instance] == i);
+				instance++;
+			}
+		}
+		SFE_CHECK(list.getInstances().size() == instance);
+
+		for (const auto& command : list.getCullingCommands()) {
+			SFE_CHECK(command.instanceCount == 0);
+		}
+
+		list.clear();
+		SFE_CHECK(list.empty());
+		SFE_CHECK(list.getInstances().empty());
+	}
+
+	void knownVisibility() {
+		std::vector<Math::Mat4> matrices = { translation({ 0.f, 0.f, -10.f }), translation({ 0.f, 0.f, 10.f }), translation({ 500.f, 0.f, -10.f }), translation({ 0.f, 0.f, -99.5f }) };
+		std::vector<const Math::Mat4*> transforms = { &matrices[0], &matrices[1], &matrices[2], &matrices[3] };
+		const FrustumModule::AABB box(Math::Vec3{ 0.f }, 1.f, 1.f, 1.f);
+		const std::vector<uint32_t> entities = { 0, 1, 2, 3 };
+
+		Render::IndirectDrawList list;
+		list.addDraw(36, 0, 0, &box, entities, &transforms);
+		list.addDraw(36, 36, 24, nullptr, entities, &transforms);
+
+		const auto frustum = cameraFrustum();
+		list.cull(&frustum);
+
+		//in front, behind, far to the side, crossing far plane
+		const auto& commands = list.getCulledCommands();
+		const auto& visible = list.getVisibleInstances();
+		SFE_CHECK(commands[0].instanceCount == 2);
+		SFE_CHECK(visible[0] == 0);
+		SFE_CHECK(visible[1] == 3);
+
+		//draw without bounds is never culled
+		SFE_CHECK(commands[1].instanceCount == 4);
+		SFE_CHECK(commands[1].baseInstance == 4);
+	}
+
+	void culledMatchesReference() {
+		const auto frustum = cameraFrustum();
+		size_t instances = 0;
+		size_t visible = 0;
+		for (uint32_t seed = 0; seed < 16; seed++) {
+			Scene scene = randomScene(seed, 500, 40);
+			Render::IndirectDrawList list;
+			scene.fill(list);
+
+			list.cull(&frustum);
+			checkAgainstReference(scene, list, &frustum);
+
+			instances += list.getInstances().size();
+			for (const auto& command : list.getCulledCommands()) {
+				visible += command.instanceCount;
+			}
+		}
+
+		//scene is spread around camera, so both outcomes are covered
+		SFE_CHECK(visible > 0);
+		SFE_CHECK(visible < instances);
+	}
+
+	void compactionWithoutFrustum() {
+		Scene scene = randomScene(7, 100, 10);
+		Render::IndirectDrawList list;
+		scene.fill(list);
+
+		list.cull(nullptr);
+		checkAgainstReference(scene, list, nullptr);
+		SFE_CHECK(list.getVisibleInstances() == list.getInstances());
+	}
+}
+
+int main() {
+	return Tests::run({
+		{ "layout", layout },
+		{ "known visibility", knownVisibility },
+		{ "culled matches reference", culledMatchesReference },
+		{ "compaction without frustum", compactionWithoutFrustum },
+	});
+}
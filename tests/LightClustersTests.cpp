@@ -0,0 +1,179 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "mathModule/Forward.h"
+#include "mathModule/Utils.h"
+#include "renderModule/LightClusters.h"
+
+using namespace SFE;
+using Render::LightClusters;
+
+namespace {
+	constexpr float NEAR = 0.1f;
+	constexpr float FAR = 100.f;
+
+	Math::Mat4 cameraProjection() {
+		return Math::perspectiveRH_NO(Math::radians(60.f), 1.5f, NEAR, FAR);
+	}
+
+	LightClusters makeClusters() {
+		LightClusters clusters;
+		clusters.setProjection(cameraProjection(), NEAR, FAR);
+		return clusters;
+	}
+
+	//cluster of view space point, false when point is out of frustum
+	bool findCluster(const LightClusters& clusters, const Math::Vec3& point, uint32_t& cluster) {
+		const auto clip = cameraProjection() * Math::Vec4(point, 1.f);
+		if (clip.w <= 0.f || -point.z < NEAR || -point.z > FAR) {
+			return false;
+		}
+
+		const auto ndcX = clip.x / clip.w;
+		const auto ndcY = clip.y / clip.w;
+		if (std::abs(ndcX) >= 1.f || std::abs(ndcY) >= 1.f) {
+			return false;
+		}
+
+		const auto x = static_cast<uint32_t>((ndcX * 0.5f + 0.5f) * LightClusters::CLUSTERS_X);
+		const auto y = static_cast<uint32_t>((ndcY * 0.5f + 0.5f) * LightClusters::CLUSTERS_Y);
+		cluster = LightClusters::getClusterIndex(x, y, clusters.getSlice(-point.z));
+		return true;
+	}
+
+	bool hasLight(const LightClusters& clusters, uint32_t cluster, uint32_t light) {
+		const auto& range = clusters.getClusters()[cluster];
+		const auto begin = clusters.getLightIndices().begin() + range.offset;
+		return std::find(begin, begin + range.count, light) != begin + range.count;
+	}
+
+	void slicesAreExponential() {
+		const auto clusters = makeClusters();
+		SFE_CHECK(clusters.getSlice(0.f) == 0);
+		SFE_CHECK(clusters.getSlice(NEAR) == 0);
+		SFE_CHECK(clusters.getSlice(FAR * 2.f) == LightClusters::CLUSTERS_Z - 1);
+
+		for (uint32_t slice = 0; slice < LightClusters::CLUSTERS_Z; slice++) {
+			const auto depth = NEAR * std::pow(FAR / NEAR, (static_cast<float>(slice) + 0.5f) / static_cast<float>(LightClusters::CLUSTERS_Z));
+			SFE_CHECK(clusters.getSlice(depth) == slice);
+		}
+	}
+
+	void lightIsInItsClusters() {
+		auto clusters = makeClusters();
+		const std::vector<LightClusters::Light> lights = {
+			{ { 0.f, 0.f, -10.f }, 0.5f },
+			//behind camera
+			{ { 0.f, 0.f, 20.f }, 1.f },
+			//out of screen
+			{ { 500.f, 0.f, -10.f }, 1.f },
+		};
+		clusters.assign(Math::Mat4{ 1.f }, lights);
+
+		uint32_t center = 0;
+		SFE_CHECK(findCluster(clusters, { 0.f, 0.f, -10.f }, center));
+		SFE_CHECK(hasLight(clusters, center, 0));
+
+		//slices far from light depth don't have it
+		const auto near = clusters.getSlice(9.f);
+		const auto far = clusters.getSlice(11.f);
+		size_t count = 0;
+		for (uint32_t cluster = 0; cluster < LightClusters::CLUSTERS_COUNT; cluster++) {
+			const auto slice = cluster / (LightClusters::CLUSTERS_X * LightClusters::CLUSTERS_Y);
+			const auto has = hasLight(clusters, cluster, 0);
+			count += has;
+			SFE_CHECK(!has || (slice >= near && slice <= far));
+			SFE_CHECK(!hasLight(clusters, cluster, 1));
+			SFE_CHECK(!hasLight(clusters, cluster, 2));
+		}
+		SFE_CHECK(count > 0 && count < 64);
+		SFE_CHECK(clusters.getLightIndices().size() == count);
+	}
+
+	void assignmentIsConservative() {
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+		//count isn't multiple of four, so padding lanes are used too
+		std::vector<LightClusters::Light> lights;
+		for (int i = 0; i < 37; i++) {
+			const auto depth = 0.5f + unit(random) * 60.f;
+			lights.push_back({ { (unit(random) - 0.5f) * depth * 1.6f, (unit(random) - 0.5f) * depth, -depth }, 0.2f + unit(random) * 4.f });
+		}
+
+		//lights are in world space, camera is moved
+		Math::Mat4 view{ 1.f };
+		view[3] = Math::Vec4(1.f, -2.f, 3.f, 1.f);
+		std::vector<LightClusters::Light> worldLights = lights;
+		for (auto& light : worldLights) {
+			light.position = light.position - Math::Vec3(1.f, -2.f, 3.f);
+		}
+
+		auto clusters = makeClusters();
+		clusters.assign(view, worldLights);
+
+		//every point of light sphere inside of frustum is in cluster which has this light
+		for (uint32_t light = 0; light < lights.size(); light++) {
+			for (int sample = 0; sample < 200; sample++) {
+				Math::Vec3 offset = { unit(random) * 2.f - 1.f, unit(random) * 2.f - 1.f, unit(random) * 2.f - 1.f };
+				if (Math::lengthSquared(offset) > 1.f) {
+					continue;
+				}
+
+				uint32_t cluster = 0;
+				if (findCluster(clusters, lights[light].position + offset * lights[light].radius * 0.99f, cluster)) {
+					SFE_CHECK(hasLight(clusters, cluster, light));
+				}
+			}
+		}
+
+		//ranges are packed one after another
+		uint32_t offset = 0;
+		for (const auto& cluster : clusters.getClusters()) {
+			SFE_CHECK(cluster.offset == offset);
+			offset += cluster.count;
+		}
+		SFE_CHECK(offset == clusters.getLightIndices().size());
+	}
+
+	void parallelAssignmentMatches() {
+		std::vector<LightClusters::Light> lights;
+		for (int i = 0; i < 64; i++) {
+			lights.push_back({ { static_cast<float>(i % 8) - 4.f, static_cast<float>(i / 8) - 4.f, -5.f - static_cast<float>(i) }, 2.f });
+		}
+
+		auto serial = makeClusters();
+		serial.assign(Math::Mat4{ 1.f }, lights);
+
+		auto parallel = makeClusters();
+		parallel.assign(Math::Mat4{ 1.f }, lights, [](size_t count, const std::function<void(size_t)>& task) {
+			for (size_t i = count; i > 0; i--) {
+				task(i - 1);
+			}
+		});
+
+		SFE_CHECK(serial.getLightIndices() == parallel.getLightIndices());
+		for (uint32_t cluster = 0; cluster < LightClusters::CLUSTERS_COUNT; cluster++) {
+			SFE_CHECK(serial.getClusters()[cluster].offset == parallel.getClusters()[cluster].offset);
+			SFE_CHECK(serial.getClusters()[cluster].count == parallel.getClusters()[cluster].count);
+		}
+
+		//no lights, no indices
+		serial.assign(Math::Mat4{ 1.f }, {});
+		SFE_CHECK(serial.getLightIndices().empty());
+		SFE_CHECK(serial.getClusters().size() == LightClusters::CLUSTERS_COUNT);
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "slices are exponential", slicesAreExponential },
+		{ "light is in its clusters", lightIsInItsClusters },
+		{ "assignment is conservative", assignmentIsConservative },
+		{ "parallel assignment matches", parallelAssignmentMatches },
+	});
+}
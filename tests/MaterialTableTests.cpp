@@ -0,0 +1,144 @@
+﻿#include <optional>
+#include <set>
+
+#include "TestsCommon.h"
+#include "renderModule/MaterialTable.h"
+
+using namespace SFE::Render;
+
+namespace {
+	constexpr TextureArrayKey RGBA_512{ 1, 512, 512, 10 };
+	constexpr TextureArrayKey RGBA_256{ 1, 256, 256, 9 };
+	constexpr TextureArrayKey BC5_512{ 2, 512, 512, 10 };
+
+	//textures below 100 are 512 rgba, below 200 are 256 rgba, others are 512 bc5
+	std::optional<TextureArrayKey> resolve(uint32_t textureId) {
+		return textureId < 100 ? RGBA_512 : textureId < 200 ? RGBA_256 : BC5_512;
+	}
+
+	std::optional<TextureArrayKey> notLoaded(uint32_t) {
+		return std::nullopt;
+	}
+
+	void defaultMaterialIsFirstRow() {
+		MaterialTable table;
+		SFE_CHECK(table.getRows().size() == 1);
+		SFE_CHECK(table.getMaterial({ 0, 0, 0 }, resolve) == MaterialTable::DEFAULT_MATERIAL);
+		SFE_CHECK(table.getRows().size() == 1);
+
+		const auto& row = table.getRows()[MaterialTable::DEFAULT_MATERIAL];
+		for (const auto layer : row.layers) {
+			SFE_CHECK(layer == -1);
+		}
+		SFE_CHECK(table.getBindings(MaterialTable::DEFAULT_MATERIAL) == MaterialTable::Bindings{});
+	}
+
+	void equalTexturesShareRow() {
+		MaterialTable table;
+		const auto first = table.getMaterial({ 1, 200, 2 }, resolve);
+		const auto second = table.getMaterial({ 1, 200, 2 }, resolve);
+		const auto other = table.getMaterial({ 1, 200, 3 }, resolve);
+
+		SFE_CHECK(first == second);
+		SFE_CHECK(first != other);
+		SFE_CHECK(table.getRows().size() == 3);
+	}
+
+	void rowKeepsLayerAndPageOfSlots() {
+		MaterialTable table;
+		const auto material = table.getMaterial({ 1, 200, 0 }, resolve);
+		const auto& row = table.getRows()[material];
+		const auto& bindings = table.getBindings(material);
+
+		SFE_CHECK(row.layers[MaterialTable::DIFFUSE_TEXTURE] == 0);
+		SFE_CHECK(row.layers[MaterialTable::NORMAL_TEXTURE] == 0);
+		SFE_CHECK(row.layers[MaterialTable::SPECULAR_TEXTURE] == -1);
+		SFE_CHECK(bindings.pages[MaterialTable::SPECULAR_TEXTURE] == MaterialTable::INVALID_PAGE);
+
+		//normal map has other format, so it is in other page
+		const auto& pages = table.getPages();
+		SFE_CHECK(bindings.pages[MaterialTable::DIFFUSE_TEXTURE] != bindings.pages[MaterialTable::NORMAL_TEXTURE]);
+		SFE_CHECK(pages[bindings.pages[MaterialTable::DIFFUSE_TEXTURE]].key == RGBA_512);
+		SFE_CHECK(pages[bindings.pages[MaterialTable::NORMAL_TEXTURE]].key == BC5_512);
+	}
+
+	void texturesArePackedByKey() {
+		MaterialTable table;
+		//the same texture in several materials takes one layer
+		table.getMaterial({ 1, 0, 0 }, resolve);
+		table.getMaterial({ 2, 0, 1 }, resolve);
+		table.getMaterial({ 101, 0, 0 }, resolve);
+		table.getMaterial({ 3, 0, 0 }, resolve);
+
+		const auto& pages = table.getPages();
+		SFE_CHECK(pages.size() == 2);
+		SFE_CHECK(pages[0].key == RGBA_512);
+		SFE_CHECK((pages[0].textures == std::vector<uint32_t>{ 1, 2, 3 }));
+		SFE_CHECK(pages[1].key == RGBA_256);
+		SFE_CHECK((pages[1].textures == std::vector<uint32_t>{ 101 }));
+	}
+
+	void pageGrowsUpToMaxLayers() {
+		MaterialTable table;
+		for (uint32_t i = 1; i <= MaterialTable::MIN_PAGE_LAYERS; i++) {
+			table.getMaterial({ i, 0, 0 }, resolve);
+		}
+		SFE_CHECK(table.getPages()[0].capacity == MaterialTable::MIN_PAGE_LAYERS);
+
+		table.getMaterial({ MaterialTable::MIN_PAGE_LAYERS + 1, 0, 0 }, resolve);
+		SFE_CHECK(table.getPages()[0].capacity == MaterialTable::MIN_PAGE_LAYERS * 2);
+
+		//ids are different for every material, only keys matter for packing
+		MaterialTable full;
+		for (uint32_t i = 0; i <= MaterialTable::MAX_PAGE_LAYERS; i++) {
+			full.getMaterial({ 1000 + i, 0, 0 }, [](uint32_t) -> std::optional<TextureArrayKey> { return RGBA_512; });
+		}
+		const auto& pages = full.getPages();
+		SFE_CHECK(pages.size() == 2);
+		SFE_CHECK(pages[0].capacity == MaterialTable::MAX_PAGE_LAYERS);
+		SFE_CHECK(pages[0].textures.size() == MaterialTable::MAX_PAGE_LAYERS);
+		SFE_CHECK(pages[1].textures.size() == 1);
+		SFE_CHECK(pages[1].key == RGBA_512);
+	}
+
+	void notLoadedTexturesArePending() {
+		MaterialTable table;
+		const auto material = table.getMaterial({ 1, 2, 0 }, notLoaded);
+		SFE_CHECK(table.hasPending());
+		SFE_CHECK(table.getRows()[material].layers[MaterialTable::DIFFUSE_TEXTURE] == -1);
+		SFE_CHECK(!table.resolvePending(notLoaded));
+		SFE_CHECK(table.hasPending());
+
+		SFE_CHECK(table.resolvePending(resolve));
+		SFE_CHECK(!table.hasPending());
+		SFE_CHECK(table.getRows()[material].layers[MaterialTable::DIFFUSE_TEXTURE] == 0);
+		SFE_CHECK(table.getRows()[material].layers[MaterialTable::NORMAL_TEXTURE] == 1);
+		SFE_CHECK(!table.resolvePending(resolve));
+	}
+
+	void rowsMatchStd430Layout() {
+		MaterialTable table;
+		table.getMaterial({ 1, 200, 2 }, resolve);
+		const auto& rows = table.getRows();
+
+		//shader reads ivec4 per material, the last component is padding
+		SFE_CHECK(sizeof(GpuMaterial) == 4 * sizeof(int32_t));
+		SFE_CHECK(alignof(GpuMaterial) == sizeof(int32_t));
+		SFE_CHECK(rows[1].layers[0] == 0);
+		SFE_CHECK(rows[1].layers[1] == 0);
+		SFE_CHECK(rows[1].layers[2] == 1);
+		SFE_CHECK(rows[1].padding == 0);
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "defaultMaterialIsFirstRow", defaultMaterialIsFirstRow },
+		{ "equalTexturesShareRow", equalTexturesShareRow },
+		{ "rowKeepsLayerAndPageOfSlots", rowKeepsLayerAndPageOfSlots },
+		{ "texturesArePackedByKey", texturesArePackedByKey },
+		{ "pageGrowsUpToMaxLayers", pageGrowsUpToMaxLayers },
+		{ "notLoadedTexturesArePending", notLoadedTexturesArePending },
+		{ "rowsMatchStd430Layout", rowsMatchStd430Layout },
+	});
+}
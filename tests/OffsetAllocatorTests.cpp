@@ -0,0 +1,232 @@
+﻿#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "containersModule/OffsetAllocator.h"
+
+using namespace SFE;
+
+namespace {
+	//allocations don't overlap, stay inside capacity and used space matches their sum
+	void checkConsistency(const OffsetAllocator& allocator, const std::map<uint32_t, uint32_t>& allocations) {
+		uint32_t used = 0;
+		uint32_t end = 0;
+		for (const auto& [offset, size] : allocations) {
+			SFE_CHECK(offset >= end);
+			SFE_CHECK(allocator.getAllocationSize(offset) == size);
+			end = offset + size;
+			used += size;
+		}
+
+		SFE_CHECK(end <= allocator.getCapacity());
+		SFE_CHECK(allocator.getUsed() == used);
+		SFE_CHECK(allocator.getAllocationsCount() == allocations.size());
+		SFE_CHECK(allocator.getLargestFreeBlock() <= allocator.getFree());
+	}
+
+	void allocateAndFree() {
+		OffsetAllocator allocator(100);
+		SFE_CHECK(allocator.getFree() == 100);
+		SFE_CHECK(allocator.allocate(0) == OffsetAllocator::INVALID_OFFSET);
+
+		const auto a = allocator.allocate(10);
+		const auto b = allocator.allocate(20);
+		const auto c = allocator.allocate(30);
+		SFE_CHECK(a == 0);
+		SFE_CHECK(b == 10);
+		SFE_CHECK(c == 30);
+		SFE_CHECK(allocator.getUsed() == 60);
+		SFE_CHECK(allocator.getAllocationSize(b) == 20);
+		SFE_CHECK(allocator.getAllocationSize(5) == 0);
+
+		allocator.free(b);
+		SFE_CHECK(allocator.getUsed() == 40);
+		SFE_CHECK(allocator.getAllocationsCount() == 2);
+
+		//freed range is reused
+		SFE_CHECK(allocator.allocate(20) == 10);
+	}
+
+	void coalescing() {
+		OffsetAllocator allocator(40);
+		const auto a = allocator.allocate(10);
+		const auto b = allocator.allocate(10);
+		const auto c = allocator.allocate(10);
+		const auto d = allocator.allocate(10);
+		SFE_CHECK(allocator.getFree() == 0);
+		SFE_CHECK(allocator.getFreeBlocksCount() == 0);
+
+		allocator.free(a);
+		allocator.free(c);
+		SFE_CHECK(allocator.getFreeBlocksCount() == 2);
+		SFE_CHECK(allocator.getLargestFreeBlock() == 10);
+
+		//merged with both neighbours
+		allocator.free(b);
+		SFE_CHECK(allocator.getFreeBlocksCount() == 1);
+		SFE_CHECK(allocator.getLargestFreeBlock() == 30);
+
+		allocator.free(d);
+		SFE_CHECK(allocator.getFreeBlocksCount() == 1);
+		SFE_CHECK(allocator.getLargestFreeBlock() == 40);
+		SFE_CHECK(allocator.getUsed() == 0);
+		SFE_CHECK(allocator.allocate(40) == 0);
+	}
+
+	void bestFit() {
+		OffsetAllocator allocator(100);
+		const auto a = allocator.allocate(30);
+		allocator.allocate(5);
+		const auto b = allocator.allocate(10);
+		allocator.allocate(5);
+		//free blocks: [0, 30), [35, 45), [50, 100)
+		allocator.free(a);
+		allocator.free(b);
+
+		SFE_CHECK(allocator.allocate(8) == 35);
+		SFE_CHECK(allocator.allocate(25) == 0);
+		SFE_CHECK(allocator.allocate(50) == 50);
+	}
+
+	void fragmentation() {
+		OffsetAllocator allocator(100);
+		SFE_CHECK(allocator.getFragmentation() == 0.f);
+
+		std::vector<uint32_t> offsets;
+		for (int i = 0; i < 10; i++) {
+			offsets.push_back(allocator.allocate(10));
+		}
+		SFE_CHECK(allocator.getFragmentation() == 0.f); //nothing free
+
+		for (size_t i = 0; i < offsets.size(); i += 2) {
+			allocator.free(offsets[i]);
+		}
+		//50 free in five blocks of 10
+		SFE_CHECK(allocator.getFree() == 50);
+		SFE_CHECK(allocator.getLargestFreeBlock() == 10);
+		SFE_CHECK(allocator.getFragmentation() > 0.79f && allocator.getFragmentation() < 0.81f);
+
+		//enough free space in total, but no block fits
+		SFE_CHECK(allocator.allocate(20) == OffsetAllocator::INVALID_OFFSET);
+
+		const auto moves = allocator.defragment();
+		SFE_CHECK(moves.size() == 5);
+		for (const auto& move : moves) {
+			SFE_CHECK(move.to < move.from);
+			SFE_CHECK(move.size == 10);
+		}
+		for (size_t i = 1; i < moves.size(); i++) {
+			SFE_CHECK(moves[i - 1].from < moves[i].from);
+		}
+		SFE_CHECK(allocator.getFragmentation() == 0.f);
+		SFE_CHECK(allocator.getLargestFreeBlock() == 50);
+		SFE_CHECK(allocator.allocate(50) == 50);
+	}
+
+	void outOfSpace() {
+		OffsetAllocator empty;
+		SFE_CHECK(empty.allocate(1) == OffsetAllocator::INVALID_OFFSET);
+
+		OffsetAllocator allocator(64);
+		SFE_CHECK(allocator.allocate(65) == OffsetAllocator::INVALID_OFFSET);
+		SFE_CHECK(allocator.allocate(64) == 0);
+		SFE_CHECK(allocator.allocate(1) == OffsetAllocator::INVALID_OFFSET);
+		SFE_CHECK(allocator.getUsed() == 64);
+
+		//grown space is merged with free tail
+		OffsetAllocator growing(32);
+		const auto a = growing.allocate(16);
+		growing.grow(64);
+		SFE_CHECK(growing.getCapacity() == 64);
+		SFE_CHECK(growing.getFreeBlocksCount() == 1);
+		SFE_CHECK(growing.allocate(48) == 16);
+		growing.free(a);
+		growing.grow(32); //never shrinks
+		SFE_CHECK(growing.getCapacity() == 64);
+	}
+
+	//arena takes vertices and indices from two allocators of one page and rolls back vertices when indices don't fit
+	void pairedRollback() {
+		OffsetAllocator vertices(100);
+		OffsetAllocator indices(10);
+
+		const auto vertex = vertices.allocate(40);
+		const auto index = indices.allocate(20);
+		SFE_CHECK(vertex != OffsetAllocator::INVALID_OFFSET);
+		SFE_CHECK(index == OffsetAllocator::INVALID_OFFSET);
+		vertices.free(vertex);
+
+		SFE_CHECK(vertices.getUsed() == 0);
+		SFE_CHECK(vertices.getFreeBlocksCount() == 1);
+		SFE_CHECK(vertices.getLargestFreeBlock() == 100);
+	}
+
+	void randomAgainstModel() {
+		std::mt19937 random(42);
+		std::uniform_int_distribution<uint32_t> size(1, 64);
+		std::uniform_int_distribution<int> action(0, 2);
+
+		OffsetAllocator allocator(4096);
+		std::map<uint32_t, uint32_t> allocations;
+		for (int step = 0; step < 5000; step++) {
+			if (action(random) < 2 || allocations.empty()) {
+				const auto request = size(random);
+				const auto offset = allocator.allocate(request);
+				if (offset == OffsetAllocator::INVALID_OFFSET) {
+					SFE_CHECK(allocator.getLargestFreeBlock() < request);
+				}
+				else {
+					allocations.emplace(offset, request);
+				}
+			}
+			else {
+				auto it = allocations.begin();
+				std::advance(it, std::uniform_int_distribution<size_t>(0, allocations.size() - 1)(random));
+				allocator.free(it->first);
+				allocations.erase(it);
+			}
+
+			if (step % 500 == 0) {
+				checkConsistency(allocator, allocations);
+			}
+		}
+
+		checkConsistency(allocator, allocations);
+
+		//moved allocations keep their order and sizes
+		const auto moves = allocator.defragment();
+		for (const auto& move : moves) {
+			SFE_CHECK(move.to < move.from);
+			SFE_CHECK(allocations.contains(move.from));
+		}
+
+		std::map<uint32_t, uint32_t> moved;
+		uint32_t offset = 0;
+		for (const auto& [from, size] : allocations) {
+			moved.emplace(offset, size);
+			offset += size;
+		}
+		checkConsistency(allocator, moved);
+		SFE_CHECK(allocator.getFreeBlocksCount() == (offset < allocator.getCapacity() ? 1u : 0u));
+
+		for (const auto& [from, size] : moved) {
+			allocator.free(from);
+		}
+		SFE_CHECK(allocator.getUsed() == 0);
+		SFE_CHECK(allocator.getLargestFreeBlock() == allocator.getCapacity());
+	}
+}
+
+int main() {
+	return Tests::run({
+		{ "allocate and free", allocateAndFree },
+		{ "coalescing", coalescing },
+		{ "best fit", bestFit },
+		{ "fragmentation", fragmentation },
+		{ "out of space", outOfSpace },
+		{ "paired rollback", pairedRollback },
+		{ "random against model", randomAgainstModel },
+	});
+}
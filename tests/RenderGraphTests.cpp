@@ -0,0 +1,223 @@
+﻿#include <string>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "renderModule/RenderGraph.h"
+
+using namespace SFE::Render;
+
+namespace {
+	using Access = RenderGraph::Access;
+
+	const RenderGraph::TextureDesc COLOR{ 1920, 1080, 1, 4 };
+	const RenderGraph::TextureDesc DEPTH{ 1920, 1080, 2, 4 };
+	const RenderGraph::TextureDesc HALF{ 960, 540, 1, 4 };
+
+	std::vector<std::string> getOrder(const RenderGraph& graph) {
+		std::vector<std::string> names;
+		for (const auto& compiled : graph.getOrder()) {
+			names.push_back(graph.getPassName(compiled.pass));
+		}
+		return names;
+	}
+
+	uint32_t getBarriers(const RenderGraph& graph, const std::string& name) {
+		for (const auto& compiled : graph.getOrder()) {
+			if (graph.getPassName(compiled.pass) == name) {
+				return compiled.barriers;
+			}
+		}
+		return RenderGraph::NO_BARRIER;
+	}
+
+	void readersGoAfterWriters() {
+		RenderGraph graph;
+		const auto backbuffer = graph.importResource("backbuffer", RenderGraph::ResourceType::TEXTURE, true);
+		const auto gbuffer = graph.createTexture("gbuffer", COLOR);
+		const auto lighting = graph.createTexture("lighting", COLOR);
+
+		//added in reverse order of dependencies
+		graph.addPass("present", {}).read(lighting).write(backbuffer);
+		graph.addPass("lighting", {}).read(gbuffer).write(lighting);
+		graph.addPass("geometry", {}).write(gbuffer);
+
+		SFE_CHECK(graph.compile());
+		SFE_CHECK(graph.isCompiled());
+		SFE_CHECK((getOrder(graph) == std::vector<std::string>{ "geometry", "lighting", "present" }));
+	}
+
+	void writersKeepOrder() {
+		RenderGraph graph;
+		const auto backbuffer = graph.importResource("backbuffer", RenderGraph::ResourceType::TEXTURE, true);
+		const auto color = graph.createTexture("color", COLOR);
+
+		//both write color, reader sees result of the last one
+		graph.addPass("opaque", {}).write(color);
+		graph.addPass("present", {}).read(color).write(backbuffer);
+		graph.addPass("transparent", {}).read(color).write(color);
+		//independent pass keeps its place among ready ones
+		graph.addPass("ui", {}).write(backbuffer);
+
+		SFE_CHECK(graph.compile());
+		SFE_CHECK((getOrder(graph) == std::vector<std::string>{ "opaque", "transparent", "present", "ui" }));
+	}
+
+	void unusedPassesAreCulled() {
+		RenderGraph graph;
+		const auto backbuffer = graph.importResource("backbuffer", RenderGraph::ResourceType::TEXTURE, true);
+		const auto debug = graph.createTexture("debug", COLOR);
+		const auto color = graph.createTexture("color", COLOR);
+		const auto stats = graph.importResource("stats", RenderGraph::ResourceType::BUFFER);
+
+		const auto debugPass = graph.addPass("debug", {}).write(debug).getId();
+		const auto debugBlur = graph.addPass("debug blur", {}).read(debug).write(debug).getId();
+		graph.addPass("scene", {}).write(color);
+		graph.addPass("present", {}).read(color).write(backbuffer);
+		//writes buffer nobody reads, but changes something outside of graph
+		const auto query = graph.addPass("query", {}).write(stats, Access::STORAGE).sideEffect().getId();
+		//optional resource which wasn't created is ignored
+		graph.addPass("optional", {}).read(RenderGraph::INVALID_RESOURCE).write(backbuffer);
+
+		SFE_CHECK(graph.compile());
+		SFE_CHECK(graph.isCulled(debugPass));
+		SFE_CHECK(graph.isCulled(debugBlur));
+		SFE_CHECK(!graph.isCulled(query));
+		SFE_CHECK((getOrder(graph) == std::vector<std::string>{ "scene", "present", "query", "optional" }));
+		SFE_CHECK(graph.getStats().passes == 6);
+		SFE_CHECK(graph.getStats().culledPasses == 2);
+
+		//texture of culled passes doesn't get memory
+		SFE_CHECK(graph.getPhysicalIndex(debug) == RenderGraph::INVALID_PHYSICAL);
+		SFE_CHECK(graph.getPhysicalIndex(color) != RenderGraph::INVALID_PHYSICAL);
+	}
+
+	void disjointTexturesAreAliased() {
+		RenderGraph graph;
+		const auto backbuffer = graph.importResource("backbuffer", RenderGraph::ResourceType::TEXTURE, true);
+		const auto depth = graph.createTexture("depth", DEPTH);
+		const auto a = graph.createTexture("a", COLOR);
+		const auto b = graph.createTexture("b", COLOR);
+		const auto c = graph.createTexture("c", COLOR);
+		const auto half = graph.createTexture("half", HALF);
+
+		graph.addPass("depth", {}).write(depth);
+		graph.addPass("a", {}).read(depth).write(a);
+		graph.addPass("b", {}).read(a).write(b);
+		//a is dead here, so c can take its memory, half has other desc
+		graph.addPass("c", {}).read(b).write(c);
+		graph.addPass("half", {}).read(c).write(half);
+		graph.addPass("present", {}).read(half).read(depth).write(backbuffer);
+
+		SFE_CHECK(graph.compile());
+		SFE_CHECK(graph.getPhysicalIndex(backbuffer) == RenderGraph::INVALID_PHYSICAL);
+		SFE_CHECK(graph.getPhysicalIndex(a) == graph.getPhysicalIndex(c));
+		SFE_CHECK(graph.getPhysicalIndex(a) != graph.getPhysicalIndex(b));
+		SFE_CHECK(graph.getPhysicalIndex(depth) != graph.getPhysicalIndex(a));
+		SFE_CHECK(graph.getPhysicalIndex(half) != graph.getPhysicalIndex(a) && graph.getPhysicalIndex(half) != graph.getPhysicalIndex(b));
+
+		const auto& stats = graph.getStats();
+		SFE_CHECK(stats.transientTextures == 5);
+		SFE_CHECK(stats.physicalTextures == 4);
+		SFE_CHECK(graph.getPhysicalTextures().size() == 4);
+		SFE_CHECK(stats.transientBytes == DEPTH.getBytes() + 3 * COLOR.getBytes() + HALF.getBytes());
+		SFE_CHECK(stats.physicalBytes == DEPTH.getBytes() + 2 * COLOR.getBytes() + HALF.getBytes());
+	}
+
+	void storageWritesNeedBarriers() {
+		RenderGraph graph;
+		const auto backbuffer = graph.importResource("backbuffer", RenderGraph::ResourceType::TEXTURE, true);
+		const auto commands = graph.importResource("commands", RenderGraph::ResourceType::BUFFER);
+		const auto visibility = graph.importResource("visibility", RenderGraph::ResourceType::BUFFER);
+		const auto ao = graph.createTexture("ao", HALF);
+		const auto color = graph.createTexture("color", COLOR);
+
+		graph.addPass("cull", {}).write(commands, Access::STORAGE).write(visibility, Access::STORAGE);
+		graph.addPass("draw", {}).read(commands, Access::INDIRECT).read(visibility).write(color);
+		graph.addPass("ao", {}).write(ao, Access::STORAGE);
+		graph.addPass("compose", {}).read(ao).read(color).write(backbuffer);
+		//attachment write isn't waited by barrier
+		graph.addPass("present", {}).read(color, Access::SAMPLED).write(backbuffer);
+
+		SFE_CHECK(graph.compile());
+		SFE_CHECK(getBarriers(graph, "cull") == RenderGraph::NO_BARRIER);
+		SFE_CHECK(getBarriers(graph, "draw") == (RenderGraph::COMMAND_BARRIER | RenderGraph::STORAGE_BUFFER_BARRIER));
+		SFE_CHECK(getBarriers(graph, "ao") == RenderGraph::NO_BARRIER);
+		SFE_CHECK(getBarriers(graph, "compose") == RenderGraph::TEXTURE_FETCH_BARRIER);
+		SFE_CHECK(getBarriers(graph, "present") == RenderGraph::NO_BARRIER);
+		SFE_CHECK(graph.getStats().barriers == 2);
+	}
+
+	void aliasedTextureWaitsPreviousOwner() {
+		RenderGraph graph;
+		const auto backbuffer = graph.importResource("backbuffer", RenderGraph::ResourceType::TEXTURE, true);
+		const auto first = graph.createTexture("first", COLOR);
+		const auto middle = graph.createTexture("middle", COLOR);
+		const auto second = graph.createTexture("second", COLOR);
+
+		graph.addPass("first", {}).write(first, Access::STORAGE);
+		graph.addPass("middle", {}).read(first, Access::STORAGE).write(middle);
+		//second takes memory of first which was written as image
+		graph.addPass("second", {}).read(middle).write(second);
+		graph.addPass("present", {}).read(second).write(backbuffer);
+
+		SFE_CHECK(graph.compile());
+		SFE_CHECK(graph.getPhysicalIndex(first) == graph.getPhysicalIndex(second));
+		SFE_CHECK(getBarriers(graph, "middle") == RenderGraph::IMAGE_ACCESS_BARRIER);
+		SFE_CHECK(getBarriers(graph, "second") == RenderGraph::FRAMEBUFFER_BARRIER);
+	}
+
+	void cycleIsReported() {
+		RenderGraph graph;
+		const auto x = graph.importResource("x");
+		const auto y = graph.importResource("y");
+		graph.addPass("ok", {}).sideEffect();
+		graph.addPass("first", {}).read(y).write(x).sideEffect();
+		graph.addPass("second", {}).read(x).write(y).sideEffect();
+
+		SFE_CHECK(!graph.compile());
+		SFE_CHECK(!graph.isCompiled());
+		SFE_CHECK(graph.getOrder().empty());
+		const auto& error = graph.getError();
+		SFE_CHECK(error.find("first") != std::string::npos);
+		SFE_CHECK(error.find("second") != std::string::npos);
+		SFE_CHECK(error.find("ok") == std::string::npos);
+	}
+
+	void recompileAfterChanges() {
+		RenderGraph graph;
+		const auto backbuffer = graph.importResource("backbuffer", RenderGraph::ResourceType::TEXTURE, true);
+		SFE_CHECK(graph.importResource("backbuffer") == backbuffer);
+		SFE_CHECK(graph.findResource("backbuffer") == backbuffer);
+		SFE_CHECK(graph.findResource("missing") == RenderGraph::INVALID_RESOURCE);
+
+		int executed = 0;
+		const auto pass = graph.addPass("present", [&executed] { executed++; }).write(backbuffer).getId();
+		SFE_CHECK(graph.compile());
+
+		graph.addPass("late", {}).write(backbuffer);
+		SFE_CHECK(!graph.isCompiled());
+		SFE_CHECK(graph.compile());
+		SFE_CHECK(graph.getOrder().size() == 2);
+
+		graph.executePass(pass);
+		SFE_CHECK(executed == 1);
+
+		graph.clear();
+		SFE_CHECK(graph.getPassesCount() == 0 && graph.getResourcesCount() == 0);
+		SFE_CHECK(graph.compile());
+		SFE_CHECK(graph.getOrder().empty());
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "readers go after writers", readersGoAfterWriters },
+		{ "writers keep order", writersKeepOrder },
+		{ "unused passes are culled", unusedPassesAreCulled },
+		{ "disjoint textures are aliased", disjointTexturesAreAliased },
+		{ "storage writes need barriers", storageWritesNeedBarriers },
+		{ "aliased texture waits previous owner", aliasedTextureWaitsPreviousOwner },
+		{ "cycle is reported", cycleIsReported },
+		{ "recompile after changes", recompileAfterChanges },
+	});
+}
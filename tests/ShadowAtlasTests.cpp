@@ -0,0 +1,276 @@
+﻿#include <cmath>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "renderModule/PointShadowScheduler.h"
+#include "renderModule/ShadowAtlas.h"
+
+using namespace SFE::Render;
+
+namespace {
+	using Scheduler = PointShadowScheduler;
+
+	const Scheduler::View VIEW{ {}, 1.f, 1000.f };
+
+	float getDistance(float screenSize) {
+		return std::sqrt(1.f + (VIEW.screenHeight / screenSize) * (VIEW.screenHeight / screenSize));
+	}
+
+	//light of radius 1 which takes this count of pixels on screen
+	Scheduler::Light lightOfSize(uint32_t id, float screenSize, bool castersChanged = false) {
+		return { id, { getDistance(screenSize), 0.f, 0.f }, 1.f, castersChanged };
+	}
+
+	//the same for light in the center, only camera moves
+	Scheduler::View viewOfSize(float screenSize) {
+		auto view = VIEW;
+		view.position = { getDistance(screenSize), 0.f, 0.f };
+		return view;
+	}
+
+	Scheduler::Settings makeSettings() {
+		Scheduler::Settings settings;
+		settings.pageSize = 1024;
+		settings.pagesCount = 2;
+		settings.minResolution = 128;
+		settings.maxResolution = 512;
+		settings.maxShadowedLights = 4;
+		settings.facesBudget = 12;
+		settings.evictFrames = 10;
+		return settings;
+	}
+
+	const Scheduler::Shadow* findShadow(const Scheduler& scheduler, uint32_t id) {
+		for (const auto& shadow : scheduler.getShadows()) {
+			if (shadow.id == id) {
+				return &shadow;
+			}
+		}
+		return nullptr;
+	}
+
+	size_t countUpdates(const std::vector<Scheduler::FaceUpdate>& updates, uint32_t id) {
+		size_t count = 0;
+		for (const auto& update : updates) {
+			count += update.id == id;
+		}
+		return count;
+	}
+
+	void atlasSplitsTiles() {
+		ShadowAtlas atlas(1024, 1, 64);
+		const auto first = atlas.allocate(512);
+		SFE_CHECK((first == ShadowAtlas::Tile{ 0, 0, 0, 512 }));
+
+		//page is split as quadtree, tiles are taken in order of position
+		const auto second = atlas.allocate(512);
+		SFE_CHECK((second == ShadowAtlas::Tile{ 0, 512, 0, 512 }));
+
+		//size is rounded up to power of two and to min tile
+		const auto rounded = atlas.allocate(300);
+		SFE_CHECK(rounded.size == 512 && rounded.x == 0 && rounded.y == 512);
+		const auto small = atlas.allocate(10);
+		SFE_CHECK((small == ShadowAtlas::Tile{ 0, 512, 512, 64 }));
+
+		SFE_CHECK(atlas.getTilesCount() == 4);
+		SFE_CHECK(atlas.getUsedTexels() == 3ull * 512 * 512 + 64 * 64);
+		SFE_CHECK(atlas.getLargestFreeTile() == 256);
+		SFE_CHECK(!atlas.allocate(2048).isValid());
+	}
+
+	void atlasMergesFreeTiles() {
+		ShadowAtlas atlas(1024, 1, 64);
+		std::vector<ShadowAtlas::Tile> tiles;
+		for (int i = 0; i < 16; i++) {
+			tiles.push_back(atlas.allocate(256));
+		}
+		SFE_CHECK(!atlas.allocate(256).isValid());
+		SFE_CHECK(atlas.getLargestFreeTile() == 0);
+
+		//three of four neighbours are free, so they can't be merged yet
+		atlas.free(tiles[0]);
+		atlas.free(tiles[1]);
+		atlas.free(tiles[2]);
+		SFE_CHECK(atlas.getLargestFreeTile() == 256);
+		SFE_CHECK(!atlas.allocate(512).isValid());
+
+		//the whole first quarter is free now
+		const auto neighbour = tiles[3];
+		SFE_CHECK(neighbour.x == 256 && neighbour.y == 256);
+		atlas.free(neighbour);
+		SFE_CHECK(atlas.getLargestFreeTile() == 512);
+		const auto merged = atlas.allocate(512);
+		SFE_CHECK((merged == ShadowAtlas::Tile{ 0, 0, 0, 512 }));
+		atlas.free(merged);
+
+		//tiles merge back up to the whole page in any order of freeing
+		for (int i = 15; i >= 0; i--) {
+			if (i > 3) {
+				atlas.free(tiles[i]);
+			}
+		}
+		SFE_CHECK(atlas.getTilesCount() == 0);
+		SFE_CHECK(atlas.getUsedTexels() == 0);
+		SFE_CHECK(atlas.getLargestFreeTile() == 1024);
+		SFE_CHECK(atlas.allocate(1024).isValid());
+	}
+
+	void atlasUsesNextPages() {
+		ShadowAtlas atlas(256, 2, 256);
+		const auto first = atlas.allocate(1);
+		const auto second = atlas.allocate(256);
+		SFE_CHECK(first.page == 0 && first.size == 256);
+		SFE_CHECK(second.page == 1);
+		SFE_CHECK(!atlas.allocate(16).isValid());
+		SFE_CHECK(atlas.getCapacityTexels() == 2ull * 256 * 256);
+
+		atlas.free(first);
+		SFE_CHECK(atlas.allocate(256).page == 0);
+
+		atlas.reset(512, 1, 128);
+		SFE_CHECK(atlas.getTilesCount() == 0 && atlas.getLargestFreeTile() == 512);
+	}
+
+	void budgetGoesByPriority() {
+		Scheduler scheduler;
+		auto settings = makeSettings();
+		settings.facesBudget = 6;
+		scheduler.setSettings(settings);
+
+		const std::vector<Scheduler::Light> lights = { lightOfSize(1, 100.f), lightOfSize(2, 350.f) };
+
+		//the biggest light on screen takes budget first
+		const auto& first = scheduler.update(VIEW, lights);
+		SFE_CHECK(first.size() == 6);
+		SFE_CHECK(countUpdates(first, 2) == 6);
+		SFE_CHECK(findShadow(scheduler, 2) && !findShadow(scheduler, 1));
+		SFE_CHECK(scheduler.getStats().pendingFaces == 6);
+
+		//light without content waits, the other one is cached
+		const auto& second = scheduler.update(VIEW, lights);
+		SFE_CHECK(countUpdates(second, 1) == 6);
+		SFE_CHECK(scheduler.getStats().cachedLights == 1);
+		SFE_CHECK(scheduler.getStats().readyLights == 2);
+
+		//both lights are dirty, but faces without any content go first
+		const std::vector<Scheduler::Light> changed = { lightOfSize(1, 100.f, true), lightOfSize(2, 350.f, true), lightOfSize(3, 50.f) };
+		const auto& third = scheduler.update(VIEW, changed);
+		SFE_CHECK(countUpdates(third, 3) == 6);
+		SFE_CHECK(scheduler.getStats().pendingFaces == 12);
+
+		//casters of both lights change every frame, priority of waiting faces grows, so smaller light isn't starved
+		SFE_CHECK(countUpdates(scheduler.update(VIEW, changed), 2) == 6);
+		SFE_CHECK(countUpdates(scheduler.update(VIEW, changed), 2) == 6);
+		SFE_CHECK(countUpdates(scheduler.update(VIEW, changed), 1) == 6);
+
+		const auto& calm = scheduler.update(VIEW, lights);
+		SFE_CHECK(countUpdates(calm, 2) == 6);
+		SFE_CHECK(scheduler.getStats().pendingFaces == 0);
+		SFE_CHECK(scheduler.update(VIEW, lights).empty());
+	}
+
+	void shadowedLightsLimit() {
+		Scheduler scheduler;
+		auto settings = makeSettings();
+		settings.maxShadowedLights = 2;
+		scheduler.setSettings(settings);
+
+		scheduler.update(VIEW, { lightOfSize(1, 100.f), lightOfSize(2, 300.f), lightOfSize(3, 200.f) });
+		SFE_CHECK(scheduler.getStats().shadowedLights == 2);
+		//sorted by importance
+		SFE_CHECK(scheduler.getShadows().size() == 2);
+		SFE_CHECK(scheduler.getShadows()[0].id == 2 && scheduler.getShadows()[1].id == 3);
+	}
+
+	void resolutionHysteresis() {
+		Scheduler scheduler;
+		scheduler.setSettings(makeSettings());
+
+		const std::vector<Scheduler::Light> light = { { 1, {}, 1.f } };
+		scheduler.update(viewOfSize(200.f), light);
+		SFE_CHECK(findShadow(scheduler, 1) && findShadow(scheduler, 1)->resolution == 256);
+		SFE_CHECK(scheduler.getStats().reallocations == 1);
+
+		//smaller, but not by margin, tiles are kept and faces aren't dirty
+		const auto& kept = scheduler.update(viewOfSize(120.f), light);
+		SFE_CHECK(kept.empty());
+		SFE_CHECK(scheduler.getStats().reallocations == 0);
+		SFE_CHECK(scheduler.getStats().cachedLights == 1);
+		SFE_CHECK(findShadow(scheduler, 1)->resolution == 256);
+
+		const auto& smaller = scheduler.update(viewOfSize(90.f), light);
+		SFE_CHECK(scheduler.getStats().reallocations == 1);
+		SFE_CHECK(smaller.size() == 6 && smaller[0].tile.size == 128);
+
+		//bigger tiles are taken at once, resolution is clamped by max
+		scheduler.update(viewOfSize(150.f), light);
+		SFE_CHECK(scheduler.getStats().reallocations == 1);
+		scheduler.update(viewOfSize(5000.f), light);
+		SFE_CHECK(findShadow(scheduler, 1) && findShadow(scheduler, 1)->resolution == 512);
+		SFE_CHECK(scheduler.getAtlas().getUsedTexels() == 6ull * 512 * 512);
+	}
+
+	void fullAtlasEvictsUnused() {
+		Scheduler scheduler;
+		scheduler.setSettings(makeSettings());
+
+		//six faces of 512 take one and half of two pages
+		scheduler.update(VIEW, { lightOfSize(1, 400.f) });
+		SFE_CHECK(scheduler.getAtlas().getUsedTexels() == 6ull * 512 * 512);
+
+		//atlas is full for the second light, it takes smaller tiles while the first one is shadowed
+		scheduler.update(VIEW, { lightOfSize(1, 400.f), lightOfSize(2, 399.f) });
+		SFE_CHECK(scheduler.getStats().shadowedLights == 2);
+		SFE_CHECK(findShadow(scheduler, 1) && findShadow(scheduler, 1)->resolution == 512);
+		SFE_CHECK(findShadow(scheduler, 2) && findShadow(scheduler, 2)->resolution == 256);
+
+		//light which isn't shadowed anymore gives its tiles to light which needs them
+		scheduler.update(VIEW, { lightOfSize(3, 400.f) });
+		SFE_CHECK(scheduler.getStats().shadowedLights == 1);
+		SFE_CHECK(scheduler.getAtlas().getUsedTexels() <= scheduler.getAtlas().getCapacityTexels());
+		const auto& updates = scheduler.update(VIEW, { lightOfSize(3, 400.f) });
+		SFE_CHECK(updates.empty());
+		SFE_CHECK(findShadow(scheduler, 3) && findShadow(scheduler, 3)->resolution == 512);
+	}
+
+	void lightsAreEvicted() {
+		Scheduler scheduler;
+		scheduler.setSettings(makeSettings());
+
+		scheduler.update(VIEW, { lightOfSize(1, 200.f) });
+		SFE_CHECK(scheduler.isKnown(1));
+		SFE_CHECK(scheduler.getAtlas().getTilesCount() == 6);
+
+		//light which is away comes back dirty
+		scheduler.update(VIEW, {});
+		SFE_CHECK(scheduler.getAtlas().getTilesCount() == 6);
+		SFE_CHECK(scheduler.update(VIEW, { lightOfSize(1, 200.f) }).size() == 6);
+
+		for (int i = 0; i < 11; i++) {
+			scheduler.update(VIEW, {});
+		}
+		SFE_CHECK(!scheduler.isKnown(1));
+		SFE_CHECK(scheduler.getAtlas().getTilesCount() == 0);
+
+		//new layout drops all lights
+		scheduler.update(VIEW, { lightOfSize(1, 200.f) });
+		auto settings = makeSettings();
+		settings.pagesCount = 1;
+		scheduler.setSettings(settings);
+		SFE_CHECK(!scheduler.isKnown(1));
+		SFE_CHECK(scheduler.getAtlas().getTilesCount() == 0);
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "atlas splits tiles", atlasSplitsTiles },
+		{ "atlas merges free tiles", atlasMergesFreeTiles },
+		{ "atlas uses next pages", atlasUsesNextPages },
+		{ "budget goes by priority", budgetGoesByPriority },
+		{ "shadowed lights limit", shadowedLightsLimit },
+		{ "resolution hysteresis", resolutionHysteresis },
+		{ "full atlas evicts unused", fullAtlasEvictsUnused },
+		{ "lights are evicted", lightsAreEvicted },
+	});
+}
@@ -0,0 +1,145 @@
+﻿#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "mathModule/Forward.h"
+#include "mathModule/Utils.h"
+#include "renderModule/SoftwareOcclusion.h"
+
+using namespace SFE;
+
+namespace {
+	using AABB = FrustumModule::AABB;
+
+	//camera in origin looking to -z
+	Math::Mat4 cameraProjection() {
+		return Math::perspectiveRH_NO(Math::radians(60.f), 1.5f, 0.1f, 100.f);
+	}
+
+	//wall in front of camera which covers the center of screen
+	Render::SoftwareOcclusion makeOcclusion(const Render::SoftwareOcclusion::ParallelFor& parallelFor = {}) {
+		Render::SoftwareOcclusion occlusion(256, 144);
+		occlusion.beginFrame(cameraProjection());
+		occlusion.addOccluder(AABB({ -5.f, -5.f, -10.5f }, { 5.f, 5.f, -9.5f }));
+		occlusion.rasterize(parallelFor);
+		return occlusion;
+	}
+
+	void sizeIsRoundedToTiles() {
+		Render::SoftwareOcclusion occlusion(100, 50);
+		SFE_CHECK(occlusion.getWidth() == 128);
+		SFE_CHECK(occlusion.getHeight() == 64);
+		SFE_CHECK(occlusion.getDepth().size() == 128 * 64);
+
+		occlusion.resize(1, 1);
+		SFE_CHECK(occlusion.getWidth() == Render::SoftwareOcclusion::TILE_WIDTH);
+		SFE_CHECK(occlusion.getHeight() == Render::SoftwareOcclusion::TILE_HEIGHT);
+		SFE_CHECK(occlusion.getHiZ(occlusion.getHiZLevelsCount() - 1).size() == 1);
+	}
+
+	void boxBehindOccluderIsHidden() {
+		const auto occlusion = makeOcclusion();
+		SFE_CHECK(occlusion.getTrianglesCount() == 12);
+
+		SFE_CHECK(occlusion.isOccluded(AABB({ -1.f, -1.f, -31.f }, { 1.f, 1.f, -29.f })));
+		//in front of occluder
+		SFE_CHECK(!occlusion.isOccluded(AABB({ -1.f, -1.f, -6.f }, { 1.f, 1.f, -4.f })));
+		//behind, but seen beside occluder
+		SFE_CHECK(!occlusion.isOccluded(AABB({ 20.f, -1.f, -31.f }, { 24.f, 1.f, -29.f })));
+		//partially covered
+		SFE_CHECK(!occlusion.isOccluded(AABB({ 2.f, -1.f, -21.f }, { 20.f, 1.f, -19.f })));
+		//intersects occluder
+		SFE_CHECK(!occlusion.isOccluded(AABB({ -1.f, -1.f, -12.f }, { 1.f, 1.f, -8.f })));
+	}
+
+	void uncertainBoxesAreVisible() {
+		const auto occlusion = makeOcclusion();
+		//crosses near plane
+		SFE_CHECK(!occlusion.isOccluded(AABB({ -1.f, -1.f, -1.f }, { 1.f, 1.f, 1.f })));
+		//behind camera
+		SFE_CHECK(!occlusion.isOccluded(AABB({ -1.f, -1.f, 29.f }, { 1.f, 1.f, 31.f })));
+		//out of screen
+		SFE_CHECK(!occlusion.isOccluded(AABB({ 200.f, -1.f, -31.f }, { 202.f, 1.f, -29.f })));
+
+		//nothing is hidden without occluders
+		Render::SoftwareOcclusion empty(256, 144);
+		empty.beginFrame(cameraProjection());
+		empty.rasterize();
+		SFE_CHECK(!empty.isOccluded(AABB({ -1.f, -1.f, -31.f }, { 1.f, 1.f, -29.f })));
+		SFE_CHECK(std::ranges::all_of(empty.getDepth(), [](float depth) { return depth == 1.f; }));
+	}
+
+	void occluderBehindCameraIsSkipped() {
+		Render::SoftwareOcclusion occlusion(256, 144);
+		occlusion.beginFrame(cameraProjection());
+		occlusion.addOccluder(AABB({ -5.f, -5.f, 9.5f }, { 5.f, 5.f, 10.5f }));
+		SFE_CHECK(occlusion.getTrianglesCount() == 0);
+
+		occlusion.rasterize();
+		SFE_CHECK(!occlusion.isOccluded(AABB({ -1.f, -1.f, -31.f }, { 1.f, 1.f, -29.f })));
+
+		//of box around camera only triangles of its far face are in front of near plane, they still occlude
+		occlusion.beginFrame(cameraProjection());
+		occlusion.addOccluder(AABB({ -5.f, -5.f, -5.f }, { 5.f, 5.f, 5.f }));
+		SFE_CHECK(occlusion.getTrianglesCount() == 2);
+		occlusion.rasterize();
+		SFE_CHECK(occlusion.isOccluded(AABB({ -1.f, -1.f, -31.f }, { 1.f, 1.f, -29.f })));
+	}
+
+	void hiZKeepsFarthestDepth() {
+		const auto occlusion = makeOcclusion();
+		SFE_CHECK(occlusion.getHiZLevelsCount() > 1);
+
+		//covered pixels have occluder depth, the rest is far plane
+		const auto& depth = occlusion.getDepth();
+		const auto width = static_cast<size_t>(occlusion.getWidth());
+		const auto height = static_cast<size_t>(occlusion.getHeight());
+		SFE_CHECK(depth[height / 2 * width + width / 2] < 1.f);
+		SFE_CHECK(depth[0] == 1.f);
+
+		size_t levelWidth = width;
+		size_t levelHeight = height;
+		for (size_t level = 1; level < occlusion.getHiZLevelsCount(); level++) {
+			const auto& source = occlusion.getHiZ(level - 1);
+			const auto& reduced = occlusion.getHiZ(level);
+			const auto reducedWidth = std::max<size_t>((levelWidth + 1) / 2, 1);
+			for (size_t y = 0; y < levelHeight; y++) {
+				for (size_t x = 0; x < levelWidth; x++) {
+					SFE_CHECK(reduced[y / 2 * reducedWidth + x / 2] >= source[y * levelWidth + x]);
+				}
+			}
+			levelWidth = reducedWidth;
+			levelHeight = std::max<size_t>((levelHeight + 1) / 2, 1);
+		}
+		SFE_CHECK(occlusion.getHiZ(occlusion.getHiZLevelsCount() - 1).size() == 1);
+		SFE_CHECK(occlusion.getHiZ(occlusion.getHiZLevelsCount() - 1)[0] == 1.f);
+	}
+
+	void parallelRasterizationMatches() {
+		const auto serial = makeOcclusion();
+
+		//tasks are run in reverse order to mimic other threads
+		const auto parallel = makeOcclusion([](size_t count, const std::function<void(size_t)>& task) {
+			for (size_t i = count; i > 0; i--) {
+				task(i - 1);
+			}
+		});
+
+		for (size_t level = 0; level < serial.getHiZLevelsCount(); level++) {
+			SFE_CHECK(serial.getHiZ(level) == parallel.getHiZ(level));
+		}
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "size is rounded to tiles", sizeIsRoundedToTiles },
+		{ "box behind occluder is hidden", boxBehindOccluderIsHidden },
+		{ "uncertain boxes are visible", uncertainBoxesAreVisible },
+		{ "occluder behind camera is skipped", occluderBehindCameraIsSkipped },
+		{ "hi-z keeps farthest depth", hiZKeepsFarthestDepth },
+		{ "parallel rasterization matches", parallelRasterizationMatches },
+	});
+}
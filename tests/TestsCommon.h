@@ -0,0 +1,21 @@
+﻿#pragma once
+#include <cstdio>
+#include <initializer_list>
+#include <utility>
+
+namespace SFE::Tests {
+	inline int failures = 0;
+
+	//runs tests one by one, returns exit code for ctest
+	inline int run(std::initializer_list<std::pair<const char*, void(*)()>> tests) {
+		for (const auto& [name, test] : tests) {
+			const auto before = failures;
+			test();
+			std::printf("%s %s\n", before == failures ? "[ok]    " : "[failed]", name);
+		}
+
+		return failures ? 1 : 0;
+	}
+}
+
+#define SFE_CHECK(expr) do { if (!(expr)) { std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); SFE::Tests::failures++; } } while (false)
@@ -0,0 +1,173 @@
+﻿#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "assetsModule/TextureImage.h"
+#include "propertiesModule/BinaryArchive.h"
+
+using namespace AssetsModule;
+
+namespace {
+	TextureImage makeImage(int width, int height, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+		TextureImage image;
+		image.width = width;
+		image.height = height;
+		auto& mip = image.mips.emplace_back();
+		mip.width = width;
+		mip.height = height;
+		for (int i = 0; i < width * height; i++) {
+			mip.data.insert(mip.data.end(), { r, g, b, a });
+		}
+		return image;
+	}
+
+	void put(std::vector<uint8_t>& data, uint32_t value, int bytes) {
+		for (int i = 0; i < bytes; i++) {
+			data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+		}
+	}
+
+	//24 bit bmp 2x2, rows are stored from bottom: bottom row is red and green, top row is blue and white
+	std::vector<uint8_t> makeBmp() {
+		std::vector<uint8_t> data;
+		data.push_back('B');
+		data.push_back('M');
+		put(data, 70, 4);
+		put(data, 0, 4);
+		put(data, 54, 4);
+		put(data, 40, 4);
+		put(data, 2, 4);
+		put(data, 2, 4);
+		put(data, 1, 2);
+		put(data, 24, 2);
+		put(data, 0, 4);
+		put(data, 16, 4);
+		put(data, 2835, 4);
+		put(data, 2835, 4);
+		put(data, 0, 4);
+		put(data, 0, 4);
+		//bgr, rows are padded to 4 bytes
+		data.insert(data.end(), { 0, 0, 255, 0, 255, 0, 0, 0 });
+		data.insert(data.end(), { 255, 0, 0, 255, 255, 255, 0, 0 });
+		return data;
+	}
+
+	void decodeFlipsRows() {
+		const auto bmp = makeBmp();
+
+		TextureImage image;
+		SFE_CHECK(image.decode(bmp, false));
+		SFE_CHECK(image.width == 2 && image.height == 2 && image.mips.size() == 1);
+		//top row first
+		SFE_CHECK(image.mips[0].data[2] == 255 && image.mips[0].data[0] == 0);
+		SFE_CHECK(image.mips[0].data[3] == 255);
+
+		TextureImage flipped;
+		SFE_CHECK(flipped.decode(bmp, true));
+		SFE_CHECK(flipped.mips[0].data[0] == 255 && flipped.mips[0].data[2] == 0);
+
+		const std::vector<uint8_t> broken = { 1, 2, 3, 4 };
+		TextureImage empty;
+		SFE_CHECK(!empty.decode(broken, false));
+		SFE_CHECK(empty.mips.empty());
+	}
+
+	void boxMipsAverage() {
+		//checker of black and white columns turns grey
+		auto image = makeImage(8, 4, 0, 0, 0, 255);
+		for (int i = 0; i < 8 * 4; i += 2) {
+			std::fill_n(image.mips[0].data.begin() + i * 4, 3, uint8_t(255));
+		}
+
+		image.generateMips(MipFilter::BOX);
+		SFE_CHECK(image.mips.size() == 4);
+		const int sizes[][2] = { { 8, 4 }, { 4, 2 }, { 2, 1 }, { 1, 1 } };
+		for (size_t level = 0; level < image.mips.size(); level++) {
+			SFE_CHECK(image.mips[level].width == sizes[level][0] && image.mips[level].height == sizes[level][1]);
+			SFE_CHECK(image.mips[level].data.size() == TextureImage::getMipBytes(sizes[level][0], sizes[level][1], TextureCompression::NONE));
+		}
+
+		for (size_t level = 1; level < image.mips.size(); level++) {
+			const auto& data = image.mips[level].data;
+			for (size_t i = 0; i < data.size(); i += 4) {
+				SFE_CHECK(data[i] == 128 && data[i + 1] == 128 && data[i + 2] == 128 && data[i + 3] == 255);
+			}
+		}
+
+		image.generateMips(MipFilter::NONE);
+		SFE_CHECK(image.mips.size() == 1);
+	}
+
+	void kaiserKeepsFlatColor() {
+		//odd size takes clamped edges
+		auto image = makeImage(7, 5, 10, 100, 200, 255);
+		image.generateMips(MipFilter::KAISER);
+		SFE_CHECK(image.mips.size() == 3);
+		SFE_CHECK(image.mips.back().width == 1 && image.mips.back().height == 1);
+
+		for (const auto& mip : image.mips) {
+			for (size_t i = 0; i < mip.data.size(); i += 4) {
+				SFE_CHECK(std::abs(mip.data[i] - 10) <= 1);
+				SFE_CHECK(std::abs(mip.data[i + 1] - 100) <= 1);
+				SFE_CHECK(std::abs(mip.data[i + 2] - 200) <= 1);
+				SFE_CHECK(mip.data[i + 3] == 255);
+			}
+		}
+	}
+
+	void compressedSizes() {
+		for (const auto compression : { TextureCompression::BC1, TextureCompression::BC3, TextureCompression::BC5, TextureCompression::BC7 }) {
+			auto image = makeImage(10, 6, 128, 128, 255, 255);
+			image.generateMips(MipFilter::BOX);
+			const auto levels = image.mips.size();
+			image.compress(compression);
+
+			SFE_CHECK(image.compression == compression);
+			SFE_CHECK(image.mips.size() == levels);
+			for (const auto& mip : image.mips) {
+				SFE_CHECK(mip.data.size() == TextureImage::getMipBytes(mip.width, mip.height, compression));
+			}
+		}
+
+		SFE_CHECK(TextureImage::getMipBytes(1, 1, TextureCompression::BC1) == 8);
+		SFE_CHECK(TextureImage::getMipBytes(5, 4, TextureCompression::BC5) == 32);
+	}
+
+	void serializationRoundTrip() {
+		auto image = makeImage(8, 8, 1, 2, 3, 4);
+		image.generateMips(MipFilter::BOX);
+		image.compress(TextureCompression::BC5);
+
+		std::vector<uint8_t> data;
+		SFE::PropertiesModule::BinaryWriter writer(data);
+		image.write(writer);
+
+		TextureImage loaded;
+		SFE::PropertiesModule::BinaryReader reader(data);
+		SFE_CHECK(loaded.read(reader));
+		SFE_CHECK(loaded.width == 8 && loaded.height == 8 && loaded.compression == TextureCompression::BC5);
+		SFE_CHECK(loaded.mips.size() == image.mips.size());
+		for (size_t level = 0; level < image.mips.size(); level++) {
+			SFE_CHECK(loaded.mips[level].data == image.mips[level].data);
+		}
+		SFE_CHECK(loaded.getBytes() == image.getBytes());
+
+		//truncated data leaves image empty
+		data.resize(data.size() - 1);
+		TextureImage broken;
+		SFE::PropertiesModule::BinaryReader brokenReader(data);
+		SFE_CHECK(!broken.read(brokenReader));
+		SFE_CHECK(broken.mips.empty() && broken.width == 0);
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "decode flips rows", decodeFlipsRows },
+		{ "box mips average", boxMipsAverage },
+		{ "kaiser keeps flat color", kaiserKeepsFlatColor },
+		{ "compressed sizes", compressedSizes },
+		{ "serialization round trip", serializationRoundTrip },
+	});
+}
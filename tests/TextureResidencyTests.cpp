@@ -0,0 +1,233 @@
+﻿#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "renderModule/TextureResidency.h"
+
+using namespace SFE::Render;
+
+namespace {
+	constexpr uint32_t SIZE = 1024;
+	constexpr uint32_t LEVELS = 11;
+	constexpr uint32_t LOCKED = 6;
+
+	const TextureResidency::View VIEW{ 1.f, 1000.f };
+
+	TextureResidency::TextureDesc makeDesc(uint32_t locked = LOCKED) {
+		TextureResidency::TextureDesc desc;
+		desc.width = SIZE;
+		desc.height = SIZE;
+		desc.lockedLevel = locked;
+		for (uint32_t level = 0; level < LEVELS; level++) {
+			const uint64_t size = SIZE >> level;
+			desc.levelBytes.push_back(size * size * 4);
+		}
+		return desc;
+	}
+
+	uint64_t bytesFrom(uint32_t level) {
+		uint64_t bytes = 0;
+		for (; level < LEVELS; level++) {
+			const uint64_t size = SIZE >> level;
+			bytes += size * size * 4;
+		}
+		return bytes;
+	}
+
+	//draw at which texture needs exactly this mip
+	TextureResidency::DrawRecord drawAtMip(uint32_t texture, float mip) {
+		const auto pixelsPerUnitAtOne = VIEW.projectionScale * VIEW.screenHeight * 0.5f;
+		return { texture, pixelsPerUnitAtOne * std::exp2(mip) / static_cast<float>(SIZE), 1.f };
+	}
+
+	TextureResidency makeResidency(uint32_t dropFrames = 5) {
+		TextureResidency residency;
+		TextureResidency::Settings settings;
+		settings.budgetBytes = 1ull << 40;
+		settings.dropFrames = dropFrames;
+		settings.maxLoadsPerFrame = 16;
+		residency.setSettings(settings);
+		return residency;
+	}
+
+	void requiredMip() {
+		SFE_CHECK(std::abs(TextureResidency::getRequiredMip(VIEW, drawAtMip(1, 2.f), SIZE) - 2.f) < 1e-4f);
+		SFE_CHECK(std::abs(TextureResidency::getRequiredMip(VIEW, drawAtMip(1, -1.f), SIZE) + 1.f) < 1e-4f);
+
+		//twice as far needs one level coarser
+		auto near = drawAtMip(1, 1.f);
+		auto far = near;
+		far.distance *= 2.f;
+		SFE_CHECK(std::abs(TextureResidency::getRequiredMip(VIEW, far, SIZE) - TextureResidency::getRequiredMip(VIEW, near, SIZE) - 1.f) < 1e-4f);
+	}
+
+	void loadsRequiredLevel() {
+		auto residency = makeResidency();
+		residency.addTexture(1, makeDesc(), LOCKED);
+		SFE_CHECK(residency.getResidentLevel(1) == LOCKED);
+
+		const auto& changes = residency.update(VIEW, { drawAtMip(1, 2.5f) });
+		SFE_CHECK(changes.size() == 1);
+		SFE_CHECK(changes[0].texture == 1 && changes[0].from == LOCKED && changes[0].to == 2);
+		SFE_CHECK(residency.getResidentLevel(1) == 2);
+		SFE_CHECK(residency.getStats().loads == 1);
+		SFE_CHECK(residency.getStats().residentBytes == bytesFrom(2));
+
+		//the nearest draw of texture wins
+		const auto& nearer = residency.update(VIEW, { drawAtMip(1, 3.f), drawAtMip(1, 0.5f) });
+		SFE_CHECK(nearer.size() == 1 && nearer[0].to == 0);
+
+		//magnified texture still needs only the first level
+		residency.update(VIEW, { drawAtMip(1, -3.f) });
+		SFE_CHECK(residency.getResidentLevel(1) == 0);
+	}
+
+	void hysteresis() {
+		auto residency = makeResidency(5);
+		residency.addTexture(1, makeDesc(), 2);
+
+		//coarser level is enough, but not by hysteresis margin
+		for (int i = 0; i < 10; i++) {
+			SFE_CHECK(residency.update(VIEW, { drawAtMip(1, 3.1f) }).empty());
+		}
+		SFE_CHECK(residency.getResidentLevel(1) == 2);
+
+		//enough by margin, level is dropped only after dropFrames updates
+		for (int i = 0; i < 4; i++) {
+			SFE_CHECK(residency.update(VIEW, { drawAtMip(1, 3.5f) }).empty());
+		}
+
+		//one finer frame resets counter
+		residency.update(VIEW, { drawAtMip(1, 2.f) });
+		for (int i = 0; i < 4; i++) {
+			SFE_CHECK(residency.update(VIEW, { drawAtMip(1, 3.5f) }).empty());
+		}
+
+		const auto& changes = residency.update(VIEW, { drawAtMip(1, 3.5f) });
+		SFE_CHECK(changes.size() == 1);
+		SFE_CHECK(changes[0].from == 2 && changes[0].to == 3);
+		SFE_CHECK(residency.getStats().drops == 1);
+
+		//finer level is loaded back at once
+		const auto& back = residency.update(VIEW, { drawAtMip(1, 2.9f) });
+		SFE_CHECK(back.size() == 1 && back[0].to == 2);
+	}
+
+	void unseenGoesToLocked() {
+		auto residency = makeResidency(3);
+		residency.addTexture(1, makeDesc(), 0);
+
+		SFE_CHECK(residency.update(VIEW, {}).empty());
+		SFE_CHECK(residency.update(VIEW, {}).empty());
+		const auto& changes = residency.update(VIEW, {});
+		SFE_CHECK(changes.size() == 1 && changes[0].to == LOCKED);
+
+		//locked level is never dropped
+		for (int i = 0; i < 10; i++) {
+			SFE_CHECK(residency.update(VIEW, {}).empty());
+		}
+		SFE_CHECK(residency.getResidentLevel(1) == LOCKED);
+	}
+
+	void budgetDropsUnseenFirst() {
+		auto residency = makeResidency(1000);
+		residency.addTexture(1, makeDesc(), 0);
+		residency.addTexture(2, makeDesc(), 0);
+
+		auto settings = residency.getSettings();
+		settings.budgetBytes = bytesFrom(0) + bytesFrom(3);
+		residency.setSettings(settings);
+
+		//texture 2 isn't drawn, it would wait for dropFrames without budget
+		const auto& changes = residency.update(VIEW, { drawAtMip(1, 0.f) });
+		SFE_CHECK(changes.size() == 1);
+		SFE_CHECK(changes[0].texture == 2 && changes[0].to == 3);
+		SFE_CHECK(residency.getResidentLevel(1) == 0);
+		SFE_CHECK(residency.getStats().wantedBytes == 2 * bytesFrom(0));
+		SFE_CHECK(residency.getStats().residentBytes <= settings.budgetBytes);
+	}
+
+	void budgetDropsBiggestExcessFirst() {
+		auto residency = makeResidency();
+		residency.addTexture(1, makeDesc(), 0);
+		residency.addTexture(2, makeDesc(), 0);
+
+		//both want level 0, texture 1 is almost fine with level 1
+		auto settings = residency.getSettings();
+		settings.budgetBytes = bytesFrom(0) + bytesFrom(1);
+		residency.setSettings(settings);
+
+		const auto& changes = residency.update(VIEW, { drawAtMip(1, 0.9f), drawAtMip(2, 0.1f) });
+		SFE_CHECK(changes.size() == 1);
+		SFE_CHECK(changes[0].texture == 1 && changes[0].to == 1);
+		SFE_CHECK(residency.getResidentLevel(2) == 0);
+
+		//with no budget everything goes down to locked levels, but not further
+		settings.budgetBytes = 0;
+		residency.setSettings(settings);
+		residency.update(VIEW, { drawAtMip(1, 0.f), drawAtMip(2, 0.f) });
+		SFE_CHECK(residency.getResidentLevel(1) == LOCKED);
+		SFE_CHECK(residency.getResidentLevel(2) == LOCKED);
+		SFE_CHECK(residency.getStats().residentBytes == 2 * bytesFrom(LOCKED));
+	}
+
+	void loadsLimitBlurriestFirst() {
+		auto residency = makeResidency();
+		auto settings = residency.getSettings();
+		settings.maxLoadsPerFrame = 2;
+		residency.setSettings(settings);
+
+		residency.addTexture(1, makeDesc(), LOCKED);
+		residency.addTexture(2, makeDesc(), LOCKED);
+		residency.addTexture(3, makeDesc(), LOCKED);
+
+		//texture 2 misses the most detail, texture 3 the least
+		const auto& changes = residency.update(VIEW, { drawAtMip(1, 2.f), drawAtMip(2, 0.f), drawAtMip(3, 4.f) });
+		SFE_CHECK(changes.size() == 2);
+		SFE_CHECK(changes[0].texture == 2);
+		SFE_CHECK(changes[1].texture == 1);
+		SFE_CHECK(residency.getStats().deferredLoads == 1);
+		SFE_CHECK(residency.getResidentLevel(3) == LOCKED);
+
+		//deferred one is loaded next frame
+		const auto& next = residency.update(VIEW, { drawAtMip(1, 2.f), drawAtMip(2, 0.f), drawAtMip(3, 4.f) });
+		SFE_CHECK(next.size() == 1 && next[0].texture == 3 && next[0].to == 4);
+	}
+
+	void busyAndRequested() {
+		auto residency = makeResidency();
+		residency.addTexture(1, makeDesc(), LOCKED);
+		residency.setBusy(1, true);
+		SFE_CHECK(residency.isBusy(1));
+		SFE_CHECK(residency.update(VIEW, { drawAtMip(1, 0.f) }).empty());
+
+		residency.setBusy(1, false);
+		residency.request(1, 0);
+		const auto& changes = residency.update(VIEW, {});
+		SFE_CHECK(changes.size() == 1 && changes[0].to == 0);
+
+		//request lasts one update only
+		residency.addTexture(2, makeDesc(), LOCKED);
+		residency.request(2, 1);
+		residency.update(VIEW, {});
+		SFE_CHECK(residency.getResidentLevel(2) == 1);
+
+		residency.removeTexture(2);
+		SFE_CHECK(!residency.contains(2));
+		SFE_CHECK(residency.getDesc(1) && residency.getDesc(1)->lockedLevel == LOCKED);
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "required mip", requiredMip },
+		{ "loads required level", loadsRequiredLevel },
+		{ "hysteresis", hysteresis },
+		{ "unseen goes to locked", unseenGoesToLocked },
+		{ "budget drops unseen first", budgetDropsUnseenFirst },
+		{ "budget drops biggest excess first", budgetDropsBiggestExcessFirst },
+		{ "loads limit blurriest first", loadsLimitBlurriestFirst },
+		{ "busy and requested", busyAndRequested },
+	});
+}
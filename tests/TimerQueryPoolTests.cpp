@@ -0,0 +1,231 @@
+﻿#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "debugModule/TimerQueryPool.h"
+
+using namespace SFE;
+
+namespace {
+	//gpu which finishes queries in order of issuing, test decides how far it is
+	struct MockBackend {
+		using Handle = uint32_t;
+
+		struct Query {
+			bool alive = false;
+			size_t issue = 0; //order of the last timestamp, 0 - never issued
+			uint64_t time = 0;
+		};
+
+		void create(Handle* handles, size_t count) {
+			for (size_t i = 0; i < count; i++) {
+				handles[i] = static_cast<Handle>(queries.size());
+				queries.push_back({ true });
+			}
+		}
+
+		void destroy(Handle* handles, size_t count) {
+			for (size_t i = 0; i < count; i++) {
+				queries[handles[i]].alive = false;
+			}
+		}
+
+		void timestamp(Handle handle) {
+			auto& query = queries[handle];
+			query.issue = ++issued;
+			query.time = clock;
+			clock += 10;
+			issuedHandles.push_back(handle);
+		}
+
+		bool available(Handle handle) {
+			const auto& query = queries[handle];
+			return query.issue && query.issue <= completed;
+		}
+
+		uint64_t result(Handle handle) {
+			return queries[handle].time;
+		}
+
+		void finishAll() { completed = issued; }
+
+		std::vector<Query> queries;
+		std::vector<Handle> issuedHandles;
+		size_t issued = 0;
+		size_t completed = 0;
+		uint64_t clock = 1000;
+	};
+
+	constexpr size_t LATENCY = 3;
+	constexpr size_t MAX_SCOPES = 4;
+	using Pool = Debug::TimerQueryPool<MockBackend, LATENCY, MAX_SCOPES>;
+
+	std::vector<Pool::FrameResult> takeFrames(Pool& pool) {
+		std::vector<Pool::FrameResult> frames;
+		pool.consume([&frames](Pool::FrameResult& frame) { frames.push_back(std::move(frame)); });
+		return frames;
+	}
+
+	void frameWithScope(Pool& pool, const std::string& name) {
+		pool.beginFrame();
+		pool.endScope(pool.beginScope(name));
+		pool.endFrame();
+	}
+
+	void resolvesFinishedFrames() {
+		Pool pool;
+		pool.init();
+
+		pool.beginFrame();
+		const auto outer = pool.beginScope("outer");
+		const auto inner = pool.beginScope("inner");
+		pool.endScope(inner);
+		pool.endScope(outer);
+		pool.getBackend().finishAll();
+		pool.endFrame();
+
+		//end of the frame was issued after finishAll, so the frame waits for the next poll
+		SFE_CHECK(takeFrames(pool).empty());
+
+		pool.getBackend().finishAll();
+		pool.poll();
+		const auto frames = takeFrames(pool);
+		SFE_CHECK(frames.size() == 1);
+		if (frames.size() == 1) {
+			const auto& frame = frames.front();
+			SFE_CHECK(frame.frameIndex == 0);
+			SFE_CHECK(frame.scopes.size() == 2);
+			SFE_CHECK(frame.scopes[0].name == "outer" && frame.scopes[1].name == "inner");
+			SFE_CHECK(frame.scopes[0].duration() == 30);
+			SFE_CHECK(frame.scopes[1].duration() == 10);
+			SFE_CHECK(frame.duration() == 50);
+		}
+	}
+
+	void reusesSlotsAfterLatency() {
+		Pool pool;
+		pool.init();
+		auto& backend = pool.getBackend();
+
+		//gpu is one frame behind, every slot is resolved before it is needed again
+		std::vector<std::vector<MockBackend::Handle>> handles;
+		for (size_t i = 0; i < LATENCY * 3; i++) {
+			const auto first = backend.issuedHandles.size();
+			frameWithScope(pool, "frame " + std::to_string(i));
+			handles.emplace_back(backend.issuedHandles.begin() + static_cast<long long>(first), backend.issuedHandles.end());
+			backend.finishAll();
+		}
+		pool.poll();
+
+		const auto frames = takeFrames(pool);
+		SFE_CHECK(frames.size() == LATENCY * 3);
+		for (size_t i = 0; i < frames.size(); i++) {
+			SFE_CHECK(frames[i].frameIndex == i);
+			SFE_CHECK(frames[i].scopes.size() == 1 && frames[i].scopes[0].name == "frame " + std::to_string(i));
+		}
+
+		//frame uses queries of the frame which was Latency frames before it and no new queries are created
+		for (size_t i = LATENCY; i < handles.size(); i++) {
+			SFE_CHECK(handles[i] == handles[i - LATENCY]);
+		}
+		SFE_CHECK(backend.queries.size() == LATENCY * (2 + MAX_SCOPES * 2));
+		SFE_CHECK(pool.getDroppedFrames() == 0);
+	}
+
+	void dropsFrameWhenGpuIsBehind() {
+		Pool pool;
+		pool.init();
+
+		//gpu doesn't finish anything, all slots are pending after Latency frames
+		for (size_t i = 0; i < LATENCY; i++) {
+			frameWithScope(pool, "pending");
+		}
+		SFE_CHECK(pool.getDroppedFrames() == 0);
+
+		//next frame needs the slot of frame 0 and doesn't wait for it
+		frameWithScope(pool, "next");
+		SFE_CHECK(pool.getDroppedFrames() == 1);
+
+		pool.getBackend().finishAll();
+		pool.poll();
+		const auto frames = takeFrames(pool);
+		SFE_CHECK(frames.size() == LATENCY);
+		SFE_CHECK(!frames.empty() && frames.front().frameIndex == 1);
+		SFE_CHECK(!frames.empty() && frames.back().frameIndex == LATENCY);
+	}
+
+	void limitsScopesPerFrame() {
+		Pool pool;
+		pool.init();
+
+		pool.beginFrame();
+		std::vector<size_t> scopes;
+		for (size_t i = 0; i < MAX_SCOPES + 2; i++) {
+			scopes.push_back(pool.beginScope("scope " + std::to_string(i)));
+		}
+		for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+			pool.endScope(*it);
+		}
+		pool.endFrame();
+
+		SFE_CHECK(std::count(scopes.begin(), scopes.end(), Pool::INVALID_SCOPE) == 2);
+		SFE_CHECK(scopes[MAX_SCOPES] == Pool::INVALID_SCOPE && scopes[MAX_SCOPES + 1] == Pool::INVALID_SCOPE);
+		SFE_CHECK(pool.getOverflowScopes() == 2);
+
+		pool.getBackend().finishAll();
+		pool.poll();
+		const auto frames = takeFrames(pool);
+		SFE_CHECK(frames.size() == 1 && frames.front().scopes.size() == MAX_SCOPES);
+
+		//counter is reset by the next frame, so scopes are available again
+		pool.beginFrame();
+		SFE_CHECK(pool.beginScope("after overflow") == 0);
+		pool.endFrame();
+	}
+
+	void closesForgottenScopes() {
+		Pool pool;
+		pool.init();
+
+		pool.beginFrame();
+		pool.beginScope("forgotten");
+		pool.endFrame();
+		pool.getBackend().finishAll();
+		pool.poll();
+
+		const auto frames = takeFrames(pool);
+		SFE_CHECK(frames.size() == 1);
+		if (frames.size() == 1) {
+			SFE_CHECK(frames.front().scopes.size() == 1);
+			SFE_CHECK(frames.front().scopes.front().end == frames.front().end - 10);
+		}
+	}
+
+	void ignoresCallsOutsideFrame() {
+		Pool pool;
+		SFE_CHECK(pool.beginScope("not initialized") == Pool::INVALID_SCOPE);
+
+		pool.init();
+		SFE_CHECK(pool.beginScope("no frame") == Pool::INVALID_SCOPE);
+		pool.endFrame();
+		SFE_CHECK(pool.getFrameIndex() == 0);
+
+		pool.release();
+		for (const auto& query : pool.getBackend().queries) {
+			SFE_CHECK(!query.alive);
+		}
+	}
+}
+
+int main() {
+	return Tests::run({
+		{ "resolvesFinishedFrames", resolvesFinishedFrames },
+		{ "reusesSlotsAfterLatency", reusesSlotsAfterLatency },
+		{ "dropsFrameWhenGpuIsBehind", dropsFrameWhenGpuIsBehind },
+		{ "limitsScopesPerFrame", limitsScopesPerFrame },
+		{ "closesForgottenScopes", closesForgottenScopes },
+		{ "ignoresCallsOutsideFrame", ignoresCallsOutsideFrame },
+	});
+}
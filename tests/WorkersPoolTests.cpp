@@ -0,0 +1,112 @@
+﻿#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "TestsCommon.h"
+#include "multithreading/WorkersPool.h"
+
+using namespace SFE;
+
+namespace {
+	void allTasksAreExecuted() {
+		WorkersPool pool(4);
+		std::atomic<int> executed = 0;
+		std::vector<std::shared_future<void>> futures;
+		for (int i = 0; i < 1000; i++) {
+			futures.push_back(pool.addTask([&executed] { executed++; }));
+		}
+		for (auto& future : futures) {
+			future.wait();
+		}
+
+		SFE_CHECK(executed == 1000);
+		SFE_CHECK(pool.size() == 4);
+	}
+
+	void workerKnowsItsPool() {
+		WorkersPool pool(2);
+		WorkersPool other(1);
+		SFE_CHECK(!pool.isWorkerThread());
+
+		bool inOwnPool = false;
+		bool inOtherPool = true;
+		pool.addTask([&] {
+			inOwnPool = pool.isWorkerThread();
+			inOtherPool = other.isWorkerThread();
+		}).wait();
+
+		SFE_CHECK(inOwnPool);
+		SFE_CHECK(!inOtherPool);
+	}
+
+	void queueIsDrainedByCaller() {
+		WorkersPool pool(0);
+		int executed = 0;
+		auto future = pool.addTask([&executed] { executed++; });
+
+		SFE_CHECK(pool.tryExecuteTask());
+		SFE_CHECK(!pool.tryExecuteTask());
+		SFE_CHECK(executed == 1);
+		SFE_CHECK(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+	}
+
+	void workersCountLeavesDedicatedCores() {
+		const auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+		SFE_CHECK(getWorkersCount(0) == hardware);
+		SFE_CHECK(getWorkersCount(hardware) == 1);
+		SFE_CHECK(getWorkersCount(hardware + 10) == 1);
+		if (hardware > 3) {
+			SFE_CHECK(getWorkersCount(3) == hardware - 3);
+		}
+	}
+
+	//frames of short batches as systems push them, the old pool had 128 common workers
+	double runFrames(size_t workers) {
+		constexpr int FRAMES = 64;
+		constexpr int TASKS = 512;
+
+		WorkersPool pool(workers);
+		std::atomic<float> sink = 0.f;
+		std::vector<std::shared_future<void>> futures;
+		futures.reserve(TASKS);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < FRAMES; frame++) {
+			for (int task = 0; task < TASKS; task++) {
+				futures.push_back(pool.addTask([&sink, task] {
+					float value = static_cast<float>(task);
+					for (int i = 0; i < 2000; i++) {
+						value = std::sqrt(value + static_cast<float>(i));
+					}
+					sink.store(value, std::memory_order_relaxed);
+				}));
+			}
+			for (auto& future : futures) {
+				future.wait();
+			}
+			futures.clear();
+		}
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / FRAMES;
+	}
+
+	//timings depend on machine, so they are printed for comparison and not checked
+	void compareWithOldPool() {
+		const auto workers = getWorkersCount(3);
+		const auto before = runFrames(128);
+		const auto after = runFrames(workers);
+		std::printf("frame of batches: 128 workers %.3f ms, %zu workers %.3f ms\n", before, workers, after);
+	}
+}
+
+int main() {
+	return SFE::Tests::run({
+		{ "allTasksAreExecuted", allTasksAreExecuted },
+		{ "workerKnowsItsPool", workerKnowsItsPool },
+		{ "queueIsDrainedByCaller", queueIsDrainedByCaller },
+		{ "workersCountLeavesDedicatedCores", workersCountLeavesDedicatedCores },
+		{ "compareWithOldPool", compareWithOldPool },
+	});
+}